@@ -1,27 +1,22 @@
 #pragma once
 
-#define WIN32_LEAN_AND_MEAN
-#define NOMINMAX
-#include <Windows.h>
-
-#include <thread>
-#include <optional>
-#include <string>
 #include <functional>
+#include <memory>
+#include <string>
 
-#include <wil/resource.h>
-#include <wil/filesystem.h>
+#include "FileWatcherService.h"
 
+// Calls the callback when the file at path changed. The watchers of a process share their folder readers and
+// a thread, see FileWatcherService, and the events of a save are coalesced into one call.
 class FileWatcher
 {
-    std::wstring m_path;
-    std::wstring m_file_name;
-    std::optional<FILETIME> m_lastWrite;
-    std::function<void()> m_callback;
-    wil::unique_folder_change_reader_nothrow m_folder_change_reader;
+    std::shared_ptr<FileWatcherService> m_service;
+    FileWatcherService::Id m_id = 0;
 
-    std::optional<FILETIME> MyFileTime();
 public:
-    FileWatcher(const std::wstring& path, std::function<void()> callback);
+    FileWatcher(const std::wstring& path, std::function<void()> callback, bool compareContent = false);
     ~FileWatcher();
+
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
 };
@@ -0,0 +1,166 @@
+#include "pch.h"
+#include "FileWatcherService.h"
+#include <utils/winapi_error.h>
+
+namespace
+{
+    // FNV-1a of the content, the watched files are small settings files
+    std::optional<uint64_t> HashFile(const std::wstring& path)
+    {
+        wil::unique_hfile file{ CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_DELETE | FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr) };
+        if (!file)
+        {
+            return std::nullopt;
+        }
+
+        uint64_t hash = 0xcbf29ce484222325;
+        std::vector<uint8_t> buffer(64 * 1024);
+        DWORD read = 0;
+        while (ReadFile(file.get(), buffer.data(), static_cast<DWORD>(buffer.size()), &read, nullptr) && read > 0)
+        {
+            for (DWORD i = 0; i < read; i++)
+            {
+                hash = (hash ^ buffer[i]) * 0x100000001b3;
+            }
+        }
+        return hash;
+    }
+
+    // The attributes are read without opening the file, which an editor might be writing
+    std::optional<file_watch::FileState> ProbeFile(const std::wstring& path, bool hash)
+    {
+        WIN32_FILE_ATTRIBUTE_DATA data{};
+        if (!GetFileAttributesExW(path.c_str(), GetFileExInfoStandard, &data) || (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+        {
+            return std::nullopt;
+        }
+
+        file_watch::FileState state;
+        state.size = uint64_t{ data.nFileSizeHigh } << 32 | data.nFileSizeLow;
+        state.mtime = uint64_t{ data.ftLastWriteTime.dwHighDateTime } << 32 | data.ftLastWriteTime.dwLowDateTime;
+        if (hash)
+        {
+            state.hash = HashFile(path);
+            if (!state.hash)
+            {
+                return std::nullopt;
+            }
+        }
+        return state;
+    }
+}
+
+std::shared_ptr<FileWatcherService> FileWatcherService::instance()
+{
+    static std::shared_ptr<FileWatcherService> service = std::make_shared<FileWatcherService>();
+    return service;
+}
+
+FileWatcherService::FileWatcherService() :
+    m_dispatcher(file_watch::Options{}, ProbeFile)
+{
+}
+
+FileWatcherService::~FileWatcherService() = default;
+
+FileWatcherService::Id FileWatcherService::watch(const std::wstring& path, std::function<void()> callback, bool compareContent)
+{
+    const std::filesystem::path fsPath(path);
+    const auto folder = fsPath.parent_path().wstring();
+    {
+        std::lock_guard lock{ m_mutex };
+        auto& entry = m_folders[file_watch::normalize(folder)];
+        if (entry.watchers++ == 0)
+        {
+            entry.reader = wil::make_folder_change_reader_nothrow(
+                folder.c_str(),
+                false,
+                wil::FolderChangeEvents::FileName | wil::FolderChangeEvents::LastWriteTime,
+                [this, folder](wil::FolderChangeEvent event, PCWSTR fileName) {
+                    OnEvent(folder, event, fileName);
+                });
+
+            if (!entry.reader)
+            {
+                Logger::error(L"Failed to start folder change reader for path {}. {}", path, get_last_error_or_default(GetLastError()));
+            }
+        }
+
+        if (m_watchers++ == 0)
+        {
+            m_thread = std::jthread([this](std::stop_token stop) { Run(stop); });
+        }
+    }
+
+    return m_dispatcher.add(folder, fsPath.filename().wstring(), std::move(callback), compareContent);
+}
+
+void FileWatcherService::unwatch(Id id)
+{
+    const auto folder = m_dispatcher.remove(id);
+    if (!folder)
+    {
+        return;
+    }
+
+    wil::unique_folder_change_reader_nothrow reader;
+    std::jthread thread;
+    {
+        std::lock_guard lock{ m_mutex };
+        if (const auto it = m_folders.find(*folder); it != m_folders.end() && --it->second.watchers == 0)
+        {
+            reader = std::move(it->second.reader);
+            m_folders.erase(it);
+        }
+
+        if (--m_watchers == 0)
+        {
+            m_thread.request_stop();
+            thread = std::move(m_thread);
+        }
+    }
+
+    // Both wait for their running callbacks, which take the lock
+    reader.reset();
+    if (thread.joinable() && thread.get_id() == std::this_thread::get_id())
+    {
+        // The last watcher was removed by its own callback, the thread ends once it returns
+        thread.detach();
+    }
+}
+
+void FileWatcherService::OnEvent(const std::wstring& folder, wil::FolderChangeEvent event, PCWSTR fileName)
+{
+    // Lost events might have been about any file of the folder
+    m_dispatcher.on_event(folder, event == wil::FolderChangeEvent::ChangesLost ? L"" : fileName, file_watch::Clock::now());
+    {
+        std::lock_guard lock{ m_mutex };
+        m_signaled = true;
+    }
+    m_wake.notify_one();
+}
+
+void FileWatcherService::Run(std::stop_token stop)
+{
+    std::unique_lock lock{ m_mutex };
+    while (!stop.stop_requested())
+    {
+        const auto signaled = [this] { return m_signaled; };
+        if (const auto deadline = m_dispatcher.next_deadline())
+        {
+            m_wake.wait_until(lock, stop, *deadline, signaled);
+        }
+        else
+        {
+            m_wake.wait(lock, stop, signaled);
+        }
+        m_signaled = false;
+
+        lock.unlock();
+        if (!stop.stop_requested())
+        {
+            m_dispatcher.dispatch(file_watch::Clock::now());
+        }
+        lock.lock();
+    }
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stop_token>
+#include <string>
+#include <thread>
+
+#include <wil/resource.h>
+#include <wil/filesystem.h>
+
+#include "file_watch_dispatcher.h"
+
+// The file watchers of the process: one folder change reader per watched folder and one thread calling the
+// callbacks, see file_watch::Dispatcher. The thread only runs while something is watched.
+class FileWatcherService
+{
+public:
+    using Id = file_watch::Dispatcher::Id;
+
+    // Shared by the watchers, which keep it alive until the last of them is gone
+    static std::shared_ptr<FileWatcherService> instance();
+
+    FileWatcherService();
+    ~FileWatcherService();
+
+    FileWatcherService(const FileWatcherService&) = delete;
+    FileWatcherService& operator=(const FileWatcherService&) = delete;
+
+    // Calls callback once per change of the file at path. With compareContent a write only counts as a change
+    // when the content is different.
+    Id watch(const std::wstring& path, std::function<void()> callback, bool compareContent = false);
+
+    // Waits for the callback of the watcher when it's running on another thread
+    void unwatch(Id id);
+
+private:
+    struct Folder
+    {
+        size_t watchers = 0;
+        wil::unique_folder_change_reader_nothrow reader;
+    };
+
+    void Run(std::stop_token stop);
+    void OnEvent(const std::wstring& folder, wil::FolderChangeEvent event, PCWSTR fileName);
+
+    file_watch::Dispatcher m_dispatcher;
+
+    std::mutex m_mutex;
+    std::condition_variable_any m_wake;
+    bool m_signaled = false;
+    std::map<std::wstring, Folder> m_folders;
+    size_t m_watchers = 0;
+    std::jthread m_thread;
+};
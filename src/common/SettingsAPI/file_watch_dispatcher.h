@@ -0,0 +1,345 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cwctype>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Routes folder change events to the watchers of single files. One dispatcher serves every file watcher of
+// the process, so a folder needs one reader however many files in it are watched. Doesn't depend on Windows,
+// the caller feeds the events of its folder readers and calls dispatch when next_deadline is due:
+// - the events of a file are debounced, the burst of a save through a temporary file is dispatched once the
+//   file was quiet for the debounce window, or max_delay after its first event for files which never are
+// - a dispatch compares the state of the file with the last one seen, its size and modification time or a
+//   hash of the content, so the callbacks are called once per save and not for writes which changed nothing
+namespace file_watch
+{
+    using Clock = std::chrono::steady_clock;
+
+    struct FileState
+    {
+        uint64_t size = 0;
+        uint64_t mtime = 0;
+
+        // Only when a watcher of the file asked for it
+        std::optional<uint64_t> hash;
+    };
+
+    // The state of the file at path, hashing the content when hash is set. nullopt when it doesn't exist or
+    // can't be read, which doesn't count as a change.
+    using Probe = std::function<std::optional<FileState>(const std::wstring& path, bool hash)>;
+
+    struct Options
+    {
+        std::chrono::milliseconds debounce{ 100 };
+        std::chrono::milliseconds max_delay{ 1000 };
+    };
+
+    struct Stats
+    {
+        uint64_t events = 0;
+        uint64_t probes = 0;
+        uint64_t callbacks = 0;
+    };
+
+    // Case-insensitive like the file system, for the keys of folders and files
+    inline std::wstring normalize(std::wstring_view name)
+    {
+        std::wstring result{ name };
+        for (auto& c : result)
+        {
+            c = static_cast<wchar_t>(std::towlower(c));
+        }
+        while (result.size() > 1 && (result.back() == L'\\' || result.back() == L'/'))
+        {
+            result.pop_back();
+        }
+        return result;
+    }
+
+    // Whether the file changed between two states. Only the hashes are compared when both have one, saving
+    // the same content again changes the modification time.
+    inline bool changed(const FileState& previous, const FileState& current)
+    {
+        if (previous.size != current.size)
+        {
+            return true;
+        }
+        if (previous.hash && current.hash)
+        {
+            return *previous.hash != *current.hash;
+        }
+        return previous.mtime != current.mtime;
+    }
+
+    class Dispatcher
+    {
+    public:
+        using Id = uint64_t;
+
+        Dispatcher(Options options, Probe probe) :
+            m_options(options), m_probe(std::move(probe))
+        {
+        }
+
+        Dispatcher(const Dispatcher&) = delete;
+        Dispatcher& operator=(const Dispatcher&) = delete;
+
+        // Watches fileName in folder. Its state now is the baseline, the callback is called for the changes
+        // after it, on the thread calling dispatch.
+        Id add(const std::wstring& folder, const std::wstring& fileName, std::function<void()> callback, bool hash = false)
+        {
+            const auto folderKey = normalize(folder);
+            const auto fileKey = normalize(fileName);
+            const auto path = folder + L"\\" + fileName;
+            const auto baseline = m_probe(path, hash);
+
+            std::lock_guard lock{ m_mutex };
+            const Id id = m_nextId++;
+            auto& file = m_folders[folderKey][fileKey];
+            if (file.watchers.empty() || (hash && !file.hash))
+            {
+                // A file which is already watched keeps its state, an event for it might be pending
+                file.path = path;
+                file.state = baseline;
+                file.hash = file.hash || hash;
+            }
+            file.watchers.push_back({ id, std::make_shared<const std::function<void()>>(std::move(callback)) });
+            m_ids.emplace(id, std::make_pair(folderKey, fileKey));
+            return id;
+        }
+
+        // Stops the watcher and returns the key of its folder, nullopt for an unknown id. Waits for its
+        // callback when it's running on another thread, so the state it uses can be destroyed afterwards.
+        std::optional<std::wstring> remove(Id id)
+        {
+            std::unique_lock lock{ m_mutex };
+            m_idle.wait(lock, [&] { return m_running != id || m_runningThread == std::this_thread::get_id(); });
+
+            const auto it = m_ids.find(id);
+            if (it == m_ids.end())
+            {
+                return std::nullopt;
+            }
+            auto [folderKey, fileKey] = std::move(it->second);
+            m_ids.erase(it);
+
+            auto& folder = m_folders[folderKey];
+            auto& watchers = folder[fileKey].watchers;
+            std::erase_if(watchers, [id](const Watcher& watcher) { return watcher.id == id; });
+            if (watchers.empty())
+            {
+                folder.erase(fileKey);
+            }
+            if (folder.empty())
+            {
+                m_folders.erase(folderKey);
+            }
+            return folderKey;
+        }
+
+        // A change of fileName in folder, an empty fileName when the events of the folder were lost
+        void on_event(std::wstring_view folder, std::wstring_view fileName, Clock::time_point now)
+        {
+            const auto folderKey = normalize(folder);
+            const auto fileKey = normalize(fileName);
+
+            std::lock_guard lock{ m_mutex };
+            m_stats.events++;
+            const auto it = m_folders.find(folderKey);
+            if (it == m_folders.end())
+            {
+                return;
+            }
+
+            auto touch = [&](File& file) {
+                if (!file.firstEvent)
+                {
+                    file.firstEvent = now;
+                }
+                file.deadline = now + m_options.debounce;
+            };
+
+            if (fileKey.empty())
+            {
+                for (auto& [name, file] : it->second)
+                {
+                    touch(file);
+                }
+            }
+            else if (const auto file = it->second.find(fileKey); file != it->second.end())
+            {
+                touch(file->second);
+            }
+        }
+
+        // When dispatch has work next, nullopt when no event is pending
+        std::optional<Clock::time_point> next_deadline() const
+        {
+            std::lock_guard lock{ m_mutex };
+            std::optional<Clock::time_point> next;
+            for (const auto& [folderKey, folder] : m_folders)
+            {
+                for (const auto& [fileKey, file] : folder)
+                {
+                    if (file.firstEvent)
+                    {
+                        const auto due = due_time(file);
+                        next = next ? (std::min)(*next, due) : due;
+                    }
+                }
+            }
+            return next;
+        }
+
+        // Probes the files whose window ended and calls the watchers of the ones which changed. Returns the
+        // number of callbacks called.
+        size_t dispatch(Clock::time_point now)
+        {
+            struct Due
+            {
+                std::wstring folderKey;
+                std::wstring fileKey;
+                std::wstring path;
+                bool hash;
+            };
+
+            std::vector<Due> due;
+            {
+                std::lock_guard lock{ m_mutex };
+                for (auto& [folderKey, folder] : m_folders)
+                {
+                    for (auto& [fileKey, file] : folder)
+                    {
+                        if (file.firstEvent && due_time(file) <= now)
+                        {
+                            file.firstEvent.reset();
+                            due.push_back({ folderKey, fileKey, file.path, file.hash });
+                        }
+                    }
+                }
+            }
+
+            // Without the lock, the events of the readers aren't held up by the file system
+            std::vector<std::pair<Id, std::shared_ptr<const std::function<void()>>>> callbacks;
+            for (const auto& item : due)
+            {
+                const auto state = m_probe(item.path, item.hash);
+
+                std::lock_guard lock{ m_mutex };
+                m_stats.probes++;
+                const auto folder = m_folders.find(item.folderKey);
+                if (!state || folder == m_folders.end())
+                {
+                    continue;
+                }
+                const auto file = folder->second.find(item.fileKey);
+                if (file == folder->second.end() || file->second.hash != item.hash)
+                {
+                    // removed meanwhile, or it has a new baseline with a hash
+                    continue;
+                }
+
+                const bool fire = !file->second.state || changed(*file->second.state, *state);
+                file->second.state = state;
+                if (fire)
+                {
+                    for (const auto& watcher : file->second.watchers)
+                    {
+                        callbacks.emplace_back(watcher.id, watcher.callback);
+                    }
+                }
+            }
+
+            size_t called = 0;
+            for (const auto& [id, callback] : callbacks)
+            {
+                {
+                    std::lock_guard lock{ m_mutex };
+                    if (!m_ids.contains(id))
+                    {
+                        // removed by an earlier callback
+                        continue;
+                    }
+                    m_running = id;
+                    m_runningThread = std::this_thread::get_id();
+                    m_stats.callbacks++;
+                }
+
+                try
+                {
+                    (*callback)();
+                }
+                catch (...)
+                {
+                    // A failing watcher doesn't keep the others from being called
+                }
+                called++;
+
+                {
+                    std::lock_guard lock{ m_mutex };
+                    m_running = 0;
+                    m_runningThread = {};
+                }
+                m_idle.notify_all();
+            }
+            return called;
+        }
+
+        Stats stats() const
+        {
+            std::lock_guard lock{ m_mutex };
+            return m_stats;
+        }
+
+    private:
+        struct Watcher
+        {
+            Id id;
+            std::shared_ptr<const std::function<void()>> callback;
+        };
+
+        struct File
+        {
+            std::wstring path;
+            std::optional<FileState> state;
+            bool hash = false;
+            std::vector<Watcher> watchers;
+
+            // Set while an event is pending
+            std::optional<Clock::time_point> firstEvent;
+            Clock::time_point deadline;
+        };
+
+        Clock::time_point due_time(const File& file) const
+        {
+            return (std::min)(file.deadline, *file.firstEvent + m_options.max_delay);
+        }
+
+        const Options m_options;
+        const Probe m_probe;
+
+        mutable std::mutex m_mutex;
+        std::condition_variable m_idle;
+        std::map<std::wstring, std::unordered_map<std::wstring, File>> m_folders;
+        std::unordered_map<Id, std::pair<std::wstring, std::wstring>> m_ids;
+        Id m_nextId = 1;
+
+        // The watcher whose callback is being called, 0 for none
+        Id m_running = 0;
+        std::thread::id m_runningThread;
+        Stats m_stats;
+    };
+}
@@ -0,0 +1,233 @@
+#include "pch.h"
+#include <common/interop/async_message_queue.h>
+
+#include <chrono>
+#include <format>
+#include <thread>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UnitTestsCommonLib
+{
+    namespace
+    {
+        struct TestMessage
+        {
+            int producer = 0;
+            int sequence = 0;
+        };
+    }
+
+    TEST_CLASS (AsyncMessageQueueUnitTests)
+    {
+    public:
+        TEST_METHOD (InterruptKeepsQueuedMessages)
+        {
+            AsyncMessageQueue<std::wstring> queue(16);
+            Assert::IsTrue(queue.queue_message(L"first"));
+            Assert::IsTrue(queue.queue_message(L"second"));
+            queue.interrupt();
+
+            Assert::IsFalse(queue.queue_message(L"third"));
+            Assert::AreEqual(std::wstring(L"first"), queue.pop_message().value());
+            Assert::AreEqual(std::wstring(L"second"), queue.pop_message().value());
+            Assert::IsFalse(queue.pop_message().has_value());
+        }
+
+        TEST_METHOD (InterruptWakesConsumerAndBlockedProducer)
+        {
+            AsyncMessageQueue<int> queue(2);
+            queue.queue_message(1);
+            queue.queue_message(2);
+
+            bool producerResult = true;
+            std::thread producer([&] { producerResult = queue.queue_message(3); });
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            queue.interrupt();
+            producer.join();
+            Assert::IsFalse(producerResult);
+
+            std::vector<int> messages;
+            Assert::AreEqual(size_t{ 2 }, queue.drain(messages, 10));
+            Assert::AreEqual(size_t{ 0 }, queue.drain(messages, 10));
+        }
+
+        TEST_METHOD (DrainTakesUpToMaxCount)
+        {
+            AsyncMessageQueue<int> queue(16);
+            for (int i = 0; i < 10; i++)
+            {
+                queue.queue_message(i);
+            }
+
+            std::vector<int> messages;
+            Assert::AreEqual(size_t{ 4 }, queue.drain(messages, 4));
+            Assert::AreEqual(size_t{ 6 }, queue.try_drain(messages, 100));
+            Assert::AreEqual(size_t{ 0 }, queue.try_drain(messages, 100));
+            for (int i = 0; i < 10; i++)
+            {
+                Assert::AreEqual(i, messages[i]);
+            }
+        }
+
+        TEST_METHOD (DropOldest)
+        {
+            AsyncMessageQueue<int> queue(4, OverflowPolicy::DropOldest);
+            for (int i = 0; i < 10; i++)
+            {
+                Assert::IsTrue(queue.queue_message(i));
+            }
+
+            std::vector<int> messages;
+            queue.try_drain(messages, 100);
+            Assert::IsTrue(std::vector<int>{ 6, 7, 8, 9 } == messages);
+            Assert::AreEqual(size_t{ 6 }, queue.dropped_count());
+        }
+
+        TEST_METHOD (CoalesceByKey)
+        {
+            using Message = std::pair<int, int>;
+            AsyncMessageQueue<Message> queue(2, OverflowPolicy::Coalesce, [](const Message& a, const Message& b) { return a.first == b.first; });
+
+            // the ring holds the first two, the rest overflow and replace older messages with the same key,
+            // which moves them after the other overflowed messages
+            for (auto message : { Message{ 1, 0 }, Message{ 2, 0 }, Message{ 3, 0 }, Message{ 4, 0 }, Message{ 3, 1 }, Message{ 4, 1 } })
+            {
+                Assert::IsTrue(queue.queue_message(message));
+            }
+
+            std::vector<Message> messages;
+            queue.try_drain(messages, 100);
+            Assert::IsTrue(std::vector<Message>{ { 1, 0 }, { 2, 0 }, { 3, 1 }, { 4, 1 } } == messages);
+            Assert::AreEqual(size_t{ 2 }, queue.dropped_count());
+
+            // the ring is used again once the overflow is taken
+            queue.queue_message({ 6, 0 });
+            messages.clear();
+            Assert::AreEqual(size_t{ 1 }, queue.try_drain(messages, 100));
+        }
+
+        TEST_METHOD (CoalesceKeepsTheOrderOfTheLatestMessages)
+        {
+            AsyncMessageQueue<std::wstring> queue(2, OverflowPolicy::Coalesce);
+            for (auto message : { L"ring", L"ring", L"A", L"B", L"A" })
+            {
+                queue.queue_message(message);
+            }
+
+            // equal messages have the same key without a key function, and the latest A comes after B
+            std::vector<std::wstring> messages;
+            queue.try_drain(messages, 100);
+            Assert::IsTrue(std::vector<std::wstring>{ L"ring", L"ring", L"B", L"A" } == messages);
+        }
+
+        TEST_METHOD (CoalesceComparesKeysNotHashes)
+        {
+            // every message has the same hash, but different keys
+            struct Message
+            {
+                int key = 0;
+                size_t hash = 0;
+            };
+            AsyncMessageQueue<Message> queue(2, OverflowPolicy::Coalesce, [](const Message& a, const Message& b) { return a.key == b.key; });
+            for (int key = 0; key < 4; key++)
+            {
+                queue.queue_message({ key, 42 });
+            }
+
+            std::vector<Message> messages;
+            Assert::AreEqual(size_t{ 4 }, queue.try_drain(messages, 100));
+            Assert::AreEqual(size_t{ 0 }, queue.dropped_count());
+        }
+
+        TEST_METHOD (CoalesceOverflowIsBounded)
+        {
+            AsyncMessageQueue<int> queue(2, OverflowPolicy::Coalesce, [](int, int) { return false; });
+            for (int i = 1; i <= 6; i++)
+            {
+                queue.queue_message(i);
+            }
+
+            // as many messages as the capacity are kept aside, the oldest of them are dropped
+            std::vector<int> messages;
+            queue.try_drain(messages, 100);
+            Assert::IsTrue(std::vector<int>{ 1, 2, 5, 6 } == messages);
+            Assert::AreEqual(size_t{ 2 }, queue.dropped_count());
+        }
+
+        TEST_METHOD (StressBlockKeepsOrderPerProducer)
+        {
+            constexpr int producerCount = 4;
+            constexpr int messageCount = 50000;
+
+            // a small capacity makes the producers block often
+            AsyncMessageQueue<TestMessage> queue(8, OverflowPolicy::Block);
+            std::vector<std::thread> producers;
+            for (int p = 0; p < producerCount; p++)
+            {
+                producers.emplace_back([&queue, p] {
+                    for (int i = 0; i < messageCount; i++)
+                    {
+                        queue.queue_message(TestMessage{ p, i });
+                    }
+                });
+            }
+
+            std::vector<int> last(producerCount, -1);
+            size_t received = 0;
+            std::vector<TestMessage> messages;
+            while (received < producerCount * messageCount)
+            {
+                messages.clear();
+                received += queue.drain(messages, 16);
+                for (const auto& message : messages)
+                {
+                    Assert::AreEqual(last[message.producer] + 1, message.sequence);
+                    last[message.producer] = message.sequence;
+                }
+            }
+
+            for (auto& producer : producers)
+            {
+                producer.join();
+            }
+            Assert::AreEqual(size_t{ 0 }, queue.try_drain(messages, 1));
+        }
+
+        TEST_METHOD (Throughput)
+        {
+            // Not a pass/fail benchmark, the numbers are written to the test log
+            constexpr int producerCount = 4;
+            constexpr int messageCount = 250000;
+
+            AsyncMessageQueue<std::wstring> queue;
+            auto start = std::chrono::steady_clock::now();
+            std::vector<std::thread> producers;
+            for (int p = 0; p < producerCount; p++)
+            {
+                producers.emplace_back([&queue] {
+                    for (int i = 0; i < messageCount; i++)
+                    {
+                        queue.queue_message(std::wstring(L"{\"refresh\":{}}"));
+                    }
+                });
+            }
+
+            size_t received = 0;
+            std::vector<std::wstring> messages;
+            while (received < producerCount * messageCount)
+            {
+                messages.clear();
+                received += queue.drain(messages, 64);
+            }
+
+            for (auto& producer : producers)
+            {
+                producer.join();
+            }
+
+            auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            Logger::WriteMessage(std::format("{:.0f} messages/s", received / seconds).c_str());
+        }
+    };
+}
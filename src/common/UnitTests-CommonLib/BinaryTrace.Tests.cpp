@@ -0,0 +1,115 @@
+#include "pch.h"
+#include <common/logger/binary_trace.h>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace BinaryTrace;
+
+namespace UnitTestsCommonLib
+{
+    namespace
+    {
+        // Builds a trace file the way BinaryTraceSink writes it
+        struct TraceFile
+        {
+            std::string data;
+
+            TraceFile()
+            {
+                data.append(FileMagic, sizeof(FileMagic));
+                write_value(data, FileVersion);
+                write_value(data, uint32_t{ 1234 });
+            }
+
+            void Format(uint32_t id, std::wstring_view text)
+            {
+                write_value(data, RecordKind::Format);
+                write_value(data, id);
+                write_string(data, text);
+            }
+
+            void Event(const std::string& payload, uint8_t level = 0)
+            {
+                write_value(data, RecordKind::Event);
+                write_value(data, int64_t{ 0 });
+                write_value(data, uint32_t{ 42 });
+                write_value(data, level);
+                data.append(payload, 1, sizeof(uint32_t));
+                write_value(data, static_cast<uint32_t>(payload.size() - 1 - sizeof(uint32_t)));
+                data.append(payload, 1 + sizeof(uint32_t));
+            }
+        };
+    }
+
+    TEST_CLASS (BinaryTraceUnitTests)
+    {
+    public:
+        TEST_METHOD (FormatMessage)
+        {
+            std::vector<Arg> args{ std::wstring(L"notepad.exe"), int64_t{ 42 }, 3.14159, true };
+            Assert::AreEqual(std::wstring(L"notepad.exe:   42 3.14 true {x} 42"), format_message(L"{}:{:>5} {:.2f} {} {{x}} {1}", args));
+
+            // missing arguments and broken fields are kept as they are
+            Assert::AreEqual(std::wstring(L"notepad.exe {} {"), format_message(L"{} {} {", { std::wstring(L"notepad.exe") }));
+        }
+
+        TEST_METHOD (EncodedArgumentsRoundTrip)
+        {
+            enum class Mode
+            {
+                Show = 3
+            };
+
+            TraceFile file;
+            file.Format(1, L"ChordKeyboardHandler:{}, pid:{}, mode:{}, elevated:{}, {}");
+
+            const wchar_t name[] = L"notepad.exe";
+            std::string payload;
+            encode_payload(payload, 1, name, DWORD{ 1234 }, Mode::Show, false, std::wstring_view(L"\u00e9"));
+            file.Event(payload, 1);
+            encode_payload(payload, 1, std::wstring(L"cmd.exe"), -1, 0u, true, L"");
+            file.Event(payload);
+
+            Decoder decoder(file.data);
+            Assert::AreEqual(uint32_t{ 1234 }, decoder.process_id());
+
+            auto record = decoder.next();
+            Assert::AreEqual(std::wstring(L"ChordKeyboardHandler:notepad.exe, pid:1234, mode:3, elevated:false, \u00e9"), record->message);
+            Assert::AreEqual(uint8_t{ 1 }, record->level);
+            Assert::AreEqual(uint32_t{ 42 }, record->threadId);
+            Assert::AreEqual(std::wstring(L"ChordKeyboardHandler:cmd.exe, pid:-1, mode:0, elevated:true, "), decoder.next()->message);
+            Assert::IsFalse(decoder.next().has_value());
+            Assert::IsFalse(decoder.failed());
+        }
+
+        TEST_METHOD (TruncatedFile)
+        {
+            TraceFile file;
+            file.Format(1, L"value {}");
+            std::string payload;
+            for (int i = 0; i < 3; i++)
+            {
+                encode_payload(payload, 1, i);
+                file.Event(payload);
+            }
+
+            // a crash cut the last record short, the complete ones are still decoded
+            Decoder decoder(file.data.substr(0, file.data.size() - 3));
+            Assert::AreEqual(std::wstring(L"value 0"), decoder.next()->message);
+            Assert::AreEqual(std::wstring(L"value 1"), decoder.next()->message);
+            Assert::IsFalse(decoder.next().has_value());
+            Assert::IsTrue(decoder.failed());
+
+            Assert::IsTrue(Decoder("not a trace").failed());
+        }
+
+        TEST_METHOD (UnsupportedArgumentsAreNotEncodable)
+        {
+            static_assert(is_encodable_arg<wchar_t[16]>());
+            static_assert(is_encodable_arg<const std::wstring&>());
+            static_assert(is_encodable_arg<double>());
+            static_assert(!is_encodable_arg<std::string>());
+            static_assert(!is_encodable_arg<wchar_t>());
+            static_assert(!is_encodable_arg<void*>());
+        }
+    };
+}
@@ -0,0 +1,168 @@
+#include "pch.h"
+#include <common/utils/excluded_apps.h>
+
+#include <chrono>
+#include <format>
+#include <random>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UnitTestsCommonLib
+{
+    namespace
+    {
+        bool TitleContainsAny(const std::wstring& title, const std::vector<std::wstring>& apps)
+        {
+            for (const auto& app : apps)
+            {
+                if (title.contains(app))
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // Excluded apps and paths made of few letters, so that the entries overlap each other and the paths
+        std::wstring RandomText(std::mt19937& random, size_t minLength, size_t maxLength, bool slashes)
+        {
+            std::uniform_int_distribution<size_t> length(minLength, maxLength);
+            std::uniform_int_distribution<int> letter(0, slashes ? 4 : 3);
+            std::wstring text(length(random), L'A');
+            for (auto& c : text)
+            {
+                const int value = letter(random);
+                c = value == 4 ? L'\\' : static_cast<wchar_t>(L'A' + value);
+            }
+            return text;
+        }
+
+        std::vector<std::wstring> ManyApps(size_t count)
+        {
+            std::vector<std::wstring> apps;
+            for (size_t i = 0; i < count; i++)
+            {
+                apps.push_back(L"APP" + std::to_wstring(1000 + i).substr(1) + L".EXE");
+            }
+            return apps;
+        }
+    }
+
+    TEST_CLASS (ExcludedAppsUnitTests)
+    {
+    public:
+        TEST_METHOD (MatchesFileNames)
+        {
+            const std::vector<std::wstring> apps = { L"NOTEPAD", L"\\CODE.EXE", L"SYSTEM32\\CMD" };
+            const ExcludedAppsMatcher matcher{ apps };
+
+            Assert::IsTrue(matcher.find_app_name_in_path(L"C:\\WINDOWS\\NOTEPAD.EXE"));
+            Assert::IsTrue(matcher.find_app_name_in_path(L"C:\\PROGRAMS\\VS CODE\\CODE.EXE"));
+            Assert::IsTrue(matcher.find_app_name_in_path(L"C:\\WINDOWS\\SYSTEM32\\CMD.EXE"));
+
+            // Only in the name of a folder, or not at the start of the file name
+            Assert::IsFalse(matcher.find_app_name_in_path(L"C:\\NOTEPAD\\EDIT.EXE"));
+            Assert::IsFalse(matcher.find_app_name_in_path(L"C:\\TOOLS\\MYNOTEPAD.EXE"));
+            Assert::IsFalse(matcher.find_app_name_in_path(L"NOTEPAD.EXE"));
+
+            // The last occurrence decides, like rfind does
+            Assert::IsFalse(matcher.find_app_name_in_path(L"C:\\TOOLS\\NOTEPAD-NOTEPAD.EXE"));
+            Assert::IsFalse(ExcludedAppsMatcher{}.find_app_name_in_path(L"C:\\WINDOWS\\NOTEPAD.EXE"));
+        }
+
+        TEST_METHOD (MatchesTitles)
+        {
+            const ExcludedAppsMatcher matcher{ { L"NOTEPAD", L"PAD++", L"VISUAL STUDIO" } };
+
+            Assert::IsTrue(matcher.find_in_title(L"UNTITLED - NOTEPAD"));
+            Assert::IsTrue(matcher.find_in_title(L"NOTEPAD++"));
+            Assert::IsTrue(matcher.find_in_title(L"SOLUTION - MICROSOFT VISUAL STUDIO"));
+            Assert::IsFalse(matcher.find_in_title(L"NOTEPA"));
+            Assert::IsFalse(matcher.find_in_title(L""));
+            Assert::IsTrue(ExcludedAppsMatcher{}.empty());
+            Assert::IsFalse(matcher.empty());
+        }
+
+        TEST_METHOD (SameResultsAsTheLists)
+        {
+            std::mt19937 random{ 7 };
+            for (int round = 0; round < 200; round++)
+            {
+                std::vector<std::wstring> apps;
+                const size_t count = random() % 8;
+                for (size_t i = 0; i < count; i++)
+                {
+                    apps.push_back(RandomText(random, 1, 4, true));
+                }
+                const ExcludedAppsMatcher matcher{ apps };
+
+                for (int query = 0; query < 100; query++)
+                {
+                    const auto path = RandomText(random, 0, 16, true);
+                    Assert::AreEqual(find_app_name_in_path(path, apps), matcher.find_app_name_in_path(path));
+
+                    const auto title = RandomText(random, 0, 16, false);
+                    Assert::AreEqual(TitleContainsAny(title, apps), matcher.find_in_title(title));
+                }
+            }
+        }
+
+        TEST_METHOD (EmptyEntriesMatchLikeTheLists)
+        {
+            const std::vector<std::wstring> apps = { L"" };
+            const ExcludedAppsMatcher matcher{ apps };
+
+            for (const std::wstring path : { L"C:\\APPS\\", L"C:\\APPS\\APP.EXE", L"APP.EXE", L"" })
+            {
+                Assert::AreEqual(find_app_name_in_path(path, apps), matcher.find_app_name_in_path(path));
+            }
+            Assert::IsTrue(matcher.find_in_title(L"ANY TITLE"));
+        }
+
+        TEST_METHOD (Benchmark500Entries)
+        {
+            const auto apps = ManyApps(500);
+            const ExcludedAppsMatcher matcher{ apps };
+
+            std::vector<std::wstring> paths;
+            for (size_t i = 0; i < 1000; i++)
+            {
+                paths.push_back(L"C:\\PROGRAM FILES\\VENDOR" + std::to_wstring(i % 17) + L"\\PRODUCT\\TOOL" + std::to_wstring(i) + L".EXE");
+            }
+            paths.push_back(L"C:\\PROGRAM FILES\\VENDOR\\APP499.EXE");
+
+            using Clock = std::chrono::steady_clock;
+            size_t listFound = 0;
+            size_t matcherFound = 0;
+
+            auto start = Clock::now();
+            for (int repeat = 0; repeat < 10; repeat++)
+            {
+                for (const auto& path : paths)
+                {
+                    listFound += find_app_name_in_path(path, apps) || TitleContainsAny(path, apps);
+                }
+            }
+            const auto listTime = Clock::now() - start;
+
+            start = Clock::now();
+            for (int repeat = 0; repeat < 10; repeat++)
+            {
+                for (const auto& path : paths)
+                {
+                    matcherFound += matcher.find_app_name_in_path(path) || matcher.find_in_title(path);
+                }
+            }
+            const auto matcherTime = Clock::now() - start;
+
+            Assert::AreEqual(size_t{ 10 }, listFound);
+            Assert::AreEqual(listFound, matcherFound);
+
+            const auto queries = 10.0 * paths.size();
+            Logger::WriteMessage(std::format("500 excluded apps, path and title: list {:.2f} us, matcher {:.2f} us per query",
+                                             std::chrono::duration<double, std::micro>(listTime).count() / queries,
+                                             std::chrono::duration<double, std::micro>(matcherTime).count() / queries)
+                                     .c_str());
+        }
+    };
+}
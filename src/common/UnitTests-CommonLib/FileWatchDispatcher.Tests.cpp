@@ -0,0 +1,272 @@
+#include "pch.h"
+#include <common/SettingsAPI/file_watch_dispatcher.h>
+
+#include <atomic>
+#include <map>
+#include <thread>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace std::chrono_literals;
+
+namespace UnitTestsCommonLib
+{
+    namespace
+    {
+        // Stands in for the file system, the tests change the files and send the events themselves
+        struct FakeFiles
+        {
+            std::map<std::wstring, file_watch::FileState> files;
+            std::map<std::wstring, uint64_t> contents;
+            int probes = 0;
+
+            file_watch::Probe probe()
+            {
+                return [this](const std::wstring& path, bool hash) -> std::optional<file_watch::FileState> {
+                    probes++;
+                    const auto it = files.find(path);
+                    if (it == files.end())
+                    {
+                        return std::nullopt;
+                    }
+                    auto state = it->second;
+                    if (hash)
+                    {
+                        state.hash = contents[path];
+                    }
+                    return state;
+                };
+            }
+
+            void write(const std::wstring& path, uint64_t size, uint64_t content)
+            {
+                auto& state = files[path];
+                state.size = size;
+                state.mtime++;
+                contents[path] = content;
+            }
+        };
+
+        file_watch::Options MakeOptions()
+        {
+            file_watch::Options options;
+            options.debounce = 100ms;
+            options.max_delay = 1000ms;
+            return options;
+        }
+
+        const std::wstring folder = L"C:\\Users\\u\\AppData\\Local\\Microsoft\\PowerToys\\FancyZones";
+        const std::wstring settingsPath = folder + L"\\settings.json";
+        const file_watch::Clock::time_point t0{};
+    }
+
+    TEST_CLASS (FileWatchDispatcherUnitTests)
+    {
+    public:
+        TEST_METHOD (DebouncesBursts)
+        {
+            FakeFiles fs;
+            fs.write(settingsPath, 10, 1);
+            file_watch::Dispatcher dispatcher{ MakeOptions(), fs.probe() };
+            int called = 0;
+            dispatcher.add(folder, L"settings.json", [&] { called++; });
+
+            // a save through a temporary file: the old one renamed away, the new one renamed in and written
+            fs.write(settingsPath, 12, 2);
+            dispatcher.on_event(folder, L"settings.json", t0);
+            dispatcher.on_event(folder, L"settings.json.tmp", t0 + 10ms);
+            dispatcher.on_event(folder, L"settings.json", t0 + 30ms);
+            dispatcher.on_event(folder, L"settings.json", t0 + 60ms);
+
+            Assert::IsTrue(dispatcher.next_deadline() == t0 + 160ms);
+            Assert::AreEqual(size_t{ 0 }, dispatcher.dispatch(t0 + 100ms));
+            Assert::AreEqual(0, called);
+
+            Assert::AreEqual(size_t{ 1 }, dispatcher.dispatch(t0 + 160ms));
+            Assert::AreEqual(1, called);
+            Assert::IsFalse(dispatcher.next_deadline().has_value());
+            Assert::AreEqual(size_t{ 0 }, dispatcher.dispatch(t0 + 1s));
+        }
+
+        TEST_METHOD (ContinuousEventsWaitAtMostMaxDelay)
+        {
+            FakeFiles fs;
+            file_watch::Dispatcher dispatcher{ MakeOptions(), fs.probe() };
+            int called = 0;
+            dispatcher.add(folder, L"settings.json", [&] { called++; });
+
+            fs.write(settingsPath, 1, 1);
+            auto now = t0;
+            for (; now < t0 + 1500ms; now += 50ms)
+            {
+                dispatcher.on_event(folder, L"settings.json", now);
+                dispatcher.dispatch(now);
+            }
+
+            // the file didn't exist when it was added, its creation is a change
+            Assert::AreEqual(1, called);
+            Assert::AreEqual(2, fs.probes);
+        }
+
+        TEST_METHOD (CallsOnlyForChangedFiles)
+        {
+            FakeFiles fs;
+            fs.write(settingsPath, 10, 1);
+            file_watch::Dispatcher dispatcher{ MakeOptions(), fs.probe() };
+            int called = 0;
+            dispatcher.add(folder, L"settings.json", [&] { called++; });
+
+            // an event without a change
+            dispatcher.on_event(folder, L"settings.json", t0);
+            dispatcher.dispatch(t0 + 1s);
+            Assert::AreEqual(0, called);
+
+            // the same size, but a new modification time
+            fs.write(settingsPath, 10, 1);
+            dispatcher.on_event(folder, L"settings.json", t0 + 2s);
+            dispatcher.dispatch(t0 + 3s);
+            Assert::AreEqual(1, called);
+
+            // a file which can't be read keeps its state, it's compared once it can
+            fs.files.erase(settingsPath);
+            dispatcher.on_event(folder, L"settings.json", t0 + 4s);
+            dispatcher.dispatch(t0 + 5s);
+            Assert::AreEqual(1, called);
+
+            fs.files[settingsPath] = { .size = 10, .mtime = 2, .hash = std::nullopt };
+            dispatcher.on_event(folder, L"settings.json", t0 + 6s);
+            dispatcher.dispatch(t0 + 7s);
+            Assert::AreEqual(1, called);
+        }
+
+        TEST_METHOD (ComparesHashesWhenAsked)
+        {
+            FakeFiles fs;
+            fs.write(settingsPath, 10, 1);
+            file_watch::Dispatcher dispatcher{ MakeOptions(), fs.probe() };
+            int called = 0;
+            dispatcher.add(folder, L"settings.json", [&] { called++; }, true);
+
+            // saved again with the same content
+            fs.write(settingsPath, 10, 1);
+            dispatcher.on_event(folder, L"settings.json", t0);
+            dispatcher.dispatch(t0 + 1s);
+            Assert::AreEqual(0, called);
+
+            fs.write(settingsPath, 10, 7);
+            dispatcher.on_event(folder, L"settings.json", t0 + 2s);
+            dispatcher.dispatch(t0 + 3s);
+            Assert::AreEqual(1, called);
+        }
+
+        TEST_METHOD (DispatchesByNormalizedName)
+        {
+            FakeFiles fs;
+            const std::wstring layoutsPath = folder + L"\\custom-layouts.json";
+            const std::wstring otherFolder = L"C:\\Users\\u\\AppData\\Local\\Microsoft\\PowerToys";
+            fs.write(settingsPath, 10, 1);
+            fs.write(layoutsPath, 10, 1);
+            fs.write(otherFolder + L"\\settings.json", 10, 1);
+
+            file_watch::Dispatcher dispatcher{ MakeOptions(), fs.probe() };
+            int settings = 0;
+            int settings2 = 0;
+            int layouts = 0;
+            int general = 0;
+            dispatcher.add(folder, L"settings.json", [&] { settings++; });
+            dispatcher.add(folder + L"\\", L"Settings.JSON", [&] { settings2++; });
+            dispatcher.add(folder, L"custom-layouts.json", [&] { layouts++; });
+            dispatcher.add(otherFolder, L"settings.json", [&] { general++; });
+
+            fs.write(settingsPath, 11, 2);
+            fs.write(otherFolder + L"\\settings.json", 11, 2);
+            dispatcher.on_event(L"c:\\users\\U\\appdata\\local\\microsoft\\powertoys\\FANCYZONES", L"SETTINGS.json", t0);
+            dispatcher.on_event(folder, L"unrelated.json", t0);
+            Assert::AreEqual(size_t{ 2 }, dispatcher.dispatch(t0 + 1s));
+
+            Assert::AreEqual(1, settings);
+            Assert::AreEqual(1, settings2);
+            Assert::AreEqual(0, layouts);
+            Assert::AreEqual(0, general);
+            Assert::AreEqual(uint64_t{ 2 }, dispatcher.stats().events);
+            Assert::AreEqual(uint64_t{ 1 }, dispatcher.stats().probes);
+        }
+
+        TEST_METHOD (LostEventsCheckTheWholeFolder)
+        {
+            FakeFiles fs;
+            const std::wstring layoutsPath = folder + L"\\custom-layouts.json";
+            fs.write(settingsPath, 10, 1);
+            fs.write(layoutsPath, 10, 1);
+
+            file_watch::Dispatcher dispatcher{ MakeOptions(), fs.probe() };
+            int settings = 0;
+            int layouts = 0;
+            dispatcher.add(folder, L"settings.json", [&] { settings++; });
+            dispatcher.add(folder, L"custom-layouts.json", [&] { layouts++; });
+
+            fs.write(layoutsPath, 20, 2);
+            dispatcher.on_event(folder, L"", t0);
+            dispatcher.dispatch(t0 + 1s);
+
+            Assert::AreEqual(0, settings);
+            Assert::AreEqual(1, layouts);
+            Assert::AreEqual(4, fs.probes);
+        }
+
+        TEST_METHOD (RemovedWatchersAreNotCalled)
+        {
+            FakeFiles fs;
+            fs.write(settingsPath, 10, 1);
+            file_watch::Dispatcher dispatcher{ MakeOptions(), fs.probe() };
+            int first = 0;
+            int second = 0;
+            file_watch::Dispatcher::Id secondId = 0;
+            const auto firstId = dispatcher.add(folder, L"settings.json", [&] {
+                first++;
+                // removing another watcher, and itself, from a callback
+                dispatcher.remove(secondId);
+            });
+            secondId = dispatcher.add(folder, L"settings.json", [&] { second++; });
+
+            fs.write(settingsPath, 11, 2);
+            dispatcher.on_event(folder, L"settings.json", t0);
+            Assert::AreEqual(size_t{ 1 }, dispatcher.dispatch(t0 + 1s));
+            Assert::AreEqual(1, first);
+            Assert::AreEqual(0, second);
+
+            Assert::IsTrue(dispatcher.remove(firstId) == file_watch::normalize(folder));
+            Assert::IsFalse(dispatcher.remove(firstId).has_value());
+
+            fs.write(settingsPath, 12, 3);
+            dispatcher.on_event(folder, L"settings.json", t0 + 2s);
+            Assert::IsFalse(dispatcher.next_deadline().has_value());
+            Assert::AreEqual(size_t{ 0 }, dispatcher.dispatch(t0 + 3s));
+        }
+
+        TEST_METHOD (RemoveWaitsForRunningCallback)
+        {
+            FakeFiles fs;
+            fs.write(settingsPath, 10, 1);
+            file_watch::Dispatcher dispatcher{ MakeOptions(), fs.probe() };
+            std::atomic<bool> started = false;
+            std::atomic<bool> finished = false;
+            const auto id = dispatcher.add(folder, L"settings.json", [&] {
+                started = true;
+                std::this_thread::sleep_for(50ms);
+                finished = true;
+            });
+
+            fs.write(settingsPath, 11, 2);
+            dispatcher.on_event(folder, L"settings.json", t0);
+            std::thread dispatching([&] { dispatcher.dispatch(t0 + 1s); });
+            while (!started)
+            {
+                std::this_thread::sleep_for(1ms);
+            }
+
+            dispatcher.remove(id);
+            Assert::IsTrue(finished);
+            dispatching.join();
+        }
+    };
+}
@@ -0,0 +1,273 @@
+#include "pch.h"
+#include <common/utils/gcode_thumbnail.h>
+
+#include <chrono>
+#include <cstring>
+#include <format>
+#include <random>
+#include <string>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UnitTestsCommonLib
+{
+    namespace
+    {
+        // Hands out text followed by filler lines up to size bytes, counting the bytes handed out
+        struct GeneratedReader
+        {
+            const std::string& text;
+            uint64_t size = 0;
+            size_t chunkSize = SIZE_MAX;
+            uint64_t position = 0;
+
+            size_t operator()(uint8_t* buffer, size_t count)
+            {
+                static constexpr std::string_view filler = "G1 X10.125 Y20.25 E0.0513\n";
+                count = static_cast<size_t>((std::min)({ uint64_t{ count }, uint64_t{ chunkSize }, size - position }));
+                for (size_t i = 0; i < count; i++, position++)
+                {
+                    buffer[i] = static_cast<uint8_t>(position < text.size() ? text[position] : filler[(position - text.size()) % filler.size()]);
+                }
+                return count;
+            }
+        };
+
+        std::optional<gcode::Thumbnail> Find(const std::string& text, uint32_t cx, size_t chunkSize = SIZE_MAX)
+        {
+            return gcode::find_thumbnail(GeneratedReader{ text, text.size(), chunkSize }, cx);
+        }
+
+        std::string Encode(const std::vector<uint8_t>& data, bool padding = true)
+        {
+            constexpr std::string_view alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+            std::string text;
+            for (size_t i = 0; i < data.size(); i += 3)
+            {
+                const size_t count = (std::min)(data.size() - i, size_t{ 3 });
+                uint32_t bits = uint32_t{ data[i] } << 16;
+                bits |= count > 1 ? uint32_t{ data[i + 1] } << 8 : 0;
+                bits |= count > 2 ? data[i + 2] : 0;
+                for (size_t j = 0; j < 4; j++)
+                {
+                    if (j <= count)
+                    {
+                        text += alphabet[(bits >> (18 - 6 * j)) & 0x3f];
+                    }
+                    else if (padding)
+                    {
+                        text += '=';
+                    }
+                }
+            }
+            return text;
+        }
+
+        std::vector<uint8_t> MakeData(size_t size, uint32_t seed)
+        {
+            std::mt19937 random{ seed };
+            std::vector<uint8_t> data(size);
+            for (auto& byte : data)
+            {
+                byte = static_cast<uint8_t>(random());
+            }
+            return data;
+        }
+
+        // Block the way PrusaSlicer writes it, 78 characters per line. The data identifies the block.
+        std::string MakeBlock(std::string_view suffix, uint32_t width, uint32_t height, std::string_view data)
+        {
+            const auto encoded = Encode({ data.begin(), data.end() });
+            std::string block = std::format("; thumbnail{} begin {}x{} {}\n", suffix, width, height, encoded.size());
+            for (size_t i = 0; i < encoded.size(); i += 78)
+            {
+                block += "; " + encoded.substr(i, 78) + "\n";
+            }
+            return block + std::format("; thumbnail{} end\n;\n\n", suffix);
+        }
+
+        std::string DataOf(const std::optional<gcode::Thumbnail>& thumbnail)
+        {
+            return thumbnail ? std::string{ thumbnail->data.begin(), thumbnail->data.end() } : "";
+        }
+
+        const std::string header = "; generated by PrusaSlicer 2.6.0 on 2023-08-01 at 10:00:00 UTC\n\n;\n\n";
+    }
+
+    TEST_CLASS (GcodeThumbnailUnitTests)
+    {
+    public:
+        TEST_METHOD (Base64MatchesEncoder)
+        {
+            for (size_t size = 0; size < 100; size++)
+            {
+                const auto data = MakeData(size, static_cast<uint32_t>(size));
+                for (bool padding : { true, false })
+                {
+                    std::vector<uint8_t> decoded;
+                    Assert::IsTrue(gcode::base64::decode(Encode(data, padding), decoded));
+                    Assert::IsTrue(data == decoded);
+                }
+            }
+        }
+
+        TEST_METHOD (Base64RejectsInvalidCharacters)
+        {
+            const auto valid = Encode(MakeData(60, 1));
+            std::vector<uint8_t> decoded;
+            Assert::IsTrue(gcode::base64::decode(valid, decoded));
+
+            // every position, in and after the vectorized blocks. Padding is only valid at the end.
+            for (size_t i = 0; i < valid.size(); i++)
+            {
+                for (char c : { '-', '_', ' ', '=', '\x80', '\0' })
+                {
+                    if (c == '=' && i == valid.size() - 1)
+                    {
+                        continue;
+                    }
+
+                    auto text = valid;
+                    text[i] = c;
+                    Assert::IsFalse(gcode::base64::decode(text, decoded));
+                }
+            }
+
+            Assert::IsFalse(gcode::base64::decode("QUJDR", decoded));
+            Assert::IsFalse(gcode::base64::decode("QUJD===", decoded));
+        }
+
+        TEST_METHOD (PicksBestThumbnailForSize)
+        {
+            const auto text = header +
+                              MakeBlock("", 16, 16, "png16") +
+                              MakeBlock("_QOI", 300, 300, "qoi300") +
+                              MakeBlock("_JPG", 220, 124, "jpg220") +
+                              MakeBlock("", 300, 300, "png300") +
+                              MakeBlock("_QOI", 16, 16, "qoi16") +
+                              "M73 P0 R30\nG28\n";
+
+            for (size_t chunkSize : { size_t{ 1 }, size_t{ 7 }, SIZE_MAX })
+            {
+                // the smallest one covering cx, the preferred format for the same size
+                Assert::AreEqual(std::string{ "png300" }, DataOf(Find(text, 256, chunkSize)));
+                Assert::AreEqual(std::string{ "jpg220" }, DataOf(Find(text, 200, chunkSize)));
+                Assert::AreEqual(std::string{ "png16" }, DataOf(Find(text, 16, chunkSize)));
+                Assert::AreEqual(std::string{ "png16" }, DataOf(Find(text, 10, chunkSize)));
+
+                // the largest one when none covers cx
+                Assert::AreEqual(std::string{ "png300" }, DataOf(Find(text, 1000, chunkSize)));
+            }
+
+            const auto thumbnail = Find(text, 200);
+            Assert::IsTrue(thumbnail->format == gcode::ThumbnailFormat::JPG);
+            Assert::AreEqual(220u, thumbnail->width);
+            Assert::AreEqual(124u, thumbnail->height);
+        }
+
+        TEST_METHOD (SkipsInvalidBlocks)
+        {
+            auto broken = MakeBlock("", 256, 256, "broken");
+            broken.replace(broken.find('\n') + 3, 1, "!");
+
+            const auto text = header +
+                              "; thumbnails_format = PNG/128x128\n" +
+                              MakeBlock("_JPG", 64, 64, "jpg64") +
+                              broken +
+                              MakeBlock("_BMP", 256, 256, "bmp256") +
+                              "; thumbnail begin 256x256 10\n; thumbnail end\n" +
+                              "G28\n";
+
+            Assert::AreEqual(std::string{ "jpg64" }, DataOf(Find(text, 256)));
+            Assert::IsFalse(Find(header + "G28\n" + MakeBlock("_BMP", 16, 16, "bmp") + "G28\n", 16).has_value());
+            Assert::IsFalse(Find("", 16).has_value());
+
+            // a block without its end line
+            Assert::IsFalse(Find(header + "; thumbnail begin 16x16 8\n; cG5nMTY=\n", 16).has_value());
+        }
+
+        TEST_METHOD (HandlesLinesLongerThanTheWindow)
+        {
+            const std::string longComment = "; " + std::string(gcode::window_size * 3 + 5, 'x') + "\n";
+            const auto text = header + longComment + MakeBlock("", 16, 16, "png16") + "G28\n";
+            Assert::AreEqual(std::string{ "png16" }, DataOf(Find(text, 16, 1000)));
+
+            // a long line inside a block breaks it
+            auto block = MakeBlock("", 32, 32, "png32");
+            block.insert(block.find('\n') + 1, longComment);
+            Assert::AreEqual(std::string{ "png16" }, DataOf(Find(header + MakeBlock("", 16, 16, "png16") + block + "G28\n", 32)));
+        }
+
+        TEST_METHOD (StopsAfterThumbnails)
+        {
+            const auto text = header + MakeBlock("_QOI", 300, 300, "qoi300") + "M73 P0 R30\n";
+            GeneratedReader reader{ text, 1ull << 40 };
+            Assert::AreEqual(std::string{ "qoi300" }, DataOf(gcode::find_thumbnail(reader, 256)));
+            Assert::IsTrue(reader.position <= text.size() + gcode::window_size);
+
+            // files without thumbnails are only read up to the limit
+            const std::string commands = header + "G28\n";
+            GeneratedReader noThumbnail{ commands, 1ull << 40 };
+            Assert::IsFalse(gcode::find_thumbnail(noThumbnail, 256, 1024 * 1024).has_value());
+            Assert::IsTrue(noThumbnail.position <= 1024 * 1024 + gcode::window_size);
+
+            // and those with a late one still find it
+            const std::string late = header + std::string(200'000, '\n') + MakeBlock("", 16, 16, "png16") + "G28\n";
+            Assert::AreEqual(std::string{ "png16" }, DataOf(Find(late, 16)));
+        }
+
+        TEST_METHOD (Fuzz)
+        {
+            const auto valid = header + MakeBlock("_QOI", 30, 30, "qoi30") + MakeBlock("", 60, 60, "png60") + "G28\n";
+            std::mt19937 random{ 7 };
+            constexpr std::string_view alphabet = "; thumbnail_QOIbegendx0123456789=+/\r\n";
+
+            for (int i = 0; i < 5000; i++)
+            {
+                auto text = valid;
+                const int mutations = 1 + random() % 8;
+                for (int j = 0; j < mutations; j++)
+                {
+                    text[random() % text.size()] = random() % 2 ? alphabet[random() % alphabet.size()] : static_cast<char>(random());
+                }
+                if (random() % 4 == 0)
+                {
+                    text.resize(random() % text.size());
+                }
+
+                const auto thumbnail = Find(text, 1 + random() % 100, 1 + random() % 32);
+                if (thumbnail)
+                {
+                    Assert::IsTrue(thumbnail->format != gcode::ThumbnailFormat::Unknown);
+                    Assert::IsFalse(thumbnail->data.empty());
+                }
+            }
+        }
+
+        TEST_METHOD (FileSizeBenchmark)
+        {
+            // Not a pass/fail benchmark, the numbers are written to the test log. The body of the files is
+            // generated while reading, so the large ones don't need the memory.
+            std::string text = header;
+            text += MakeBlock("", 16, 16, std::string(500, 'a'));
+            text += MakeBlock("", 220, 124, std::string(20'000, 'b'));
+            text += MakeBlock("_QOI", 300, 300, std::string(60'000, 'c'));
+            text += "M73 P0 R30\n";
+
+            for (uint64_t size : { 1ull << 20, 1ull << 26, 1ull << 32, 1ull << 38 })
+            {
+                GeneratedReader reader{ text, size, 4096 };
+                const auto start = std::chrono::steady_clock::now();
+                const auto thumbnail = gcode::find_thumbnail(reader, 256);
+                const auto end = std::chrono::steady_clock::now();
+
+                Assert::IsTrue(thumbnail.has_value());
+                Logger::WriteMessage(std::format("{} MB file: {:.2f} ms, {} KB read",
+                                                 size >> 20,
+                                                 std::chrono::duration<double, std::milli>(end - start).count(),
+                                                 reader.position >> 10)
+                                         .c_str());
+            }
+        }
+    };
+}
@@ -0,0 +1,103 @@
+#include "pch.h"
+#include <common/utils/gpo_snapshot.h>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace powertoys_gpo;
+
+namespace UnitTestsCommonLib
+{
+    namespace
+    {
+        const std::wstring fancyZones = L"ConfigureEnabledUtilityFancyZones";
+        const std::wstring global = L"ConfigureGlobalUtilityEnabledState";
+        const std::wstring plugins = L"PowerLauncherIndividualPluginEnabledList";
+        const std::wstring mappingRules = L"MwbPolicyDefinedIpMappingRules";
+    }
+
+    TEST_CLASS (GpoSnapshotUnitTests)
+    {
+    public:
+        TEST_METHOD (MachineScopeHidesUserScope)
+        {
+            PolicyScope machine;
+            machine.set_dword(fancyZones, 0);
+            PolicyScope user;
+            user.set_dword(fancyZones, 1).set_dword(global, 1);
+
+            const PolicySnapshot snapshot{ machine, user };
+            Assert::AreEqual<int>(gpo_rule_configured_disabled, snapshot.configured(fancyZones));
+            Assert::AreEqual<int>(gpo_rule_configured_enabled, snapshot.configured(global));
+        }
+
+        TEST_METHOD (UnsetPoliciesResolveByUserScope)
+        {
+            PolicyScope machine;
+            machine.set_dword(global, 1);
+
+            PolicyScope missing;
+            Assert::AreEqual<int>(gpo_rule_configured_not_configured, PolicySnapshot{ machine, missing }.configured(fancyZones));
+
+            PolicyScope unavailable;
+            unavailable.state = PolicyScope::State::Unavailable;
+            Assert::AreEqual<int>(gpo_rule_configured_unavailable, PolicySnapshot{ machine, unavailable }.configured(fancyZones));
+            Assert::AreEqual<int>(gpo_rule_configured_enabled, PolicySnapshot{ machine, unavailable }.configured(global));
+
+            Assert::AreEqual<int>(gpo_rule_configured_not_configured, PolicySnapshot{}.configured(fancyZones));
+        }
+
+        TEST_METHOD (UnrecognizedValuesAreWrongValues)
+        {
+            PolicyScope machine;
+            machine.set_dword(fancyZones, 2).set_string(global, L"1");
+
+            const PolicySnapshot snapshot{ machine, {} };
+            Assert::AreEqual<int>(gpo_rule_configured_wrong_value, snapshot.configured(fancyZones));
+            Assert::AreEqual<int>(gpo_rule_configured_wrong_value, snapshot.configured(global));
+        }
+
+        TEST_METHOD (NamesAreCaseInsensitive)
+        {
+            PolicyScope machine;
+            machine.set_dword(L"configureenabledutilityfancyzones", 1);
+            machine.set_list_string(L"POWERLAUNCHERINDIVIDUALPLUGINENABLEDLIST", L"791fc278ba4c4bd0b6e3d1ad8f0ab0e2", L"0");
+
+            const PolicySnapshot snapshot{ machine, {} };
+            Assert::AreEqual<int>(gpo_rule_configured_enabled, snapshot.configured(fancyZones));
+            Assert::IsTrue(snapshot.list_value(plugins, L"791FC278BA4C4BD0B6E3D1AD8F0AB0E2") == L"0");
+        }
+
+        TEST_METHOD (ListsAreNotMixed)
+        {
+            PolicyScope machine;
+            machine.set_list_string(plugins, L"a", L"0");
+            PolicyScope user;
+            user.set_list_string(plugins, L"a", L"1").set_list_string(plugins, L"b", L"1");
+
+            // The list of the machine scope is used, even for the values it doesn't have
+            const PolicySnapshot snapshot{ machine, user };
+            Assert::IsTrue(snapshot.list_value(plugins, L"a") == L"0");
+            Assert::IsFalse(snapshot.list_value(plugins, L"b").has_value());
+
+            const PolicySnapshot userOnly{ {}, user };
+            Assert::IsTrue(userOnly.list_value(plugins, L"a") == L"1");
+            Assert::IsTrue(userOnly.list_value(plugins, L"b") == L"1");
+            Assert::IsFalse(userOnly.list_value(L"OtherList", L"a").has_value());
+        }
+
+        TEST_METHOD (MultiStringsOfTheMachineScopeComeFirst)
+        {
+            PolicyScope machine;
+            PolicyScope user;
+            user.set_string(mappingRules, L"pc1 10.0.0.1\r\npc2 10.0.0.2", true);
+            Assert::IsTrue(PolicySnapshot{ machine, user }.multi_string(mappingRules) == L"pc1 10.0.0.1\r\npc2 10.0.0.2");
+
+            // A value of another type doesn't hide the one of the user scope
+            machine.set_string(mappingRules, L"pc3 10.0.0.3");
+            Assert::IsTrue(PolicySnapshot{ machine, user }.multi_string(mappingRules) == L"pc1 10.0.0.1\r\npc2 10.0.0.2");
+
+            machine.set_string(mappingRules, L"pc3 10.0.0.3", true);
+            Assert::IsTrue(PolicySnapshot{ machine, user }.multi_string(mappingRules) == L"pc3 10.0.0.3");
+            Assert::IsFalse(PolicySnapshot{}.multi_string(mappingRules).has_value());
+        }
+    };
+}
@@ -0,0 +1,275 @@
+#include "pch.h"
+#include <common/interop/message_framing.h>
+
+#include <chrono>
+#include <format>
+#include <thread>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace MessageFraming;
+
+namespace UnitTestsCommonLib
+{
+    namespace
+    {
+        std::vector<uint8_t> Encode(const std::vector<MessageBuffer>& messages)
+        {
+            std::vector<uint8_t> result;
+            for (const auto& message : messages)
+            {
+                encode(message, result);
+            }
+            return result;
+        }
+
+        // One direction of a loopback connection over an anonymous pipe
+        struct PipeStream
+        {
+            HANDLE read = nullptr;
+            HANDLE write = nullptr;
+
+            PipeStream()
+            {
+                Assert::IsTrue(CreatePipe(&read, &write, nullptr, 64 * 1024));
+            }
+
+            ~PipeStream()
+            {
+                CloseWrite();
+                CloseHandle(read);
+            }
+
+            void CloseWrite()
+            {
+                if (write)
+                {
+                    CloseHandle(write);
+                    write = nullptr;
+                }
+            }
+
+            FrameReader Reader()
+            {
+                return FrameReader([this](uint8_t* buffer, size_t size) -> ptrdiff_t {
+                    DWORD bytesRead = 0;
+                    if (!ReadFile(read, buffer, static_cast<DWORD>(size), &bytesRead, nullptr))
+                    {
+                        return -1;
+                    }
+                    return bytesRead;
+                });
+            }
+
+            FrameWriter Writer()
+            {
+                return FrameWriter([this](const uint8_t* data, size_t size) {
+                    while (size > 0)
+                    {
+                        DWORD bytesWritten = 0;
+                        if (!WriteFile(write, data, static_cast<DWORD>(size), &bytesWritten, nullptr))
+                        {
+                            return false;
+                        }
+                        data += bytesWritten;
+                        size -= bytesWritten;
+                    }
+                    return true;
+                });
+            }
+        };
+    }
+
+    TEST_CLASS (MessageFramingUnitTests)
+    {
+    public:
+        TEST_METHOD (TextRoundTrip)
+        {
+            const std::wstring text = L"{\"action\":{\"general\":{\"action_name\":\"restart_elevation\"}}} \u00e9\u4e2d";
+            std::vector<uint8_t> frames;
+            encode(MessageBuffer::from_text(text), frames);
+
+            FrameDecoder decoder;
+            Assert::IsTrue(decoder.feed(frames.data(), frames.size()));
+            auto message = decoder.next();
+            Assert::IsTrue(message.has_value());
+            Assert::IsTrue(message->type() == PayloadType::Text);
+            Assert::AreEqual(text, message->to_text());
+            Assert::IsFalse(decoder.next().has_value());
+        }
+
+        TEST_METHOD (EmptyMessages)
+        {
+            std::vector<MessageBuffer> messages;
+            messages.push_back(MessageBuffer::from_text(L""));
+            messages.push_back(MessageBuffer(PayloadType::Binary, {}));
+            auto frames = Encode(messages);
+            Assert::AreEqual(FrameHeaderSize * 2, frames.size());
+
+            FrameDecoder decoder;
+            decoder.feed(frames.data(), frames.size());
+            Assert::AreEqual(std::wstring(), decoder.next()->to_text());
+            Assert::IsTrue(decoder.next()->payload().empty());
+            Assert::IsFalse(decoder.next().has_value());
+        }
+
+        TEST_METHOD (MessagesSplitAcrossReads)
+        {
+            std::vector<MessageBuffer> messages;
+            for (uint8_t i = 0; i < 20; i++)
+            {
+                messages.push_back(MessageBuffer(PayloadType::Binary, std::vector<uint8_t>(i * 7, i)));
+            }
+            auto frames = Encode(messages);
+
+            // feed the stream byte by byte, which is the worst chunking a transport can do
+            FrameDecoder decoder;
+            std::vector<MessageBuffer> decoded;
+            for (uint8_t byte : frames)
+            {
+                decoder.feed(&byte, 1);
+                while (auto message = decoder.next())
+                {
+                    decoded.push_back(std::move(message.value()));
+                }
+            }
+
+            Assert::AreEqual(messages.size(), decoded.size());
+            for (size_t i = 0; i < messages.size(); i++)
+            {
+                Assert::IsTrue(decoded[i].type() == PayloadType::Binary);
+                Assert::IsTrue(messages[i].payload() == decoded[i].payload());
+            }
+        }
+
+        TEST_METHOD (CorruptStreamFails)
+        {
+            const uint8_t garbage[] = { 'h', 'e', 'l', 'l', 'o', ' ', 'w', 'o', 'r', 'l', 'd' };
+            FrameDecoder decoder;
+            Assert::IsTrue(decoder.feed(garbage, sizeof(garbage)));
+            Assert::IsFalse(decoder.next().has_value());
+            Assert::IsTrue(decoder.failed());
+            Assert::IsFalse(decoder.feed(garbage, sizeof(garbage)));
+        }
+
+        TEST_METHOD (OversizedFrameFails)
+        {
+            std::vector<uint8_t> frames;
+            encode(MessageBuffer(PayloadType::Binary, { 1, 2, 3 }), frames);
+            const uint32_t size = MaxPayloadSize + 1;
+            memcpy(frames.data() + 4, &size, sizeof(size));
+
+            FrameDecoder decoder;
+            decoder.feed(frames.data(), frames.size());
+            Assert::IsFalse(decoder.next().has_value());
+            Assert::IsTrue(decoder.failed());
+        }
+
+        TEST_METHOD (OversizedPayloadIsNotEncoded)
+        {
+            std::vector<uint8_t> frames;
+            encode(MessageBuffer::from_text(L"before"), frames);
+            const auto encodedSize = frames.size();
+
+            const MessageBuffer oversized(PayloadType::Binary, std::vector<uint8_t>(MaxPayloadSize + 1));
+            Assert::IsFalse(encode(oversized, frames));
+            Assert::AreEqual(encodedSize, frames.size());
+
+            size_t writes = 0;
+            FrameWriter writer([&](const uint8_t*, size_t) {
+                writes++;
+                return true;
+            });
+            Assert::IsFalse(writer.write(oversized));
+            Assert::AreEqual(size_t{ 0 }, writes);
+
+            // The other messages of a batch are still sent
+            std::vector<MessageBuffer> batch;
+            batch.push_back(MessageBuffer::from_text(L"a"));
+            batch.push_back(MessageBuffer(PayloadType::Binary, std::vector<uint8_t>(MaxPayloadSize + 1)));
+            Assert::IsFalse(writer.write(batch));
+            Assert::AreEqual(size_t{ 1 }, writes);
+        }
+
+        TEST_METHOD (PayloadIsMovedNotCopied)
+        {
+            std::vector<uint8_t> payload(1024, 42);
+            const uint8_t* data = payload.data();
+            MessageBuffer message(PayloadType::Binary, std::move(payload));
+            MessageBuffer moved = std::move(message);
+            Assert::IsTrue(data == moved.payload().data());
+            Assert::IsTrue(data == moved.release().data());
+        }
+
+        TEST_METHOD (LoopbackThroughputAndLatency)
+        {
+            // Not a pass/fail benchmark, the numbers are written to the test log
+            constexpr size_t messageCount = 100000;
+            constexpr size_t batchSize = 64;
+            const std::wstring text = L"{\"powertoys\":{\"Workspaces\":{\"properties\":{}}}}";
+
+            PipeStream stream;
+            auto start = std::chrono::steady_clock::now();
+            std::thread sender([&] {
+                auto writer = stream.Writer();
+                std::vector<MessageBuffer> batch;
+                for (size_t i = 0; i < messageCount; i++)
+                {
+                    batch.push_back(MessageBuffer::from_text(text));
+                    if (batch.size() == batchSize)
+                    {
+                        writer.write(batch);
+                        batch.clear();
+                    }
+                }
+                writer.write(batch);
+                stream.CloseWrite();
+            });
+
+            auto reader = stream.Reader();
+            size_t received = 0;
+            while (auto message = reader.read())
+            {
+                if (received == 0)
+                {
+                    Assert::AreEqual(text, message->to_text());
+                }
+                received++;
+            }
+            sender.join();
+            auto throughputTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            Assert::AreEqual(messageCount, received);
+
+            // round trips of a small binary message
+            constexpr size_t roundTrips = 2000;
+            PipeStream request;
+            PipeStream response;
+            std::thread echo([&] {
+                auto echoReader = request.Reader();
+                auto echoWriter = response.Writer();
+                while (auto message = echoReader.read())
+                {
+                    echoWriter.write(message.value());
+                }
+            });
+
+            auto requestWriter = request.Writer();
+            auto responseReader = response.Reader();
+            start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < roundTrips; i++)
+            {
+                requestWriter.write(MessageBuffer(PayloadType::Binary, { static_cast<uint8_t>(i), 1, 2, 3 }));
+                auto message = responseReader.read();
+                Assert::IsTrue(message.has_value());
+                Assert::AreEqual(static_cast<uint8_t>(i), message->payload()[0]);
+            }
+            auto latencyTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            request.CloseWrite();
+            echo.join();
+
+            Logger::WriteMessage(std::format("{:.0f} messages/s, {:.1f} us per round trip",
+                                             messageCount / throughputTime,
+                                             latencyTime * 1000000 / roundTrips)
+                                     .c_str());
+        }
+    };
+}
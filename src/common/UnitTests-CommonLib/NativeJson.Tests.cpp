@@ -0,0 +1,159 @@
+#include "pch.h"
+#include <common/utils/json.h>
+#include <common/utils/native_json.h>
+
+#include <chrono>
+#include <format>
+#include <limits>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UnitTestsCommonLib
+{
+    namespace
+    {
+        // A document shaped like app-zone-history.json
+        std::string MakeHistory(int appCount)
+        {
+            json::native::Writer writer;
+            writer.begin_object().key(L"app-zone-history").begin_array();
+            for (int i = 0; i < appCount; i++)
+            {
+                writer.begin_object().member(L"app-path", std::format(L"C:\\Program Files\\App{}\\app.exe", i));
+                writer.key(L"history").begin_array().begin_object();
+                writer.key(L"zone-index-set").begin_array().value(i % 4).value(i % 4 + 1).end_array();
+                writer.key(L"device").begin_object();
+                writer.member(L"monitor", L"DELA0E5").member(L"monitor-instance", L"5&1234abcd&0&UID4352").member(L"monitor-number", 1);
+                writer.member(L"virtual-desktop", L"{5F3E8F5D-1234-4567-89AB-0123456789AB}");
+                writer.end_object();
+                writer.member(L"zoneset-uuid", L"{5F3E8F5D-1234-4567-89AB-0123456789AB}");
+                writer.end_object().end_array().end_object();
+            }
+            writer.end_array().end_object();
+            return writer.release();
+        }
+    }
+
+    TEST_CLASS (NativeJsonUnitTests)
+    {
+    public:
+        TEST_METHOD (ParseValues)
+        {
+            auto document = json::native::Document::parse(R"( {"number":-1.5e2,"array":[true,false,null],"object":{"text":"plain"},"escaped":"a\"\\\n\u00e9\ud83d\ude00"} )");
+            Assert::IsTrue(document.has_value());
+
+            const auto& root = document->root();
+            Assert::AreEqual(-150.0, root.get_named_number(L"number"));
+            const auto& array = root.get_named_array(L"array");
+            Assert::AreEqual(size_t{ 3 }, array.size());
+            Assert::IsTrue(array[0].get_boolean());
+            Assert::IsFalse(array[1].get_boolean());
+            Assert::IsTrue(array[2].is_null());
+            Assert::AreEqual(std::wstring(L"plain"), root.get_named_object(L"object").get_named_string(L"text"));
+            Assert::AreEqual(std::wstring(L"a\"\\\n\u00e9\U0001F600"), root.get_named_string(L"escaped"));
+        }
+
+        TEST_METHOD (MissingAndMistypedMembers)
+        {
+            auto document = json::native::Document::parse(R"({"number":1,"text":"x"})");
+            const auto& root = document->root();
+
+            Assert::IsFalse(root.has_key(L"missing"));
+            Assert::AreEqual(std::wstring(L"default"), root.get_named_string(L"missing", L"default"));
+            Assert::ExpectException<json::native::error>([&] { root.get_named_string(L"missing"); });
+            Assert::ExpectException<json::native::error>([&] { root.get_named_string(L"number"); });
+            Assert::ExpectException<json::native::error>([&] { root.get_named_number(L"text", 0); });
+
+            int number = 0;
+            json::native::get(root, L"number", number);
+            Assert::AreEqual(1, number);
+            json::native::get(root, L"text", number, 7);
+            Assert::AreEqual(7, number);
+        }
+
+        TEST_METHOD (InvalidDocuments)
+        {
+            for (const char* text : { "", "{", "[1,]", "{\"a\":1,}", "{\"a\"}", "01", "1.", "tru", "[1] x", "\"a\nb\"", "\"\\x\"" })
+            {
+                Assert::IsFalse(json::native::Document::parse(text).has_value());
+            }
+
+            // too deep to parse on the stack
+            Assert::IsFalse(json::native::Document::parse(std::string(1000, '[') + std::string(1000, ']')).has_value());
+        }
+
+        TEST_METHOD (WriterRoundTrip)
+        {
+            json::native::Writer writer;
+            writer.begin_object();
+            writer.member(L"text", L"q\"\u00e9\x01");
+            writer.member(L"whole", 3.0).member(L"fraction", 0.25).member(L"flag", true);
+            writer.key(L"empty").begin_array().end_array();
+            writer.end_object();
+            Assert::AreEqual(std::string("{\"text\":\"q\\\"\xC3\xA9\\u0001\",\"whole\":3,\"fraction\":0.25,\"flag\":true,\"empty\":[]}"), writer.str());
+
+            // the text is also valid for Windows.Data.Json
+            auto winrtJson = json::JsonValue::Parse(winrt::to_hstring(writer.str())).GetObjectW();
+            Assert::AreEqual(std::wstring(L"q\"\u00e9\x01"), std::wstring(winrtJson.GetNamedString(L"text")));
+        }
+
+        TEST_METHOD (WriterNumbersOutsideInt64)
+        {
+            json::native::Writer writer;
+            writer.begin_array();
+            writer.value(1e300).value(-1e20).value(123456789012345.0).value(-0.5);
+            writer.value(std::numeric_limits<double>::infinity()).value(-std::numeric_limits<double>::infinity()).value(std::numeric_limits<double>::quiet_NaN());
+            writer.end_array();
+            Assert::AreEqual(std::string("[1e+300,-1e+20,123456789012345,-0.5,null,null,null]"), writer.str());
+        }
+
+        TEST_METHOD (ParseAndSerializeBenchmark)
+        {
+            // Not a pass/fail benchmark, the numbers are written to the test log
+            constexpr int iterations = 20;
+            constexpr int appCount = 2000;
+            const std::string text = MakeHistory(appCount);
+
+            size_t count = 0;
+            auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < iterations; i++)
+            {
+                auto parsed = json::JsonValue::Parse(winrt::to_hstring(text)).GetObjectW();
+                for (const auto& app : parsed.GetNamedArray(L"app-zone-history"))
+                {
+                    count += app.GetObjectW().GetNamedString(L"app-path").size();
+                }
+            }
+            const double winrtParse = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / iterations;
+
+            start = std::chrono::steady_clock::now();
+            for (int i = 0; i < iterations; i++)
+            {
+                auto document = json::native::Document::parse(text);
+                for (const auto& app : document->root().get_named_array(L"app-zone-history"))
+                {
+                    count += app.get_named_string(L"app-path").size();
+                }
+            }
+            const double nativeParse = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / iterations;
+
+            auto winrtJson = json::JsonValue::Parse(winrt::to_hstring(text)).GetObjectW();
+            start = std::chrono::steady_clock::now();
+            for (int i = 0; i < iterations; i++)
+            {
+                count += winrt::to_string(winrtJson.Stringify()).size();
+            }
+            const double winrtSerialize = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / iterations;
+
+            start = std::chrono::steady_clock::now();
+            for (int i = 0; i < iterations; i++)
+            {
+                count += MakeHistory(appCount).size();
+            }
+            const double nativeSerialize = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / iterations;
+
+            Assert::IsTrue(count > 0);
+            Logger::WriteMessage(std::format("{} bytes, Windows.Data.Json / native: parse {:.2f} / {:.2f} ms, serialize {:.2f} / {:.2f} ms", text.size(), winrtParse, nativeParse, winrtSerialize, nativeSerialize).c_str());
+        }
+    };
+}
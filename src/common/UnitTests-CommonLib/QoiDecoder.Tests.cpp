@@ -0,0 +1,346 @@
+#include "pch.h"
+#include <common/utils/qoi_decoder.h>
+
+#include <cstring>
+#include <random>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UnitTestsCommonLib
+{
+    namespace
+    {
+        // Hands out the data in chunks of at most chunkSize bytes
+        struct MemoryReader
+        {
+            const std::vector<uint8_t>& data;
+            size_t chunkSize = SIZE_MAX;
+            size_t position = 0;
+
+            size_t operator()(uint8_t* buffer, size_t size)
+            {
+                const size_t count = (std::min)({ size, chunkSize, data.size() - position });
+                std::memcpy(buffer, data.data() + position, count);
+                position += count;
+                return count;
+            }
+        };
+
+        std::optional<qoi::Image> Decode(const std::vector<uint8_t>& data, uint32_t maxSize, size_t chunkSize = SIZE_MAX)
+        {
+            return qoi::decode(MemoryReader{ data, chunkSize }, maxSize);
+        }
+
+        std::vector<uint8_t> MakeHeader(uint32_t width, uint32_t height, uint8_t channels = 4)
+        {
+            std::vector<uint8_t> data{ 'q', 'o', 'i', 'f' };
+            for (uint32_t value : { width, height })
+            {
+                for (int shift = 24; shift >= 0; shift -= 8)
+                {
+                    data.push_back(static_cast<uint8_t>(value >> shift));
+                }
+            }
+            data.push_back(channels);
+            data.push_back(0);
+            return data;
+        }
+
+        void AppendEndMarker(std::vector<uint8_t>& data)
+        {
+            data.insert(data.end(), { 0, 0, 0, 0, 0, 0, 0, 1 });
+        }
+
+        // Encoder following the specification, for images decoded by the tests. rgba holds 4 bytes per pixel.
+        std::vector<uint8_t> Encode(const std::vector<uint8_t>& rgba, uint32_t width, uint32_t height)
+        {
+            auto data = MakeHeader(width, height);
+            uint8_t index[64][4]{};
+            uint8_t previous[4]{ 0, 0, 0, 255 };
+            int run = 0;
+
+            const size_t pixelCount = size_t{ width } * height;
+            for (size_t i = 0; i < pixelCount; i++)
+            {
+                const uint8_t* px = &rgba[i * 4];
+                if (std::memcmp(px, previous, 4) == 0)
+                {
+                    if (++run == 62 || i == pixelCount - 1)
+                    {
+                        data.push_back(static_cast<uint8_t>(0xc0 | (run - 1)));
+                        run = 0;
+                    }
+                    continue;
+                }
+
+                if (run > 0)
+                {
+                    data.push_back(static_cast<uint8_t>(0xc0 | (run - 1)));
+                    run = 0;
+                }
+
+                const int hash = (px[0] * 3 + px[1] * 5 + px[2] * 7 + px[3] * 11) % 64;
+                if (std::memcmp(index[hash], px, 4) == 0)
+                {
+                    data.push_back(static_cast<uint8_t>(hash));
+                }
+                else
+                {
+                    std::memcpy(index[hash], px, 4);
+                    if (px[3] == previous[3])
+                    {
+                        const int8_t vr = static_cast<int8_t>(px[0] - previous[0]);
+                        const int8_t vg = static_cast<int8_t>(px[1] - previous[1]);
+                        const int8_t vb = static_cast<int8_t>(px[2] - previous[2]);
+                        const int8_t vgr = static_cast<int8_t>(vr - vg);
+                        const int8_t vgb = static_cast<int8_t>(vb - vg);
+
+                        if (vr > -3 && vr < 2 && vg > -3 && vg < 2 && vb > -3 && vb < 2)
+                        {
+                            data.push_back(static_cast<uint8_t>(0x40 | (vr + 2) << 4 | (vg + 2) << 2 | (vb + 2)));
+                        }
+                        else if (vgr > -9 && vgr < 8 && vg > -33 && vg < 32 && vgb > -9 && vgb < 8)
+                        {
+                            data.push_back(static_cast<uint8_t>(0x80 | (vg + 32)));
+                            data.push_back(static_cast<uint8_t>((vgr + 8) << 4 | (vgb + 8)));
+                        }
+                        else
+                        {
+                            data.insert(data.end(), { 0xfe, px[0], px[1], px[2] });
+                        }
+                    }
+                    else
+                    {
+                        data.insert(data.end(), { 0xff, px[0], px[1], px[2], px[3] });
+                    }
+                }
+                std::memcpy(previous, px, 4);
+            }
+
+            AppendEndMarker(data);
+            return data;
+        }
+
+        // Smooth gradients with noise and flat areas, so every op of the format is used
+        std::vector<uint8_t> MakePixels(uint32_t width, uint32_t height, uint32_t seed)
+        {
+            std::mt19937 random{ seed };
+            std::vector<uint8_t> rgba(size_t{ width } * height * 4);
+            for (uint32_t y = 0; y < height; y++)
+            {
+                for (uint32_t x = 0; x < width; x++)
+                {
+                    uint8_t* px = &rgba[(size_t{ y } * width + x) * 4];
+                    if (x < width / 4)
+                    {
+                        px[0] = 200, px[1] = 10, px[2] = 10, px[3] = 255;
+                    }
+                    else
+                    {
+                        px[0] = static_cast<uint8_t>(x * 3 + random() % 3);
+                        px[1] = static_cast<uint8_t>(y * 2);
+                        px[2] = static_cast<uint8_t>(random() % 8 == 0 ? random() : x + y);
+                        px[3] = static_cast<uint8_t>(y % 16 == 0 ? random() : 255);
+                    }
+                }
+            }
+            return rgba;
+        }
+
+        std::vector<uint8_t> ToBgra(const std::vector<uint8_t>& rgba)
+        {
+            std::vector<uint8_t> bgra(rgba.size());
+            for (size_t i = 0; i < rgba.size(); i += 4)
+            {
+                bgra[i] = rgba[i + 2];
+                bgra[i + 1] = rgba[i + 1];
+                bgra[i + 2] = rgba[i];
+                bgra[i + 3] = rgba[i + 3];
+            }
+            return bgra;
+        }
+    }
+
+    TEST_CLASS (QoiDecoderUnitTests)
+    {
+    public:
+        TEST_METHOD (DecodesEveryOp)
+        {
+            auto data = MakeHeader(4, 2);
+            data.insert(data.end(), {
+                                        0xff, 0x10, 0x20, 0x30, 0x80, // RGBA
+                                        0x76, // DIFF +1 -1 0
+                                        0xa5, 0xa5, // LUMA +5, red +2, blue -3 relative to green
+                                        0xfe, 0x01, 0x02, 0x03, // RGB keeps the alpha
+                                        0x20, // INDEX of the first pixel
+                                        0xc1, // RUN of 2
+                                        0xff, 0x00, 0x00, 0x00, 0x00, // RGBA
+                                    });
+            AppendEndMarker(data);
+
+            const std::vector<uint8_t> expected{
+                0x30, 0x20, 0x10, 0x80,
+                0x30, 0x1f, 0x11, 0x80,
+                0x32, 0x24, 0x18, 0x80,
+                0x03, 0x02, 0x01, 0x80,
+                0x30, 0x20, 0x10, 0x80,
+                0x30, 0x20, 0x10, 0x80,
+                0x30, 0x20, 0x10, 0x80,
+                0x00, 0x00, 0x00, 0x00,
+            };
+
+            const auto image = Decode(data, 256);
+            Assert::IsTrue(image.has_value());
+            Assert::AreEqual(4u, image->width);
+            Assert::AreEqual(2u, image->height);
+            Assert::IsTrue(expected == image->bgra);
+        }
+
+        TEST_METHOD (MatchesReferenceEncoder)
+        {
+            const auto rgba = MakePixels(97, 61, 1);
+            const auto data = Encode(rgba, 97, 61);
+
+            // the reader boundaries must not matter
+            for (size_t chunkSize : { size_t{ 1 }, size_t{ 7 }, SIZE_MAX })
+            {
+                const auto image = Decode(data, 256, chunkSize);
+                Assert::IsTrue(image.has_value());
+                Assert::IsTrue(ToBgra(rgba) == image->bgra);
+            }
+        }
+
+        TEST_METHOD (FitSize)
+        {
+            Assert::IsTrue(std::pair{ 256u, 128u } == qoi::fit_size(1000, 500, 256));
+            Assert::IsTrue(std::pair{ 128u, 256u } == qoi::fit_size(500, 1000, 256));
+            Assert::IsTrue(std::pair{ 256u, 1u } == qoi::fit_size(10000, 1, 256));
+            Assert::IsTrue(std::pair{ 20u, 10u } == qoi::fit_size(20, 10, 256));
+        }
+
+        TEST_METHOD (ScalesDown)
+        {
+            // left half red, right half blue
+            std::vector<uint8_t> rgba;
+            for (int i = 0; i < 16; i++)
+            {
+                const bool left = i % 4 < 2;
+                rgba.insert(rgba.end(), { static_cast<uint8_t>(left ? 255 : 0), 0, static_cast<uint8_t>(left ? 0 : 255), 255 });
+            }
+
+            const auto image = Decode(Encode(rgba, 4, 4), 2);
+            Assert::IsTrue(image.has_value());
+            Assert::AreEqual(2u, image->width);
+            Assert::AreEqual(2u, image->height);
+            const std::vector<uint8_t> expected{ 0, 0, 255, 255, 255, 0, 0, 255, 0, 0, 255, 255, 255, 0, 0, 255 };
+            Assert::IsTrue(expected == image->bgra);
+        }
+
+        TEST_METHOD (ScalingWeightsColorsByAlpha)
+        {
+            // opaque white next to transparent black must stay white and get half the alpha
+            const std::vector<uint8_t> rgba{ 255, 255, 255, 255, 0, 0, 0, 0, 255, 255, 255, 255, 0, 0, 0, 0 };
+            const auto image = Decode(Encode(rgba, 4, 1), 2);
+            Assert::IsTrue(image.has_value());
+            const std::vector<uint8_t> expected{ 255, 255, 255, 128, 255, 255, 255, 128 };
+            Assert::IsTrue(expected == image->bgra);
+        }
+
+        TEST_METHOD (ScalingKeepsAverageColor)
+        {
+            const uint32_t width = 301;
+            const uint32_t height = 199;
+            const auto rgba = MakePixels(width, height, 2);
+            const auto image = Decode(Encode(rgba, width, height), 64);
+            Assert::IsTrue(image.has_value());
+            Assert::AreEqual(64u, image->width);
+            Assert::AreEqual(42u, image->height);
+
+            // the flat left quarter stays exactly the same color
+            Assert::AreEqual(uint8_t{ 10 }, image->bgra[0]);
+            Assert::AreEqual(uint8_t{ 10 }, image->bgra[1]);
+            Assert::AreEqual(uint8_t{ 200 }, image->bgra[2]);
+        }
+
+        TEST_METHOD (ScaleDownMatchesDecode)
+        {
+            const uint32_t width = 301;
+            const uint32_t height = 199;
+            const auto rgba = MakePixels(width, height, 6);
+            const auto bgra = ToBgra(rgba);
+            for (uint32_t maxSize : { 1u, 64u, 200u, 301u, 512u })
+            {
+                const auto scaled = qoi::scale_down(bgra.data(), width, height, maxSize);
+                const auto decoded = Decode(Encode(rgba, width, height), maxSize);
+                Assert::AreEqual(decoded->width, scaled.width);
+                Assert::AreEqual(decoded->height, scaled.height);
+                Assert::IsTrue(decoded->bgra == scaled.bgra);
+            }
+        }
+
+        TEST_METHOD (RejectsInvalidData)
+        {
+            auto valid = Encode(MakePixels(16, 16, 3), 16, 16);
+            Assert::IsTrue(Decode(valid, 16).has_value());
+
+            auto badMagic = valid;
+            badMagic[0] = 'x';
+            Assert::IsFalse(Decode(badMagic, 16).has_value());
+
+            auto badChannels = valid;
+            badChannels[12] = 5;
+            Assert::IsFalse(Decode(badChannels, 16).has_value());
+
+            Assert::IsFalse(Decode(MakeHeader(0, 16), 16).has_value());
+            Assert::IsFalse(Decode(MakeHeader(100'000, 100'000), 16).has_value());
+            Assert::IsFalse(Decode(valid, 0).has_value());
+
+            // truncated pixel data
+            valid.resize(valid.size() / 2);
+            Assert::IsFalse(Decode(valid, 16).has_value());
+        }
+
+        TEST_METHOD (ParseHeader)
+        {
+            uint8_t bytes[qoi::header_size];
+            const auto data = MakeHeader(640, 480, 3);
+            std::copy(data.begin(), data.end(), bytes);
+            const auto header = qoi::parse_header(bytes);
+            Assert::IsTrue(header.has_value());
+            Assert::AreEqual(640u, header->width);
+            Assert::AreEqual(480u, header->height);
+            Assert::AreEqual(uint8_t{ 3 }, header->channels);
+
+            bytes[3] = 'x';
+            Assert::IsFalse(qoi::parse_header(bytes).has_value());
+        }
+
+        TEST_METHOD (Fuzz)
+        {
+            const auto valid = Encode(MakePixels(40, 30, 4), 40, 30);
+            std::mt19937 random{ 5 };
+
+            for (int i = 0; i < 5000; i++)
+            {
+                auto data = valid;
+                const int mutations = 1 + random() % 8;
+                for (int j = 0; j < mutations; j++)
+                {
+                    data[random() % data.size()] = static_cast<uint8_t>(random());
+                }
+                if (random() % 4 == 0)
+                {
+                    data.resize(random() % data.size());
+                }
+
+                const uint32_t maxSize = 1 + random() % 64;
+                const auto image = Decode(data, maxSize, 1 + random() % 32);
+                if (image)
+                {
+                    Assert::IsTrue(image->width <= maxSize && image->height <= maxSize);
+                    Assert::AreEqual(size_t{ image->width } * image->height * 4, image->bgra.size());
+                }
+            }
+        }
+    };
+}
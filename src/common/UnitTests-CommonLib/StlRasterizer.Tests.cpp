@@ -0,0 +1,270 @@
+#include "pch.h"
+#include <common/utils/stl_rasterizer.h>
+
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <format>
+#include <numbers>
+#include <string>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UnitTestsCommonLib
+{
+    namespace
+    {
+        struct MemoryReader
+        {
+            const std::vector<uint8_t>& data;
+            size_t chunkSize = SIZE_MAX;
+            size_t position = 0;
+
+            size_t operator()(uint8_t* buffer, size_t size)
+            {
+                const size_t count = (std::min)({ size, chunkSize, data.size() - position });
+                if (count > 0)
+                {
+                    std::memcpy(buffer, data.data() + position, count);
+                }
+                position += count;
+                return count;
+            }
+        };
+
+        std::optional<stl::Mesh> Parse(const std::vector<uint8_t>& data, size_t maxTriangles = stl::default_max_triangles, size_t chunkSize = SIZE_MAX)
+        {
+            return stl::parse(MemoryReader{ data, chunkSize }, maxTriangles);
+        }
+
+        // Unit cube from (0, 0, 0) to (1, 1, 1)
+        std::vector<stl::Triangle> MakeCube()
+        {
+            const stl::Vec3 v[8]{ { 0, 0, 0 }, { 1, 0, 0 }, { 1, 1, 0 }, { 0, 1, 0 }, { 0, 0, 1 }, { 1, 0, 1 }, { 1, 1, 1 }, { 0, 1, 1 } };
+            const int faces[12][3]{ { 0, 2, 1 }, { 0, 3, 2 }, { 4, 5, 6 }, { 4, 6, 7 }, { 0, 1, 5 }, { 0, 5, 4 }, { 1, 2, 6 }, { 1, 6, 5 }, { 2, 3, 7 }, { 2, 7, 6 }, { 3, 0, 4 }, { 3, 4, 7 } };
+
+            std::vector<stl::Triangle> triangles;
+            for (const auto& face : faces)
+            {
+                triangles.push_back({ v[face[0]], v[face[1]], v[face[2]] });
+            }
+            return triangles;
+        }
+
+        std::vector<uint8_t> ToAscii(const std::vector<stl::Triangle>& triangles)
+        {
+            std::string text = "solid cube\n";
+            for (const auto& triangle : triangles)
+            {
+                text += "  facet normal 0 0 0\n    outer loop\n";
+                for (const auto& v : triangle)
+                {
+                    text += std::format("      vertex {} {:e} +{}\n", v.x, v.y, v.z);
+                }
+                text += "    endloop\n  endfacet\n";
+            }
+            text += "endsolid cube\n";
+            return { text.begin(), text.end() };
+        }
+
+        std::vector<uint8_t> ToBinary(const std::vector<stl::Triangle>& triangles, bool writeCount = true)
+        {
+            // the header starting with "solid" must not make it look like an ASCII file
+            std::vector<uint8_t> data(84);
+            std::memcpy(data.data(), "solid exported as binary", 24);
+            const uint32_t count = writeCount ? static_cast<uint32_t>(triangles.size()) : 0;
+            std::memcpy(data.data() + 80, &count, sizeof(count));
+
+            for (const auto& triangle : triangles)
+            {
+                uint8_t record[50]{};
+                std::memcpy(record + 12, triangle.data(), sizeof(float) * 9);
+                data.insert(data.end(), std::begin(record), std::end(record));
+            }
+            return data;
+        }
+
+        bool SameTriangles(const std::vector<stl::Triangle>& expected, const std::vector<stl::Triangle>& actual)
+        {
+            return expected.size() == actual.size() && std::memcmp(expected.data(), actual.data(), expected.size() * sizeof(stl::Triangle)) == 0;
+        }
+
+        // Lines of '#' for drawn and '.' for transparent pixels
+        std::string Mask(const std::vector<uint8_t>& bgra, uint32_t size)
+        {
+            std::string mask;
+            for (uint32_t y = 0; y < size; y++)
+            {
+                for (uint32_t x = 0; x < size; x++)
+                {
+                    mask += bgra[(size_t{ y } * size + x) * 4 + 3] ? '#' : '.';
+                }
+                mask += '\n';
+            }
+            return mask;
+        }
+
+        // The index of every triangle is stored in the x of its first vertex
+        std::vector<stl::Triangle> MakeIndexedTriangles(size_t count)
+        {
+            std::vector<stl::Triangle> triangles(count);
+            for (size_t i = 0; i < count; i++)
+            {
+                triangles[i] = { stl::Vec3{ static_cast<float>(i), 0, 0 }, stl::Vec3{ 0, 1, 0 }, stl::Vec3{ 0, 0, 1 } };
+            }
+            return triangles;
+        }
+
+        std::vector<stl::Triangle> MakeSphere(int rings, int segments)
+        {
+            auto point = [&](int ring, int segment) {
+                const double theta = std::numbers::pi * ring / rings;
+                const double phi = 2 * std::numbers::pi * segment / segments;
+                return stl::Vec3{ static_cast<float>(std::sin(theta) * std::cos(phi)), static_cast<float>(std::sin(theta) * std::sin(phi)), static_cast<float>(std::cos(theta)) };
+            };
+
+            std::vector<stl::Triangle> triangles;
+            for (int ring = 0; ring < rings; ring++)
+            {
+                for (int segment = 0; segment < segments; segment++)
+                {
+                    triangles.push_back({ point(ring, segment), point(ring + 1, segment), point(ring + 1, segment + 1) });
+                    triangles.push_back({ point(ring, segment), point(ring + 1, segment + 1), point(ring, segment + 1) });
+                }
+            }
+            return triangles;
+        }
+    }
+
+    TEST_CLASS (StlRasterizerUnitTests)
+    {
+    public:
+        TEST_METHOD (ParsesAsciiAndBinary)
+        {
+            const auto cube = MakeCube();
+            for (const auto& data : { ToAscii(cube), ToBinary(cube), ToBinary(cube, false) })
+            {
+                for (size_t chunkSize : { size_t{ 1 }, size_t{ 13 }, SIZE_MAX })
+                {
+                    const auto mesh = Parse(data, stl::default_max_triangles, chunkSize);
+                    Assert::IsTrue(mesh.has_value());
+                    Assert::IsTrue(SameTriangles(cube, mesh->triangles));
+                    Assert::AreEqual(uint64_t{ 1 }, mesh->stride);
+                }
+            }
+        }
+
+        TEST_METHOD (KeepsTrianglesOfTruncatedFiles)
+        {
+            auto data = ToBinary(MakeCube());
+            data.resize(84 + 50 * 5 + 20);
+            const auto mesh = Parse(data);
+            Assert::IsTrue(mesh.has_value());
+            Assert::AreEqual(size_t{ 5 }, mesh->triangles.size());
+        }
+
+        TEST_METHOD (RejectsFilesWithoutTriangles)
+        {
+            const std::string text = "solid empty\nendsolid empty\n";
+            for (const auto& data : { std::vector<uint8_t>{}, std::vector<uint8_t>(text.begin(), text.end()), std::vector<uint8_t>(60, 'x'), ToBinary({}) })
+            {
+                Assert::IsFalse(Parse(data).has_value());
+            }
+        }
+
+        TEST_METHOD (DecimatesLargeMeshesEvenly)
+        {
+            const auto triangles = MakeIndexedTriangles(10'000);
+
+            // the binary count is known up front, the ASCII one isn't
+            for (const auto& data : { ToBinary(triangles), ToAscii(triangles) })
+            {
+                const auto mesh = Parse(data, 1000);
+                Assert::IsTrue(mesh.has_value());
+                Assert::AreEqual(uint64_t{ 10'000 }, mesh->source_triangles);
+                Assert::IsTrue(mesh->triangles.size() <= 1000 && mesh->triangles.size() >= 500);
+                for (size_t i = 0; i < mesh->triangles.size(); i++)
+                {
+                    Assert::AreEqual(static_cast<float>(i * mesh->stride), mesh->triangles[i][0].x);
+                }
+            }
+        }
+
+        TEST_METHOD (RendersGoldenCube)
+        {
+            const auto mesh = Parse(ToBinary(MakeCube()));
+            constexpr uint32_t size = 16;
+            std::vector<uint8_t> bgra(size * size * 4, 0xcd);
+            stl::render(*mesh, size, { 255, 201, 36 }, bgra.data(), 1);
+
+            const std::string expected = "................\n"
+                                         ".....#######....\n"
+                                         ".############...\n"
+                                         ".#############..\n"
+                                         ".##############.\n"
+                                         ".##############.\n"
+                                         ".##############.\n"
+                                         ".##############.\n"
+                                         ".##############.\n"
+                                         ".##############.\n"
+                                         ".##############.\n"
+                                         ".##############.\n"
+                                         "..#############.\n"
+                                         "...############.\n"
+                                         "....#######.....\n"
+                                         "................\n";
+            Assert::AreEqual(expected, Mask(bgra, size));
+
+            // The three visible faces, with their normals along X, Y and Z, are the color darkened by
+            // 0.3 + 0.7 * |normal . light|, which is 0.654, 0.602 and 0.823 for the fixed light
+            const std::array<std::array<uint8_t, 4>, 3> faces{ { { 23, 131, 166, 255 }, { 21, 121, 153, 255 }, { 29, 165, 209, 255 } } };
+            std::array<size_t, 3> counts{};
+            for (size_t i = 0; i < bgra.size(); i += 4)
+            {
+                if (bgra[i + 3])
+                {
+                    const auto face = std::find_if(faces.begin(), faces.end(), [&](const auto& color) { return std::memcmp(color.data(), &bgra[i], color.size()) == 0; });
+                    Assert::IsTrue(face != faces.end());
+                    counts[face - faces.begin()]++;
+                }
+            }
+            Assert::IsTrue(counts[0] > 0 && counts[1] > 0 && counts[2] > 0);
+
+            // The top of the image is the top face
+            Assert::AreEqual(0, std::memcmp(faces[2].data(), &bgra[(2 * size + 7) * 4], 4));
+        }
+
+        TEST_METHOD (RenderingDoesNotDependOnThreads)
+        {
+            const auto mesh = Parse(ToBinary(MakeSphere(40, 80)));
+            constexpr uint32_t size = 97;
+            std::vector<uint8_t> single(size * size * 4);
+            std::vector<uint8_t> multiple(size * size * 4);
+            stl::render(*mesh, size, { 200, 100, 50 }, single.data(), 1);
+            stl::render(*mesh, size, { 200, 100, 50 }, multiple.data(), 8);
+            Assert::IsTrue(single == multiple);
+        }
+
+        TEST_METHOD (LargeMeshBenchmark)
+        {
+            // Not a pass/fail benchmark, the numbers are written to the test log
+            const auto data = ToBinary(MakeSphere(1000, 2000));
+            std::vector<uint8_t> bgra(256 * 256 * 4);
+
+            const auto start = std::chrono::steady_clock::now();
+            const auto mesh = Parse(data);
+            const auto parsed = std::chrono::steady_clock::now();
+            stl::render(*mesh, 256, { 255, 201, 36 }, bgra.data());
+            const auto rendered = std::chrono::steady_clock::now();
+
+            Assert::IsTrue(mesh->triangles.size() <= stl::default_max_triangles);
+            Logger::WriteMessage(std::format("{} MB, {} of {} triangles: parse {:.1f} ms, render {:.1f} ms",
+                                             data.size() / (1024 * 1024),
+                                             mesh->triangles.size(),
+                                             mesh->source_triangles,
+                                             std::chrono::duration<double, std::milli>(parsed - start).count(),
+                                             std::chrono::duration<double, std::milli>(rendered - parsed).count())
+                                     .c_str());
+        }
+    };
+}
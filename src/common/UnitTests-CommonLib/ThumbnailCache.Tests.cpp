@@ -0,0 +1,329 @@
+#include "pch.h"
+#include <common/utils/qoi_encoder.h>
+#include <common/utils/thumbnail_cache_index.h>
+
+#include <chrono>
+#include <format>
+#include <random>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UnitTestsCommonLib
+{
+    namespace
+    {
+        using thumbnail_cache::Index;
+        using thumbnail_cache::Key;
+
+        thumbnail_cache::Options MakeOptions(uint32_t sets = 4, uint64_t maxBytes = 16000)
+        {
+            thumbnail_cache::Options options;
+            options.sets = sets;
+            options.max_bytes = maxBytes;
+            return options;
+        }
+
+        Key MakeKey(uint64_t hash, uint32_t bucket = 256)
+        {
+            return Key{ hash, 1000 + hash, 1234, bucket, 0 };
+        }
+
+        // Image with flat areas, gradients and noise, so every QOI operation is used
+        std::vector<uint8_t> MakeImage(uint32_t width, uint32_t height, uint32_t seed)
+        {
+            std::mt19937 random{ seed };
+            std::vector<uint8_t> bgra(size_t{ width } * height * 4);
+            for (uint32_t y = 0; y < height; y++)
+            {
+                for (uint32_t x = 0; x < width; x++)
+                {
+                    uint8_t* px = bgra.data() + (size_t{ y } * width + x) * 4;
+                    switch ((x / 8 + y / 8) % 4)
+                    {
+                    case 0:
+                        px[0] = 10, px[1] = 20, px[2] = 30, px[3] = 255;
+                        break;
+                    case 1:
+                        px[0] = static_cast<uint8_t>(x), px[1] = static_cast<uint8_t>(y), px[2] = static_cast<uint8_t>(x + y), px[3] = 255;
+                        break;
+                    case 2:
+                        px[0] = static_cast<uint8_t>(x * 7), px[1] = static_cast<uint8_t>(y * 3), px[2] = 0, px[3] = static_cast<uint8_t>(x * 13);
+                        break;
+                    default:
+                        for (int i = 0; i < 4; i++)
+                        {
+                            px[i] = static_cast<uint8_t>(random());
+                        }
+                        break;
+                    }
+                }
+            }
+            return bgra;
+        }
+    }
+
+    TEST_CLASS (ThumbnailCacheUnitTests)
+    {
+    public:
+        TEST_METHOD (SizeBuckets)
+        {
+            Assert::AreEqual(16u, thumbnail_cache::size_bucket(1));
+            Assert::AreEqual(32u, thumbnail_cache::size_bucket(32));
+            Assert::AreEqual(64u, thumbnail_cache::size_bucket(48));
+            Assert::AreEqual(256u, thumbnail_cache::size_bucket(190));
+            Assert::AreEqual(1024u, thumbnail_cache::size_bucket(1024));
+            Assert::AreEqual(1500u, thumbnail_cache::size_bucket(1500));
+        }
+
+        TEST_METHOD (HashCoversEveryByte)
+        {
+            std::vector<uint8_t> data(1000, 7);
+            const auto hash = thumbnail_cache::hash_prefix(data);
+            Assert::AreEqual(hash, thumbnail_cache::hash_prefix(data));
+
+            for (size_t i = 0; i < data.size(); i++)
+            {
+                auto changed = data;
+                changed[i] ^= 1;
+                Assert::AreNotEqual(hash, thumbnail_cache::hash_prefix(changed));
+            }
+            for (size_t size = 0; size < 40; size++)
+            {
+                Assert::AreNotEqual(thumbnail_cache::hash_prefix({ data.data(), size }), thumbnail_cache::hash_prefix({ data.data(), size + 1 }));
+            }
+        }
+
+        TEST_METHOD (FindsStoredEntries)
+        {
+            const auto options = MakeOptions();
+            std::vector<uint8_t> memory(Index::required_size(options));
+            Index index{ memory, options };
+            Assert::IsTrue(index.was_reset());
+
+            std::vector<uint64_t> dropped;
+            const auto id = index.insert(MakeKey(1), 100, dropped);
+            Assert::AreNotEqual(uint64_t{ 0 }, id);
+            Assert::IsTrue(dropped.empty());
+
+            Assert::AreEqual(id, index.find(MakeKey(1))->id);
+            Assert::IsFalse(index.find(MakeKey(1, 512)).has_value());
+            Assert::IsFalse(index.find(Key{ 1, 1001, 1235, 256, 0 }).has_value());
+            Assert::IsFalse(index.find(Key{ 1, 1001, 1234, 256, 1 }).has_value());
+
+            // replacing an entry gives the blob a new name
+            const auto replaced = index.insert(MakeKey(1), 200, dropped);
+            Assert::AreNotEqual(id, replaced);
+            Assert::IsTrue(std::vector<uint64_t>{ id } == dropped);
+            Assert::AreEqual(uint64_t{ 1 }, index.stats().entries);
+            Assert::AreEqual(uint64_t{ 200 }, index.stats().bytes);
+            Assert::AreEqual(uint64_t{ 0 }, index.stats().evictions);
+        }
+
+        TEST_METHOD (SurvivesReopening)
+        {
+            const auto options = MakeOptions();
+            std::vector<uint8_t> memory(Index::required_size(options));
+            std::vector<uint64_t> dropped;
+            uint64_t id;
+            {
+                Index index{ memory, options };
+                id = index.insert(MakeKey(5), 100, dropped);
+                index.record(true);
+                index.record(false);
+            }
+
+            Index reopened{ memory, options };
+            Assert::IsFalse(reopened.was_reset());
+            Assert::AreEqual(id, reopened.find(MakeKey(5))->id);
+            Assert::AreEqual(uint64_t{ 1 }, reopened.stats().hits);
+            Assert::AreEqual(uint64_t{ 1 }, reopened.stats().misses);
+
+            // another layout or a damaged header starts over
+            Index resized{ memory, MakeOptions(2) };
+            Assert::IsTrue(resized.was_reset());
+            Assert::IsFalse(resized.find(MakeKey(5)).has_value());
+
+            memory[0] ^= 0xff;
+            Index damaged{ memory, MakeOptions(2) };
+            Assert::IsTrue(damaged.was_reset());
+            Assert::AreEqual(uint64_t{ 0 }, damaged.stats().entries);
+
+            Index tooSmall{ { memory.data(), 10 }, options };
+            Assert::IsFalse(tooSmall.valid());
+            Assert::IsFalse(tooSmall.find(MakeKey(5)).has_value());
+        }
+
+        TEST_METHOD (FullSetDropsLeastRecentlyUsed)
+        {
+            // a single set, every key lands in it
+            const auto options = MakeOptions(1, 1'000'000);
+            std::vector<uint8_t> memory(Index::required_size(options));
+            Index index{ memory, options };
+            std::vector<uint64_t> dropped;
+
+            std::vector<uint64_t> ids;
+            for (uint64_t i = 0; i < Index::ways; i++)
+            {
+                ids.push_back(index.insert(MakeKey(i), 10, dropped));
+            }
+            index.find(MakeKey(0));
+
+            index.insert(MakeKey(100), 10, dropped);
+            Assert::IsTrue(std::vector<uint64_t>{ ids[1] } == dropped);
+            Assert::IsTrue(index.find(MakeKey(0)).has_value());
+            Assert::IsFalse(index.find(MakeKey(1)).has_value());
+            Assert::AreEqual(uint64_t{ Index::ways }, index.stats().entries);
+            Assert::AreEqual(uint64_t{ 1 }, index.stats().evictions);
+        }
+
+        TEST_METHOD (StaysWithinTheByteBudget)
+        {
+            const auto options = MakeOptions(64, 10'000);
+            std::vector<uint8_t> memory(Index::required_size(options));
+            Index index{ memory, options };
+            std::vector<uint64_t> dropped;
+
+            for (uint64_t i = 0; i < 100; i++)
+            {
+                index.insert(MakeKey(i), 500, dropped);
+                Assert::IsTrue(index.stats().bytes <= options.max_bytes);
+            }
+
+            // trimmed to 90% at once, the recent entries stay
+            Assert::IsTrue(index.stats().bytes <= 9'500);
+            Assert::IsTrue(index.find(MakeKey(99)).has_value());
+            Assert::IsFalse(index.find(MakeKey(0)).has_value());
+            Assert::AreEqual(size_t{ 100 } - index.stats().entries, dropped.size());
+
+            // too large for the budget
+            Assert::AreEqual(uint64_t{ 0 }, index.insert(MakeKey(1000), 1000, dropped));
+
+            index.trim(0, dropped);
+            Assert::AreEqual(uint64_t{ 0 }, index.stats().entries);
+            Assert::AreEqual(uint64_t{ 0 }, index.stats().bytes);
+            Assert::AreEqual(size_t{ 100 }, dropped.size());
+        }
+
+        TEST_METHOD (RemovesOnlyTheBrokenBlob)
+        {
+            const auto options = MakeOptions();
+            std::vector<uint8_t> memory(Index::required_size(options));
+            Index index{ memory, options };
+            std::vector<uint64_t> dropped;
+
+            const auto old = index.insert(MakeKey(3), 100, dropped);
+            const auto current = index.insert(MakeKey(3), 100, dropped);
+            dropped.clear();
+
+            // a reader of the old blob doesn't drop the new one
+            index.remove(MakeKey(3), old, dropped);
+            Assert::IsTrue(index.find(MakeKey(3)).has_value());
+
+            index.remove(MakeKey(3), current, dropped);
+            Assert::IsFalse(index.find(MakeKey(3)).has_value());
+            Assert::IsTrue(std::vector<uint64_t>{ current } == dropped);
+        }
+
+        TEST_METHOD (RepairRecountsTotals)
+        {
+            const auto options = MakeOptions();
+            std::vector<uint8_t> memory(Index::required_size(options));
+            Index index{ memory, options };
+            std::vector<uint64_t> dropped;
+            index.insert(MakeKey(1), 100, dropped);
+            index.insert(MakeKey(2), 300, dropped);
+
+            // as if a process died halfway through an insert
+            const auto before = index.stats();
+            std::memset(memory.data() + 24, 0, 24);
+            index.repair();
+
+            Assert::AreEqual(before.entries, index.stats().entries);
+            Assert::AreEqual(before.bytes, index.stats().bytes);
+            Assert::IsTrue(index.insert(MakeKey(4), 100, dropped) > 2);
+        }
+
+        TEST_METHOD (QoiRoundTrip)
+        {
+            for (auto [width, height] : { std::pair{ 1u, 1u }, std::pair{ 63u, 1u }, std::pair{ 64u, 64u }, std::pair{ 100u, 37u } })
+            {
+                const auto image = MakeImage(width, height, width);
+                const auto encoded = qoi::encode(image.data(), width, height);
+                Assert::IsFalse(encoded.empty());
+
+                size_t position = 0;
+                auto reader = [&](uint8_t* buffer, size_t size) {
+                    size = (std::min)(size, encoded.size() - position);
+                    std::memcpy(buffer, encoded.data() + position, size);
+                    position += size;
+                    return size;
+                };
+                const auto decoded = qoi::decode(reader, UINT32_MAX);
+                Assert::IsTrue(decoded.has_value());
+                Assert::AreEqual(width, decoded->width);
+                Assert::AreEqual(height, decoded->height);
+                Assert::IsTrue(image == decoded->bgra);
+            }
+
+            Assert::IsTrue(qoi::encode(nullptr, 1, 1).empty());
+            const uint8_t px[4]{};
+            Assert::IsTrue(qoi::encode(px, 0, 1).empty());
+        }
+
+        TEST_METHOD (LookupBenchmark)
+        {
+            // Not a pass/fail benchmark, the numbers are written to the test log
+            const thumbnail_cache::Options options;
+            std::vector<uint8_t> memory(Index::required_size(options));
+            Index index{ memory, options };
+            std::vector<uint64_t> dropped;
+
+            std::vector<uint8_t> prefix(thumbnail_cache::prefix_size, 1);
+            auto start = std::chrono::steady_clock::now();
+            uint64_t hash = 0;
+            for (int i = 0; i < 1000; i++)
+            {
+                prefix[0] = static_cast<uint8_t>(i);
+                hash ^= thumbnail_cache::hash_prefix(prefix);
+            }
+            const auto hashTime = std::chrono::steady_clock::now() - start;
+
+            constexpr uint64_t count = 100'000;
+            start = std::chrono::steady_clock::now();
+            for (uint64_t i = 0; i < count; i++)
+            {
+                index.insert(MakeKey(hash + i), 4000, dropped);
+            }
+            const auto insertTime = std::chrono::steady_clock::now() - start;
+
+            start = std::chrono::steady_clock::now();
+            uint64_t hits = 0;
+            for (uint64_t i = 0; i < count; i++)
+            {
+                hits += index.find(MakeKey(hash + i)).has_value();
+            }
+            const auto findTime = std::chrono::steady_clock::now() - start;
+
+            const auto image = MakeImage(256, 256, 1);
+            start = std::chrono::steady_clock::now();
+            const auto encoded = qoi::encode(image.data(), 256, 256);
+            const auto encodeTime = std::chrono::steady_clock::now() - start;
+
+            using us = std::chrono::duration<double, std::micro>;
+            Logger::WriteMessage(std::format("hash of 64 KB: {:.1f} us, insert: {:.3f} us, find: {:.3f} us, {} of {} kept, {} entries, {} MB",
+                                             us(hashTime).count() / 1000,
+                                             us(insertTime).count() / count,
+                                             us(findTime).count() / count,
+                                             hits,
+                                             count,
+                                             index.stats().entries,
+                                             index.stats().bytes >> 20)
+                                     .c_str());
+            Logger::WriteMessage(std::format("256x256 QOI encode: {:.1f} us, {} KB to {} KB",
+                                             us(encodeTime).count(),
+                                             image.size() >> 10,
+                                             encoded.size() >> 10)
+                                     .c_str());
+        }
+    };
+}
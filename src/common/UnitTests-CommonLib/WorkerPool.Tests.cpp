@@ -0,0 +1,281 @@
+#include "pch.h"
+#include <common/utils/worker_pool.h>
+
+#include <atomic>
+#include <thread>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace std::chrono_literals;
+
+namespace UnitTestsCommonLib
+{
+    namespace
+    {
+        // Stands in for a worker process, the tests decide how it behaves
+        struct FakeWorker
+        {
+            int id = 0;
+            uint64_t memory = 0;
+            std::atomic<bool> running = true;
+            std::atomic<int>* terminatedCount = nullptr;
+
+            bool alive() const
+            {
+                return running;
+            }
+
+            uint64_t memory_usage() const
+            {
+                return memory;
+            }
+
+            void terminate()
+            {
+                if (running.exchange(false) && terminatedCount)
+                {
+                    (*terminatedCount)++;
+                }
+            }
+        };
+
+        using Pool = worker_pool::Pool<FakeWorker>;
+
+        struct Launcher
+        {
+            std::atomic<int> launched = 0;
+            std::atomic<int> terminated = 0;
+            bool fail = false;
+
+            Pool::Launcher get()
+            {
+                return [this](Pool::Clock::time_point) -> std::unique_ptr<FakeWorker> {
+                    if (fail)
+                    {
+                        return nullptr;
+                    }
+                    auto worker = std::make_unique<FakeWorker>();
+                    worker->id = ++launched;
+                    worker->terminatedCount = &terminated;
+                    return worker;
+                };
+            }
+        };
+
+        worker_pool::Options MakeOptions(size_t maxWorkers = 2, uint32_t maxRequests = 100)
+        {
+            worker_pool::Options options;
+            options.max_workers = maxWorkers;
+            options.max_requests = maxRequests;
+            options.max_memory = 1000;
+            options.timeout = 2s;
+            return options;
+        }
+
+        // Runs a request which returns status and records the worker it ran on
+        worker_pool::Status Run(Pool& pool, int& id, worker_pool::Status status = worker_pool::Status::Ok)
+        {
+            return pool.run([&](FakeWorker& worker, Pool::Clock::time_point) {
+                id = worker.id;
+                return status;
+            });
+        }
+    }
+
+    TEST_CLASS (WorkerPoolUnitTests)
+    {
+    public:
+        TEST_METHOD (ReusesWarmWorkers)
+        {
+            Launcher launcher;
+            Pool pool{ MakeOptions(), launcher.get() };
+            for (int i = 0; i < 10; i++)
+            {
+                int id = 0;
+                Assert::IsTrue(Run(pool, id) == worker_pool::Status::Ok);
+                Assert::AreEqual(1, id);
+            }
+
+            Assert::AreEqual(1, launcher.launched.load());
+            Assert::AreEqual(size_t{ 1 }, pool.idle_workers());
+            Assert::AreEqual(uint64_t{ 10 }, pool.stats().requests);
+        }
+
+        TEST_METHOD (RecyclesAfterMaxRequests)
+        {
+            Launcher launcher;
+            Pool pool{ MakeOptions(2, 3), launcher.get() };
+            std::vector<int> ids;
+            for (int i = 0; i < 7; i++)
+            {
+                int id = 0;
+                Run(pool, id);
+                ids.push_back(id);
+            }
+
+            Assert::IsTrue(std::vector<int>{ 1, 1, 1, 2, 2, 2, 3 } == ids);
+            Assert::AreEqual(2, launcher.terminated.load());
+            Assert::AreEqual(uint64_t{ 2 }, pool.stats().recycled);
+        }
+
+        TEST_METHOD (RecyclesOnMemoryThreshold)
+        {
+            Launcher launcher;
+            Pool pool{ MakeOptions(), launcher.get() };
+            int id = 0;
+            pool.run([&](FakeWorker& worker, Pool::Clock::time_point) {
+                worker.memory = 1001;
+                return worker_pool::Status::Ok;
+            });
+            Run(pool, id);
+
+            Assert::AreEqual(2, id);
+            Assert::AreEqual(uint64_t{ 1 }, pool.stats().recycled);
+        }
+
+        TEST_METHOD (TerminatesHungAndBrokenWorkers)
+        {
+            Launcher launcher;
+            Pool pool{ MakeOptions(), launcher.get() };
+            int id = 0;
+            Assert::IsTrue(Run(pool, id, worker_pool::Status::TimedOut) == worker_pool::Status::TimedOut);
+            Assert::AreEqual(1, launcher.terminated.load());
+
+            Assert::IsTrue(Run(pool, id, worker_pool::Status::Broken) == worker_pool::Status::Broken);
+            Assert::AreEqual(2, id);
+            Assert::AreEqual(2, launcher.terminated.load());
+
+            // a throwing request leaves the worker in an unknown state
+            pool.run([](FakeWorker&, Pool::Clock::time_point) -> worker_pool::Status { throw std::runtime_error("failed"); });
+            Assert::AreEqual(3, launcher.terminated.load());
+
+            // failed requests don't say anything about the worker
+            Assert::IsTrue(Run(pool, id, worker_pool::Status::Failed) == worker_pool::Status::Failed);
+            Run(pool, id);
+            Assert::AreEqual(4, id);
+            Assert::AreEqual(uint64_t{ 3 }, pool.stats().terminated);
+            Assert::AreEqual(size_t{ 1 }, pool.idle_workers());
+        }
+
+        TEST_METHOD (ReplacesWorkersWhichExitedWhileIdle)
+        {
+            Launcher launcher;
+            Pool pool{ MakeOptions(), launcher.get() };
+            FakeWorker* first = nullptr;
+            pool.run([&](FakeWorker& worker, Pool::Clock::time_point) {
+                first = &worker;
+                return worker_pool::Status::Ok;
+            });
+
+            first->running = false;
+            int id = 0;
+            Run(pool, id);
+            Assert::AreEqual(2, id);
+        }
+
+        TEST_METHOD (LimitsConcurrentWorkers)
+        {
+            Launcher launcher;
+            Pool pool{ MakeOptions(3), launcher.get() };
+            std::atomic<int> concurrent = 0;
+            std::atomic<int> maxConcurrent = 0;
+
+            std::vector<std::thread> threads;
+            for (int i = 0; i < 8; i++)
+            {
+                threads.emplace_back([&] {
+                    for (int j = 0; j < 5; j++)
+                    {
+                        const auto status = pool.run([&](FakeWorker&, Pool::Clock::time_point) {
+                            const int current = ++concurrent;
+                            int max = maxConcurrent;
+                            while (current > max && !maxConcurrent.compare_exchange_weak(max, current))
+                            {
+                            }
+                            std::this_thread::sleep_for(2ms);
+                            concurrent--;
+                            return worker_pool::Status::Ok;
+                        });
+                        Assert::IsTrue(status == worker_pool::Status::Ok);
+                    }
+                });
+            }
+            for (auto& thread : threads)
+            {
+                thread.join();
+            }
+
+            Assert::IsTrue(maxConcurrent <= 3);
+            Assert::IsTrue(launcher.launched <= 3);
+            Assert::AreEqual(uint64_t{ 40 }, pool.stats().requests);
+        }
+
+        TEST_METHOD (WaitingForAWorkerTimesOut)
+        {
+            Launcher launcher;
+            auto options = MakeOptions(1);
+            options.timeout = 50ms;
+            Pool pool{ options, launcher.get() };
+
+            std::atomic<bool> started = false;
+            std::atomic<bool> done = false;
+            std::thread busy([&] {
+                pool.run([&](FakeWorker&, Pool::Clock::time_point) {
+                    started = true;
+                    while (!done)
+                    {
+                        std::this_thread::sleep_for(1ms);
+                    }
+                    return worker_pool::Status::Ok;
+                });
+            });
+            while (!started)
+            {
+                std::this_thread::sleep_for(1ms);
+            }
+
+            bool called = false;
+            const auto status = pool.run([&](FakeWorker&, Pool::Clock::time_point) {
+                called = true;
+                return worker_pool::Status::Ok;
+            });
+            done = true;
+            busy.join();
+
+            Assert::IsTrue(status == worker_pool::Status::TimedOut);
+            Assert::IsFalse(called);
+            Assert::AreEqual(1, launcher.launched.load());
+        }
+
+        TEST_METHOD (LaunchFailuresDontLeakSlots)
+        {
+            Launcher launcher;
+            launcher.fail = true;
+            Pool pool{ MakeOptions(1), launcher.get() };
+            int id = 0;
+            Assert::IsTrue(Run(pool, id) == worker_pool::Status::Failed);
+            Assert::IsTrue(Run(pool, id) == worker_pool::Status::Failed);
+
+            launcher.fail = false;
+            Assert::IsTrue(Run(pool, id) == worker_pool::Status::Ok);
+        }
+
+        TEST_METHOD (TerminatesIdleWorkersOnDestruction)
+        {
+            Launcher launcher;
+            {
+                Pool pool{ MakeOptions(2), launcher.get() };
+                std::thread other([&] {
+                    pool.run([](FakeWorker&, Pool::Clock::time_point) {
+                        std::this_thread::sleep_for(20ms);
+                        return worker_pool::Status::Ok;
+                    });
+                });
+                int id = 0;
+                Run(pool, id);
+                other.join();
+                Assert::AreEqual(0, launcher.terminated.load());
+            }
+            Assert::AreEqual(launcher.launched.load(), launcher.terminated.load());
+        }
+    };
+}
@@ -1,54 +1,381 @@
 #pragma once
-#include <queue>
-#include <thread>
+#include <algorithm>
+#include <atomic>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
 #include <mutex>
-#include <condition_variable>
+#include <optional>
 #include <string>
+#include <vector>
 
+// What queue_message does when the queue is full
+enum class OverflowPolicy
+{
+    // Wait until the consumer makes room
+    Block,
+    // Drop the oldest queued message
+    DropOldest,
+    // Keep the message aside, replacing an older kept message with the same key. The replacing message
+    // goes after the other kept ones. At most as many messages as the capacity are kept aside, the oldest
+    // is dropped beyond that.
+    Coalesce,
+};
+
+// Bounded multi-producer single-consumer queue. Producers and the consumer don't take locks,
+// except for Coalesce after the queue overflowed. Messages are moved in and out, never copied.
+// After interrupt() no new messages are accepted, but the consumer still gets the queued ones.
+// This header has no Windows dependencies.
+template<typename T = std::wstring>
 class AsyncMessageQueue
 {
+public:
+    // Whether two messages have the same key, so that the newer one replaces the older one when the queue
+    // overflows with OverflowPolicy::Coalesce. Equal messages have the same key by default.
+    using same_key_function = std::function<bool(const T&, const T&)>;
+
+    explicit AsyncMessageQueue(size_t capacity = 1024, OverflowPolicy policy = OverflowPolicy::Block, same_key_function key = nullptr) :
+        policy(policy), same_key(std::move(key))
+    {
+        if constexpr (std::equality_comparable<T>)
+        {
+            if (!same_key)
+            {
+                same_key = std::equal_to<T>{};
+            }
+        }
+
+        size_t size = 2;
+        while (size < capacity)
+        {
+            size *= 2;
+        }
+
+        cells = std::make_unique<Cell[]>(size);
+        mask = size - 1;
+        for (size_t i = 0; i < size; i++)
+        {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    AsyncMessageQueue(const AsyncMessageQueue&) = delete;
+    AsyncMessageQueue& operator=(const AsyncMessageQueue&) = delete;
+
+    // Returns false if the message was rejected because the queue was interrupted
+    bool queue_message(T message)
+    {
+        while (true)
+        {
+            if (interrupted.load(std::memory_order_acquire))
+            {
+                return false;
+            }
+
+            // Coalesced messages are newer than the ones in the ring, so the ring is bypassed until the consumer takes them
+            if (policy == OverflowPolicy::Coalesce && has_overflow.load(std::memory_order_acquire))
+            {
+                queue_overflow(std::move(message));
+                return true;
+            }
+
+            if (try_push(message))
+            {
+                notify_consumer();
+                return true;
+            }
+
+            switch (policy)
+            {
+            case OverflowPolicy::Block:
+                wait_for_space();
+                break;
+            case OverflowPolicy::DropOldest:
+                if (try_pop(nullptr))
+                {
+                    dropped.fetch_add(1, std::memory_order_relaxed);
+                }
+                break;
+            case OverflowPolicy::Coalesce:
+                queue_overflow(std::move(message));
+                return true;
+            }
+        }
+    }
+
+    // Waits for a message. Returns nullopt once the queue is interrupted and empty.
+    std::optional<T> pop_message()
+    {
+        std::optional<T> message;
+        wait_for_messages([&] {
+            T value;
+            if (try_take(value))
+            {
+                message.emplace(std::move(value));
+                return true;
+            }
+            return false;
+        });
+        return message;
+    }
+
+    // Waits for a message, then takes everything queued by then, up to max_count messages.
+    // Returns the number of messages appended, 0 once the queue is interrupted and empty.
+    size_t drain(std::vector<T>& messages, size_t max_count)
+    {
+        size_t count = 0;
+        wait_for_messages([&] {
+            count = try_drain(messages, max_count);
+            return count > 0;
+        });
+        return count;
+    }
+
+    // Takes the queued messages without waiting, up to max_count messages
+    size_t try_drain(std::vector<T>& messages, size_t max_count)
+    {
+        size_t count = 0;
+        T value;
+        while (count < max_count && try_take(value))
+        {
+            messages.push_back(std::move(value));
+            count++;
+        }
+        return count;
+    }
+
+    void interrupt()
+    {
+        interrupted.store(true, std::memory_order_release);
+        items_signal.fetch_add(1, std::memory_order_seq_cst);
+        items_signal.notify_all();
+        space_signal.fetch_add(1, std::memory_order_seq_cst);
+        space_signal.notify_all();
+    }
+
+    bool is_interrupted() const
+    {
+        return interrupted.load(std::memory_order_acquire);
+    }
+
+    // Messages dropped by OverflowPolicy::DropOldest, or replaced or dropped by OverflowPolicy::Coalesce
+    size_t dropped_count() const
+    {
+        return dropped.load(std::memory_order_relaxed);
+    }
+
 private:
-    std::mutex queue_mutex;
-    std::queue<std::wstring> message_queue;
-    std::condition_variable message_ready;
-    bool interrupted = false;
+    struct Cell
+    {
+        std::atomic<size_t> sequence;
+        std::optional<T> value;
+    };
+
+    // Ring with a sequence number per cell, see https://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue
+    // It allows several consumers, which lets producers drop the oldest message.
+    bool try_push(T& message)
+    {
+        size_t pos = enqueue_pos.load(std::memory_order_relaxed);
+        Cell* cell;
+        while (true)
+        {
+            cell = &cells[pos & mask];
+            const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+            if (diff == 0)
+            {
+                if (enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (diff < 0)
+            {
+                return false;
+            }
+            else
+            {
+                pos = enqueue_pos.load(std::memory_order_relaxed);
+            }
+        }
 
-    //Disable copy
-    AsyncMessageQueue(const AsyncMessageQueue&);
-    AsyncMessageQueue& operator=(const AsyncMessageQueue&);
+        cell->value.emplace(std::move(message));
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
 
-public:
-    AsyncMessageQueue()
+    bool try_pop(T* message)
+    {
+        size_t pos = dequeue_pos.load(std::memory_order_relaxed);
+        Cell* cell;
+        while (true)
+        {
+            cell = &cells[pos & mask];
+            const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1);
+            if (diff == 0)
+            {
+                if (dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (diff < 0)
+            {
+                return false;
+            }
+            else
+            {
+                pos = dequeue_pos.load(std::memory_order_relaxed);
+            }
+        }
+
+        if (message)
+        {
+            *message = std::move(*cell->value);
+        }
+        cell->value.reset();
+        cell->sequence.store(pos + mask + 1, std::memory_order_release);
+        notify_producers();
+        return true;
+    }
+
+    // The ring first, then the messages kept aside when it overflowed
+    bool try_take(T& message)
+    {
+        if (try_pop(&message))
+        {
+            return true;
+        }
+
+        if (!has_overflow.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+
+        std::unique_lock lock(overflow_mutex);
+        if (overflow.empty())
+        {
+            return false;
+        }
+
+        message = std::move(overflow.front());
+        overflow.pop_front();
+        if (overflow.empty())
+        {
+            has_overflow.store(false, std::memory_order_release);
+        }
+        return true;
+    }
+
+    void queue_overflow(T message)
     {
+        {
+            std::unique_lock lock(overflow_mutex);
+            auto it = same_key ? std::find_if(overflow.begin(), overflow.end(), [&](const T& item) { return same_key(item, message); }) : overflow.end();
+            if (it != overflow.end())
+            {
+                overflow.erase(it);
+                dropped.fetch_add(1, std::memory_order_relaxed);
+            }
+            else if (overflow.size() > mask)
+            {
+                overflow.pop_front();
+                dropped.fetch_add(1, std::memory_order_relaxed);
+            }
+            overflow.push_back(std::move(message));
+            has_overflow.store(true, std::memory_order_release);
+        }
+        notify_consumer();
     }
-    void queue_message(std::wstring message)
+
+    // Runs take until it succeeds, sleeping while the queue is empty
+    template<typename Take>
+    void wait_for_messages(Take take)
     {
-        this->queue_mutex.lock();
-        this->message_queue.push(message);
-        this->queue_mutex.unlock();
-        this->message_ready.notify_one();
+        while (true)
+        {
+            const uint32_t seen = items_signal.load(std::memory_order_seq_cst);
+            if (take())
+            {
+                return;
+            }
+
+            if (interrupted.load(std::memory_order_acquire))
+            {
+                // a producer may have pushed right before the interruption
+                take();
+                return;
+            }
+
+            consumer_waiting.store(true, std::memory_order_seq_cst);
+            if (take())
+            {
+                consumer_waiting.store(false, std::memory_order_relaxed);
+                return;
+            }
+            items_signal.wait(seen, std::memory_order_seq_cst);
+            consumer_waiting.store(false, std::memory_order_relaxed);
+        }
     }
-    std::wstring pop_message()
+
+    void wait_for_space()
     {
-        std::unique_lock<std::mutex> lock(this->queue_mutex);
-        while (message_queue.empty() && !this->interrupted)
+        const uint32_t seen = space_signal.load(std::memory_order_seq_cst);
+        producers_waiting.fetch_add(1, std::memory_order_seq_cst);
+
+        // the consumer may have made room before it saw this producer waiting
+        const size_t pos = enqueue_pos.load(std::memory_order_relaxed);
+        const size_t sequence = cells[pos & mask].sequence.load(std::memory_order_acquire);
+        if (static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos) >= 0 || interrupted.load(std::memory_order_acquire))
         {
-            this->message_ready.wait(lock);
+            producers_waiting.fetch_sub(1, std::memory_order_relaxed);
+            return;
         }
-        if (this->interrupted)
+
+        space_signal.wait(seen, std::memory_order_seq_cst);
+        producers_waiting.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    void notify_consumer()
+    {
+        items_signal.fetch_add(1, std::memory_order_seq_cst);
+        if (consumer_waiting.load(std::memory_order_seq_cst))
         {
-            //Just returns a empty string if the queue was interrupted.
-            return std::wstring(L"");
+            items_signal.notify_one();
         }
-        std::wstring message = this->message_queue.front();
-        this->message_queue.pop();
-        return message;
     }
-    void interrupt()
+
+    void notify_producers()
     {
-        this->queue_mutex.lock();
-        this->interrupted = true;
-        this->queue_mutex.unlock();
-        this->message_ready.notify_all();
+        space_signal.fetch_add(1, std::memory_order_seq_cst);
+        if (producers_waiting.load(std::memory_order_seq_cst) > 0)
+        {
+            space_signal.notify_all();
+        }
     }
+
+    const OverflowPolicy policy;
+    same_key_function same_key;
+
+    std::unique_ptr<Cell[]> cells;
+    size_t mask = 0;
+
+    alignas(64) std::atomic<size_t> enqueue_pos{ 0 };
+    alignas(64) std::atomic<size_t> dequeue_pos{ 0 };
+
+    alignas(64) std::atomic<uint32_t> items_signal{ 0 };
+    std::atomic<bool> consumer_waiting{ false };
+    std::atomic<uint32_t> space_signal{ 0 };
+    std::atomic<uint32_t> producers_waiting{ 0 };
+
+    std::atomic<bool> interrupted{ false };
+    std::atomic<size_t> dropped{ 0 };
+
+    std::mutex overflow_mutex;
+    std::deque<T> overflow;
+    std::atomic<bool> has_overflow{ false };
 };
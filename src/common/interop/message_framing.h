@@ -0,0 +1,296 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Length-prefixed frames for sending messages over a byte stream, like a named pipe or a socket.
+// Every frame starts with an 8 byte header:
+//   uint16 magic, uint8 version, uint8 payload type, uint32 payload length (all little-endian)
+// followed by the payload. This header has no Windows dependencies.
+namespace MessageFraming
+{
+    enum class PayloadType : uint8_t
+    {
+        Text = 1, // UTF-16LE, without a terminating null
+        Binary = 2,
+    };
+
+    constexpr uint16_t FrameMagic = 0x5450; // "PT"
+    constexpr uint8_t FrameVersion = 1;
+    constexpr size_t FrameHeaderSize = 8;
+
+    // Larger frames are treated as a corrupt stream
+    constexpr uint32_t MaxPayloadSize = 64 * 1024 * 1024;
+
+    // Owns the payload of one message. Move-only, so a message is never copied on its way
+    // from the sender through the queues and the pipe to the receiver.
+    class MessageBuffer
+    {
+    public:
+        MessageBuffer() = default;
+
+        MessageBuffer(PayloadType type, std::vector<uint8_t> payload) :
+            m_type(type), m_payload(std::move(payload))
+        {
+        }
+
+        MessageBuffer(const MessageBuffer&) = delete;
+        MessageBuffer& operator=(const MessageBuffer&) = delete;
+        MessageBuffer(MessageBuffer&&) noexcept = default;
+        MessageBuffer& operator=(MessageBuffer&&) noexcept = default;
+
+        static MessageBuffer from_text(std::wstring_view text)
+        {
+            std::vector<uint8_t> payload;
+            payload.reserve(text.size() * 2);
+            auto append_unit = [&](uint32_t unit) {
+                payload.push_back(static_cast<uint8_t>(unit & 0xFF));
+                payload.push_back(static_cast<uint8_t>((unit >> 8) & 0xFF));
+            };
+
+            for (wchar_t ch : text)
+            {
+                const auto code_point = static_cast<uint32_t>(ch);
+                if (code_point > 0xFFFF)
+                {
+                    // wchar_t holds UTF-32 on non-Windows platforms
+                    append_unit(0xD800 + ((code_point - 0x10000) >> 10));
+                    append_unit(0xDC00 + ((code_point - 0x10000) & 0x3FF));
+                }
+                else
+                {
+                    append_unit(code_point);
+                }
+            }
+
+            return MessageBuffer(PayloadType::Text, std::move(payload));
+        }
+
+        std::wstring to_text() const
+        {
+            std::wstring text;
+            text.reserve(m_payload.size() / 2);
+            for (size_t i = 0; i + 1 < m_payload.size(); i += 2)
+            {
+                uint32_t unit = m_payload[i] | (m_payload[i + 1] << 8);
+                if constexpr (sizeof(wchar_t) > 2)
+                {
+                    if (unit >= 0xD800 && unit < 0xDC00 && i + 3 < m_payload.size())
+                    {
+                        uint32_t low = m_payload[i + 2] | (m_payload[i + 3] << 8);
+                        if (low >= 0xDC00 && low < 0xE000)
+                        {
+                            unit = 0x10000 + ((unit - 0xD800) << 10) + (low - 0xDC00);
+                            i += 2;
+                        }
+                    }
+                }
+
+                text.push_back(static_cast<wchar_t>(unit));
+            }
+
+            return text;
+        }
+
+        PayloadType type() const noexcept
+        {
+            return m_type;
+        }
+
+        const std::vector<uint8_t>& payload() const noexcept
+        {
+            return m_payload;
+        }
+
+        std::vector<uint8_t> release() noexcept
+        {
+            return std::move(m_payload);
+        }
+
+    private:
+        PayloadType m_type = PayloadType::Text;
+        std::vector<uint8_t> m_payload;
+    };
+
+    // Appends the frame of the message to out. A payload larger than MaxPayloadSize isn't framed, since the
+    // receiver would take it for a corrupt stream; returns false and leaves out unchanged then.
+    inline bool encode(const MessageBuffer& message, std::vector<uint8_t>& out)
+    {
+        if (message.payload().size() > MaxPayloadSize)
+        {
+            return false;
+        }
+
+        const auto size = static_cast<uint32_t>(message.payload().size());
+        const uint8_t header[FrameHeaderSize] = {
+            static_cast<uint8_t>(FrameMagic & 0xFF),
+            static_cast<uint8_t>(FrameMagic >> 8),
+            FrameVersion,
+            static_cast<uint8_t>(message.type()),
+            static_cast<uint8_t>(size & 0xFF),
+            static_cast<uint8_t>((size >> 8) & 0xFF),
+            static_cast<uint8_t>((size >> 16) & 0xFF),
+            static_cast<uint8_t>((size >> 24) & 0xFF),
+        };
+
+        out.insert(out.end(), std::begin(header), std::end(header));
+        out.insert(out.end(), message.payload().begin(), message.payload().end());
+        return true;
+    }
+
+    // Splits received bytes into messages, regardless of how the bytes were chunked by the transport
+    class FrameDecoder
+    {
+    public:
+        // Returns false once the stream turned out to be corrupt, the connection should be dropped then
+        bool feed(const uint8_t* data, size_t size)
+        {
+            if (m_failed)
+            {
+                return false;
+            }
+
+            // drop the consumed bytes before growing the buffer
+            if (m_offset > 0 && m_offset == m_buffer.size())
+            {
+                m_buffer.clear();
+                m_offset = 0;
+            }
+            else if (m_offset > 0 && m_offset >= m_buffer.size() / 2)
+            {
+                m_buffer.erase(m_buffer.begin(), m_buffer.begin() + m_offset);
+                m_offset = 0;
+            }
+
+            m_buffer.insert(m_buffer.end(), data, data + size);
+            return true;
+        }
+
+        // Returns the next complete message, if any
+        std::optional<MessageBuffer> next()
+        {
+            if (m_failed || m_buffer.size() - m_offset < FrameHeaderSize)
+            {
+                return std::nullopt;
+            }
+
+            const uint8_t* header = m_buffer.data() + m_offset;
+            const uint16_t magic = static_cast<uint16_t>(header[0] | (header[1] << 8));
+            const uint8_t version = header[2];
+            const uint8_t type = header[3];
+            const uint32_t size = header[4] | (header[5] << 8) | (header[6] << 16) | (static_cast<uint32_t>(header[7]) << 24);
+            if (magic != FrameMagic ||
+                version != FrameVersion ||
+                (type != static_cast<uint8_t>(PayloadType::Text) && type != static_cast<uint8_t>(PayloadType::Binary)) ||
+                size > MaxPayloadSize)
+            {
+                m_failed = true;
+                return std::nullopt;
+            }
+
+            if (m_buffer.size() - m_offset - FrameHeaderSize < size)
+            {
+                return std::nullopt;
+            }
+
+            auto payload_begin = m_buffer.begin() + m_offset + FrameHeaderSize;
+            std::vector<uint8_t> payload(payload_begin, payload_begin + size);
+            m_offset += FrameHeaderSize + size;
+            return MessageBuffer(static_cast<PayloadType>(type), std::move(payload));
+        }
+
+        bool failed() const noexcept
+        {
+            return m_failed;
+        }
+
+    private:
+        std::vector<uint8_t> m_buffer;
+        size_t m_offset = 0;
+        bool m_failed = false;
+    };
+
+    // Returns the number of bytes read, 0 at the end of the stream, or a negative value on error
+    using ReadFunction = std::function<ptrdiff_t(uint8_t* buffer, size_t size)>;
+
+    // Writes all the bytes, returns false on error
+    using WriteFunction = std::function<bool(const uint8_t* data, size_t size)>;
+
+    class FrameWriter
+    {
+    public:
+        explicit FrameWriter(WriteFunction write) :
+            m_write(std::move(write))
+        {
+        }
+
+        bool write(const MessageBuffer& message)
+        {
+            m_buffer.clear();
+            return encode(message, m_buffer) && m_write(m_buffer.data(), m_buffer.size());
+        }
+
+        // Sends all the messages with a single write. Messages too large to be framed are left out,
+        // and false is returned then.
+        bool write(const std::vector<MessageBuffer>& messages)
+        {
+            m_buffer.clear();
+            bool encoded = true;
+            for (const auto& message : messages)
+            {
+                encoded = encode(message, m_buffer) && encoded;
+            }
+
+            const bool written = m_buffer.empty() || m_write(m_buffer.data(), m_buffer.size());
+            return written && encoded;
+        }
+
+    private:
+        WriteFunction m_write;
+        std::vector<uint8_t> m_buffer;
+    };
+
+    class FrameReader
+    {
+    public:
+        explicit FrameReader(ReadFunction read, size_t block_size = 4096) :
+            m_read(std::move(read)), m_block(block_size)
+        {
+        }
+
+        // Blocks until a message arrives. Returns nullopt at the end of the stream or on error.
+        std::optional<MessageBuffer> read()
+        {
+            while (true)
+            {
+                if (auto message = m_decoder.next())
+                {
+                    return message;
+                }
+
+                if (m_decoder.failed())
+                {
+                    return std::nullopt;
+                }
+
+                const ptrdiff_t bytes_read = m_read(m_block.data(), m_block.size());
+                if (bytes_read <= 0)
+                {
+                    return std::nullopt;
+                }
+
+                m_decoder.feed(m_block.data(), static_cast<size_t>(bytes_read));
+            }
+        }
+
+    private:
+        ReadFunction m_read;
+        std::vector<uint8_t> m_block;
+        FrameDecoder m_decoder;
+    };
+}
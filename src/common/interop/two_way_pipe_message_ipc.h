@@ -1,15 +1,22 @@
 #pragma once
+#include <cstdint>
 #include <functional>
+#include <string>
+#include <vector>
 class TwoWayPipeMessageIPC
 {
 public:
     typedef std::function<void(const std::wstring&)>callback_function;
+    typedef std::function<void(std::vector<uint8_t>)> binary_callback_function;
     TwoWayPipeMessageIPC(
         std::wstring _input_pipe_name,
         std::wstring _output_pipe_name,
-        callback_function p_func);
+        callback_function p_func,
+        binary_callback_function p_binary_func = nullptr);
     ~TwoWayPipeMessageIPC();
     void send(std::wstring msg);
+    // Sends the payload as is, the receiver gets it in its binary callback
+    void send_binary(std::vector<uint8_t> payload);
     void start(HANDLE _restricted_pipe_token);
     void end();
 
@@ -1,6 +1,7 @@
 #pragma once
 #include <Windows.h>
 #include "async_message_queue.h"
+#include "message_framing.h"
 #include <WinSafer.h>
 #include <accctrl.h>
 #include <aclapi.h>
@@ -11,26 +12,40 @@ class TwoWayPipeMessageIPC::TwoWayPipeMessageIPCImpl
 {
 public:
     void send(std::wstring msg);
-    TwoWayPipeMessageIPCImpl(std::wstring _input_pipe_name, std::wstring _output_pipe_name, callback_function p_func);
+    void send_binary(std::vector<uint8_t> payload);
+    TwoWayPipeMessageIPCImpl(std::wstring _input_pipe_name, std::wstring _output_pipe_name, callback_function p_func, binary_callback_function p_binary_func);
     void start(HANDLE _restricted_pipe_token);
     void end();
 
 private:
-    AsyncMessageQueue input_queue;
-    AsyncMessageQueue output_queue;
+    AsyncMessageQueue<MessageFraming::MessageBuffer> input_queue;
+    AsyncMessageQueue<MessageFraming::MessageBuffer> output_queue;
     std::wstring output_pipe_name;
     std::wstring input_pipe_name;
     std::thread input_queue_thread;
     std::thread output_queue_thread;
     std::thread input_pipe_thread;
-    std::mutex pipe_connect_handle_mutex; // For manipulating the current_connect_pipe
+    std::mutex pipe_connect_handle_mutex; // For manipulating the current_connect_pipe and the connections
     std::wstring outgoing_message; // Store the updated json settings.
 
+    // Connections stay open until the peer disconnects, each one is read by its own thread
+    struct Connection
+    {
+        HANDLE pipe_handle;
+        std::thread thread;
+        bool finished = false;
+    };
+    std::list<Connection> connections;
+
     HANDLE current_connect_pipe_handle = NULL;
+    HANDLE output_pipe_handle = INVALID_HANDLE_VALUE; // Used only by the output queue thread
     bool closed = false;
     TwoWayPipeMessageIPC::callback_function dispatch_inc_message_function;
+    TwoWayPipeMessageIPC::binary_callback_function dispatch_inc_binary_message_function;
 
-    void send_pipe_message(std::wstring message);
+    bool connect_output_pipe();
+    void close_output_pipe();
+    bool send_pipe_messages(const std::vector<uint8_t>& frames);
     void consume_output_queue_thread();
     BOOL GetLogonSID(HANDLE hToken, PSID* ppsid);
     VOID FreeLogonSID(PSID* ppsid);
@@ -38,5 +53,6 @@ private:
     HANDLE create_medium_integrity_token();
     void handle_pipe_connection(HANDLE input_pipe_handle);
     void start_named_pipe_server(HANDLE token);
+    void cleanup_finished_connections();
     void consume_input_queue_thread();
 };
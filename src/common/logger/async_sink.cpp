@@ -0,0 +1,343 @@
+#include "pch.h"
+#include "async_sink.h"
+
+#include <algorithm>
+#include <chrono>
+#include <spdlog/details/log_msg.h>
+#include <spdlog/formatter.h>
+
+using spdlog::details::log_msg;
+
+namespace
+{
+    // The writer also wakes up on its own, so records of quiet threads don't wait for long
+    constexpr auto writerInterval = std::chrono::milliseconds(200);
+
+    // How long a crashing thread waits for the writer to finish its batch
+    constexpr auto crashFlushTimeout = std::chrono::seconds(1);
+
+    std::atomic<uint64_t> nextSinkId = 1;
+}
+
+struct AsyncSink::Record
+{
+    spdlog::log_clock::time_point time;
+    spdlog::level::level_enum level = spdlog::level::trace;
+    size_t threadId = 0;
+    std::string loggerName;
+    std::string payload;
+};
+
+// Ring of records written by one logging thread and read by the thread holding m_drainMutex.
+// The strings of a slot keep their capacity, so logging doesn't allocate once the slots warmed up.
+class AsyncSink::ThreadBuffer
+{
+public:
+    explicit ThreadBuffer(size_t size)
+    {
+        size_t capacity = 2;
+        while (capacity < size)
+        {
+            capacity *= 2;
+        }
+
+        m_records.resize(capacity);
+        m_mask = capacity - 1;
+    }
+
+    bool TryPush(const log_msg& msg)
+    {
+        const size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_head.load(std::memory_order_acquire) > m_mask)
+        {
+            return false;
+        }
+
+        auto& record = m_records[tail & m_mask];
+        record.time = msg.time;
+        record.level = msg.level;
+        record.threadId = msg.thread_id;
+        record.loggerName.assign(msg.logger_name.data(), msg.logger_name.size());
+        record.payload.assign(msg.payload.data(), msg.payload.size());
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t Size() const
+    {
+        return m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire);
+    }
+
+    size_t Capacity() const
+    {
+        return m_mask + 1;
+    }
+
+    size_t Head() const
+    {
+        return m_head.load(std::memory_order_relaxed);
+    }
+
+    size_t Tail() const
+    {
+        return m_tail.load(std::memory_order_acquire);
+    }
+
+    const Record& At(size_t pos) const
+    {
+        return m_records[pos & m_mask];
+    }
+
+    // The records before pos were written, their slots can be reused
+    void Release(size_t pos)
+    {
+        m_head.store(pos, std::memory_order_release);
+    }
+
+    std::atomic<size_t> dropped = 0;
+    std::atomic<bool> orphaned = false;
+
+private:
+    std::vector<Record> m_records;
+    size_t m_mask = 0;
+    alignas(64) std::atomic<size_t> m_head = 0;
+    alignas(64) std::atomic<size_t> m_tail = 0;
+};
+
+AsyncSink::AsyncSink(std::vector<spdlog::sink_ptr> sinks, AsyncLogOverflowPolicy policy, size_t bufferSize) :
+    m_id(nextSinkId++),
+    m_policy(policy),
+    m_bufferSize(bufferSize),
+    m_sinks(std::move(sinks))
+{
+    m_writerThread = std::thread(&AsyncSink::WriterThread, this);
+}
+
+AsyncSink::~AsyncSink()
+{
+    {
+        std::lock_guard lock(m_wakeMutex);
+        m_stopping = true;
+    }
+    m_wakeCondition.notify_one();
+
+    if (m_writerThread.joinable())
+    {
+        m_writerThread.join();
+    }
+}
+
+void AsyncSink::log(const log_msg& msg)
+{
+    auto& buffer = GetThreadBuffer();
+    while (!buffer.TryPush(msg))
+    {
+        // the writer can't wait for itself
+        if (m_policy == AsyncLogOverflowPolicy::Drop || std::this_thread::get_id() == m_writerThreadId.load())
+        {
+            buffer.dropped++;
+            Wake();
+            return;
+        }
+
+        Wake();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    // Warnings and errors are written right away, other records once enough of them are buffered
+    if (msg.level >= spdlog::level::warn || buffer.Size() == buffer.Capacity() / 2)
+    {
+        Wake();
+    }
+}
+
+void AsyncSink::flush()
+{
+    Wake();
+}
+
+void AsyncSink::set_pattern(const std::string& pattern)
+{
+    for (auto& sink : m_sinks)
+    {
+        sink->set_pattern(pattern);
+    }
+}
+
+void AsyncSink::set_formatter(std::unique_ptr<spdlog::formatter> sinkFormatter)
+{
+    for (auto& sink : m_sinks)
+    {
+        sink->set_formatter(sinkFormatter->clone());
+    }
+}
+
+void AsyncSink::flush_sync()
+{
+    std::lock_guard lock(m_drainMutex);
+    Drain();
+}
+
+void AsyncSink::flush_on_crash()
+{
+    // the crash happened while this thread was writing, the records can't be written safely anymore
+    if (m_drainOwner.load() == std::this_thread::get_id())
+    {
+        return;
+    }
+
+    if (m_drainMutex.try_lock_for(crashFlushTimeout))
+    {
+        Drain();
+        m_drainMutex.unlock();
+    }
+}
+
+AsyncSink::ThreadBuffer& AsyncSink::GetThreadBuffer()
+{
+    // Buffers of the sinks this thread logged to. The writer removes a buffer after its thread
+    // exited and its records were written.
+    struct ThreadBuffers
+    {
+        std::vector<std::pair<uint64_t, std::shared_ptr<ThreadBuffer>>> items;
+
+        ~ThreadBuffers()
+        {
+            for (auto& item : items)
+            {
+                item.second->orphaned = true;
+            }
+        }
+    };
+    thread_local ThreadBuffers threadBuffers;
+
+    for (auto& [id, buffer] : threadBuffers.items)
+    {
+        if (id == m_id)
+        {
+            return *buffer;
+        }
+    }
+
+    auto buffer = std::make_shared<ThreadBuffer>(m_bufferSize);
+    {
+        std::lock_guard lock(m_buffersMutex);
+        m_buffers.push_back(buffer);
+    }
+    threadBuffers.items.emplace_back(m_id, buffer);
+    return *buffer;
+}
+
+void AsyncSink::Wake()
+{
+    {
+        std::lock_guard lock(m_wakeMutex);
+        m_wakeRequested = true;
+    }
+    m_wakeCondition.notify_one();
+}
+
+void AsyncSink::WriterThread()
+{
+    m_writerThreadId = std::this_thread::get_id();
+    while (true)
+    {
+        bool stopping;
+        {
+            std::unique_lock lock(m_wakeMutex);
+            m_wakeCondition.wait_for(lock, writerInterval, [this] { return m_wakeRequested || m_stopping; });
+            m_wakeRequested = false;
+            stopping = m_stopping;
+        }
+
+        {
+            std::lock_guard lock(m_drainMutex);
+            Drain();
+        }
+
+        if (stopping)
+        {
+            break;
+        }
+    }
+}
+
+void AsyncSink::Drain()
+{
+    m_drainOwner = std::this_thread::get_id();
+
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    {
+        std::lock_guard lock(m_buffersMutex);
+        buffers = m_buffers;
+    }
+
+    // Records of all the threads are written in the order they were logged
+    struct Pending
+    {
+        ThreadBuffer* buffer;
+        size_t pos;
+    };
+    std::vector<Pending> pending;
+    std::vector<size_t> tails(buffers.size());
+    for (size_t i = 0; i < buffers.size(); i++)
+    {
+        tails[i] = buffers[i]->Tail();
+        for (size_t pos = buffers[i]->Head(); pos != tails[i]; pos++)
+        {
+            pending.push_back({ buffers[i].get(), pos });
+        }
+    }
+
+    std::stable_sort(pending.begin(), pending.end(), [](const Pending& a, const Pending& b) {
+        return a.buffer->At(a.pos).time < b.buffer->At(b.pos).time;
+    });
+
+    auto write = [this](const log_msg& msg) {
+        for (auto& sink : m_sinks)
+        {
+            if (sink->should_log(msg.level))
+            {
+                sink->log(msg);
+            }
+        }
+    };
+
+    for (const auto& item : pending)
+    {
+        const auto& record = item.buffer->At(item.pos);
+        log_msg msg(record.time, spdlog::source_loc{}, record.loggerName, record.level, record.payload);
+        msg.thread_id = record.threadId;
+        write(msg);
+    }
+
+    bool written = !pending.empty();
+    for (size_t i = 0; i < buffers.size(); i++)
+    {
+        buffers[i]->Release(tails[i]);
+
+        if (const size_t dropped = buffers[i]->dropped.exchange(0); dropped > 0)
+        {
+            const std::string text = std::to_string(dropped) + " log messages were dropped, the log buffer was full";
+            write(log_msg(spdlog::source_loc{}, spdlog::string_view_t{}, spdlog::level::warn, text));
+            written = true;
+        }
+    }
+
+    {
+        std::lock_guard lock(m_buffersMutex);
+        std::erase_if(m_buffers, [](const std::shared_ptr<ThreadBuffer>& buffer) {
+            return buffer->orphaned && buffer->Size() == 0;
+        });
+    }
+
+    if (written)
+    {
+        for (auto& sink : m_sinks)
+        {
+            sink->flush();
+        }
+    }
+
+    m_drainOwner = std::thread::id{};
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <spdlog/sinks/sink.h>
+
+// What a logging thread does when its buffer is full
+enum class AsyncLogOverflowPolicy
+{
+    // Wait for the writer thread, never loses messages
+    Block,
+    // Drop the message, the writer logs how many were dropped
+    Drop,
+};
+
+// Sink that moves writing to a background thread. Every logging thread gets its own buffer of records,
+// so logging takes no lock and does no I/O. The message is formatted by the logger on the calling
+// thread, the pattern (time, thread, level) is applied by the writer thread.
+// The writer writes the records of all threads in batches and flushes the wrapped sinks after each batch.
+// Only for loggers of executables: the writer thread is joined on destruction, which can't be done
+// while a DLL is being unloaded.
+class AsyncSink : public spdlog::sinks::sink
+{
+public:
+    AsyncSink(std::vector<spdlog::sink_ptr> sinks, AsyncLogOverflowPolicy policy, size_t bufferSize = 4096);
+    ~AsyncSink() override;
+
+    void log(const spdlog::details::log_msg& msg) override;
+
+    // Asks the writer thread to write out the buffered records without waiting for it
+    void flush() override;
+
+    void set_pattern(const std::string& pattern) override;
+    void set_formatter(std::unique_ptr<spdlog::formatter> sinkFormatter) override;
+
+    // Writes out the records buffered so far before returning
+    void flush_sync();
+
+    // Same as flush_sync, but doesn't wait forever for the writer, which may be the crashed thread
+    void flush_on_crash();
+
+private:
+    struct Record;
+    class ThreadBuffer;
+
+    ThreadBuffer& GetThreadBuffer();
+    void Wake();
+    void WriterThread();
+
+    // Writes out the records of all the buffers. The caller holds m_drainMutex.
+    void Drain();
+
+    const uint64_t m_id;
+    const AsyncLogOverflowPolicy m_policy;
+    const size_t m_bufferSize;
+    std::vector<spdlog::sink_ptr> m_sinks;
+
+    std::mutex m_buffersMutex;
+    std::vector<std::shared_ptr<ThreadBuffer>> m_buffers;
+
+    std::timed_mutex m_drainMutex;
+    std::atomic<std::thread::id> m_drainOwner;
+
+    std::mutex m_wakeMutex;
+    std::condition_variable m_wakeCondition;
+    bool m_wakeRequested = false;
+    bool m_stopping = false;
+
+    std::atomic<std::thread::id> m_writerThreadId;
+    std::thread m_writerThread;
+};
@@ -0,0 +1,467 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <variant>
+#include <vector>
+
+// Compact trace file format. A record stores the id of its format string and the raw arguments,
+// the text is only built when the file is decoded. The format strings are written to the file
+// the first time they're used, so a file can be decoded without the binaries that wrote it.
+// This header has no Windows or spdlog dependencies, the decoder tool includes it too.
+//
+// File: header, then records. Numbers are little endian, strings are UTF-16 with a uint32 length in characters.
+//   header: "PTBT", uint16 version, uint32 process id
+//   format: uint8 RecordKind::Format, uint32 format id, string
+//   event:  uint8 RecordKind::Event, int64 time (microseconds since the epoch), uint32 thread id, uint8 level,
+//           uint32 format id, uint32 size of the arguments, arguments (uint8 ArgType and the value each)
+//   text:   uint8 RecordKind::Text, int64 time, uint32 thread id, uint8 level, uint32 size, UTF-8 message
+namespace BinaryTrace
+{
+    inline constexpr char FileMagic[4] = { 'P', 'T', 'B', 'T' };
+    inline constexpr uint16_t FileVersion = 1;
+
+    // First byte of a message payload with encoded arguments, it can't start an UTF-8 text
+    inline constexpr uint8_t EncodedPayloadMarker = 0xFF;
+
+    enum class RecordKind : uint8_t
+    {
+        Format = 1,
+        Event = 2,
+        Text = 3,
+    };
+
+    enum class ArgType : uint8_t
+    {
+        Bool = 1,
+        Int = 2,
+        UInt = 3,
+        Double = 4,
+        String = 5,
+    };
+
+    // Argument types the format can store, others are logged as text
+    template<typename T>
+    constexpr bool is_encodable_arg()
+    {
+        using Type = std::remove_cvref_t<std::decay_t<T>>;
+        if constexpr (std::is_same_v<Type, char> || std::is_same_v<Type, wchar_t> || std::is_same_v<Type, char8_t> ||
+                      std::is_same_v<Type, char16_t> || std::is_same_v<Type, char32_t>)
+        {
+            // characters would be decoded as numbers
+            return false;
+        }
+        else
+        {
+            return std::is_arithmetic_v<Type> || std::is_enum_v<Type> ||
+                   std::is_same_v<Type, const wchar_t*> || std::is_same_v<Type, wchar_t*> ||
+                   std::is_same_v<Type, std::wstring> || std::is_same_v<Type, std::wstring_view>;
+        }
+    }
+
+    template<typename T>
+    void write_value(std::string& out, const T& value)
+    {
+        const auto size = out.size();
+        out.resize(size + sizeof(T));
+        std::memcpy(out.data() + size, &value, sizeof(T));
+    }
+
+    inline void write_string(std::string& out, std::wstring_view text)
+    {
+        write_value(out, static_cast<uint32_t>(text.size()));
+        out.append(reinterpret_cast<const char*>(text.data()), text.size() * sizeof(wchar_t));
+    }
+
+    template<typename T>
+    void encode_arg(std::string& out, const T& value)
+    {
+        using Type = std::remove_cvref_t<std::decay_t<T>>;
+        if constexpr (std::is_same_v<Type, bool>)
+        {
+            out.push_back(static_cast<char>(ArgType::Bool));
+            out.push_back(value ? 1 : 0);
+        }
+        else if constexpr (std::is_enum_v<Type>)
+        {
+            encode_arg(out, static_cast<std::underlying_type_t<Type>>(value));
+        }
+        else if constexpr (std::is_floating_point_v<Type>)
+        {
+            out.push_back(static_cast<char>(ArgType::Double));
+            write_value(out, static_cast<double>(value));
+        }
+        else if constexpr (std::is_signed_v<Type>)
+        {
+            out.push_back(static_cast<char>(ArgType::Int));
+            write_value(out, static_cast<int64_t>(value));
+        }
+        else if constexpr (std::is_unsigned_v<Type>)
+        {
+            out.push_back(static_cast<char>(ArgType::UInt));
+            write_value(out, static_cast<uint64_t>(value));
+        }
+        else
+        {
+            out.push_back(static_cast<char>(ArgType::String));
+            write_string(out, value ? std::wstring_view(value) : std::wstring_view());
+        }
+    }
+
+    inline void encode_arg(std::string& out, const std::wstring& value)
+    {
+        out.push_back(static_cast<char>(ArgType::String));
+        write_string(out, value);
+    }
+
+    inline void encode_arg(std::string& out, std::wstring_view value)
+    {
+        out.push_back(static_cast<char>(ArgType::String));
+        write_string(out, value);
+    }
+
+    // Payload handed to the trace sink by the logging thread: marker, format id, arguments
+    template<typename... Args>
+    void encode_payload(std::string& out, uint32_t formatId, const Args&... args)
+    {
+        out.clear();
+        out.push_back(static_cast<char>(EncodedPayloadMarker));
+        write_value(out, formatId);
+        (encode_arg(out, args), ...);
+    }
+
+    using Arg = std::variant<bool, int64_t, uint64_t, double, std::wstring>;
+
+    // Replaces the {} fields of a format string, with the std::format syntax for the format specs
+    inline std::wstring format_message(std::wstring_view format, const std::vector<Arg>& args)
+    {
+        std::wstring result;
+        size_t nextArg = 0;
+        for (size_t i = 0; i < format.size(); i++)
+        {
+            const wchar_t c = format[i];
+            if ((c == L'{' || c == L'}') && i + 1 < format.size() && format[i + 1] == c)
+            {
+                result += c;
+                i++;
+                continue;
+            }
+
+            const size_t end = c == L'{' ? format.find(L'}', i) : std::wstring_view::npos;
+            if (end == std::wstring_view::npos)
+            {
+                result += c;
+                continue;
+            }
+
+            // {index:spec}
+            auto field = format.substr(i + 1, end - i - 1);
+            const size_t colon = field.find(L':');
+            auto indexText = field.substr(0, colon);
+            size_t index = nextArg++;
+            if (!indexText.empty())
+            {
+                index = 0;
+                for (wchar_t digit : indexText)
+                {
+                    index = index * 10 + (digit - L'0');
+                }
+            }
+
+            if (index >= args.size())
+            {
+                result += format.substr(i, end - i + 1);
+            }
+            else
+            {
+                const std::wstring spec = L"{" + std::wstring(colon == std::wstring_view::npos ? L"" : field.substr(colon)) + L"}";
+                try
+                {
+                    std::visit([&](const auto& value) { result += std::vformat(spec, std::make_wformat_args(value)); }, args[index]);
+                }
+                catch (const std::format_error&)
+                {
+                    std::visit([&](const auto& value) { result += std::format(L"{}", value); }, args[index]);
+                }
+            }
+            i = end;
+        }
+        return result;
+    }
+
+    // Invalid sequences become U+FFFD
+    inline std::wstring from_utf8(std::string_view text)
+    {
+        std::wstring result;
+        result.reserve(text.size());
+        for (size_t i = 0; i < text.size();)
+        {
+            const auto lead = static_cast<uint8_t>(text[i]);
+            const size_t length = lead < 0x80 ? 1 : (lead >> 5) == 0x6 ? 2 :
+                                                    (lead >> 4) == 0xE ? 3 :
+                                                    (lead >> 3) == 0x1E ? 4 :
+                                                                          0;
+            if (length == 0 || i + length > text.size())
+            {
+                result += L'\xFFFD';
+                i++;
+                continue;
+            }
+
+            char32_t codePoint = length == 1 ? lead : lead & (0x7F >> length);
+            bool valid = true;
+            for (size_t j = 1; j < length; j++)
+            {
+                const auto next = static_cast<uint8_t>(text[i + j]);
+                valid = valid && (next & 0xC0) == 0x80;
+                codePoint = (codePoint << 6) | (next & 0x3F);
+            }
+
+            if (!valid || codePoint > 0x10FFFF)
+            {
+                result += L'\xFFFD';
+                i++;
+                continue;
+            }
+
+            if (codePoint >= 0x10000 && sizeof(wchar_t) == 2)
+            {
+                codePoint -= 0x10000;
+                result += static_cast<wchar_t>(0xD800 + (codePoint >> 10));
+                result += static_cast<wchar_t>(0xDC00 + (codePoint & 0x3FF));
+            }
+            else
+            {
+                result += static_cast<wchar_t>(codePoint);
+            }
+            i += length;
+        }
+        return result;
+    }
+
+    struct DecodedRecord
+    {
+        std::chrono::sys_time<std::chrono::microseconds> time;
+        uint32_t threadId = 0;
+        uint8_t level = 0;
+        std::wstring message;
+    };
+
+    // Reads the records of a trace file. Fails on a truncated or corrupt file, the records read
+    // before the damaged one are still returned.
+    class Decoder
+    {
+    public:
+        explicit Decoder(std::string data) :
+            m_data(std::move(data))
+        {
+            if (m_data.size() < sizeof(FileMagic) + sizeof(uint16_t) + sizeof(uint32_t) || std::memcmp(m_data.data(), FileMagic, sizeof(FileMagic)) != 0)
+            {
+                m_failed = true;
+                return;
+            }
+
+            m_pos = sizeof(FileMagic);
+            uint16_t version = 0;
+            read(version);
+            read(m_processId);
+            m_failed = version != FileVersion;
+        }
+
+        bool failed() const
+        {
+            return m_failed;
+        }
+
+        uint32_t process_id() const
+        {
+            return m_processId;
+        }
+
+        std::optional<DecodedRecord> next()
+        {
+            while (!m_failed && m_pos < m_data.size())
+            {
+                uint8_t kind = 0;
+                read(kind);
+                switch (static_cast<RecordKind>(kind))
+                {
+                case RecordKind::Format:
+                {
+                    uint32_t id = 0;
+                    std::wstring text;
+                    if (read(id) && read_string(text))
+                    {
+                        if (m_formats.size() <= id)
+                        {
+                            m_formats.resize(id + 1);
+                        }
+                        m_formats[id] = std::move(text);
+                    }
+                    break;
+                }
+                case RecordKind::Event:
+                    if (auto record = read_event())
+                    {
+                        return record;
+                    }
+                    break;
+                case RecordKind::Text:
+                    if (auto record = read_text())
+                    {
+                        return record;
+                    }
+                    break;
+                default:
+                    m_failed = true;
+                    break;
+                }
+            }
+            return std::nullopt;
+        }
+
+    private:
+        template<typename T>
+        bool read(T& value)
+        {
+            if (m_failed || m_data.size() - m_pos < sizeof(T))
+            {
+                m_failed = true;
+                return false;
+            }
+
+            std::memcpy(&value, m_data.data() + m_pos, sizeof(T));
+            m_pos += sizeof(T);
+            return true;
+        }
+
+        bool read_string(std::wstring& text)
+        {
+            uint32_t length = 0;
+            if (!read(length) || (m_data.size() - m_pos) / sizeof(wchar_t) < length)
+            {
+                m_failed = true;
+                return false;
+            }
+
+            text.assign(reinterpret_cast<const wchar_t*>(m_data.data() + m_pos), length);
+            m_pos += length * sizeof(wchar_t);
+            return true;
+        }
+
+        bool read_header(DecodedRecord& record)
+        {
+            int64_t time = 0;
+            if (!read(time) || !read(record.threadId) || !read(record.level))
+            {
+                return false;
+            }
+
+            record.time = std::chrono::sys_time<std::chrono::microseconds>(std::chrono::microseconds(time));
+            return true;
+        }
+
+        std::optional<DecodedRecord> read_event()
+        {
+            DecodedRecord record;
+            uint32_t formatId = 0;
+            uint32_t size = 0;
+            if (!read_header(record) || !read(formatId) || !read(size) || m_data.size() - m_pos < size)
+            {
+                m_failed = true;
+                return std::nullopt;
+            }
+
+            const size_t end = m_pos + size;
+            std::vector<Arg> args;
+            while (m_pos < end && !m_failed)
+            {
+                uint8_t type = 0;
+                read(type);
+                switch (static_cast<ArgType>(type))
+                {
+                case ArgType::Bool:
+                {
+                    uint8_t value = 0;
+                    read(value);
+                    args.emplace_back(value != 0);
+                    break;
+                }
+                case ArgType::Int:
+                {
+                    int64_t value = 0;
+                    read(value);
+                    args.emplace_back(value);
+                    break;
+                }
+                case ArgType::UInt:
+                {
+                    uint64_t value = 0;
+                    read(value);
+                    args.emplace_back(value);
+                    break;
+                }
+                case ArgType::Double:
+                {
+                    double value = 0;
+                    read(value);
+                    args.emplace_back(value);
+                    break;
+                }
+                case ArgType::String:
+                {
+                    std::wstring value;
+                    read_string(value);
+                    args.emplace_back(std::move(value));
+                    break;
+                }
+                default:
+                    m_failed = true;
+                    break;
+                }
+            }
+
+            if (m_failed || m_pos != end)
+            {
+                m_failed = true;
+                return std::nullopt;
+            }
+
+            if (formatId < m_formats.size() && m_formats[formatId].has_value())
+            {
+                record.message = format_message(m_formats[formatId].value(), args);
+            }
+            else
+            {
+                record.message = std::format(L"<unknown format {}>", formatId);
+            }
+            return record;
+        }
+
+        std::optional<DecodedRecord> read_text()
+        {
+            DecodedRecord record;
+            uint32_t size = 0;
+            if (!read_header(record) || !read(size) || m_data.size() - m_pos < size)
+            {
+                m_failed = true;
+                return std::nullopt;
+            }
+
+            record.message = from_utf8(std::string_view(m_data.data() + m_pos, size));
+            m_pos += size;
+            return record;
+        }
+
+        std::string m_data;
+        size_t m_pos = 0;
+        bool m_failed = false;
+        uint32_t m_processId = 0;
+        std::vector<std::optional<std::wstring>> m_formats;
+    };
+}
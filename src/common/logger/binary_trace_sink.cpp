@@ -0,0 +1,109 @@
+#include "pch.h"
+#include "binary_trace_sink.h"
+#include "binary_trace.h"
+
+#include <spdlog/details/log_msg.h>
+
+using namespace BinaryTrace;
+
+namespace
+{
+    std::mutex formatsMutex;
+
+    // Id 0 is reserved, it marks a call site that didn't register its format string yet
+    std::vector<std::wstring> formats{ L"" };
+
+    template<typename T>
+    void Append(spdlog::memory_buf_t& buffer, const T& value)
+    {
+        const auto data = reinterpret_cast<const char*>(&value);
+        buffer.append(data, data + sizeof(T));
+    }
+
+    void AppendRecordHeader(spdlog::memory_buf_t& buffer, RecordKind kind, const spdlog::details::log_msg& msg)
+    {
+        Append(buffer, kind);
+        Append(buffer, static_cast<int64_t>(std::chrono::duration_cast<std::chrono::microseconds>(msg.time.time_since_epoch()).count()));
+        Append(buffer, static_cast<uint32_t>(msg.thread_id));
+        Append(buffer, static_cast<uint8_t>(msg.level));
+    }
+}
+
+BinaryTraceSink::BinaryTraceSink(const spdlog::filename_t& filePath)
+{
+    m_file.open(filePath, true);
+
+    m_buffer.append(std::begin(FileMagic), std::end(FileMagic));
+    Append(m_buffer, FileVersion);
+    Append(m_buffer, static_cast<uint32_t>(GetCurrentProcessId()));
+    m_file.write(m_buffer);
+    m_buffer.clear();
+}
+
+uint32_t BinaryTraceSink::register_format(std::wstring_view format)
+{
+    std::lock_guard lock(formatsMutex);
+    formats.emplace_back(format);
+    return static_cast<uint32_t>(formats.size() - 1);
+}
+
+void BinaryTraceSink::sink_it_(const spdlog::details::log_msg& msg)
+{
+    const auto payload = msg.payload;
+    m_buffer.clear();
+    if (payload.size() > sizeof(uint32_t) && static_cast<uint8_t>(payload[0]) == EncodedPayloadMarker)
+    {
+        uint32_t formatId = 0;
+        memcpy(&formatId, payload.data() + 1, sizeof(formatId));
+        WriteFormat(formatId);
+
+        const size_t argsSize = payload.size() - 1 - sizeof(formatId);
+        AppendRecordHeader(m_buffer, RecordKind::Event, msg);
+        Append(m_buffer, formatId);
+        Append(m_buffer, static_cast<uint32_t>(argsSize));
+        m_buffer.append(payload.data() + 1 + sizeof(formatId), payload.data() + payload.size());
+    }
+    else
+    {
+        AppendRecordHeader(m_buffer, RecordKind::Text, msg);
+        Append(m_buffer, static_cast<uint32_t>(payload.size()));
+        m_buffer.append(payload.data(), payload.data() + payload.size());
+    }
+
+    m_file.write(m_buffer);
+}
+
+void BinaryTraceSink::flush_()
+{
+    m_file.flush();
+}
+
+void BinaryTraceSink::WriteFormat(uint32_t formatId)
+{
+    if (formatId < m_writtenFormats.size() && m_writtenFormats[formatId])
+    {
+        return;
+    }
+
+    std::wstring format;
+    {
+        std::lock_guard lock(formatsMutex);
+        if (formatId >= formats.size())
+        {
+            return;
+        }
+        format = formats[formatId];
+    }
+
+    if (m_writtenFormats.size() <= formatId)
+    {
+        m_writtenFormats.resize(formatId + 1);
+    }
+    m_writtenFormats[formatId] = true;
+
+    Append(m_buffer, RecordKind::Format);
+    Append(m_buffer, formatId);
+    Append(m_buffer, static_cast<uint32_t>(format.size()));
+    const auto data = reinterpret_cast<const char*>(format.data());
+    m_buffer.append(data, data + format.size() * sizeof(wchar_t));
+}
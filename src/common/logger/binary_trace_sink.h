@@ -0,0 +1,29 @@
+#pragma once
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <spdlog/details/file_helper.h>
+#include <spdlog/sinks/base_sink.h>
+
+// Writes messages to a file in the BinaryTrace format. Messages logged through Logger::log with
+// encodable arguments arrive as encoded payloads, anything else is stored as text.
+class BinaryTraceSink : public spdlog::sinks::base_sink<std::mutex>
+{
+public:
+    explicit BinaryTraceSink(const spdlog::filename_t& filePath);
+
+    // Ids of the format strings used by the process, shared by all the sinks
+    static uint32_t register_format(std::wstring_view format);
+
+protected:
+    void sink_it_(const spdlog::details::log_msg& msg) override;
+    void flush_() override;
+
+private:
+    void WriteFormat(uint32_t formatId);
+
+    spdlog::details::file_helper m_file;
+    spdlog::memory_buf_t m_buffer;
+    std::vector<bool> m_writtenFormats;
+};
@@ -3,6 +3,9 @@
 #include "pch.h"
 #include "framework.h"
 #include "logger.h"
+#include "async_sink.h"
+#include "binary_trace_sink.h"
+#include <filesystem>
 #include <unordered_map>
 #include <spdlog/sinks/daily_file_sink.h>
 #include <spdlog/sinks/msvc_sink.h>
@@ -10,7 +13,6 @@
 #include <spdlog/sinks/stdout_color_sinks-inl.h>
 #include <iostream>
 
-using spdlog::sinks_init_list;
 using spdlog::level::level_enum;
 using spdlog::sinks::daily_file_sink_mt;
 using spdlog::sinks::msvc_sink_mt;
@@ -29,9 +31,14 @@ namespace
     };
 }
 
-level_enum getLogLevel(std::wstring_view logSettingsPath)
+level_enum getLogLevel(const LogSettings& settings, const std::wstring& moduleName)
 {
-    auto logLevel = get_log_settings(logSettingsPath).logLevel;
+    auto logLevel = settings.logLevel;
+    if (auto it = settings.moduleLogLevels.find(moduleName); it != settings.moduleLogLevels.end())
+    {
+        logLevel = it->second;
+    }
+
     if (auto it = logLevelMapping.find(logLevel); it != logLevelMapping.end())
     {
         return it->second;
@@ -44,7 +51,23 @@ level_enum getLogLevel(std::wstring_view logSettingsPath)
     return level_enum::trace;
 }
 
+// Only the trace and debug messages can go to the binary trace
+level_enum getTraceLevel(const LogSettings& settings, const std::wstring& moduleName)
+{
+    if (auto it = settings.moduleTraceLevels.find(moduleName); it != settings.moduleTraceLevels.end())
+    {
+        if (auto level = logLevelMapping.find(it->second); level != logLevelMapping.end() && level->second <= level_enum::debug)
+        {
+            return level->second;
+        }
+    }
+    return level_enum::off;
+}
+
 std::shared_ptr<spdlog::logger> Logger::logger = spdlog::null_logger_mt("null");
+std::shared_ptr<AsyncSink> Logger::asyncSink;
+std::shared_ptr<spdlog::logger> Logger::traceLogger;
+std::shared_ptr<AsyncSink> Logger::traceAsyncSink;
 
 bool Logger::wasLogFailedShown()
 {
@@ -55,31 +78,57 @@ bool Logger::wasLogFailedShown()
     return len;
 }
 
-void Logger::init(std::string loggerName, std::wstring logFilePath, std::wstring_view logSettingsPath)
+void Logger::init(std::string loggerName, std::wstring logFilePath, std::wstring_view logSettingsPath, bool async)
 {
-    auto logLevel = getLogLevel(logSettingsPath);
+    const auto settings = get_log_settings(logSettingsPath);
+    const std::wstring moduleName(loggerName.begin(), loggerName.end());
+    auto logLevel = getLogLevel(settings, moduleName);
+    auto traceLevel = getTraceLevel(settings, moduleName);
     bool newLoggerCreated = false;
     try
     {
         logger = spdlog::get(loggerName);
         if (logger == nullptr)
         {
-            auto sink = make_shared<daily_file_sink_mt>(logFilePath, 0, 0, false, LogSettings::retention);
+            std::vector<spdlog::sink_ptr> sinks{ make_shared<daily_file_sink_mt>(logFilePath, 0, 0, false, LogSettings::retention) };
             if (IsDebuggerPresent())
             {
                 auto msvc_sink = make_shared<msvc_sink_mt>();
                 msvc_sink->set_pattern("[%Y-%m-%d %H:%M:%S.%f] [%n] [t-%t] [%l] %v");
-                logger = make_shared<spdlog::logger>(loggerName, sinks_init_list{ sink, msvc_sink });
+                sinks.push_back(msvc_sink);
+            }
+
+            if (async)
+            {
+                // Hook threads must not wait for the writer, so messages are dropped (and counted) if it falls behind
+                asyncSink = make_shared<AsyncSink>(sinks, AsyncLogOverflowPolicy::Drop);
+                logger = make_shared<spdlog::logger>(loggerName, asyncSink);
             }
             else
             {
-                logger = make_shared<spdlog::logger>(loggerName, sink);
+                logger = make_shared<spdlog::logger>(loggerName, begin(sinks), end(sinks));
+            }
+
+            if (traceLevel != level_enum::off)
+            {
+                auto tracePath = std::filesystem::path(logFilePath).replace_extension(L".trace").wstring();
+                spdlog::sink_ptr traceSink = make_shared<BinaryTraceSink>(tracePath);
+                if (async)
+                {
+                    traceAsyncSink = make_shared<AsyncSink>(std::vector<spdlog::sink_ptr>{ traceSink }, AsyncLogOverflowPolicy::Drop);
+                    traceSink = traceAsyncSink;
+                }
+                traceLogger = make_shared<spdlog::logger>(loggerName + "-trace", traceSink);
+                traceLogger->set_level(traceLevel);
             }
             newLoggerCreated = true;
         }
     }
     catch (...)
     {
+        asyncSink = nullptr;
+        traceLogger = nullptr;
+        traceAsyncSink = nullptr;
         logger = spdlog::null_logger_mt(loggerName);
         if (!wasLogFailedShown())
         {
@@ -99,20 +148,98 @@ void Logger::init(std::string loggerName, std::wstring logFilePath, std::wstring
     {
         logger->set_level(logLevel);
         logger->set_pattern("[%Y-%m-%d %H:%M:%S.%f] [p-%P] [t-%t] [%l] %v");
-        logger->flush_on(logLevel); // Auto flush on every log message.
+        if (!asyncSink)
+        {
+            logger->flush_on(logLevel); // Auto flush on every log message.
+        }
         spdlog::register_logger(logger);
     }
 
     logger->info("{} logger is initialized", loggerName);
 }
 
-void Logger::init(std::vector<spdlog::sink_ptr> sinks)
+void Logger::init(std::vector<spdlog::sink_ptr> sinks, bool async)
 {
-    auto init_logger = std::make_shared<spdlog::logger>("", begin(sinks), end(sinks));
+    std::shared_ptr<AsyncSink> init_async_sink;
+    std::shared_ptr<spdlog::logger> init_logger;
+    if (async)
+    {
+        init_async_sink = std::make_shared<AsyncSink>(std::move(sinks), AsyncLogOverflowPolicy::Drop);
+        init_logger = std::make_shared<spdlog::logger>("", init_async_sink);
+    }
+    else
+    {
+        init_logger = std::make_shared<spdlog::logger>("", begin(sinks), end(sinks));
+    }
+
     if (!init_logger)
     {
         return;
     }
 
+    // the levels of the sinks decide what is written
+    init_logger->set_level(spdlog::level::trace);
     Logger::logger = init_logger;
+    Logger::asyncSink = init_async_sink;
+    Logger::traceLogger = nullptr;
+    Logger::traceAsyncSink = nullptr;
+}
+
+void Logger::flush()
+{
+    if (asyncSink)
+    {
+        asyncSink->flush_sync();
+    }
+    else
+    {
+        logger->flush();
+    }
+
+    if (traceAsyncSink)
+    {
+        traceAsyncSink->flush_sync();
+    }
+    else if (traceLogger)
+    {
+        traceLogger->flush();
+    }
+}
+
+void Logger::flush_on_crash()
+{
+    if (asyncSink)
+    {
+        asyncSink->flush_on_crash();
+    }
+    else
+    {
+        logger->flush();
+    }
+
+    if (traceAsyncSink)
+    {
+        traceAsyncSink->flush_on_crash();
+    }
+    else if (traceLogger)
+    {
+        traceLogger->flush();
+    }
+}
+
+uint32_t Logger::register_trace_format(std::wstring_view format)
+{
+    return BinaryTraceSink::register_format(format);
+}
+
+std::string& Logger::trace_payload_buffer()
+{
+    // keeps its capacity, so encoding a message doesn't allocate
+    thread_local std::string payload;
+    return payload;
+}
+
+void Logger::write_trace(spdlog::level::level_enum level, const std::string& payload)
+{
+    traceLogger->log(level, spdlog::string_view_t(payload.data(), payload.size()));
 }
@@ -1,19 +1,74 @@
 #pragma once
+#include <atomic>
 #include <spdlog/spdlog.h>
+#include "binary_trace.h"
 #include "logger_settings.h"
 
+class AsyncSink;
+
 class Logger
 {
 private:
     inline const static std::wstring logFailedShown = L"logFailedShown";
     static std::shared_ptr<spdlog::logger> logger;
+    static std::shared_ptr<AsyncSink> asyncSink;
+    static std::shared_ptr<spdlog::logger> traceLogger;
+    static std::shared_ptr<AsyncSink> traceAsyncSink;
     static bool wasLogFailedShown();
 
+    static uint32_t register_trace_format(std::wstring_view format);
+    static std::string& trace_payload_buffer();
+    static void write_trace(spdlog::level::level_enum level, const std::string& payload);
+
 public:
     Logger() = delete;
 
-    static void init(std::string loggerName, std::wstring logFilePath, std::wstring_view logSettingsPath);
-    static void init(std::vector<spdlog::sink_ptr> sinks);
+    // With async, messages are written to the file by a background thread, so logging doesn't block
+    // the calling thread on file I/O. Meant for executables with hot logging paths, like hook threads.
+    // The levels come from the log settings: moduleLogLevels overrides logLevel for loggerName, and
+    // moduleTraceLevels enables the binary trace file of the LOG_TRACE and LOG_DEBUG messages.
+    static void init(std::string loggerName, std::wstring logFilePath, std::wstring_view logSettingsPath, bool async = false);
+    static void init(std::vector<spdlog::sink_ptr> sinks, bool async = false);
+
+    // Call site of a LOG_* macro, keeps the id of its format string in the binary trace
+    struct CallSite
+    {
+        std::atomic<uint32_t> formatId = 0;
+    };
+
+    static bool should_log(spdlog::level::level_enum level)
+    {
+        return logger->should_log(level) || (traceLogger && level < spdlog::level::info && traceLogger->should_log(level));
+    }
+
+    // Used by the LOG_* macros. Trace and debug messages go to the binary trace when it's enabled and
+    // it can store the arguments, everything else goes to the log.
+    template<typename FormatString, typename... Args>
+    static void log(CallSite& callSite, spdlog::level::level_enum level, const FormatString& fmt, const Args&... args)
+    {
+        if constexpr (std::is_convertible_v<const FormatString&, std::wstring_view> && (BinaryTrace::is_encodable_arg<Args>() && ...))
+        {
+            if (traceLogger && level < spdlog::level::info && traceLogger->should_log(level))
+            {
+                uint32_t formatId = callSite.formatId.load(std::memory_order_relaxed);
+                if (formatId == 0)
+                {
+                    formatId = register_trace_format(fmt);
+                    callSite.formatId.store(formatId, std::memory_order_relaxed);
+                }
+
+                auto& payload = trace_payload_buffer();
+                BinaryTrace::encode_payload(payload, formatId, args...);
+                write_trace(level, payload);
+                return;
+            }
+        }
+
+        if (logger->should_log(level))
+        {
+            logger->log(level, fmt, args...);
+        }
+    }
 
     // log message should not be localized
     template<typename FormatString, typename... Args>
@@ -57,8 +112,59 @@ public:
         logger->critical(fmt, args...);
     }
 
-    static void flush()
-    {
-        logger->flush();
-    }
+    // Writes out all the messages logged so far
+    static void flush();
+
+    // Same as flush, but safe to call from a crash handler
+    static void flush_on_crash();
 };
+
+// Lowest level compiled in. A project can raise it by defining POWERTOYS_LOG_ACTIVE_LEVEL as one of the
+// SPDLOG_LEVEL_* values, the LOG_* macros below that level compile to nothing.
+#ifndef POWERTOYS_LOG_ACTIVE_LEVEL
+#define POWERTOYS_LOG_ACTIVE_LEVEL SPDLOG_LEVEL_TRACE
+#endif
+
+// Unlike the Logger methods, the LOG_* macros evaluate their arguments only if the message is logged.
+// log message should not be localized
+#define POWERTOYS_LOG(level, ...)                                  \
+    do                                                             \
+    {                                                              \
+        if (Logger::should_log(level))                             \
+        {                                                          \
+            static Logger::CallSite powertoysLogCallSite;          \
+            Logger::log(powertoysLogCallSite, level, __VA_ARGS__); \
+        }                                                          \
+    } while (0)
+
+#if POWERTOYS_LOG_ACTIVE_LEVEL <= SPDLOG_LEVEL_TRACE
+#define LOG_TRACE(...) POWERTOYS_LOG(spdlog::level::trace, __VA_ARGS__)
+#else
+#define LOG_TRACE(...) (void)0
+#endif
+
+#if POWERTOYS_LOG_ACTIVE_LEVEL <= SPDLOG_LEVEL_DEBUG
+#define LOG_DEBUG(...) POWERTOYS_LOG(spdlog::level::debug, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...) (void)0
+#endif
+
+#if POWERTOYS_LOG_ACTIVE_LEVEL <= SPDLOG_LEVEL_INFO
+#define LOG_INFO(...) POWERTOYS_LOG(spdlog::level::info, __VA_ARGS__)
+#else
+#define LOG_INFO(...) (void)0
+#endif
+
+#if POWERTOYS_LOG_ACTIVE_LEVEL <= SPDLOG_LEVEL_WARN
+#define LOG_WARN(...) POWERTOYS_LOG(spdlog::level::warn, __VA_ARGS__)
+#else
+#define LOG_WARN(...) (void)0
+#endif
+
+#if POWERTOYS_LOG_ACTIVE_LEVEL <= SPDLOG_LEVEL_ERROR
+#define LOG_ERROR(...) POWERTOYS_LOG(spdlog::level::err, __VA_ARGS__)
+#else
+#define LOG_ERROR(...) (void)0
+#endif
+
+#define LOG_CRITICAL(...) POWERTOYS_LOG(spdlog::level::critical, __VA_ARGS__)
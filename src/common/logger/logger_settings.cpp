@@ -43,11 +43,44 @@ void to_file(std::wstring_view file_name, const JsonObject& obj)
     }
 }
 
+JsonObject to_json(const std::map<std::wstring, std::wstring>& levels)
+{
+    JsonObject result;
+    for (const auto& [name, level] : levels)
+    {
+        result.SetNamedValue(name, JsonValue::CreateStringValue(level));
+    }
+    return result;
+}
+
+std::map<std::wstring, std::wstring> to_levels(const JsonObject& jobject)
+{
+    std::map<std::wstring, std::wstring> result;
+    for (const auto& item : jobject)
+    {
+        if (item.Value().ValueType() == JsonValueType::String)
+        {
+            result[std::wstring{ item.Key() }] = item.Value().GetString();
+        }
+    }
+    return result;
+}
+
 JsonObject to_json(LogSettings settings)
 {
     JsonObject result;
     result.SetNamedValue(LogSettings::logLevelOption, JsonValue::CreateStringValue(settings.logLevel));
 
+    // the per module tables are only written when they're used
+    if (!settings.moduleLogLevels.empty())
+    {
+        result.SetNamedValue(LogSettings::moduleLogLevelsOption, to_json(settings.moduleLogLevels));
+    }
+    if (!settings.moduleTraceLevels.empty())
+    {
+        result.SetNamedValue(LogSettings::moduleTraceLevelsOption, to_json(settings.moduleTraceLevels));
+    }
+
     return result;
 }
 
@@ -62,7 +95,22 @@ LogSettings to_settings(JsonObject jobject)
     {
         result.logLevel = LogSettings::defaultLogLevel;
     }
-    
+
+    try
+    {
+        if (jobject.HasKey(LogSettings::moduleLogLevelsOption))
+        {
+            result.moduleLogLevels = to_levels(jobject.GetNamedObject(LogSettings::moduleLogLevelsOption));
+        }
+        if (jobject.HasKey(LogSettings::moduleTraceLevelsOption))
+        {
+            result.moduleTraceLevels = to_levels(jobject.GetNamedObject(LogSettings::moduleTraceLevelsOption));
+        }
+    }
+    catch (...)
+    {
+    }
+
     return result;
 }
 
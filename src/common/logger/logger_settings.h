@@ -1,4 +1,5 @@
 #pragma once
+#include <map>
 #include <string>
 
 struct LogSettings
@@ -6,6 +7,8 @@ struct LogSettings
     // The following strings are not localizable
     inline const static std::wstring defaultLogLevel = L"trace";
     inline const static std::wstring logLevelOption = L"logLevel";
+    inline const static std::wstring moduleLogLevelsOption = L"moduleLogLevels";
+    inline const static std::wstring moduleTraceLevelsOption = L"moduleTraceLevels";
     inline const static std::string runnerLoggerName = "runner";
     inline const static std::wstring logPath = L"Logs\\";
     inline const static std::wstring runnerLogPath = L"RunnerLogs\\runner-log.txt";
@@ -79,6 +82,10 @@ struct LogSettings
     inline const static std::string zoomItLoggerName = "zoom-it";
     inline const static int retention = 30;
     std::wstring logLevel;
+    // Levels per logger name, they override logLevel
+    std::map<std::wstring, std::wstring> moduleLogLevels;
+    // Per logger name, "trace" or "debug" writes the LOG_TRACE and LOG_DEBUG messages to a binary trace file next to the log, instead of the log
+    std::map<std::wstring, std::wstring> moduleTraceLevels;
     LogSettings();
 };
 
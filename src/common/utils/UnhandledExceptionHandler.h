@@ -204,7 +204,7 @@ inline void LogStackTrace()
     }
 
     Logger::error(L"STACK TRACE\r\n{}", ss.str());
-    Logger::flush();
+    Logger::flush_on_crash();
 }
 
 inline LONG WINAPI UnhandledExceptionHandler(PEXCEPTION_POINTERS info)
@@ -228,7 +228,7 @@ inline LONG WINAPI UnhandledExceptionHandler(PEXCEPTION_POINTERS info)
         catch (...)
         {
             Logger::error("Failed to log stack trace");
-            Logger::flush();
+            Logger::flush_on_crash();
         }
 
         processingException = false;
@@ -248,7 +248,7 @@ inline void AbortHandler(int /*signal_number*/)
     catch (...)
     {
         Logger::error("Failed to log stack trace on abort");
-        Logger::flush();
+        Logger::flush_on_crash();
     }
 }
 
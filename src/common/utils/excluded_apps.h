@@ -1,6 +1,10 @@
 #pragma once
-#include <vector>
+#include <algorithm>
+#include <cstdint>
 #include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
 
 // Checks if a process path is included in a list of strings.
 inline bool find_app_name_in_path(const std::wstring& where, const std::vector<std::wstring>& what)
@@ -31,6 +35,181 @@ inline bool find_folder_in_path(const std::wstring& where, const std::vector<std
     return false;
 }
 
+// Matches paths and titles against all the excluded apps at once, with the same results as
+// find_app_name_in_path and the title check of check_excluded_app_with_title. It's an Aho-Corasick automaton
+// over the entries, so a query reads the text once however long the list is. Build it when the list changes,
+// with the entries upper-cased like the paths and titles.
+class ExcludedAppsMatcher
+{
+public:
+    ExcludedAppsMatcher() = default;
+
+    explicit ExcludedAppsMatcher(const std::vector<std::wstring>& apps)
+    {
+        // The trie first, with the edges of a node in a list of their own
+        std::vector<std::vector<std::pair<wchar_t, uint32_t>>> children(1);
+        for (const auto& app : apps)
+        {
+            if (app.empty())
+            {
+                m_hasEmpty = true;
+                continue;
+            }
+
+            uint32_t node = 0;
+            for (const wchar_t c : app)
+            {
+                const auto it = std::find_if(children[node].begin(), children[node].end(), [c](const auto& edge) { return edge.first == c; });
+                if (it != children[node].end())
+                {
+                    node = it->second;
+                    continue;
+                }
+
+                const auto child = static_cast<uint32_t>(m_nodes.size());
+                m_nodes.push_back({ .depth = m_nodes[node].depth + 1 });
+                children[node].emplace_back(c, child);
+                children.emplace_back();
+                node = child;
+            }
+            m_nodes[node].terminal = true;
+            m_maxLength = (std::max)(m_maxLength, app.size());
+        }
+
+        for (uint32_t node = 0; node < m_nodes.size(); node++)
+        {
+            auto& edges = children[node];
+            std::sort(edges.begin(), edges.end());
+            m_nodes[node].first = static_cast<uint32_t>(m_edges.size());
+            m_nodes[node].count = static_cast<uint32_t>(edges.size());
+            m_edges.insert(m_edges.end(), edges.begin(), edges.end());
+        }
+
+        // The failure links in breadth-first order, so the ones of the shorter prefixes are there already
+        std::vector<uint32_t> queue{ 0 };
+        for (size_t i = 0; i < queue.size(); i++)
+        {
+            const uint32_t node = queue[i];
+            for (uint32_t e = m_nodes[node].first; e < m_nodes[node].first + m_nodes[node].count; e++)
+            {
+                const auto [c, child] = m_edges[e];
+                const uint32_t fail = node == 0 ? 0 : next(m_nodes[node].fail, c);
+                m_nodes[child].fail = fail;
+                m_nodes[child].output = m_nodes[fail].terminal ? fail : m_nodes[fail].output;
+                queue.push_back(child);
+            }
+        }
+    }
+
+    bool empty() const
+    {
+        return m_nodes.size() <= 1 && !m_hasEmpty;
+    }
+
+    // Same as find_app_name_in_path: the last occurrence of an entry has to contain the first character of the
+    // file name, or the backslash before it
+    bool find_app_name_in_path(std::wstring_view path) const
+    {
+        const auto lastSlash = path.rfind(L'\\');
+        if (lastSlash == std::wstring_view::npos)
+        {
+            return false;
+        }
+        if (m_hasEmpty && lastSlash == path.size() - 1)
+        {
+            return true;
+        }
+
+        // The occurrences which count end at the backslash or after it, the text before can't reach it
+        const size_t begin = lastSlash + 1 > m_maxLength ? lastSlash + 1 - m_maxLength : 0;
+
+        // The nodes of the entries whose occurrences count so far, a later one in the file name overrules them
+        std::vector<uint32_t> found;
+        uint32_t state = 0;
+        for (size_t i = begin; i < path.size(); i++)
+        {
+            state = next(state, path[i]);
+            for (uint32_t node = m_nodes[state].terminal ? state : m_nodes[state].output; node != 0; node = m_nodes[node].output)
+            {
+                const size_t start = i + 1 - m_nodes[node].depth;
+                const auto it = std::find(found.begin(), found.end(), node);
+                if (start > lastSlash + 1)
+                {
+                    if (it != found.end())
+                    {
+                        found.erase(it);
+                    }
+                }
+                else if (i >= lastSlash && it == found.end())
+                {
+                    found.push_back(node);
+                }
+            }
+        }
+        return !found.empty();
+    }
+
+    // Whether the title contains an entry
+    bool find_in_title(std::wstring_view title) const
+    {
+        if (m_hasEmpty)
+        {
+            return true;
+        }
+
+        uint32_t state = 0;
+        for (const wchar_t c : title)
+        {
+            state = next(state, c);
+            if (m_nodes[state].terminal || m_nodes[state].output != 0)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    struct Node
+    {
+        // The edges of the node in m_edges, sorted by character
+        uint32_t first = 0;
+        uint32_t count = 0;
+
+        // The node of the longest proper suffix, and the one of the longest proper suffix which is an entry
+        uint32_t fail = 0;
+        uint32_t output = 0;
+
+        size_t depth = 0;
+        bool terminal = false;
+    };
+
+    uint32_t next(uint32_t node, wchar_t c) const
+    {
+        for (;;)
+        {
+            const auto begin = m_edges.begin() + m_nodes[node].first;
+            const auto end = begin + m_nodes[node].count;
+            const auto it = std::lower_bound(begin, end, c, [](const auto& edge, wchar_t value) { return edge.first < value; });
+            if (it != end && it->first == c)
+            {
+                return it->second;
+            }
+            if (node == 0)
+            {
+                return 0;
+            }
+            node = m_nodes[node].fail;
+        }
+    }
+
+    // The root first
+    std::vector<Node> m_nodes = std::vector<Node>(1);
+    std::vector<std::pair<wchar_t, uint32_t>> m_edges;
+    size_t m_maxLength = 0;
+    bool m_hasEmpty = false;
+};
+
 #define MAX_TITLE_LENGTH 255
 inline bool check_excluded_app_with_title(const HWND& hwnd, const std::vector<std::wstring>& excludedApps)
 {
@@ -41,8 +220,8 @@ inline bool check_excluded_app_with_title(const HWND& hwnd, const std::vector<st
         return false;
     }
 
-    std::wstring titleStr(title);
-    CharUpperBuffW(titleStr.data(), static_cast<DWORD>(titleStr.length()));
+    CharUpperBuffW(title, static_cast<DWORD>(len));
+    const std::wstring_view titleStr(title, len);
 
     for (const auto& app : excludedApps)
     {
@@ -54,6 +233,19 @@ inline bool check_excluded_app_with_title(const HWND& hwnd, const std::vector<st
     return false;
 }
 
+inline bool check_excluded_app_with_title(const HWND& hwnd, const ExcludedAppsMatcher& excludedApps)
+{
+    WCHAR title[MAX_TITLE_LENGTH];
+    int len = GetWindowTextW(hwnd, title, MAX_TITLE_LENGTH);
+    if (len <= 0)
+    {
+        return false;
+    }
+
+    CharUpperBuffW(title, static_cast<DWORD>(len));
+    return excludedApps.find_in_title(std::wstring_view(title, len));
+}
+
 inline bool check_excluded_app(const HWND& hwnd, const std::wstring& processPath, const std::vector<std::wstring>& excludedApps)
 {
     bool res = find_app_name_in_path(processPath, excludedApps);
@@ -65,3 +257,8 @@ inline bool check_excluded_app(const HWND& hwnd, const std::wstring& processPath
 
     return res;
 }
+
+inline bool check_excluded_app(const HWND& hwnd, const std::wstring& processPath, const ExcludedAppsMatcher& excludedApps)
+{
+    return excludedApps.find_app_name_in_path(processPath) || check_excluded_app_with_title(hwnd, excludedApps);
+}
@@ -0,0 +1,462 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define GCODE_THUMBNAIL_SSE2
+#endif
+
+// Extracts the thumbnails slicers embed at the top of G-code files:
+//
+//   ; thumbnail_QOI begin 128x128 4556
+//   ; cW9pZgAAAIAAAACABAD...
+//   ; thumbnail_QOI end
+//
+// The file is scanned line by line through a bounded window and the scan stops at the end of the thumbnail
+// section, so the time doesn't depend on the size of the file. Only the payload of the best thumbnail so far
+// is kept and decoded. Doesn't depend on Windows, the caller decodes the PNG, JPG or QOI image.
+namespace gcode
+{
+    // Same order as GcodeHelper in FilePreviewCommon, higher is preferred for the same size
+    enum class ThumbnailFormat
+    {
+        Unknown,
+        JPG,
+        QOI,
+        PNG,
+    };
+
+    struct Thumbnail
+    {
+        ThumbnailFormat format = ThumbnailFormat::Unknown;
+
+        // As declared in the begin line, 0 when it's missing
+        uint32_t width = 0;
+        uint32_t height = 0;
+
+        // Encoded image
+        std::vector<uint8_t> data;
+    };
+
+    // Longest line kept whole, thumbnail lines are below 100 characters
+    inline constexpr size_t window_size = 64 * 1024;
+
+    // The scan is given up on after this, slicers write the thumbnails before the first command
+    inline constexpr uint64_t default_max_scan_bytes = 8 * 1024 * 1024;
+
+    // Fills up to size bytes and returns how many were written, 0 at the end of the data or on errors
+    template<typename T>
+    concept Reader = requires(T reader, uint8_t* buffer, size_t size) {
+        { reader(buffer, size) } -> std::convertible_to<size_t>;
+    };
+
+    namespace base64
+    {
+        namespace details
+        {
+            inline constexpr std::array<int8_t, 256> make_table()
+            {
+                std::array<int8_t, 256> table{};
+                table.fill(-1);
+                constexpr std::string_view alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+                for (size_t i = 0; i < alphabet.size(); i++)
+                {
+                    table[static_cast<uint8_t>(alphabet[i])] = static_cast<int8_t>(i);
+                }
+                return table;
+            }
+
+            inline constexpr auto table = make_table();
+
+#ifdef GCODE_THUMBNAIL_SSE2
+            inline __m128i in_range(__m128i chars, char first, char last)
+            {
+                return _mm_and_si128(_mm_cmpgt_epi8(chars, _mm_set1_epi8(static_cast<char>(first - 1))), _mm_cmplt_epi8(chars, _mm_set1_epi8(static_cast<char>(last + 1))));
+            }
+
+            // Decodes 16 characters into 12 bytes, returns false if one of them isn't in the alphabet.
+            // Characters above 127 are negative as signed bytes and fall outside every range.
+            inline bool decode_block(const char* in, uint8_t* out)
+            {
+                const __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+                const __m128i upper = in_range(chars, 'A', 'Z');
+                const __m128i lower = in_range(chars, 'a', 'z');
+                const __m128i digit = in_range(chars, '0', '9');
+                const __m128i plus = _mm_cmpeq_epi8(chars, _mm_set1_epi8('+'));
+                const __m128i slash = _mm_cmpeq_epi8(chars, _mm_set1_epi8('/'));
+
+                const __m128i valid = _mm_or_si128(_mm_or_si128(upper, lower), _mm_or_si128(digit, _mm_or_si128(plus, slash)));
+                if (_mm_movemask_epi8(valid) != 0xffff)
+                {
+                    return false;
+                }
+
+                __m128i offset = _mm_and_si128(upper, _mm_set1_epi8(static_cast<char>(-'A')));
+                offset = _mm_or_si128(offset, _mm_and_si128(lower, _mm_set1_epi8(static_cast<char>(26 - 'a'))));
+                offset = _mm_or_si128(offset, _mm_and_si128(digit, _mm_set1_epi8(static_cast<char>(52 - '0'))));
+                offset = _mm_or_si128(offset, _mm_and_si128(plus, _mm_set1_epi8(static_cast<char>(62 - '+'))));
+                offset = _mm_or_si128(offset, _mm_and_si128(slash, _mm_set1_epi8(static_cast<char>(63 - '/'))));
+                const __m128i values = _mm_add_epi8(chars, offset);
+
+                // 6 bit values to 12 bits per 16 bit lane, then 24 bits per 32 bit lane
+                const __m128i pairs = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(values, _mm_set1_epi16(0x00ff)), 6), _mm_srli_epi16(values, 8));
+                const __m128i quads = _mm_madd_epi16(pairs, _mm_set1_epi32(0x00011000));
+
+                alignas(16) uint32_t lanes[4];
+                _mm_store_si128(reinterpret_cast<__m128i*>(lanes), quads);
+                for (uint32_t lane : lanes)
+                {
+                    out[0] = static_cast<uint8_t>(lane >> 16);
+                    out[1] = static_cast<uint8_t>(lane >> 8);
+                    out[2] = static_cast<uint8_t>(lane);
+                    out += 3;
+                }
+                return true;
+            }
+#endif
+        }
+
+        // Decodes standard base64 with optional padding and no whitespace. Returns false for invalid input.
+        inline bool decode(std::string_view text, std::vector<uint8_t>& out)
+        {
+            for (int i = 0; i < 2 && !text.empty() && text.back() == '='; i++)
+            {
+                text.remove_suffix(1);
+            }
+            if (text.size() % 4 == 1)
+            {
+                return false;
+            }
+
+            out.resize(text.size() / 4 * 3 + (text.size() % 4 ? text.size() % 4 - 1 : 0));
+            const char* in = text.data();
+            const char* end = in + text.size();
+            uint8_t* dest = out.data();
+
+#ifdef GCODE_THUMBNAIL_SSE2
+            for (; end - in >= 16; in += 16, dest += 12)
+            {
+                if (!details::decode_block(in, dest))
+                {
+                    return false;
+                }
+            }
+#endif
+
+            uint32_t bits = 0;
+            int count = 0;
+            for (; in != end; in++)
+            {
+                const int8_t value = details::table[static_cast<uint8_t>(*in)];
+                if (value < 0)
+                {
+                    return false;
+                }
+
+                bits = bits << 6 | static_cast<uint32_t>(value);
+                if (++count == 4)
+                {
+                    dest[0] = static_cast<uint8_t>(bits >> 16);
+                    dest[1] = static_cast<uint8_t>(bits >> 8);
+                    dest[2] = static_cast<uint8_t>(bits);
+                    dest += 3;
+                    bits = 0;
+                    count = 0;
+                }
+            }
+
+            if (count == 2)
+            {
+                *dest = static_cast<uint8_t>(bits >> 4);
+            }
+            else if (count == 3)
+            {
+                dest[0] = static_cast<uint8_t>(bits >> 10);
+                dest[1] = static_cast<uint8_t>(bits >> 2);
+            }
+            return true;
+        }
+    }
+
+    namespace details
+    {
+        struct Line
+        {
+            std::string_view text;
+
+            // False for lines longer than the window, which only keep their beginning
+            bool complete = true;
+        };
+
+        // Splits the data into lines without keeping more than one window in memory
+        template<Reader R>
+        class LineReader
+        {
+        public:
+            explicit LineReader(R& reader) :
+                m_reader(reader), m_buffer(window_size)
+            {
+            }
+
+            std::optional<Line> next()
+            {
+                while (true)
+                {
+                    const char* begin = m_buffer.data() + m_begin;
+                    if (const auto* newline = static_cast<const char*>(std::memchr(begin, '\n', m_end - m_begin)))
+                    {
+                        const size_t length = newline - begin;
+                        m_begin += length + 1;
+                        m_offset += length + 1;
+                        if (m_skipping)
+                        {
+                            m_skipping = false;
+                            continue;
+                        }
+                        return Line{ std::string_view{ begin, length } };
+                    }
+
+                    if (m_eof)
+                    {
+                        if (m_begin == m_end || m_skipping)
+                        {
+                            return std::nullopt;
+                        }
+                        const std::string_view last{ begin, m_end - m_begin };
+                        m_offset += last.size();
+                        m_begin = m_end;
+                        return Line{ last };
+                    }
+
+                    if (m_skipping)
+                    {
+                        m_offset += m_end - m_begin;
+                        m_begin = m_end;
+                    }
+                    else if (m_begin == 0 && m_end == m_buffer.size())
+                    {
+                        // The rest of the line is dropped up to the next newline
+                        const std::string_view prefix{ begin, m_end };
+                        m_offset += m_end;
+                        m_begin = m_end;
+                        m_skipping = true;
+                        return Line{ prefix, false };
+                    }
+                    fill();
+                }
+            }
+
+            // Bytes of the lines returned so far
+            uint64_t offset() const
+            {
+                return m_offset;
+            }
+
+        private:
+            void fill()
+            {
+                std::memmove(m_buffer.data(), m_buffer.data() + m_begin, m_end - m_begin);
+                m_end -= m_begin;
+                m_begin = 0;
+
+                const size_t space = m_buffer.size() - m_end;
+                const size_t read = (std::min)(static_cast<size_t>(m_reader(reinterpret_cast<uint8_t*>(m_buffer.data() + m_end), space)), space);
+                m_end += read;
+                m_eof = read == 0;
+            }
+
+            R& m_reader;
+            std::vector<char> m_buffer;
+            size_t m_begin = 0;
+            size_t m_end = 0;
+            uint64_t m_offset = 0;
+            bool m_eof = false;
+            bool m_skipping = false;
+        };
+
+        inline std::string_view trim(std::string_view text)
+        {
+            constexpr std::string_view whitespace = " \t\r";
+            const auto first = text.find_first_not_of(whitespace);
+            if (first == std::string_view::npos)
+            {
+                return {};
+            }
+            return text.substr(first, text.find_last_not_of(whitespace) - first + 1);
+        }
+
+        inline std::string_view next_word(std::string_view& text)
+        {
+            const auto space = text.find(' ');
+            const auto word = text.substr(0, space);
+            text = space == std::string_view::npos ? std::string_view{} : text.substr(space + 1);
+            return word;
+        }
+
+        struct Marker
+        {
+            bool begin = false;
+            Thumbnail thumbnail;
+            size_t length = 0;
+        };
+
+        // "; thumbnail[_FMT] begin|end [WxH LENGTH]", split on single spaces like GcodeHelper does
+        inline std::optional<Marker> parse_marker(std::string_view line)
+        {
+            constexpr std::string_view prefix = "; thumbnail";
+            if (!line.starts_with(prefix))
+            {
+                return std::nullopt;
+            }
+
+            std::string_view rest = line.substr(prefix.size());
+            rest = rest.substr(0, rest.find_last_not_of(" \t\r") + 1);
+            const auto suffix = next_word(rest);
+            const auto kind = next_word(rest);
+            if (kind != "begin" && kind != "end")
+            {
+                return std::nullopt;
+            }
+
+            Marker marker;
+            marker.begin = kind == "begin";
+            marker.thumbnail.format = suffix.empty() ? ThumbnailFormat::PNG :
+                                      suffix == "_JPG" ? ThumbnailFormat::JPG :
+                                      suffix == "_QOI" ? ThumbnailFormat::QOI :
+                                                         ThumbnailFormat::Unknown;
+
+            const auto size = next_word(rest);
+            const auto x = size.find('x');
+            if (x != std::string_view::npos)
+            {
+                uint32_t width = 0;
+                uint32_t height = 0;
+                const auto* end = size.data() + size.size();
+                if (std::from_chars(size.data(), size.data() + x, width).ptr == size.data() + x &&
+                    std::from_chars(size.data() + x + 1, end, height).ptr == end)
+                {
+                    marker.thumbnail.width = width;
+                    marker.thumbnail.height = height;
+                }
+            }
+
+            const auto length = next_word(rest);
+            std::from_chars(length.data(), length.data() + length.size(), marker.length);
+            return marker;
+        }
+
+        // The smallest thumbnail at least cx large, or the largest one if none is, then the preferred format
+        inline bool is_better(const Thumbnail& candidate, const Thumbnail& best, uint32_t cx)
+        {
+            const uint32_t candidateSize = (std::max)(candidate.width, candidate.height);
+            const uint32_t bestSize = (std::max)(best.width, best.height);
+            const bool candidateFits = candidateSize >= cx;
+            const bool bestFits = bestSize >= cx;
+
+            if (candidateFits != bestFits)
+            {
+                return candidateFits;
+            }
+            if (candidateSize != bestSize)
+            {
+                return candidateFits ? candidateSize < bestSize : candidateSize > bestSize;
+            }
+            return candidate.format > best.format;
+        }
+
+        inline bool is_command(std::string_view line)
+        {
+            line = trim(line);
+            return !line.empty() && line.front() != ';';
+        }
+    }
+
+    // Finds the thumbnail which fits cx x cx best. The scan ends at the first command after the thumbnails,
+    // after an exact match in the preferred format, or after max_scan_bytes.
+    // Returns nullopt when there's no thumbnail in a known format with a valid payload.
+    template<Reader R>
+    std::optional<Thumbnail> find_thumbnail(R&& reader, uint32_t cx, uint64_t max_scan_bytes = default_max_scan_bytes)
+    {
+        details::LineReader<std::remove_reference_t<R>> lines{ reader };
+        std::optional<Thumbnail> best;
+        bool seenThumbnail = false;
+
+        // Payload of the block being read, only for blocks better than the best one
+        std::optional<details::Marker> block;
+        bool inBlock = false;
+        std::string payload;
+
+        while (auto line = lines.next())
+        {
+            if (lines.offset() > max_scan_bytes)
+            {
+                break;
+            }
+
+            if (!inBlock)
+            {
+                if (seenThumbnail && details::is_command(line->text))
+                {
+                    break;
+                }
+
+                auto marker = line->complete ? details::parse_marker(line->text) : std::nullopt;
+                if (!marker || !marker->begin)
+                {
+                    continue;
+                }
+
+                inBlock = true;
+                seenThumbnail = true;
+                payload.clear();
+                block.reset();
+                if (marker->thumbnail.format != ThumbnailFormat::Unknown && (!best || details::is_better(marker->thumbnail, *best, cx)))
+                {
+                    payload.reserve(static_cast<size_t>((std::min)(uint64_t{ marker->length }, max_scan_bytes)));
+                    block = std::move(marker);
+                }
+                continue;
+            }
+
+            if (!line->complete)
+            {
+                block.reset();
+                continue;
+            }
+
+            if (auto marker = details::parse_marker(line->text); marker && !marker->begin)
+            {
+                inBlock = false;
+                if (block && base64::decode(payload, block->thumbnail.data) && !block->thumbnail.data.empty())
+                {
+                    best = std::move(block->thumbnail);
+                    if (best->format == ThumbnailFormat::PNG && (std::max)(best->width, best->height) == cx)
+                    {
+                        break;
+                    }
+                }
+                block.reset();
+                continue;
+            }
+
+            if (block)
+            {
+                payload += details::trim(line->text.substr((std::min)(line->text.size(), size_t{ 2 })));
+            }
+        }
+
+        return best;
+    }
+}
@@ -1,18 +1,18 @@
 #pragma once
 
 #include <Windows.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include <optional>
+#include <string>
 #include <vector>
 
-namespace powertoys_gpo {
-    enum gpo_rule_configured_t {
-        gpo_rule_configured_wrong_value = -3, // The policy is set to an unrecognized value
-        gpo_rule_configured_unavailable = -2, // Couldn't access registry
-        gpo_rule_configured_not_configured = -1, // Policy is not configured
-        gpo_rule_configured_disabled = 0, // Policy is disabled
-        gpo_rule_configured_enabled = 1, // Policy is enabled
-    };
+#include "gpo_snapshot.h"
 
+namespace powertoys_gpo {
     // Registry path where gpo policy values are stored.
     const std::wstring POLICIES_PATH = L"SOFTWARE\\Policies\\PowerToys";
     const std::wstring POWER_LAUNCHER_INDIVIDUAL_PLUGIN_ENABLED_LIST_PATH = POLICIES_PATH + L"\\PowerLauncherIndividualPluginEnabledList";
@@ -142,63 +142,273 @@ namespace powertoys_gpo {
         return string_value;
     }
 
-    inline gpo_rule_configured_t getConfiguredValue(const std::wstring& registry_value_name)
+    // data holds data_size bytes followed by two zeros
+    inline PolicyValue toPolicyValue(DWORD type, const wchar_t* data, DWORD data_size)
     {
-        HKEY key{};
-        DWORD value = 0xFFFFFFFE;
-        DWORD valueSize = sizeof(value);
+        PolicyValue value;
+        if (type == REG_DWORD && data_size == sizeof(DWORD))
+        {
+            value.type = PolicyValue::Type::Dword;
+            memcpy(&value.dword, data, sizeof(DWORD));
+        }
+        else if (type == REG_SZ)
+        {
+            value.type = PolicyValue::Type::String;
+            value.text = data;
+        }
+        else if (type == REG_MULTI_SZ)
+        {
+            // Same as readRegistryStringValue
+            value.type = PolicyValue::Type::MultiString;
+            for (const wchar_t* current = data; *current != L'\0'; current += wcslen(current) + 1)
+            {
+                value.text += value.text.empty() ? current : std::wstring(L"\r\n") + current;
+            }
+        }
+        return value;
+    }
 
-        bool machine_key_found = true;
-        if (auto res = RegOpenKeyExW(POLICIES_SCOPE_MACHINE, POLICIES_PATH.c_str(), 0, KEY_READ, &key); res != ERROR_SUCCESS)
+    // Reads the values of a policies key, or of a list key below it
+    inline void readPolicyValues(HKEY key, PolicyNameMap<PolicyValue>& values)
+    {
+        DWORD max_name_length = 0;
+        DWORD max_data_size = 0;
+        if (RegQueryInfoKeyW(key, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, &max_name_length, &max_data_size, nullptr, nullptr) != ERROR_SUCCESS)
         {
-            machine_key_found = false;
+            return;
         }
 
-        if(machine_key_found)
+        // With room for the terminating zeros, which the registry doesn't ensure
+        std::vector<wchar_t> name(max_name_length + 1);
+        std::vector<wchar_t> data(max_data_size / sizeof(wchar_t) + 2);
+        for (DWORD index = 0;; index++)
         {
-            // If the path was found in the machine, we need to check if the value for the policy exists.
-            auto res = RegQueryValueExW(key, registry_value_name.c_str(), nullptr, nullptr, reinterpret_cast<LPBYTE>(&value), &valueSize);
+            DWORD name_length = static_cast<DWORD>(name.size());
+            DWORD data_size = max_data_size;
+            DWORD type = REG_NONE;
+            std::fill(data.begin(), data.end(), L'\0');
+            const auto res = RegEnumValueW(key, index, name.data(), &name_length, nullptr, &type, reinterpret_cast<LPBYTE>(data.data()), &data_size);
+            if (res == ERROR_NO_MORE_ITEMS)
+            {
+                break;
+            }
+            if (res != ERROR_SUCCESS)
+            {
+                // Changed while it was read, the change notification reads it again
+                continue;
+            }
 
+            values[std::wstring(name.data(), name_length)] = toPolicyValue(type, data.data(), data_size);
+        }
+    }
+
+    // Reads one value of a policies key, nothing if it doesn't exist
+    inline void readPolicyValue(HKEY key, const std::wstring& value_name, PolicyNameMap<PolicyValue>& values)
+    {
+        DWORD data_size = 0;
+        if (RegQueryValueExW(key, value_name.c_str(), nullptr, nullptr, nullptr, &data_size) != ERROR_SUCCESS)
+        {
+            return;
+        }
+
+        // With room for the terminating zeros, which the registry doesn't ensure
+        std::vector<wchar_t> data(data_size / sizeof(wchar_t) + 2);
+        DWORD type = REG_NONE;
+        if (RegQueryValueExW(key, value_name.c_str(), nullptr, &type, reinterpret_cast<LPBYTE>(data.data()), &data_size) == ERROR_SUCCESS)
+        {
+            values[value_name] = toPolicyValue(type, data.data(), data_size);
+        }
+    }
+
+    // Reads the policies of one scope with the lists below them, or only the value with the given name
+    inline PolicyScope readPolicyScope(HKEY hRootKey, const std::wstring* value_name = nullptr)
+    {
+        PolicyScope scope;
+        HKEY key{};
+        if (auto res = RegOpenKeyExW(hRootKey, POLICIES_PATH.c_str(), 0, KEY_READ, &key); res != ERROR_SUCCESS)
+        {
+            scope.state = res == ERROR_FILE_NOT_FOUND ? PolicyScope::State::NotFound : PolicyScope::State::Unavailable;
+            return scope;
+        }
+
+        scope.state = PolicyScope::State::Found;
+        if (value_name)
+        {
+            readPolicyValue(key, *value_name, scope.values);
             RegCloseKey(key);
+            return scope;
+        }
 
-            if (res != ERROR_SUCCESS) {
-                // Value not found on the path.
-                machine_key_found=false;
+        readPolicyValues(key, scope.values);
+
+        wchar_t list_name[256];
+        for (DWORD index = 0;; index++)
+        {
+            DWORD list_name_length = ARRAYSIZE(list_name);
+            const auto res = RegEnumKeyExW(key, index, list_name, &list_name_length, nullptr, nullptr, nullptr, nullptr);
+            if (res == ERROR_NO_MORE_ITEMS)
+            {
+                break;
+            }
+            if (res != ERROR_SUCCESS)
+            {
+                continue;
+            }
+
+            HKEY list_key{};
+            if (RegOpenKeyExW(key, list_name, 0, KEY_READ, &list_key) == ERROR_SUCCESS)
+            {
+                readPolicyValues(list_key, scope.lists[std::wstring(list_name, list_name_length)]);
+                RegCloseKey(list_key);
             }
         }
 
-        if (!machine_key_found)
+        RegCloseKey(key);
+        return scope;
+    }
+
+    inline std::shared_ptr<const PolicySnapshot> readPolicySnapshot()
+    {
+        return std::make_shared<const PolicySnapshot>(readPolicyScope(POLICIES_SCOPE_MACHINE), readPolicyScope(POLICIES_SCOPE_USER));
+    }
+
+    // Keeps the snapshot of the policies current. Both scopes are read once and again when something below
+    // their Policies key changes, the getters read the published snapshot without going to the registry.
+    // Only started by watchPolicyChanges.
+    class PolicySnapshotCache
+    {
+    public:
+        // nullptr until the process started watching the policies
+        static PolicySnapshotCache* instance()
+        {
+            return started().load(std::memory_order_acquire);
+        }
+
+        // Lives as long as the process, the watches are never stopped
+        static void start()
+        {
+            static PolicySnapshotCache* cache = new PolicySnapshotCache();
+            started().store(cache, std::memory_order_release);
+        }
+
+        std::shared_ptr<const PolicySnapshot> current()
         {
-            // If there's no value found on the machine scope, try to get it from the user scope.
-            if (auto res = RegOpenKeyExW(POLICIES_SCOPE_USER, POLICIES_PATH.c_str(), 0, KEY_READ, &key); res != ERROR_SUCCESS)
+            if (!m_watching)
             {
-                if (res == ERROR_FILE_NOT_FOUND) {
-                    return gpo_rule_configured_not_configured;
-                }
-                return gpo_rule_configured_unavailable;
+                // Without the notifications the snapshot could be outdated
+                return readPolicySnapshot();
             }
-            auto res = RegQueryValueExW(key, registry_value_name.c_str(), nullptr, nullptr, reinterpret_cast<LPBYTE>(&value), &valueSize);
-            RegCloseKey(key);
+            return m_snapshot.load();
+        }
 
-            if (res != ERROR_SUCCESS) {
-                return gpo_rule_configured_not_configured;
+        PolicySnapshotCache(const PolicySnapshotCache&) = delete;
+        PolicySnapshotCache& operator=(const PolicySnapshotCache&) = delete;
+
+    private:
+        struct Watch
+        {
+            PolicySnapshotCache* cache = nullptr;
+            HKEY key = nullptr;
+            HANDLE event = nullptr;
+            PTP_WAIT wait = nullptr;
+        };
+
+        static std::atomic<PolicySnapshotCache*>& started()
+        {
+            static std::atomic<PolicySnapshotCache*> cache = nullptr;
+            return cache;
+        }
+
+        PolicySnapshotCache()
+        {
+            bool watching = true;
+            const HKEY scopes[] = { POLICIES_SCOPE_MACHINE, POLICIES_SCOPE_USER };
+            for (size_t i = 0; i < m_watches.size(); i++)
+            {
+                // The PowerToys key might not exist yet, the Policies key above it does
+                auto& watch = m_watches[i];
+                watch.cache = this;
+                watching = watching &&
+                           RegOpenKeyExW(scopes[i], L"SOFTWARE\\Policies", 0, KEY_NOTIFY, &watch.key) == ERROR_SUCCESS &&
+                           (watch.event = CreateEventW(nullptr, FALSE, FALSE, nullptr)) != nullptr &&
+                           (watch.wait = CreateThreadpoolWait(OnChange, &watch, nullptr)) != nullptr &&
+                           Arm(watch);
+            }
+
+            // Armed before the first read, so no change is missed
+            Refresh();
+            m_watching = watching;
+        }
+
+        // The machine and user callbacks can run together. Reading and publishing under the lock keeps a
+        // snapshot read before a change from replacing one read after it.
+        void Refresh()
+        {
+            std::scoped_lock lock{ m_refresh_mutex };
+            m_snapshot.store(readPolicySnapshot());
+        }
+
+        static bool Arm(Watch& watch)
+        {
+            if (RegNotifyChangeKeyValue(watch.key, TRUE, REG_NOTIFY_CHANGE_NAME | REG_NOTIFY_CHANGE_LAST_SET | REG_NOTIFY_THREAD_AGNOSTIC, watch.event, TRUE) != ERROR_SUCCESS)
+            {
+                return false;
+            }
+            SetThreadpoolWait(watch.wait, watch.event, nullptr);
+            return true;
+        }
+
+        static void CALLBACK OnChange(PTP_CALLBACK_INSTANCE, PVOID context, PTP_WAIT, TP_WAIT_RESULT)
+        {
+            auto& watch = *static_cast<Watch*>(context);
+            if (!Arm(watch))
+            {
+                watch.cache->m_watching = false;
+                return;
             }
+            watch.cache->Refresh();
         }
 
-        switch (value)
+        std::array<Watch, 2> m_watches;
+        std::mutex m_refresh_mutex;
+        std::atomic<std::shared_ptr<const PolicySnapshot>> m_snapshot;
+        std::atomic<bool> m_watching = false;
+    };
+
+    // Keeps the policies in memory and current, so the getters don't go to the registry. For the runner and
+    // the module processes, never for DLLs loaded into other processes like the shell extensions: the watches
+    // can't be stopped and would keep the DLL in use.
+    inline void watchPolicyChanges()
+    {
+        PolicySnapshotCache::start();
+    }
+
+    // The policies as they're configured now. Without watchPolicyChanges only the value with the given name is
+    // read from the registry.
+    inline std::shared_ptr<const PolicySnapshot> getPolicySnapshot(const std::wstring& registry_value_name)
+    {
+        if (auto cache = PolicySnapshotCache::instance())
         {
-        case 0:
-            return gpo_rule_configured_disabled;
-        case 1:
-            return gpo_rule_configured_enabled;
-        default:
-            return gpo_rule_configured_wrong_value;
+            return cache->current();
         }
+        return std::make_shared<const PolicySnapshot>(readPolicyScope(POLICIES_SCOPE_MACHINE, &registry_value_name), readPolicyScope(POLICIES_SCOPE_USER, &registry_value_name));
+    }
+
+    inline gpo_rule_configured_t getConfiguredValue(const std::wstring& registry_value_name)
+    {
+        return getPolicySnapshot(registry_value_name)->configured(registry_value_name);
     }
 
     inline std::optional<std::wstring> getPolicyListValue(const std::wstring& registry_list_path, const std::wstring& registry_list_value_name)
     {
         // This function returns the value of an entry of an policy list. The user scope is only checked, if the list is not enabled for the machine to not mix the lists.
+        // The lists right below the policies key are in the watched snapshot, others are read from the registry.
+        const std::wstring prefix = POLICIES_PATH + L"\\";
+        auto cache = PolicySnapshotCache::instance();
+        if (cache && registry_list_path.starts_with(prefix) && registry_list_path.find(L'\\', prefix.size()) == std::wstring::npos)
+        {
+            return cache->current()->list_value(std::wstring_view(registry_list_path).substr(prefix.size()), registry_list_value_name);
+        }
 
         HKEY key{};
 
@@ -576,11 +786,7 @@ namespace powertoys_gpo {
     inline std::wstring getConfiguredMwbPolicyDefinedIpMappingRules()
     {
         // Important: HKLM has priority over HKCU
-        auto mapping_rules = readRegistryStringValue(HKEY_LOCAL_MACHINE, POLICIES_PATH, POLICY_MWB_POLICY_DEFINED_IP_MAPPING_RULES, true);
-        if (!mapping_rules.has_value())
-        {
-            mapping_rules = readRegistryStringValue(HKEY_CURRENT_USER, POLICIES_PATH, POLICY_MWB_POLICY_DEFINED_IP_MAPPING_RULES, true);
-        }
+        auto mapping_rules = getPolicySnapshot(POLICY_MWB_POLICY_DEFINED_IP_MAPPING_RULES)->multi_string(POLICY_MWB_POLICY_DEFINED_IP_MAPPING_RULES);
 
         // return value
         if (mapping_rules.has_value())
@@ -0,0 +1,223 @@
+#pragma once
+
+#include <cstdint>
+#include <cwctype>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+
+// The values of the PowerToys policies at one point in time, see gpo.h for how they're read from the registry
+// and kept current. Resolves the machine and user scopes once, so the getters of gpo.h are lookups in memory
+// and don't depend on Windows, which lets the tests feed made up policy sets.
+namespace powertoys_gpo
+{
+    enum gpo_rule_configured_t {
+        gpo_rule_configured_wrong_value = -3, // The policy is set to an unrecognized value
+        gpo_rule_configured_unavailable = -2, // Couldn't access registry
+        gpo_rule_configured_not_configured = -1, // Policy is not configured
+        gpo_rule_configured_disabled = 0, // Policy is disabled
+        gpo_rule_configured_enabled = 1, // Policy is enabled
+    };
+
+    // Registry names are case-insensitive
+    struct PolicyNameHash
+    {
+        using is_transparent = void;
+
+        size_t operator()(std::wstring_view name) const noexcept
+        {
+            size_t hash = 14695981039346656037ull;
+            for (const wchar_t c : name)
+            {
+                hash = (hash ^ static_cast<size_t>(std::towlower(c))) * 1099511628211ull;
+            }
+            return hash;
+        }
+    };
+
+    struct PolicyNameEqual
+    {
+        using is_transparent = void;
+
+        bool operator()(std::wstring_view a, std::wstring_view b) const noexcept
+        {
+            if (a.size() != b.size())
+            {
+                return false;
+            }
+            for (size_t i = 0; i < a.size(); i++)
+            {
+                if (std::towlower(a[i]) != std::towlower(b[i]))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+    };
+
+    template<typename T>
+    using PolicyNameMap = std::unordered_map<std::wstring, T, PolicyNameHash, PolicyNameEqual>;
+
+    struct PolicyValue
+    {
+        enum class Type
+        {
+            Dword,
+            String,
+            MultiString, // The strings joined by "\r\n"
+            Other,
+        };
+
+        Type type = Type::Other;
+        uint32_t dword = 0;
+        std::wstring text;
+    };
+
+    // The policy values of one registry scope, HKLM or HKCU
+    struct PolicyScope
+    {
+        enum class State
+        {
+            Found,
+            NotFound, // The policies key doesn't exist
+            Unavailable, // The policies key couldn't be read
+        };
+
+        State state = State::NotFound;
+        PolicyNameMap<PolicyValue> values;
+
+        // The values of the list keys below the policies key, by the name of the key
+        PolicyNameMap<PolicyNameMap<PolicyValue>> lists;
+
+        PolicyScope& set_dword(const std::wstring& name, uint32_t value)
+        {
+            state = State::Found;
+            values[name] = { PolicyValue::Type::Dword, value, {} };
+            return *this;
+        }
+
+        PolicyScope& set_string(const std::wstring& name, std::wstring value, bool multi = false)
+        {
+            state = State::Found;
+            values[name] = { multi ? PolicyValue::Type::MultiString : PolicyValue::Type::String, 0, std::move(value) };
+            return *this;
+        }
+
+        PolicyScope& set_list_string(const std::wstring& list, const std::wstring& name, std::wstring value)
+        {
+            state = State::Found;
+            lists[list][name] = { PolicyValue::Type::String, 0, std::move(value) };
+            return *this;
+        }
+    };
+
+    class PolicySnapshot
+    {
+    public:
+        PolicySnapshot() = default;
+
+        PolicySnapshot(const PolicyScope& machine, const PolicyScope& user)
+        {
+            // A value of the machine scope hides the one of the user scope
+            for (const auto* scope : { &user, &machine })
+            {
+                if (scope->state != PolicyScope::State::Found)
+                {
+                    continue;
+                }
+                for (const auto& [name, value] : scope->values)
+                {
+                    m_configured[name] = to_configured(value);
+                    if (value.type == PolicyValue::Type::MultiString)
+                    {
+                        m_multiStrings[name] = value.text;
+                    }
+                }
+            }
+
+            // Lists aren't mixed, the one of the machine scope is used when it exists, even without the value
+            for (const auto* scope : { &user, &machine })
+            {
+                if (scope->state != PolicyScope::State::Found)
+                {
+                    continue;
+                }
+                for (const auto& [listName, list] : scope->lists)
+                {
+                    auto& strings = m_lists[listName];
+                    strings.clear();
+                    for (const auto& [name, value] : list)
+                    {
+                        if (value.type == PolicyValue::Type::String)
+                        {
+                            strings[name] = value.text;
+                        }
+                    }
+                }
+            }
+
+            // What a policy which is set nowhere resolves to, it's only looked for in the user scope then
+            m_unset = user.state == PolicyScope::State::Unavailable ? gpo_rule_configured_unavailable : gpo_rule_configured_not_configured;
+        }
+
+        // The state of a policy with a DWORD value, 0 for disabled and 1 for enabled
+        gpo_rule_configured_t configured(std::wstring_view name) const
+        {
+            const auto it = m_configured.find(name);
+            return it != m_configured.end() ? it->second : m_unset;
+        }
+
+        // A string value of a policy list, nullopt when the list or the value doesn't exist
+        std::optional<std::wstring> list_value(std::wstring_view list, std::wstring_view name) const
+        {
+            const auto it = m_lists.find(list);
+            if (it == m_lists.end())
+            {
+                return std::nullopt;
+            }
+            const auto value = it->second.find(name);
+            if (value == it->second.end())
+            {
+                return std::nullopt;
+            }
+            return value->second;
+        }
+
+        // A policy with a multi-line string value, its lines joined by "\r\n"
+        std::optional<std::wstring> multi_string(std::wstring_view name) const
+        {
+            const auto it = m_multiStrings.find(name);
+            if (it == m_multiStrings.end())
+            {
+                return std::nullopt;
+            }
+            return it->second;
+        }
+
+    private:
+        static gpo_rule_configured_t to_configured(const PolicyValue& value)
+        {
+            if (value.type != PolicyValue::Type::Dword)
+            {
+                return gpo_rule_configured_wrong_value;
+            }
+            switch (value.dword)
+            {
+            case 0:
+                return gpo_rule_configured_disabled;
+            case 1:
+                return gpo_rule_configured_enabled;
+            default:
+                return gpo_rule_configured_wrong_value;
+            }
+        }
+
+        PolicyNameMap<gpo_rule_configured_t> m_configured;
+        PolicyNameMap<std::wstring> m_multiStrings;
+        PolicyNameMap<PolicyNameMap<std::wstring>> m_lists;
+        gpo_rule_configured_t m_unset = gpo_rule_configured_not_configured;
+    };
+}
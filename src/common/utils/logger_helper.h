@@ -81,7 +81,8 @@ namespace LoggerHelpers
         return result;
     }
 
-    inline void init_logger(std::wstring moduleName, std::wstring internalPath, std::string loggerName)
+    // async: see Logger::init
+    inline void init_logger(std::wstring moduleName, std::wstring internalPath, std::string loggerName, bool async = false)
     {
         std::filesystem::path rootFolder(PTSettingsHelper::get_module_save_folder_location(moduleName));
         rootFolder.append(internalPath);
@@ -92,7 +93,7 @@ namespace LoggerHelpers
 
         auto logsPath = currentFolder;
         logsPath.append(L"log.txt");
-        Logger::init(loggerName, logsPath.wstring(), PTSettingsHelper::get_log_settings_file_location());
+        Logger::init(loggerName, logsPath.wstring(), PTSettingsHelper::get_log_settings_file_location(), async);
 
         delete_other_versions_log_folders(rootFolder.wstring(), currentFolder); 
     }
@@ -0,0 +1,1210 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define NATIVE_JSON_SSE2
+#endif
+
+// UTF-8 JSON parser and writer for the settings files read and written on hot paths.
+// Unlike Windows::Data::Json it needs no UTF-16 conversion of the whole file and no COM allocations:
+// the document keeps the file contents, strings without escapes are views into them and
+// the nodes are allocated from one arena, which is released with the document.
+// Accessors follow the JsonObject names and throw json::native::error where JsonObject throws hresult_error.
+namespace json::native
+{
+    class error : public std::runtime_error
+    {
+    public:
+        using std::runtime_error::runtime_error;
+    };
+
+    enum class Type : uint8_t
+    {
+        Null,
+        Bool,
+        Number,
+        String,
+        Array,
+        Object,
+    };
+
+    class Value;
+    struct Member;
+
+    namespace details
+    {
+        // Bump allocator for the nodes and unescaped strings of a document
+        class Arena
+        {
+        public:
+            Arena() = default;
+            Arena(const Arena&) = delete;
+            Arena& operator=(const Arena&) = delete;
+
+            template<typename T>
+            T* allocate(size_t count)
+            {
+                static_assert(std::is_trivially_destructible_v<T>);
+                const size_t size = sizeof(T) * count;
+                size_t padding = (alignof(T) - reinterpret_cast<uintptr_t>(m_current) % alignof(T)) % alignof(T);
+                if (m_current == nullptr || size + padding > m_remaining)
+                {
+                    const size_t blockSize = (std::max)(size + alignof(T), m_nextBlockSize);
+                    m_blocks.push_back(std::make_unique<std::byte[]>(blockSize));
+                    m_current = m_blocks.back().get();
+                    m_remaining = blockSize;
+                    m_nextBlockSize = (std::min)(m_nextBlockSize * 2, size_t{ 1 } << 20);
+                    padding = (alignof(T) - reinterpret_cast<uintptr_t>(m_current) % alignof(T)) % alignof(T);
+                }
+
+                T* result = reinterpret_cast<T*>(m_current + padding);
+                m_current += padding + size;
+                m_remaining -= padding + size;
+                return result;
+            }
+
+        private:
+            std::vector<std::unique_ptr<std::byte[]>> m_blocks;
+            std::byte* m_current = nullptr;
+            size_t m_remaining = 0;
+            size_t m_nextBlockSize = 4096;
+        };
+
+        inline void append_utf8(std::string& out, char32_t c)
+        {
+            if (c < 0x80)
+            {
+                out.push_back(static_cast<char>(c));
+            }
+            else if (c < 0x800)
+            {
+                out.push_back(static_cast<char>(0xC0 | (c >> 6)));
+                out.push_back(static_cast<char>(0x80 | (c & 0x3F)));
+            }
+            else if (c < 0x10000)
+            {
+                out.push_back(static_cast<char>(0xE0 | (c >> 12)));
+                out.push_back(static_cast<char>(0x80 | ((c >> 6) & 0x3F)));
+                out.push_back(static_cast<char>(0x80 | (c & 0x3F)));
+            }
+            else
+            {
+                out.push_back(static_cast<char>(0xF0 | (c >> 18)));
+                out.push_back(static_cast<char>(0x80 | ((c >> 12) & 0x3F)));
+                out.push_back(static_cast<char>(0x80 | ((c >> 6) & 0x3F)));
+                out.push_back(static_cast<char>(0x80 | (c & 0x3F)));
+            }
+        }
+
+        inline void append_wide(std::wstring& out, char32_t c)
+        {
+            if constexpr (sizeof(wchar_t) == 2)
+            {
+                if (c >= 0x10000)
+                {
+                    c -= 0x10000;
+                    out.push_back(static_cast<wchar_t>(0xD800 | (c >> 10)));
+                    out.push_back(static_cast<wchar_t>(0xDC00 | (c & 0x3FF)));
+                    return;
+                }
+            }
+            out.push_back(static_cast<wchar_t>(c));
+        }
+
+        // Decodes the code point at text[pos] and advances pos, invalid sequences decode to U+FFFD
+        inline char32_t next_utf8(std::string_view text, size_t& pos)
+        {
+            const auto lead = static_cast<unsigned char>(text[pos++]);
+            if (lead < 0x80)
+            {
+                return lead;
+            }
+
+            size_t length;
+            char32_t c;
+            char32_t min;
+            if ((lead & 0xE0) == 0xC0)
+            {
+                length = 1, c = lead & 0x1F, min = 0x80;
+            }
+            else if ((lead & 0xF0) == 0xE0)
+            {
+                length = 2, c = lead & 0x0F, min = 0x800;
+            }
+            else if ((lead & 0xF8) == 0xF0)
+            {
+                length = 3, c = lead & 0x07, min = 0x10000;
+            }
+            else
+            {
+                return 0xFFFD;
+            }
+
+            for (size_t i = 0; i < length; i++)
+            {
+                if (pos == text.size() || (static_cast<unsigned char>(text[pos]) & 0xC0) != 0x80)
+                {
+                    return 0xFFFD;
+                }
+                c = (c << 6) | (static_cast<unsigned char>(text[pos++]) & 0x3F);
+            }
+
+            if (c < min || c > 0x10FFFF || (c >= 0xD800 && c <= 0xDFFF))
+            {
+                return 0xFFFD;
+            }
+            return c;
+        }
+
+        // Decodes the code point at text[pos] and advances pos, unpaired surrogates decode to U+FFFD
+        inline char32_t next_wide(std::wstring_view text, size_t& pos)
+        {
+            char32_t c = static_cast<char32_t>(text[pos++]);
+            if constexpr (sizeof(wchar_t) == 2)
+            {
+                if (c >= 0xD800 && c <= 0xDBFF && pos < text.size() && text[pos] >= 0xDC00 && text[pos] <= 0xDFFF)
+                {
+                    return 0x10000 + ((c - 0xD800) << 10) + (static_cast<char32_t>(text[pos++]) - 0xDC00);
+                }
+            }
+            if (c >= 0xD800 && c <= 0xDFFF)
+            {
+                return 0xFFFD;
+            }
+            return c;
+        }
+
+        inline std::wstring to_wide(std::string_view text)
+        {
+            std::wstring result;
+            result.reserve(text.size());
+            for (size_t pos = 0; pos < text.size();)
+            {
+                append_wide(result, next_utf8(text, pos));
+            }
+            return result;
+        }
+
+        inline void append_utf8(std::string& out, std::wstring_view text)
+        {
+            for (size_t pos = 0; pos < text.size();)
+            {
+                append_utf8(out, next_wide(text, pos));
+            }
+        }
+
+        // Compares without converting as long as both names are ASCII, which settings keys are
+        inline bool equals(std::string_view utf8, std::wstring_view wide)
+        {
+            const size_t length = (std::min)(utf8.size(), wide.size());
+            size_t i = 0;
+            for (; i < length; i++)
+            {
+                const auto c = static_cast<unsigned char>(utf8[i]);
+                if (c >= 0x80 || wide[i] >= 0x80)
+                {
+                    break;
+                }
+                if (c != static_cast<unsigned char>(wide[i]))
+                {
+                    return false;
+                }
+            }
+
+            if (i == utf8.size() || i == wide.size())
+            {
+                return utf8.size() == wide.size();
+            }
+            return to_wide(utf8.substr(i)) == wide.substr(i);
+        }
+
+        inline bool is_whitespace(char c)
+        {
+            return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+        }
+
+        inline const char* skip_whitespace(const char* p, const char* end)
+        {
+#ifdef NATIVE_JSON_SSE2
+            // Settings files are indented, so whitespace comes in runs
+            while (end - p >= 16 && is_whitespace(*p))
+            {
+                const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+                const __m128i spaces = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\n'))),
+                                                    _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('\r')), _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\t'))));
+                const unsigned mask = ~static_cast<unsigned>(_mm_movemask_epi8(spaces)) & 0xFFFF;
+                if (mask != 0)
+                {
+                    return p + std::countr_zero(mask);
+                }
+                p += 16;
+            }
+#endif
+            while (p != end && is_whitespace(*p))
+            {
+                p++;
+            }
+            return p;
+        }
+
+        // Returns the first quote, backslash or control character of a string body
+        inline const char* find_string_special(const char* p, const char* end)
+        {
+#ifdef NATIVE_JSON_SSE2
+            const __m128i quote = _mm_set1_epi8('"');
+            const __m128i backslash = _mm_set1_epi8('\\');
+            const __m128i lastControl = _mm_set1_epi8(0x1F);
+            while (end - p >= 16)
+            {
+                const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+                // bytes <= 0x1F are the ones that don't change when clamped to 0x1F
+                const __m128i control = _mm_cmpeq_epi8(_mm_min_epu8(chunk, lastControl), chunk);
+                const __m128i special = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)), control);
+                const unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(special));
+                if (mask != 0)
+                {
+                    return p + std::countr_zero(mask);
+                }
+                p += 16;
+            }
+#endif
+            while (p != end && *p != '"' && *p != '\\' && static_cast<unsigned char>(*p) >= 0x20)
+            {
+                p++;
+            }
+            return p;
+        }
+
+        class Parser;
+    }
+
+    class Value
+    {
+    public:
+        Type type() const noexcept { return m_type; }
+        bool is_null() const noexcept { return m_type == Type::Null; }
+        bool is_bool() const noexcept { return m_type == Type::Bool; }
+        bool is_number() const noexcept { return m_type == Type::Number; }
+        bool is_string() const noexcept { return m_type == Type::String; }
+        bool is_array() const noexcept { return m_type == Type::Array; }
+        bool is_object() const noexcept { return m_type == Type::Object; }
+
+        bool get_boolean() const
+        {
+            expect(Type::Bool);
+            return m_boolean;
+        }
+
+        double get_number() const
+        {
+            expect(Type::Number);
+            double result = 0;
+            std::from_chars(m_text, m_text + m_size, result);
+            return result;
+        }
+
+        // The UTF-8 text of a string, valid as long as the document
+        std::string_view get_utf8() const
+        {
+            expect(Type::String);
+            return { m_text, m_size };
+        }
+
+        std::wstring get_string() const
+        {
+            return details::to_wide(get_utf8());
+        }
+
+        // Number of items of an array or members of an object
+        size_t size() const
+        {
+            if (m_type != Type::Array && m_type != Type::Object)
+            {
+                throw error("json value is not an array or object");
+            }
+            return m_size;
+        }
+
+        // Items of an array
+        const Value* begin() const
+        {
+            expect(Type::Array);
+            return m_items;
+        }
+
+        const Value* end() const
+        {
+            return begin() + m_size;
+        }
+
+        const Value& operator[](size_t index) const
+        {
+            if (index >= size())
+            {
+                throw error("json array index out of range");
+            }
+            return begin()[index];
+        }
+
+        // Members of an object, in the order of the document
+        std::span<const Member> members() const;
+
+        // nullptr if the object has no member with the name
+        const Value* find(std::wstring_view name) const;
+        const Value* find(std::string_view name) const;
+
+        bool has_key(std::wstring_view name) const
+        {
+            return find(name) != nullptr;
+        }
+
+        const Value& get_named_value(std::wstring_view name) const
+        {
+            if (auto value = find(name))
+            {
+                return *value;
+            }
+            throw error("json object has no such member");
+        }
+
+        std::wstring get_named_string(std::wstring_view name) const
+        {
+            return get_named_value(name).get_string();
+        }
+
+        // The defaults are used when the member is missing, a member of another type still throws
+        std::wstring get_named_string(std::wstring_view name, std::wstring_view default_value) const
+        {
+            auto value = find(name);
+            return value ? value->get_string() : std::wstring{ default_value };
+        }
+
+        double get_named_number(std::wstring_view name) const
+        {
+            return get_named_value(name).get_number();
+        }
+
+        double get_named_number(std::wstring_view name, double default_value) const
+        {
+            auto value = find(name);
+            return value ? value->get_number() : default_value;
+        }
+
+        bool get_named_boolean(std::wstring_view name) const
+        {
+            return get_named_value(name).get_boolean();
+        }
+
+        bool get_named_boolean(std::wstring_view name, bool default_value) const
+        {
+            auto value = find(name);
+            return value ? value->get_boolean() : default_value;
+        }
+
+        const Value& get_named_object(std::wstring_view name) const
+        {
+            const auto& value = get_named_value(name);
+            value.expect(Type::Object);
+            return value;
+        }
+
+        const Value& get_named_array(std::wstring_view name) const
+        {
+            const auto& value = get_named_value(name);
+            value.expect(Type::Array);
+            return value;
+        }
+
+    private:
+        friend class details::Parser;
+
+        void expect(Type type) const
+        {
+            if (m_type != type)
+            {
+                throw error("json value has another type");
+            }
+        }
+
+        Type m_type = Type::Null;
+        bool m_boolean = false;
+        uint32_t m_size = 0;
+        union
+        {
+            // string contents or number text
+            const char* m_text = nullptr;
+            const Value* m_items;
+            const Member* m_members;
+        };
+    };
+
+    struct Member
+    {
+        std::string_view name;
+        Value value;
+    };
+
+    inline std::span<const Member> Value::members() const
+    {
+        expect(Type::Object);
+        return { m_members, m_size };
+    }
+
+    inline const Value* Value::find(std::wstring_view name) const
+    {
+        expect(Type::Object);
+        for (size_t i = 0; i < m_size; i++)
+        {
+            if (details::equals(m_members[i].name, name))
+            {
+                return &m_members[i].value;
+            }
+        }
+        return nullptr;
+    }
+
+    inline const Value* Value::find(std::string_view name) const
+    {
+        expect(Type::Object);
+        for (size_t i = 0; i < m_size; i++)
+        {
+            if (m_members[i].name == name)
+            {
+                return &m_members[i].value;
+            }
+        }
+        return nullptr;
+    }
+
+    // A parsed document, owns the text and the nodes the values point into
+    class Document
+    {
+    public:
+        // nullopt if the text is not valid JSON
+        static std::optional<Document> parse(std::string text);
+
+        const Value& root() const noexcept
+        {
+            return m_state->root;
+        }
+
+    private:
+        Document() = default;
+
+        // Kept on the heap, so the views stay valid when the document is moved
+        struct State
+        {
+            std::string text;
+            details::Arena arena;
+            Value root;
+        };
+
+        std::unique_ptr<State> m_state;
+    };
+
+    namespace details
+    {
+        class Parser
+        {
+        public:
+            Parser(const std::string& text, Arena& arena) :
+                m_p(text.data()), m_end(text.data() + text.size()), m_arena(arena)
+            {
+            }
+
+            bool parse_document(Value& root)
+            {
+                if (!parse_value(root, 0))
+                {
+                    return false;
+                }
+                m_p = skip_whitespace(m_p, m_end);
+                return m_p == m_end;
+            }
+
+        private:
+            // Deeper documents are rejected instead of running out of stack
+            static constexpr int maxDepth = 256;
+
+            bool parse_value(Value& value, int depth)
+            {
+                m_p = skip_whitespace(m_p, m_end);
+                if (m_p == m_end)
+                {
+                    return false;
+                }
+
+                switch (*m_p)
+                {
+                case '{':
+                    return depth < maxDepth && parse_object(value, depth + 1);
+                case '[':
+                    return depth < maxDepth && parse_array(value, depth + 1);
+                case '"':
+                {
+                    value.m_type = Type::String;
+                    std::string_view text;
+                    if (!parse_string(text))
+                    {
+                        return false;
+                    }
+                    value.m_text = text.data();
+                    value.m_size = static_cast<uint32_t>(text.size());
+                    return true;
+                }
+                case 't':
+                    value.m_type = Type::Bool;
+                    value.m_boolean = true;
+                    return parse_literal("true");
+                case 'f':
+                    value.m_type = Type::Bool;
+                    value.m_boolean = false;
+                    return parse_literal("false");
+                case 'n':
+                    value.m_type = Type::Null;
+                    return parse_literal("null");
+                default:
+                    return parse_number(value);
+                }
+            }
+
+            bool parse_literal(std::string_view literal)
+            {
+                if (static_cast<size_t>(m_end - m_p) < literal.size() || std::string_view(m_p, literal.size()) != literal)
+                {
+                    return false;
+                }
+                m_p += literal.size();
+                return true;
+            }
+
+            static bool is_digit(char c)
+            {
+                return c >= '0' && c <= '9';
+            }
+
+            // Only checks the grammar, the text is converted when the number is read
+            bool parse_number(Value& value)
+            {
+                const char* start = m_p;
+                if (m_p != m_end && *m_p == '-')
+                {
+                    m_p++;
+                }
+
+                if (m_p == m_end || !is_digit(*m_p))
+                {
+                    return false;
+                }
+                if (*m_p == '0')
+                {
+                    m_p++;
+                }
+                else
+                {
+                    while (m_p != m_end && is_digit(*m_p))
+                    {
+                        m_p++;
+                    }
+                }
+
+                if (m_p != m_end && *m_p == '.')
+                {
+                    m_p++;
+                    if (m_p == m_end || !is_digit(*m_p))
+                    {
+                        return false;
+                    }
+                    while (m_p != m_end && is_digit(*m_p))
+                    {
+                        m_p++;
+                    }
+                }
+
+                if (m_p != m_end && (*m_p == 'e' || *m_p == 'E'))
+                {
+                    m_p++;
+                    if (m_p != m_end && (*m_p == '+' || *m_p == '-'))
+                    {
+                        m_p++;
+                    }
+                    if (m_p == m_end || !is_digit(*m_p))
+                    {
+                        return false;
+                    }
+                    while (m_p != m_end && is_digit(*m_p))
+                    {
+                        m_p++;
+                    }
+                }
+
+                value.m_type = Type::Number;
+                value.m_text = start;
+                value.m_size = static_cast<uint32_t>(m_p - start);
+                return true;
+            }
+
+            bool parse_hex4(char32_t& result)
+            {
+                if (m_end - m_p < 4)
+                {
+                    return false;
+                }
+
+                result = 0;
+                for (int i = 0; i < 4; i++)
+                {
+                    const char c = *m_p++;
+                    result <<= 4;
+                    if (is_digit(c))
+                    {
+                        result |= c - '0';
+                    }
+                    else if (c >= 'a' && c <= 'f')
+                    {
+                        result |= c - 'a' + 10;
+                    }
+                    else if (c >= 'A' && c <= 'F')
+                    {
+                        result |= c - 'A' + 10;
+                    }
+                    else
+                    {
+                        return false;
+                    }
+                }
+                return true;
+            }
+
+            // Strings without escapes point into the document text, the others are unescaped into the arena
+            bool parse_string(std::string_view& result)
+            {
+                const char* start = ++m_p;
+                m_p = find_string_special(m_p, m_end);
+                if (m_p != m_end && *m_p == '"')
+                {
+                    result = { start, static_cast<size_t>(m_p - start) };
+                    m_p++;
+                    return true;
+                }
+
+                m_unescaped.assign(start, m_p);
+                while (m_p != m_end)
+                {
+                    const char c = *m_p++;
+                    if (c == '"')
+                    {
+                        char* copy = m_arena.allocate<char>(m_unescaped.size() + 1);
+                        std::memcpy(copy, m_unescaped.data(), m_unescaped.size());
+                        result = { copy, m_unescaped.size() };
+                        return true;
+                    }
+                    if (static_cast<unsigned char>(c) < 0x20 || m_p == m_end)
+                    {
+                        return false;
+                    }
+                    if (c != '\\')
+                    {
+                        m_unescaped.push_back(c);
+                        continue;
+                    }
+
+                    switch (*m_p++)
+                    {
+                    case '"':
+                        m_unescaped.push_back('"');
+                        break;
+                    case '\\':
+                        m_unescaped.push_back('\\');
+                        break;
+                    case '/':
+                        m_unescaped.push_back('/');
+                        break;
+                    case 'b':
+                        m_unescaped.push_back('\b');
+                        break;
+                    case 'f':
+                        m_unescaped.push_back('\f');
+                        break;
+                    case 'n':
+                        m_unescaped.push_back('\n');
+                        break;
+                    case 'r':
+                        m_unescaped.push_back('\r');
+                        break;
+                    case 't':
+                        m_unescaped.push_back('\t');
+                        break;
+                    case 'u':
+                    {
+                        char32_t c32;
+                        if (!parse_hex4(c32))
+                        {
+                            return false;
+                        }
+                        if (c32 >= 0xD800 && c32 <= 0xDBFF)
+                        {
+                            char32_t low;
+                            if (m_end - m_p >= 6 && m_p[0] == '\\' && m_p[1] == 'u')
+                            {
+                                const char* pairStart = m_p;
+                                m_p += 2;
+                                if (parse_hex4(low) && low >= 0xDC00 && low <= 0xDFFF)
+                                {
+                                    c32 = 0x10000 + ((c32 - 0xD800) << 10) + (low - 0xDC00);
+                                }
+                                else
+                                {
+                                    m_p = pairStart;
+                                    c32 = 0xFFFD;
+                                }
+                            }
+                            else
+                            {
+                                c32 = 0xFFFD;
+                            }
+                        }
+                        else if (c32 >= 0xDC00 && c32 <= 0xDFFF)
+                        {
+                            c32 = 0xFFFD;
+                        }
+                        append_utf8(m_unescaped, c32);
+                        break;
+                    }
+                    default:
+                        return false;
+                    }
+
+                    // copy the run up to the next escape at once
+                    const char* run = m_p;
+                    m_p = find_string_special(m_p, m_end);
+                    m_unescaped.append(run, m_p);
+                }
+                return false;
+            }
+
+            bool parse_array(Value& value, int depth)
+            {
+                m_p++;
+                const size_t base = m_items.size();
+                m_p = skip_whitespace(m_p, m_end);
+                if (m_p != m_end && *m_p == ']')
+                {
+                    m_p++;
+                }
+                else
+                {
+                    while (true)
+                    {
+                        // the items of nested arrays are taken off the stack before the next item is pushed
+                        Value item;
+                        if (!parse_value(item, depth))
+                        {
+                            return false;
+                        }
+                        m_items.push_back(item);
+
+                        m_p = skip_whitespace(m_p, m_end);
+                        if (m_p == m_end)
+                        {
+                            return false;
+                        }
+                        if (*m_p++ == ']')
+                        {
+                            break;
+                        }
+                        if (m_p[-1] != ',')
+                        {
+                            return false;
+                        }
+                    }
+                }
+
+                const size_t count = m_items.size() - base;
+                Value* items = m_arena.allocate<Value>(count);
+                std::uninitialized_copy(m_items.begin() + base, m_items.end(), items);
+                m_items.resize(base);
+
+                value.m_type = Type::Array;
+                value.m_size = static_cast<uint32_t>(count);
+                value.m_items = items;
+                return true;
+            }
+
+            bool parse_object(Value& value, int depth)
+            {
+                m_p++;
+                const size_t base = m_members.size();
+                m_p = skip_whitespace(m_p, m_end);
+                if (m_p != m_end && *m_p == '}')
+                {
+                    m_p++;
+                }
+                else
+                {
+                    while (true)
+                    {
+                        Member member;
+                        m_p = skip_whitespace(m_p, m_end);
+                        if (m_p == m_end || *m_p != '"' || !parse_string(member.name))
+                        {
+                            return false;
+                        }
+
+                        m_p = skip_whitespace(m_p, m_end);
+                        if (m_p == m_end || *m_p++ != ':')
+                        {
+                            return false;
+                        }
+
+                        if (!parse_value(member.value, depth))
+                        {
+                            return false;
+                        }
+                        m_members.push_back(member);
+
+                        m_p = skip_whitespace(m_p, m_end);
+                        if (m_p == m_end)
+                        {
+                            return false;
+                        }
+                        if (*m_p++ == '}')
+                        {
+                            break;
+                        }
+                        if (m_p[-1] != ',')
+                        {
+                            return false;
+                        }
+                    }
+                }
+
+                const size_t count = m_members.size() - base;
+                Member* members = m_arena.allocate<Member>(count);
+                std::uninitialized_copy(m_members.begin() + base, m_members.end(), members);
+                m_members.resize(base);
+
+                value.m_type = Type::Object;
+                value.m_size = static_cast<uint32_t>(count);
+                value.m_members = members;
+                return true;
+            }
+
+            const char* m_p;
+            const char* m_end;
+            Arena& m_arena;
+
+            // children of the arrays and objects being parsed, copied to the arena once complete
+            std::vector<Value> m_items;
+            std::vector<Member> m_members;
+            std::string m_unescaped;
+        };
+    }
+
+    inline std::optional<Document> Document::parse(std::string text)
+    {
+        Document document;
+        document.m_state = std::make_unique<State>();
+        document.m_state->text = std::move(text);
+
+        details::Parser parser(document.m_state->text, document.m_state->arena);
+        if (!parser.parse_document(document.m_state->root))
+        {
+            return std::nullopt;
+        }
+        return document;
+    }
+
+    // nullopt if the file is missing or not valid JSON
+    inline std::optional<Document> from_file(std::wstring_view file_name)
+    {
+        std::ifstream file(std::filesystem::path(file_name), std::ios::binary | std::ios::ate);
+        if (!file.is_open())
+        {
+            return std::nullopt;
+        }
+
+        std::string text(static_cast<size_t>(file.tellg()), '\0');
+        file.seekg(0);
+        if (!file.read(text.data(), text.size()))
+        {
+            return std::nullopt;
+        }
+
+        // skip the byte order mark some editors add
+        if (text.starts_with("\xEF\xBB\xBF"))
+        {
+            text.erase(0, 3);
+        }
+        return Document::parse(std::move(text));
+    }
+
+    // Writes compact UTF-8 JSON, members in the order they are written
+    class Writer
+    {
+    public:
+        Writer& begin_object()
+        {
+            separator();
+            m_out.push_back('{');
+            m_first.push_back(true);
+            return *this;
+        }
+
+        Writer& end_object()
+        {
+            m_out.push_back('}');
+            m_first.pop_back();
+            return *this;
+        }
+
+        Writer& begin_array()
+        {
+            separator();
+            m_out.push_back('[');
+            m_first.push_back(true);
+            return *this;
+        }
+
+        Writer& end_array()
+        {
+            m_out.push_back(']');
+            m_first.pop_back();
+            return *this;
+        }
+
+        // Name of the next member of the object
+        Writer& key(std::wstring_view name)
+        {
+            separator();
+            write_string(name);
+            m_out.push_back(':');
+            m_afterKey = true;
+            return *this;
+        }
+
+        Writer& key(const wchar_t* name)
+        {
+            return key(std::wstring_view{ name });
+        }
+
+        Writer& value(std::wstring_view text)
+        {
+            separator();
+            write_string(text);
+            return *this;
+        }
+
+        Writer& value(const wchar_t* text)
+        {
+            return value(std::wstring_view{ text });
+        }
+
+        Writer& value(const std::wstring& text)
+        {
+            return value(std::wstring_view{ text });
+        }
+
+        Writer& value(bool boolean)
+        {
+            separator();
+            m_out.append(boolean ? "true" : "false");
+            return *this;
+        }
+
+        Writer& value(std::nullptr_t)
+        {
+            separator();
+            m_out.append("null");
+            return *this;
+        }
+
+        template<typename T>
+            requires(std::is_arithmetic_v<T> && !std::is_same_v<T, bool>)
+        Writer& value(T number)
+        {
+            separator();
+            char buffer[32];
+            std::to_chars_result result;
+            if constexpr (std::is_floating_point_v<T>)
+            {
+                // JSON has no infinity or NaN, they are written as null
+                if (!std::isfinite(number))
+                {
+                    m_out.append("null");
+                    return *this;
+                }
+
+                // whole numbers are written without a fraction, like JsonObject does. The range is checked
+                // first, converting a number int64_t can't hold is undefined.
+                if (number > -1e15 && number < 1e15 && number == static_cast<T>(static_cast<int64_t>(number)))
+                {
+                    result = std::to_chars(buffer, buffer + sizeof(buffer), static_cast<int64_t>(number));
+                }
+                else
+                {
+                    result = std::to_chars(buffer, buffer + sizeof(buffer), number);
+                }
+            }
+            else
+            {
+                result = std::to_chars(buffer, buffer + sizeof(buffer), number);
+            }
+            m_out.append(buffer, result.ptr);
+            return *this;
+        }
+
+        // Writes already serialized JSON as the next value
+        Writer& raw_value(std::string_view json)
+        {
+            separator();
+            m_out.append(json);
+            return *this;
+        }
+
+        template<typename Name, typename T>
+        Writer& member(Name&& name, T&& member_value)
+        {
+            key(std::forward<Name>(name));
+            return value(std::forward<T>(member_value));
+        }
+
+        const std::string& str() const noexcept
+        {
+            return m_out;
+        }
+
+        std::string release() noexcept
+        {
+            return std::move(m_out);
+        }
+
+    private:
+        void separator()
+        {
+            if (m_afterKey)
+            {
+                m_afterKey = false;
+                return;
+            }
+
+            if (!m_first.empty())
+            {
+                if (!m_first.back())
+                {
+                    m_out.push_back(',');
+                }
+                m_first.back() = false;
+            }
+        }
+
+        void write_string(std::wstring_view text)
+        {
+            static constexpr char hex[] = "0123456789ABCDEF";
+
+            m_out.push_back('"');
+            for (size_t pos = 0; pos < text.size();)
+            {
+                const char32_t c = details::next_wide(text, pos);
+                switch (c)
+                {
+                case '"':
+                    m_out.append("\\\"");
+                    break;
+                case '\\':
+                    m_out.append("\\\\");
+                    break;
+                case '\b':
+                    m_out.append("\\b");
+                    break;
+                case '\f':
+                    m_out.append("\\f");
+                    break;
+                case '\n':
+                    m_out.append("\\n");
+                    break;
+                case '\r':
+                    m_out.append("\\r");
+                    break;
+                case '\t':
+                    m_out.append("\\t");
+                    break;
+                default:
+                    if (c < 0x20)
+                    {
+                        m_out.append("\\u00");
+                        m_out.push_back(hex[c >> 4]);
+                        m_out.push_back(hex[c & 0xF]);
+                    }
+                    else
+                    {
+                        details::append_utf8(m_out, c);
+                    }
+                }
+            }
+            m_out.push_back('"');
+        }
+
+        std::string m_out;
+        std::vector<bool> m_first;
+        bool m_afterKey = false;
+    };
+
+    inline bool to_file(std::wstring_view file_name, std::string_view text)
+    {
+        std::ofstream file(std::filesystem::path(file_name), std::ios::binary);
+        return file.write(text.data(), text.size()).good();
+    }
+
+    // Same as json::get for a native value
+    template<typename T, typename D = std::optional<T>>
+        requires std::constructible_from<std::optional<T>, D>
+    void get(const Value& o, const wchar_t* name, T& destination, D default_value = std::nullopt)
+    {
+        try
+        {
+            if constexpr (std::is_same_v<T, bool>)
+            {
+                destination = o.get_named_boolean(name);
+            }
+            else if constexpr (std::is_arithmetic_v<T>)
+            {
+                destination = static_cast<T>(o.get_named_number(name));
+            }
+            else if constexpr (std::is_same_v<T, std::wstring>)
+            {
+                destination = o.get_named_string(name);
+            }
+            else
+            {
+                static_assert(std::bool_constant<std::is_same_v<T, T&>>::value, "Unsupported type");
+            }
+        }
+        catch (...)
+        {
+            std::optional<T> maybe_default{ std::move(default_value) };
+            if (maybe_default.has_value())
+                destination = std::move(*maybe_default);
+        }
+    }
+}
@@ -0,0 +1,399 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Streaming decoder for QOI images (https://qoiformat.org/qoi-specification.pdf) which scales the image down
+// to thumbnail size while decoding, so neither the encoded file nor the full size image is kept in memory.
+// Doesn't depend on Windows, the caller supplies the bytes and gets BGRA rows the size of a DIB section.
+namespace qoi
+{
+    struct Header
+    {
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint8_t channels = 0;
+        uint8_t colorspace = 0;
+    };
+
+    // 32 bit BGRA with straight alpha, rows top-down without padding
+    struct Image
+    {
+        uint32_t width = 0;
+        uint32_t height = 0;
+        std::vector<uint8_t> bgra;
+    };
+
+    // Same limit as the reference decoder
+    inline constexpr uint64_t max_pixels = 400'000'000;
+
+    // Fills up to size bytes and returns how many were written, 0 at the end of the data or on errors
+    template<typename T>
+    concept Reader = requires(T reader, uint8_t* buffer, size_t size) {
+        { reader(buffer, size) } -> std::convertible_to<size_t>;
+    };
+
+    inline constexpr size_t header_size = 14;
+
+    // nullopt if the bytes aren't the header of an image the decoder accepts
+    inline std::optional<Header> parse_header(const uint8_t (&bytes)[header_size])
+    {
+        if (bytes[0] != 'q' || bytes[1] != 'o' || bytes[2] != 'i' || bytes[3] != 'f')
+        {
+            return std::nullopt;
+        }
+
+        auto be32 = [](const uint8_t* p) {
+            return uint32_t{ p[0] } << 24 | uint32_t{ p[1] } << 16 | uint32_t{ p[2] } << 8 | p[3];
+        };
+
+        Header header{ be32(bytes + 4), be32(bytes + 8), bytes[12], bytes[13] };
+        if (header.width == 0 || header.height == 0 || header.channels < 3 || header.channels > 4 || header.colorspace > 1 ||
+            uint64_t{ header.width } * header.height > max_pixels)
+        {
+            return std::nullopt;
+        }
+        return header;
+    }
+
+    // Size of an image of width x height scaled down to fit max_size x max_size, keeping the aspect ratio.
+    // Images which already fit keep their size.
+    inline std::pair<uint32_t, uint32_t> fit_size(uint32_t width, uint32_t height, uint32_t max_size)
+    {
+        if (width <= max_size && height <= max_size)
+        {
+            return { width, height };
+        }
+
+        if (width >= height)
+        {
+            const auto scaled = static_cast<uint32_t>((uint64_t{ height } * max_size + width / 2) / width);
+            return { max_size, (std::max)(scaled, 1u) };
+        }
+
+        const auto scaled = static_cast<uint32_t>((uint64_t{ width } * max_size + height / 2) / height);
+        return { (std::max)(scaled, 1u), max_size };
+    }
+
+    namespace details
+    {
+        struct Rgba
+        {
+            uint8_t r;
+            uint8_t g;
+            uint8_t b;
+            uint8_t a;
+        };
+
+        inline uint8_t hash(Rgba px)
+        {
+            return (px.r * 3 + px.g * 5 + px.b * 7 + px.a * 11) % 64;
+        }
+
+        // Buffers the reader, so the decoding loop reads one byte at a time from memory
+        template<Reader R>
+        class Source
+        {
+        public:
+            explicit Source(R& reader) :
+                m_reader(reader), m_buffer(64 * 1024)
+            {
+            }
+
+            bool next(uint8_t& byte)
+            {
+                if (m_position == m_size && !fill())
+                {
+                    return false;
+                }
+                byte = m_buffer[m_position++];
+                return true;
+            }
+
+            bool next(uint8_t* bytes, size_t count)
+            {
+                for (size_t i = 0; i < count; i++)
+                {
+                    if (!next(bytes[i]))
+                    {
+                        return false;
+                    }
+                }
+                return true;
+            }
+
+        private:
+            bool fill()
+            {
+                m_position = 0;
+                m_size = (std::min)(static_cast<size_t>(m_reader(m_buffer.data(), m_buffer.size())), m_buffer.size());
+                return m_size != 0;
+            }
+
+            R& m_reader;
+            std::vector<uint8_t> m_buffer;
+            size_t m_position = 0;
+            size_t m_size = 0;
+        };
+
+        // Box filter for one destination row. Colors are weighted by alpha, so transparent pixels don't darken
+        // the edges they're averaged into.
+        class RowAccumulator
+        {
+        public:
+            RowAccumulator(uint32_t sourceWidth, uint32_t width) :
+                m_sourceWidth(sourceWidth), m_sums(width)
+            {
+            }
+
+            void begin_row()
+            {
+                m_x = 0;
+                m_next = next_boundary(0);
+            }
+
+            void add(Rgba px, uint32_t x)
+            {
+                if (x == m_next)
+                {
+                    m_x++;
+                    m_next = next_boundary(m_x);
+                }
+
+                auto& sum = m_sums[m_x];
+                sum.b += uint64_t{ px.b } * px.a;
+                sum.g += uint64_t{ px.g } * px.a;
+                sum.r += uint64_t{ px.r } * px.a;
+                sum.a += px.a;
+                sum.count++;
+            }
+
+            void flush(uint8_t* bgra)
+            {
+                for (auto& sum : m_sums)
+                {
+                    if (sum.a != 0)
+                    {
+                        bgra[0] = static_cast<uint8_t>((sum.b + sum.a / 2) / sum.a);
+                        bgra[1] = static_cast<uint8_t>((sum.g + sum.a / 2) / sum.a);
+                        bgra[2] = static_cast<uint8_t>((sum.r + sum.a / 2) / sum.a);
+                        bgra[3] = static_cast<uint8_t>((sum.a + sum.count / 2) / sum.count);
+                    }
+                    else
+                    {
+                        std::fill_n(bgra, 4, uint8_t{ 0 });
+                    }
+                    bgra += 4;
+                    sum = {};
+                }
+            }
+
+        private:
+            struct Sum
+            {
+                uint64_t b = 0;
+                uint64_t g = 0;
+                uint64_t r = 0;
+                uint64_t a = 0;
+                uint64_t count = 0;
+            };
+
+            // First source column of the next destination column
+            uint32_t next_boundary(uint32_t x) const
+            {
+                return static_cast<uint32_t>((uint64_t{ x } + 1) * m_sourceWidth / m_sums.size());
+            }
+
+            uint32_t m_sourceWidth;
+            std::vector<Sum> m_sums;
+            uint32_t m_x = 0;
+            uint32_t m_next = 0;
+        };
+
+        template<Reader R>
+        std::optional<Header> read_header(details::Source<R>& source)
+        {
+            uint8_t bytes[header_size];
+            if (!source.next(bytes, sizeof(bytes)))
+            {
+                return std::nullopt;
+            }
+            return parse_header(bytes);
+        }
+    }
+
+    // Decodes the image and scales it down to fit max_size x max_size.
+    // Returns nullopt for invalid and truncated data.
+    template<Reader R>
+    std::optional<Image> decode(R&& reader, uint32_t max_size)
+    {
+        if (max_size == 0)
+        {
+            return std::nullopt;
+        }
+
+        details::Source<std::remove_reference_t<R>> source{ reader };
+        const auto header = details::read_header(source);
+        if (!header)
+        {
+            return std::nullopt;
+        }
+
+        Image image;
+        std::tie(image.width, image.height) = fit_size(header->width, header->height, max_size);
+        image.bgra.resize(size_t{ image.width } * image.height * 4);
+
+        const bool scaled = image.width != header->width || image.height != header->height;
+        details::RowAccumulator accumulator{ header->width, scaled ? image.width : 0 };
+
+        std::array<details::Rgba, 64> index{};
+        details::Rgba px{ 0, 0, 0, 255 };
+        uint32_t run = 0;
+
+        uint8_t* out = image.bgra.data();
+        uint32_t destY = 0;
+        uint32_t nextRowBoundary = static_cast<uint32_t>(uint64_t{ header->height } / image.height);
+
+        for (uint32_t y = 0; y < header->height; y++)
+        {
+            if (scaled)
+            {
+                if (y == nextRowBoundary)
+                {
+                    accumulator.flush(out + size_t{ destY } * image.width * 4);
+                    destY++;
+                    nextRowBoundary = static_cast<uint32_t>((uint64_t{ destY } + 1) * header->height / image.height);
+                }
+                accumulator.begin_row();
+            }
+
+            for (uint32_t x = 0; x < header->width; x++)
+            {
+                if (run > 0)
+                {
+                    run--;
+                }
+                else
+                {
+                    uint8_t b1;
+                    if (!source.next(b1))
+                    {
+                        return std::nullopt;
+                    }
+
+                    if (b1 == 0xfe || b1 == 0xff)
+                    {
+                        uint8_t rgba[4];
+                        if (!source.next(rgba, b1 == 0xff ? 4 : 3))
+                        {
+                            return std::nullopt;
+                        }
+                        px.r = rgba[0];
+                        px.g = rgba[1];
+                        px.b = rgba[2];
+                        if (b1 == 0xff)
+                        {
+                            px.a = rgba[3];
+                        }
+                    }
+                    else
+                    {
+                        switch (b1 & 0xc0)
+                        {
+                        case 0x00:
+                            px = index[b1];
+                            break;
+                        case 0x40:
+                            px.r += static_cast<uint8_t>(((b1 >> 4) & 0x03) - 2);
+                            px.g += static_cast<uint8_t>(((b1 >> 2) & 0x03) - 2);
+                            px.b += static_cast<uint8_t>((b1 & 0x03) - 2);
+                            break;
+                        case 0x80:
+                        {
+                            uint8_t b2;
+                            if (!source.next(b2))
+                            {
+                                return std::nullopt;
+                            }
+                            const int vg = (b1 & 0x3f) - 32;
+                            px.r += static_cast<uint8_t>(vg - 8 + ((b2 >> 4) & 0x0f));
+                            px.g += static_cast<uint8_t>(vg);
+                            px.b += static_cast<uint8_t>(vg - 8 + (b2 & 0x0f));
+                            break;
+                        }
+                        default:
+                            run = b1 & 0x3f;
+                            break;
+                        }
+                    }
+
+                    index[details::hash(px)] = px;
+                }
+
+                if (scaled)
+                {
+                    accumulator.add(px, x);
+                }
+                else
+                {
+                    out[0] = px.b;
+                    out[1] = px.g;
+                    out[2] = px.r;
+                    out[3] = px.a;
+                    out += 4;
+                }
+            }
+        }
+
+        if (scaled)
+        {
+            accumulator.flush(out + size_t{ destY } * image.width * 4);
+        }
+        return image;
+    }
+
+    // Scales 32 bit BGRA rows, top-down without padding, down to fit max_size x max_size with the same filter
+    // as decode. Images which already fit are copied.
+    inline Image scale_down(const uint8_t* bgra, uint32_t width, uint32_t height, uint32_t max_size)
+    {
+        Image image;
+        std::tie(image.width, image.height) = fit_size(width, height, max_size);
+        image.bgra.resize(size_t{ image.width } * image.height * 4);
+        if (image.width == width && image.height == height)
+        {
+            std::copy_n(bgra, image.bgra.size(), image.bgra.data());
+            return image;
+        }
+
+        details::RowAccumulator accumulator{ width, image.width };
+        uint32_t destY = 0;
+        uint32_t nextRowBoundary = static_cast<uint32_t>(uint64_t{ height } / image.height);
+        for (uint32_t y = 0; y < height; y++)
+        {
+            if (y == nextRowBoundary)
+            {
+                accumulator.flush(image.bgra.data() + size_t{ destY } * image.width * 4);
+                destY++;
+                nextRowBoundary = static_cast<uint32_t>((uint64_t{ destY } + 1) * height / image.height);
+            }
+
+            accumulator.begin_row();
+            const uint8_t* row = bgra + size_t{ y } * width * 4;
+            for (uint32_t x = 0; x < width; x++)
+            {
+                accumulator.add({ row[2], row[1], row[0], row[3] }, x);
+                row += 4;
+            }
+        }
+        accumulator.flush(image.bgra.data() + size_t{ destY } * image.width * 4);
+        return image;
+    }
+}
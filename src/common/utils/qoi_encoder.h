@@ -0,0 +1,122 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+
+#include <common/utils/qoi_decoder.h>
+
+// Encoder for QOI images (https://qoiformat.org/qoi-specification.pdf), the counterpart of qoi::decode.
+// Used to keep thumbnails compressed on disk, rendered thumbnails are mostly flat background and gradients,
+// which QOI handles well, and it decodes faster than the uncompressed pixels would be read from disk.
+namespace qoi
+{
+    // Encodes 32 bit BGRA rows, top-down without padding, as a 4 channel sRGB QOI image.
+    // Returns an empty vector when the size doesn't match the pixels or is out of the format's range.
+    inline std::vector<uint8_t> encode(const uint8_t* bgra, uint32_t width, uint32_t height)
+    {
+        const uint64_t pixels = uint64_t{ width } * height;
+        if (!bgra || pixels == 0 || pixels > max_pixels)
+        {
+            return {};
+        }
+
+        // The worst case, every pixel as QOI_OP_RGBA, trimmed at the end
+        std::vector<uint8_t> buffer(static_cast<size_t>(14 + pixels * 5 + 8));
+        uint8_t* out = buffer.data();
+
+        auto be32 = [&out](uint32_t value) {
+            *out++ = static_cast<uint8_t>(value >> 24);
+            *out++ = static_cast<uint8_t>(value >> 16);
+            *out++ = static_cast<uint8_t>(value >> 8);
+            *out++ = static_cast<uint8_t>(value);
+        };
+
+        *out++ = 'q';
+        *out++ = 'o';
+        *out++ = 'i';
+        *out++ = 'f';
+        be32(width);
+        be32(height);
+        *out++ = 4;
+        *out++ = 0;
+
+        std::array<details::Rgba, 64> index{};
+        details::Rgba previous{ 0, 0, 0, 255 };
+        uint32_t run = 0;
+
+        for (uint64_t i = 0; i < pixels; i++, bgra += 4)
+        {
+            const details::Rgba px{ bgra[2], bgra[1], bgra[0], bgra[3] };
+            if (px.r == previous.r && px.g == previous.g && px.b == previous.b && px.a == previous.a)
+            {
+                run++;
+                if (run == 62 || i == pixels - 1)
+                {
+                    *out++ = static_cast<uint8_t>(0xc0 | (run - 1));
+                    run = 0;
+                }
+                continue;
+            }
+
+            if (run > 0)
+            {
+                *out++ = static_cast<uint8_t>(0xc0 | (run - 1));
+                run = 0;
+            }
+
+            const uint8_t hash = details::hash(px);
+            const auto& indexed = index[hash];
+            if (indexed.r == px.r && indexed.g == px.g && indexed.b == px.b && indexed.a == px.a)
+            {
+                *out++ = hash;
+            }
+            else
+            {
+                index[hash] = px;
+                if (px.a == previous.a)
+                {
+                    const auto vr = static_cast<int8_t>(px.r - previous.r);
+                    const auto vg = static_cast<int8_t>(px.g - previous.g);
+                    const auto vb = static_cast<int8_t>(px.b - previous.b);
+                    const int vgr = vr - vg;
+                    const int vgb = vb - vg;
+
+                    if (vr > -3 && vr < 2 && vg > -3 && vg < 2 && vb > -3 && vb < 2)
+                    {
+                        *out++ = static_cast<uint8_t>(0x40 | (vr + 2) << 4 | (vg + 2) << 2 | (vb + 2));
+                    }
+                    else if (vgr > -9 && vgr < 8 && vg > -33 && vg < 32 && vgb > -9 && vgb < 8)
+                    {
+                        *out++ = static_cast<uint8_t>(0x80 | (vg + 32));
+                        *out++ = static_cast<uint8_t>((vgr + 8) << 4 | (vgb + 8));
+                    }
+                    else
+                    {
+                        *out++ = 0xfe;
+                        *out++ = px.r;
+                        *out++ = px.g;
+                        *out++ = px.b;
+                    }
+                }
+                else
+                {
+                    *out++ = 0xff;
+                    *out++ = px.r;
+                    *out++ = px.g;
+                    *out++ = px.b;
+                    *out++ = px.a;
+                }
+            }
+            previous = px;
+        }
+
+        constexpr uint8_t end[8] = { 0, 0, 0, 0, 0, 0, 0, 1 };
+        out = std::copy(std::begin(end), std::end(end), out);
+        buffer.resize(static_cast<size_t>(out - buffer.data()));
+        return buffer;
+    }
+}
@@ -0,0 +1,550 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// Renders thumbnails of STL meshes without a 3D API: the mesh is parsed while it's read, decimated when it
+// has more triangles than are worth drawing at thumbnail size, and rasterized in software with a z-buffer.
+// Doesn't depend on Windows, the caller supplies the bytes and the BGRA pixels to draw into.
+namespace stl
+{
+    struct Vec3
+    {
+        float x = 0;
+        float y = 0;
+        float z = 0;
+    };
+
+    using Triangle = std::array<Vec3, 3>;
+
+    struct Mesh
+    {
+        std::vector<Triangle> triangles;
+        // Triangles in the file, every stride-th one was kept
+        uint64_t source_triangles = 0;
+        uint64_t stride = 1;
+    };
+
+    struct Color
+    {
+        uint8_t r = 0;
+        uint8_t g = 0;
+        uint8_t b = 0;
+    };
+
+    // A million triangles take 36 MB and are drawn in well under a second
+    inline constexpr size_t default_max_triangles = 1'000'000;
+
+    // Fills up to size bytes and returns how many were written, 0 at the end of the data or on errors
+    template<typename T>
+    concept Reader = requires(T reader, uint8_t* buffer, size_t size) {
+        { reader(buffer, size) } -> std::convertible_to<size_t>;
+    };
+
+    namespace details
+    {
+        inline Vec3 operator-(Vec3 a, Vec3 b)
+        {
+            return { a.x - b.x, a.y - b.y, a.z - b.z };
+        }
+
+        inline float dot(Vec3 a, Vec3 b)
+        {
+            return a.x * b.x + a.y * b.y + a.z * b.z;
+        }
+
+        inline Vec3 cross(Vec3 a, Vec3 b)
+        {
+            return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+        }
+
+        inline Vec3 normalize(Vec3 v)
+        {
+            const float length = std::sqrt(dot(v, v));
+            return length > 0 ? Vec3{ v.x / length, v.y / length, v.z / length } : Vec3{};
+        }
+
+        // Keeps every stride-th triangle. When the budget is reached, every other kept triangle is dropped
+        // and the stride doubles, so files of unknown length end up evenly sampled too.
+        class Decimator
+        {
+        public:
+            Decimator(Mesh& mesh, size_t maxTriangles) :
+                m_mesh(mesh), m_maxTriangles((std::max)(maxTriangles, size_t{ 2 }))
+            {
+            }
+
+            void expect(uint64_t count)
+            {
+                m_mesh.stride = (std::max)(uint64_t{ 1 }, (count + m_maxTriangles - 1) / m_maxTriangles);
+            }
+
+            void add(const Triangle& triangle)
+            {
+                if (m_mesh.source_triangles++ % m_mesh.stride != 0)
+                {
+                    return;
+                }
+
+                for (const auto& v : triangle)
+                {
+                    if (!std::isfinite(v.x) || !std::isfinite(v.y) || !std::isfinite(v.z))
+                    {
+                        return;
+                    }
+                }
+
+                if (m_mesh.triangles.size() == m_maxTriangles)
+                {
+                    auto& triangles = m_mesh.triangles;
+                    for (size_t i = 0; i < triangles.size() / 2; i++)
+                    {
+                        triangles[i] = triangles[i * 2];
+                    }
+                    triangles.resize(triangles.size() / 2);
+                    m_mesh.stride *= 2;
+
+                    // the triangles kept are the ones at multiples of the new stride
+                    if ((m_mesh.source_triangles - 1) % m_mesh.stride != 0)
+                    {
+                        return;
+                    }
+                }
+                m_mesh.triangles.push_back(triangle);
+            }
+
+        private:
+            Mesh& m_mesh;
+            size_t m_maxTriangles;
+        };
+
+        template<Reader R>
+        class Source
+        {
+        public:
+            static constexpr size_t capacity = 256 * 1024;
+
+            explicit Source(R& reader) :
+                m_reader(reader), m_buffer(capacity)
+            {
+            }
+
+            // Makes count bytes available unless the data ends first, count can't exceed the capacity
+            std::span<const uint8_t> peek(size_t count)
+            {
+                if (m_end - m_begin < count && !m_eof)
+                {
+                    std::memmove(m_buffer.data(), m_buffer.data() + m_begin, m_end - m_begin);
+                    m_end -= m_begin;
+                    m_begin = 0;
+                    while (m_end < count && !m_eof)
+                    {
+                        const size_t read = (std::min)(static_cast<size_t>(m_reader(m_buffer.data() + m_end, capacity - m_end)), capacity - m_end);
+                        m_eof = read == 0;
+                        m_end += read;
+                    }
+                }
+                return { m_buffer.data() + m_begin, (std::min)(count, m_end - m_begin) };
+            }
+
+            void consume(size_t count)
+            {
+                m_begin += count;
+            }
+
+        private:
+            R& m_reader;
+            std::vector<uint8_t> m_buffer;
+            size_t m_begin = 0;
+            size_t m_end = 0;
+            bool m_eof = false;
+        };
+
+        inline bool is_space(uint8_t c)
+        {
+            return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+        }
+
+        inline std::string_view trim(std::string_view text)
+        {
+            while (!text.empty() && is_space(text.front()))
+            {
+                text.remove_prefix(1);
+            }
+            while (!text.empty() && is_space(text.back()))
+            {
+                text.remove_suffix(1);
+            }
+            return text;
+        }
+
+        // Binary files may start with "solid" too, but their header isn't followed by a facet
+        inline bool is_ascii(std::span<const uint8_t> start)
+        {
+            const std::string_view text{ reinterpret_cast<const char*>(start.data()), start.size() };
+            if (!text.starts_with("solid"))
+            {
+                return false;
+            }
+
+            const size_t lineEnd = text.find('\n');
+            if (lineEnd == std::string_view::npos)
+            {
+                return false;
+            }
+
+            const auto next = trim(text.substr(lineEnd + 1));
+            return next.starts_with("facet") || next.starts_with("endsolid");
+        }
+
+        template<Reader R>
+        void parse_binary(Source<R>& source, Decimator& decimator)
+        {
+            constexpr size_t triangleSize = 50;
+            auto header = source.peek(84);
+            if (header.size() < 84)
+            {
+                return;
+            }
+
+            uint32_t count;
+            std::memcpy(&count, header.data() + 80, sizeof(count));
+            source.consume(84);
+            decimator.expect(count);
+
+            // some exporters leave the count at 0, the triangles go on until the end of the file then
+            constexpr size_t batch = Source<R>::capacity / triangleSize * triangleSize;
+            for (uint64_t remaining = count ? count : UINT64_MAX / triangleSize; remaining > 0;)
+            {
+                const auto bytes = source.peek(static_cast<size_t>((std::min)(remaining * triangleSize, uint64_t{ batch })));
+                const size_t triangles = bytes.size() / triangleSize;
+                if (triangles == 0)
+                {
+                    // truncated, keep what was read
+                    return;
+                }
+
+                for (size_t i = 0; i < triangles; i++)
+                {
+                    // the normal is skipped, it's computed from the vertices
+                    float values[9];
+                    std::memcpy(values, bytes.data() + i * triangleSize + 12, sizeof(values));
+                    decimator.add({ Vec3{ values[0], values[1], values[2] },
+                                    Vec3{ values[3], values[4], values[5] },
+                                    Vec3{ values[6], values[7], values[8] } });
+                }
+
+                source.consume(triangles * triangleSize);
+                remaining -= triangles;
+            }
+        }
+
+        template<Reader R>
+        void parse_ascii(Source<R>& source, Decimator& decimator)
+        {
+            constexpr size_t maxLine = 4096;
+            Triangle triangle;
+            size_t vertex = 0;
+
+            while (true)
+            {
+                const auto bytes = source.peek(maxLine);
+                if (bytes.empty())
+                {
+                    return;
+                }
+
+                std::string_view text{ reinterpret_cast<const char*>(bytes.data()), bytes.size() };
+                const size_t lineEnd = text.find('\n');
+                const size_t consumed = lineEnd == std::string_view::npos ? text.size() : lineEnd + 1;
+                const auto line = trim(text.substr(0, consumed));
+                source.consume(consumed);
+
+                if (!line.starts_with("vertex"))
+                {
+                    continue;
+                }
+
+                float values[3];
+                const char* position = line.data() + 6;
+                const char* end = line.data() + line.size();
+                bool valid = true;
+                for (float& value : values)
+                {
+                    while (position < end && is_space(*position))
+                    {
+                        position++;
+                    }
+                    if (position < end && *position == '+')
+                    {
+                        position++;
+                    }
+                    const auto result = std::from_chars(position, end, value);
+                    valid = valid && result.ec == std::errc{};
+                    position = result.ptr;
+                }
+
+                if (!valid)
+                {
+                    vertex = 0;
+                    continue;
+                }
+
+                triangle[vertex++] = { values[0], values[1], values[2] };
+                if (vertex == 3)
+                {
+                    decimator.add(triangle);
+                    vertex = 0;
+                }
+            }
+        }
+
+        // Splits [0, count) into ranges run on up to threadCount threads, including the calling one
+        template<typename Fn>
+        void parallel_for(size_t count, unsigned threadCount, Fn&& fn)
+        {
+            threadCount = static_cast<unsigned>((std::min)(size_t{ threadCount }, count));
+            if (threadCount <= 1)
+            {
+                if (count > 0)
+                {
+                    fn(size_t{ 0 }, count);
+                }
+                return;
+            }
+
+            std::vector<std::thread> threads;
+            for (unsigned i = 1; i < threadCount; i++)
+            {
+                threads.emplace_back([&fn, i, count, threadCount] {
+                    fn(count * i / threadCount, count * (i + 1) / threadCount);
+                });
+            }
+            fn(size_t{ 0 }, count / threadCount);
+            for (auto& thread : threads)
+            {
+                thread.join();
+            }
+        }
+
+        struct ScreenTriangle
+        {
+            float x[3];
+            float y[3];
+            float z[3];
+            float shade;
+        };
+    }
+
+    // Parses a binary or ASCII STL file. Meshes with more than maxTriangles triangles are decimated evenly.
+    // Returns nullopt if there's nothing to draw.
+    template<Reader R>
+    std::optional<Mesh> parse(R&& reader, size_t maxTriangles = default_max_triangles)
+    {
+        details::Source<std::remove_reference_t<R>> source{ reader };
+        Mesh mesh;
+        details::Decimator decimator{ mesh, maxTriangles };
+
+        if (details::is_ascii(source.peek(1024)))
+        {
+            details::parse_ascii(source, decimator);
+        }
+        else
+        {
+            details::parse_binary(source, decimator);
+        }
+
+        if (mesh.triangles.empty())
+        {
+            return std::nullopt;
+        }
+        return mesh;
+    }
+
+    // Draws the mesh into size x size pixels of 32 bit BGRA with straight alpha, rows top-down without padding.
+    // The view matches the managed thumbnail provider: looking at the model from the front left and above,
+    // scaled to fit, with a transparent background. threadCount 0 uses the hardware concurrency.
+    inline void render(const Mesh& mesh, uint32_t size, Color color, uint8_t* bgra, unsigned threadCount = 0)
+    {
+        using namespace details;
+
+        std::fill_n(bgra, size_t{ size } * size * 4, uint8_t{ 0 });
+        if (mesh.triangles.empty() || size == 0)
+        {
+            return;
+        }
+
+        if (threadCount == 0)
+        {
+            threadCount = std::clamp(std::thread::hardware_concurrency(), 1u, 8u);
+        }
+
+        Vec3 min{ (std::numeric_limits<float>::max)(), (std::numeric_limits<float>::max)(), (std::numeric_limits<float>::max)() };
+        Vec3 max{ std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest() };
+        for (const auto& triangle : mesh.triangles)
+        {
+            for (const auto& v : triangle)
+            {
+                min = { (std::min)(min.x, v.x), (std::min)(min.y, v.y), (std::min)(min.z, v.z) };
+                max = { (std::max)(max.x, v.x), (std::max)(max.y, v.y), (std::max)(max.z, v.z) };
+            }
+        }
+        const Vec3 center{ (min.x + max.x) / 2, (min.y + max.y) / 2, (min.z + max.z) / 2 };
+
+        // The managed provider turns the model by 180 degrees around Z and looks at it from (1, 2, 1) with Z up,
+        // which is the same as looking from (-1, -2, 1)
+        const Vec3 forward = normalize({ 1, 2, -1 });
+        const Vec3 right = normalize(cross(forward, { 0, 0, 1 }));
+        const Vec3 up = cross(right, forward);
+        const Vec3 light = normalize({ -forward.x + up.x * 0.5f - right.x * 0.3f, -forward.y + up.y * 0.5f - right.y * 0.3f, -forward.z + up.z * 0.5f - right.z * 0.3f });
+
+        std::vector<ScreenTriangle> screen(mesh.triangles.size());
+        parallel_for(mesh.triangles.size(), threadCount, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++)
+            {
+                const auto& triangle = mesh.triangles[i];
+                auto& projected = screen[i];
+                for (int j = 0; j < 3; j++)
+                {
+                    const Vec3 v = triangle[j] - center;
+                    projected.x[j] = dot(v, right);
+                    projected.y[j] = dot(v, up);
+                    projected.z[j] = dot(v, forward);
+                }
+
+                // STL normals are often missing or inconsistent, so both sides are lit
+                const Vec3 normal = normalize(cross(triangle[1] - triangle[0], triangle[2] - triangle[0]));
+                projected.shade = 0.3f + 0.7f * std::abs(dot(normal, light));
+            }
+        });
+
+        float extent = 0;
+        for (const auto& triangle : screen)
+        {
+            for (int j = 0; j < 3; j++)
+            {
+                extent = (std::max)({ extent, std::abs(triangle.x[j]), std::abs(triangle.y[j]) });
+            }
+        }
+
+        // a small margin, as the managed provider's zoom to extents leaves
+        const float scale = extent > 0 ? size * 0.95f / (2 * extent) : 1.0f;
+        const float half = size / 2.0f;
+        for (auto& triangle : screen)
+        {
+            for (int j = 0; j < 3; j++)
+            {
+                triangle.x[j] = half + triangle.x[j] * scale;
+                triangle.y[j] = half - triangle.y[j] * scale;
+            }
+        }
+
+        // Every band of rows is drawn by one thread with its part of the z-buffer, so nothing is shared while
+        // drawing. The model is centered, so the bands are interleaved to give every thread some of it.
+        const size_t bands = (std::min)(size_t{ threadCount } * 4, size_t{ size });
+        std::vector<float> depth(size_t{ size } * size, (std::numeric_limits<float>::max)());
+        auto draw_band = [&](size_t band) {
+            const int top = static_cast<int>(size * band / bands);
+            const int bottom = static_cast<int>(size * (band + 1) / bands);
+
+            for (const auto& t : screen)
+            {
+                const float minX = (std::min)({ t.x[0], t.x[1], t.x[2] });
+                const float maxX = (std::max)({ t.x[0], t.x[1], t.x[2] });
+                const float minY = (std::min)({ t.y[0], t.y[1], t.y[2] });
+                const float maxY = (std::max)({ t.y[0], t.y[1], t.y[2] });
+
+                // pixel centers inside the bounding box
+                const int x0 = (std::max)(0, static_cast<int>(std::ceil(minX - 0.5f)));
+                const int x1 = (std::min)(static_cast<int>(size) - 1, static_cast<int>(std::floor(maxX - 0.5f)));
+                const int y0 = (std::max)(top, static_cast<int>(std::ceil(minY - 0.5f)));
+                const int y1 = (std::min)(bottom - 1, static_cast<int>(std::floor(maxY - 0.5f)));
+                if (x0 > x1 || y0 > y1)
+                {
+                    continue;
+                }
+
+                const float area = (t.x[1] - t.x[0]) * (t.y[2] - t.y[0]) - (t.x[2] - t.x[0]) * (t.y[1] - t.y[0]);
+                if (area == 0)
+                {
+                    continue;
+                }
+
+                // edge functions, stepped per pixel
+                const float sign = area > 0 ? 1.0f : -1.0f;
+                float a[3];
+                float b[3];
+                float c[3];
+                for (int e = 0; e < 3; e++)
+                {
+                    const int from = (e + 1) % 3;
+                    const int to = (e + 2) % 3;
+                    a[e] = sign * (t.y[from] - t.y[to]);
+                    b[e] = sign * (t.x[to] - t.x[from]);
+                    c[e] = sign * (t.x[from] * t.y[to] - t.x[to] * t.y[from]);
+                }
+
+                const float invArea = 1.0f / std::abs(area);
+                const uint8_t pixel[4]{
+                    static_cast<uint8_t>(color.b * t.shade),
+                    static_cast<uint8_t>(color.g * t.shade),
+                    static_cast<uint8_t>(color.r * t.shade),
+                    255,
+                };
+
+                for (int y = y0; y <= y1; y++)
+                {
+                    const float py = y + 0.5f;
+                    const float px = x0 + 0.5f;
+                    float w[3];
+                    for (int e = 0; e < 3; e++)
+                    {
+                        w[e] = a[e] * px + b[e] * py + c[e];
+                    }
+
+                    float* depthRow = depth.data() + static_cast<size_t>(y) * size;
+                    uint8_t* row = bgra + static_cast<size_t>(y) * size * 4;
+                    for (int x = x0; x <= x1; x++)
+                    {
+                        if (w[0] >= 0 && w[1] >= 0 && w[2] >= 0)
+                        {
+                            const float z = (w[0] * t.z[0] + w[1] * t.z[1] + w[2] * t.z[2]) * invArea;
+                            if (z < depthRow[x])
+                            {
+                                depthRow[x] = z;
+                                std::memcpy(row + static_cast<size_t>(x) * 4, pixel, 4);
+                            }
+                        }
+
+                        for (int e = 0; e < 3; e++)
+                        {
+                            w[e] += a[e];
+                        }
+                    }
+                }
+            }
+        };
+
+        parallel_for(threadCount, threadCount, [&](size_t begin, size_t end) {
+            for (size_t thread = begin; thread < end; thread++)
+            {
+                for (size_t band = thread; band < bands; band += threadCount)
+                {
+                    draw_band(band);
+                }
+            }
+        });
+    }
+}
@@ -0,0 +1,403 @@
+#pragma once
+
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#include <ObjIdl.h>
+
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <wil/resource.h>
+
+#include <common/utils/qoi_decoder.h>
+#include <common/utils/qoi_encoder.h>
+#include <common/utils/thumbnail_cache_index.h>
+
+// Thumbnails rendered by the thumbnail providers, kept on disk so a file isn't decoded again when Explorer
+// dropped it from its own cache or asks for another view size. Shared by every provider and host process:
+//   <folder>\index.bin   the memory-mapped thumbnail_cache::Index, guarded by a named mutex
+//   <folder>\<id>.qoi    the thumbnails, 32bpp BGRA compressed as QOI
+// The cache is only an optimization, every failure is treated as a miss.
+namespace thumbnail_cache
+{
+    // Identifies the provider in the key, so the same bytes opened by two providers don't share a thumbnail
+    enum class Source : uint32_t
+    {
+        Qoi = 1,
+        Stl,
+        Gcode,
+        Svg,
+        Pdf,
+    };
+
+    namespace details
+    {
+        // The rows of a 32bpp DIB section, top-down
+        inline std::optional<qoi::Image> read_bitmap(HBITMAP bitmap)
+        {
+            DIBSECTION dib{};
+            if (GetObjectW(bitmap, sizeof(dib), &dib) != static_cast<int>(sizeof(dib)) || dib.dsBm.bmBitsPixel != 32 || !dib.dsBm.bmBits)
+            {
+                return std::nullopt;
+            }
+
+            qoi::Image image{ static_cast<uint32_t>(dib.dsBm.bmWidth), static_cast<uint32_t>(dib.dsBm.bmHeight) };
+            image.bgra.resize(size_t{ image.width } * image.height * 4);
+            const auto* bits = static_cast<const uint8_t*>(dib.dsBm.bmBits);
+            for (uint32_t y = 0; y < image.height; y++)
+            {
+                const uint32_t sourceRow = dib.dsBmih.biHeight < 0 ? y : image.height - 1 - y;
+                std::memcpy(image.bgra.data() + size_t{ y } * image.width * 4, bits + size_t{ sourceRow } * dib.dsBm.bmWidthBytes, size_t{ image.width } * 4);
+            }
+            return image;
+        }
+
+        // A top-down 32bpp DIB section of the image
+        inline HBITMAP create_bitmap(const qoi::Image& image)
+        {
+            BITMAPINFO bmi{};
+            bmi.bmiHeader.biSize = sizeof(bmi.bmiHeader);
+            bmi.bmiHeader.biWidth = static_cast<LONG>(image.width);
+            bmi.bmiHeader.biHeight = -static_cast<LONG>(image.height);
+            bmi.bmiHeader.biPlanes = 1;
+            bmi.bmiHeader.biBitCount = 32;
+            bmi.bmiHeader.biCompression = BI_RGB;
+
+            void* bits = nullptr;
+            HBITMAP bitmap = CreateDIBSection(NULL, &bmi, DIB_RGB_COLORS, &bits, NULL, 0);
+            if (bitmap)
+            {
+                std::memcpy(bits, image.bgra.data(), image.bgra.size());
+            }
+            return bitmap;
+        }
+    }
+
+    // Thumbnails are rendered and cached at the size of the bucket, Explorer gets one which fits the cx it
+    // asked for. Replaces a larger 32bpp DIB section with a scaled down one, keeps it if it can't be scaled.
+    inline void fit(HBITMAP& bitmap, UINT cx)
+    {
+        const auto image = details::read_bitmap(bitmap);
+        if (!image || cx == 0 || (image->width <= cx && image->height <= cx))
+        {
+            return;
+        }
+
+        if (HBITMAP scaled = details::create_bitmap(qoi::scale_down(image->bgra.data(), image->width, image->height, cx)))
+        {
+            DeleteObject(bitmap);
+            bitmap = scaled;
+        }
+    }
+
+    class Cache
+    {
+    public:
+        Cache(const std::wstring& folder, Options options = {}) :
+            m_folder(folder), m_options(options)
+        {
+            std::error_code error;
+            std::filesystem::create_directories(m_folder, error);
+
+            m_mutex.reset(CreateMutexW(nullptr, FALSE, (L"Local\\PowerToys_ThumbnailCache_" + std::to_wstring(std::hash<std::wstring>{}(m_folder))).c_str()));
+            if (!m_mutex)
+            {
+                return;
+            }
+
+            const auto size = Index::required_size(options);
+            wil::unique_hfile file{ CreateFileW((m_folder + L"\\index.bin").c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr) };
+            if (!file)
+            {
+                return;
+            }
+
+            // A new or shorter file is extended with zeros by the mapping
+            m_mapping.reset(CreateFileMappingW(file.get(), nullptr, PAGE_READWRITE, static_cast<DWORD>(uint64_t{ size } >> 32), static_cast<DWORD>(size), nullptr));
+            if (!m_mapping)
+            {
+                return;
+            }
+            m_view.reset(static_cast<uint8_t*>(MapViewOfFile(m_mapping.get(), FILE_MAP_READ | FILE_MAP_WRITE, 0, 0, size)));
+            if (!m_view)
+            {
+                return;
+            }
+
+            if (auto lock = acquire())
+            {
+                m_index.emplace(std::span<uint8_t>{ m_view.get(), size }, options);
+                if (m_index->was_reset())
+                {
+                    remove_blobs();
+                }
+            }
+        }
+
+        Cache(const Cache&) = delete;
+        Cache& operator=(const Cache&) = delete;
+
+        bool valid() const
+        {
+            return m_index.has_value() && m_index->valid();
+        }
+
+        // Key of the content of the stream for a request of cx. Reads the prefix and seeks back to the start,
+        // nullopt when the stream can't tell its size or can't seek.
+        std::optional<Key> make_key(IStream* stream, UINT cx, Source source, uint32_t variant = 0) const
+        {
+            STATSTG stat{};
+            if (!valid() || FAILED(stream->Stat(&stat, STATFLAG_NONAME)) || stat.cbSize.QuadPart == 0)
+            {
+                return std::nullopt;
+            }
+
+            std::vector<uint8_t> prefix(static_cast<size_t>((std::min)(stat.cbSize.QuadPart, ULONGLONG{ prefix_size })));
+            size_t position = 0;
+            while (position < prefix.size())
+            {
+                ULONG read = 0;
+                if (FAILED(stream->Read(prefix.data() + position, static_cast<ULONG>(prefix.size() - position), &read)) || read == 0)
+                {
+                    break;
+                }
+                position += read;
+            }
+
+            LARGE_INTEGER start{};
+            if (position != prefix.size() || FAILED(stream->Seek(start, STREAM_SEEK_SET, nullptr)))
+            {
+                return std::nullopt;
+            }
+
+            Key key;
+            key.hash = hash_prefix(prefix);
+            key.size = stat.cbSize.QuadPart;
+            key.mtime = uint64_t{ stat.mtime.dwHighDateTime } << 32 | stat.mtime.dwLowDateTime;
+            key.bucket = size_bucket(cx);
+            key.variant = static_cast<uint32_t>(source) << 24 | (variant & 0xFFFFFF);
+            return key;
+        }
+
+        // A top-down 32bpp DIB section of the cached thumbnail scaled down to fit cx, counted as a hit or a miss
+        bool find(const Key& key, UINT cx, HBITMAP* phbmp)
+        {
+            if (!valid())
+            {
+                return false;
+            }
+
+            std::optional<Index::Entry> entry;
+            if (auto lock = acquire())
+            {
+                entry = m_index->find(key);
+                if (!entry)
+                {
+                    m_index->record(false);
+                    return false;
+                }
+            }
+            else
+            {
+                return false;
+            }
+
+            HBITMAP bitmap = load(entry->id, entry->blob_size, key.bucket, cx);
+            std::vector<uint64_t> dropped;
+            if (auto lock = acquire())
+            {
+                m_index->record(bitmap != nullptr);
+                if (!bitmap)
+                {
+                    m_index->remove(key, entry->id, dropped);
+                }
+            }
+            delete_blobs(dropped);
+
+            if (!bitmap)
+            {
+                return false;
+            }
+            *phbmp = bitmap;
+            return true;
+        }
+
+        // Adds the thumbnail, a 32bpp DIB section, to the cache
+        void store(const Key& key, HBITMAP bitmap)
+        {
+            // Stored top-down like the providers create them
+            const auto image = valid() ? details::read_bitmap(bitmap) : std::nullopt;
+            if (!image)
+            {
+                return;
+            }
+
+            const auto blob = qoi::encode(image->bgra.data(), image->width, image->height);
+            if (blob.empty() || blob.size() > UINT32_MAX)
+            {
+                return;
+            }
+
+            // Written under a name of its own and renamed once the index has an id for it, readers only
+            // ever see complete blobs
+            static std::atomic<uint32_t> counter = 0;
+            const auto temp = std::format(L"{}\\{}_{}_{}.tmp", m_folder, GetCurrentProcessId(), GetCurrentThreadId(), counter++);
+            if (!write_file(temp, blob))
+            {
+                return;
+            }
+
+            std::vector<uint64_t> dropped;
+            if (auto lock = acquire())
+            {
+                const uint64_t id = m_index->insert(key, static_cast<uint32_t>(blob.size()), dropped);
+                if (id == 0 || !MoveFileExW(temp.c_str(), blob_path(id).c_str(), MOVEFILE_REPLACE_EXISTING))
+                {
+                    if (id != 0)
+                    {
+                        m_index->remove(key, id, dropped);
+                    }
+                    DeleteFileW(temp.c_str());
+                }
+            }
+            else
+            {
+                DeleteFileW(temp.c_str());
+            }
+            delete_blobs(dropped);
+        }
+
+        Stats stats()
+        {
+            auto lock = valid() ? acquire() : wil::mutex_release_scope_exit{};
+            return lock ? m_index->stats() : Stats{};
+        }
+
+        // Drops every entry and blob
+        void clear()
+        {
+            if (!valid())
+            {
+                return;
+            }
+
+            if (auto lock = acquire())
+            {
+                std::vector<uint64_t> dropped;
+                m_index->trim(0, dropped);
+                remove_blobs();
+            }
+        }
+
+    private:
+        wil::mutex_release_scope_exit acquire()
+        {
+            if (!m_mutex || !m_view)
+            {
+                return {};
+            }
+
+            const DWORD result = WaitForSingleObject(m_mutex.get(), 5000);
+            if (result != WAIT_OBJECT_0 && result != WAIT_ABANDONED)
+            {
+                return {};
+            }
+
+            wil::mutex_release_scope_exit lock{ m_mutex.get() };
+            if (result == WAIT_ABANDONED && m_index)
+            {
+                m_index->repair();
+            }
+            return lock;
+        }
+
+        std::wstring blob_path(uint64_t id) const
+        {
+            return std::format(L"{}\\{:016x}.qoi", m_folder, id);
+        }
+
+        // Blobs are thumbnails of at most maxSize x maxSize, anything larger is rejected before it's decoded.
+        // The thumbnail is scaled down to fit cx while decoding.
+        HBITMAP load(uint64_t id, uint32_t blobSize, uint32_t maxSize, UINT cx) const
+        {
+            // FILE_SHARE_DELETE, so another process can still evict it meanwhile
+            wil::unique_hfile file{ CreateFileW(blob_path(id).c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr) };
+            LARGE_INTEGER size{};
+            if (!file || !GetFileSizeEx(file.get(), &size) || size.QuadPart != blobSize)
+            {
+                return nullptr;
+            }
+
+            uint8_t bytes[qoi::header_size];
+            DWORD read = 0;
+            if (!ReadFile(file.get(), bytes, sizeof(bytes), &read, nullptr) || read != sizeof(bytes))
+            {
+                return nullptr;
+            }
+            const auto header = qoi::parse_header(bytes);
+            LARGE_INTEGER start{};
+            if (!header || header->width > maxSize || header->height > maxSize || !SetFilePointerEx(file.get(), start, nullptr, FILE_BEGIN))
+            {
+                return nullptr;
+            }
+
+            auto reader = [&file](uint8_t* buffer, size_t count) -> size_t {
+                DWORD read = 0;
+                if (!ReadFile(file.get(), buffer, static_cast<DWORD>((std::min)(count, size_t{ 1024 * 1024 })), &read, nullptr))
+                {
+                    return 0;
+                }
+                return read;
+            };
+            auto image = qoi::decode(reader, (std::min)(maxSize, static_cast<uint32_t>(cx)));
+            return image ? details::create_bitmap(*image) : nullptr;
+        }
+
+        static bool write_file(const std::wstring& path, const std::vector<uint8_t>& data)
+        {
+            wil::unique_hfile file{ CreateFileW(path.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr) };
+            DWORD written = 0;
+            if (!file || !WriteFile(file.get(), data.data(), static_cast<DWORD>(data.size()), &written, nullptr) || written != data.size())
+            {
+                file.reset();
+                DeleteFileW(path.c_str());
+                return false;
+            }
+            return true;
+        }
+
+        void delete_blobs(const std::vector<uint64_t>& ids) const
+        {
+            for (const auto id : ids)
+            {
+                DeleteFileW(blob_path(id).c_str());
+            }
+        }
+
+        // Every blob and leftover temporary file, while the index is empty
+        void remove_blobs() const
+        {
+            std::error_code error;
+            for (const auto& item : std::filesystem::directory_iterator(m_folder, error))
+            {
+                const auto extension = item.path().extension();
+                if (extension == L".qoi" || extension == L".tmp")
+                {
+                    std::filesystem::remove(item.path(), error);
+                }
+            }
+        }
+
+        const std::wstring m_folder;
+        const Options m_options;
+        wil::unique_mutex_nothrow m_mutex;
+        wil::unique_handle m_mapping;
+        wil::unique_mapview_ptr<uint8_t> m_view;
+        std::optional<Index> m_index;
+    };
+}
@@ -0,0 +1,366 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <span>
+#include <utility>
+#include <vector>
+
+// Index of the thumbnail cache shared by the thumbnail providers. It lives in a memory-mapped file, so every
+// host process sees the same entries, and doesn't depend on Windows, the caller maps the memory and keeps
+// the blobs. The caller also serializes the access, none of the functions are thread safe.
+//
+// An entry is found by the content of the file, not its path: a hash of the first bytes plus the size and
+// the modification time, the requested size bucket and a variant for anything else changing the result.
+// Entries are in 8-way sets, a full set drops its least recently used entry. Once the blobs take more than
+// the byte budget, the least recently used entries of the whole index are dropped until 90% of it is left,
+// so an insert doesn't scan the index every time.
+namespace thumbnail_cache
+{
+    // Bytes of the file which go into the hash, the rest is covered by the size and the modification time
+    inline constexpr size_t prefix_size = 64 * 1024;
+
+    // Thumbnails up to this size are cached at the next power of two, larger ones at their size
+    inline constexpr uint32_t max_bucket = 1024;
+
+    struct Key
+    {
+        uint64_t hash = 0;
+        uint64_t size = 0;
+        uint64_t mtime = 0;
+        uint32_t bucket = 0;
+        uint32_t variant = 0;
+
+        bool operator==(const Key&) const = default;
+    };
+
+    struct Options
+    {
+        uint32_t sets = 2048;
+        uint64_t max_bytes = 256 * 1024 * 1024;
+    };
+
+    struct Stats
+    {
+        uint64_t entries = 0;
+        uint64_t bytes = 0;
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t stores = 0;
+        uint64_t evictions = 0;
+    };
+
+    // Size the thumbnail is rendered and cached at for a request of cx, so the requests Explorer makes
+    // for the different views share entries. The shell scales down thumbnails larger than cx.
+    inline uint32_t size_bucket(uint32_t cx)
+    {
+        if (cx > max_bucket)
+        {
+            return cx;
+        }
+
+        uint32_t bucket = 16;
+        while (bucket < cx)
+        {
+            bucket *= 2;
+        }
+        return bucket;
+    }
+
+    // Fast non-cryptographic hash of the file prefix, 4 independent lanes of 8 byte words so it runs
+    // at memory speed. Nothing depends on it being hard to collide, the size and the time are in the key too.
+    inline uint64_t hash_prefix(std::span<const uint8_t> data)
+    {
+        constexpr uint64_t k0 = 0x9E3779B97F4A7C15ull;
+        constexpr uint64_t k1 = 0xC2B2AE3D27D4EB4Full;
+        auto load = [](const uint8_t* p) {
+            uint64_t value;
+            std::memcpy(&value, p, 8);
+            return value;
+        };
+        auto mix = [](uint64_t lane, uint64_t value) {
+            lane ^= value * k1;
+            lane = (lane << 31) | (lane >> 33);
+            return lane * k0;
+        };
+
+        uint64_t lanes[4] = { k0, k1, ~k0, ~k1 };
+        const uint8_t* p = data.data();
+        size_t size = data.size();
+        for (; size >= 32; p += 32, size -= 32)
+        {
+            for (int i = 0; i < 4; i++)
+            {
+                lanes[i] = mix(lanes[i], load(p + i * 8));
+            }
+        }
+        for (int i = 0; size >= 8; p += 8, size -= 8, i++)
+        {
+            lanes[i] = mix(lanes[i], load(p));
+        }
+
+        uint8_t tail[8]{};
+        std::memcpy(tail, p, size);
+        uint64_t hash = mix(lanes[0] ^ (lanes[1] << 1) ^ (lanes[2] << 2) ^ (lanes[3] << 3), load(tail) ^ data.size());
+        hash ^= hash >> 33;
+        hash *= k1;
+        hash ^= hash >> 29;
+        return hash;
+    }
+
+    class Index
+    {
+    public:
+        static constexpr uint32_t magic = 0x43545450; // "PTTC"
+        static constexpr uint32_t version = 1;
+        static constexpr uint32_t ways = 8;
+
+        struct Entry
+        {
+            Key key;
+
+            // Name of the blob, 0 for free entries. A replaced entry gets a new one, so a blob which is
+            // being read is never overwritten.
+            uint64_t id = 0;
+            uint64_t last_used = 0;
+            uint32_t blob_size = 0;
+            uint32_t reserved = 0;
+        };
+
+        static size_t required_size(const Options& options)
+        {
+            return sizeof(Header) + size_t{ options.sets } * ways * sizeof(Entry);
+        }
+
+        // The memory must be at least required_size(options) bytes, zeroed or holding an earlier index.
+        // An index with another layout or a damaged header is cleared, the blobs of its entries are orphans then.
+        Index(std::span<uint8_t> memory, Options options) :
+            m_options(options)
+        {
+            if (options.sets == 0 || memory.size() < required_size(options))
+            {
+                return;
+            }
+
+            m_header = reinterpret_cast<Header*>(memory.data());
+            m_entries = reinterpret_cast<Entry*>(memory.data() + sizeof(Header));
+            if (m_header->magic != magic || m_header->version != version || m_header->sets != options.sets || m_header->ways != ways)
+            {
+                std::memset(memory.data(), 0, required_size(options));
+                m_header->magic = magic;
+                m_header->version = version;
+                m_header->sets = options.sets;
+                m_header->ways = ways;
+                m_header->next_id = 1;
+                m_reset = true;
+            }
+        }
+
+        bool valid() const
+        {
+            return m_header != nullptr;
+        }
+
+        // Whether the memory didn't hold a usable index
+        bool was_reset() const
+        {
+            return m_reset;
+        }
+
+        // Marks the entry as used, doesn't count it as a hit, the blob might turn out to be gone
+        std::optional<Entry> find(const Key& key)
+        {
+            if (!valid())
+            {
+                return std::nullopt;
+            }
+
+            for (auto& entry : set_of(key))
+            {
+                if (entry.id != 0 && entry.key == key)
+                {
+                    entry.last_used = ++m_header->clock;
+                    return entry;
+                }
+            }
+            return std::nullopt;
+        }
+
+        void record(bool hit)
+        {
+            if (valid())
+            {
+                (hit ? m_header->hits : m_header->misses)++;
+            }
+        }
+
+        // Adds an entry for a blob of blob_size bytes and returns its id, 0 when it's too large to be cached.
+        // The ids of the blobs which are no longer used are added to dropped, including the one the entry
+        // had before.
+        uint64_t insert(const Key& key, uint32_t blob_size, std::vector<uint64_t>& dropped)
+        {
+            if (!valid() || blob_size == 0 || blob_size > m_options.max_bytes / 16)
+            {
+                return 0;
+            }
+
+            auto set = set_of(key);
+            Entry* target = nullptr;
+            for (auto& entry : set)
+            {
+                if (entry.id != 0 && entry.key == key)
+                {
+                    target = &entry;
+                    break;
+                }
+            }
+            if (!target)
+            {
+                target = &*std::min_element(set.begin(), set.end(), [](const Entry& a, const Entry& b) {
+                    return std::make_pair(a.id != 0, a.last_used) < std::make_pair(b.id != 0, b.last_used);
+                });
+            }
+            if (target->id != 0)
+            {
+                if (!(target->key == key))
+                {
+                    m_header->evictions++;
+                }
+                drop(*target, dropped);
+            }
+
+            *target = Entry{ key, m_header->next_id++, ++m_header->clock, blob_size };
+            m_header->entries++;
+            m_header->bytes += blob_size;
+            m_header->stores++;
+
+            if (m_header->bytes > m_options.max_bytes)
+            {
+                trim(m_options.max_bytes / 10 * 9, dropped);
+            }
+            return target->id;
+        }
+
+        // Drops the entry when its blob is missing or damaged, unless it was replaced by another blob meanwhile
+        void remove(const Key& key, uint64_t id, std::vector<uint64_t>& dropped)
+        {
+            if (!valid())
+            {
+                return;
+            }
+
+            for (auto& entry : set_of(key))
+            {
+                if (entry.id == id && entry.key == key)
+                {
+                    drop(entry, dropped);
+                }
+            }
+        }
+
+        // Drops the least recently used entries until the blobs take at most max_bytes
+        void trim(uint64_t max_bytes, std::vector<uint64_t>& dropped)
+        {
+            if (!valid() || m_header->bytes <= max_bytes)
+            {
+                return;
+            }
+
+            std::vector<Entry*> used;
+            for (auto& entry : entries())
+            {
+                if (entry.id != 0)
+                {
+                    used.push_back(&entry);
+                }
+            }
+            std::sort(used.begin(), used.end(), [](const Entry* a, const Entry* b) { return a->last_used < b->last_used; });
+
+            for (auto* entry : used)
+            {
+                if (m_header->bytes <= max_bytes)
+                {
+                    break;
+                }
+                m_header->evictions++;
+                drop(*entry, dropped);
+            }
+        }
+
+        // Recounts the totals from the entries, after a process died while it was changing the index
+        void repair()
+        {
+            if (!valid())
+            {
+                return;
+            }
+
+            m_header->entries = 0;
+            m_header->bytes = 0;
+            for (auto& entry : entries())
+            {
+                if (entry.id != 0)
+                {
+                    m_header->entries++;
+                    m_header->bytes += entry.blob_size;
+                    m_header->next_id = (std::max)(m_header->next_id, entry.id + 1);
+                    m_header->clock = (std::max)(m_header->clock, entry.last_used);
+                }
+            }
+        }
+
+        Stats stats() const
+        {
+            if (!valid())
+            {
+                return {};
+            }
+            return { m_header->entries, m_header->bytes, m_header->hits, m_header->misses, m_header->stores, m_header->evictions };
+        }
+
+    private:
+        struct Header
+        {
+            uint32_t magic;
+            uint32_t version;
+            uint32_t sets;
+            uint32_t ways;
+            uint64_t clock;
+            uint64_t next_id;
+            uint64_t entries;
+            uint64_t bytes;
+            uint64_t hits;
+            uint64_t misses;
+            uint64_t stores;
+            uint64_t evictions;
+        };
+
+        std::span<Entry> entries() const
+        {
+            return { m_entries, size_t{ m_options.sets } * ways };
+        }
+
+        std::span<Entry> set_of(const Key& key) const
+        {
+            uint64_t hash = key.hash ^ key.size * 0x9E3779B97F4A7C15ull ^ key.mtime ^ (uint64_t{ key.bucket } << 32 | key.variant);
+            hash ^= hash >> 32;
+            return entries().subspan(static_cast<size_t>(hash % m_options.sets) * ways, ways);
+        }
+
+        void drop(Entry& entry, std::vector<uint64_t>& dropped)
+        {
+            dropped.push_back(entry.id);
+            m_header->entries--;
+            m_header->bytes -= entry.blob_size;
+            entry = {};
+        }
+
+        Options m_options;
+        Header* m_header = nullptr;
+        Entry* m_entries = nullptr;
+        bool m_reset = false;
+    };
+}
@@ -0,0 +1,360 @@
+#pragma once
+
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#include <ObjIdl.h>
+#include <Psapi.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <format>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <wil/resource.h>
+
+#include <common/interop/message_framing.h>
+#include <common/utils/worker_pool.h>
+
+// Thumbnail requests for the managed thumbnail providers, handled by a pool of warm workers instead of a
+// fresh process per thumbnail. A worker is started as "<exe> --worker <pipe name>", connects to the pipe
+// and handles requests until the pipe is closed.
+//
+// Every request is a MessageFraming binary frame:
+//   uint32 cx, uint32 reserved, uint64 content size, uint64 result offset, uint32 name length,
+//   UTF-16LE name of a file mapping
+// The mapping holds the file content at offset 0. The worker writes uint32 width, uint32 height and the
+// 32bpp BGRA rows with straight alpha, top-down, at the result offset, then answers with a binary frame
+// holding a uint32 status.
+namespace thumbnail_worker
+{
+    inline constexpr uint32_t StatusOk = 0;
+    inline constexpr uint32_t StatusFailed = 1;
+
+    inline constexpr size_t RequestHeaderSize = 28;
+    inline constexpr size_t ResultHeaderSize = 8;
+
+    // Larger files aren't handed to the workers
+    inline constexpr uint64_t MaxContentSize = 512 * 1024 * 1024;
+
+    class WorkerProcess
+    {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        WorkerProcess(const WorkerProcess&) = delete;
+        WorkerProcess& operator=(const WorkerProcess&) = delete;
+
+        ~WorkerProcess()
+        {
+            terminate();
+        }
+
+        // Starts the worker in the job and waits until it connected to its pipe. Returns nullptr on failure.
+        static std::unique_ptr<WorkerProcess> launch(const std::wstring& exePath, HANDLE job, Clock::time_point deadline)
+        {
+            static std::atomic<uint32_t> counter = 0;
+            const auto pipeName = std::format(L"powertoys_thumbnail_worker_{}_{}_{}", GetCurrentProcessId(), GetTickCount64(), counter++);
+
+            std::unique_ptr<WorkerProcess> worker{ new WorkerProcess() };
+            worker->m_pipe.reset(CreateNamedPipeW((L"\\\\.\\pipe\\" + pipeName).c_str(),
+                                                  PIPE_ACCESS_DUPLEX | FILE_FLAG_OVERLAPPED | FILE_FLAG_FIRST_PIPE_INSTANCE,
+                                                  PIPE_TYPE_BYTE | PIPE_READMODE_BYTE | PIPE_WAIT | PIPE_REJECT_REMOTE_CLIENTS,
+                                                  1,
+                                                  64 * 1024,
+                                                  64 * 1024,
+                                                  0,
+                                                  nullptr));
+            worker->m_event.reset(CreateEventW(nullptr, TRUE, FALSE, nullptr));
+            if (!worker->m_pipe || !worker->m_event)
+            {
+                return nullptr;
+            }
+
+            // Suspended until it's in the job, so nothing it starts escapes the job
+            std::wstring commandLine = std::format(L"\"{}\" --worker {}", exePath, pipeName);
+            STARTUPINFOW startupInfo{ sizeof(startupInfo) };
+            PROCESS_INFORMATION processInfo{};
+            if (!CreateProcessW(exePath.c_str(), commandLine.data(), nullptr, nullptr, FALSE, CREATE_SUSPENDED, nullptr, nullptr, &startupInfo, &processInfo))
+            {
+                return nullptr;
+            }
+
+            worker->m_process.reset(processInfo.hProcess);
+            wil::unique_handle thread{ processInfo.hThread };
+            // Outside the job it could outlive the host, so it never runs
+            if (job && !AssignProcessToJobObject(job, processInfo.hProcess))
+            {
+                worker->terminate();
+                return nullptr;
+            }
+            ResumeThread(thread.get());
+
+            OVERLAPPED overlapped{};
+            overlapped.hEvent = worker->m_event.get();
+            if (!ConnectNamedPipe(worker->m_pipe.get(), &overlapped))
+            {
+                const DWORD error = GetLastError();
+                DWORD transferred = 0;
+                if (error == ERROR_IO_PENDING)
+                {
+                    if (worker->wait(overlapped, deadline, transferred) != worker_pool::Status::Ok)
+                    {
+                        return nullptr;
+                    }
+                }
+                else if (error != ERROR_PIPE_CONNECTED)
+                {
+                    return nullptr;
+                }
+            }
+            return worker;
+        }
+
+        bool alive() const
+        {
+            return m_process && WaitForSingleObject(m_process.get(), 0) == WAIT_TIMEOUT;
+        }
+
+        uint64_t memory_usage() const
+        {
+            PROCESS_MEMORY_COUNTERS_EX counters{ sizeof(counters) };
+            if (!GetProcessMemoryInfo(m_process.get(), reinterpret_cast<PROCESS_MEMORY_COUNTERS*>(&counters), sizeof(counters)))
+            {
+                return 0;
+            }
+            return counters.PrivateUsage;
+        }
+
+        void terminate()
+        {
+            if (alive())
+            {
+                TerminateProcess(m_process.get(), 1);
+            }
+        }
+
+        // Sends the request and reads the response, giving up at the deadline
+        worker_pool::Status call(std::vector<uint8_t> request, std::vector<uint8_t>& response, Clock::time_point deadline)
+        {
+            std::vector<uint8_t> frame;
+            MessageFraming::encode(MessageFraming::MessageBuffer(MessageFraming::PayloadType::Binary, std::move(request)), frame);
+
+            for (size_t written = 0; written < frame.size();)
+            {
+                OVERLAPPED overlapped{};
+                overlapped.hEvent = m_event.get();
+                DWORD transferred = 0;
+                const auto size = static_cast<DWORD>((std::min)(frame.size() - written, size_t{ 64 * 1024 }));
+                if (!WriteFile(m_pipe.get(), frame.data() + written, size, &transferred, &overlapped) && GetLastError() != ERROR_IO_PENDING)
+                {
+                    return worker_pool::Status::Broken;
+                }
+                if (const auto status = wait(overlapped, deadline, transferred); status != worker_pool::Status::Ok)
+                {
+                    return status;
+                }
+                written += transferred;
+            }
+
+            uint8_t buffer[4096];
+            while (true)
+            {
+                if (auto message = m_decoder.next())
+                {
+                    if (message->type() != MessageFraming::PayloadType::Binary)
+                    {
+                        return worker_pool::Status::Broken;
+                    }
+                    response = message->release();
+                    return worker_pool::Status::Ok;
+                }
+                if (m_decoder.failed())
+                {
+                    return worker_pool::Status::Broken;
+                }
+
+                OVERLAPPED overlapped{};
+                overlapped.hEvent = m_event.get();
+                DWORD transferred = 0;
+                if (!ReadFile(m_pipe.get(), buffer, sizeof(buffer), &transferred, &overlapped) && GetLastError() != ERROR_IO_PENDING)
+                {
+                    return worker_pool::Status::Broken;
+                }
+                if (const auto status = wait(overlapped, deadline, transferred); status != worker_pool::Status::Ok)
+                {
+                    return status;
+                }
+                if (transferred == 0 || !m_decoder.feed(buffer, transferred))
+                {
+                    return worker_pool::Status::Broken;
+                }
+            }
+        }
+
+    private:
+        WorkerProcess() = default;
+
+        // Waits for the pending I/O, the deadline or the exit of the worker. The I/O is cancelled unless it completed.
+        worker_pool::Status wait(OVERLAPPED& overlapped, Clock::time_point deadline, DWORD& transferred)
+        {
+            const auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()).count();
+            const HANDLE handles[]{ m_event.get(), m_process.get() };
+            const DWORD result = WaitForMultipleObjects(2, handles, FALSE, static_cast<DWORD>(std::clamp<long long>(remaining, 0, INFINITE - 1)));
+            if (result == WAIT_OBJECT_0)
+            {
+                return GetOverlappedResult(m_pipe.get(), &overlapped, &transferred, FALSE) ? worker_pool::Status::Ok : worker_pool::Status::Broken;
+            }
+
+            CancelIoEx(m_pipe.get(), &overlapped);
+            GetOverlappedResult(m_pipe.get(), &overlapped, &transferred, TRUE);
+            return result == WAIT_TIMEOUT ? worker_pool::Status::TimedOut : worker_pool::Status::Broken;
+        }
+
+        wil::unique_handle m_process;
+        wil::unique_handle m_pipe;
+        wil::unique_event_nothrow m_event;
+        MessageFraming::FrameDecoder m_decoder;
+    };
+
+    // The workers of one thumbnail provider. The job kills them together with the hosting process.
+    class Broker
+    {
+    public:
+        Broker(std::wstring exePath, worker_pool::Options options) :
+            m_exePath(std::move(exePath)),
+            m_job(CreateJobObjectW(nullptr, nullptr)),
+            m_pool(options, [this](worker_pool::Pool<WorkerProcess>::Clock::time_point deadline) {
+                return WorkerProcess::launch(m_exePath, m_job.get(), deadline);
+            })
+        {
+            if (m_job)
+            {
+                JOBOBJECT_EXTENDED_LIMIT_INFORMATION limits{};
+                limits.BasicLimitInformation.LimitFlags = JOB_OBJECT_LIMIT_KILL_ON_JOB_CLOSE;
+                SetInformationJobObject(m_job.get(), JobObjectExtendedLimitInformation, &limits, sizeof(limits));
+            }
+        }
+
+        // Renders the content of the stream to a bitmap fitting cx x cx
+        HRESULT render(IStream* stream, UINT cx, HBITMAP* phbmp)
+        {
+            STATSTG stat{};
+            HRESULT hr = stream->Stat(&stat, STATFLAG_NONAME);
+            if (FAILED(hr))
+            {
+                return hr;
+            }
+            const uint64_t contentSize = stat.cbSize.QuadPart;
+            if (contentSize == 0 || contentSize > MaxContentSize)
+            {
+                return E_FAIL;
+            }
+
+            static std::atomic<uint32_t> counter = 0;
+            const auto sectionName = std::format(L"Local\\powertoys_thumbnail_{}_{}", GetCurrentProcessId(), counter++);
+            const uint64_t resultOffset = (contentSize + 15) & ~uint64_t{ 15 };
+            const uint64_t sectionSize = resultOffset + ResultHeaderSize + uint64_t{ cx } * cx * 4;
+
+            wil::unique_handle section{ CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, static_cast<DWORD>(sectionSize >> 32), static_cast<DWORD>(sectionSize), sectionName.c_str()) };
+            if (!section)
+            {
+                return HRESULT_FROM_WIN32(GetLastError());
+            }
+            wil::unique_mapview_ptr<uint8_t> view{ static_cast<uint8_t*>(MapViewOfFile(section.get(), FILE_MAP_READ | FILE_MAP_WRITE, 0, 0, 0)) };
+            if (!view)
+            {
+                return HRESULT_FROM_WIN32(GetLastError());
+            }
+
+            // Straight into the section, the content isn't copied anywhere else
+            for (uint64_t position = 0; position < contentSize;)
+            {
+                ULONG read = 0;
+                const auto size = static_cast<ULONG>((std::min)(contentSize - position, uint64_t{ 1024 * 1024 }));
+                if (FAILED(stream->Read(view.get() + position, size, &read)) || read == 0)
+                {
+                    return E_FAIL;
+                }
+                position += read;
+            }
+
+            std::vector<uint8_t> request(RequestHeaderSize + sectionName.size() * 2);
+            const uint32_t reserved = 0;
+            const auto nameLength = static_cast<uint32_t>(sectionName.size());
+            std::memcpy(request.data(), &cx, 4);
+            std::memcpy(request.data() + 4, &reserved, 4);
+            std::memcpy(request.data() + 8, &contentSize, 8);
+            std::memcpy(request.data() + 16, &resultOffset, 8);
+            std::memcpy(request.data() + 24, &nameLength, 4);
+            std::memcpy(request.data() + RequestHeaderSize, sectionName.data(), sectionName.size() * 2);
+
+            const auto status = m_pool.run([&](WorkerProcess& worker, WorkerProcess::Clock::time_point deadline) {
+                std::vector<uint8_t> response;
+                const auto callStatus = worker.call(request, response, deadline);
+                if (callStatus != worker_pool::Status::Ok)
+                {
+                    return callStatus;
+                }
+                if (response.size() < 4)
+                {
+                    return worker_pool::Status::Broken;
+                }
+                uint32_t result;
+                std::memcpy(&result, response.data(), 4);
+                return result == StatusOk ? worker_pool::Status::Ok : worker_pool::Status::Failed;
+            });
+
+            if (status == worker_pool::Status::TimedOut)
+            {
+                return HRESULT_FROM_WIN32(ERROR_TIMEOUT);
+            }
+            if (status != worker_pool::Status::Ok)
+            {
+                return E_FAIL;
+            }
+
+            uint32_t width;
+            uint32_t height;
+            const uint8_t* result = view.get() + resultOffset;
+            std::memcpy(&width, result, 4);
+            std::memcpy(&height, result + 4, 4);
+            if (width == 0 || height == 0 || width > cx || height > cx)
+            {
+                return E_FAIL;
+            }
+
+            BITMAPINFO bmi{};
+            bmi.bmiHeader.biSize = sizeof(bmi.bmiHeader);
+            bmi.bmiHeader.biWidth = static_cast<LONG>(width);
+            bmi.bmiHeader.biHeight = -static_cast<LONG>(height);
+            bmi.bmiHeader.biPlanes = 1;
+            bmi.bmiHeader.biBitCount = 32;
+            bmi.bmiHeader.biCompression = BI_RGB;
+
+            void* bits = nullptr;
+            HBITMAP bitmap = CreateDIBSection(NULL, &bmi, DIB_RGB_COLORS, &bits, NULL, 0);
+            if (!bitmap)
+            {
+                return E_OUTOFMEMORY;
+            }
+
+            std::memcpy(bits, result + ResultHeaderSize, size_t{ width } * height * 4);
+            *phbmp = bitmap;
+            return S_OK;
+        }
+
+        worker_pool::Stats stats() const
+        {
+            return m_pool.stats();
+        }
+
+    private:
+        const std::wstring m_exePath;
+        wil::unique_handle m_job;
+        worker_pool::Pool<WorkerProcess> m_pool;
+    };
+}
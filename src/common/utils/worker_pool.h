@@ -0,0 +1,227 @@
+#pragma once
+
+#include <chrono>
+#include <concepts>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Lifecycle of a small pool of long-lived worker processes, so requests don't pay the startup of a fresh
+// process each time. Doesn't depend on Windows, the worker type wraps the actual process and transport:
+// - workers are launched on demand, up to max_workers, and reused while they're healthy
+// - a worker is recycled after max_requests requests or once it uses more than max_memory bytes
+// - a worker which timed out or broke the protocol is terminated, it might be stuck in the request
+// - a request waits at most timeout for a worker and for its result
+namespace worker_pool
+{
+    enum class Status
+    {
+        Ok,
+
+        // The worker handled the request but couldn't produce a result, it stays in the pool
+        Failed,
+
+        // No worker within the timeout or no result within the timeout
+        TimedOut,
+
+        // The worker crashed or sent something invalid
+        Broken,
+    };
+
+    struct Options
+    {
+        size_t max_workers = 2;
+        uint32_t max_requests = 100;
+        uint64_t max_memory = 512 * 1024 * 1024;
+        std::chrono::milliseconds timeout{ 30'000 };
+    };
+
+    struct Stats
+    {
+        uint64_t launched = 0;
+        uint64_t requests = 0;
+        uint64_t recycled = 0;
+        uint64_t terminated = 0;
+    };
+
+    template<typename T>
+    concept Worker = requires(T& worker, const T& constWorker) {
+        { constWorker.alive() } -> std::convertible_to<bool>;
+        { constWorker.memory_usage() } -> std::convertible_to<uint64_t>;
+        worker.terminate();
+    };
+
+    template<Worker W>
+    class Pool
+    {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        // Returns nullptr when the worker couldn't be started
+        using Launcher = std::function<std::unique_ptr<W>(Clock::time_point deadline)>;
+
+        Pool(Options options, Launcher launcher) :
+            m_options(options), m_launcher(std::move(launcher))
+        {
+        }
+
+        Pool(const Pool&) = delete;
+        Pool& operator=(const Pool&) = delete;
+
+        // The idle workers are terminated, busy ones are owned by their requests until then
+        ~Pool()
+        {
+            std::lock_guard lock{ m_mutex };
+            for (auto& entry : m_idle)
+            {
+                entry.worker->terminate();
+            }
+        }
+
+        // Runs request(W&, Clock::time_point deadline) -> Status on a warm worker
+        template<typename F>
+        Status run(F&& request)
+        {
+            const auto deadline = Clock::now() + m_options.timeout;
+            Status status = Status::Failed;
+            auto entry = acquire(deadline, status);
+            if (!entry.worker)
+            {
+                return status;
+            }
+
+            try
+            {
+                status = request(*entry.worker, deadline);
+            }
+            catch (...)
+            {
+                // The state of the worker is unknown
+                status = Status::Broken;
+            }
+            release(std::move(entry), status);
+            return status;
+        }
+
+        Stats stats() const
+        {
+            std::lock_guard lock{ m_mutex };
+            return m_stats;
+        }
+
+        size_t idle_workers() const
+        {
+            std::lock_guard lock{ m_mutex };
+            return m_idle.size();
+        }
+
+    private:
+        struct Entry
+        {
+            std::unique_ptr<W> worker;
+            uint32_t requests = 0;
+        };
+
+        Entry acquire(Clock::time_point deadline, Status& status)
+        {
+            std::unique_lock lock{ m_mutex };
+            while (true)
+            {
+                // Most recently used first, it has the warmest caches
+                while (!m_idle.empty())
+                {
+                    Entry entry = std::move(m_idle.back());
+                    m_idle.pop_back();
+                    if (entry.worker->alive())
+                    {
+                        m_busy++;
+                        return entry;
+                    }
+                    m_stats.terminated++;
+                }
+
+                if (m_busy < m_options.max_workers)
+                {
+                    // Launched without the lock, other requests can keep using the idle workers meanwhile
+                    m_busy++;
+                    lock.unlock();
+                    std::unique_ptr<W> worker;
+                    try
+                    {
+                        worker = m_launcher(deadline);
+                    }
+                    catch (...)
+                    {
+                    }
+                    lock.lock();
+
+                    if (!worker)
+                    {
+                        m_busy--;
+                        m_released.notify_one();
+                        status = Status::Failed;
+                        return {};
+                    }
+                    m_stats.launched++;
+                    return Entry{ std::move(worker) };
+                }
+
+                if (m_released.wait_until(lock, deadline) == std::cv_status::timeout)
+                {
+                    status = Status::TimedOut;
+                    return {};
+                }
+            }
+        }
+
+        void release(Entry entry, Status status)
+        {
+            entry.requests++;
+
+            bool keep = status == Status::Ok || status == Status::Failed;
+            bool recycled = false;
+            if (keep && (entry.requests >= m_options.max_requests || !entry.worker->alive() || entry.worker->memory_usage() > m_options.max_memory))
+            {
+                keep = false;
+                recycled = true;
+            }
+
+            if (!keep)
+            {
+                entry.worker->terminate();
+            }
+
+            std::lock_guard lock{ m_mutex };
+            m_busy--;
+            m_stats.requests++;
+            if (keep)
+            {
+                m_idle.push_back(std::move(entry));
+            }
+            else if (recycled)
+            {
+                m_stats.recycled++;
+            }
+            else
+            {
+                m_stats.terminated++;
+            }
+            m_released.notify_one();
+        }
+
+        const Options m_options;
+        const Launcher m_launcher;
+
+        mutable std::mutex m_mutex;
+        std::condition_variable m_released;
+        std::vector<Entry> m_idle;
+
+        // Workers handed out to requests, including those being launched
+        size_t m_busy = 0;
+        Stats m_stats;
+    };
+}
@@ -1,38 +1,33 @@
 #include "pch.h"
 
 #include "FileLocksmith.h"
+#include "HandleSnapshot.h"
+#include "KernelPathTrie.h"
 #include "NtdllExtensions.h"
 
+#include <mutex>
+
 static bool is_directory(const std::wstring path)
 {
     DWORD attributes = GetFileAttributesW(path.c_str());
     return attributes != INVALID_FILE_ATTRIBUTES && attributes & FILE_ATTRIBUTE_DIRECTORY;
 }
 
-// C++20 method
-static constexpr bool starts_with(std::wstring_view whole, std::wstring_view part)
-{
-    return whole.size() >= part.size() && whole.substr(0, part.size()) == part;
-}
-
 std::vector<ProcessResult> find_processes_recursive(const std::vector<std::wstring>& paths)
 {
     NtdllExtensions nt_ext;
 
-    // TODO use a trie!
-
-    // This maps kernel names of files within `paths` to their normal paths.
-    std::map<std::wstring, std::wstring> kernel_names_files;
-
-    // This maps kernel names of directories within `paths` to their normal paths.
-    std::map<std::wstring, std::wstring> kernel_names_dirs;
+    // Maps kernel names of files and directories within `paths` to their normal paths.
+    // Kernel names are compared case-insensitively, like the file system does by default,
+    // since handles keep the case the file was opened with.
+    KernelPathTrie selected_paths(false);
 
     for (const auto& path : paths)
     {
         auto kernel_path = nt_ext.path_to_kernel_name(path.c_str());
         if (!kernel_path.empty())
         {
-            (is_directory(path) ? kernel_names_dirs : kernel_names_files)[kernel_path] = path;
+            selected_paths.insert(kernel_path, path, is_directory(path));
         }
     }
 
@@ -42,54 +37,87 @@ std::vector<ProcessResult> find_processes_recursive(const std::vector<std::wstri
     // the search criteria. Otherwise, return an empty string.
     auto kernel_paths_contain = [&](const std::wstring& kernel_name) -> std::wstring
     {
-        // Normal equivalence
-        if (auto it = kernel_names_files.find(kernel_name); it != kernel_names_files.end())
+        return selected_paths.find(kernel_name);
+    };
+
+    auto processes = nt_ext.processes();
+
+    auto add_file = [&](ULONG_PTR pid, std::wstring&& path)
+    {
+        pid_files[pid].insert(std::move(path));
+    };
+
+    // Check all modules used by processes
+    for (const auto& process : processes)
+    {
+        for (const auto& path : process.modules)
         {
-            return it->second;
+            auto kernel_name = nt_ext.cached_path_to_kernel_name(path);
+
+            auto found_path = kernel_paths_contain(kernel_name);
+            if (!found_path.empty())
+            {
+                add_file(process.pid, std::move(found_path));
+            }
         }
+    }
+
+    // The handle snapshot is kept between calls, so that reloading only queries handles
+    // opened since the previous scan.
+    static std::mutex snapshot_mutex;
+    static HandleSnapshot snapshot;
+    std::lock_guard snapshot_lock(snapshot_mutex);
 
-        if (auto it = kernel_names_dirs.find(kernel_name); it != kernel_names_dirs.end())
+    // Check new file handles, as the scan resolves them
+    snapshot.refresh(nt_ext, [&](const NtdllExtensions::HandleInfo& handle_info)
+    {
+        auto path = kernel_paths_contain(handle_info.kernel_file_name);
+        if (!path.empty())
         {
-            return it->second;
+            add_file(handle_info.pid, std::move(path));
         }
+    });
+
+    // The kernel names in the snapshot which are within the selected paths, kept along with it.
+    // For the same paths as in the previous call only the names this refresh added are matched.
+    static std::vector<std::wstring> matched_paths;
+    static std::map<std::wstring, std::wstring> matched_kernel_names;
 
-        for (const auto& [dir_kernel_name, dir_path] : kernel_names_dirs)
+    auto match_kernel_name = [&](const std::wstring& kernel_name) {
+        auto path = kernel_paths_contain(kernel_name);
+        if (!path.empty())
         {
-            if (starts_with(kernel_name, dir_kernel_name + (dir_kernel_name.length()>0&&dir_kernel_name[dir_kernel_name.length()-1]!=L'\\' ? L"\\" : L"")))
-            {
-                return dir_path + kernel_name.substr(dir_kernel_name.size());
-            }
+            matched_kernel_names.emplace(kernel_name, std::move(path));
         }
-
-        return {};
     };
 
-    for (const auto& handle_info : nt_ext.handles())
+    if (matched_paths != paths)
     {
-        if (handle_info.type_name == L"File")
+        matched_kernel_names.clear();
+        for (const auto& [kernel_name, pids] : snapshot.pids_by_kernel_name())
         {
-            auto path = kernel_paths_contain(handle_info.kernel_file_name);
-            if (!path.empty())
-            {
-                pid_files[handle_info.pid].insert(std::move(path));
-            }
+            match_kernel_name(kernel_name);
         }
+        matched_paths = paths;
     }
-
-    // Check all modules used by processes
-    auto processes = nt_ext.processes();
-
-    for (const auto& process : processes)
+    else
     {
-        for (const auto& path : process.modules)
+        for (const auto& kernel_name : snapshot.removed_kernel_names())
+        {
+            matched_kernel_names.erase(kernel_name);
+        }
+        for (const auto& kernel_name : snapshot.added_kernel_names())
         {
-            auto kernel_name = nt_ext.path_to_kernel_name(path.c_str());
+            match_kernel_name(kernel_name);
+        }
+    }
 
-            auto found_path = kernel_paths_contain(kernel_name);
-            if (!found_path.empty())
-            {
-                pid_files[process.pid].insert(std::move(found_path));
-            }
+    // Check the file handles known from previous scans
+    for (const auto& [kernel_name, path] : matched_kernel_names)
+    {
+        for (const auto& [pid, handle_count] : snapshot.pids_by_kernel_name().at(kernel_name))
+        {
+            add_file(pid, std::wstring(path));
         }
     }
 
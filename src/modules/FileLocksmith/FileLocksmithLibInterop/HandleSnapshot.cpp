@@ -0,0 +1,93 @@
+#include "pch.h"
+
+#include "HandleSnapshot.h"
+
+void HandleSnapshot::refresh(NtdllExtensions& nt_ext, const std::function<void(const NtdllExtensions::HandleInfo&)>& on_new_handle)
+{
+    NtdllExtensions::ResolvedHandles current;
+    m_added_kernel_names.clear();
+    m_removed_kernel_names.clear();
+
+    nt_ext.handles([&](NtdllExtensions::HandleInfo&& handle_info) {
+        NtdllExtensions::HandleKey key{ handle_info.pid, handle_info.handle, handle_info.object };
+
+        // Without an object address the handle had to be queried again, so it's reported like a new one.
+        const bool known = handle_info.object && m_handles.contains(key);
+        if (!known && on_new_handle)
+        {
+            on_new_handle(handle_info);
+        }
+        current.emplace(key, std::move(handle_info.kernel_file_name));
+    }, &m_handles);
+
+    // Both maps are sorted by key, so the difference is a single merge pass.
+    auto old_it = m_handles.begin();
+    auto new_it = current.begin();
+    while (old_it != m_handles.end() || new_it != current.end())
+    {
+        if (new_it == current.end() || (old_it != m_handles.end() && old_it->first < new_it->first))
+        {
+            remove(old_it->first, old_it->second);
+            ++old_it;
+        }
+        else if (old_it == m_handles.end() || new_it->first < old_it->first)
+        {
+            add(new_it->first, new_it->second);
+            ++new_it;
+        }
+        else
+        {
+            if (old_it->second != new_it->second)
+            {
+                remove(old_it->first, old_it->second);
+                add(new_it->first, new_it->second);
+            }
+            ++old_it;
+            ++new_it;
+        }
+    }
+
+    m_handles.swap(current);
+}
+
+void HandleSnapshot::add(const NtdllExtensions::HandleKey& key, const std::wstring& kernel_name)
+{
+    // Handles to pipes, consoles and the like have no kernel file name
+    if (kernel_name.empty())
+    {
+        return;
+    }
+
+    auto [name_it, inserted] = m_pids_by_kernel_name.try_emplace(kernel_name);
+    name_it->second[key.pid]++;
+
+    // A name that was removed and added back in the same refresh didn't change
+    if (inserted && !m_removed_kernel_names.erase(kernel_name))
+    {
+        m_added_kernel_names.insert(kernel_name);
+    }
+}
+
+void HandleSnapshot::remove(const NtdllExtensions::HandleKey& key, const std::wstring& kernel_name)
+{
+    auto name_it = m_pids_by_kernel_name.find(kernel_name);
+    if (name_it == m_pids_by_kernel_name.end())
+    {
+        return;
+    }
+
+    auto& pids = name_it->second;
+    if (auto pid_it = pids.find(key.pid); pid_it != pids.end() && --pid_it->second == 0)
+    {
+        pids.erase(pid_it);
+    }
+
+    if (pids.empty())
+    {
+        m_pids_by_kernel_name.erase(name_it);
+        if (!m_added_kernel_names.erase(kernel_name))
+        {
+            m_removed_kernel_names.insert(kernel_name);
+        }
+    }
+}
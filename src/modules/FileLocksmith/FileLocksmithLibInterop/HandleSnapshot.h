@@ -0,0 +1,48 @@
+#pragma once
+
+#include "pch.h"
+
+#include "NtdllExtensions.h"
+
+#include <functional>
+
+// The file handles found by the last scan, indexed by kernel name.
+// Refreshing diffs the new handle table against the previous one: entries that didn't change
+// keep their kernel name without being queried again, and the index is only updated for
+// handles that were opened or closed in between.
+class HandleSnapshot
+{
+public:
+    // Number of handles each process holds to a file
+    using PidHandleCounts = std::map<ULONG_PTR, size_t>;
+
+    // Rescans the handle table. on_new_handle is called on the calling thread for each handle
+    // that wasn't in the previous snapshot, as soon as it's resolved.
+    void refresh(NtdllExtensions& nt_ext, const std::function<void(const NtdllExtensions::HandleInfo&)>& on_new_handle);
+
+    const std::map<std::wstring, PidHandleCounts>& pids_by_kernel_name() const
+    {
+        return m_pids_by_kernel_name;
+    }
+
+    // Kernel names the last refresh added to the index, and the ones it removed
+    const std::set<std::wstring>& added_kernel_names() const
+    {
+        return m_added_kernel_names;
+    }
+
+    const std::set<std::wstring>& removed_kernel_names() const
+    {
+        return m_removed_kernel_names;
+    }
+
+private:
+    void add(const NtdllExtensions::HandleKey& key, const std::wstring& kernel_name);
+    void remove(const NtdllExtensions::HandleKey& key, const std::wstring& kernel_name);
+
+    // Ordered by pid first, so the handles of a process are a contiguous range
+    NtdllExtensions::ResolvedHandles m_handles;
+    std::map<std::wstring, PidHandleCounts> m_pids_by_kernel_name;
+    std::set<std::wstring> m_added_kernel_names;
+    std::set<std::wstring> m_removed_kernel_names;
+};
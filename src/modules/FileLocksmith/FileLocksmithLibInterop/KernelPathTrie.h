@@ -0,0 +1,165 @@
+#pragma once
+
+#include <algorithm>
+#include <cwctype>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+
+// Maps the kernel names of the selected files and directories to their normal paths,
+// so that the kernel name of every open handle in the system can be resolved in
+// O(path depth) instead of probing every selected directory.
+// Paths are split on '\' into components, so "\Device\HarddiskVolume3\" (a volume root)
+// and "\Device\HarddiskVolume3\dir" share their first two nodes.
+// This header has no Windows dependencies.
+class KernelPathTrie
+{
+public:
+    explicit KernelPathTrie(bool case_sensitive) :
+        m_root(std::make_unique<Node>(ComponentLess{ case_sensitive })),
+        m_case_sensitive(case_sensitive)
+    {
+    }
+
+    // A file only matches itself. A directory matches itself and everything below it.
+    void insert(std::wstring_view kernel_name, std::wstring path, bool is_directory)
+    {
+        Node* node = m_root.get();
+        for_each_component(kernel_name, [&](std::wstring_view component, size_t) {
+            auto it = node->children.find(component);
+            if (it == node->children.end())
+            {
+                it = node->children.emplace(std::wstring(component), std::make_unique<Node>(ComponentLess{ m_case_sensitive })).first;
+            }
+            node = it->second.get();
+            return true;
+        });
+
+        (is_directory ? node->directory_path : node->file_path) = std::move(path);
+    }
+
+    // Returns the normal path of the file specified by kernel_name, if it is one of the
+    // selected files or lies within one of the selected directories. Otherwise, returns
+    // an empty string.
+    std::wstring find(std::wstring_view kernel_name) const
+    {
+        const Node* node = m_root.get();
+
+        // The shallowest selected directory on the way down wins
+        const std::wstring* directory_match = nullptr;
+        size_t directory_end = 0;
+
+        for_each_component(kernel_name, [&](std::wstring_view component, size_t end) {
+            auto it = node->children.find(component);
+            if (it == node->children.end())
+            {
+                node = nullptr;
+                return false;
+            }
+            node = it->second.get();
+            if (!directory_match && node->directory_path)
+            {
+                directory_match = &*node->directory_path;
+                directory_end = end;
+            }
+            return true;
+        });
+
+        if (node && node != m_root.get() && node->file_path)
+        {
+            return *node->file_path;
+        }
+
+        if (!directory_match)
+        {
+            return {};
+        }
+
+        // Append what follows the directory, keeping exactly one separator between them
+        std::wstring result = *directory_match;
+        auto rest = kernel_name.substr(directory_end);
+        while (!rest.empty() && rest.front() == L'\\')
+        {
+            rest.remove_prefix(1);
+        }
+        if (!rest.empty())
+        {
+            if (!result.empty() && result.back() != L'\\')
+            {
+                result.push_back(L'\\');
+            }
+            result.append(rest);
+        }
+        return result;
+    }
+
+    bool empty() const
+    {
+        return m_root->children.empty();
+    }
+
+private:
+    struct ComponentLess
+    {
+        using is_transparent = void;
+        bool case_sensitive = true;
+
+        bool operator()(std::wstring_view lhs, std::wstring_view rhs) const
+        {
+            if (case_sensitive)
+            {
+                return lhs < rhs;
+            }
+
+            const size_t length = (std::min)(lhs.size(), rhs.size());
+            for (size_t i = 0; i < length; i++)
+            {
+                const auto l = std::towupper(lhs[i]);
+                const auto r = std::towupper(rhs[i]);
+                if (l != r)
+                {
+                    return l < r;
+                }
+            }
+            return lhs.size() < rhs.size();
+        }
+    };
+
+    struct Node
+    {
+        explicit Node(ComponentLess less) :
+            children(less)
+        {
+        }
+
+        std::map<std::wstring, std::unique_ptr<Node>, ComponentLess> children;
+        std::optional<std::wstring> file_path;
+        std::optional<std::wstring> directory_path;
+    };
+
+    // Calls callback(component, end offset of the component) for each non-empty
+    // component until it returns false
+    template<typename Callback>
+    static void for_each_component(std::wstring_view path, Callback&& callback)
+    {
+        size_t start = 0;
+        while (start < path.size())
+        {
+            size_t end = path.find(L'\\', start);
+            if (end == std::wstring_view::npos)
+            {
+                end = path.size();
+            }
+            if (end > start && !callback(path.substr(start, end - start), end))
+            {
+                return;
+            }
+            start = end + 1;
+        }
+    }
+
+    std::unique_ptr<Node> m_root;
+    bool m_case_sensitive;
+};
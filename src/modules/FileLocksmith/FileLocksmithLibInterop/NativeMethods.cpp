@@ -1,6 +1,7 @@
 #include "pch.h"
 #include "NativeMethods.h"
 #include "FileLocksmith.h"
+#include "NtdllExtensions.h"
 #include "../FileLocksmithLib/Constants.h"
 
 namespace winrt::PowerToys::FileLocksmithLib::Interop::implementation
@@ -54,6 +55,11 @@ namespace winrt::PowerToys::FileLocksmithLib::Interop::implementation
         return com_array<ProcessResult>{ result.begin(), result.end() };
     }
 
+    uint64_t NativeMethods::AbandonedHandleScanWorkers()
+    {
+        return NtdllExtensions::abandoned_handle_scan_workers();
+    }
+
     hstring NativeMethods::PidToFullPath(uint32_t pid)
     {
         return hstring{ pid_to_full_path(pid) };
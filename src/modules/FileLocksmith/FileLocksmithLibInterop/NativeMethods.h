@@ -8,6 +8,7 @@ namespace winrt::PowerToys::FileLocksmithLib::Interop::implementation
         NativeMethods() = default;
 
         static com_array<winrt::PowerToys::FileLocksmithLib::Interop::ProcessResult> FindProcessesRecursive(array_view<hstring const> paths);
+        static uint64_t AbandonedHandleScanWorkers();
         static hstring PidToFullPath(uint32_t pid);
         static com_array<hstring> ReadPathsFromFile();
         static bool StartAsElevated(array_view<hstring const> paths);
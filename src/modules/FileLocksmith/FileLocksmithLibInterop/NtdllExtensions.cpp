@@ -3,6 +3,9 @@
 #include "NtdllExtensions.h"
 #include <thread>
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
 
 #define STATUS_INFO_LENGTH_MISMATCH ((LONG)0xC0000004)
 
@@ -152,139 +155,379 @@ std::wstring NtdllExtensions::path_to_kernel_name(LPCWSTR path)
     return kernel_name;
 }
 
+std::wstring NtdllExtensions::cached_path_to_kernel_name(const std::wstring& path)
+{
+    static std::mutex cache_mutex;
+    static std::map<std::wstring, std::wstring> cache;
+
+    {
+        std::lock_guard lock(cache_mutex);
+        if (auto it = cache.find(path); it != cache.end())
+        {
+            return it->second;
+        }
+    }
+
+    auto kernel_name = path_to_kernel_name(path.c_str());
+
+    // Failures aren't remembered, the path may become accessible later.
+    if (!kernel_name.empty())
+    {
+        std::lock_guard lock(cache_mutex);
+        cache.emplace(path, kernel_name);
+    }
+
+    return kernel_name;
+}
+
+std::atomic<int> NtdllExtensions::s_file_object_type_index = -1;
+std::atomic<size_t> NtdllExtensions::s_abandoned_handle_scan_workers = 0;
+
+int NtdllExtensions::file_object_type_index(const SYSTEM_HANDLE_INFORMATION_EX* info, HANDLE probe_handle)
+{
+    int index = s_file_object_type_index;
+    if (index >= 0 || probe_handle == INVALID_HANDLE_VALUE)
+    {
+        return index;
+    }
+
+    // Find the handle we opened ourselves; its type is "File" by construction.
+    const auto pid = static_cast<ULONG_PTR>(GetCurrentProcessId());
+    for (ULONG_PTR i = 0; i < info->NumberOfHandles; i++)
+    {
+        const auto& entry = info->Handles[i];
+        if (entry.UniqueProcessId == pid && entry.HandleValue == reinterpret_cast<ULONG_PTR>(probe_handle))
+        {
+            s_file_object_type_index = entry.ObjectTypeIndex;
+            return entry.ObjectTypeIndex;
+        }
+    }
+
+    return -1;
+}
+
+namespace
+{
+    // State of one handle scan worker. Workers own a contiguous range of handle table
+    // entries that never splits a process, so each process is opened by a single worker.
+    struct HandleScanWorker
+    {
+        std::vector<const Ntdll::SYSTEM_HANDLE_TABLE_ENTRY_INFO_EX*> entries;
+        std::atomic<size_t> next = 0;
+        std::atomic<bool> finished = false;
+
+        // Set when the thread hangs. It stops once the call it's stuck on returns.
+        std::atomic<bool> abandoned = false;
+        std::thread thread;
+        size_t previous_next = 0;
+    };
+
+    // What the worker threads use. Threads that hang are abandoned, so this is shared with
+    // them and lives until the last of them is done, which may be after the scan returned.
+    struct HandleScanState
+    {
+        explicit HandleScanState(const NtdllExtensions& ntdll) :
+            ntdll(ntdll)
+        {
+        }
+
+        NtdllExtensions ntdll;
+        std::vector<BYTE> handle_table;
+        std::mutex results_mutex;
+        std::condition_variable results_available;
+        std::vector<NtdllExtensions::HandleInfo> results;
+    };
+
+    // The threads of abandoned workers, joined by later scans once they return
+    struct AbandonedHandleScanWorkers
+    {
+        std::mutex mutex;
+        std::vector<std::shared_ptr<HandleScanWorker>> workers;
+
+        // Never destroyed, destroying a thread that wasn't joined terminates the process
+        static AbandonedHandleScanWorkers& instance()
+        {
+            static auto abandoned = new AbandonedHandleScanWorkers();
+            return *abandoned;
+        }
+
+        // Joins the threads that are done and returns how many are still hanging
+        size_t join_finished()
+        {
+            std::lock_guard lock(mutex);
+            std::erase_if(workers, [](auto& worker) {
+                if (!worker->finished)
+                {
+                    return false;
+                }
+                worker->thread.join();
+                return true;
+            });
+            return workers.size();
+        }
+
+        void add(std::shared_ptr<HandleScanWorker> worker)
+        {
+            std::lock_guard lock(mutex);
+            workers.push_back(std::move(worker));
+        }
+    };
+}
+
 std::vector<NtdllExtensions::HandleInfo> NtdllExtensions::handles() noexcept
 {
+    std::vector<HandleInfo> result;
+    handles([&](HandleInfo&& handle_info) { result.push_back(std::move(handle_info)); });
+    return result;
+}
+
+void NtdllExtensions::handles(const std::function<void(HandleInfo&&)>& on_handle, const ResolvedHandles* previous) noexcept
+{
+    // Keep a file handle of our own open while taking the snapshot to learn the "File" type index.
+    HANDLE probe_handle = INVALID_HANDLE_VALUE;
+    if (s_file_object_type_index < 0)
+    {
+        probe_handle = CreateFileW(L"NUL", 0, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, 0, NULL);
+    }
+
     auto get_info_result = NtQuerySystemInformationMemoryLoop(SystemExtendedHandleInformation);
     if (NT_ERROR(get_info_result.status))
     {
-        return {};
+        if (probe_handle != INVALID_HANDLE_VALUE)
+        {
+            CloseHandle(probe_handle);
+        }
+        return;
     }
 
-    auto info_ptr = reinterpret_cast<SYSTEM_HANDLE_INFORMATION_EX*>(get_info_result.memory.data());
+    auto state = std::make_shared<HandleScanState>(*this);
+    state->handle_table = std::move(get_info_result.memory);
+    auto info_ptr = reinterpret_cast<SYSTEM_HANDLE_INFORMATION_EX*>(state->handle_table.data());
 
-    std::map<ULONG_PTR, HANDLE> pid_to_handle;
-    std::vector<HandleInfo> result;
+    // Without the type index, every handle has to be duplicated and have its type queried,
+    // which is what the workers fall back to.
+    const int file_type_index = file_object_type_index(info_ptr, probe_handle);
+    if (probe_handle != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(probe_handle);
+    }
 
-    std::vector<BYTE> object_info_buffer(DefaultResultBufferSize);
+    std::vector<const SYSTEM_HANDLE_TABLE_ENTRY_INFO_EX*> entries;
+    for (ULONG_PTR i = 0; i < info_ptr->NumberOfHandles; i++)
+    {
+        const auto& entry = info_ptr->Handles[i];
+        if (file_type_index >= 0 && entry.ObjectTypeIndex != file_type_index)
+        {
+            continue;
+        }
+
+        // The same handle to the same object still refers to the same file.
+        if (previous && entry.Object)
+        {
+            if (auto it = previous->find(HandleKey{ entry.UniqueProcessId, entry.HandleValue, entry.Object }); it != previous->end())
+            {
+                on_handle(HandleInfo{ entry.UniqueProcessId, entry.HandleValue, entry.Object, it->second });
+                continue;
+            }
+        }
 
-    std::atomic<ULONG> i = 0;
-    std::atomic<ULONG_PTR> handle_count = info_ptr->NumberOfHandles;
-    std::atomic<HANDLE> process_handle = NULL;
-    std::atomic<HANDLE> handle_copy = NULL;
-    ULONG previous_i;
+        entries.push_back(&entry);
+    }
 
+    std::stable_sort(entries.begin(), entries.end(), [](auto lhs, auto rhs) { return lhs->UniqueProcessId < rhs->UniqueProcessId; });
 
-    while (i < handle_count)
+    // Partition by process across a bounded number of workers
+    const size_t worker_count = std::clamp<size_t>(std::thread::hardware_concurrency(), 1, MaxHandleScanWorkers);
+    const size_t target_size = (entries.size() + worker_count - 1) / worker_count;
+    std::vector<std::shared_ptr<HandleScanWorker>> workers;
+    for (size_t i = 0; i < entries.size(); i++)
     {
-        previous_i = i;
+        if (workers.empty() || (workers.back()->entries.size() >= target_size && entries[i]->UniqueProcessId != entries[i - 1]->UniqueProcessId))
+        {
+            workers.push_back(std::make_shared<HandleScanWorker>());
+        }
+        workers.back()->entries.push_back(entries[i]);
+    }
+
+    auto scan = [state, file_type_index](std::shared_ptr<HandleScanWorker> worker) {
+        std::vector<BYTE> object_info_buffer(DefaultResultBufferSize);
+        std::map<ULONG_PTR, HANDLE> pid_to_handle;
+
+        for (; worker->next < worker->entries.size() && !worker->abandoned; worker->next++)
+        {
+            auto handle_info = worker->entries[worker->next];
+            auto pid = handle_info->UniqueProcessId;
 
-        // The system calls we use in this block were reported to hang on some machines.
-        // We need to offload the cycle to another thread and keep track of progress to terminate and resume when needed.
-        // Unfortunately, there are no alternative APIs to what we're using that accept timeouts. (NtQueryObject and GetFileType)
-        auto offload_function = std::thread([&] {
-            for (; i < handle_count; i++)
+            HANDLE process_handle = NULL;
+            auto iter = pid_to_handle.find(pid);
+            if (iter != pid_to_handle.end())
             {
-                process_handle = NULL;
-                handle_copy = NULL;
+                process_handle = iter->second;
+            }
+            else
+            {
+                process_handle = OpenProcess(PROCESS_DUP_HANDLE, FALSE, static_cast<DWORD>(pid));
+                pid_to_handle[pid] = process_handle;
+            }
 
-                auto handle_info = info_ptr->Handles + i;
-                auto pid = handle_info->UniqueProcessId;
+            if (!process_handle)
+            {
+                continue;
+            }
+
+            // According to this:
+            // https://stackoverflow.com/questions/46384048/enumerate-handles
+            // NtQueryObject could hang
 
-                auto iter = pid_to_handle.find(pid);
-                if (iter != pid_to_handle.end())
+            // TODO uncomment and investigate
+            // if (handle_info->GrantedAccess == 0x0012019f) {
+            //     continue;
+            // }
+
+            HANDLE local_handle_copy;
+            auto dh_result = DuplicateHandle(process_handle, reinterpret_cast<HANDLE>(handle_info->HandleValue), GetCurrentProcess(), &local_handle_copy, 0, 0, DUPLICATE_SAME_ACCESS);
+            if (dh_result == 0)
+            {
+                // Ignore this handle.
+                continue;
+            }
+
+            bool is_file = file_type_index >= 0;
+            if (!is_file)
+            {
+                ULONG return_length;
+                auto status = state->ntdll.NtQueryObject(local_handle_copy, ObjectTypeInformation, object_info_buffer.data(), static_cast<ULONG>(object_info_buffer.size()), &return_length);
+                if (NT_SUCCESS(status))
                 {
-                    process_handle = iter->second;
+                    auto object_type_info = reinterpret_cast<OBJECT_TYPE_INFORMATION*>(object_info_buffer.data());
+                    is_file = unicode_to_view(object_type_info->Name) == L"File";
+                    if (is_file)
+                    {
+                        s_file_object_type_index = handle_info->ObjectTypeIndex;
+                    }
                 }
-                else
+            }
+
+            if (is_file)
+            {
+                auto file_name = state->ntdll.file_handle_to_kernel_name(local_handle_copy, object_info_buffer);
                 {
-                    process_handle = OpenProcess(PROCESS_DUP_HANDLE, FALSE, static_cast<DWORD>(pid));
-                    if (!process_handle)
+                    // The entries after this one belong to another worker once it's abandoned
+                    std::lock_guard lock(state->results_mutex);
+                    if (!worker->abandoned)
                     {
-                        continue;
+                        state->results.push_back(HandleInfo{ pid, handle_info->HandleValue, handle_info->Object, std::move(file_name) });
                     }
-                    pid_to_handle[pid] = process_handle;
                 }
+                state->results_available.notify_one();
+            }
 
-                // According to this:
-                // https://stackoverflow.com/questions/46384048/enumerate-handles
-                // NtQueryObject could hang
-
-                // TODO uncomment and investigate
-                // if (handle_info->GrantedAccess == 0x0012019f) {
-                //     continue;
-                // }
+            CloseHandle(local_handle_copy);
+        }
 
-                HANDLE local_handle_copy;
-                auto dh_result = DuplicateHandle(process_handle, reinterpret_cast<HANDLE>(handle_info->HandleValue), GetCurrentProcess(), &local_handle_copy, 0, 0, DUPLICATE_SAME_ACCESS);
-                if (dh_result == 0)
-                {
-                    // Ignore this handle.
-                    continue;
-                }
-                handle_copy = local_handle_copy;
+        for (auto [pid, handle] : pid_to_handle)
+        {
+            if (handle)
+            {
+                CloseHandle(handle);
+            }
+        }
 
-                ULONG return_length;
-                auto status = NtQueryObject(handle_copy, ObjectTypeInformation, object_info_buffer.data(), static_cast<ULONG>(object_info_buffer.size()), &return_length);
-                if (NT_ERROR(status))
-                {
-                    // Ignore this handle.
-                    CloseHandle(handle_copy);
-                    handle_copy = NULL;
-                    continue;
-                }
+        worker->finished = true;
+        state->results_available.notify_one();
+    };
 
-                auto object_type_info = reinterpret_cast<OBJECT_TYPE_INFORMATION*>(object_info_buffer.data());
-                auto type_name = unicode_to_str(object_type_info->Name);
+    for (auto& worker : workers)
+    {
+        worker->thread = std::thread(scan, worker);
+    }
 
-                std::wstring file_name;
+    // The system calls the workers use were reported to hang on some machines, and there are
+    // no alternatives to them that accept timeouts (NtQueryObject and GetFileType).
+    // Results are forwarded as they arrive, and every watchdog period workers that made no
+    // progress are abandoned and replaced by one that resumes after the handle they're stuck on.
+    constexpr auto watchdog_period = std::chrono::milliseconds(200);
+    auto next_watchdog_check = std::chrono::steady_clock::now() + watchdog_period;
+    bool all_finished = false;
+    while (!all_finished)
+    {
+        std::vector<HandleInfo> pending;
+        {
+            std::unique_lock lock(state->results_mutex);
+            state->results_available.wait_until(lock, next_watchdog_check, [&] {
+                return !state->results.empty() || std::all_of(workers.begin(), workers.end(), [](auto& worker) { return worker->finished.load(); });
+            });
+            pending.swap(state->results);
+        }
 
-                if (type_name == L"File")
-                {
-                    file_name = file_handle_to_kernel_name(handle_copy, object_info_buffer);
-                    result.push_back(HandleInfo{ pid, handle_info->HandleValue, type_name, file_name });
-                }
+        for (auto& handle_info : pending)
+        {
+            on_handle(std::move(handle_info));
+        }
 
-                CloseHandle(handle_copy);
-                handle_copy = NULL;
-            }
-        });
+        all_finished = std::all_of(workers.begin(), workers.end(), [](auto& worker) { return worker->finished.load(); });
+        if (all_finished || std::chrono::steady_clock::now() < next_watchdog_check)
+        {
+            continue;
+        }
+        next_watchdog_check = std::chrono::steady_clock::now() + watchdog_period;
 
-        offload_function.detach();
-        do
+        for (auto& worker : workers)
         {
-            Sleep(200); // Timeout in milliseconds for detecting that the system hang on getting information for a handle.
-            if (i >= handle_count)
+            if (worker->finished)
             {
-                // We're done.
-                break;
+                continue;
             }
 
-            if (previous_i >= i)
+            size_t next;
             {
-                // The thread looks like it's hanging on some handle. Let's kill it and resume.
-
-                // HACK: This is unsafe and may leak something, but looks like there's no way to properly clean up a thread when it's hanging on a system call.
-                TerminateThread(offload_function.native_handle(), 1);
-
-                // Close Handles that might be lingering.
-                if (handle_copy!=NULL)
+                // Decided under the lock, so the worker can't report a handle past the one it's stuck on
+                std::lock_guard lock(state->results_mutex);
+                next = worker->next;
+                if (worker->previous_next < next)
                 {
-                    CloseHandle(handle_copy);
+                    worker->previous_next = next;
+                    continue;
                 }
-                i++;
-                break;
+                worker->abandoned = true;
             }
-            previous_i = i;
-        } while (1);
 
+            // The thread looks like it's hanging on some handle. Terminating it could leave the locks
+            // it holds (the heap, the loader lock) taken for good, so it's left to return on its own
+            // and joined by a later scan.
+            auto& abandoned = AbandonedHandleScanWorkers::instance();
+            const bool replace = abandoned.join_finished() < MaxAbandonedHandleScanWorkers;
+            s_abandoned_handle_scan_workers++;
+
+            auto replacement = std::make_shared<HandleScanWorker>();
+            if (replace)
+            {
+                replacement->entries.assign(worker->entries.begin() + (std::min)(next + 1, worker->entries.size()), worker->entries.end());
+                replacement->thread = std::thread(scan, replacement);
+            }
+            else
+            {
+                // Too many threads hang already, the rest of the entries are skipped
+                replacement->finished = true;
+            }
+            abandoned.add(std::exchange(worker, std::move(replacement)));
+        }
     }
 
-    for (auto [pid, handle] : pid_to_handle)
+    for (auto& worker : workers)
     {
-        CloseHandle(handle);
+        if (worker->thread.joinable())
+        {
+            worker->thread.join();
+        }
     }
+    AbandonedHandleScanWorkers::instance().join_finished();
 
-    return result;
+    // Results pushed right before the last worker finished
+    for (auto& handle_info : state->results)
+    {
+        on_handle(std::move(handle_info));
+    }
 }
 
 // Returns the list of all processes.
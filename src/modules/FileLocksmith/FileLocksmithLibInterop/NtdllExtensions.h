@@ -4,6 +4,10 @@
 
 #include "NtdllBase.h"
 
+#include <atomic>
+#include <compare>
+#include <functional>
+
 class NtdllExtensions : protected Ntdll
 {
 private:
@@ -13,6 +17,13 @@ private:
     constexpr static int ObjectNameInformation = 1;
     constexpr static int SystemExtendedHandleInformation = 64;
 
+    // Upper bound for the threads scanning the system handle table
+    constexpr static unsigned MaxHandleScanWorkers = 8;
+
+    // Upper bound for the hung scan threads still waiting to return. Past it, the entries of
+    // a worker that hangs are skipped instead of handed to a new thread.
+    constexpr static size_t MaxAbandonedHandleScanWorkers = 8;
+
     struct MemoryLoopResult
     {
         NTSTATUS status = 0;
@@ -24,6 +35,13 @@ private:
 
     std::wstring file_handle_to_kernel_name(HANDLE file_handle, std::vector<BYTE>& buffer);
 
+    // Object type indices are assigned at boot, so the index of the "File" type is looked up
+    // once per process. Returns -1 if it isn't known yet.
+    static int file_object_type_index(const SYSTEM_HANDLE_INFORMATION_EX* info, HANDLE probe_handle);
+    static std::atomic<int> s_file_object_type_index;
+
+    static std::atomic<size_t> s_abandoned_handle_scan_workers;
+
 public:
     struct ProcessInfo
     {
@@ -33,24 +51,55 @@ public:
         std::vector<std::wstring> modules;
     };
 
+    // A file handle held by some process
     struct HandleInfo
     {
         ULONG_PTR pid;
         ULONG_PTR handle;
-        std::wstring type_name;
+        PVOID object;
         std::wstring kernel_file_name;
     };
 
+    // Identifies a handle table entry across scans. The kernel object address is only
+    // reported to callers with SeDebugPrivilege; without it, entries can't be recognized.
+    struct HandleKey
+    {
+        ULONG_PTR pid;
+        ULONG_PTR handle;
+        PVOID object;
+
+        auto operator<=>(const HandleKey&) const = default;
+    };
+
+    // Kernel names of the file handles found by a previous scan
+    using ResolvedHandles = std::map<HandleKey, std::wstring>;
+
     std::wstring file_handle_to_kernel_name(HANDLE file_handle);
 
     std::wstring path_to_kernel_name(LPCWSTR path);
 
+    // Same as path_to_kernel_name, but remembers the results for the lifetime of the process.
+    // Meant for paths that repeat across processes and scans, like module paths.
+    std::wstring cached_path_to_kernel_name(const std::wstring& path);
+
     // Gives the user name of the account running this process
     std::wstring pid_to_user(DWORD pid);
 
+    // Returns the file handles of all processes.
     std::vector<HandleInfo> handles() noexcept;
 
+    // Calls on_handle for each file handle of all processes as soon as it's resolved.
+    // on_handle is always called on the calling thread.
+    // Entries found in previous are reported first, without being queried again.
+    void handles(const std::function<void(HandleInfo&&)>& on_handle, const ResolvedHandles* previous = nullptr) noexcept;
+
     // Returns the list of all processes.
     // On failure, returns an empty vector.
     std::vector<ProcessInfo> processes() noexcept;
+
+    // Number of handle scan workers that hung and were abandoned since the process started
+    static size_t abandoned_handle_scan_workers() noexcept
+    {
+        return s_abandoned_handle_scan_workers;
+    }
 };
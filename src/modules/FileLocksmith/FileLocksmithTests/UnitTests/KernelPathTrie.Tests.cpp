@@ -0,0 +1,155 @@
+#include "pch.h"
+#include <modules/FileLocksmith/FileLocksmithLibInterop/KernelPathTrie.h>
+
+#include <map>
+#include <random>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace FileLocksmithUnitTests
+{
+    namespace
+    {
+        const std::wstring volume = L"\\Device\\HarddiskVolume3";
+
+        // The lookup FileLocksmith did before the trie: the exact names, then every selected directory in turn
+        std::wstring FindInMaps(const std::map<std::wstring, std::wstring>& files, const std::map<std::wstring, std::wstring>& dirs, const std::wstring& kernelName)
+        {
+            if (auto it = files.find(kernelName); it != files.end())
+            {
+                return it->second;
+            }
+            if (auto it = dirs.find(kernelName); it != dirs.end())
+            {
+                return it->second;
+            }
+            for (const auto& [dirKernelName, dirPath] : dirs)
+            {
+                const auto prefix = dirKernelName.back() != L'\\' ? dirKernelName + L"\\" : dirKernelName;
+                if (kernelName.starts_with(prefix))
+                {
+                    return dirPath + kernelName.substr(dirKernelName.size());
+                }
+            }
+            return {};
+        }
+
+        // Paths under the volume made of few names, so that the selection and the handles overlap
+        std::wstring RandomPath(std::mt19937& random)
+        {
+            static const wchar_t* names[] = { L"a", L"b", L"ab", L"a.txt" };
+            std::wstring path;
+            const auto depth = 1 + random() % 4;
+            for (size_t i = 0; i < depth; i++)
+            {
+                path += L"\\";
+                path += names[random() % std::size(names)];
+            }
+            return path;
+        }
+    }
+
+    TEST_CLASS (KernelPathTrieUnitTests)
+    {
+    public:
+        TEST_METHOD (FilesMatchOnlyThemselves)
+        {
+            KernelPathTrie trie(true);
+            trie.insert(volume + L"\\Users\\me\\notes.txt", L"C:\\Users\\me\\notes.txt", false);
+
+            Assert::AreEqual(std::wstring(L"C:\\Users\\me\\notes.txt"), trie.find(volume + L"\\Users\\me\\notes.txt"));
+            Assert::AreEqual(std::wstring(), trie.find(volume + L"\\Users\\me\\notes.txt\\stream"));
+            Assert::AreEqual(std::wstring(), trie.find(volume + L"\\Users\\me\\notes.txt.bak"));
+            Assert::AreEqual(std::wstring(), trie.find(volume + L"\\Users\\me"));
+        }
+
+        TEST_METHOD (DirectoriesMatchTheirContents)
+        {
+            KernelPathTrie trie(true);
+            trie.insert(volume + L"\\Users\\me", L"C:\\Users\\me", true);
+
+            Assert::AreEqual(std::wstring(L"C:\\Users\\me"), trie.find(volume + L"\\Users\\me"));
+            Assert::AreEqual(std::wstring(L"C:\\Users\\me\\a\\b.txt"), trie.find(volume + L"\\Users\\me\\a\\b.txt"));
+
+            // Not a sibling which starts with the same name
+            Assert::AreEqual(std::wstring(), trie.find(volume + L"\\Users\\meme\\b.txt"));
+            Assert::AreEqual(std::wstring(), trie.find(volume + L"\\Users"));
+            Assert::AreEqual(std::wstring(), trie.find(L"\\Device\\HarddiskVolume4\\Users\\me\\b.txt"));
+        }
+
+        TEST_METHOD (VolumeRoots)
+        {
+            KernelPathTrie trie(true);
+            trie.insert(volume + L"\\", L"C:\\", true);
+
+            Assert::AreEqual(std::wstring(L"C:\\Windows\\notepad.exe"), trie.find(volume + L"\\Windows\\notepad.exe"));
+            Assert::AreEqual(std::wstring(L"C:\\"), trie.find(volume + L"\\"));
+            Assert::AreEqual(std::wstring(), trie.find(L"\\Device\\HarddiskVolume31\\Windows\\notepad.exe"));
+        }
+
+        TEST_METHOD (ShallowestDirectoryWins)
+        {
+            KernelPathTrie trie(true);
+            trie.insert(volume + L"\\a\\b", L"C:\\a\\b", true);
+            trie.insert(volume + L"\\a", L"C:\\a", true);
+            trie.insert(volume + L"\\a\\b\\c.txt", L"C:\\a\\b\\c.txt", false);
+
+            Assert::AreEqual(std::wstring(L"C:\\a\\b\\d.txt"), trie.find(volume + L"\\a\\b\\d.txt"));
+
+            // An exact file still wins over the directories above it
+            Assert::AreEqual(std::wstring(L"C:\\a\\b\\c.txt"), trie.find(volume + L"\\a\\b\\c.txt"));
+        }
+
+        TEST_METHOD (CaseInsensitive)
+        {
+            KernelPathTrie insensitive(false);
+            insensitive.insert(volume + L"\\Users\\Me", L"C:\\Users\\Me", true);
+            Assert::AreEqual(std::wstring(L"C:\\Users\\Me\\File.TXT"), insensitive.find(L"\\DEVICE\\HARDDISKVOLUME3\\users\\me\\File.TXT"));
+
+            KernelPathTrie sensitive(true);
+            sensitive.insert(volume + L"\\Users\\Me", L"C:\\Users\\Me", true);
+            Assert::AreEqual(std::wstring(), sensitive.find(L"\\DEVICE\\HARDDISKVOLUME3\\users\\me\\File.TXT"));
+        }
+
+        TEST_METHOD (Empty)
+        {
+            KernelPathTrie trie(true);
+            Assert::IsTrue(trie.empty());
+            Assert::AreEqual(std::wstring(), trie.find(volume + L"\\a"));
+            Assert::AreEqual(std::wstring(), trie.find(L""));
+
+            trie.insert(volume + L"\\a", L"C:\\a", false);
+            Assert::IsFalse(trie.empty());
+        }
+
+        TEST_METHOD (SameResultsAsTheMaps)
+        {
+            std::mt19937 random{ 29 };
+            for (int round = 0; round < 200; round++)
+            {
+                // Every kernel name is either a file or a directory, and its normal path is the one on C:
+                std::map<std::wstring, bool> selection;
+                const auto count = random() % 6;
+                for (size_t i = 0; i < count; i++)
+                {
+                    selection.emplace(RandomPath(random), random() % 2 == 0);
+                }
+
+                KernelPathTrie trie(true);
+                std::map<std::wstring, std::wstring> files;
+                std::map<std::wstring, std::wstring> dirs;
+                for (const auto& [path, isDirectory] : selection)
+                {
+                    trie.insert(volume + path, L"C:" + path, isDirectory);
+                    (isDirectory ? dirs : files)[volume + path] = L"C:" + path;
+                }
+
+                for (int query = 0; query < 100; query++)
+                {
+                    const auto kernelName = volume + RandomPath(random);
+                    Assert::AreEqual(FindInMaps(files, dirs, kernelName), trie.find(kernelName));
+                }
+            }
+        }
+    };
+}
@@ -0,0 +1,13 @@
+//{{NO_DEPENDENCIES}}
+// Microsoft Visual C++ generated include file.
+// Used by UnitTests-FileLocksmith.rc
+
+//////////////////////////////
+// Non-localizable
+
+#define FILE_DESCRIPTION "PowerToys UnitTests-FileLocksmith"
+#define INTERNAL_NAME "UnitTests-FileLocksmith"
+#define ORIGINAL_FILENAME "UnitTests-FileLocksmith.dll"
+
+// Non-localizable
+//////////////////////////////
@@ -114,7 +114,14 @@ namespace PowerToys.FileLocksmithUI.ViewModels
             var results = new List<ProcessResult>();
             await Task.Run(() =>
             {
+                var abandonedWorkers = NativeMethods.AbandonedHandleScanWorkers();
                 results = NativeMethods.FindProcessesRecursive(paths)?.ToList();
+
+                abandonedWorkers = NativeMethods.AbandonedHandleScanWorkers() - abandonedWorkers;
+                if (abandonedWorkers > 0)
+                {
+                    Logger.LogWarning($"{abandonedWorkers} handle scan threads hung and were abandoned, the results may be incomplete.");
+                }
             });
             return results;
         }
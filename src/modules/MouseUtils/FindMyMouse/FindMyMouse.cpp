@@ -71,7 +71,7 @@ protected:
     int m_sonarZoomFactor = FIND_MY_MOUSE_DEFAULT_SPOTLIGHT_INITIAL_ZOOM;
     DWORD m_fadeDuration = FIND_MY_MOUSE_DEFAULT_ANIMATION_DURATION_MS;
     int m_finalAlphaNumerator = FIND_MY_MOUSE_DEFAULT_OVERLAY_OPACITY;
-    std::vector<std::wstring> m_excludedApps;
+    ExcludedAppsMatcher m_excludedApps;
     int m_shakeMinimumDistance = FIND_MY_MOUSE_DEFAULT_SHAKE_MINIMUM_DISTANCE;
     static constexpr int FinalAlphaDenominator = 100;
     winrt::DispatcherQueueController m_dispatcherQueueController{ nullptr };
@@ -609,7 +609,7 @@ void SuperSonar<D>::UpdateMouseSnooping()
 template<typename D>
 bool SuperSonar<D>::IsForegroundAppExcluded()
 {
-    if (m_excludedApps.size() < 1)
+    if (m_excludedApps.empty())
     {
         return false;
     }
@@ -775,7 +775,7 @@ public:
             m_fadeDuration = settings.animationDurationMs > 0 ? settings.animationDurationMs : 1;
             m_finalAlphaNumerator = settings.overlayOpacity;
             m_sonarZoomFactor = settings.spotlightInitialZoom;
-            m_excludedApps = settings.excludedApps;
+            m_excludedApps = ExcludedAppsMatcher(settings.excludedApps);
             m_shakeMinimumDistance = settings.shakeMinimumDistance;
             m_shakeIntervalMs = settings.shakeIntervalMs;
             m_shakeFactor = settings.shakeFactor;
@@ -805,7 +805,7 @@ public:
                     m_fadeDuration = localSettings.animationDurationMs > 0 ? localSettings.animationDurationMs : 1;
                     m_finalAlphaNumerator = localSettings.overlayOpacity;
                     m_sonarZoomFactor = localSettings.spotlightInitialZoom;
-                    m_excludedApps = localSettings.excludedApps;
+                    m_excludedApps = ExcludedAppsMatcher(localSettings.excludedApps);
                     m_shakeMinimumDistance = localSettings.shakeMinimumDistance;
                     m_shakeIntervalMs = localSettings.shakeIntervalMs;
                     m_shakeFactor = localSettings.shakeFactor;
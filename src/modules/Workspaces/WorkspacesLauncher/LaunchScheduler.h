@@ -0,0 +1,266 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cwctype>
+#include <optional>
+#include <string>
+#include <vector>
+
+// Decides which apps of a workspace can be launched at a given moment.
+// Apps are launched concurrently, except for instances of the same app: the next instance
+// is launched only after the window of the previous one is moved, or after waiting for it
+// times out. Otherwise the arranger can't tell which window belongs to which instance,
+// and some apps merge a second launch into the running process.
+// The scheduler neither launches apps nor reads the clock. The caller reports what happened,
+// so the policy can be tested with a fake launcher and clock.
+class LaunchScheduler
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    using TimePoint = Clock::time_point;
+
+    struct App
+    {
+        std::wstring name;
+        std::wstring path;
+    };
+
+    // Special handling for apps that don't tolerate launching instances right one after another
+    struct Rule
+    {
+        std::wstring fileNameUpper;
+
+        // Pause between the previous instance being ready and launching the next one
+        std::chrono::milliseconds instanceDelay{};
+    };
+
+    static std::vector<Rule> DefaultRules()
+    {
+        return {
+            // Launching Outlook instances right one after another causes error message.
+            // Launching Outlook instances with less than 1-second delay causes the second window not to appear
+            // even though there wasn't a launch error.
+            { L"OUTLOOK.EXE", std::chrono::milliseconds(1000) },
+        };
+    }
+
+    struct Options
+    {
+        // Launch calls in flight at the same time
+        size_t maxConcurrentLaunches = 4;
+
+        // How long the next instance of an app waits for the window of the previous one
+        std::chrono::milliseconds instanceTimeout{ 3000 };
+    };
+
+    LaunchScheduler(const std::vector<App>& apps, const std::vector<Rule>& rules, Options options) :
+        m_options(options)
+    {
+        m_items.reserve(apps.size());
+        for (size_t i = 0; i < apps.size(); i++)
+        {
+            Item item{ .group = i };
+
+            // instances of an app are recognized by name or path, same as LaunchingStatus does
+            for (size_t j = 0; j < i; j++)
+            {
+                if (apps[j].name == apps[i].name || apps[j].path == apps[i].path)
+                {
+                    item.group = m_items[j].group;
+                    break;
+                }
+            }
+
+            auto fileName = ToUpper(FileName(apps[i].path));
+            auto rule = std::find_if(rules.begin(), rules.end(), [&](const Rule& val) { return val.fileNameUpper == fileName; });
+            if (rule != rules.end())
+            {
+                item.instanceDelay = rule->instanceDelay;
+            }
+
+            m_items.push_back(item);
+        }
+    }
+
+    explicit LaunchScheduler(const std::vector<App>& apps) :
+        LaunchScheduler(apps, DefaultRules(), Options{})
+    {
+    }
+
+    // Returns the apps to launch now, in the workspace order, and marks them as launching
+    std::vector<size_t> Next(TimePoint now)
+    {
+        std::vector<size_t> result;
+
+        size_t launching = std::count_if(m_items.begin(), m_items.end(), [](const Item& val) { return val.state == State::Launching; });
+        for (size_t i = 0; i < m_items.size() && launching < m_options.maxConcurrentLaunches; i++)
+        {
+            if (m_items[i].state != State::Pending)
+            {
+                continue;
+            }
+
+            auto readyAt = ReadyAt(i);
+            if (readyAt.has_value() && readyAt.value() <= now)
+            {
+                m_items[i].state = State::Launching;
+                result.push_back(i);
+                launching++;
+            }
+        }
+
+        return result;
+    }
+
+    // The launch call returned
+    void OnLaunched(size_t index, bool success, TimePoint now)
+    {
+        auto& item = m_items.at(index);
+        if (item.state != State::Launching)
+        {
+            return;
+        }
+
+        if (success)
+        {
+            item.state = State::Launched;
+            item.wasLaunched = true;
+            item.launchedAt = now;
+        }
+        else
+        {
+            item.state = State::Finished;
+            item.finishedAt = now;
+        }
+    }
+
+    // The window of the app is moved, or the app failed or got canceled.
+    // Apps may finish without being launched, e.g. when an existing window was moved.
+    void OnFinished(size_t index, TimePoint now)
+    {
+        auto& item = m_items.at(index);
+        if (item.state == State::Finished)
+        {
+            return;
+        }
+
+        if (item.state == State::Launching)
+        {
+            item.wasLaunched = true;
+            item.launchedAt = now;
+        }
+
+        item.state = State::Finished;
+        item.finishedAt = now;
+    }
+
+    // When Next can return something without any other event, if the caller should wake up then
+    std::optional<TimePoint> NextDeadline() const
+    {
+        std::optional<TimePoint> result;
+        for (size_t i = 0; i < m_items.size(); i++)
+        {
+            if (m_items[i].state != State::Pending)
+            {
+                continue;
+            }
+
+            auto readyAt = ReadyAt(i);
+            if (readyAt.has_value() && (!result.has_value() || readyAt.value() < result.value()))
+            {
+                result = readyAt;
+            }
+        }
+
+        return result;
+    }
+
+    // Nothing is left to launch
+    bool Done() const
+    {
+        return std::none_of(m_items.begin(), m_items.end(), [](const Item& val) { return val.state == State::Pending || val.state == State::Launching; });
+    }
+
+private:
+    enum class State
+    {
+        Pending,
+        Launching,
+        Launched,
+        Finished,
+    };
+
+    struct Item
+    {
+        size_t group{};
+        std::chrono::milliseconds instanceDelay{};
+        State state = State::Pending;
+        bool wasLaunched = false;
+        TimePoint launchedAt{};
+        TimePoint finishedAt{};
+    };
+
+    // When the pending app at index can be launched, or nullopt if it waits for an event
+    std::optional<TimePoint> ReadyAt(size_t index) const
+    {
+        const auto& item = m_items[index];
+
+        TimePoint releasedAt{};
+        bool hasPreviousInstance = false;
+        for (size_t j = 0; j < m_items.size(); j++)
+        {
+            const auto& other = m_items[j];
+            if (j == index || other.group != item.group)
+            {
+                continue;
+            }
+
+            switch (other.state)
+            {
+            case State::Pending:
+                if (j < index)
+                {
+                    // instances are launched in the workspace order
+                    return std::nullopt;
+                }
+                break;
+            case State::Launching:
+                return std::nullopt;
+            case State::Launched:
+                hasPreviousInstance = true;
+                releasedAt = (std::max)(releasedAt, other.launchedAt + m_options.instanceTimeout);
+                break;
+            case State::Finished:
+                if (other.wasLaunched)
+                {
+                    hasPreviousInstance = true;
+                    releasedAt = (std::max)(releasedAt, (std::min)(other.finishedAt, other.launchedAt + m_options.instanceTimeout));
+                }
+                break;
+            }
+        }
+
+        if (!hasPreviousInstance)
+        {
+            return TimePoint{};
+        }
+
+        return releasedAt + item.instanceDelay;
+    }
+
+    static std::wstring FileName(const std::wstring& path)
+    {
+        auto pos = path.find_last_of(L"\\/");
+        return pos == std::wstring::npos ? path : path.substr(pos + 1);
+    }
+
+    static std::wstring ToUpper(std::wstring str)
+    {
+        std::transform(str.begin(), str.end(), str.begin(), towupper);
+        return str;
+    }
+
+    const Options m_options;
+    std::vector<Item> m_items;
+};
@@ -8,6 +8,7 @@
 #include <WorkspacesLib/trace.h>
 
 #include <AppLauncher.h>
+#include <LaunchScheduler.h>
 #include <WorkspacesLib/AppUtils.h>
 
 Launcher::Launcher(const WorkspacesData::WorkspacesProject& project, 
@@ -97,68 +98,117 @@ Launcher::~Launcher()
 
 void Launcher::Launch() // Launching thread
 {
-    const long maxWaitTimeMs = 3000;
-    const long ms = 100;
+    std::vector<LaunchScheduler::App> schedulerApps;
+    for (const auto& app : m_project.apps)
+    {
+        schedulerApps.push_back({ app.name, app.path });
+    }
+
+    LaunchScheduler scheduler(schedulerApps);
+    std::vector<std::thread> launchThreads;
 
-    // Launch apps
-    for (auto appState = m_launchingStatus.GetNext(LaunchingState::Waiting);appState.has_value();appState = m_launchingStatus.GetNext(LaunchingState::Waiting))
+    std::unique_lock lock(m_launchMutex);
+    while (true)
     {
-        auto app = appState.value().application;
-        
-        long waitingTime = 0;
-        bool additionalWait = false;
-        while (!m_launchingStatus.AllInstancesOfTheAppLaunchedAndMoved(app) && waitingTime < maxWaitTimeMs)
-        {
-            std::this_thread::sleep_for(std::chrono::milliseconds(ms));
-            waitingTime += ms;
-            additionalWait = true;
-        }
+        auto now = LaunchScheduler::Clock::now();
 
-        if (additionalWait)
+        // apps moved by WindowArranger, failed or canceled
+        for (size_t i = 0; i < m_project.apps.size(); i++)
         {
-            // Resolves an issue when Outlook does not launch when launching one after another.
-            // Launching Outlook instances right one after another causes error message.
-            // Launching Outlook instances with less than 1-second delay causes the second window not to appear
-            // even though there wasn't a launch error.
-            std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+            auto status = m_launchingStatus.Get(m_project.apps[i]);
+            if (!status.has_value() ||
+                status.value().state == LaunchingState::LaunchedAndMoved ||
+                status.value().state == LaunchingState::Failed ||
+                status.value().state == LaunchingState::Canceled)
+            {
+                scheduler.OnFinished(i, now);
+            }
         }
 
-        if (waitingTime >= maxWaitTimeMs)
+        if (scheduler.Done())
         {
-            Logger::info(L"Waiting time for launching next {} instance expired", app.name);
+            break;
         }
 
-        bool launched{ false };
+        for (size_t index : scheduler.Next(now))
         {
-            std::lock_guard lock(m_launchErrorsMutex);
-            launched = AppLauncher::Launch(app, m_launchErrors);
+            launchThreads.emplace_back([this, &scheduler, index]() {
+                const auto& app = m_project.apps[index];
+                LaunchApp(app);
+
+                auto status = m_launchingStatus.Get(app);
+                {
+                    std::lock_guard lock(m_launchMutex);
+                    scheduler.OnLaunched(index, status.has_value() && status.value().state != LaunchingState::Failed, LaunchScheduler::Clock::now());
+                }
+
+                m_launchCondition.notify_all();
+            });
         }
 
-        if (launched)
+        // wait for the apps to be launched or moved, or for the next instance of an app to be due
+        auto deadline = scheduler.NextDeadline();
+        if (deadline.has_value() && deadline.value() > now)
         {
-            m_launchingStatus.Update(app, LaunchingState::Launched);
+            m_launchCondition.wait_until(lock, deadline.value());
         }
         else
         {
-            Logger::error(L"Failed to launch {}", app.name);
-            m_launchingStatus.Update(app, LaunchingState::Failed);
-            m_launchedSuccessfully = false;
+            m_launchCondition.wait(lock);
         }
+    }
+
+    lock.unlock();
+    for (auto& thread : launchThreads)
+    {
+        thread.join();
+    }
+}
+
+void Launcher::LaunchApp(const WorkspacesData::WorkspacesProject::Application& app) // App launching thread
+{
+    AppLauncher::ErrorList launchErrors{};
+    bool launched = AppLauncher::Launch(app, launchErrors);
 
-        auto status = m_launchingStatus.Get(app); // updated after launch status 
-        if (status.has_value())
+    {
+        std::lock_guard lock(m_launchErrorsMutex);
+        m_launchErrors.insert(m_launchErrors.end(), launchErrors.begin(), launchErrors.end());
+    }
+
+    if (launched)
+    {
+        m_launchingStatus.Update(app, LaunchingState::Launched);
+    }
+    else
+    {
+        Logger::error(L"Failed to launch {}", app.name);
+        m_launchingStatus.Update(app, LaunchingState::Failed);
+        m_launchedSuccessfully = false;
+    }
+
+    auto status = m_launchingStatus.Get(app); // updated after launch status
+    if (status.has_value())
+    {
         {
-            {
-                std::lock_guard lock(m_windowArrangerHelperMutex);
-                m_windowArrangerHelper->UpdateLaunchStatus(status.value());
-            }
+            std::lock_guard lock(m_windowArrangerHelperMutex);
+            m_windowArrangerHelper->UpdateLaunchStatus(status.value());
         }
+    }
 
-        {
-            std::lock_guard lock(m_uiHelperMutex);
-            m_uiHelper->UpdateLaunchStatus(m_launchingStatus.Get());
-        };
+    {
+        std::lock_guard lock(m_uiHelperMutex);
+        m_uiHelper->UpdateLaunchStatus(m_launchingStatus.Get());
+    };
+}
+
+void Launcher::notifyLaunchingThread()
+{
+    // taking the lock makes sure the launching thread is either waiting or yet to check the status
+    {
+        std::lock_guard lock(m_launchMutex);
     }
+
+    m_launchCondition.notify_all();
 }
 
 void Launcher::handleWindowArrangerMessage(const std::wstring& msg) // WorkspacesArranger IPC thread
@@ -175,7 +225,8 @@ void Launcher::handleWindowArrangerMessage(const std::wstring& msg) // Workspace
             if (data.has_value())
             {
                 m_launchingStatus.Update(data.value().application, data.value().state);
-                
+                notifyLaunchingThread();
+
                 {
                     std::lock_guard lock(m_uiHelperMutex);
                     m_uiHelper->UpdateLaunchStatus(m_launchingStatus.Get());
@@ -198,5 +249,6 @@ void Launcher::handleUIMessage(const std::wstring& msg) // UI IPC thread
     if (msg == L"cancel")
     {
         m_launchingStatus.Cancel();
+        notifyLaunchingThread();
     }
 }
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <condition_variable>
+
 #include <WorkspacesLib/LaunchingStatus.h>
 #include <WorkspacesLib/WorkspacesData.h>
 
@@ -31,7 +33,13 @@ private:
     std::vector<std::pair<std::wstring, std::wstring>> m_launchErrors{};
     std::mutex m_launchErrorsMutex;
 
+    // Wakes up the launching thread when an app is launched, moved or canceled
+    std::mutex m_launchMutex;
+    std::condition_variable m_launchCondition;
+
     void Launch();
+    void LaunchApp(const WorkspacesData::WorkspacesProject::Application& app);
+    void notifyLaunchingThread();
     void handleWindowArrangerMessage(const std::wstring& msg);
     void handleUIMessage(const std::wstring& msg);
 };
@@ -6,9 +6,12 @@
 #include <ShlObj.h>
 #include <TlHelp32.h>
 
+#include <chrono>
 #include <filesystem>
 
 #include <common/logger/logger.h>
+#include <common/SettingsAPI/settings_helpers.h>
+#include <common/utils/json.h>
 #include <common/utils/process_path.h>
 #include <common/utils/winapi_error.h>
 
@@ -34,11 +37,276 @@ namespace Utils
 
             constexpr const wchar_t* EdgeFilename = L"msedge.exe";
             constexpr const wchar_t* ChromeFilename = L"chrome.exe";
+
+            constexpr const wchar_t* ModuleKey = L"Workspaces";
+            constexpr const wchar_t* AppsCacheFile = L"\\installed-apps-cache.json";
+            constexpr const wchar_t* AppsCacheTempFile = L"\\installed-apps-cache.json.tmp";
+
+            constexpr const wchar_t* CacheStampKey = L"stamp";
+            constexpr const wchar_t* CacheCreatedKey = L"created";
+            constexpr const wchar_t* CacheAppsKey = L"apps";
+            constexpr const wchar_t* NameKey = L"name";
+            constexpr const wchar_t* InstallPathKey = L"installPath";
+            constexpr const wchar_t* PackageFullNameKey = L"packageFullName";
+            constexpr const wchar_t* AppUserModelIdKey = L"appUserModelId";
+            constexpr const wchar_t* CanLaunchElevatedKey = L"canLaunchElevated";
+
+            // Keys that change when packaged apps or Win32 programs are installed or removed
+            constexpr const wchar_t* PackagesKey = L"Software\\Classes\\Local Settings\\Software\\Microsoft\\Windows\\CurrentVersion\\AppModel\\Repository\\Packages";
+            constexpr const wchar_t* AllUserPackagesKey = L"SOFTWARE\\Microsoft\\Windows\\CurrentVersion\\Appx\\AppxAllUserStore\\Applications";
+            constexpr const wchar_t* UninstallKey = L"SOFTWARE\\Microsoft\\Windows\\CurrentVersion\\Uninstall";
+        }
+
+        namespace
+        {
+            // Shortcuts installed outside of the registry keys above are only noticed through the
+            // Start menu folders, so the cache can't be trusted for longer than this.
+            constexpr std::chrono::hours AppsCacheMaxAge{ 24 };
+
+            std::wstring ToUpper(std::wstring str)
+            {
+                std::transform(str.begin(), str.end(), str.begin(), towupper);
+                return str;
+            }
+
+            uint64_t ToUInt64(const FILETIME& time)
+            {
+                return (static_cast<uint64_t>(time.dwHighDateTime) << 32) | time.dwLowDateTime;
+            }
+
+            void AppendKeyStamp(std::wstring& stamp, HKEY root, const wchar_t* subKey)
+            {
+                HKEY key{};
+                if (RegOpenKeyExW(root, subKey, 0, KEY_READ, &key) != ERROR_SUCCESS)
+                {
+                    stamp += L"-;";
+                    return;
+                }
+
+                DWORD subKeys = 0;
+                FILETIME lastWriteTime{};
+                RegQueryInfoKeyW(key, nullptr, nullptr, nullptr, &subKeys, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, &lastWriteTime);
+                RegCloseKey(key);
+
+                stamp += std::to_wstring(subKeys) + L":" + std::to_wstring(ToUInt64(lastWriteTime)) + L";";
+            }
+
+            void AppendFolderStamp(std::wstring& stamp, REFKNOWNFOLDERID folderId)
+            {
+                CComHeapPtr<wchar_t> folderPath;
+                if (FAILED(SHGetKnownFolderPath(folderId, KF_FLAG_DEFAULT, nullptr, &folderPath)))
+                {
+                    stamp += L"-;";
+                    return;
+                }
+
+                // Adding or removing a shortcut updates the last write time of its folder
+                std::error_code ec;
+                auto newest = std::filesystem::last_write_time(folderPath.m_pData, ec);
+                size_t folders = 1;
+                for (auto it = std::filesystem::recursive_directory_iterator(folderPath.m_pData, std::filesystem::directory_options::skip_permission_denied, ec);
+                     !ec && it != std::filesystem::recursive_directory_iterator();
+                     it.increment(ec))
+                {
+                    if (it->is_directory(ec))
+                    {
+                        folders++;
+                        newest = (std::max)(newest, it->last_write_time(ec));
+                    }
+                }
+
+                stamp += std::to_wstring(folders) + L":" + std::to_wstring(newest.time_since_epoch().count()) + L";";
+            }
+
+            // Identifies the state of installed apps. The display names are localized, so the UI language is a part of it too.
+            std::wstring AppsFolderStamp()
+            {
+                std::wstring stamp = std::to_wstring(GetUserDefaultUILanguage()) + L";";
+                AppendKeyStamp(stamp, HKEY_CURRENT_USER, NonLocalizable::PackagesKey);
+                AppendKeyStamp(stamp, HKEY_LOCAL_MACHINE, NonLocalizable::AllUserPackagesKey);
+                AppendKeyStamp(stamp, HKEY_LOCAL_MACHINE, NonLocalizable::UninstallKey);
+                AppendKeyStamp(stamp, HKEY_CURRENT_USER, NonLocalizable::UninstallKey);
+                AppendFolderStamp(stamp, FOLDERID_CommonPrograms);
+                AppendFolderStamp(stamp, FOLDERID_Programs);
+                return stamp;
+            }
+
+            int64_t SecondsSinceEpoch()
+            {
+                return std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+            }
+
+            std::optional<std::vector<AppData>> ReadAppsCache(const std::wstring& stamp)
+            {
+                std::wstring file = PTSettingsHelper::get_module_save_folder_location(NonLocalizable::ModuleKey) + NonLocalizable::AppsCacheFile;
+                auto cache = json::from_file(file);
+                if (!cache.has_value())
+                {
+                    return std::nullopt;
+                }
+
+                try
+                {
+                    if (stamp != cache->GetNamedString(NonLocalizable::CacheStampKey).c_str())
+                    {
+                        Logger::trace(L"Installed apps changed, the apps cache is outdated");
+                        return std::nullopt;
+                    }
+
+                    auto age = SecondsSinceEpoch() - static_cast<int64_t>(cache->GetNamedNumber(NonLocalizable::CacheCreatedKey));
+                    if (age < 0 || age > std::chrono::duration_cast<std::chrono::seconds>(AppsCacheMaxAge).count())
+                    {
+                        Logger::trace(L"The apps cache is expired");
+                        return std::nullopt;
+                    }
+
+                    std::vector<AppData> result;
+                    auto apps = cache->GetNamedArray(NonLocalizable::CacheAppsKey);
+                    result.reserve(apps.Size());
+                    for (const auto& value : apps)
+                    {
+                        auto app = value.GetObjectW();
+                        result.push_back(AppData{
+                            .name = app.GetNamedString(NonLocalizable::NameKey).c_str(),
+                            .installPath = app.GetNamedString(NonLocalizable::InstallPathKey).c_str(),
+                            .packageFullName = app.GetNamedString(NonLocalizable::PackageFullNameKey).c_str(),
+                            .appUserModelId = app.GetNamedString(NonLocalizable::AppUserModelIdKey).c_str(),
+                            .canLaunchElevated = app.GetNamedBoolean(NonLocalizable::CanLaunchElevatedKey),
+                        });
+                    }
+
+                    return result;
+                }
+                catch (const winrt::hresult_error&)
+                {
+                    Logger::error(L"Failed to parse the apps cache");
+                    return std::nullopt;
+                }
+            }
+
+            void WriteAppsCache(const std::vector<AppData>& apps, const std::wstring& stamp)
+            {
+                try
+                {
+                    json::JsonArray appsJson{};
+                    for (const auto& app : apps)
+                    {
+                        json::JsonObject appJson{};
+                        appJson.SetNamedValue(NonLocalizable::NameKey, json::value(app.name));
+                        appJson.SetNamedValue(NonLocalizable::InstallPathKey, json::value(app.installPath));
+                        appJson.SetNamedValue(NonLocalizable::PackageFullNameKey, json::value(app.packageFullName));
+                        appJson.SetNamedValue(NonLocalizable::AppUserModelIdKey, json::value(app.appUserModelId));
+                        appJson.SetNamedValue(NonLocalizable::CanLaunchElevatedKey, json::value(app.canLaunchElevated));
+                        appsJson.Append(appJson);
+                    }
+
+                    json::JsonObject cache{};
+                    cache.SetNamedValue(NonLocalizable::CacheStampKey, json::value(stamp));
+                    cache.SetNamedValue(NonLocalizable::CacheCreatedKey, json::value(SecondsSinceEpoch()));
+                    cache.SetNamedValue(NonLocalizable::CacheAppsKey, appsJson);
+
+                    // The launcher and the snapshot tool may run at the same time, so readers must never see a partial file
+                    std::wstring folder = PTSettingsHelper::get_module_save_folder_location(NonLocalizable::ModuleKey);
+                    std::wstring tempFile = folder + NonLocalizable::AppsCacheTempFile;
+                    json::to_file(tempFile, cache);
+                    if (!MoveFileExW(tempFile.c_str(), (folder + NonLocalizable::AppsCacheFile).c_str(), MOVEFILE_REPLACE_EXISTING))
+                    {
+                        Logger::error(L"Failed to save the apps cache: {}", get_last_error_or_default(GetLastError()));
+                    }
+                }
+                catch (const winrt::hresult_error&)
+                {
+                    Logger::error(L"Failed to serialize the apps cache");
+                }
+            }
+        }
+
+        AppList::AppList(std::vector<AppData> apps) :
+            m_apps(std::move(apps))
+        {
+            for (size_t i = 0; i < m_apps.size(); i++)
+            {
+                const auto& app = m_apps[i];
+
+                // try_emplace keeps the first match, as the linear search did
+                m_names.try_emplace(app.name, i);
+                m_namesUpper.try_emplace(ToUpper(app.name), i);
+
+                if (!app.appUserModelId.empty())
+                {
+                    m_appUserModelIds.try_emplace(app.appUserModelId, i);
+                }
+
+                if (!app.installPath.empty())
+                {
+                    std::filesystem::path installPath(app.installPath);
+                    m_installPathsUpper.try_emplace(ToUpper(app.installPath), i);
+                    m_installFoldersUpper.try_emplace(ToUpper(installPath.parent_path().wstring()), i);
+
+                    // insert_or_assign keeps the last match like the file name fallback of the linear search,
+                    // which compared the file names case-sensitively
+                    m_fileNames.insert_or_assign(installPath.filename().wstring(), i);
+                }
+            }
+        }
+
+        const AppData* AppList::Find(const std::unordered_map<std::wstring, size_t>& index, const std::wstring& key) const
+        {
+            auto iter = index.find(key);
+            return iter != index.end() ? &m_apps[iter->second] : nullptr;
+        }
+
+        const AppData* AppList::FindByInstallPath(const std::wstring& pathUpper) const
+        {
+            // Install paths point either to the executable or to a folder containing it,
+            // so only the path itself and its parent folders can match
+            std::optional<size_t> first{};
+            auto check = [&](const std::wstring& key) {
+                auto iter = m_installPathsUpper.find(key);
+                if (iter != m_installPathsUpper.end() && (!first.has_value() || iter->second < first.value()))
+                {
+                    first = iter->second;
+                }
+            };
+
+            for (size_t pos = pathUpper.find(L'\\'); pos != std::wstring::npos; pos = pathUpper.find(L'\\', pos + 1))
+            {
+                check(pathUpper.substr(0, pos));
+                check(pathUpper.substr(0, pos + 1));
+            }
+            check(pathUpper);
+
+            return first.has_value() ? &m_apps[first.value()] : nullptr;
+        }
+
+        const AppData* AppList::FindByFileName(const std::wstring& fileName) const
+        {
+            return Find(m_fileNames, fileName);
+        }
+
+        const AppData* AppList::FindByInstallFolder(const std::wstring& folderUpper) const
+        {
+            return Find(m_installFoldersUpper, folderUpper);
         }
 
-        AppList IterateAppsFolder()
+        const AppData* AppList::FindByName(const std::wstring& name) const
         {
-            AppList result{};
+            return Find(m_names, name);
+        }
+
+        const AppData* AppList::FindByNameUpper(const std::wstring& nameUpper) const
+        {
+            return Find(m_namesUpper, nameUpper);
+        }
+
+        const AppData* AppList::FindByAppUserModelId(const std::wstring& appUserModelId) const
+        {
+            return Find(m_appUserModelIds, appUserModelId);
+        }
+
+        std::vector<AppData> IterateAppsFolder()
+        {
+            std::vector<AppData> result{};
 
             // get apps folder
             CComPtr<IShellItem> folder;
@@ -187,7 +455,21 @@ namespace Utils
 
         AppList GetAppsList()
         {
-            return IterateAppsFolder();
+            auto stamp = AppsFolderStamp();
+            auto cached = ReadAppsCache(stamp);
+            if (cached.has_value())
+            {
+                Logger::trace(L"Loaded {} apps from the apps cache", cached.value().size());
+                return AppList(std::move(cached.value()));
+            }
+
+            auto apps = IterateAppsFolder();
+            if (!apps.empty())
+            {
+                WriteAppsCache(apps, stamp);
+            }
+
+            return AppList(std::move(apps));
         }
 
         DWORD GetParentPid(DWORD pid)
@@ -214,8 +496,7 @@ namespace Utils
 
         std::optional<AppData> GetApp(const std::wstring& appPath, DWORD pid, const AppList& apps)
         {
-            std::wstring appPathUpper(appPath);
-            std::transform(appPathUpper.begin(), appPathUpper.end(), appPathUpper.begin(), towupper);
+            std::wstring appPathUpper = ToUpper(appPath);
 
             // filter out ApplicationFrameHost.exe
             if (appPathUpper.ends_with(NonLocalizable::ApplicationFrameHost))
@@ -252,59 +533,34 @@ namespace Utils
             }
 
             // search in apps list
-            std::optional<AppData> appDataPlanB{ std::nullopt };
-            for (const auto& appData : apps)
+            if (const auto* appData = apps.FindByInstallPath(appPathUpper))
             {
-                if (!appData.installPath.empty())
+                // Update the install path to keep .exe in the path
+                if (!ToUpper(appData->installPath).ends_with(NonLocalizable::Exe))
                 {
-                    std::wstring installPathUpper(appData.installPath);
-                    std::transform(installPathUpper.begin(), installPathUpper.end(), installPathUpper.begin(), towupper);
-
-                    if (appPathUpper.contains(installPathUpper))
-                    {
-                        // Update the install path to keep .exe in the path
-                        if (!installPathUpper.ends_with(NonLocalizable::Exe))
-                        {
-                            auto settingsAppData = appData;
-                            settingsAppData.installPath = appPath;
-                            return settingsAppData;
-                        }
-
-                        return appData;
-                    }
-
-                    // edge case, some apps (e.g., Gitkraken) have different .exe files in the subfolders.
-                    // apps list contains only one path, so in this case app is not found
-                    // remember the match and return it in case the loop is over and there are no direct matches
-                    if (std::filesystem::path(appPath).filename() == std::filesystem::path(appData.installPath).filename())
-                    {
-                        appDataPlanB = appData;
-                    }
+                    auto settingsAppData = *appData;
+                    settingsAppData.installPath = appPath;
+                    return settingsAppData;
                 }
+
+                return *appData;
             }
 
-            if (appDataPlanB.has_value())
+            // edge case, some apps (e.g., Gitkraken) have different .exe files in the subfolders.
+            // apps list contains only one path, so in this case app is not found by the path
+            if (const auto* appData = apps.FindByFileName(std::filesystem::path(appPath).filename()))
             {
-                return appDataPlanB.value();
+                return *appData;
             }
 
             // try by name if path not found
             // apps list could contain a different path from that one we get from the process (for electron)
-            std::wstring exeName = std::filesystem::path(appPath).stem();
-            std::wstring exeNameUpper(exeName);
-            std::transform(exeNameUpper.begin(), exeNameUpper.end(), exeNameUpper.begin(), towupper);
-
-            for (const auto& appData : apps)
+            std::wstring exeNameUpper = ToUpper(std::filesystem::path(appPath).stem());
+            if (const auto* appData = apps.FindByNameUpper(exeNameUpper))
             {
-                std::wstring appNameUpper(appData.name);
-                std::transform(appNameUpper.begin(), appNameUpper.end(), appNameUpper.begin(), towupper);
-
-                if (appNameUpper == exeNameUpper)
-                {
-                    auto result = appData;
-                    result.installPath = appPath;
-                    return result;
-                }
+                auto result = *appData;
+                result.installPath = appPath;
+                return result;
             }
 
             // try with parent process (fix for Steam)
@@ -313,25 +569,14 @@ namespace Utils
 
             if (!parentProcessPath.empty())
             {
-                std::wstring parentDirUpper = std::filesystem::path(parentProcessPath).parent_path().c_str();
-                std::transform(parentDirUpper.begin(), parentDirUpper.end(), parentDirUpper.begin(), towupper);
-
+                std::wstring parentDirUpper = ToUpper(std::filesystem::path(parentProcessPath).parent_path());
                 if (appPathUpper.starts_with(parentDirUpper))
                 {
                     Logger::info(L"original process is in the subfolder of the parent process");
 
-                    for (const auto& appData : apps)
+                    if (const auto* appData = apps.FindByInstallFolder(parentDirUpper))
                     {
-                        if (!appData.installPath.empty())
-                        {
-                            std::wstring installDirUpper = std::filesystem::path(appData.installPath).parent_path().c_str();
-                            std::transform(installDirUpper.begin(), installDirUpper.end(), installDirUpper.begin(), towupper);
-
-                            if (installDirUpper == parentDirUpper)
-                            {
-                                return appData;
-                            }
-                        }
+                        return *appData;
                     }
                 }
             }
@@ -354,8 +599,18 @@ namespace Utils
 
         bool UpdateAppVersion(WorkspacesData::WorkspacesProject::Application& app, const AppList& installedApps)
         {
-            auto installedApp = std::find_if(installedApps.begin(), installedApps.end(), [&](const AppData& val) { return val.name == app.name; });
-            if (installedApp == installedApps.end())
+            const AppData* installedApp = nullptr;
+            if (!app.appUserModelId.empty())
+            {
+                installedApp = installedApps.FindByAppUserModelId(app.appUserModelId);
+            }
+
+            if (!installedApp)
+            {
+                installedApp = installedApps.FindByName(app.name);
+            }
+
+            if (!installedApp)
             {
                 return false;
             }
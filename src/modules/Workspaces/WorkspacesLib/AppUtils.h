@@ -1,5 +1,7 @@
 #pragma once
 
+#include <unordered_map>
+
 #include <WorkspacesLib/WorkspacesData.h>
 
 namespace Utils
@@ -19,11 +21,50 @@ namespace Utils
             bool IsChrome() const;
         };
 
-        using AppList = std::vector<AppData>;
+        // Installed apps in the apps folder enumeration order, indexed for the lookups GetApp does per window.
+        class AppList
+        {
+        public:
+            AppList() = default;
+            explicit AppList(std::vector<AppData> apps);
+
+            std::vector<AppData>::const_iterator begin() const { return m_apps.begin(); }
+            std::vector<AppData>::const_iterator end() const { return m_apps.end(); }
+            size_t size() const { return m_apps.size(); }
+            bool empty() const { return m_apps.empty(); }
+
+            // First app installed at the upper-cased path or one of its parent folders
+            const AppData* FindByInstallPath(const std::wstring& pathUpper) const;
+
+            // Last app whose install path has the given file name
+            const AppData* FindByFileName(const std::wstring& fileName) const;
+
+            // First app whose install path is directly in the upper-cased folder
+            const AppData* FindByInstallFolder(const std::wstring& folderUpper) const;
+
+            // First app with the name, compared case-insensitively if nameUpper is upper-cased
+            const AppData* FindByName(const std::wstring& name) const;
+            const AppData* FindByNameUpper(const std::wstring& nameUpper) const;
+
+            const AppData* FindByAppUserModelId(const std::wstring& appUserModelId) const;
+
+        private:
+            const AppData* Find(const std::unordered_map<std::wstring, size_t>& index, const std::wstring& key) const;
+
+            std::vector<AppData> m_apps;
+            std::unordered_map<std::wstring, size_t> m_installPathsUpper;
+            std::unordered_map<std::wstring, size_t> m_fileNames;
+            std::unordered_map<std::wstring, size_t> m_installFoldersUpper;
+            std::unordered_map<std::wstring, size_t> m_names;
+            std::unordered_map<std::wstring, size_t> m_namesUpper;
+            std::unordered_map<std::wstring, size_t> m_appUserModelIds;
+        };
 
         const std::wstring& GetCurrentFolder();
         const std::wstring& GetCurrentFolderUpper();
 
+        // Enumerating the apps folder takes a while, so the result is cached on disk until
+        // installed packages or programs change.
         AppList GetAppsList();
         std::optional<AppData> GetApp(const std::wstring& appPath, DWORD pid, const AppList& apps);
         std::optional<AppData> GetApp(HWND window, const AppList& apps);
@@ -22,7 +22,28 @@ std::wstring CommandLineArgsHelper::GetCommandLineArgs(DWORD processID) const
 
     std::wstring executablePath = m_wbemHelper->GetExecutablePath(processID);
     std::wstring commandLineArgs = m_wbemHelper->GetCommandLineArgs(processID);
+    return RemoveExecutablePath(commandLineArgs, executablePath);
+}
+
+std::map<DWORD, std::wstring> CommandLineArgsHelper::GetCommandLineArgs(const std::vector<DWORD>& processIDs) const
+{
+    std::map<DWORD, std::wstring> result{};
+    if (!m_wbemHelper)
+    {
+        Logger::error(L"WbemHelper not initialized");
+        return result;
+    }
 
+    for (const auto& [processID, info] : m_wbemHelper->GetProcesses(processIDs))
+    {
+        result[processID] = RemoveExecutablePath(info.commandLine, info.executablePath);
+    }
+
+    return result;
+}
+
+std::wstring CommandLineArgsHelper::RemoveExecutablePath(std::wstring commandLineArgs, const std::wstring& executablePath)
+{
     if (!commandLineArgs.empty())
     {
         auto pos = commandLineArgs.find(executablePath);
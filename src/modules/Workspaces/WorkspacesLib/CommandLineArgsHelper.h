@@ -10,6 +10,11 @@ public:
 
     std::wstring GetCommandLineArgs(DWORD processID) const;
 
+    // Same as above for several processes, queried together
+    std::map<DWORD, std::wstring> GetCommandLineArgs(const std::vector<DWORD>& processIDs) const;
+
 private:
+    static std::wstring RemoveExecutablePath(std::wstring commandLineArgs, const std::wstring& executablePath);
+
     std::unique_ptr<WbemHelper> m_wbemHelper;
 };
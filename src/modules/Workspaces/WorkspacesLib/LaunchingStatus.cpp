@@ -60,8 +60,9 @@ bool LaunchingStatus::AllInstancesOfTheAppLaunchedAndMoved(const WorkspacesData:
     return true;
 }
 
-const WorkspacesData::LaunchingAppStateMap& LaunchingStatus::Get() noexcept
+WorkspacesData::LaunchingAppStateMap LaunchingStatus::Get() noexcept
 {
+    // A copy, the launcher and the arranger threads update the states while it's being read
     std::shared_lock lock(m_mutex);
     return m_appsState;
 }
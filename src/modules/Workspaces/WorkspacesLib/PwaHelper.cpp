@@ -2,6 +2,7 @@
 #include "PwaHelper.h"
 
 #include <filesystem>
+#include <mutex>
 
 #include <appmodel.h>
 #include <shellapi.h>
@@ -91,16 +92,16 @@ namespace Utils
         InitEdgeAppIds();
     }
 
-    void PwaHelper::InitAppIds(const std::wstring& browserDataFolder, const std::wstring& browserDirPrefix, const std::function<void(const std::wstring&)>& addingAppIdCallback)
+    struct WebApp
     {
-        std::filesystem::path folderPath(GetLocalAppDataFolder());
-        folderPath.append(browserDataFolder);
-        if (!std::filesystem::exists(folderPath))
-        {
-            Logger::info(L"Edge base path does not exist: {}", folderPath.wstring());
-            return;
-        }
+        std::wstring appId;
+        std::optional<std::wstring> name;
+    };
 
+    // Lists the web apps installed in a browser profile. Returns nullopt if the folder can't be read.
+    static std::optional<std::vector<WebApp>> ScanWebApps(const std::filesystem::path& folderPath, const std::wstring& browserDirPrefix)
+    {
+        std::vector<WebApp> result;
         try
         {
             for (const auto& directory : std::filesystem::directory_iterator(folderPath))
@@ -116,12 +117,7 @@ namespace Utils
                     continue;
                 }
 
-                const std::wstring appId = directoryName.substr(browserDirPrefix.length());
-                if (addingAppIdCallback)
-                {
-                    addingAppIdCallback(appId);
-                }
-
+                WebApp app{ .appId = directoryName.substr(browserDirPrefix.length()) };
                 for (const auto& filename : std::filesystem::directory_iterator(directory))
                 {
                     if (!filename.is_directory())
@@ -129,18 +125,83 @@ namespace Utils
                         const std::filesystem::path filenameString = filename.path().filename();
                         if (StringUtils::CaseInsensitiveEquals(filenameString.extension(), NonLocalizable::IcoExtension))
                         {
-                            const auto stem = filenameString.stem().wstring();
-                            m_pwaAppIdsToAppNames.insert({ appId, stem });
-                            Logger::info(L"Found an installed Pwa app {} with PwaAppId {}", stem, appId);
+                            app.name = filenameString.stem().wstring();
+                            Logger::info(L"Found an installed Pwa app {} with PwaAppId {}", app.name.value(), app.appId);
                             break;
                         }
                     }
                 }
+
+                result.push_back(std::move(app));
             }
         }
         catch (std::exception& ex)
         {
             Logger::error("Failed to iterate over the directory: {}", ex.what());
+            return std::nullopt;
+        }
+
+        return result;
+    }
+
+    // Scanning the web apps folder of a browser profile takes a directory walk per app, so the result
+    // is kept for the lifetime of the process, until an app is added to or removed from the folder.
+    static std::vector<WebApp> GetWebApps(const std::filesystem::path& folderPath, const std::wstring& browserDirPrefix)
+    {
+        struct ProfileWebApps
+        {
+            std::filesystem::file_time_type lastWriteTime;
+            std::vector<WebApp> apps;
+        };
+
+        static std::mutex cacheMutex;
+        static std::map<std::wstring, ProfileWebApps> cache;
+
+        std::error_code ec;
+        const auto lastWriteTime = std::filesystem::last_write_time(folderPath, ec);
+
+        std::lock_guard lock(cacheMutex);
+        const auto cached = cache.find(folderPath.wstring());
+        if (!ec && cached != cache.end() && cached->second.lastWriteTime == lastWriteTime)
+        {
+            return cached->second.apps;
+        }
+
+        auto apps = ScanWebApps(folderPath, browserDirPrefix);
+        if (!apps.has_value())
+        {
+            return {};
+        }
+
+        if (!ec)
+        {
+            cache.insert_or_assign(folderPath.wstring(), ProfileWebApps{ lastWriteTime, apps.value() });
+        }
+
+        return apps.value();
+    }
+
+    void PwaHelper::InitAppIds(const std::wstring& browserDataFolder, const std::wstring& browserDirPrefix, const std::function<void(const std::wstring&)>& addingAppIdCallback)
+    {
+        std::filesystem::path folderPath(GetLocalAppDataFolder());
+        folderPath.append(browserDataFolder);
+        if (!std::filesystem::exists(folderPath))
+        {
+            Logger::info(L"Edge base path does not exist: {}", folderPath.wstring());
+            return;
+        }
+
+        for (const auto& app : GetWebApps(folderPath, browserDirPrefix))
+        {
+            if (addingAppIdCallback)
+            {
+                addingAppIdCallback(app.appId);
+            }
+
+            if (app.name.has_value())
+            {
+                m_pwaAppIdsToAppNames.insert({ app.appId, app.name.value() });
+            }
         }
     }
 
@@ -157,11 +218,14 @@ namespace Utils
         const auto pwaHelperProcessIds = FindPwaHelperProcessIds();
         Logger::info(L"Found {} edge Pwa helper processes", pwaHelperProcessIds.size());
 
+        // a single WMI query for all helper processes
+        const auto commandLineArgs = commandLineArgsHelper.GetCommandLineArgs(pwaHelperProcessIds);
+
         for (const auto subProcessID : pwaHelperProcessIds)
         {
             std::wstring aumidID = GetAUMIDFromProcessId(subProcessID);
-            std::wstring commandLineArg = commandLineArgsHelper.GetCommandLineArgs(subProcessID);
-            std::wstring appId = GetAppIdFromCommandLineArgs(commandLineArg);
+            const auto commandLineArg = commandLineArgs.find(subProcessID);
+            std::wstring appId = GetAppIdFromCommandLineArgs(commandLineArg != commandLineArgs.end() ? commandLineArg->second : L"");
 
             m_edgeAppIds.insert({ aumidID, appId });
             Logger::info(L"Found an edge Pwa helper process with AumidID {} and PwaAppId {}", aumidID, appId);
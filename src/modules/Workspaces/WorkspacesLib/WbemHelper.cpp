@@ -1,6 +1,8 @@
 #include "pch.h"
 #include "WbemHelper.h"
 
+#include <algorithm>
+
 #include <comdef.h>
 #include <Wbemidl.h>
 
@@ -9,6 +11,27 @@
 
 #pragma comment(lib, "wbemuuid.lib")
 
+namespace
+{
+    // Keeps the WHERE clause of a batch query short
+    constexpr size_t MaxProcessesPerQuery = 64;
+
+    std::wstring GetStringProperty(IWbemClassObject* object, const wchar_t* propertyName)
+    {
+        std::wstring result{};
+
+        VARIANT vtProp;
+        HRESULT hr = object->Get(propertyName, 0, &vtProp, 0, 0);
+        if (SUCCEEDED(hr) && vtProp.vt == VT_BSTR)
+        {
+            result = vtProp.bstrVal;
+        }
+        VariantClear(&vtProp);
+
+        return result;
+    }
+}
+
 std::unique_ptr<WbemHelper> WbemHelper::Create()
 {
     auto instance = std::unique_ptr<WbemHelper>(new WbemHelper());
@@ -47,6 +70,40 @@ std::wstring WbemHelper::GetExecutablePath(DWORD processID) const
     return Query(query, property);
 }
 
+std::map<DWORD, WbemHelper::ProcessInfo> WbemHelper::GetProcesses(const std::vector<DWORD>& processIDs) const
+{
+    std::map<DWORD, ProcessInfo> result{};
+
+    std::vector<DWORD> uniqueIDs(processIDs);
+    std::sort(uniqueIDs.begin(), uniqueIDs.end());
+    uniqueIDs.erase(std::unique(uniqueIDs.begin(), uniqueIDs.end()), uniqueIDs.end());
+
+    for (size_t batchStart = 0; batchStart < uniqueIDs.size(); batchStart += MaxProcessesPerQuery)
+    {
+        std::wstring query = L"SELECT ProcessId, ExecutablePath, CommandLine FROM Win32_Process WHERE ";
+        size_t batchEnd = (std::min)(batchStart + MaxProcessesPerQuery, uniqueIDs.size());
+        for (size_t i = batchStart; i < batchEnd; i++)
+        {
+            query += (i == batchStart ? L"ProcessId = " : L" OR ProcessId = ") + std::to_wstring(uniqueIDs[i]);
+        }
+
+        Query(query, [&](IWbemClassObject* object) {
+            VARIANT vtProp;
+            HRESULT hr = object->Get(L"ProcessId", 0, &vtProp, 0, 0);
+            if (SUCCEEDED(hr) && (vtProp.vt == VT_I4 || vtProp.vt == VT_UI4))
+            {
+                result[static_cast<DWORD>(vtProp.ulVal)] = ProcessInfo{
+                    .executablePath = GetStringProperty(object, L"ExecutablePath"),
+                    .commandLine = GetStringProperty(object, L"CommandLine"),
+                };
+            }
+            VariantClear(&vtProp);
+        });
+    }
+
+    return result;
+}
+
 bool WbemHelper::Initialize()
 {
     // Obtain the initial locator to WMI.
@@ -77,10 +134,20 @@ bool WbemHelper::Initialize()
 }
 
 std::wstring WbemHelper::Query(const std::wstring& query, const std::wstring& propertyName) const
+{
+    std::wstring result = L"";
+    Query(query, [&](IWbemClassObject* object) {
+        result = GetStringProperty(object, propertyName.c_str());
+    });
+
+    return result;
+}
+
+void WbemHelper::Query(const std::wstring& query, const std::function<void(IWbemClassObject*)>& callback) const
 {
     if (!m_locator || !m_services)
     {
-        return L"";
+        return;
     }
 
     IEnumWbemClassObject* pEnumerator = NULL;
@@ -89,12 +156,11 @@ std::wstring WbemHelper::Query(const std::wstring& query, const std::wstring& pr
     if (FAILED(hres))
     {
         Logger::error(L"Query for process failed. Error: {}", get_last_error_or_default(hres));
-        return L"";
+        return;
     }
 
     IWbemClassObject* pClassObject = NULL;
     ULONG uReturn = 0;
-    std::wstring result = L"";
     while (pEnumerator)
     {
         HRESULT hr = pEnumerator->Next(WBEM_INFINITE, 1, &pClassObject, &uReturn);
@@ -103,18 +169,9 @@ std::wstring WbemHelper::Query(const std::wstring& query, const std::wstring& pr
             break;
         }
 
-        VARIANT vtProp;
-        hr = pClassObject->Get(propertyName.c_str(), 0, &vtProp, 0, 0);
-        if (SUCCEEDED(hr) && vtProp.vt == VT_BSTR)
-        {
-            result = vtProp.bstrVal;
-        }
-        VariantClear(&vtProp);
-
+        callback(pClassObject);
         pClassObject->Release();
     }
 
     pEnumerator->Release();
-
-    return result;
 }
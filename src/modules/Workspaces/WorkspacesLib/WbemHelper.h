@@ -1,5 +1,9 @@
 #pragma once
 
+#include <functional>
+#include <map>
+
+struct IWbemClassObject;
 struct IWbemLocator;
 struct IWbemServices;
 
@@ -9,15 +13,26 @@ public:
     static std::unique_ptr<WbemHelper> Create();
     ~WbemHelper();
 
+    struct ProcessInfo
+    {
+        std::wstring executablePath;
+        std::wstring commandLine;
+    };
+
     std::wstring GetCommandLineArgs(DWORD processID) const;
     std::wstring GetExecutablePath(DWORD processID) const;
 
+    // Queries several processes at once, each WMI round trip costs as much as a whole batch.
+    // Processes that are gone are missing from the result.
+    std::map<DWORD, ProcessInfo> GetProcesses(const std::vector<DWORD>& processIDs) const;
+
 private:
     WbemHelper() = default;
 
     bool Initialize();
 
     std::wstring Query(const std::wstring& query, const std::wstring& propertyName) const;
+    void Query(const std::wstring& query, const std::function<void(IWbemClassObject*)>& callback) const;
 
     IWbemLocator* m_locator = NULL;
     IWbemServices* m_services = NULL;
@@ -6,14 +6,19 @@
 
 constexpr DWORD BUFSIZE = 1024;
 
+// Messages queued while a write or a dispatch is in progress are handled together, e.g. sent with a single write
+constexpr size_t MAX_BATCH_MESSAGES = 64;
+
 TwoWayPipeMessageIPC::TwoWayPipeMessageIPC(
     std::wstring _input_pipe_name,
     std::wstring _output_pipe_name,
-    callback_function p_func) :
+    callback_function p_func,
+    binary_callback_function p_binary_func) :
     impl(new TwoWayPipeMessageIPC::TwoWayPipeMessageIPCImpl(
         _input_pipe_name,
         _output_pipe_name,
-        p_func))
+        p_func,
+        p_binary_func))
 {
 }
 
@@ -24,7 +29,12 @@ TwoWayPipeMessageIPC::~TwoWayPipeMessageIPC()
 
 void TwoWayPipeMessageIPC::send(std::wstring msg)
 {
-    impl->send(msg);
+    impl->send(std::move(msg));
+}
+
+void TwoWayPipeMessageIPC::send_binary(std::vector<uint8_t> payload)
+{
+    impl->send_binary(std::move(payload));
 }
 
 void TwoWayPipeMessageIPC::start(HANDLE _restricted_pipe_token)
@@ -40,16 +50,23 @@ void TwoWayPipeMessageIPC::end()
 TwoWayPipeMessageIPC::TwoWayPipeMessageIPCImpl::TwoWayPipeMessageIPCImpl(
     std::wstring _input_pipe_name,
     std::wstring _output_pipe_name,
-    callback_function p_func)
+    callback_function p_func,
+    binary_callback_function p_binary_func)
 {
     input_pipe_name = _input_pipe_name;
     output_pipe_name = _output_pipe_name;
     dispatch_inc_message_function = p_func;
+    dispatch_inc_binary_message_function = p_binary_func;
 }
 
 void TwoWayPipeMessageIPC::TwoWayPipeMessageIPCImpl::send(std::wstring msg)
 {
-    output_queue.queue_message(msg);
+    output_queue.queue_message(MessageFraming::MessageBuffer::from_text(msg));
+}
+
+void TwoWayPipeMessageIPC::TwoWayPipeMessageIPCImpl::send_binary(std::vector<uint8_t> payload)
+{
+    output_queue.queue_message(MessageFraming::MessageBuffer(MessageFraming::PayloadType::Binary, std::move(payload)));
 }
 
 void TwoWayPipeMessageIPC::TwoWayPipeMessageIPCImpl::start(HANDLE _restricted_pipe_token)
@@ -66,6 +83,7 @@ void TwoWayPipeMessageIPC::TwoWayPipeMessageIPCImpl::end()
     input_queue_thread.join();
     output_queue.interrupt();
     output_queue_thread.join();
+    close_output_pipe();
     pipe_connect_handle_mutex.lock();
     if (current_connect_pipe_handle != NULL)
     {
@@ -74,15 +92,37 @@ void TwoWayPipeMessageIPC::TwoWayPipeMessageIPCImpl::end()
     }
     pipe_connect_handle_mutex.unlock();
     input_pipe_thread.join();
+
+    // No new connections are accepted anymore. A read can start right after it was canceled,
+    // so the reads are canceled until the connection threads notice.
+    for (auto& connection : connections)
+    {
+        while (true)
+        {
+            std::unique_lock lock(pipe_connect_handle_mutex);
+            if (connection.finished)
+            {
+                break;
+            }
+            CancelIoEx(connection.pipe_handle, NULL);
+            lock.unlock();
+            Sleep(10);
+        }
+        connection.thread.join();
+        DisconnectNamedPipe(connection.pipe_handle);
+        CloseHandle(connection.pipe_handle);
+    }
+    connections.clear();
 }
 
-void TwoWayPipeMessageIPC::TwoWayPipeMessageIPCImpl::send_pipe_message(std::wstring message)
+bool TwoWayPipeMessageIPC::TwoWayPipeMessageIPCImpl::connect_output_pipe()
 {
     // Adapted from https://learn.microsoft.com/windows/win32/ipc/named-pipe-client
-    HANDLE output_pipe_handle;
-    const wchar_t* message_send = message.c_str();
-    BOOL fSuccess = FALSE;
-    DWORD cbToWrite, cbWritten, dwMode;
+    if (output_pipe_handle != INVALID_HANDLE_VALUE)
+    {
+        return true;
+    }
+
     const wchar_t* lpszPipename = output_pipe_name.c_str();
 
     // Try to open a named pipe; wait for it, if necessary.
@@ -108,55 +148,92 @@ void TwoWayPipeMessageIPC::TwoWayPipeMessageIPCImpl::send_pipe_message(std::wstr
         DWORD curr_error = 0;
         if ((curr_error = GetLastError()) != ERROR_PIPE_BUSY)
         {
-            return;
+            return false;
         }
 
         // All pipe instances are busy, so wait for 20 seconds.
 
         if (!WaitNamedPipe(lpszPipename, 20000))
         {
-            return;
+            return false;
         }
     }
-    dwMode = PIPE_READMODE_MESSAGE;
-    fSuccess = SetNamedPipeHandleState(
-        output_pipe_handle, // pipe handle
-        &dwMode, // new pipe mode
-        NULL, // don't set maximum bytes
-        NULL); // don't set maximum time
-    if (!fSuccess)
+
+    // The connection is kept open and carries a byte stream of frames, see message_framing.h
+    return true;
+}
+
+void TwoWayPipeMessageIPC::TwoWayPipeMessageIPCImpl::close_output_pipe()
+{
+    if (output_pipe_handle != INVALID_HANDLE_VALUE)
     {
-        return;
+        CloseHandle(output_pipe_handle);
+        output_pipe_handle = INVALID_HANDLE_VALUE;
     }
+}
 
-    // Send a message to the pipe server.
+bool TwoWayPipeMessageIPC::TwoWayPipeMessageIPCImpl::send_pipe_messages(const std::vector<uint8_t>& frames)
+{
+    // The receiver may have restarted since the last message, so a broken connection is reopened once
+    for (int attempt = 0; attempt < 2; attempt++)
+    {
+        if (!connect_output_pipe())
+        {
+            return false;
+        }
 
-    cbToWrite = (lstrlen(message_send)) * sizeof(WCHAR); // no need to send final '\0'. Pipe is in message mode.
+        const uint8_t* data = frames.data();
+        size_t remaining = frames.size();
+        while (remaining > 0)
+        {
+            DWORD cbWritten = 0;
+            if (!WriteFile(
+                    output_pipe_handle, // pipe handle
+                    data, // frames
+                    static_cast<DWORD>((std::min)(remaining, static_cast<size_t>(MAXDWORD))), // frames length
+                    &cbWritten, // bytes written
+                    NULL)) // not overlapped
+            {
+                break;
+            }
+            data += cbWritten;
+            remaining -= cbWritten;
+        }
 
-    fSuccess = WriteFile(
-        output_pipe_handle, // pipe handle
-        message_send, // message
-        cbToWrite, // message length
-        &cbWritten, // bytes written
-        NULL); // not overlapped
-    if (!fSuccess)
-    {
-        return;
+        if (remaining == 0)
+        {
+            return true;
+        }
+
+        close_output_pipe();
+        if (remaining != frames.size())
+        {
+            // Part of the frames was already sent, resending them would duplicate messages
+            return false;
+        }
     }
-    CloseHandle(output_pipe_handle);
-    return;
+    return false;
 }
 
 void TwoWayPipeMessageIPC::TwoWayPipeMessageIPCImpl::consume_output_queue_thread()
 {
-    while (!closed)
+    std::vector<MessageFraming::MessageBuffer> messages;
+    std::vector<uint8_t> frames;
+    // Runs until the queue is interrupted and the messages queued before that are sent
+    while (true)
     {
-        std::wstring message = output_queue.pop_message();
-        if (message.length() == 0)
+        messages.clear();
+        if (output_queue.drain(messages, MAX_BATCH_MESSAGES) == 0)
         {
             break;
         }
-        send_pipe_message(message);
+
+        frames.clear();
+        for (const auto& message : messages)
+        {
+            MessageFraming::encode(message, frames);
+        }
+        send_pipe_messages(frames);
     }
 }
 
@@ -354,46 +431,56 @@ void TwoWayPipeMessageIPC::TwoWayPipeMessageIPCImpl::handle_pipe_connection(HAND
     {
         return;
     }
-    constexpr DWORD readBlockBytes = BUFSIZE;
-    std::wstring message;
-    size_t iBlock = 0;
-    message.reserve(BUFSIZE);
-    bool ok;
-    do
-    {
-        constexpr size_t charsPerBlock = readBlockBytes / sizeof(message[0]);
-        message.resize(message.size() + charsPerBlock);
+
+    // Reads frames until the client disconnects or the server is closed
+    auto read_pipe = [this, input_pipe_handle](uint8_t* buffer, size_t size) -> ptrdiff_t {
         DWORD bytesRead = 0;
-        ok = ReadFile(
-            input_pipe_handle,
-            // read the message directly into the string block by block simultaneously resizing it
-            message.data() + iBlock * charsPerBlock,
-            readBlockBytes,
-            &bytesRead,
-            nullptr);
-
-        if (!ok && GetLastError() != ERROR_MORE_DATA)
+        if (closed || !ReadFile(input_pipe_handle, buffer, static_cast<DWORD>(size), &bytesRead, nullptr))
         {
-            break;
+            return -1;
         }
-        iBlock++;
-    } while (!ok);
-    // trim the message's buffer
-    const auto nullCharPos = message.find_last_not_of(L'\0');
-    if (nullCharPos != std::wstring::npos)
+        return bytesRead;
+    };
+    MessageFraming::FrameReader reader(read_pipe, BUFSIZE);
+
+    while (auto message = reader.read())
     {
-        message.resize(nullCharPos + 1);
+        input_queue.queue_message(std::move(message.value()));
     }
 
-    input_queue.queue_message(std::move(message));
+    // The handle is disconnected and closed by the server thread
+    std::unique_lock lock(pipe_connect_handle_mutex);
+    for (auto& connection : connections)
+    {
+        if (connection.pipe_handle == input_pipe_handle)
+        {
+            connection.finished = true;
+        }
+    }
+}
 
-    // Flush the pipe to allow the client to read the pipe's contents
-    // before disconnecting. Then disconnect the pipe, and close the
-    // handle to this pipe instance.
+void TwoWayPipeMessageIPC::TwoWayPipeMessageIPCImpl::cleanup_finished_connections()
+{
+    std::list<Connection> finished;
+    {
+        std::unique_lock lock(pipe_connect_handle_mutex);
+        for (auto it = connections.begin(); it != connections.end();)
+        {
+            auto next = std::next(it);
+            if (it->finished)
+            {
+                finished.splice(finished.end(), connections, it);
+            }
+            it = next;
+        }
+    }
 
-    FlushFileBuffers(input_pipe_handle);
-    DisconnectNamedPipe(input_pipe_handle);
-    CloseHandle(input_pipe_handle);
+    for (auto& connection : finished)
+    {
+        connection.thread.join();
+        DisconnectNamedPipe(connection.pipe_handle);
+        CloseHandle(connection.pipe_handle);
+    }
 }
 
 void TwoWayPipeMessageIPC::TwoWayPipeMessageIPCImpl::start_named_pipe_server(HANDLE token)
@@ -410,8 +497,8 @@ void TwoWayPipeMessageIPC::TwoWayPipeMessageIPCImpl::start_named_pipe_server(HAN
                 pipe_name,
                 PIPE_ACCESS_DUPLEX |
                     WRITE_DAC,
-                PIPE_TYPE_MESSAGE |
-                    PIPE_READMODE_MESSAGE |
+                PIPE_TYPE_BYTE |
+                    PIPE_READMODE_BYTE |
                     PIPE_WAIT,
                 PIPE_UNLIMITED_INSTANCES,
                 BUFSIZE,
@@ -435,13 +522,16 @@ void TwoWayPipeMessageIPC::TwoWayPipeMessageIPCImpl::start_named_pipe_server(HAN
             std::unique_lock lock(pipe_connect_handle_mutex);
             current_connect_pipe_handle = NULL;
         }
-        if (connected)
+        cleanup_finished_connections();
+        std::unique_lock lock(pipe_connect_handle_mutex);
+        if (connected && !closed)
         {
-            std::thread(&TwoWayPipeMessageIPCImpl::handle_pipe_connection, this, connect_pipe_handle).detach();
+            auto& connection = connections.emplace_back(Connection{ connect_pipe_handle });
+            connection.thread = std::thread(&TwoWayPipeMessageIPCImpl::handle_pipe_connection, this, connect_pipe_handle);
         }
         else
         {
-            // Client could not connect.
+            // Client could not connect, or the server is closing.
             CloseHandle(connect_pipe_handle);
         }
     }
@@ -449,21 +539,35 @@ void TwoWayPipeMessageIPC::TwoWayPipeMessageIPCImpl::start_named_pipe_server(HAN
 
 void TwoWayPipeMessageIPC::TwoWayPipeMessageIPCImpl::consume_input_queue_thread()
 {
-    while (!closed)
+    std::vector<MessageFraming::MessageBuffer> messages;
+    while (true)
     {
-        outgoing_message = L"";
-        std::wstring message = input_queue.pop_message();
-        if (message.length() == 0)
+        messages.clear();
+        if (input_queue.drain(messages, MAX_BATCH_MESSAGES) == 0)
         {
             break;
         }
 
-        // Check if callback method exists first before trying to call it.
-        // otherwise just store the response message in a variable.
-        if (dispatch_inc_message_function != nullptr)
+        for (auto& message : messages)
         {
-            dispatch_inc_message_function(message);
+            outgoing_message = L"";
+            if (message.type() == MessageFraming::PayloadType::Binary)
+            {
+                if (dispatch_inc_binary_message_function != nullptr)
+                {
+                    dispatch_inc_binary_message_function(message.release());
+                }
+                continue;
+            }
+
+            // Check if callback method exists first before trying to call it.
+            // otherwise just store the response message in a variable.
+            std::wstring text = message.to_text();
+            if (dispatch_inc_message_function != nullptr)
+            {
+                dispatch_inc_message_function(text);
+            }
+            outgoing_message = std::move(text);
         }
-        outgoing_message = message;
     }
 }
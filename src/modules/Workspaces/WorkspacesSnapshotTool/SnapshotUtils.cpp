@@ -1,6 +1,9 @@
 #include "pch.h"
 #include "SnapshotUtils.h"
 
+#include <chrono>
+#include <map>
+
 #include <common/utils/elevation.h>
 #include <common/utils/process_path.h>
 #include <common/utils/resources.h>
@@ -42,14 +45,78 @@ namespace SnapshotUtils
         return false;
     }
 
+    // Windows of the same process share its data, so it's collected once per process
+    class ProcessCache
+    {
+    public:
+        const std::wstring& GetPath(DWORD pid)
+        {
+            auto iter = m_paths.find(pid);
+            if (iter == m_paths.end())
+            {
+                iter = m_paths.emplace(pid, get_process_path(pid)).first;
+            }
+
+            return iter->second;
+        }
+
+        bool IsElevated(DWORD pid)
+        {
+            auto iter = m_elevated.find(pid);
+            if (iter == m_elevated.end())
+            {
+                iter = m_elevated.emplace(pid, IsProcessElevated(pid)).first;
+            }
+
+            return iter->second;
+        }
+
+        std::optional<Utils::Apps::AppData> GetApp(const std::wstring& processPath, DWORD pid, const Utils::Apps::AppList& installedApps)
+        {
+            auto key = std::make_pair(pid, processPath);
+            auto iter = m_apps.find(key);
+            if (iter == m_apps.end())
+            {
+                iter = m_apps.emplace(key, Utils::Apps::GetApp(processPath, pid, installedApps)).first;
+            }
+
+            return iter->second;
+        }
+
+    private:
+        std::map<DWORD, std::wstring> m_paths;
+        std::map<DWORD, bool> m_elevated;
+        std::map<std::pair<DWORD, std::wstring>, std::optional<Utils::Apps::AppData>> m_apps;
+    };
+
     std::vector<WorkspacesData::WorkspacesProject::Application> GetApps(bool isGuidNeeded, const std::function<unsigned int(HWND)> getMonitorNumberFromWindowHandle, const std::function<WorkspacesData::WorkspacesProject::Monitor::MonitorRect(unsigned int)> getMonitorRect)
     {
+        using Clock = std::chrono::steady_clock;
+        auto elapsedMs = [](Clock::time_point start, Clock::time_point end) { return std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count(); };
+
+        const auto startTime = Clock::now();
         Utils::PwaHelper pwaHelper{};
         std::vector<WorkspacesData::WorkspacesProject::Application> apps{};
 
+        const auto pwaTime = Clock::now();
         auto installedApps = Utils::Apps::GetAppsList();
+
+        const auto installedAppsTime = Clock::now();
         auto windows = WindowEnumerator::Enumerate(WindowFilter::Filter);
 
+        const auto windowsTime = Clock::now();
+        ProcessCache processes{};
+        std::map<HWND, std::wstring> titles{};
+        auto getTitle = [&](HWND window) -> const std::wstring& {
+            auto iter = titles.find(window);
+            if (iter == titles.end())
+            {
+                iter = titles.emplace(window, WindowUtils::GetWindowTitle(window)).first;
+            }
+
+            return iter->second;
+        };
+
         for (const auto window : windows)
         {
             // filter by window rect size
@@ -60,7 +127,7 @@ namespace SnapshotUtils
             }
 
             // filter by window title
-            std::wstring title = WindowUtils::GetWindowTitle(window);
+            std::wstring title = getTitle(window);
             if (title.empty())
             {
                 continue;
@@ -70,12 +137,18 @@ namespace SnapshotUtils
             GetWindowThreadProcessId(window, &pid);
 
             // filter by app path
-            std::wstring processPath = get_process_path(window);
+            std::wstring processPath = processes.GetPath(pid);
+            if (processPath.ends_with(NonLocalizable::ApplicationFrameHost))
+            {
+                // the app hosted in the frame is found by the window
+                processPath = get_process_path(window);
+            }
+
             if (processPath.empty())
             {
                 // When PT runs not as admin, it can't get the process path of the window of the elevated process.
                 // Notify the user that running as admin is required to process elevated windows.
-                if (!is_process_elevated() && IsProcessElevated(pid))
+                if (!is_process_elevated() && processes.IsElevated(pid))
                 {
                     auto notificationUtil = std::make_unique<notifications::NotificationUtil>();
 
@@ -102,9 +175,9 @@ namespace SnapshotUtils
                     GetWindowThreadProcessId(otherWindow, &otherPid);
 
                     // searching for the window with the same title but different PID
-                    if (pid != otherPid && title == WindowUtils::GetWindowTitle(otherWindow))
+                    if (pid != otherPid && title == getTitle(otherWindow))
                     {
-                        processPath = get_process_path(otherPid);
+                        processPath = processes.GetPath(otherPid);
                         break;
                     }
                 }
@@ -115,7 +188,7 @@ namespace SnapshotUtils
                 continue;
             }
 
-            auto data = Utils::Apps::GetApp(processPath, pid, installedApps);
+            auto data = processes.GetApp(processPath, pid, installedApps);
             if (!data.has_value() || data->name.empty())
             {
                 Logger::info(L"Installed app not found: {}", processPath);
@@ -174,7 +247,7 @@ namespace SnapshotUtils
                 .appUserModelId = appData.appUserModelId,
                 .pwaAppId = appData.pwaAppId,
                 .commandLineArgs = L"",
-                .isElevated = IsProcessElevated(pid),
+                .isElevated = processes.IsElevated(pid),
                 .canLaunchElevated = appData.canLaunchElevated,
                 .isMinimized = isMinimized,
                 .isMaximized = WindowUtils::IsMaximized(window),
@@ -190,6 +263,16 @@ namespace SnapshotUtils
             apps.push_back(app);
         }
 
+        const auto endTime = Clock::now();
+        Logger::info(L"Captured {} apps from {} windows in {} ms: PWA data {} ms, installed apps {} ms, windows {} ms, processing {} ms",
+                     apps.size(),
+                     windows.size(),
+                     elapsedMs(startTime, endTime),
+                     elapsedMs(startTime, pwaTime),
+                     elapsedMs(pwaTime, installedAppsTime),
+                     elapsedMs(installedAppsTime, windowsTime),
+                     elapsedMs(windowsTime, endTime));
+
         return apps;
     }
 }
\ No newline at end of file
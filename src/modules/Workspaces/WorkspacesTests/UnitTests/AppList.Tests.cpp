@@ -0,0 +1,52 @@
+#include "pch.h"
+#include <WorkspacesLib/AppUtils.h>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using Utils::Apps::AppData;
+using Utils::Apps::AppList;
+
+namespace WorkspacesUnitTests
+{
+    TEST_CLASS (AppListUnitTests)
+    {
+    public:
+        TEST_METHOD (FindByNameKeepsTheFirstMatch)
+        {
+            const AppList apps({
+                AppData{ .name = L"Terminal", .installPath = L"C:\\First\\wt.exe" },
+                AppData{ .name = L"Terminal", .installPath = L"C:\\Second\\wt.exe" },
+            });
+
+            Assert::AreEqual(std::wstring(L"C:\\First\\wt.exe"), apps.FindByName(L"Terminal")->installPath);
+            Assert::AreEqual(std::wstring(L"C:\\First\\wt.exe"), apps.FindByNameUpper(L"TERMINAL")->installPath);
+            Assert::IsNull(apps.FindByName(L"TERMINAL"));
+        }
+
+        TEST_METHOD (FindByFileNameKeepsTheLastMatch)
+        {
+            // Apps with the same executable in different folders, the last one in the list wins
+            const AppList apps({
+                AppData{ .name = L"First", .installPath = L"C:\\First\\app.exe" },
+                AppData{ .name = L"Second", .installPath = L"C:\\Second\\app.exe" },
+                AppData{ .name = L"NoPath" },
+                AppData{ .name = L"Third", .installPath = L"C:\\Third\\other.exe" },
+            });
+
+            Assert::AreEqual(std::wstring(L"Second"), apps.FindByFileName(L"app.exe")->name);
+            Assert::AreEqual(std::wstring(L"Third"), apps.FindByFileName(L"other.exe")->name);
+            Assert::IsNull(apps.FindByFileName(L"missing.exe"));
+        }
+
+        TEST_METHOD (FindByFileNameIsCaseSensitive)
+        {
+            const AppList apps({
+                AppData{ .name = L"Lower", .installPath = L"C:\\Lower\\app.exe" },
+                AppData{ .name = L"Upper", .installPath = L"C:\\Upper\\APP.EXE" },
+            });
+
+            Assert::AreEqual(std::wstring(L"Lower"), apps.FindByFileName(L"app.exe")->name);
+            Assert::AreEqual(std::wstring(L"Upper"), apps.FindByFileName(L"APP.EXE")->name);
+            Assert::IsNull(apps.FindByFileName(L"App.exe"));
+        }
+    };
+}
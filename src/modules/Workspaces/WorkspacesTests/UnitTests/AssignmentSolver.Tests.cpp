@@ -0,0 +1,152 @@
+#include "pch.h"
+#include <modules/Workspaces/workspaces-common/AssignmentSolver.h>
+
+#include <random>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using AssignmentSolver::Forbidden;
+
+namespace WorkspacesUnitTests
+{
+    namespace
+    {
+        using Costs = std::vector<std::vector<int64_t>>;
+
+        struct Score
+        {
+            size_t matched = 0;
+            int64_t cost = 0;
+        };
+
+        // Checks that the assignment is one and returns how good it is
+        Score Evaluate(const Costs& costs, const std::vector<int>& assignment)
+        {
+            Assert::AreEqual(costs.size(), assignment.size());
+
+            Score score;
+            std::vector<bool> used(costs.empty() ? 0 : costs[0].size(), false);
+            for (size_t row = 0; row < assignment.size(); row++)
+            {
+                const int col = assignment[row];
+                if (col < 0)
+                {
+                    continue;
+                }
+
+                Assert::IsTrue(static_cast<size_t>(col) < used.size());
+                Assert::IsFalse(used[col]);
+                Assert::IsTrue(costs[row][col] != Forbidden);
+                used[col] = true;
+                score.matched++;
+                score.cost += costs[row][col];
+            }
+            return score;
+        }
+
+        // Tries every assignment: the most pairs first, then the lowest cost
+        void BruteForce(const Costs& costs, size_t row, std::vector<bool>& used, Score current, Score& best)
+        {
+            if (row == costs.size())
+            {
+                if (current.matched > best.matched || (current.matched == best.matched && current.cost < best.cost))
+                {
+                    best = current;
+                }
+                return;
+            }
+
+            BruteForce(costs, row + 1, used, current, best);
+            for (size_t col = 0; col < used.size(); col++)
+            {
+                if (!used[col] && costs[row][col] != Forbidden)
+                {
+                    used[col] = true;
+                    BruteForce(costs, row + 1, used, { current.matched + 1, current.cost + costs[row][col] }, best);
+                    used[col] = false;
+                }
+            }
+        }
+
+        Score BruteForce(const Costs& costs)
+        {
+            std::vector<bool> used(costs.empty() ? 0 : costs[0].size(), false);
+            Score best;
+            BruteForce(costs, 0, used, {}, best);
+            return best;
+        }
+    }
+
+    TEST_CLASS (AssignmentSolverUnitTests)
+    {
+    public:
+        TEST_METHOD (Empty)
+        {
+            Assert::IsTrue(AssignmentSolver::Solve({}).empty());
+            Assert::IsTrue(std::vector<int>{ -1, -1 } == AssignmentSolver::Solve({ {}, {} }));
+            Assert::IsTrue(std::vector<int>{ -1 } == AssignmentSolver::Solve({ { Forbidden } }));
+        }
+
+        TEST_METHOD (LowestTotalCost)
+        {
+            // Each row on its cheapest column would take column 0 twice
+            const Costs costs = {
+                { 1, 4, 5 },
+                { 2, 8, 9 },
+                { 7, 3, 2 },
+            };
+            Assert::IsTrue(std::vector<int>{ 1, 0, 2 } == AssignmentSolver::Solve(costs));
+        }
+
+        TEST_METHOD (MoreRowsThanColumns)
+        {
+            const Costs costs = {
+                { 5, 9 },
+                { 1, 2 },
+                { 4, 1 },
+            };
+            Assert::IsTrue(std::vector<int>{ -1, 0, 1 } == AssignmentSolver::Solve(costs));
+        }
+
+        TEST_METHOD (MostPairsBeforeLowestCost)
+        {
+            // Row 0 alone on column 0 is cheaper, but then row 1 stays unmatched
+            const Costs costs = {
+                { 1, 50 },
+                { 1, Forbidden },
+            };
+            Assert::IsTrue(std::vector<int>{ 1, 0 } == AssignmentSolver::Solve(costs));
+        }
+
+        TEST_METHOD (ForbiddenPairsAreNeverMatched)
+        {
+            const Costs costs = {
+                { Forbidden, Forbidden },
+                { Forbidden, 3 },
+            };
+            Assert::IsTrue(std::vector<int>{ -1, 1 } == AssignmentSolver::Solve(costs));
+        }
+
+        TEST_METHOD (SameResultsAsBruteForce)
+        {
+            std::mt19937 random{ 34 };
+            for (int round = 0; round < 1000; round++)
+            {
+                const size_t rows = random() % 6;
+                const size_t cols = random() % 6;
+                Costs costs(rows, std::vector<int64_t>(cols));
+                for (auto& row : costs)
+                {
+                    for (auto& cost : row)
+                    {
+                        cost = random() % 4 == 0 ? Forbidden : static_cast<int64_t>(random() % 20);
+                    }
+                }
+
+                const auto expected = BruteForce(costs);
+                const auto actual = Evaluate(costs, AssignmentSolver::Solve(costs));
+                Assert::AreEqual(expected.matched, actual.matched);
+                Assert::AreEqual(expected.cost, actual.cost);
+            }
+        }
+    };
+}
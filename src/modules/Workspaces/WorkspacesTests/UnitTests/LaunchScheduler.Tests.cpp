@@ -0,0 +1,227 @@
+#include "pch.h"
+#include <modules/Workspaces/WorkspacesLauncher/LaunchScheduler.h>
+
+#include <map>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace std::chrono_literals;
+
+namespace WorkspacesUnitTests
+{
+    namespace
+    {
+        using TimePoint = LaunchScheduler::TimePoint;
+        using Milliseconds = std::chrono::milliseconds;
+
+        const TimePoint start = TimePoint{} + 1h;
+
+        // How an app behaves when the fake launcher starts it
+        struct FakeApp
+        {
+            LaunchScheduler::App app;
+            Milliseconds launchTime;
+
+            // When the arranger moves its window after the launch call returned, never if not set
+            std::optional<Milliseconds> windowTime;
+            bool fails = false;
+        };
+
+        std::vector<LaunchScheduler::App> Apps(const std::vector<FakeApp>& fakeApps)
+        {
+            std::vector<LaunchScheduler::App> apps;
+            for (const auto& fakeApp : fakeApps)
+            {
+                apps.push_back(fakeApp.app);
+            }
+            return apps;
+        }
+
+        // Runs the scheduler on a fake clock the way the launcher does, waking up on the events of the fake
+        // launcher and the deadlines of the scheduler. Returns when each app was launched.
+        std::vector<std::optional<Milliseconds>> Run(LaunchScheduler& scheduler, const std::vector<FakeApp>& apps)
+        {
+            enum class Event
+            {
+                Launched,
+                WindowMoved,
+            };
+
+            std::vector<std::optional<Milliseconds>> launchedAt(apps.size());
+            std::multimap<TimePoint, std::pair<size_t, Event>> events;
+            TimePoint now = start;
+            while (!scheduler.Done())
+            {
+                for (const auto index : scheduler.Next(now))
+                {
+                    Assert::IsFalse(launchedAt[index].has_value());
+                    launchedAt[index] = std::chrono::duration_cast<Milliseconds>(now - start);
+                    events.emplace(now + apps[index].launchTime, std::pair{ index, Event::Launched });
+                }
+
+                std::optional<TimePoint> wakeUp;
+                if (!events.empty())
+                {
+                    wakeUp = events.begin()->first;
+                }
+                if (const auto deadline = scheduler.NextDeadline(); deadline.has_value() && deadline.value() > now && (!wakeUp.has_value() || deadline.value() < wakeUp.value()))
+                {
+                    wakeUp = deadline;
+                }
+
+                // Nothing to wait for while something is still pending would hang the launcher
+                Assert::IsTrue(wakeUp.has_value());
+                now = wakeUp.value();
+
+                while (!events.empty() && events.begin()->first <= now)
+                {
+                    const auto [time, event] = *events.begin();
+                    events.erase(events.begin());
+
+                    const auto& app = apps[event.first];
+                    if (event.second == Event::Launched)
+                    {
+                        scheduler.OnLaunched(event.first, !app.fails, time);
+                        if (!app.fails && app.windowTime.has_value())
+                        {
+                            events.emplace(time + app.windowTime.value(), std::pair{ event.first, Event::WindowMoved });
+                        }
+                    }
+                    else
+                    {
+                        scheduler.OnFinished(event.first, time);
+                    }
+                }
+            }
+            return launchedAt;
+        }
+
+        const LaunchScheduler::App terminal{ L"Terminal", L"C:\\Program Files\\WindowsApps\\Terminal\\WindowsTerminal.exe" };
+        const LaunchScheduler::App edge{ L"Edge", L"C:\\Program Files (x86)\\Microsoft\\Edge\\Application\\msedge.exe" };
+        const LaunchScheduler::App outlook{ L"Outlook", L"C:\\Program Files\\Microsoft Office\\root\\Office16\\outlook.exe" };
+        const LaunchScheduler::App notepad{ L"Notepad", L"C:\\Windows\\System32\\notepad.exe" };
+        const LaunchScheduler::App paint{ L"Paint", L"C:\\Windows\\System32\\mspaint.exe" };
+    }
+
+    TEST_CLASS (LaunchSchedulerUnitTests)
+    {
+    public:
+        TEST_METHOD (IndependentAppsLaunchTogether)
+        {
+            LaunchScheduler scheduler({ terminal, edge, notepad });
+            Assert::IsTrue(std::vector<size_t>{ 0, 1, 2 } == scheduler.Next(start));
+            Assert::IsTrue(scheduler.Next(start).empty());
+            Assert::IsFalse(scheduler.Done());
+
+            for (size_t i = 0; i < 3; i++)
+            {
+                scheduler.OnLaunched(i, true, start + 10ms);
+            }
+            Assert::IsTrue(scheduler.Done());
+        }
+
+        TEST_METHOD (LaunchesInFlightAreBounded)
+        {
+            LaunchScheduler scheduler({ terminal, edge, outlook, notepad, paint }, {}, { .maxConcurrentLaunches = 2 });
+            Assert::IsTrue(std::vector<size_t>{ 0, 1 } == scheduler.Next(start));
+
+            scheduler.OnLaunched(1, true, start + 10ms);
+            Assert::IsTrue(std::vector<size_t>{ 2 } == scheduler.Next(start + 10ms));
+
+            scheduler.OnLaunched(0, false, start + 20ms);
+            scheduler.OnLaunched(2, true, start + 20ms);
+            Assert::IsTrue(std::vector<size_t>{ 3, 4 } == scheduler.Next(start + 20ms));
+        }
+
+        TEST_METHOD (InstancesWaitForThePreviousWindow)
+        {
+            LaunchScheduler scheduler({ terminal, terminal });
+            Assert::IsTrue(std::vector<size_t>{ 0 } == scheduler.Next(start));
+
+            // Not before the window of the first instance is moved
+            scheduler.OnLaunched(0, true, start + 100ms);
+            Assert::IsTrue(scheduler.Next(start + 200ms).empty());
+            Assert::IsTrue(scheduler.NextDeadline() == start + 3100ms);
+
+            scheduler.OnFinished(0, start + 500ms);
+            Assert::IsTrue(scheduler.NextDeadline() == start + 500ms);
+            Assert::IsTrue(std::vector<size_t>{ 1 } == scheduler.Next(start + 500ms));
+        }
+
+        TEST_METHOD (InstancesStopWaitingAfterTheTimeout)
+        {
+            LaunchScheduler scheduler({ terminal, terminal }, {}, { .instanceTimeout = 3000ms });
+            scheduler.Next(start);
+            scheduler.OnLaunched(0, true, start);
+
+            Assert::IsTrue(scheduler.Next(start + 2999ms).empty());
+            Assert::IsTrue(std::vector<size_t>{ 1 } == scheduler.Next(start + 3000ms));
+        }
+
+        TEST_METHOD (InstancesAreRecognizedByNameOrPath)
+        {
+            const LaunchScheduler::App renamed{ L"My terminal", terminal.path };
+            const LaunchScheduler::App moved{ terminal.name, L"D:\\Terminal\\WindowsTerminal.exe" };
+            LaunchScheduler scheduler({ terminal, renamed, moved, edge });
+            Assert::IsTrue(std::vector<size_t>{ 0, 3 } == scheduler.Next(start));
+        }
+
+        TEST_METHOD (FailedLaunchReleasesTheNextInstance)
+        {
+            LaunchScheduler scheduler({ terminal, terminal });
+            scheduler.Next(start);
+            scheduler.OnLaunched(0, false, start + 100ms);
+            Assert::IsTrue(std::vector<size_t>{ 1 } == scheduler.Next(start + 100ms));
+        }
+
+        TEST_METHOD (AppsFinishedWithoutLaunching)
+        {
+            // An existing window was moved, the app isn't launched and the next instance doesn't wait
+            LaunchScheduler scheduler({ terminal, terminal, edge });
+            scheduler.OnFinished(0, start);
+            Assert::IsTrue(std::vector<size_t>{ 1, 2 } == scheduler.Next(start));
+        }
+
+        TEST_METHOD (RulesDelayTheNextInstance)
+        {
+            LaunchScheduler scheduler({ outlook, outlook });
+            scheduler.Next(start);
+            scheduler.OnLaunched(0, true, start + 200ms);
+            scheduler.OnFinished(0, start + 1000ms);
+
+            // The rule matches the file name whatever its case
+            Assert::IsTrue(scheduler.NextDeadline() == start + 2000ms);
+            Assert::IsTrue(scheduler.Next(start + 1999ms).empty());
+            Assert::IsTrue(std::vector<size_t>{ 1 } == scheduler.Next(start + 2000ms));
+        }
+
+        TEST_METHOD (WorkspaceWithFakeLauncher)
+        {
+            const std::vector<FakeApp> apps = {
+                { terminal, 50ms, 400ms },
+                { edge, 100ms, 800ms },
+                { terminal, 50ms, 300ms },
+                { outlook, 200ms, 1500ms },
+                { outlook, 200ms, 1500ms },
+                { notepad, 20ms, 100ms },
+                { paint, 30ms, std::nullopt },
+                { paint, 30ms, std::nullopt },
+                { notepad, 20ms, 100ms, true },
+            };
+            LaunchScheduler scheduler(Apps(apps));
+            const auto launchedAt = Run(scheduler, apps);
+
+            const std::vector<std::optional<Milliseconds>> expected = {
+                0ms, // four launches in flight at first
+                0ms,
+                450ms, // after the window of the first terminal is moved
+                0ms,
+                2700ms, // one second after the window of the first Outlook is moved
+                0ms,
+                20ms, // when the Notepad launch call returns
+                3050ms, // the window of the first Paint is never moved, so after the timeout
+                120ms,
+            };
+            Assert::IsTrue(expected == launchedAt);
+        }
+    };
+}
@@ -0,0 +1,13 @@
+//{{NO_DEPENDENCIES}}
+// Microsoft Visual C++ generated include file.
+// Used by UnitTests-Workspaces.rc
+
+//////////////////////////////
+// Non-localizable
+
+#define FILE_DESCRIPTION "PowerToys UnitTests-Workspaces"
+#define INTERNAL_NAME "UnitTests-Workspaces"
+#define ORIGINAL_FILENAME "UnitTests-Workspaces.dll"
+
+// Non-localizable
+//////////////////////////////
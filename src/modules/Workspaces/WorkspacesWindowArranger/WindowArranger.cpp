@@ -6,6 +6,9 @@
 #include <common/utils/process_path.h>
 #include <common/utils/winapi_error.h>
 
+#include <numeric>
+
+#include <workspaces-common/AssignmentSolver.h>
 #include <workspaces-common/MonitorUtils.h>
 #include <workspaces-common/WindowEnumerator.h>
 #include <workspaces-common/WindowFilter.h>
@@ -151,152 +154,212 @@ bool WindowArranger::TryMoveWindow(const WorkspacesData::WorkspacesProject::Appl
     return success;
 }
 
-std::optional<WindowWithDistance> WindowArranger::GetNearestWindow(const WorkspacesData::WorkspacesProject::Application& app, const std::vector<HWND>& movedWindows, Utils::PwaHelper& pwaHelper)
+WindowAppData& WindowArranger::GetWindowApp(HWND window)
+{
+    DWORD pid{};
+    GetWindowThreadProcessId(window, &pid);
+
+    // handles can be reused by another process after the window is closed,
+    // and the process path of a window that has just been created may not be available yet
+    auto iter = m_windowApps.find(window);
+    if (iter != m_windowApps.end() && iter->second.pid == pid && !iter->second.processPath.empty())
+    {
+        return iter->second;
+    }
+
+    WindowAppData windowApp{ .pid = pid, .processPath = get_process_path(window) };
+    if (!windowApp.processPath.empty())
+    {
+        windowApp.app = Utils::Apps::GetApp(windowApp.processPath, pid, m_installedApps);
+    }
+
+    return m_windowApps.insert_or_assign(window, std::move(windowApp)).first->second;
+}
+
+const std::optional<Utils::Apps::AppData>& WindowArranger::GetWindowPwaApp(HWND window, WindowAppData& windowApp, Utils::PwaHelper& pwaHelper)
 {
-    std::optional<Utils::Apps::AppData> appDataNearest = std::nullopt;
-    WindowWithDistance nearestWindowWithDistance{};
+    if (windowApp.pwaResolved)
+    {
+        return windowApp.pwaApp;
+    }
+
+    windowApp.pwaResolved = true;
+    windowApp.pwaApp = windowApp.app;
+    if (!windowApp.pwaApp.has_value())
+    {
+        return windowApp.pwaApp;
+    }
 
-    for (HWND window : m_windowsBefore)
+    auto& appData = windowApp.pwaApp.value();
+
+    // PWA apps
+    bool isEdge = appData.IsEdge();
+    bool isChrome = appData.IsChrome();
+    if (isEdge || isChrome)
     {
-        if (std::find(movedWindows.begin(), movedWindows.end(), window) != movedWindows.end())
+        auto windowAumid = pwaHelper.GetAUMIDFromWindow(window);
+        std::optional<std::wstring> pwaAppId{};
+
+        if (isEdge)
         {
-            continue;
+            pwaAppId = pwaHelper.GetEdgeAppId(windowAumid);
+        }
+        else if (isChrome)
+        {
+            pwaAppId = pwaHelper.GetChromeAppId(windowAumid);
         }
 
-        std::wstring processPath = get_process_path(window);
-        if (processPath.empty())
+        if (pwaAppId.has_value())
         {
-            continue;
+            auto pwaName = pwaHelper.SearchPwaName(pwaAppId.value(), windowAumid);
+            Logger::info(L"Found {} PWA app with name {}, appId: {}", (isEdge ? L"Edge" : (isChrome ? L"Chrome" : L"unknown")), pwaName, pwaAppId.value());
+
+            appData.pwaAppId = pwaAppId.value();
+            appData.name = pwaName + L" (" + appData.name + L")";
         }
+    }
+
+    return windowApp.pwaApp;
+}
 
-        DWORD pid{};
-        GetWindowThreadProcessId(window, &pid);
+std::vector<WindowAssignment> WindowArranger::AssignExistingWindows(Utils::PwaHelper& pwaHelper)
+{
+    const auto& apps = m_project.apps;
 
-        auto data = Utils::Apps::GetApp(processPath, pid, m_installedApps);
+    // windows that could belong to each app
+    std::vector<std::vector<size_t>> candidates(apps.size());
+    for (size_t windowIndex = 0; windowIndex < m_windowsBefore.size(); windowIndex++)
+    {
+        HWND window = m_windowsBefore[windowIndex];
+        auto& windowApp = GetWindowApp(window);
+        const auto& data = GetWindowPwaApp(window, windowApp, pwaHelper);
         if (!data.has_value())
         {
             continue;
         }
 
-        auto appData = data.value();
+        for (size_t appIndex = 0; appIndex < apps.size(); appIndex++)
+        {
+            const auto& app = apps[appIndex];
+            if ((app.name == data.value().name || app.path == data.value().installPath) && (app.pwaAppId == data.value().pwaAppId))
+            {
+                candidates[appIndex].push_back(windowIndex);
+            }
+        }
+    }
 
-        // PWA apps
-        bool isEdge = appData.IsEdge();
-        bool isChrome = appData.IsChrome();
-        if (isEdge || isChrome)
+    // apps competing for the same windows are assigned together, usually these are instances of one app
+    std::vector<size_t> groups(apps.size());
+    std::iota(groups.begin(), groups.end(), 0);
+    auto groupOf = [&](size_t appIndex) {
+        while (groups[appIndex] != appIndex)
         {
-            auto windowAumid = pwaHelper.GetAUMIDFromWindow(window);
-            std::optional<std::wstring> pwaAppId{};
+            appIndex = groups[appIndex] = groups[groups[appIndex]];
+        }
+        return appIndex;
+    };
 
-            if (isEdge)
+    std::vector<std::optional<size_t>> windowOwners(m_windowsBefore.size());
+    for (size_t appIndex = 0; appIndex < apps.size(); appIndex++)
+    {
+        for (size_t windowIndex : candidates[appIndex])
+        {
+            if (windowOwners[windowIndex].has_value())
             {
-                pwaAppId = pwaHelper.GetEdgeAppId(windowAumid);
+                groups[groupOf(appIndex)] = groupOf(windowOwners[windowIndex].value());
             }
-            else if (isChrome)
+            else
             {
-                pwaAppId = pwaHelper.GetChromeAppId(windowAumid);
+                windowOwners[windowIndex] = appIndex;
             }
+        }
+    }
 
-            if (pwaAppId.has_value())
-            {
-                auto pwaName = pwaHelper.SearchPwaName(pwaAppId.value(), windowAumid);
-                Logger::info(L"Found {} PWA app with name {}, appId: {}", (isEdge ? L"Edge" : (isChrome ? L"Chrome" : L"unknown")), pwaName, pwaAppId.value());
+    std::map<size_t, std::vector<size_t>> groupApps;
+    for (size_t appIndex = 0; appIndex < apps.size(); appIndex++)
+    {
+        if (!candidates[appIndex].empty())
+        {
+            groupApps[groupOf(appIndex)].push_back(appIndex);
+        }
+    }
 
-                appData.pwaAppId = pwaAppId.value();
-                appData.name = pwaName + L" (" + appData.name + L")";
-            }
+    // Matching all windows of a group at once gives the smallest total distance, while picking
+    // the nearest window app by app could leave another instance with a far away window
+    std::vector<WindowAssignment> result;
+    for (const auto& [group, groupAppIndexes] : groupApps)
+    {
+        std::vector<size_t> groupWindows;
+        for (size_t appIndex : groupAppIndexes)
+        {
+            groupWindows.insert(groupWindows.end(), candidates[appIndex].begin(), candidates[appIndex].end());
         }
 
-        if ((app.name == appData.name || app.path == appData.installPath) && (app.pwaAppId == appData.pwaAppId))
+        std::sort(groupWindows.begin(), groupWindows.end());
+        groupWindows.erase(std::unique(groupWindows.begin(), groupWindows.end()), groupWindows.end());
+
+        std::vector<std::vector<int64_t>> costs(groupAppIndexes.size(), std::vector<int64_t>(groupWindows.size(), AssignmentSolver::Forbidden));
+        for (size_t row = 0; row < groupAppIndexes.size(); row++)
         {
-            if (!appDataNearest.has_value())
+            const auto& app = apps[groupAppIndexes[row]];
+            for (size_t windowIndex : candidates[groupAppIndexes[row]])
             {
-                appDataNearest = data;
-                nearestWindowWithDistance.distance = PlacementHelper::CalculateDistance(app, window);
-                nearestWindowWithDistance.window = window;
+                size_t col = std::lower_bound(groupWindows.begin(), groupWindows.end(), windowIndex) - groupWindows.begin();
+                costs[row][col] = PlacementHelper::CalculateDistance(app, m_windowsBefore[windowIndex]);
             }
-            else
+        }
+
+        auto assignment = AssignmentSolver::Solve(costs);
+        for (size_t row = 0; row < assignment.size(); row++)
+        {
+            if (assignment[row] >= 0)
             {
-                int currentDistance = PlacementHelper::CalculateDistance(app, window);
-                if (currentDistance < nearestWindowWithDistance.distance)
-                {
-                    appDataNearest = data;
-                    nearestWindowWithDistance.distance = currentDistance;
-                    nearestWindowWithDistance.window = window;
-                }
+                result.push_back(WindowAssignment{
+                    .app = groupAppIndexes[row],
+                    .window = m_windowsBefore[groupWindows[assignment[row]]],
+                    .distance = static_cast<int>(costs[row][assignment[row]]),
+                });
             }
         }
     }
 
-    if (appDataNearest.has_value())
-    {
-        return nearestWindowWithDistance;
-    }
-
-    return std::nullopt;
+    // the closest windows are moved first, as before
+    std::stable_sort(result.begin(), result.end(), [](const WindowAssignment& lhs, const WindowAssignment& rhs) { return lhs.distance < rhs.distance; });
+    return result;
 }
+
 WindowArranger::WindowArranger(WorkspacesData::WorkspacesProject project) :
     m_project(project),
     m_windowsBefore(WindowEnumerator::Enumerate(WindowFilter::Filter)),
     m_monitors(MonitorUtils::IdentifyMonitors()),
     m_installedApps(Utils::Apps::GetAppsList()),
+    m_windowCreationHandler(std::bind(&WindowArranger::onWindowCreated, this, std::placeholders::_1)),
     m_ipcHelper(IPCHelperStrings::WindowArrangerPipeName, IPCHelperStrings::LauncherArrangerPipeName, std::bind(&WindowArranger::receiveIpcMessage, this, std::placeholders::_1)),
     m_launchingStatus(m_project)
 {
     if (project.moveExistingWindows)
     {
         Logger::info(L"Moving existing windows");
-        bool isMovePhase = true;
-        bool movedAny = false;
-        std::vector<HWND> movedWindows;
-        std::vector<WorkspacesData::WorkspacesProject::Application> movedApps;
         Utils::PwaHelper pwaHelper{};
+        auto assignments = AssignExistingWindows(pwaHelper);
 
-        while (isMovePhase)
+        // move the apps which are set to "Move-If-Exists" and are already present (launched, running)
+        std::vector<bool> assignedApps(m_project.apps.size());
+        for (const auto& assignment : assignments)
         {
-            isMovePhase = false;
-            int minDistance = INT_MAX;
-            WorkspacesData::WorkspacesProject::Application appToMove;
-            HWND windowToMove = NULL;
-            for (auto& app : project.apps)
-            {
-                // move the apps which are set to "Move-If-Exists" and are already present (launched, running)
-                if (std::find(movedApps.begin(), movedApps.end(), app) != movedApps.end())
-                {
-                    continue;
-                }
-
-                std::optional<WindowWithDistance> nearestWindowWithDistance;
-                nearestWindowWithDistance = GetNearestWindow(app, movedWindows, pwaHelper);
-                if (nearestWindowWithDistance.has_value())
-                {
-                    if (nearestWindowWithDistance.value().distance < minDistance)
-                    {
-                        minDistance = nearestWindowWithDistance.value().distance;
-                        appToMove = app;
-                        windowToMove = nearestWindowWithDistance.value().window;
-                    }
-                }
-                else
-                {
-                    Logger::info(L"The app {} is not found at launch, cannot be moved, has to be started", app.name);
-                    movedApps.push_back(app);
-                }
-            }
-            if (minDistance < INT_MAX)
+            assignedApps[assignment.app] = true;
+            TryMoveWindow(m_project.apps[assignment.app], assignment.window);
+        }
+
+        for (size_t appIndex = 0; appIndex < m_project.apps.size(); appIndex++)
+        {
+            if (!assignedApps[appIndex])
             {
-                isMovePhase = true;
-                movedAny = true;
-                bool success = TryMoveWindow(appToMove, windowToMove);
-                movedApps.push_back(appToMove);
-                if (success)
-                {
-                    movedWindows.push_back(windowToMove);
-                }
+                Logger::info(L"The app {} is not found at launch, cannot be moved, has to be started", m_project.apps[appIndex].name);
             }
         }
 
-        if (movedAny)
+        if (!assignments.empty())
         {
             // Wait if there were moved windows. This message might not arrive if sending immediately after the last "moved" message (status update)
             std::this_thread::sleep_for(std::chrono::milliseconds(100));
@@ -307,22 +370,28 @@ WindowArranger::WindowArranger(WorkspacesData::WorkspacesProject project) :
 
     m_ipcHelper.send(L"ready");
 
-    const long maxLaunchingWaitingTime = 10000, maxRepositionWaitingTime = 3000, ms = 300;
-    long waitingTime{ 0 };
+    // windows are also checked periodically, as an app may resize its window without any event
+    const auto maxLaunchingWaitingTime = std::chrono::milliseconds(10000), maxRepositionWaitingTime = std::chrono::milliseconds(3000), ms = std::chrono::milliseconds(300);
 
     // process launching windows
-    while (!m_launchingStatus.AllLaunched() && waitingTime < maxLaunchingWaitingTime)
+    auto lastProcessedTime = std::chrono::steady_clock::now();
+    bool timeoutExpired = false;
+    while (!m_launchingStatus.AllLaunched())
     {
         if (processWindows(false))
         {
-            waitingTime = 0;
+            lastProcessedTime = std::chrono::steady_clock::now();
+        }
+        else if (std::chrono::steady_clock::now() - lastProcessedTime >= maxLaunchingWaitingTime)
+        {
+            timeoutExpired = true;
+            break;
         }
 
-        std::this_thread::sleep_for(std::chrono::milliseconds(ms));
-        waitingTime += ms;
+        waitForEvents(ms);
     }
 
-    if (waitingTime >= maxLaunchingWaitingTime)
+    if (timeoutExpired)
     {
         Logger::info(L"Launching timeout expired");
     }
@@ -330,20 +399,65 @@ WindowArranger::WindowArranger(WorkspacesData::WorkspacesProject project) :
     Logger::info(L"Finished moving new windows");
 
     // wait for 3 seconds after all apps launched
-    waitingTime = 0;
-    while (!m_launchingStatus.AllLaunchedAndMoved() && waitingTime < maxRepositionWaitingTime)
+    const auto repositionStartTime = std::chrono::steady_clock::now();
+    timeoutExpired = false;
+    while (!m_launchingStatus.AllLaunchedAndMoved())
     {
         processWindows(true);
-        std::this_thread::sleep_for(std::chrono::milliseconds(ms));
-        waitingTime += ms;
+        if (std::chrono::steady_clock::now() - repositionStartTime >= maxRepositionWaitingTime)
+        {
+            timeoutExpired = true;
+            break;
+        }
+
+        waitForEvents(ms);
     }
 
-    if (waitingTime >= maxRepositionWaitingTime)
+    if (timeoutExpired)
     {
         Logger::info(L"Repositioning timeout expired");
     }
 }
 
+void WindowArranger::onWindowCreated(HWND window)
+{
+    if (GetAncestor(window, GA_ROOT) == window)
+    {
+        m_windowEventPending = true;
+    }
+}
+
+void WindowArranger::waitForEvents(std::chrono::milliseconds timeout)
+{
+    // win event hooks are called back on this thread while it pumps messages
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    m_windowEventPending = false;
+    while (!m_windowEventPending)
+    {
+        auto now = std::chrono::steady_clock::now();
+        if (now >= deadline)
+        {
+            return;
+        }
+
+        HANDLE events[] = { m_launchStatusEvent.get() };
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now);
+        DWORD result = MsgWaitForMultipleObjects(1, events, FALSE, static_cast<DWORD>(remaining.count()), QS_ALLINPUT);
+        if (result != WAIT_OBJECT_0 + 1)
+        {
+            // status update, timeout or failure
+            return;
+        }
+
+        MSG msg;
+        while (PeekMessageW(&msg, nullptr, 0, 0, PM_REMOVE))
+        {
+            TranslateMessage(&msg);
+            DispatchMessageW(&msg);
+        }
+    }
+}
+
 bool WindowArranger::processWindows(bool processAll)
 {
     bool processedAnyWindow = false;
@@ -377,16 +491,9 @@ bool WindowArranger::processWindow(HWND window)
         return false;
     }
 
-    std::wstring processPath = get_process_path(window);
-    if (processPath.empty())
-    {
-        return false;
-    }
-
-    DWORD pid{};
-    GetWindowThreadProcessId(window, &pid);
-
-    auto data = Utils::Apps::GetApp(processPath, pid, m_installedApps);
+    const auto& windowApp = GetWindowApp(window);
+    const auto& processPath = windowApp.processPath;
+    const auto& data = windowApp.app;
     if (!data.has_value())
     {
         return false;
@@ -461,7 +568,7 @@ bool WindowArranger::moveWindow(HWND window, const WorkspacesData::WorkspacesPro
     {
         WorkspacesWindowProperties::StampWorkspacesLaunchedProperty(window);
         WorkspacesWindowProperties::StampWorkspacesGuidProperty(window, app.id);
-        Logger::trace(L"Placed {} to ({},{}) [{}x{}]", app.name, rect.left, rect.top, rect.right - rect.left, rect.bottom - rect.top);
+        LOG_TRACE(L"Placed {} to ({},{}) [{}x{}]", app.name, rect.left, rect.top, rect.right - rect.left, rect.bottom - rect.top);
         return true;
     }
     else
@@ -479,6 +586,7 @@ void WindowArranger::receiveIpcMessage(const std::wstring& message)
         if (data.has_value())
         {
             m_launchingStatus.Update(data.value().application, data.value().state);
+            m_launchStatusEvent.SetEvent();
         }
         else
         {
@@ -1,5 +1,9 @@
 #pragma once
 
+#include <map>
+
+#include <wil/resource.h>
+
 #include <WindowCreationHandler.h>
 
 #include <WorkspacesLib/AppUtils.h>
@@ -8,10 +12,24 @@
 #include <WorkspacesLib/PwaHelper.h>
 #include <WorkspacesLib/WorkspacesData.h>
 
-struct WindowWithDistance
+// An existing window matched to an app of the project
+struct WindowAssignment
 {
-    int distance;
+    size_t app; // index in the project apps
     HWND window;
+    int distance;
+};
+
+// The app a window belongs to, looked up once per launch
+struct WindowAppData
+{
+    DWORD pid{};
+    std::wstring processPath;
+    std::optional<Utils::Apps::AppData> app;
+
+    // app with the PWA name and id filled in, resolved on first use
+    std::optional<Utils::Apps::AppData> pwaApp;
+    bool pwaResolved{};
 };
 
 class WindowArranger
@@ -25,13 +43,22 @@ private:
     const std::vector<HWND> m_windowsBefore;
     const std::vector<WorkspacesData::WorkspacesProject::Monitor> m_monitors;
     const Utils::Apps::AppList m_installedApps;
-    //const WindowCreationHandler m_windowCreationHandler;
+    std::map<HWND, WindowAppData> m_windowApps;
+
+    // The arranging loops wake up when a window appears or the launcher reports a launched app
+    const WindowCreationHandler m_windowCreationHandler;
+    bool m_windowEventPending{};
+    wil::unique_event m_launchStatusEvent{ wil::EventOptions::None };
+
     IPCHelper m_ipcHelper;
     LaunchingStatus m_launchingStatus;
-    std::optional<WindowWithDistance> GetNearestWindow(const WorkspacesData::WorkspacesProject::Application& app, const std::vector<HWND>& movedWindows, Utils::PwaHelper& pwaHelper);
+    std::vector<WindowAssignment> AssignExistingWindows(Utils::PwaHelper& pwaHelper);
+    WindowAppData& GetWindowApp(HWND window);
+    const std::optional<Utils::Apps::AppData>& GetWindowPwaApp(HWND window, WindowAppData& windowApp, Utils::PwaHelper& pwaHelper);
     bool TryMoveWindow(const WorkspacesData::WorkspacesProject::Application& app, HWND windowToMove);
 
-    //void onWindowCreated(HWND window);
+    void onWindowCreated(HWND window);
+    void waitForEvents(std::chrono::milliseconds timeout);
     bool processWindows(bool processAll);
     bool processWindow(HWND window);
     bool moveWindow(HWND window, const WorkspacesData::WorkspacesProject::Application& app);
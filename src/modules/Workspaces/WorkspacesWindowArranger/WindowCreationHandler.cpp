@@ -43,8 +43,8 @@ void WindowCreationHandler::HandleWinHookEvent(DWORD event, HWND window) noexcep
 {
     switch (event)
     {
-    //case EVENT_OBJECT_UNCLOAKED:
-    //case EVENT_OBJECT_SHOW:
+    case EVENT_OBJECT_UNCLOAKED:
+    case EVENT_OBJECT_SHOW:
     case EVENT_OBJECT_CREATE:
     {
         if (m_windowCreatedCallback)
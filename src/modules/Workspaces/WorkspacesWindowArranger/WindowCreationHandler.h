@@ -22,7 +22,7 @@ private:
                                      DWORD eventThread,
                                      DWORD eventTime)
     {
-        if (s_instance)
+        if (s_instance && object == OBJID_WINDOW && child == CHILDID_SELF)
         {
             s_instance->HandleWinHookEvent(event, window);
         }
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace AssignmentSolver
+{
+    // Cost of the pairs that must not be matched
+    constexpr int64_t Forbidden = (std::numeric_limits<int64_t>::max)();
+
+    // Matches rows to columns so that as many pairs as possible are matched, and among those
+    // assignments the total cost is minimal (Hungarian algorithm, O(n^2 * m) for n <= m).
+    // Returns the column matched to each row, or -1 if the row is left unmatched.
+    inline std::vector<int> Solve(const std::vector<std::vector<int64_t>>& costs)
+    {
+        const size_t rows = costs.size();
+        const size_t cols = rows > 0 ? costs[0].size() : 0;
+        std::vector<int> result(rows, -1);
+        if (rows == 0 || cols == 0)
+        {
+            return result;
+        }
+
+        // Forbidden pairs cost more than any assignment of allowed pairs, so they are only
+        // used to fill up the matching and dropped afterwards
+        int64_t forbiddenCost = 1;
+        for (const auto& row : costs)
+        {
+            for (int64_t cost : row)
+            {
+                if (cost != Forbidden)
+                {
+                    forbiddenCost += cost;
+                }
+            }
+        }
+
+        // the algorithm below needs rows <= cols, so the matrix is transposed if needed
+        const bool transposed = rows > cols;
+        const size_t n = transposed ? cols : rows;
+        const size_t m = transposed ? rows : cols;
+        auto cost = [&](size_t i, size_t j) {
+            int64_t value = transposed ? costs[j][i] : costs[i][j];
+            return value == Forbidden ? forbiddenCost : value;
+        };
+
+        // potentials and matching use 1-based indices, index 0 is a sentinel
+        const int64_t infinity = (std::numeric_limits<int64_t>::max)() / 4;
+        std::vector<int64_t> u(n + 1), v(m + 1);
+        std::vector<size_t> matchedRow(m + 1), way(m + 1);
+        for (size_t i = 1; i <= n; i++)
+        {
+            matchedRow[0] = i;
+            size_t j0 = 0;
+            std::vector<int64_t> minDelta(m + 1, infinity);
+            std::vector<bool> used(m + 1, false);
+            do
+            {
+                used[j0] = true;
+                size_t i0 = matchedRow[j0];
+                int64_t delta = infinity;
+                size_t j1 = 0;
+                for (size_t j = 1; j <= m; j++)
+                {
+                    if (!used[j])
+                    {
+                        int64_t current = cost(i0 - 1, j - 1) - u[i0] - v[j];
+                        if (current < minDelta[j])
+                        {
+                            minDelta[j] = current;
+                            way[j] = j0;
+                        }
+
+                        if (minDelta[j] < delta)
+                        {
+                            delta = minDelta[j];
+                            j1 = j;
+                        }
+                    }
+                }
+
+                for (size_t j = 0; j <= m; j++)
+                {
+                    if (used[j])
+                    {
+                        u[matchedRow[j]] += delta;
+                        v[j] -= delta;
+                    }
+                    else
+                    {
+                        minDelta[j] -= delta;
+                    }
+                }
+
+                j0 = j1;
+            } while (matchedRow[j0] != 0);
+
+            do
+            {
+                size_t j1 = way[j0];
+                matchedRow[j0] = matchedRow[j1];
+                j0 = j1;
+            } while (j0 != 0);
+        }
+
+        for (size_t j = 1; j <= m; j++)
+        {
+            if (matchedRow[j] == 0)
+            {
+                continue;
+            }
+
+            size_t row = transposed ? j - 1 : matchedRow[j] - 1;
+            size_t col = transposed ? matchedRow[j] - 1 : j - 1;
+            if (costs[row][col] != Forbidden)
+            {
+                result[row] = static_cast<int>(col);
+            }
+        }
+
+        return result;
+    }
+}
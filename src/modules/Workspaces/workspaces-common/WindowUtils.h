@@ -75,15 +75,15 @@ namespace WindowUtils
             return true;
         }
 
-        static std::vector<std::wstring> defaultExcludedApps = { 
-            NonLocalizable::CoreWindow, 
-            NonLocalizable::SearchUI, 
+        static const ExcludedAppsMatcher defaultExcludedApps{ {
+            NonLocalizable::CoreWindow,
+            NonLocalizable::SearchUI,
             NonLocalizable::HelpWindow,
-            NonLocalizable::WorkspacesEditor, 
+            NonLocalizable::WorkspacesEditor,
             NonLocalizable::WorkspacesLauncher,
             NonLocalizable::WorkspacesWindowArranger,
-            NonLocalizable::WorkspacesSnapshotTool, 
-        };
+            NonLocalizable::WorkspacesSnapshotTool,
+        } };
         return (check_excluded_app(window, processPathUpper, defaultExcludedApps));
     }
 
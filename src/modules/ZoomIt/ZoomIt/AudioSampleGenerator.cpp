@@ -21,8 +21,6 @@ namespace winrt
 
 AudioSampleGenerator::AudioSampleGenerator()
 {
-    m_audioEvent.create(wil::EventOptions::ManualReset);
-    m_endEvent.create(wil::EventOptions::ManualReset);
     m_asyncInitialized.create(wil::EventOptions::ManualReset);
 }
 
@@ -88,45 +86,13 @@ std::optional<winrt::MediaStreamSample> AudioSampleGenerator::TryGetNextSample()
     CheckInitialized();
     CheckStarted();
 
-    {
-        auto lock = m_lock.lock_exclusive();
-        if (m_samples.empty() && m_endEvent.is_signaled())
-        {
-            return std::nullopt;
-        }
-        else if (!m_samples.empty())
-        {
-            std::optional result(m_samples.front());
-            m_samples.pop_front();
-            return result;
-        }
-    }
-
-    m_audioEvent.ResetEvent();
-    std::vector<HANDLE> events = { m_endEvent.get(), m_audioEvent.get() };
-    auto waitResult = WaitForMultipleObjectsEx(static_cast<DWORD>(events.size()), events.data(), false, INFINITE, false);
-    auto eventIndex = -1;
-    switch (waitResult)
-    {
-    case WAIT_OBJECT_0:
-    case WAIT_OBJECT_0 + 1:
-        eventIndex = waitResult - WAIT_OBJECT_0;
-        break;
-    }
-    WINRT_VERIFY(eventIndex >= 0);
-
-    auto signaledEvent = events[eventIndex];
-    if (signaledEvent == m_endEvent.get())
+    // Blocks until audio arrives or the generator is stopped
+    auto entry = m_samples.Pop();
+    if (!entry)
     {
         return std::nullopt;
     }
-    else
-    {
-        auto lock = m_lock.lock_exclusive();
-        std::optional result(m_samples.front());
-        m_samples.pop_front();
-        return result;
-    }
+    return std::optional(entry->sample);
 }
 
 void AudioSampleGenerator::Start()
@@ -146,23 +112,18 @@ void AudioSampleGenerator::Stop()
     {
         m_asyncInitialized.wait();
         m_audioGraph.Stop();
-        m_endEvent.SetEvent();
+        m_samples.Close();
     }
 }
 
 void AudioSampleGenerator::OnAudioQuantumStarted(winrt::AudioGraph const& sender, winrt::IInspectable const& args)
 {
-    {
-        auto lock = m_lock.lock_exclusive();
-
-        auto frame = m_audioOutputNode.GetFrame();
-        std::optional<winrt::TimeSpan> timestamp = frame.RelativeTime();
-        auto audioBuffer = frame.LockBuffer(winrt::AudioBufferAccessMode::Read);
-
-        auto sampleBuffer = winrt::Buffer::CreateCopyFromMemoryBuffer(audioBuffer);
-        sampleBuffer.Length(audioBuffer.Length());
-        auto sample = winrt::MediaStreamSample::CreateFromBuffer(sampleBuffer, timestamp.value());
-        m_samples.push_back(sample);
-    }
-    m_audioEvent.SetEvent();
+    auto frame = m_audioOutputNode.GetFrame();
+    std::optional<winrt::TimeSpan> timestamp = frame.RelativeTime();
+    auto audioBuffer = frame.LockBuffer(winrt::AudioBufferAccessMode::Read);
+
+    auto sampleBuffer = winrt::Buffer::CreateCopyFromMemoryBuffer(audioBuffer);
+    sampleBuffer.Length(audioBuffer.Length());
+    auto sample = winrt::MediaStreamSample::CreateFromBuffer(sampleBuffer, timestamp.value());
+    m_samples.Push(sample, timestamp.value().count());
 }
@@ -1,5 +1,12 @@
 #pragma once
 
+#include "RecordingPipeline.h"
+
+// Audio quanta are 10ms, so this holds about a second of audio. If the
+// encoder falls further behind, the oldest audio is dropped rather than
+// growing the queue for the rest of the recording.
+constexpr size_t c_audioSampleQueueDepth = 100;
+
 class AudioSampleGenerator
 {
 public:
@@ -12,6 +19,7 @@ public:
     std::optional<winrt::Windows::Media::Core::MediaStreamSample> TryGetNextSample();
     void Start();
     void Stop();
+    RecordingPipeline::QueueStats GetStats() const { return m_samples.Stats(); }
 
 private:
     void OnAudioQuantumStarted(
@@ -38,11 +46,9 @@ private:
     winrt::Windows::Media::Audio::AudioGraph m_audioGraph{ nullptr };
     winrt::Windows::Media::Audio::AudioDeviceInputNode m_audioInputNode{ nullptr };
     winrt::Windows::Media::Audio::AudioFrameOutputNode m_audioOutputNode{ nullptr };
-    wil::srwlock m_lock;
-    wil::unique_event m_audioEvent;
-    wil::unique_event m_endEvent;
     wil::unique_event m_asyncInitialized;
-    std::deque<winrt::Windows::Media::Core::MediaStreamSample> m_samples;
+    RecordingPipeline::SampleQueue<winrt::Windows::Media::Core::MediaStreamSample> m_samples{ c_audioSampleQueueDepth,
+                                                                                             RecordingPipeline::DropPolicy::DropOldest };
     std::atomic<bool> m_initialized = false;
     std::atomic<bool> m_started = false;
 };
\ No newline at end of file
@@ -33,19 +33,21 @@ namespace util
 CaptureFrameWait::CaptureFrameWait(
     winrt::IDirect3DDevice const& device,
     winrt::GraphicsCaptureItem const& item,
-    winrt::SizeInt32 const& size)
+    winrt::SizeInt32 const& size,
+    uint32_t frameRate) :
+    m_frameRateLimiter(frameRate)
 {
     m_device = device;
     m_item = item;
 
-    m_nextFrameEvent = wil::shared_event(wil::EventOptions::ManualReset);
     m_endEvent = wil::shared_event(wil::EventOptions::ManualReset);
     m_closedEvent = wil::shared_event(wil::EventOptions::ManualReset);
 
+    // Each queued frame, the one the encoder is reading and the one being captured
     m_framePool = winrt::Direct3D11CaptureFramePool::CreateFreeThreaded(
         m_device,
         winrt::DirectXPixelFormat::B8G8R8A8UIntNormalized,
-        1,
+        static_cast<int32_t>(RecordingPipeline::FramePoolSize(c_captureFrameQueueDepth)),
         size);
     m_session = m_framePool.CreateCaptureSession(m_item);
 
@@ -63,13 +65,18 @@ CaptureFrameWait::~CaptureFrameWait()
     StopCapture();
     // We might end the capture before we ever get another frame.
     m_closedEvent.wait(200);
+
+    while (auto queued = m_frames.TryPop())
+    {
+        queued->sample.Frame.Close();
+    }
 }
 
 //----------------------------------------------------------------------------
 //
 // CaptureFrameWait::TryGetNextFrame
 //
-// Fetches next available frame
+// Fetches the oldest queued frame, waiting for one if necessary
 //
 //----------------------------------------------------------------------------
 std::optional<CaptureFrame> CaptureFrameWait::TryGetNextFrame()
@@ -77,32 +84,22 @@ std::optional<CaptureFrame> CaptureFrameWait::TryGetNextFrame()
     if (m_currentFrame != nullptr)
     {
         m_currentFrame.Close();
+        m_currentFrame = nullptr;
     }
-    m_nextFrameEvent.ResetEvent();
 
-    std::vector<HANDLE> events = { m_endEvent.get(), m_nextFrameEvent.get() };
-    auto waitResult = WaitForMultipleObjectsEx(static_cast<DWORD>(events.size()), events.data(), false, INFINITE, false);
-    auto eventIndex = -1;
-    switch (waitResult)
-    {
-    case WAIT_OBJECT_0:
-    case WAIT_OBJECT_0 + 1:
-        eventIndex = waitResult - WAIT_OBJECT_0;
-        break;
-    }
-    WINRT_VERIFY(eventIndex >= 0);
-
-    auto signaledEvent = events[eventIndex];
-    if (signaledEvent == m_endEvent.get())
+    auto queued = m_frames.Pop();
+    if (!queued)
     {
         return std::nullopt;
     }
+    m_currentFrame = queued->sample.Frame;
 
     return std::optional<CaptureFrame>(
         {
             m_currentFrame.Surface(),
             m_currentFrame.ContentSize(),
             m_currentFrame.SystemRelativeTime(),
+            queued->sample.ArrivalTime,
         });
 }
 
@@ -118,6 +115,7 @@ void CaptureFrameWait::StopCapture()
 {
     auto lock = m_lock.lock_exclusive();
     m_endEvent.SetEvent();
+    m_frames.Close();
     m_framePool.Close();
     m_session.Close();
 }
@@ -141,7 +139,37 @@ void CaptureFrameWait::OnFrameArrived(
     }
     auto frame = sender.TryGetNextFrame();
     if( frame ) {
-        m_currentFrame = frame;
-        m_nextFrameEvent.SetEvent();
+        m_framesCaptured++;
+
+        // Capture runs at the display refresh rate; only keep the frames
+        // the encoder is going to use
+        auto timestamp = frame.SystemRelativeTime().count();
+        if( !m_frameRateLimiter.Accept( timestamp ) )
+        {
+            m_framesDroppedByPacing++;
+            frame.Close();
+            return;
+        }
+
+        auto dropped = m_frames.Push( { frame, std::chrono::steady_clock::now() }, timestamp );
+        if( dropped )
+        {
+            dropped->sample.Frame.Close();
+        }
     }
 }
+
+//----------------------------------------------------------------------------
+//
+// CaptureFrameWait::GetStats
+//
+//----------------------------------------------------------------------------
+void CaptureFrameWait::GetStats( RecordingPipeline::RecordingStats& stats ) const
+{
+    auto queueStats = m_frames.Stats();
+    stats.framesCaptured = m_framesCaptured;
+    stats.framesDroppedByPacing = m_framesDroppedByPacing;
+    stats.framesDroppedByQueue = queueStats.dropped;
+    stats.frameQueueDepth = queueStats.depth;
+    stats.maxFrameQueueDepth = queueStats.maxDepth;
+}
@@ -58,6 +58,8 @@
 #include <mutex>
 #include <deque>
 
+#include "RecordingPipeline.h"
+
 // robmikh.common
 #include <robmikh.common/composition.interop.h>
 #include <robmikh.common/direct3d11.interop.h>
@@ -95,19 +97,34 @@ struct CaptureFrame
     winrt::Direct3D11::IDirect3DSurface FrameTexture;
     winrt::SizeInt32 ContentSize;
     winrt::TimeSpan SystemRelativeTime;
+
+    // When the frame was handed to us by the capture session, used to
+    // measure how long frames wait before they reach the encoder
+    std::chrono::steady_clock::time_point ArrivalTime;
 };
 
+//
+// Capture frames that passed pacing and are waiting for the encoder. The
+// frame pool has a buffer for the frame the encoder holds and one for the
+// frame being captured on top of the queue, so capture never stalls on the
+// encoder; when the encoder falls behind the oldest queued frame is dropped
+// and returned to the pool.
+//
+constexpr size_t c_captureFrameQueueDepth = 3;
+
 class CaptureFrameWait
 {
 public:
     CaptureFrameWait(
         winrt::Direct3D11::IDirect3DDevice const& device,
         winrt::GraphicsCaptureItem const& item,
-        winrt::SizeInt32 const& size );
+        winrt::SizeInt32 const& size,
+        uint32_t frameRate );
     ~CaptureFrameWait();
 
     std::optional<CaptureFrame> TryGetNextFrame();
     void StopCapture();
+    void GetStats( RecordingPipeline::RecordingStats& stats ) const;
     void EnableCursorCapture( bool enable = true )
     {
         if( winrt::ApiInformation::IsPropertyPresent( winrt::name_of<decltype(m_session)>(), L"IsCursorCaptureEnabled" ) )
@@ -128,15 +145,26 @@ private:
         winrt::Direct3D11CaptureFramePool const& sender,
         winrt::IInspectable const& args );
 
+    struct QueuedFrame
+    {
+        winrt::Direct3D11CaptureFrame Frame{ nullptr };
+        std::chrono::steady_clock::time_point ArrivalTime;
+    };
+
 private:
     winrt::Direct3D11::IDirect3DDevice m_device{ nullptr };
     winrt::GraphicsCaptureItem m_item{ nullptr };
     winrt::Direct3D11CaptureFramePool m_framePool{ nullptr };
     winrt::GraphicsCaptureSession m_session{ nullptr };
-    wil::shared_event m_nextFrameEvent;
     wil::shared_event m_endEvent;
     wil::shared_event m_closedEvent;
     wil::srwlock m_lock;
 
+    RecordingPipeline::SampleQueue<QueuedFrame> m_frames{ c_captureFrameQueueDepth,
+                                                          RecordingPipeline::DropPolicy::DropOldest };
+    RecordingPipeline::FrameRateLimiter m_frameRateLimiter;
+    std::atomic<uint64_t> m_framesCaptured = 0;
+    std::atomic<uint64_t> m_framesDroppedByPacing = 0;
+
     winrt::Direct3D11CaptureFrame m_currentFrame{ nullptr };
 };
\ No newline at end of file
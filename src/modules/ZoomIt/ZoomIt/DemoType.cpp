@@ -12,18 +12,21 @@
 
 #include "pch.h"
 #include "DemoType.h"
+#include "DemoTypeScript.h"
 
 #define MAX_INDENT_DEPTH    100
 
 #define INDENT_SEEK_FLAG    L"x"
 
-#define END_CONTROL_LEN     5
-// Longest accepted control: [pause:000]
-#define MAX_CONTROL_LEN     11
-
 #define THIRD_TYPING_SPEED  static_cast<int>((MIN_TYPING_SPEED - MAX_TYPING_SPEED) / 3)
 #define TYPING_VARIANCE     ((float) 1.0)
 
+// Characters whose typing delays add up to less than a scheduler tick are
+// sent with a single SendInput, since sleeping for less than a tick isn't
+// possible anyway
+#define TYPING_BATCH_TICK   16   // ms
+#define MAX_TYPING_BATCH    32
+
 #define NOTEPAD_REFRESH     1    // ms
 #define DEMOTYPE_REFRESH    50   // ms
 #define CLIPBOARD_REFRESH   100  // ms
@@ -64,6 +67,7 @@ HHOOK                   g_hHook = nullptr;
 size_t                  g_TextLen = 0;
 wchar_t*                g_ClipboardCache = nullptr;
 std::wstring            g_Text = L"";
+DemoTypeScript::Plan    g_Plan;
 std::vector<size_t>     g_TextSegments;
 std::wstring            g_BaselineIndentation = L"";
 std::atomic<size_t>     g_Index = 0;
@@ -130,29 +134,6 @@ bool IsInjected( const DWORD vkCode, const DWORD scanCode )
     return injected;
 }
 
-//----------------------------------------------------------------------------
-//
-// IsAutoFormatTrigger
-//
-//----------------------------------------------------------------------------
-bool IsAutoFormatTrigger( wchar_t lastCh, wchar_t ch )
-{
-    // Will trigger auto-indentation in smart editors
-    //     '\t' check also handles possible auto-completion
-    if( ch == L'\n' || ch == L'\t' || (ch == L' ' && lastCh == L'\n') )
-    {
-        return true;
-    }
-
-    // Will trigger auto-close character(s) in smart editors
-    if( ch == L'{' || ch == L'[' || ch == L'(' || (ch == L'*' && lastCh == L'/') )
-    {
-        return true;
-    }
-
-    return false;
-}
-
 //----------------------------------------------------------------------------
 //
 // PopInjection
@@ -201,16 +182,6 @@ void PushInjection( const WORD vK, const wchar_t ch )
     }
 }
 
-//----------------------------------------------------------------------------
-//
-// IsNotPrintable
-//
-//----------------------------------------------------------------------------
-bool IsNotPrintable( wchar_t ch )
-{
-    return ch != L'\n' && ch != L'\t' && !iswprint( ch );
-}
-
 //----------------------------------------------------------------------------
 //
 // SendKeyInput
@@ -297,6 +268,43 @@ void SendVirtualKeyUp( const WORD vK )
     SendKeyInput ( vK, NULL, true );
 }
 
+//----------------------------------------------------------------------------
+//
+// SendUnicodeText
+//
+// Sends the key down and up events of several characters with one
+// SendInput call
+//
+//----------------------------------------------------------------------------
+void SendUnicodeText( const std::wstring& text, const size_t start, const size_t count )
+{
+    // Notepad needs latency between keydown/up, so it gets one key at a time
+    if( g_Notepad )
+    {
+        for( size_t i = start; i < start + count; i++ )
+        {
+            SendUnicodeKeyDown( text[i] );
+            SendUnicodeKeyUp  ( text[i] );
+        }
+        return;
+    }
+
+    std::vector<INPUT> inputs( count * 2 );
+    for( size_t i = 0; i < count; i++ )
+    {
+        const wchar_t ch = text[start + i];
+        PushInjection( NULL, ch );
+        PushInjection( NULL, ch );
+
+        inputs[i * 2].type = INPUT_KEYBOARD;
+        inputs[i * 2].ki.wScan = ch;
+        inputs[i * 2].ki.dwFlags = KEYEVENTF_UNICODE;
+        inputs[i * 2 + 1] = inputs[i * 2];
+        inputs[i * 2 + 1].ki.dwFlags |= KEYEVENTF_KEYUP;
+    }
+    SendInput( static_cast<UINT>(inputs.size()), inputs.data(), sizeof( INPUT ) );
+}
+
 //----------------------------------------------------------------------------
 //
 // GetRandomNumber
@@ -532,45 +540,15 @@ void GetBaselineIndentation()
 // Editors handle paste operations slowly so we use this method sparingly
 // 
 //----------------------------------------------------------------------------
-wchar_t InjectByClipboard( wchar_t lastCh, wchar_t ch, const std::wstring& override = L"" )
+void InjectByClipboard( const std::wstring& injection )
 {
-    int i = 0;
-    bool trim = false;
-    bool chunk = false;
-    std::wstring injection(1, ch);
     static const WORD VK_V = static_cast<WORD>(LOBYTE( VkKeyScan( L'v' ) ));
 
-    if( override == L"" )
-    {
-        if( ch == L'\n' && g_BaselineIndentation != L"" && g_BaselineIndentation != L"x" )
-        {
-            injection.append( g_BaselineIndentation );
-        }
-
-        // VS absorbs pasted line indentation so we inject it as a chunk of indents and the first printable ch
-        if( lastCh == L'\n' && (ch == L'\t' || ch == L' ') )
-        {
-            chunk = true;
-            for( i = 1; g_Index + i < g_TextLen; i++ )
-            {
-                injection.push_back( g_Text[g_Index + i] );
-                if( g_Text[g_Index + i] != L' ' && iswprint( g_Text[g_Index + i] ) )
-                {
-                    if( g_Text[g_Index + i] == L'[' )
-                    {
-                        trim = true;
-                    }
-                    break;
-                }
-            }
-        }
-    }
-
     std::this_thread::sleep_for( std::chrono::milliseconds( CLIPBOARD_REFRESH ) );
-    if( !SetClipboard( override == L"" ? injection.c_str() : override.c_str() ) )
+    if( !SetClipboard( injection.c_str() ) )
     {
         std::this_thread::sleep_for( std::chrono::milliseconds( CLIPBOARD_REFRESH ) );
-        SetClipboard( override == L"" ? injection.c_str() : override.c_str() );
+        SetClipboard( injection.c_str() );
     }
     std::this_thread::sleep_for( std::chrono::milliseconds( CLIPBOARD_REFRESH ) );
 
@@ -580,181 +558,116 @@ wchar_t InjectByClipboard( wchar_t lastCh, wchar_t ch, const std::wstring& overr
     SendVirtualKeyUp  ( VK_LCONTROL );
 
     std::this_thread::sleep_for( std::chrono::milliseconds( CLIPBOARD_REFRESH ) );
+}
 
-    // Trim the last character from our chunk if it was [
-    // Because it might be the start of a control keyword
-    if( trim )
-    {
-        SendVirtualKeyDown( VK_BACK );
-        SendVirtualKeyUp  ( VK_BACK );
-
-        g_Index += static_cast<unsigned long long>(i) - 1;
-        return g_Text[g_Index];
-    }
-    else if( chunk )
+//----------------------------------------------------------------------------
+//
+// InitInjection
+//
+//----------------------------------------------------------------------------
+void InitInjection()
+{
+    if( g_Index == 0 )
     {
-        g_Index += i;
-        return g_Text[g_Index];
+        g_TextSegments.clear();
     }
-    return NULL;
+
+    GetBaselineIndentation();
 }
 
 //----------------------------------------------------------------------------
 //
-// HandleControlKeyword
+// HandleInjection
+//
+// Injects the plan token at g_Index. Text runs inject up to maxChars
+// characters; returns the number of characters typed.
 //
 //----------------------------------------------------------------------------
-bool HandleControlKeyword()
+size_t HandleInjection( const size_t maxChars = 1 )
 {
-    size_t controlClose = g_Text.find( L']', g_Index );
-    size_t controlLen = controlClose - g_Index + 1;
+    const size_t tokenIndex = g_Plan.TokenAt( g_Index );
+    if( tokenIndex >= g_Plan.tokens.size() )
+    {
+        g_Index = g_TextLen;
+        return 0;
+    }
+    const DemoTypeScript::Token& token = g_Plan.tokens[tokenIndex];
+    const size_t tokenEnd = token.offset + token.length;
 
-    if( controlLen <= MAX_CONTROL_LEN )
+    switch( token.type )
     {
-        std::wstring control = g_Text.substr( g_Index, controlLen );
+    case DemoTypeScript::TokenType::Text:
+    {
+        const size_t start = g_Index - token.offset;
+        const size_t count = min( maxChars, token.length - start );
+        SendUnicodeText( token.text, start, count );
+        g_Index += count;
+        return count;
+    }
 
-        if( control == L"[end]" )
+    case DemoTypeScript::TokenType::AutoFormat:
+        if( token.newline && g_BaselineIndentation != L"" && g_BaselineIndentation != INDENT_SEEK_FLAG )
         {
-            g_End = true;
-            g_Index += controlLen;
-            g_TextSegments.push_back( g_Index );
-
-            // In standard mode, [end] is interpreted as an immediate kill signal
-            if( !g_UserDriven )
-            {
-                g_EmitterState = KILL_STATE;
-            }
-
-            return true;
+            InjectByClipboard( token.text + g_BaselineIndentation );
         }
-        else if( control.substr( 0, 7 ) == L"[pause:" )
+        else
         {
-            g_Index += controlLen;
-
-            if( g_UserDriven )
-            {
-                return true;
-            }
-
-            std::wistringstream iss(control.substr( 7, control.length() - 2 ));
-            unsigned int time;
-
-            if( iss >> time )
-            {
-                if( time > 0 )
-                {
-                    // Pause but poll for termination
-                    for( int i = 0; i < static_cast<int>(1000 / DEMOTYPE_REFRESH * time); i++ )
-                    {
-                        if( g_EmitterState == KILL_STATE )
-                        {
-                            break;
-                        }
-                        std::this_thread::sleep_for( std::chrono::milliseconds( 50 ) );
-                    }
-                    return true;
-                }
-            }
+            InjectByClipboard( token.text );
         }
-        else if( control == L"[paste]" )
-        {
-            size_t endControlOpen = g_Text.find( L"[/paste]", controlClose );
-            if( endControlOpen != std::wstring::npos )
-            {
-                size_t endControlClose = g_Text.find( L']', endControlOpen );
-                size_t endControlLen = endControlClose - g_Index + 1;
-
-                std::wstring pasteData = g_Text.substr( controlClose + 1, endControlOpen - controlClose - 1 );
-                InjectByClipboard( NULL, NULL, pasteData );
+        break;
 
-                g_Index += endControlLen;
-                return true;
-            }
+    case DemoTypeScript::TokenType::Key:
+    {
+        WORD vK = NULL;
+        switch( token.key )
+        {
+        case DemoTypeScript::ControlKey::Enter: vK = VK_RETURN; break;
+        case DemoTypeScript::ControlKey::Up:    vK = VK_UP;     break;
+        case DemoTypeScript::ControlKey::Down:  vK = VK_DOWN;   break;
+        case DemoTypeScript::ControlKey::Left:  vK = VK_LEFT;   break;
+        case DemoTypeScript::ControlKey::Right: vK = VK_RIGHT;  break;
         }
-        else
+        if( vK != NULL )
         {
-            if( control == L"[enter]" )
-            {
-                SendVirtualKeyDown( VK_RETURN );
-                SendVirtualKeyUp  ( VK_RETURN );
-            }
-            else if( control == L"[up]" )
-            {
-                SendVirtualKeyDown( VK_UP );
-                SendVirtualKeyUp  ( VK_UP );
-            }
-            else if( control == L"[down]" )
-            {
-                SendVirtualKeyDown( VK_DOWN );
-                SendVirtualKeyUp  ( VK_DOWN );
-            }
-            else if( control == L"[left]" )
-            {
-                SendVirtualKeyDown( VK_LEFT );
-                SendVirtualKeyUp  ( VK_LEFT );
-            }
-            else if( control == L"[right]" )
-            {
-                SendVirtualKeyDown( VK_RIGHT );
-                SendVirtualKeyUp  ( VK_RIGHT );
-            }
-            else
-            {
-                return false;
-            }
-            g_Index += controlLen;
-            return true;
+            SendVirtualKeyDown( vK );
+            SendVirtualKeyUp  ( vK );
         }
+        break;
     }
-    return false;
-}
-
-//----------------------------------------------------------------------------
-//
-// HandleInjection
-//
-//----------------------------------------------------------------------------
-void HandleInjection( bool init = false )
-{
-    static wchar_t lastCh = NULL;
 
-    if( init )
-    {
-        if( g_Index == 0 )
+    case DemoTypeScript::TokenType::Pause:
+        if( !g_UserDriven )
         {
-            g_TextSegments.clear();
+            // Pause but poll for termination
+            for( unsigned int i = 0; i < 1000 / DEMOTYPE_REFRESH * token.pauseSeconds; i++ )
+            {
+                if( g_EmitterState == KILL_STATE )
+                {
+                    break;
+                }
+                std::this_thread::sleep_for( std::chrono::milliseconds( DEMOTYPE_REFRESH ) );
+            }
         }
+        break;
 
-        lastCh = NULL;
-        GetBaselineIndentation();
-        return;
-    }
+    case DemoTypeScript::TokenType::Paste:
+        InjectByClipboard( token.text );
+        break;
 
-    wchar_t ch = g_Text[g_Index];
+    case DemoTypeScript::TokenType::End:
+        g_End = true;
+        g_TextSegments.push_back( tokenEnd );
 
-    if( ch == L'[' )
-    {
-        if( HandleControlKeyword() )
+        // In standard mode, [end] is interpreted as an immediate kill signal
+        if( !g_UserDriven )
         {
-            return;
+            g_EmitterState = KILL_STATE;
         }
+        break;
     }
 
-    if( IsAutoFormatTrigger( lastCh, ch ) )
-    {
-        wchar_t newCh = InjectByClipboard( lastCh, ch );
-        if( newCh != NULL )
-        {
-            ch = newCh;
-        }
-    }
-    else
-    {
-        SendUnicodeKeyDown( ch );
-        SendUnicodeKeyUp  ( ch );
-    }
-    lastCh = ch;
-    g_Index++;
+    g_Index = tokenEnd;
+    return 0;
 }
 
 //----------------------------------------------------------------------------
@@ -768,14 +681,25 @@ void DemoTypeEmitter()
     const unsigned int variance = static_cast<unsigned int>(speed * TYPING_VARIANCE);
 
     // Initialize the injection handler
-    HandleInjection( true );
+    InitInjection();
 
     while( g_EmitterState == ACTIVE_STATE && g_Index < g_TextLen )
     {
-        HandleInjection();
+        // Draw per-character delays until they add up to a scheduler tick
+        // and type that many characters of the current run in one batch
+        size_t batch = 0;
+        unsigned int delay = 0;
+        do
+        {
+            delay += GetRandomNumber( max( speed - variance, 1 ), max( speed + variance, 1 ) );
+            batch++;
+        } while( delay < TYPING_BATCH_TICK && batch < MAX_TYPING_BATCH );
+
+        size_t typed = HandleInjection( batch );
 
-        std::this_thread::sleep_for( std::chrono::milliseconds(
-            GetRandomNumber( max( speed - variance, 1 ), max( speed + variance, 1 ) ) ) );
+        // Controls and short runs only wait for their share of the delay
+        delay = static_cast<unsigned int>(delay * max( typed, static_cast<size_t>(1) ) / batch);
+        std::this_thread::sleep_for( std::chrono::milliseconds( delay ) );
     }
     if( g_Index >= g_TextLen )
     {
@@ -850,7 +774,7 @@ LRESULT CALLBACK DemoTypeHookProc( int nCode, WPARAM wParam, LPARAM lParam )
                     g_BaselineIndentation = INDENT_SEEK_FLAG;
 
                     // Initialize the injection handler
-                    HandleInjection( true );
+                    InitInjection();
                 }
                 return 1;
             }
@@ -1062,14 +986,14 @@ void DemoTypeController()
     // Upon kill, hop to the next text segment if kill wasn't triggered by an [end]
     if( g_Index != 0 && !g_End )
     {
-        size_t nextEnd = g_Text.find( L"[end]", g_Index );
-        if( nextEnd == std::wstring::npos )
+        size_t nextSegment = g_Plan.NextSegment( g_Index );
+        if( nextSegment == std::wstring::npos )
         {
             g_Index = 0;
         }
         else
         {
-            g_Index = nextEnd + END_CONTROL_LEN;
+            g_Index = nextSegment;
             g_TextSegments.push_back( g_Index );
             if( g_Index >= g_TextLen )
             {
@@ -1081,90 +1005,17 @@ void DemoTypeController()
     g_Active = false;
 }
 
-//----------------------------------------------------------------------------
-//
-// TrimNewlineAroundControl
-//
-//----------------------------------------------------------------------------
-void TrimNewlineAroundControl( const std::wstring control, const bool trimLeft, const bool trimRight )
-{
-    const size_t controlLen = control.length();
-
-    // Seek first occurrence of `control` in `g_Text`
-    size_t nextControl = g_Text.find( control );
-
-    // Loop through each occurrence of `control` in `g_Text`
-    while( nextControl != std::wstring::npos )
-    {
-        // Erase the character to the left of `control` if it is a newline
-        if( trimLeft && nextControl > 0 && g_Text[nextControl - 1] == L'\n' )
-        {
-            g_Text.erase( nextControl - 1, 1 );
-            // Decrement `nextControl` to account for `g_Text` shrinking to left of `nextControl`
-            nextControl--;
-        }
-
-        // Erase the character to the right of `control` if it is a newline
-        if( trimRight && (nextControl + controlLen) < g_Text.length() && g_Text[nextControl + controlLen] == L'\n' )
-        {
-            g_Text.erase( nextControl + controlLen, 1 );
-        }
-
-        // Seek next occurrence of `control` in `g_Text`
-        nextControl = g_Text.find( control, nextControl + controlLen);
-
-        // Shrink `g_Text` to new size on last pass
-        if( nextControl == std::wstring::npos )
-        {
-            g_Text.shrink_to_fit();
-        }
-    }
-}
-
 //----------------------------------------------------------------------------
 //
 // CleanDemoTypeText
 //
+// Cleans and compiles the script once; injection only walks the plan
+//
 //----------------------------------------------------------------------------
 bool CleanDemoTypeText()
 {
-    // Remove all unsupported characters from our text buffer
-    g_Text.erase( std::remove_if( g_Text.begin(), g_Text.end(), IsNotPrintable ), g_Text.end() );
-    g_Text.shrink_to_fit();
-
-    // Remove the first character if it is a newline
-    if( g_Text.length() > 0 && g_Text[0] == L'\n' )
-    {
-        g_Text.erase( 0, 1 );
-        g_Text.shrink_to_fit();
-    }
-
-    // Trim a newline character to the left and right of each [end] control
-    TrimNewlineAroundControl( L"[end]", true, true );
-
-    // Trim a newline character to the right of each [paste] control
-    TrimNewlineAroundControl( L"[paste]", false, true );
-
-    // Trim a newline character to the left of each [/paste] control
-    TrimNewlineAroundControl( L"[/paste]", true, false );
-
-    // Remove any dangling whitespace after the last [end]
-    size_t lastEnd = g_Text.rfind( L"[end]" );
-    if( lastEnd != std::wstring::npos )
-    {
-        for( size_t i = lastEnd + END_CONTROL_LEN; i < g_Text.length(); i++ )
-        {
-            if( iswprint( g_Text[i] ) && g_Text[i] != L' ' )
-            {
-                break;
-            }
-            else if( i >= g_Text.length() - 1 )
-            {
-                g_Text.erase( lastEnd + END_CONTROL_LEN );
-                g_Text.shrink_to_fit();
-            }
-        }
-    }
+    g_Text = DemoTypeScript::Clean( g_Text );
+    g_Plan = DemoTypeScript::Compile( g_Text );
 
     g_TextLen = g_Text.length();
     if( g_TextLen > 0 )
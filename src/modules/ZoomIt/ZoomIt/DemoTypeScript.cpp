@@ -0,0 +1,336 @@
+//============================================================================
+//
+// Zoomit
+// Copyright (C) Mark Russinovich
+// Sysinternals - www.sysinternals.com
+//
+// DemoType script compiler
+//
+// The Microsoft Corporation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+//============================================================================
+
+#include "DemoTypeScript.h"
+
+#include <algorithm>
+#include <cwchar>
+#include <cwctype>
+#include <iterator>
+#include <sstream>
+
+// Longest accepted control: [pause:000]
+#define MAX_CONTROL_LEN     11
+#define END_CONTROL         L"[end]"
+#define PAUSE_CONTROL       L"[pause:"
+#define PASTE_CONTROL       L"[paste]"
+#define PASTE_END_CONTROL   L"[/paste]"
+
+namespace DemoTypeScript
+{
+    namespace
+    {
+        //----------------------------------------------------------------------------
+        //
+        // IsNotPrintable
+        //
+        //----------------------------------------------------------------------------
+        bool IsNotPrintable( wchar_t ch )
+        {
+            return ch != L'\n' && ch != L'\t' && !std::iswprint( ch );
+        }
+
+        //----------------------------------------------------------------------------
+        //
+        // IsAutoFormatTrigger
+        //
+        //----------------------------------------------------------------------------
+        bool IsAutoFormatTrigger( wchar_t lastCh, wchar_t ch )
+        {
+            // Will trigger auto-indentation in smart editors
+            //     '\t' check also handles possible auto-completion
+            if( ch == L'\n' || ch == L'\t' || (ch == L' ' && lastCh == L'\n') )
+            {
+                return true;
+            }
+
+            // Will trigger auto-close character(s) in smart editors
+            if( ch == L'{' || ch == L'[' || ch == L'(' || (ch == L'*' && lastCh == L'/') )
+            {
+                return true;
+            }
+
+            return false;
+        }
+
+        //----------------------------------------------------------------------------
+        //
+        // TrimNewlineAroundControl
+        //
+        // Single pass over the script instead of erasing in place, which was
+        // quadratic in the number of controls.
+        //
+        //----------------------------------------------------------------------------
+        std::wstring TrimNewlineAroundControl( const std::wstring& text, const std::wstring& control,
+                                               const bool trimLeft, const bool trimRight )
+        {
+            std::wstring trimmed;
+            trimmed.reserve( text.length() );
+
+            size_t position = 0;
+            size_t nextControl = text.find( control );
+            while( nextControl != std::wstring::npos )
+            {
+                trimmed.append( text, position, nextControl - position );
+
+                // Erase the character to the left of `control` if it is a newline
+                if( trimLeft && !trimmed.empty() && trimmed.back() == L'\n' )
+                {
+                    trimmed.pop_back();
+                }
+                trimmed.append( control );
+                position = nextControl + control.length();
+
+                // Erase the character to the right of `control` if it is a newline
+                if( trimRight && position < text.length() && text[position] == L'\n' )
+                {
+                    position++;
+                }
+                nextControl = text.find( control, position );
+            }
+            trimmed.append( text, position, std::wstring::npos );
+            return trimmed;
+        }
+
+        //----------------------------------------------------------------------------
+        //
+        // ParseControlKeyword
+        //
+        // Returns false if the '[' at offset doesn't start a control keyword,
+        // in which case it is typed like any other character.
+        //
+        //----------------------------------------------------------------------------
+        bool ParseControlKeyword( const std::wstring& text, const size_t offset, Token& token )
+        {
+            size_t controlClose = text.find( L']', offset );
+            if( controlClose == std::wstring::npos )
+            {
+                return false;
+            }
+            size_t controlLen = controlClose - offset + 1;
+            if( controlLen > MAX_CONTROL_LEN )
+            {
+                return false;
+            }
+
+            std::wstring control = text.substr( offset, controlLen );
+            token.offset = offset;
+            token.length = controlLen;
+
+            if( control == END_CONTROL )
+            {
+                token.type = TokenType::End;
+                return true;
+            }
+            else if( control.compare( 0, 7, PAUSE_CONTROL ) == 0 )
+            {
+                std::wistringstream iss(control.substr( 7, control.length() - 8 ));
+                unsigned int time = 0;
+
+                // A malformed or zero pause is consumed without pausing
+                token.type = TokenType::Pause;
+                token.pauseSeconds = (iss >> time) ? time : 0;
+                return true;
+            }
+            else if( control == PASTE_CONTROL )
+            {
+                size_t endControlOpen = text.find( PASTE_END_CONTROL, controlClose );
+                if( endControlOpen == std::wstring::npos )
+                {
+                    return false;
+                }
+                token.type = TokenType::Paste;
+                token.text = text.substr( controlClose + 1, endControlOpen - controlClose - 1 );
+                token.length = endControlOpen + wcslen( PASTE_END_CONTROL ) - offset;
+                return true;
+            }
+
+            static const std::pair<const wchar_t*, ControlKey> keys[] = {
+                { L"[enter]", ControlKey::Enter },
+                { L"[up]",    ControlKey::Up },
+                { L"[down]",  ControlKey::Down },
+                { L"[left]",  ControlKey::Left },
+                { L"[right]", ControlKey::Right },
+            };
+            for( const auto& key : keys )
+            {
+                if( control == key.first )
+                {
+                    token.type = TokenType::Key;
+                    token.key = key.second;
+                    return true;
+                }
+            }
+            return false;
+        }
+    }
+
+    //----------------------------------------------------------------------------
+    //
+    // Plan::TokenAt
+    //
+    //----------------------------------------------------------------------------
+    size_t Plan::TokenAt( size_t offset ) const
+    {
+        auto next = std::upper_bound( tokens.begin(), tokens.end(), offset,
+            []( size_t value, const Token& token ) { return value < token.offset; } );
+        if( next == tokens.begin() )
+        {
+            return tokens.size();
+        }
+        auto token = std::prev( next );
+        if( offset >= token->offset + token->length )
+        {
+            return tokens.size();
+        }
+        return static_cast<size_t>(token - tokens.begin());
+    }
+
+    //----------------------------------------------------------------------------
+    //
+    // Plan::NextSegment
+    //
+    //----------------------------------------------------------------------------
+    size_t Plan::NextSegment( size_t offset ) const
+    {
+        for( size_t i = TokenAt( offset ); i < tokens.size(); i++ )
+        {
+            if( tokens[i].type == TokenType::End && tokens[i].offset >= offset )
+            {
+                return tokens[i].offset + tokens[i].length;
+            }
+        }
+        return std::wstring::npos;
+    }
+
+    //----------------------------------------------------------------------------
+    //
+    // Clean
+    //
+    //----------------------------------------------------------------------------
+    std::wstring Clean( const std::wstring& script )
+    {
+        // Remove all unsupported characters
+        std::wstring text;
+        text.reserve( script.length() );
+        std::remove_copy_if( script.begin(), script.end(), std::back_inserter( text ), IsNotPrintable );
+
+        // Remove the first character if it is a newline
+        if( !text.empty() && text[0] == L'\n' )
+        {
+            text.erase( 0, 1 );
+        }
+
+        // Trim a newline character to the left and right of each [end] control
+        text = TrimNewlineAroundControl( text, END_CONTROL, true, true );
+
+        // Trim a newline character to the right of each [paste] control
+        text = TrimNewlineAroundControl( text, PASTE_CONTROL, false, true );
+
+        // Trim a newline character to the left of each [/paste] control
+        text = TrimNewlineAroundControl( text, PASTE_END_CONTROL, true, false );
+
+        // Remove any dangling whitespace after the last [end]
+        size_t lastEnd = text.rfind( END_CONTROL );
+        if( lastEnd != std::wstring::npos )
+        {
+            size_t tail = lastEnd + wcslen( END_CONTROL );
+            auto printable = std::find_if( text.begin() + tail, text.end(),
+                []( wchar_t ch ) { return std::iswprint( ch ) && ch != L' '; } );
+            if( printable == text.end() )
+            {
+                text.erase( tail );
+            }
+        }
+
+        text.shrink_to_fit();
+        return text;
+    }
+
+    //----------------------------------------------------------------------------
+    //
+    // Compile
+    //
+    //----------------------------------------------------------------------------
+    Plan Compile( const std::wstring& script )
+    {
+        Plan plan;
+        const size_t length = script.length();
+        wchar_t lastCh = L'\0';
+        size_t i = 0;
+        while( i < length )
+        {
+            wchar_t ch = script[i];
+
+            Token token{};
+            if( ch == L'[' && ParseControlKeyword( script, i, token ) )
+            {
+                // Each segment starts without a previous character
+                if( token.type == TokenType::End )
+                {
+                    lastCh = L'\0';
+                }
+                i += token.length;
+                plan.tokens.push_back( std::move( token ) );
+                continue;
+            }
+
+            if( IsAutoFormatTrigger( lastCh, ch ) )
+            {
+                token.type = TokenType::AutoFormat;
+                token.offset = i;
+                token.text.assign( 1, ch );
+                token.newline = ch == L'\n';
+
+                // VS absorbs pasted line indentation so indentation is
+                // injected as one chunk together with the first printable
+                // character. A '[' ends the chunk without being included
+                // since it may start a control keyword.
+                size_t next = i + 1;
+                if( lastCh == L'\n' && (ch == L'\t' || ch == L' ') )
+                {
+                    for( ; next < length; next++ )
+                    {
+                        if( script[next] != L' ' && std::iswprint( script[next] ) )
+                        {
+                            if( script[next] != L'[' )
+                            {
+                                token.text.push_back( script[next++] );
+                            }
+                            break;
+                        }
+                        token.text.push_back( script[next] );
+                    }
+                }
+                token.length = next - i;
+                lastCh = token.text.back();
+                i = next;
+                plan.tokens.push_back( std::move( token ) );
+                continue;
+            }
+
+            // Extend the current run of plain characters
+            if( plan.tokens.empty() || plan.tokens.back().type != TokenType::Text )
+            {
+                token.type = TokenType::Text;
+                token.offset = i;
+                token.length = 0;
+                plan.tokens.push_back( std::move( token ) );
+            }
+            plan.tokens.back().text.push_back( ch );
+            plan.tokens.back().length++;
+            lastCh = ch;
+            i++;
+        }
+        return plan;
+    }
+}
@@ -0,0 +1,80 @@
+//============================================================================
+//
+// Zoomit
+// Copyright (C) Mark Russinovich
+// Sysinternals - www.sysinternals.com
+//
+// DemoType script compiler. A script is cleaned and tokenized once into an
+// injection plan; the emitter then only walks the plan. This file has no
+// Windows dependencies.
+//
+// The Microsoft Corporation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+//============================================================================
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace DemoTypeScript
+{
+    enum class TokenType
+    {
+        Text,           // run of characters typed as unicode key presses
+        AutoFormat,     // characters that smart editors reformat; injected by clipboard
+        Key,            // [enter], [up], [down], [left], [right]
+        Pause,          // [pause:n]
+        Paste,          // [paste]...[/paste]
+        End             // [end]
+    };
+
+    enum class ControlKey
+    {
+        None,
+        Enter,
+        Up,
+        Down,
+        Left,
+        Right
+    };
+
+    struct Token
+    {
+        TokenType type;
+
+        // Position of the token in the cleaned script. Script positions are
+        // what DemoType persists between runs (segments, [end] hops).
+        size_t offset;
+        size_t length;
+
+        // Characters to inject for Text, AutoFormat and Paste tokens
+        std::wstring text;
+
+        ControlKey key = ControlKey::None;
+        unsigned int pauseSeconds = 0;
+
+        // AutoFormat token starting with a newline; the editor's baseline
+        // indentation is appended to it at injection time
+        bool newline = false;
+    };
+
+    struct Plan
+    {
+        std::vector<Token> tokens;
+
+        // Index of the token covering a script position, or tokens.size()
+        size_t TokenAt( size_t offset ) const;
+
+        // Script position just past the next [end] at or after offset, or
+        // std::wstring::npos if there is none
+        size_t NextSegment( size_t offset ) const;
+    };
+
+    // Drops unsupported characters and the newlines around control keywords
+    // that only serve to make the script readable
+    std::wstring Clean( const std::wstring& script );
+
+    // Tokenizes an already cleaned script
+    Plan Compile( const std::wstring& script );
+}
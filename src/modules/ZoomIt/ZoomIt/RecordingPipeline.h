@@ -0,0 +1,251 @@
+//==============================================================================
+//
+// Zoomit
+// Sysinternals - www.sysinternals.com
+//
+// Queueing and pacing for the recording pipeline. Capture callbacks push
+// timestamped samples into bounded queues and the encoder pulls from them.
+// This file only depends on the STL so the policies can be exercised with
+// simulated timestamps.
+//
+//==============================================================================
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <utility>
+
+namespace RecordingPipeline
+{
+    // Timestamps are in 100ns units, like winrt::TimeSpan
+    using Timestamp = int64_t;
+    constexpr Timestamp TicksPerSecond = 10'000'000;
+
+    //
+    // Buffers a capture frame pool needs to feed a queue of the given depth.
+    // One more for the frame the encoder holds and one for the frame being
+    // captured, so a full queue drops its oldest frame instead of stalling
+    // capture until the encoder lets go of a buffer.
+    //
+    constexpr size_t FramePoolSize( size_t queueDepth )
+    {
+        return queueDepth + 2;
+    }
+
+    enum class DropPolicy
+    {
+        DropOldest,     // keep latency low; used for video and audio
+        DropNewest      // keep continuity; reject the sample being pushed
+    };
+
+    struct QueueStats
+    {
+        uint64_t pushed = 0;
+        uint64_t popped = 0;
+        uint64_t dropped = 0;
+        size_t depth = 0;
+        size_t maxDepth = 0;
+    };
+
+    //
+    // Bounded, closeable multi-producer queue of timestamped samples. Samples
+    // that are dropped are handed back to the caller, since capture frames
+    // must be closed to return their buffer to the frame pool.
+    //
+    template<typename T>
+    class SampleQueue
+    {
+    public:
+        struct Entry
+        {
+            T sample;
+            Timestamp timestamp;
+        };
+
+        SampleQueue( size_t capacity, DropPolicy policy ) :
+            m_capacity( (std::max)( capacity, static_cast<size_t>(1) ) ), m_policy( policy ) {}
+
+        // Returns the sample that had to be dropped to respect the capacity,
+        // if any. Pushing to a closed queue drops the pushed sample.
+        std::optional<Entry> Push( T sample, Timestamp timestamp )
+        {
+            std::optional<Entry> dropped;
+            {
+                std::lock_guard lock( m_mutex );
+                m_stats.pushed++;
+                if( m_closed )
+                {
+                    m_stats.dropped++;
+                    return Entry{ std::move( sample ), timestamp };
+                }
+                if( m_entries.size() >= m_capacity )
+                {
+                    m_stats.dropped++;
+                    if( m_policy == DropPolicy::DropNewest )
+                    {
+                        return Entry{ std::move( sample ), timestamp };
+                    }
+                    dropped.emplace( std::move( m_entries.front() ) );
+                    m_entries.pop_front();
+                }
+                m_entries.push_back( Entry{ std::move( sample ), timestamp } );
+                m_stats.maxDepth = (std::max)( m_stats.maxDepth, m_entries.size() );
+            }
+            m_available.notify_one();
+            return dropped;
+        }
+
+        // Blocks until a sample is available or the queue is closed and
+        // drained
+        std::optional<Entry> Pop()
+        {
+            std::unique_lock lock( m_mutex );
+            m_available.wait( lock, [this] { return !m_entries.empty() || m_closed; } );
+            return PopLocked();
+        }
+
+        std::optional<Entry> TryPop()
+        {
+            std::lock_guard lock( m_mutex );
+            return PopLocked();
+        }
+
+        // Wakes up waiters; samples already queued can still be popped
+        void Close()
+        {
+            {
+                std::lock_guard lock( m_mutex );
+                m_closed = true;
+            }
+            m_available.notify_all();
+        }
+
+        bool IsClosed() const
+        {
+            std::lock_guard lock( m_mutex );
+            return m_closed;
+        }
+
+        QueueStats Stats() const
+        {
+            std::lock_guard lock( m_mutex );
+            QueueStats stats = m_stats;
+            stats.depth = m_entries.size();
+            return stats;
+        }
+
+    private:
+        std::optional<Entry> PopLocked()
+        {
+            if( m_entries.empty() )
+            {
+                return std::nullopt;
+            }
+            std::optional<Entry> entry( std::move( m_entries.front() ) );
+            m_entries.pop_front();
+            m_stats.popped++;
+            return entry;
+        }
+
+        const size_t m_capacity;
+        const DropPolicy m_policy;
+        mutable std::mutex m_mutex;
+        std::condition_variable m_available;
+        std::deque<Entry> m_entries;
+        QueueStats m_stats;
+        bool m_closed = false;
+    };
+
+    //
+    // Thins a capture stream down to the target frame rate. Capture runs at
+    // the monitor refresh rate, which is often well above what is being
+    // encoded. A frame is accepted when it is due within half an interval,
+    // so that small timestamp jitter doesn't cause beats.
+    //
+    class FrameRateLimiter
+    {
+    public:
+        explicit FrameRateLimiter( uint32_t framesPerSecond ) :
+            m_interval( framesPerSecond ? TicksPerSecond / framesPerSecond : 0 ) {}
+
+        bool Accept( Timestamp timestamp )
+        {
+            if( m_interval == 0 || !m_nextDue )
+            {
+                m_nextDue = timestamp + m_interval;
+                return true;
+            }
+            if( timestamp + m_interval / 2 < *m_nextDue )
+            {
+                return false;
+            }
+
+            // Stay on the frame grid unless capture stalled for more than
+            // an interval, in which case restart the grid from this frame
+            *m_nextDue += m_interval;
+            if( *m_nextDue <= timestamp )
+            {
+                m_nextDue = timestamp + m_interval;
+            }
+            return true;
+        }
+
+    private:
+        const Timestamp m_interval;
+        std::optional<Timestamp> m_nextDue;
+    };
+
+    //
+    // Accumulates the time samples spend between capture and the encoder
+    //
+    class LatencyTracker
+    {
+    public:
+        void Add( std::chrono::microseconds latency )
+        {
+            std::lock_guard lock( m_mutex );
+            m_count++;
+            m_total += latency;
+            m_max = (std::max)( m_max, latency );
+        }
+
+        std::chrono::microseconds Average() const
+        {
+            std::lock_guard lock( m_mutex );
+            return m_count ? m_total / static_cast<int64_t>(m_count) : std::chrono::microseconds::zero();
+        }
+
+        std::chrono::microseconds Max() const
+        {
+            std::lock_guard lock( m_mutex );
+            return m_max;
+        }
+
+    private:
+        mutable std::mutex m_mutex;
+        uint64_t m_count = 0;
+        std::chrono::microseconds m_total{};
+        std::chrono::microseconds m_max{};
+    };
+
+    struct RecordingStats
+    {
+        uint64_t framesCaptured = 0;
+        uint64_t framesEncoded = 0;
+        uint64_t framesDroppedByPacing = 0;
+        uint64_t framesDroppedByQueue = 0;
+        size_t frameQueueDepth = 0;
+        size_t maxFrameQueueDepth = 0;
+        uint64_t audioSamplesCaptured = 0;
+        uint64_t audioSamplesEncoded = 0;
+        uint64_t audioSamplesDropped = 0;
+        size_t audioQueueDepth = 0;
+        std::chrono::microseconds averageEncodeLatency{};
+        std::chrono::microseconds maxEncodeLatency{};
+    };
+}
@@ -65,7 +65,7 @@ VideoRecordingSession::VideoRecordingSession(
     auto itemSize = item.Size();
     auto inputWidth = EnsureEven(itemSize.Width);
     auto inputHeight = EnsureEven(itemSize.Height);
-    m_frameWait = std::make_shared<CaptureFrameWait>(m_device, m_item, winrt::SizeInt32{ inputWidth, inputHeight });
+    m_frameWait = std::make_shared<CaptureFrameWait>(m_device, m_item, winrt::SizeInt32{ inputWidth, inputHeight }, frameRate);
     auto weakPointer{ std::weak_ptr{ m_frameWait } };
     m_itemClosed = item.Closed(winrt::auto_revoke, [weakPointer](auto&, auto&)
         {
@@ -256,6 +256,50 @@ void VideoRecordingSession::CloseInternal()
     }
     m_frameWait->StopCapture();
     m_itemClosed.revoke();
+    LogStats();
+}
+
+//----------------------------------------------------------------------------
+//
+// VideoRecordingSession::GetStats
+//
+//----------------------------------------------------------------------------
+RecordingPipeline::RecordingStats VideoRecordingSession::GetStats() const
+{
+    RecordingPipeline::RecordingStats stats;
+    m_frameWait->GetStats(stats);
+    stats.framesEncoded = m_framesEncoded;
+    stats.averageEncodeLatency = m_encodeLatency.Average();
+    stats.maxEncodeLatency = m_encodeLatency.Max();
+    if (m_audioGenerator)
+    {
+        auto audioStats = m_audioGenerator->GetStats();
+        stats.audioSamplesCaptured = audioStats.pushed;
+        stats.audioSamplesEncoded = audioStats.popped;
+        stats.audioSamplesDropped = audioStats.dropped;
+        stats.audioQueueDepth = audioStats.depth;
+    }
+    return stats;
+}
+
+//----------------------------------------------------------------------------
+//
+// VideoRecordingSession::LogStats
+//
+//----------------------------------------------------------------------------
+void VideoRecordingSession::LogStats() const
+{
+    auto stats = GetStats();
+    wchar_t message[512];
+    swprintf_s(message,
+        L"ZoomIt recording: frames captured %llu encoded %llu dropped %llu (pacing) %llu (queue), "
+        L"max frame queue %zu, encode latency avg %lld us max %lld us, "
+        L"audio samples captured %llu encoded %llu dropped %llu\n",
+        stats.framesCaptured, stats.framesEncoded, stats.framesDroppedByPacing, stats.framesDroppedByQueue,
+        stats.maxFrameQueueDepth, static_cast<long long>(stats.averageEncodeLatency.count()),
+        static_cast<long long>(stats.maxEncodeLatency.count()),
+        stats.audioSamplesCaptured, stats.audioSamplesEncoded, stats.audioSamplesDropped);
+    OutputDebugStringW(message);
 }
 
 
@@ -362,6 +406,10 @@ void VideoRecordingSession::OnMediaStreamSourceSampleRequested(
 
                 auto sample = winrt::MediaStreamSample::CreateFromDirect3D11Surface(sampleSurface, timeStamp);
                 request.Sample(sample);
+
+                m_framesEncoded++;
+                m_encodeLatency.Add(std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - frame->ArrivalTime));
             }
             catch (winrt::hresult_error const& error)
             {
@@ -27,6 +27,7 @@ public:
     winrt::IAsyncAction StartAsync();
     void EnableCursorCapture(bool enable = true) { m_frameWait->EnableCursorCapture(enable); }
     void Close();
+    RecordingPipeline::RecordingStats GetStats() const;
 
 private:
     VideoRecordingSession(
@@ -37,6 +38,7 @@ private:
         bool captureAudio,
         winrt::Streams::IRandomAccessStream const& stream);
     void CloseInternal();
+    void LogStats() const;
 
     void OnMediaStreamSourceStarting(
         winrt::MediaStreamSource const& sender,
@@ -63,6 +65,9 @@ private:
 
     std::unique_ptr<AudioSampleGenerator> m_audioGenerator;
 
+    RecordingPipeline::LatencyTracker m_encodeLatency;
+    std::atomic<uint64_t> m_framesEncoded = 0;
+
     winrt::com_ptr<IDXGISwapChain1> m_previewSwapChain;
     winrt::com_ptr<ID3D11RenderTargetView> m_renderTargetView;
 
@@ -62,6 +62,7 @@ type_pEnableThemeDialogTexture    pEnableThemeDialogTexture;
 #define WM_USER_MAGNIFY_CURSOR	WM_USER+108
 #define WM_USER_EXIT_MODE		WM_USER+109
 #define WM_USER_RELOAD_SETTINGS	WM_USER+110
+#define WM_USER_VSYNC_FRAME		WM_USER+111
 
 typedef struct _TYPED_KEY {
     RECT		rc;
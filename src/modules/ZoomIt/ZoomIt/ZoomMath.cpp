@@ -0,0 +1,146 @@
+//==============================================================================
+//
+// Zoomit
+// Sysinternals - www.sysinternals.com
+//
+// Zoom and pan geometry shared by static zoom and LiveZoom
+//
+//==============================================================================
+#include "ZoomMath.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ZoomMath
+{
+    //----------------------------------------------------------------------------
+    //
+    // AdjustToMoveBoundary
+    //
+    // Shifts to accomodate move boundary.
+    //
+    //----------------------------------------------------------------------------
+    int AdjustToMoveBoundary( int coordinate, int cursor, int size, int max, int moveRegions )
+    {
+        int diff = static_cast<int>(static_cast<float>(size) / static_cast<float>(moveRegions));
+        if( cursor - coordinate < diff )
+        {
+            coordinate = (std::max)( 0, cursor - diff );
+        }
+        else if( (coordinate + size) - cursor < diff )
+        {
+            coordinate = (std::min)( cursor + diff - size, max - size );
+        }
+        return coordinate;
+    }
+
+    //----------------------------------------------------------------------------
+    //
+    // GetZoomedTopLeft
+    //
+    //----------------------------------------------------------------------------
+    Point GetZoomedTopLeft( float zoomLevel, Point cursor, int width, int height, int moveRegions )
+    {
+        // smoother and more natural zoom in
+        float scaledWidth = width / zoomLevel;
+        float scaledHeight = height / zoomLevel;
+        Point topLeft;
+        topLeft.x = (std::max)( 0, (std::min)( static_cast<int>(width - scaledWidth),
+            static_cast<int>(cursor.x - static_cast<int>((static_cast<float>(cursor.x) / static_cast<float>(width)) * scaledWidth)) ) );
+        topLeft.x = AdjustToMoveBoundary( topLeft.x, cursor.x, static_cast<int>(scaledWidth), width, moveRegions );
+        topLeft.y = (std::max)( 0, (std::min)( static_cast<int>(height - scaledHeight),
+            static_cast<int>(cursor.y - static_cast<int>((static_cast<float>(cursor.y) / static_cast<float>(height)) * scaledHeight)) ) );
+        topLeft.y = AdjustToMoveBoundary( topLeft.y, cursor.y, static_cast<int>(scaledHeight), height, moveRegions );
+        return topLeft;
+    }
+
+    //----------------------------------------------------------------------------
+    //
+    // GetZoomedBounds
+    //
+    //----------------------------------------------------------------------------
+    Rect GetZoomedBounds( float zoomLevel, Point cursor, int width, int height,
+                          Point monitorOrigin, int moveRegions )
+    {
+        Point topLeft = GetZoomedTopLeft( zoomLevel, cursor, width, height, moveRegions );
+        Rect rc;
+        rc.left = monitorOrigin.x + topLeft.x;
+        rc.right = rc.left + static_cast<int>(width / zoomLevel);
+        rc.top = monitorOrigin.y + topLeft.y;
+        rc.bottom = rc.top + static_cast<int>(height / zoomLevel);
+        return rc;
+    }
+
+    //----------------------------------------------------------------------------
+    //
+    // ZoomedToScreen
+    //
+    //----------------------------------------------------------------------------
+    Point ZoomedToScreen( float zoomLevel, Point cursor, int width, int height,
+                          Point monitorOrigin, int moveRegions )
+    {
+        Point topLeft = GetZoomedTopLeft( zoomLevel, cursor, width, height, moveRegions );
+        Point screen;
+        screen.x = monitorOrigin.x + topLeft.x + static_cast<int>((cursor.x - topLeft.x) * zoomLevel);
+        screen.y = monitorOrigin.y + topLeft.y + static_cast<int>((cursor.y - topLeft.y) * zoomLevel);
+        return screen;
+    }
+
+    //----------------------------------------------------------------------------
+    //
+    // ClampSourceRect
+    //
+    // Don't scroll outside desktop area.
+    //
+    //----------------------------------------------------------------------------
+    Rect ClampSourceRect( Point center, int zoomWidth, int zoomHeight, const Rect& monitor )
+    {
+        Rect source;
+        source.left = center.x - zoomWidth / 2;
+        source.top = center.y - zoomHeight / 2;
+        if( source.left < monitor.left )
+        {
+            source.left = monitor.left;
+        }
+        else if( source.left > monitor.right - zoomWidth )
+        {
+            source.left = monitor.right - zoomWidth;
+        }
+        source.right = source.left + zoomWidth;
+        if( source.top < monitor.top )
+        {
+            source.top = monitor.top;
+        }
+        else if( source.top > monitor.bottom - zoomHeight )
+        {
+            source.top = monitor.bottom - zoomHeight;
+        }
+        source.bottom = source.top + zoomHeight;
+        return source;
+    }
+
+    //----------------------------------------------------------------------------
+    //
+    // AdvanceTelescope
+    //
+    //----------------------------------------------------------------------------
+    bool AdvanceTelescope( float& zoomLevel, float step, float target,
+                           unsigned int elapsedMs, unsigned int stepTimeMs )
+    {
+        if( step <= 0 || step == 1 || stepTimeMs == 0 )
+        {
+            zoomLevel = target;
+            return true;
+        }
+
+        float steps = static_cast<float>(elapsedMs) / static_cast<float>(stepTimeMs);
+        float next = zoomLevel * std::pow( step, steps );
+        if( (step > 1 && next >= target) || (step < 1 && next <= target) )
+        {
+            zoomLevel = target;
+            return true;
+        }
+        zoomLevel = next;
+        return false;
+    }
+}
@@ -0,0 +1,55 @@
+//==============================================================================
+//
+// Zoomit
+// Sysinternals - www.sysinternals.com
+//
+// Zoom and pan geometry shared by static zoom and LiveZoom. This file has no
+// Windows dependencies so the math can be exercised in isolation.
+//
+//==============================================================================
+#pragma once
+
+namespace ZoomMath
+{
+    struct Point
+    {
+        int x;
+        int y;
+    };
+
+    struct Rect
+    {
+        int left;
+        int top;
+        int right;
+        int bottom;
+    };
+
+    // Shifts a zoomed origin so the cursor stays out of the outer move
+    // region (1/moveRegions of the zoomed size) on that axis.
+    int AdjustToMoveBoundary( int coordinate, int cursor, int size, int max, int moveRegions );
+
+    // Returns the top left of the zoomed area of a width x height monitor
+    // for a monitor-relative cursor position.
+    Point GetZoomedTopLeft( float zoomLevel, Point cursor, int width, int height, int moveRegions );
+
+    // Returns the zoomed area in desktop coordinates; this is the rectangle
+    // the cursor is clipped to while zoomed.
+    Rect GetZoomedBounds( float zoomLevel, Point cursor, int width, int height,
+                          Point monitorOrigin, int moveRegions );
+
+    // Maps a position inside the zoomed area back to the unzoomed monitor.
+    Point ZoomedToScreen( float zoomLevel, Point cursor, int width, int height,
+                          Point monitorOrigin, int moveRegions );
+
+    // Centers a zoomWidth x zoomHeight source rectangle on center and keeps
+    // it inside the monitor.
+    Rect ClampSourceRect( Point center, int zoomWidth, int zoomHeight, const Rect& monitor );
+
+    // Advances a telescoping zoom. Levels are interpolated geometrically so
+    // that elapsedMs worth of stepTimeMs-sized steps are applied regardless
+    // of how often the caller gets to run, and the result never overshoots
+    // target. Returns true once target has been reached.
+    bool AdvanceTelescope( float& zoomLevel, float step, float target,
+                           unsigned int elapsedMs, unsigned int stepTimeMs );
+}
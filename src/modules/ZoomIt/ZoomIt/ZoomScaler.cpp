@@ -0,0 +1,276 @@
+//==============================================================================
+//
+// Zoomit
+// Sysinternals - www.sysinternals.com
+//
+// GPU scaling of the captured desktop for static zoom, and vsync paced
+// redraw scheduling
+//
+//==============================================================================
+#include "pch.h"
+#include "ZoomScaler.h"
+
+// d2d1.dll and dwmapi.dll are loaded on demand, like the other optional
+// system components ZoomIt uses, so ZoomIt keeps running where they are
+// missing.
+typedef HRESULT (__stdcall *type_pD2D1CreateFactory)( D2D1_FACTORY_TYPE factoryType, REFIID riid,
+                                                       const D2D1_FACTORY_OPTIONS* factoryOptions, void** factory );
+typedef HRESULT (__stdcall *type_pDwmFlush)();
+
+//----------------------------------------------------------------------------
+//
+// ZoomScaler::Reset
+//
+//----------------------------------------------------------------------------
+void ZoomScaler::Reset()
+{
+    m_bitmap.reset();
+    m_deviceContext.reset();
+    m_renderTarget.reset();
+    m_stagingBitmap.reset();
+    m_stagingDc.reset();
+    m_stagingBits = nullptr;
+    m_sourceSize = {};
+    m_sourceDirty = true;
+}
+
+//----------------------------------------------------------------------------
+//
+// ZoomScaler::EnsureRenderTarget
+//
+//----------------------------------------------------------------------------
+bool ZoomScaler::EnsureRenderTarget()
+{
+    if( m_renderTarget )
+    {
+        return true;
+    }
+    if( m_unavailable )
+    {
+        return false;
+    }
+
+    if( !m_factory )
+    {
+        auto pD2D1CreateFactory = reinterpret_cast<type_pD2D1CreateFactory>(
+            GetProcAddress( LoadLibrarySafe( L"d2d1.dll", DLL_LOAD_LOCATION_SYSTEM ), "D2D1CreateFactory" ));
+        if( pD2D1CreateFactory == nullptr ||
+            FAILED( pD2D1CreateFactory( D2D1_FACTORY_TYPE_SINGLE_THREADED, __uuidof(ID2D1Factory),
+                                        nullptr, m_factory.put_void() )))
+        {
+            m_unavailable = true;
+            return false;
+        }
+    }
+
+    // Default lets Direct2D pick hardware rendering and only fall back to
+    // WARP when there is no usable adapter.
+    auto properties = D2D1::RenderTargetProperties( D2D1_RENDER_TARGET_TYPE_DEFAULT,
+        D2D1::PixelFormat( DXGI_FORMAT_B8G8R8A8_UNORM, D2D1_ALPHA_MODE_IGNORE ));
+    if( FAILED( m_factory->CreateDCRenderTarget( &properties, m_renderTarget.put() )))
+    {
+        m_unavailable = true;
+        return false;
+    }
+
+    // ID2D1DeviceContext adds high quality cubic interpolation (Win8+)
+    m_deviceContext = m_renderTarget.try_query<ID2D1DeviceContext>();
+    m_renderTarget->SetAntialiasMode( D2D1_ANTIALIAS_MODE_ALIASED );
+    m_bitmap.reset();
+    m_sourceDirty = true;
+    return true;
+}
+
+//----------------------------------------------------------------------------
+//
+// ZoomScaler::UploadSource
+//
+// Copies the capture into a DIB section and from there into the Direct2D
+// bitmap. This only happens when the capture changes, not per frame.
+//
+//----------------------------------------------------------------------------
+bool ZoomScaler::UploadSource( HDC hdcSrc, SIZE srcSize )
+{
+    if( !m_stagingBitmap || m_sourceSize.cx != srcSize.cx || m_sourceSize.cy != srcSize.cy )
+    {
+        m_stagingBitmap.reset();
+        m_stagingDc.reset();
+        m_bitmap.reset();
+
+        BITMAPINFO bitmapInfo{};
+        bitmapInfo.bmiHeader.biSize = sizeof( bitmapInfo.bmiHeader );
+        bitmapInfo.bmiHeader.biWidth = srcSize.cx;
+        bitmapInfo.bmiHeader.biHeight = -srcSize.cy;
+        bitmapInfo.bmiHeader.biPlanes = 1;
+        bitmapInfo.bmiHeader.biBitCount = 32;
+        bitmapInfo.bmiHeader.biCompression = BI_RGB;
+        m_stagingBitmap.reset( CreateDIBSection( hdcSrc, &bitmapInfo, DIB_RGB_COLORS, &m_stagingBits, nullptr, 0 ));
+        if( !m_stagingBitmap )
+        {
+            return false;
+        }
+        m_stagingDc.reset( CreateCompatibleDC( hdcSrc ));
+        SelectObject( m_stagingDc.get(), m_stagingBitmap.get() );
+        m_sourceSize = srcSize;
+    }
+
+    BitBlt( m_stagingDc.get(), 0, 0, srcSize.cx, srcSize.cy, hdcSrc, 0, 0, SRCCOPY );
+    GdiFlush();
+
+    const UINT32 pitch = static_cast<UINT32>(srcSize.cx) * 4;
+    if( m_bitmap )
+    {
+        if( FAILED( m_bitmap->CopyFromMemory( nullptr, m_stagingBits, pitch )))
+        {
+            return false;
+        }
+    }
+    else
+    {
+        auto properties = D2D1::BitmapProperties(
+            D2D1::PixelFormat( DXGI_FORMAT_B8G8R8A8_UNORM, D2D1_ALPHA_MODE_IGNORE ));
+        if( FAILED( m_renderTarget->CreateBitmap( D2D1::SizeU( srcSize.cx, srcSize.cy ),
+                                                  m_stagingBits, pitch, &properties, m_bitmap.put() )))
+        {
+            return false;
+        }
+    }
+    m_sourceDirty = false;
+    return true;
+}
+
+//----------------------------------------------------------------------------
+//
+// ZoomScaler::Draw
+//
+//----------------------------------------------------------------------------
+bool ZoomScaler::Draw( HDC hdcDst, const RECT& dst, HDC hdcSrc, SIZE srcSize,
+                       float xSrc, float ySrc, float wSrc, float hSrc, Quality quality )
+{
+    if( !EnsureRenderTarget() )
+    {
+        return false;
+    }
+    if( FAILED( m_renderTarget->BindDC( hdcDst, &dst )))
+    {
+        return false;
+    }
+
+    // The bitmap belongs to the render target, so upload after binding
+    if( m_sourceDirty || !m_bitmap || m_sourceSize.cx != srcSize.cx || m_sourceSize.cy != srcSize.cy )
+    {
+        if( !UploadSource( hdcSrc, srcSize ))
+        {
+            return false;
+        }
+    }
+
+    const D2D1_RECT_F dstRect = D2D1::RectF( 0, 0, static_cast<float>(dst.right - dst.left),
+                                             static_cast<float>(dst.bottom - dst.top) );
+    const D2D1_RECT_F srcRect = D2D1::RectF( xSrc, ySrc, xSrc + wSrc, ySrc + hSrc );
+
+    m_renderTarget->BeginDraw();
+    if( m_deviceContext )
+    {
+        m_deviceContext->DrawBitmap( m_bitmap.get(), dstRect, 1.0f,
+            quality == Quality::High ? D2D1_INTERPOLATION_MODE_HIGH_QUALITY_CUBIC : D2D1_INTERPOLATION_MODE_LINEAR,
+            srcRect, nullptr );
+    }
+    else
+    {
+        m_renderTarget->DrawBitmap( m_bitmap.get(), dstRect, 1.0f,
+            D2D1_BITMAP_INTERPOLATION_MODE_LINEAR, srcRect );
+    }
+    HRESULT hr = m_renderTarget->EndDraw();
+    if( hr == D2DERR_RECREATE_TARGET )
+    {
+        // Device lost; rebuild on the next frame and let GDI draw this one
+        m_bitmap.reset();
+        m_deviceContext.reset();
+        m_renderTarget.reset();
+        m_sourceDirty = true;
+        return false;
+    }
+    return SUCCEEDED( hr );
+}
+
+//----------------------------------------------------------------------------
+//
+// FramePacer::Start
+//
+//----------------------------------------------------------------------------
+void FramePacer::Start( HWND hWnd, UINT frameMessage )
+{
+    Stop();
+
+    m_window = hWnd;
+    m_frameMessage = frameMessage;
+    m_stop = false;
+    m_framePending = false;
+    m_requestEvent.create( wil::EventOptions::None );
+    m_thread = std::thread( [this] { PacerThread(); } );
+}
+
+//----------------------------------------------------------------------------
+//
+// FramePacer::Stop
+//
+//----------------------------------------------------------------------------
+void FramePacer::Stop()
+{
+    if( m_thread.joinable() )
+    {
+        m_stop = true;
+        m_requestEvent.SetEvent();
+        m_thread.join();
+    }
+    m_window = nullptr;
+}
+
+//----------------------------------------------------------------------------
+//
+// FramePacer::RequestFrame
+//
+//----------------------------------------------------------------------------
+void FramePacer::RequestFrame()
+{
+    if( !m_thread.joinable() )
+    {
+        if( m_window )
+        {
+            InvalidateRect( m_window, nullptr, FALSE );
+        }
+        return;
+    }
+
+    // Only the first request between two frames wakes the pacer
+    if( !m_framePending.exchange( true ))
+    {
+        m_requestEvent.SetEvent();
+    }
+}
+
+//----------------------------------------------------------------------------
+//
+// FramePacer::PacerThread
+//
+//----------------------------------------------------------------------------
+void FramePacer::PacerThread()
+{
+    static auto pDwmFlush = reinterpret_cast<type_pDwmFlush>(
+        GetProcAddress( LoadLibrarySafe( L"dwmapi.dll", DLL_LOAD_LOCATION_SYSTEM ), "DwmFlush" ));
+
+    while( m_requestEvent.wait() && !m_stop )
+    {
+        // Without composition DwmFlush fails immediately, which degrades to
+        // presenting as soon as the window thread is ready.
+        if( pDwmFlush == nullptr || FAILED( pDwmFlush() ))
+        {
+            Sleep( 1 );
+        }
+        if( !m_stop )
+        {
+            PostMessage( m_window, m_frameMessage, 0, 0 );
+        }
+    }
+}
@@ -0,0 +1,88 @@
+//==============================================================================
+//
+// Zoomit
+// Sysinternals - www.sysinternals.com
+//
+// GPU scaling of the captured desktop for static zoom, and vsync paced
+// redraw scheduling
+//
+//==============================================================================
+#pragma once
+
+#include "pch.h"
+
+#include <thread>
+
+//
+// Keeps the captured desktop resident as a Direct2D bitmap so that pan and
+// zoom steps only re-render a source rectangle instead of stretching the
+// whole capture through GDI. Draw returns false when Direct2D isn't
+// available or the device was lost, in which case the caller falls back to
+// StretchBlt for that frame.
+//
+class ZoomScaler
+{
+public:
+    enum class Quality
+    {
+        Fast,       // bilinear, used while animating or panning
+        High        // high quality cubic, used once the zoom has settled
+    };
+
+    ~ZoomScaler() { Reset(); }
+
+    bool Draw( HDC hdcDst, const RECT& dst, HDC hdcSrc, SIZE srcSize,
+               float xSrc, float ySrc, float wSrc, float hSrc, Quality quality );
+
+    // Must be called whenever the contents of the source DC change (new
+    // capture, drawing, typing) so the next Draw re-uploads it.
+    void InvalidateSource() { m_sourceDirty = true; }
+    void Reset();
+
+private:
+    bool EnsureRenderTarget();
+    bool UploadSource( HDC hdcSrc, SIZE srcSize );
+
+    wil::com_ptr<ID2D1Factory> m_factory;
+    wil::com_ptr<ID2D1DCRenderTarget> m_renderTarget;
+    wil::com_ptr<ID2D1DeviceContext> m_deviceContext;
+    wil::com_ptr<ID2D1Bitmap> m_bitmap;
+    wil::unique_hdc m_stagingDc;
+    wil::unique_hbitmap m_stagingBitmap;
+    void* m_stagingBits = nullptr;
+    SIZE m_sourceSize{};
+    bool m_sourceDirty = true;
+    bool m_unavailable = false;
+};
+
+//
+// Coalesces redraw requests to at most one per display refresh. A worker
+// thread waits for the compositor's next vblank with DwmFlush and posts the
+// frame message to the target window, which then invalidates itself.
+// When DWM isn't available requests invalidate the window immediately, as
+// they did before.
+//
+class FramePacer
+{
+public:
+    ~FramePacer() { Stop(); }
+
+    void Start( HWND hWnd, UINT frameMessage );
+    void Stop();
+
+    // Called from the window thread, e.g. on WM_MOUSEMOVE
+    void RequestFrame();
+
+    // Called from the window thread when the frame message arrives
+    void FramePresented() { m_framePending = false; }
+
+private:
+    void PacerThread();
+
+    HWND m_window = nullptr;
+    UINT m_frameMessage = 0;
+    std::thread m_thread;
+    wil::unique_event m_requestEvent;
+    std::atomic<bool> m_framePending{ false };
+    std::atomic<bool> m_stop{ false };
+};
@@ -15,6 +15,8 @@
 #include "Utility.h"
 #include "WindowsVersions.h"
 #include "ZoomItSettings.h"
+#include "ZoomMath.h"
+#include "ZoomScaler.h"
 
 #ifdef __ZOOMIT_POWERTOYS__
 #include <common/interop/shared_constants.h>
@@ -155,6 +157,8 @@ BOOLEAN g_running = TRUE;
 BOOL	g_RecordToggle = FALSE;
 BOOL	g_RecordCropping = FALSE;
 SelectRectangle g_SelectRectangle;
+ZoomScaler g_ZoomScaler;
+FramePacer g_FramePacer;
 std::wstring	g_RecordingSaveLocation;
 winrt::IDirect3DDevice	g_RecordDevice{ nullptr };
 std::shared_ptr<VideoRecordingSession> g_RecordingSession = nullptr;
@@ -731,6 +735,20 @@ Gdiplus::Rect GetLineBounds( POINT p1, POINT p2, int penWidth )
     return rect;
 }
 
+//----------------------------------------------------------------------------
+//
+// InvalidateScreenCompat
+//
+// Repaints the window after the screen copy it shows was modified. The
+// scaler keeps its own copy of it, which has to be uploaded again.
+// 
+//----------------------------------------------------------------------------
+void InvalidateScreenCompat( HWND hWnd, const RECT* rc = NULL, BOOL erase = FALSE )
+{
+    g_ZoomScaler.InvalidateSource();
+    InvalidateRect( hWnd, rc, erase );
+}
+
 //----------------------------------------------------------------------------
 //
 // InvalidateGdiplusRect
@@ -745,7 +763,7 @@ void InvalidateGdiplusRect(HWND hWnd, Gdiplus::Rect BoundsRect)
     lineBoundsGdi.top = BoundsRect.Y;
     lineBoundsGdi.right = BoundsRect.X + BoundsRect.Width;
     lineBoundsGdi.bottom = BoundsRect.Y + BoundsRect.Height;
-    InvalidateRect(hWnd, &lineBoundsGdi, FALSE);
+    InvalidateScreenCompat(hWnd, &lineBoundsGdi);
 }
 
 
@@ -1235,22 +1253,6 @@ HBITMAP CreateFadedDesktopBackground( HDC hdc, LPRECT rcScreen, LPRECT rcCrop )
     return hBitmap;
 }
 
-//----------------------------------------------------------------------------
-//
-// AdjustToMoveBoundary
-//
-// Shifts to accomodate move boundary.
-//
-//----------------------------------------------------------------------------
-void AdjustToMoveBoundary( float zoomLevel, int *coordinate, int cursor, int size, int max )
-{
-    int diff = static_cast<int> (static_cast<float>(size)/ static_cast<float>(LIVEZOOM_MOVE_REGIONS));
-    if( cursor - *coordinate < diff ) 
-        *coordinate = max( 0, cursor - diff ); 
-    else if( (*coordinate + size) - cursor < diff ) 
-        *coordinate = min( cursor + diff - size, max - size );
-}
-
 //----------------------------------------------------------------------------
 //
 // GetZoomedTopLeftCoordinates
@@ -1260,13 +1262,10 @@ void AdjustToMoveBoundary( float zoomLevel, int *coordinate, int cursor, int siz
 //----------------------------------------------------------------------------
 void GetZoomedTopLeftCoordinates( float zoomLevel, POINT *cursorPos, int *x, int width, int *y, int height )
 {
-    // smoother and more natural zoom in
-    float scaledWidth = width/zoomLevel;
-    float scaledHeight = height/zoomLevel;
-    *x = max( 0, min( (int) (width - scaledWidth), (int) (cursorPos->x - (int) (((float) cursorPos->x/ (float) width)*scaledWidth))));
-    AdjustToMoveBoundary( zoomLevel, x, cursorPos->x, static_cast<int>(scaledWidth), width );
-    *y = max( 0, min( (int) (height - scaledHeight), (int) (cursorPos->y - (int) (((float) cursorPos->y/ (float) height)*scaledHeight))));
-    AdjustToMoveBoundary( zoomLevel, y, cursorPos->y, static_cast<int>(scaledHeight), height );
+    ZoomMath::Point topLeft = ZoomMath::GetZoomedTopLeft( zoomLevel, { cursorPos->x, cursorPos->y },
+                                                          width, height, LIVEZOOM_MOVE_REGIONS );
+    *x = topLeft.x;
+    *y = topLeft.y;
 }
 
 
@@ -2591,7 +2590,7 @@ void DrawTypingCursor( HWND hWnd, POINT *textPt, HDC hdcScreenCompat,
 		hdcScreenCompat, rc->left, rc->top, SRCCOPY|CAPTUREBLT );
 
 	DrawText( hdcScreenCompat, static_cast<PTCHAR>(&vKey), 1, rc, DT_LEFT );
-	InvalidateRect( hWnd, NULL, TRUE );
+	InvalidateScreenCompat( hWnd, NULL, TRUE );
 }
 
 //----------------------------------------------------------------------------
@@ -2603,13 +2602,13 @@ RECT BoundMouse( float zoomLevel, MONITORINFO *monInfo, int width, int height,
                     POINT *cursorPos )
 {
     RECT		rc;
-    int			x, y;
 
-    GetZoomedTopLeftCoordinates( zoomLevel, cursorPos, &x, width, &y, height );
-    rc.left = monInfo->rcMonitor.left + x; 
-    rc.right = rc.left + static_cast<int>(width/zoomLevel);
-    rc.top = monInfo->rcMonitor.top + y;
-    rc.bottom = rc.top + static_cast<int>(height/zoomLevel);
+    ZoomMath::Rect bounds = ZoomMath::GetZoomedBounds( zoomLevel, { cursorPos->x, cursorPos->y }, width, height,
+                                    { monInfo->rcMonitor.left, monInfo->rcMonitor.top }, LIVEZOOM_MOVE_REGIONS );
+    rc.left = bounds.left;
+    rc.right = bounds.right;
+    rc.top = bounds.top;
+    rc.bottom = bounds.bottom;
 
     OutputDebug( L"x: %d y: %d width: %d height: %d zoomLevel: %g\n",
         cursorPos->x, cursorPos->y, width, height, zoomLevel);
@@ -2931,7 +2930,7 @@ void InvalidateCursorMoveArea( HWND hWnd, float zoomLevel, int width, int height
     rc.right = static_cast<int>((max( prevPt.x, currentPt.x)+invWidth - x) * zoomLevel);
     rc.top = static_cast<int>(max( 0, (int) ((min( prevPt.y, currentPt.y)-invWidth - y) * zoomLevel)));
     rc.bottom = static_cast<int>((max( prevPt.y, currentPt.y)+invWidth -y) * zoomLevel);
-    InvalidateRect( hWnd, &rc, FALSE );
+    InvalidateScreenCompat( hWnd, &rc );
 
     OutputDebug( L"INVALIDATE: (%d, %d) - (%d, %d)\n", rc.left, rc.top, rc.right, rc.bottom);
 }
@@ -3681,6 +3680,7 @@ LRESULT APIENTRY MainWndProc(
     static float	zoomLevel;
     static float	zoomTelescopeStep;
     static float	zoomTelescopeTarget;
+    static DWORD	prevTelescopeTickCount = 0;
     static POINT	cursorPos;
     static POINT	savedCursorPos;
     static RECT		cursorRc;
@@ -4425,6 +4425,8 @@ LRESULT APIENTRY MainWndProc(
                     hdcScreenCompat = CreateCompatibleDC(hdcScreen); 
                     hdcScreenSaveCompat = CreateCompatibleDC(hdcScreen); 
                     hdcScreenCursorCompat = CreateCompatibleDC(hdcScreen); 
+                    g_ZoomScaler.InvalidateSource();
+                    g_FramePacer.Start( hWnd, WM_USER_VSYNC_FRAME );
 
                     // Determine what monitor we're on
                     GetCursorPos(&cursorPos);
@@ -4595,6 +4597,7 @@ LRESULT APIENTRY MainWndProc(
                             zoomLevel = static_cast<float>(1.0) * zoomTelescopeStep; 
                         else
                             zoomLevel = zoomTelescopeTarget;
+                        prevTelescopeTickCount = 0;
                         SetTimer( hWnd, 1, ZOOM_LEVEL_STEP_TIME, NULL );
                     }
 
@@ -4610,6 +4613,7 @@ LRESULT APIENTRY MainWndProc(
                         // Start telescoping zoom. 
                         zoomTelescopeStep = ZOOM_LEVEL_STEP_OUT;
                         zoomTelescopeTarget = 1.0;
+                        prevTelescopeTickCount = 0;
                         SetTimer( hWnd, 2, ZOOM_LEVEL_STEP_TIME, NULL );
 
                     } else {
@@ -4639,7 +4643,7 @@ LRESULT APIENTRY MainWndProc(
                 if (PopDrawUndo(hdcScreenCompat, &drawUndoList, width, height)) {
 
                     SaveCursorArea(hdcScreenCursorCompat, hdcScreenCompat, prevPt);
-                    InvalidateRect(hWnd, NULL, FALSE);
+                    InvalidateScreenCompat(hWnd);
                 }
             }
         } else if( g_PenDown && !penInverted) {
@@ -4673,6 +4677,7 @@ LRESULT APIENTRY MainWndProc(
             SendPenMessage(hWnd, WM_LBUTTONUP, lParam);
             SendPenMessage(hWnd, WM_MOUSEMOVE, lParam);
             PopDrawUndo(hdcScreenCompat, &drawUndoList, width, height);
+            g_ZoomScaler.InvalidateSource();
 
             // Enter tracing mode
             SendPenMessage(hWnd, WM_LBUTTONDOWN, lParam);
@@ -4744,8 +4749,11 @@ LRESULT APIENTRY MainWndProc(
 
                                 if( zoomLevel > zoomTelescopeTarget ) 
                                     zoomLevel = zoomTelescopeTarget;
-                                else
+                                else {
+
+                                    prevTelescopeTickCount = 0;
                                     SetTimer( hWnd, 1, ZOOM_LEVEL_STEP_TIME, NULL );
+                                }
                             }
 
                         } else if( zoomTelescopeTarget > ZOOM_LEVEL_MIN ) {
@@ -4775,6 +4783,7 @@ LRESULT APIENTRY MainWndProc(
                             }
                             else
                             {
+                                prevTelescopeTickCount = 0;
                                 SetTimer( hWnd, 1, ZOOM_LEVEL_STEP_TIME, NULL );
                             }
                         }
@@ -4790,7 +4799,7 @@ LRESULT APIENTRY MainWndProc(
                             //SetCursorPos( monInfo.rcMonitor.left + cursorPos.x, 
                             //		monInfo.rcMonitor.top + cursorPos.y );
                         }
-                        InvalidateRect( hWnd, NULL, FALSE );
+                        InvalidateScreenCompat( hWnd );
                     }				
                 }
             } else {
@@ -4889,7 +4898,7 @@ LRESULT APIENTRY MainWndProc(
                 DrawText( hdcScreenCompat, &vKey, 1, &rc, DT_LEFT|DT_NOPREFIX);
                 textPt.x += rc.right - rc.left;
             }
-            InvalidateRect( hWnd, NULL, TRUE );
+            InvalidateScreenCompat( hWnd, NULL, TRUE );
 
             // Save the key for undo
             P_TYPED_KEY newKey = static_cast<P_TYPED_KEY>(malloc( sizeof(TYPED_KEY) ));
@@ -5039,7 +5048,7 @@ LRESULT APIENTRY MainWndProc(
                             BitBlt(hdcScreenCompat, rect.left, rect.top, rect.right - rect.left,
                                 rect.bottom - rect.top, hdcScreenSaveCompat, rect.left, rect.top, SRCCOPY | CAPTUREBLT );
                         }
-                        InvalidateRect( hWnd, NULL, FALSE );
+                        InvalidateScreenCompat( hWnd );
 
                         textPt.x = rect.left;
                         textPt.y = rect.top;
@@ -5129,7 +5138,7 @@ LRESULT APIENTRY MainWndProc(
 
                     ClearTypingCursor( hdcScreenCompat, hdcScreenCursorCompat, cursorRc, g_BlankedScreen );
                     DrawTypingCursor( hWnd, &textPt, hdcScreenCompat, hdcScreenCursorCompat, &cursorRc );
-                    InvalidateRect( hWnd, NULL, FALSE );
+                    InvalidateScreenCompat( hWnd );
                 }
             }
             break;
@@ -5148,7 +5157,7 @@ LRESULT APIENTRY MainWndProc(
 
                         SaveCursorArea(hdcScreenCursorCompat, hdcScreenCompat, prevPt);
                     }
-                    InvalidateRect( hWnd, NULL, FALSE );
+                    InvalidateScreenCompat( hWnd );
                 }
             }
             break;
@@ -5189,7 +5198,7 @@ LRESULT APIENTRY MainWndProc(
                 rc.bottom = height;
                 rc.right = width;
                 BlankScreenArea( hdcScreenCompat, &rc, g_BlankedScreen );
-                InvalidateRect( hWnd, NULL, FALSE );
+                InvalidateScreenCompat( hWnd );
 
                 // Save area that's going to be occupied by new cursor position
                 SaveCursorArea( hdcScreenCursorCompat, hdcScreenCompat, prevPt );
@@ -5219,7 +5228,7 @@ LRESULT APIENTRY MainWndProc(
                         g_HaveDrawn = TRUE;
                     }
                 }
-                InvalidateRect( hWnd, NULL, FALSE );
+                InvalidateScreenCompat( hWnd );
                 g_BlankedScreen = FALSE;
             } 
             break;
@@ -5559,9 +5568,11 @@ LRESULT APIENTRY MainWndProc(
 
             } else {
 
+                // Panning; repaint once per display refresh rather than
+                // once per mouse message
                 cursorPos.x = LOWORD( lParam );
                 cursorPos.y = HIWORD( lParam );
-                InvalidateRect( hWnd, NULL, FALSE );
+                g_FramePacer.RequestFrame();
             }
         } else if( g_Zoomed && (g_TypeMode != TypeModeOff) && !g_HaveTyped ) {
 
@@ -5572,7 +5583,7 @@ LRESULT APIENTRY MainWndProc(
             // Draw the typing cursor
             DrawTypingCursor( hWnd, &textPt, hdcScreenCompat, hdcScreenCursorCompat, &cursorRc, true );
             prevPt = textPt;
-            InvalidateRect( hWnd, NULL, FALSE );
+            InvalidateScreenCompat( hWnd );
         }
 #if 0
         {
@@ -5706,7 +5717,7 @@ LRESULT APIENTRY MainWndProc(
                     path.AddLine(static_cast<INT>(prevPt.x), prevPt.y, prevPt.x, prevPt.y);
                     dstGraphics.DrawPath(&pen, &path);
                 }
-                InvalidateRect( hWnd, NULL, FALSE );
+                InvalidateScreenCompat( hWnd );
 
                 // If we're in live zoom, make the drawing pen larger to compensate
                 if( g_ZoomOnLiveZoom && forcePenResize )
@@ -5833,7 +5844,7 @@ LRESULT APIENTRY MainWndProc(
                 // Draw final one using Gdi+
                 DrawShape( g_DrawingShape, hdcScreenCompat, &g_rcRectangle, true );
 
-                InvalidateRect( hWnd, NULL, FALSE );
+                InvalidateScreenCompat( hWnd );
                 DeleteObject( hBrush );
                 SelectObject( hdcScreenCompat, oldHbrush );
 
@@ -5861,7 +5872,7 @@ LRESULT APIENTRY MainWndProc(
 
             g_TypeMode = TypeModeOff;
             ClearTypingCursor( hdcScreenCompat, hdcScreenCursorCompat, cursorRc, g_BlankedScreen );
-            InvalidateRect( hWnd, NULL, FALSE );
+            InvalidateScreenCompat( hWnd );
             DeleteTypedText( &typedKeyList );
 
             // 1 means don't reset the cursor. We get that for font resizing
@@ -5940,6 +5951,14 @@ LRESULT APIENTRY MainWndProc(
         StopRecording();
         break;
 
+    case WM_USER_VSYNC_FRAME:
+        g_FramePacer.FramePresented();
+        if( g_Zoomed )
+        {
+            InvalidateRect( hWnd, NULL, FALSE );
+        }
+        break;
+
     case WM_USER_SAVE_CURSOR:
         if( g_Zoomed == TRUE )
         {
@@ -5982,7 +6001,7 @@ LRESULT APIENTRY MainWndProc(
                     RestoreCursorArea( hdcScreenCompat, hdcScreenCursorCompat, prevPt );
 
                     // Ensure the cursor area is painted before returning
-                    InvalidateRect( hWnd, NULL, FALSE );
+                    InvalidateScreenCompat( hWnd );
                     UpdateWindow( hWnd );
 
                     // Make the magnified cursor visible again if LiveDraw is on in LiveZoom
@@ -6513,11 +6532,15 @@ LRESULT APIENTRY MainWndProc(
             //
             if( zoomTelescopeStep ) {
 
-                zoomLevel *= zoomTelescopeStep;
-                if( (zoomTelescopeStep > 1 && zoomLevel >= zoomTelescopeTarget ) ||
-                    (zoomTelescopeStep < 1 && zoomLevel <= zoomTelescopeTarget )) {
+                // Step by elapsed time rather than per tick so the animation
+                // runs at the same speed when timer messages are delayed
+                DWORD curTickCount = GetTickCount();
+                DWORD elapsed = prevTelescopeTickCount ? curTickCount - prevTelescopeTickCount : ZOOM_LEVEL_STEP_TIME;
+                prevTelescopeTickCount = curTickCount;
+                if( ZoomMath::AdvanceTelescope( zoomLevel, zoomTelescopeStep, zoomTelescopeTarget,
+                                                elapsed, ZOOM_LEVEL_STEP_TIME )) {
 
-                    zoomLevel = zoomTelescopeTarget;
+                    prevTelescopeTickCount = 0;
                     KillTimer( hWnd, wParam );
                     OutputDebug( L"SETCURSOR mon_left: %x mon_top: %x x: %d y: %d\n",
                             monInfo.rcMonitor.left, monInfo.rcMonitor.top, cursorPos.x, cursorPos.y );
@@ -6528,6 +6551,7 @@ LRESULT APIENTRY MainWndProc(
             } else {
 
                 // Case where we didn't zoom at all
+                prevTelescopeTickCount = 0;
                 KillTimer( hWnd, wParam );
             }
             if( wParam == 2 && zoomLevel == 1 ) {
@@ -6547,9 +6571,10 @@ LRESULT APIENTRY MainWndProc(
                         cursorPos = prevPt;
                     }
                     OutputDebug(L"FINAL MOUSE: x: %d y: %d\n", cursorPos.x, cursorPos.y );
-                    GetZoomedTopLeftCoordinates(zoomLevel, &cursorPos, &x, width, &y, height);
-                    cursorPos.x = monInfo.rcMonitor.left + x + static_cast<int>((cursorPos.x - x) * zoomLevel);
-                    cursorPos.y = monInfo.rcMonitor.top + y + static_cast<int>((cursorPos.y - y) * zoomLevel);		
+                    ZoomMath::Point screenPos = ZoomMath::ZoomedToScreen( zoomLevel, { cursorPos.x, cursorPos.y }, width, height,
+                                                    { monInfo.rcMonitor.left, monInfo.rcMonitor.top }, LIVEZOOM_MOVE_REGIONS );
+                    cursorPos.x = screenPos.x;
+                    cursorPos.y = screenPos.y;
                     SetCursorPos(cursorPos.x, cursorPos.y);
                 }
                 if( hTargetWindow ) {
@@ -6560,6 +6585,8 @@ LRESULT APIENTRY MainWndProc(
                     hTargetWindow = NULL;
                 }
                 DeleteDrawUndoList( &drawUndoList );
+                g_FramePacer.Stop();
+                g_ZoomScaler.Reset();
 
                 // Restore live zoom if we came from that mode
                 if( g_ZoomOnLiveZoom ) {
@@ -6643,18 +6670,36 @@ LRESULT APIENTRY MainWndProc(
                         SRCCOPY); 
             }
 #else
+            // Scale from the GPU copy of the capture while it isn't being
+            // drawn on; drawing and typing modify hdcScreenCompat on every
+            // message, so those stay on GDI and force a re-upload afterwards.
+            RECT dstRc = { 0, 0, bmp.bmWidth, bmp.bmHeight };
+            BOOLEAN scaled = FALSE;
+            if( g_Drawing || g_TypeMode != TypeModeOff ) {
+
+                g_ZoomScaler.InvalidateSource();
+
+            } else {
+
+                scaled = g_ZoomScaler.Draw( ps.hdc, dstRc, hdcScreenCompat, { bmp.bmWidth, bmp.bmHeight },
+                            static_cast<float>(x), static_cast<float>(y), width/zoomLevel, height/zoomLevel,
+                            zoomLevel == zoomTelescopeTarget ? ZoomScaler::Quality::High : ZoomScaler::Quality::Fast );
+            }
+            if( !scaled ) {
+
 #if SCALE_HALFTONE
-            SetStretchBltMode( hDc, zoomLevel == zoomTelescopeTarget ? HALFTONE : COLORONCOLOR );
+                SetStretchBltMode( hDc, zoomLevel == zoomTelescopeTarget ? HALFTONE : COLORONCOLOR );
 #else
-            SetStretchBltMode( hDc, COLORONCOLOR );
+                SetStretchBltMode( hDc, COLORONCOLOR );
 #endif
-            StretchBlt( ps.hdc, 
-                    0, 0, 
-                    bmp.bmWidth, bmp.bmHeight, 
-                    hdcScreenCompat, 
-                    x, y, 
-                    static_cast<int>(width/zoomLevel), static_cast<int>(height/zoomLevel),
-                    SRCCOPY|CAPTUREBLT ); 
+                StretchBlt( ps.hdc, 
+                        0, 0, 
+                        bmp.bmWidth, bmp.bmHeight, 
+                        hdcScreenCompat, 
+                        x, y, 
+                        static_cast<int>(width/zoomLevel), static_cast<int>(height/zoomLevel),
+                        SRCCOPY|CAPTUREBLT ); 
+            }
 #endif
         } else if( g_TimerActive ) {
 
@@ -7034,22 +7079,14 @@ LRESULT CALLBACK LiveZoomWndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM
                 if( zoomCenterPos.x == 0 )
                     zoomCenterPos.x = lastSourceRect.left + sourceRectWidth/2;
 
-                int zoomWidth = static_cast<int>(width / zoomLevel);
-                int zoomHeight = static_cast<int>(height/ zoomLevel);
-                sourceRect.left = zoomCenterPos.x - zoomWidth / 2;
-                sourceRect.top = zoomCenterPos.y -  zoomHeight / 2;
-
                 // Don't scroll outside desktop area.
-                if (sourceRect.left < monInfo.rcMonitor.left) 
-                    sourceRect.left = monInfo.rcMonitor.left;
-                else if (sourceRect.left > monInfo.rcMonitor.right - zoomWidth )
-                    sourceRect.left = monInfo.rcMonitor.right - zoomWidth;
-                sourceRect.right = sourceRect.left + zoomWidth;
-                if (sourceRect.top < monInfo.rcMonitor.top) 
-                    sourceRect.top = monInfo.rcMonitor.top;
-                else if (sourceRect.top > monInfo.rcMonitor.bottom - zoomHeight) 
-                    sourceRect.top = monInfo.rcMonitor.bottom - zoomHeight;
-                sourceRect.bottom = sourceRect.top + zoomHeight;
+                ZoomMath::Rect clamped = ZoomMath::ClampSourceRect( { zoomCenterPos.x, zoomCenterPos.y },
+                                    static_cast<int>(width / zoomLevel), static_cast<int>(height / zoomLevel),
+                                    { monInfo.rcMonitor.left, monInfo.rcMonitor.top, monInfo.rcMonitor.right, monInfo.rcMonitor.bottom } );
+                sourceRect.left = clamped.left;
+                sourceRect.top = clamped.top;
+                sourceRect.right = clamped.right;
+                sourceRect.bottom = clamped.bottom;
 
                 if( g_ZoomOnLiveZoom ) {
 
@@ -7422,6 +7459,7 @@ int APIENTRY wWinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance
     if( !ShowEula( APPNAME, NULL, NULL )) return 1;
 
 #ifdef __ZOOMIT_POWERTOYS__
+    powertoys_gpo::watchPolicyChanges();
     if (powertoys_gpo::getConfiguredZoomItEnabledValue() == powertoys_gpo::gpo_rule_configured_disabled)
     {
         Logger::warn(L"Tried to start with a GPO policy setting the utility to always be disabled. Please contact your systems administrator.");
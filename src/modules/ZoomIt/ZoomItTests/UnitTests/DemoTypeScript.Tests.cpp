@@ -0,0 +1,190 @@
+#include "pch.h"
+#include <modules/ZoomIt/ZoomIt/DemoTypeScript.h>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace DemoTypeScript;
+
+namespace ZoomItUnitTests
+{
+    namespace
+    {
+        std::wstring Escape(const std::wstring& text)
+        {
+            std::wstring escaped;
+            for (const wchar_t c : text)
+            {
+                if (c == L'\n')
+                {
+                    escaped += L"\\n";
+                }
+                else if (c == L'\t')
+                {
+                    escaped += L"\\t";
+                }
+                else
+                {
+                    escaped += c;
+                }
+            }
+            return escaped;
+        }
+
+        // One line per token: the type, the position in the script and what gets injected
+        std::wstring Describe(const Plan& plan)
+        {
+            static const wchar_t* keys[] = { L"none", L"enter", L"up", L"down", L"left", L"right" };
+
+            std::wstring description;
+            for (const auto& token : plan.tokens)
+            {
+                const auto position = L" " + std::to_wstring(token.offset) + L"+" + std::to_wstring(token.length);
+                switch (token.type)
+                {
+                case TokenType::Text:
+                    description += L"text" + position + L" \"" + Escape(token.text) + L"\"";
+                    break;
+                case TokenType::AutoFormat:
+                    description += (token.newline ? L"newline" : L"format") + position + L" \"" + Escape(token.text) + L"\"";
+                    break;
+                case TokenType::Key:
+                    description += L"key" + position + L" " + keys[static_cast<int>(token.key)];
+                    break;
+                case TokenType::Pause:
+                    description += L"pause" + position + L" " + std::to_wstring(token.pauseSeconds);
+                    break;
+                case TokenType::Paste:
+                    description += L"paste" + position + L" \"" + Escape(token.text) + L"\"";
+                    break;
+                case TokenType::End:
+                    description += L"end" + position;
+                    break;
+                }
+                description += L"\n";
+            }
+            return description;
+        }
+    }
+
+    TEST_CLASS (DemoTypeScriptUnitTests)
+    {
+    public:
+        TEST_METHOD (CleanDropsUnsupportedCharacters)
+        {
+            Assert::AreEqual(std::wstring(L"abc\ndef\tg"), Clean(L"\nabc\r\ndef\tg\x01"));
+        }
+
+        TEST_METHOD (CleanTrimsNewlinesAroundControls)
+        {
+            Assert::AreEqual(std::wstring(L"abc[end]xyz"), Clean(L"abc\n[end]\nxyz"));
+            Assert::AreEqual(std::wstring(L"[paste]line1\nline2[/paste]"), Clean(L"[paste]\nline1\nline2\n[/paste]"));
+
+            // Only one newline on each side
+            Assert::AreEqual(std::wstring(L"a\n[end]\nb"), Clean(L"a\n\n[end]\n\nb"));
+
+            // Whitespace after the last [end] isn't typed
+            Assert::AreEqual(std::wstring(L"a[end]"), Clean(L"a\n[end]\n  \n"));
+            Assert::AreEqual(std::wstring(L"a[end] b"), Clean(L"a[end] b"));
+        }
+
+        TEST_METHOD (PlainText)
+        {
+            Assert::AreEqual(std::wstring(L"text 0+6 \"int x;\"\n"), Describe(Compile(L"int x;")));
+            Assert::AreEqual(std::wstring(), Describe(Compile(L"")));
+        }
+
+        TEST_METHOD (AutoFormatTriggers)
+        {
+            Assert::AreEqual(std::wstring(L"text 0+1 \"f\"\n"
+                                          L"format 1+1 \"(\"\n"
+                                          L"text 2+2 \"a)\"\n"
+                                          L"format 4+1 \"{\"\n"
+                                          L"text 5+2 \" /\"\n"
+                                          L"format 7+1 \"*\"\n"),
+                             Describe(Compile(L"f(a){ /*")));
+        }
+
+        TEST_METHOD (IndentationIsOneChunk)
+        {
+            // With the first printable character of the line
+            Assert::AreEqual(std::wstring(L"text 0+1 \"a\"\n"
+                                          L"newline 1+1 \"\\n\"\n"
+                                          L"format 2+4 \"\\t  b\"\n"
+                                          L"text 6+1 \"c\"\n"),
+                             Describe(Compile(L"a\n\t  bc")));
+
+            // But not with a '[', which can start a control
+            Assert::AreEqual(std::wstring(L"newline 0+1 \"\\n\"\n"
+                                          L"format 1+2 \"  \"\n"
+                                          L"key 3+7 enter\n"),
+                             Describe(Compile(L"\n  [enter]")));
+        }
+
+        TEST_METHOD (Controls)
+        {
+            Assert::AreEqual(std::wstring(L"text 0+1 \"a\"\n"
+                                          L"key 1+7 enter\n"
+                                          L"pause 8+9 2\n"
+                                          L"text 17+1 \"b\"\n"
+                                          L"pause 18+9 0\n"
+                                          L"end 27+5\n"
+                                          L"key 32+4 up\n"
+                                          L"key 36+6 down\n"
+                                          L"key 42+6 left\n"
+                                          L"key 48+7 right\n"),
+                             Describe(Compile(L"a[enter][pause:2]b[pause:x][end][up][down][left][right]")));
+        }
+
+        TEST_METHOD (UnknownControlsAreTyped)
+        {
+            Assert::AreEqual(std::wstring(L"format 0+1 \"[\"\n"
+                                          L"text 1+8 \"notakey]\"\n"),
+                             Describe(Compile(L"[notakey]")));
+
+            // Too long to be a control
+            Assert::AreEqual(std::wstring(L"format 0+1 \"[\"\n"
+                                          L"text 1+12 \"pause:10000]\"\n"),
+                             Describe(Compile(L"[pause:10000]")));
+        }
+
+        TEST_METHOD (PasteBlocks)
+        {
+            Assert::AreEqual(std::wstring(L"paste 0+19 \"x{y}\"\n"
+                                          L"text 19+1 \"z\"\n"),
+                             Describe(Compile(L"[paste]x{y}[/paste]z")));
+
+            // Without the end it's typed
+            Assert::AreEqual(std::wstring(L"format 0+1 \"[\"\n"
+                                          L"text 1+7 \"paste]x\"\n"),
+                             Describe(Compile(L"[paste]x")));
+        }
+
+        TEST_METHOD (SegmentsStartWithoutPreviousCharacter)
+        {
+            // The space after [end] doesn't follow the newline of the previous segment
+            Assert::AreEqual(std::wstring(L"text 0+1 \"a\"\n"
+                                          L"newline 1+1 \"\\n\"\n"
+                                          L"end 2+5\n"
+                                          L"text 7+2 \" b\"\n"),
+                             Describe(Compile(L"a\n[end] b")));
+        }
+
+        TEST_METHOD (ScriptPositions)
+        {
+            const auto plan = Compile(L"ab[end]cd[end]");
+            Assert::AreEqual(size_t{ 4 }, plan.tokens.size());
+
+            Assert::AreEqual(size_t{ 0 }, plan.TokenAt(0));
+            Assert::AreEqual(size_t{ 0 }, plan.TokenAt(1));
+            Assert::AreEqual(size_t{ 1 }, plan.TokenAt(3));
+            Assert::AreEqual(size_t{ 2 }, plan.TokenAt(7));
+            Assert::AreEqual(size_t{ 3 }, plan.TokenAt(13));
+            Assert::AreEqual(plan.tokens.size(), plan.TokenAt(14));
+
+            Assert::AreEqual(size_t{ 7 }, plan.NextSegment(0));
+            Assert::AreEqual(size_t{ 7 }, plan.NextSegment(2));
+            Assert::AreEqual(size_t{ 14 }, plan.NextSegment(7));
+            Assert::AreEqual(std::wstring::npos, plan.NextSegment(10));
+            Assert::AreEqual(std::wstring::npos, plan.NextSegment(14));
+        }
+    };
+}
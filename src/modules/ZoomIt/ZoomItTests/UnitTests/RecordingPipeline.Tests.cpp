@@ -0,0 +1,264 @@
+#include "pch.h"
+#include <modules/ZoomIt/ZoomIt/RecordingPipeline.h>
+
+#include <thread>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace RecordingPipeline;
+
+namespace ZoomItUnitTests
+{
+    namespace
+    {
+        Timestamp CaptureTime(int64_t frame, int64_t refreshRate)
+        {
+            return frame * TicksPerSecond / refreshRate;
+        }
+
+        struct SimulationResult
+        {
+            uint64_t captured = 0;
+            uint64_t accepted = 0;
+            uint64_t encoded = 0;
+            Timestamp lastEncoded = -1;
+            QueueStats queue;
+            LatencyTracker latency;
+        };
+
+        // Capture at the refresh rate, paced to the recording frame rate, into a queue of three frames which an
+        // encoder taking encodeTime per frame drains. Runs on simulated time, the encoder starts a frame as soon as
+        // it's done with the previous one and the queue isn't empty.
+        void Simulate(SimulationResult& result, int64_t refreshRate, uint32_t framesPerSecond, Timestamp encodeTime, Timestamp duration)
+        {
+            FrameRateLimiter limiter{ framesPerSecond };
+            SampleQueue<int64_t> queue{ 3, DropPolicy::DropOldest };
+            Timestamp encoderFree = 0;
+
+            auto encodeUntil = [&](Timestamp now) {
+                while (encoderFree <= now)
+                {
+                    const auto entry = queue.TryPop();
+                    if (!entry)
+                    {
+                        break;
+                    }
+
+                    // Frames are encoded in capture order
+                    Assert::IsTrue(entry->timestamp > result.lastEncoded);
+                    result.lastEncoded = entry->timestamp;
+
+                    const Timestamp start = (std::max)(encoderFree, entry->timestamp);
+                    result.latency.Add(std::chrono::microseconds{ (start - entry->timestamp) / 10 });
+                    encoderFree = start + encodeTime;
+                    result.encoded++;
+                }
+            };
+
+            for (int64_t frame = 0; CaptureTime(frame, refreshRate) < duration; frame++)
+            {
+                const Timestamp now = CaptureTime(frame, refreshRate);
+                encodeUntil(now);
+
+                result.captured++;
+                if (limiter.Accept(now))
+                {
+                    result.accepted++;
+                    queue.Push(frame, now);
+                }
+            }
+            encodeUntil(duration);
+            result.queue = queue.Stats();
+        }
+    }
+
+    TEST_CLASS (RecordingPipelineUnitTests)
+    {
+    public:
+        TEST_METHOD (LimiterThinsCaptureToTheFrameRate)
+        {
+            for (const int64_t refreshRate : { 60, 120, 144, 165, 240 })
+            {
+                FrameRateLimiter limiter{ 30 };
+                uint64_t accepted = 0;
+                Timestamp previous = -1;
+                for (int64_t frame = 0; frame < refreshRate * 10; frame++)
+                {
+                    const auto timestamp = CaptureTime(frame, refreshRate);
+                    if (limiter.Accept(timestamp))
+                    {
+                        // Never closer than half an interval, and no gap of more than an interval and a capture frame
+                        if (previous >= 0)
+                        {
+                            Assert::IsTrue(timestamp - previous >= TicksPerSecond / 60);
+                            Assert::IsTrue(timestamp - previous <= TicksPerSecond / 30 + TicksPerSecond / refreshRate);
+                        }
+                        previous = timestamp;
+                        accepted++;
+                    }
+                }
+
+                // The last one is the frame due at 10 s, which is accepted up to half an interval early
+                Assert::AreEqual(uint64_t{ 301 }, accepted);
+            }
+        }
+
+        TEST_METHOD (LimiterRestartsAfterAStall)
+        {
+            FrameRateLimiter limiter{ 10 };
+            Assert::IsTrue(limiter.Accept(0));
+            Assert::IsFalse(limiter.Accept(TicksPerSecond / 100));
+
+            // Nothing for a second, the grid starts again from the next frame instead of accepting a burst
+            Assert::IsTrue(limiter.Accept(TicksPerSecond + 1));
+            Assert::IsFalse(limiter.Accept(TicksPerSecond + TicksPerSecond / 100));
+            Assert::IsTrue(limiter.Accept(TicksPerSecond + TicksPerSecond / 10 + 1));
+        }
+
+        TEST_METHOD (LimiterWithoutFrameRateAcceptsAll)
+        {
+            FrameRateLimiter limiter{ 0 };
+            for (Timestamp timestamp = 0; timestamp < 100; timestamp++)
+            {
+                Assert::IsTrue(limiter.Accept(timestamp));
+            }
+        }
+
+        TEST_METHOD (DropOldestHandsBackTheOldest)
+        {
+            SampleQueue<int> queue{ 2, DropPolicy::DropOldest };
+            Assert::IsFalse(queue.Push(1, 10).has_value());
+            Assert::IsFalse(queue.Push(2, 20).has_value());
+
+            const auto dropped = queue.Push(3, 30);
+            Assert::IsTrue(dropped.has_value());
+            Assert::AreEqual(1, dropped->sample);
+            Assert::AreEqual(Timestamp{ 10 }, dropped->timestamp);
+
+            Assert::AreEqual(2, queue.TryPop()->sample);
+            Assert::AreEqual(3, queue.TryPop()->sample);
+            Assert::IsFalse(queue.TryPop().has_value());
+
+            const auto stats = queue.Stats();
+            Assert::AreEqual(uint64_t{ 3 }, stats.pushed);
+            Assert::AreEqual(uint64_t{ 2 }, stats.popped);
+            Assert::AreEqual(uint64_t{ 1 }, stats.dropped);
+            Assert::AreEqual(size_t{ 0 }, stats.depth);
+            Assert::AreEqual(size_t{ 2 }, stats.maxDepth);
+        }
+
+        TEST_METHOD (DropNewestRejectsThePush)
+        {
+            SampleQueue<int> queue{ 1, DropPolicy::DropNewest };
+            Assert::IsFalse(queue.Push(1, 10).has_value());
+            Assert::AreEqual(2, queue.Push(2, 20)->sample);
+            Assert::AreEqual(1, queue.TryPop()->sample);
+        }
+
+        TEST_METHOD (ClosedQueueDrainsThenStops)
+        {
+            SampleQueue<int> queue{ 4, DropPolicy::DropOldest };
+            queue.Push(1, 10);
+            queue.Close();
+            Assert::IsTrue(queue.IsClosed());
+
+            // Pushes after closing are dropped, what was queued can still be popped
+            Assert::AreEqual(2, queue.Push(2, 20)->sample);
+            Assert::AreEqual(1, queue.Pop()->sample);
+            Assert::IsFalse(queue.Pop().has_value());
+            Assert::AreEqual(uint64_t{ 1 }, queue.Stats().dropped);
+        }
+
+        TEST_METHOD (EncoderKeepingUp)
+        {
+            // 144 Hz capture recorded at 30 fps, the encoder needs 10 ms a frame
+            SimulationResult result;
+            Simulate(result, 144, 30, TicksPerSecond / 100, 10 * TicksPerSecond);
+
+            Assert::AreEqual(uint64_t{ 1440 }, result.captured);
+            Assert::AreEqual(uint64_t{ 301 }, result.accepted);
+            Assert::AreEqual(result.accepted, result.encoded);
+            Assert::AreEqual(uint64_t{ 0 }, result.queue.dropped);
+            Assert::AreEqual(size_t{ 1 }, result.queue.maxDepth);
+            Assert::IsTrue(result.latency.Max() == std::chrono::microseconds::zero());
+        }
+
+        TEST_METHOD (EncoderFallingBehind)
+        {
+            // 144 Hz capture recorded at 60 fps, the encoder only manages 40 frames a second
+            SimulationResult result;
+            Simulate(result, 144, 60, TicksPerSecond / 40, 10 * TicksPerSecond);
+
+            Assert::AreEqual(uint64_t{ 601 }, result.accepted);
+
+            // Every accepted frame is encoded, dropped or still queued
+            Assert::AreEqual(result.accepted, result.queue.pushed);
+            Assert::AreEqual(result.encoded, result.queue.popped);
+            Assert::AreEqual(result.accepted, result.encoded + result.queue.dropped + result.queue.depth);
+            Assert::IsTrue(result.queue.dropped > 0);
+            Assert::AreEqual(size_t{ 3 }, result.queue.maxDepth);
+
+            // The encoder runs at its own rate, and the dropped frames keep the latency bounded by the queue
+            Assert::IsTrue(result.encoded >= 399 && result.encoded <= 401);
+            Assert::IsTrue(result.latency.Max() <= std::chrono::microseconds{ 3 * 25'000 });
+        }
+
+        TEST_METHOD (FullQueueWhileTheEncoderHoldsAFrame)
+        {
+            // The buffers of the frame pool, capture needs a free one for every frame
+            size_t freeBuffers = FramePoolSize(3);
+            auto capture = [&freeBuffers] {
+                Assert::IsTrue(freeBuffers > 0);
+                freeBuffers--;
+            };
+
+            SampleQueue<int> queue{ 3, DropPolicy::DropOldest };
+            capture();
+            queue.Push(0, 0);
+            const auto held = queue.Pop();
+            Assert::AreEqual(0, held->sample);
+
+            // The encoder doesn't let go of its frame while capture fills the queue and keeps going
+            for (int frame = 1; frame <= 10; frame++)
+            {
+                capture();
+                if (const auto dropped = queue.Push(frame, frame))
+                {
+                    Assert::AreEqual(frame - 3, dropped->sample);
+                    freeBuffers++;
+                }
+                Assert::AreEqual(FramePoolSize(3) - 1 - queue.Stats().depth, freeBuffers);
+            }
+
+            // Capture got every frame, the newest ones are queued
+            Assert::AreEqual(size_t{ 3 }, queue.Stats().depth);
+            Assert::AreEqual(uint64_t{ 7 }, queue.Stats().dropped);
+            Assert::AreEqual(8, queue.TryPop()->sample);
+        }
+
+        TEST_METHOD (ProducerAndConsumerThreads)
+        {
+            SampleQueue<int> queue{ 8, DropPolicy::DropOldest };
+            uint64_t dropped = 0;
+            std::thread producer([&] {
+                for (int i = 0; i < 10000; i++)
+                {
+                    dropped += queue.Push(i, i).has_value();
+                }
+                queue.Close();
+            });
+
+            uint64_t popped = 0;
+            int previous = -1;
+            while (const auto entry = queue.Pop())
+            {
+                Assert::IsTrue(entry->sample > previous);
+                previous = entry->sample;
+                popped++;
+            }
+            producer.join();
+
+            Assert::AreEqual(uint64_t{ 10000 }, popped + dropped);
+            Assert::AreEqual(dropped, queue.Stats().dropped);
+        }
+    };
+}
@@ -0,0 +1,130 @@
+#include "pch.h"
+#include <modules/ZoomIt/ZoomIt/ZoomMath.h>
+
+#include <cmath>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace ZoomItUnitTests
+{
+    namespace
+    {
+        constexpr int width = 1920;
+        constexpr int height = 1080;
+        constexpr int moveRegions = 8;
+
+        bool Near(float a, float b)
+        {
+            return std::fabs(a - b) < 1e-4f;
+        }
+    }
+
+    TEST_CLASS (ZoomMathUnitTests)
+    {
+    public:
+        TEST_METHOD (ZoomedTopLeftFollowsTheCursor)
+        {
+            const auto center = ZoomMath::GetZoomedTopLeft(2.0f, { 960, 540 }, width, height, moveRegions);
+            Assert::AreEqual(480, center.x);
+            Assert::AreEqual(270, center.y);
+
+            // Kept on the monitor in the corners
+            const auto topLeft = ZoomMath::GetZoomedTopLeft(2.0f, { 0, 0 }, width, height, moveRegions);
+            Assert::AreEqual(0, topLeft.x);
+            Assert::AreEqual(0, topLeft.y);
+
+            const auto bottomRight = ZoomMath::GetZoomedTopLeft(2.0f, { width - 1, height - 1 }, width, height, moveRegions);
+            Assert::AreEqual(width / 2, bottomRight.x);
+            Assert::AreEqual(height / 2, bottomRight.y);
+        }
+
+        TEST_METHOD (MoveBoundaryKeepsTheCursorInside)
+        {
+            // The cursor entered the outer eighth of a 960 wide zoomed area on the left and on the right
+            Assert::AreEqual(380, ZoomMath::AdjustToMoveBoundary(480, 500, 960, width, moveRegions));
+            Assert::AreEqual(540, ZoomMath::AdjustToMoveBoundary(480, 1380, 960, width, moveRegions));
+
+            // Not past the edges of the monitor
+            Assert::AreEqual(0, ZoomMath::AdjustToMoveBoundary(10, 50, 960, width, moveRegions));
+            Assert::AreEqual(960, ZoomMath::AdjustToMoveBoundary(950, 1900, 960, width, moveRegions));
+
+            // Nothing to do away from the boundary
+            Assert::AreEqual(480, ZoomMath::AdjustToMoveBoundary(480, 960, 960, width, moveRegions));
+        }
+
+        TEST_METHOD (BoundsAndScreenPositionsAreOnTheMonitor)
+        {
+            const ZoomMath::Point origin{ 100, 200 };
+            const auto bounds = ZoomMath::GetZoomedBounds(2.0f, { 960, 540 }, width, height, origin, moveRegions);
+            Assert::AreEqual(580, bounds.left);
+            Assert::AreEqual(470, bounds.top);
+            Assert::AreEqual(1540, bounds.right);
+            Assert::AreEqual(1010, bounds.bottom);
+
+            const auto screen = ZoomMath::ZoomedToScreen(2.0f, { 960, 540 }, width, height, origin, moveRegions);
+            Assert::AreEqual(100 + 1440, screen.x);
+            Assert::AreEqual(200 + 810, screen.y);
+
+            const auto corner = ZoomMath::ZoomedToScreen(2.0f, { 0, 0 }, width, height, origin, moveRegions);
+            Assert::AreEqual(origin.x, corner.x);
+            Assert::AreEqual(origin.y, corner.y);
+        }
+
+        TEST_METHOD (SourceRectStaysOnTheMonitor)
+        {
+            const ZoomMath::Rect monitor{ 0, 0, width, height };
+
+            const auto inside = ZoomMath::ClampSourceRect({ 960, 540 }, 100, 50, monitor);
+            Assert::AreEqual(910, inside.left);
+            Assert::AreEqual(515, inside.top);
+            Assert::AreEqual(1010, inside.right);
+            Assert::AreEqual(565, inside.bottom);
+
+            const auto topLeft = ZoomMath::ClampSourceRect({ 10, 10 }, 100, 50, monitor);
+            Assert::AreEqual(0, topLeft.left);
+            Assert::AreEqual(0, topLeft.top);
+            Assert::AreEqual(100, topLeft.right);
+            Assert::AreEqual(50, topLeft.bottom);
+
+            const auto bottomRight = ZoomMath::ClampSourceRect({ 1915, 1075 }, 100, 50, monitor);
+            Assert::AreEqual(1820, bottomRight.left);
+            Assert::AreEqual(1030, bottomRight.top);
+            Assert::AreEqual(width, bottomRight.right);
+            Assert::AreEqual(height, bottomRight.bottom);
+        }
+
+        TEST_METHOD (TelescopeStepsByElapsedTime)
+        {
+            float zoomLevel = 1.0f;
+            Assert::IsFalse(ZoomMath::AdvanceTelescope(zoomLevel, 2.0f, 8.0f, 20, 20));
+            Assert::IsTrue(Near(2.0f, zoomLevel));
+
+            Assert::IsFalse(ZoomMath::AdvanceTelescope(zoomLevel, 2.0f, 8.0f, 20, 20));
+            Assert::IsTrue(Near(4.0f, zoomLevel));
+
+            // Timer messages which come late catch up, the same time in two steps gets as far
+            float split = 1.0f;
+            ZoomMath::AdvanceTelescope(split, 2.0f, 8.0f, 10, 20);
+            ZoomMath::AdvanceTelescope(split, 2.0f, 8.0f, 30, 20);
+            Assert::IsTrue(Near(4.0f, split));
+
+            // And doesn't overshoot the target
+            Assert::IsTrue(ZoomMath::AdvanceTelescope(zoomLevel, 2.0f, 8.0f, 1000, 20));
+            Assert::AreEqual(8.0f, zoomLevel);
+        }
+
+        TEST_METHOD (TelescopeZoomsOut)
+        {
+            float zoomLevel = 4.0f;
+            Assert::IsFalse(ZoomMath::AdvanceTelescope(zoomLevel, 0.5f, 1.0f, 20, 20));
+            Assert::IsTrue(Near(2.0f, zoomLevel));
+            Assert::IsTrue(ZoomMath::AdvanceTelescope(zoomLevel, 0.5f, 1.0f, 100, 20));
+            Assert::AreEqual(1.0f, zoomLevel);
+
+            // A step which can't get anywhere goes to the target right away
+            zoomLevel = 3.0f;
+            Assert::IsTrue(ZoomMath::AdvanceTelescope(zoomLevel, 1.0f, 1.0f, 20, 20));
+            Assert::AreEqual(1.0f, zoomLevel);
+        }
+    };
+}
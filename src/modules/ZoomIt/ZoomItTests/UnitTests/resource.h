@@ -0,0 +1,13 @@
+//{{NO_DEPENDENCIES}}
+// Microsoft Visual C++ generated include file.
+// Used by UnitTests-ZoomIt.rc
+
+//////////////////////////////
+// Non-localizable
+
+#define FILE_DESCRIPTION "PowerToys UnitTests-ZoomIt"
+#define INTERNAL_NAME "UnitTests-ZoomIt"
+#define ORIGINAL_FILENAME "UnitTests-ZoomIt.dll"
+
+// Non-localizable
+//////////////////////////////
@@ -28,7 +28,7 @@ bool isExcluded(HWND window)
     auto processPath = get_process_path(window);
     CharUpperBuffW(processPath.data(), static_cast<DWORD>(processPath.length()));
 
-    return check_excluded_app(window, processPath, AlwaysOnTopSettings::settings().excludedApps);
+    return check_excluded_app(window, processPath, AlwaysOnTopSettings::settings().excludedAppsMatcher);
 }
 
 AlwaysOnTop::AlwaysOnTop(bool useLLKH, DWORD mainThreadId) :
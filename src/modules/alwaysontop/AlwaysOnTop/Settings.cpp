@@ -195,6 +195,7 @@ void AlwaysOnTopSettings::LoadSettings()
             if (m_settings.excludedApps != excludedApps)
             {
                 m_settings.excludedApps = excludedApps;
+                m_settings.excludedAppsMatcher = ExcludedAppsMatcher(excludedApps);
                 NotifyObservers(SettingId::ExcludeApps);
             }
         }
@@ -4,6 +4,7 @@
 
 #include <common/SettingsAPI/FileWatcher.h>
 #include <common/SettingsAPI/settings_objects.h>
+#include <common/utils/excluded_apps.h>
 
 #include <SettingsConstants.h>
 
@@ -24,6 +25,7 @@ struct Settings
     int frameOpacity = 100;
     COLORREF frameColor = RGB(0, 173, 239);
     std::vector<std::wstring> excludedApps{};
+    ExcludedAppsMatcher excludedAppsMatcher;
 };
 
 class AlwaysOnTopSettings
@@ -31,8 +31,9 @@ int WINAPI wWinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance,
     trace.UpdateState(true);
 
     winrt::init_apartment();
-    LoggerHelpers::init_logger(moduleName, internalPath, LogSettings::fancyZonesLoggerName);
+    LoggerHelpers::init_logger(moduleName, internalPath, LogSettings::fancyZonesLoggerName, true);
 
+    powertoys_gpo::watchPolicyChanges();
     if (powertoys_gpo::getConfiguredFancyZonesEnabledValue() == powertoys_gpo::gpo_rule_configured_disabled)
     {
         Logger::warn(L"Tried to start with a GPO policy setting the utility to always be disabled. Please contact your systems administrator.");
@@ -3,6 +3,7 @@
 
 #include <common/logger/call_tracer.h>
 #include <common/logger/logger.h>
+#include <common/utils/native_json.h>
 #include <common/utils/process_path.h>
 
 #include <FancyZonesLib/GuidUtils.h>
@@ -17,18 +18,18 @@ namespace JsonUtils
     struct AppZoneHistoryJSON
     {
     private:
-        static std::optional<FancyZonesDataTypes::WorkAreaId> DeviceIdFromJson(const json::JsonObject& json)
+        static std::optional<FancyZonesDataTypes::WorkAreaId> DeviceIdFromJson(const json::native::Value& json)
         {
             try
             {
-                if (json.HasKey(NonLocalizable::AppZoneHistoryIds::DeviceID))
+                if (json.has_key(NonLocalizable::AppZoneHistoryIds::DeviceID))
                 {
-                    json::JsonObject device = json.GetNamedObject(NonLocalizable::AppZoneHistoryIds::DeviceID);
-                    std::wstring monitor = device.GetNamedString(NonLocalizable::AppZoneHistoryIds::MonitorID).c_str();
-                    std::wstring monitorInstance = device.GetNamedString(NonLocalizable::AppZoneHistoryIds::MonitorInstanceID, L"").c_str();
-                    std::wstring monitorSerialNumber = device.GetNamedString(NonLocalizable::AppZoneHistoryIds::MonitorSerialNumberID, L"").c_str();
-                    int monitorNumber = static_cast<int>(device.GetNamedNumber(NonLocalizable::AppZoneHistoryIds::MonitorNumberID, 0));
-                    std::wstring virtualDesktop = device.GetNamedString(NonLocalizable::AppZoneHistoryIds::VirtualDesktopID).c_str();
+                    const auto& device = json.get_named_object(NonLocalizable::AppZoneHistoryIds::DeviceID);
+                    std::wstring monitor = device.get_named_string(NonLocalizable::AppZoneHistoryIds::MonitorID);
+                    std::wstring monitorInstance = device.get_named_string(NonLocalizable::AppZoneHistoryIds::MonitorInstanceID, L"");
+                    std::wstring monitorSerialNumber = device.get_named_string(NonLocalizable::AppZoneHistoryIds::MonitorSerialNumberID, L"");
+                    int monitorNumber = static_cast<int>(device.get_named_number(NonLocalizable::AppZoneHistoryIds::MonitorNumberID, 0));
+                    std::wstring virtualDesktop = device.get_named_string(NonLocalizable::AppZoneHistoryIds::VirtualDesktopID);
 
                     auto virtualDesktopGuid = FancyZonesUtils::GuidFromString(virtualDesktop);
                     if (!virtualDesktopGuid)
@@ -61,7 +62,7 @@ namespace JsonUtils
                 }
                 else
                 {
-                    std::wstring deviceIdStr = json.GetNamedString(NonLocalizable::AppZoneHistoryIds::DeviceIdID).c_str();
+                    std::wstring deviceIdStr = json.get_named_string(NonLocalizable::AppZoneHistoryIds::DeviceIdID);
                     auto bcDeviceId = BackwardsCompatibility::DeviceIdData::ParseDeviceId(deviceIdStr);
                     if (!bcDeviceId)
                     {
@@ -74,26 +75,26 @@ namespace JsonUtils
                     };
                 }
             }
-            catch (const winrt::hresult_error&)
+            catch (const json::native::error&)
             {
                 return std::nullopt;
             }
         }
 
-        static std::optional<FancyZonesDataTypes::AppZoneHistoryData> ParseSingleAppZoneHistoryItem(const json::JsonObject& json)
+        static std::optional<FancyZonesDataTypes::AppZoneHistoryData> ParseSingleAppZoneHistoryItem(const json::native::Value& json)
         {
             FancyZonesDataTypes::AppZoneHistoryData data;
-            if (json.HasKey(NonLocalizable::AppZoneHistoryIds::LayoutIndexesID))
+            if (json.has_key(NonLocalizable::AppZoneHistoryIds::LayoutIndexesID))
             {
                 data.zoneIndexSet = {};
-                for (const auto& value : json.GetNamedArray(NonLocalizable::AppZoneHistoryIds::LayoutIndexesID))
+                for (const auto& value : json.get_named_array(NonLocalizable::AppZoneHistoryIds::LayoutIndexesID))
                 {
-                    data.zoneIndexSet.push_back(static_cast<ZoneIndex>(value.GetNumber()));
+                    data.zoneIndexSet.push_back(static_cast<ZoneIndex>(value.get_number()));
                 }
             }
-            else if (json.HasKey(NonLocalizable::AppZoneHistoryIds::LayoutIndexesID))
+            else if (json.has_key(NonLocalizable::AppZoneHistoryIds::LayoutIndexesID))
             {
-                data.zoneIndexSet = { static_cast<ZoneIndex>(json.GetNamedNumber(NonLocalizable::AppZoneHistoryIds::LayoutIndexesID)) };
+                data.zoneIndexSet = { static_cast<ZoneIndex>(json.get_named_number(NonLocalizable::AppZoneHistoryIds::LayoutIndexesID)) };
             }
 
             auto deviceIdOpt = DeviceIdFromJson(json);
@@ -103,7 +104,7 @@ namespace JsonUtils
             }
 
             data.workAreaId = deviceIdOpt.value();
-            std::wstring layoutIdStr = json.GetNamedString(NonLocalizable::AppZoneHistoryIds::LayoutIdID).c_str();
+            std::wstring layoutIdStr = json.get_named_string(NonLocalizable::AppZoneHistoryIds::LayoutIdID);
             auto layoutIdOpt = FancyZonesUtils::GuidFromString(layoutIdStr);
             if (!layoutIdOpt.has_value())
             {
@@ -118,19 +119,17 @@ namespace JsonUtils
         std::wstring appPath;
         std::vector<FancyZonesDataTypes::AppZoneHistoryData> data;
         
-        static std::optional<AppZoneHistoryJSON> FromJson(const json::JsonObject& json)
+        static std::optional<AppZoneHistoryJSON> FromJson(const json::native::Value& json)
         {
             try
             {
                 AppZoneHistoryJSON result;
 
-                result.appPath = json.GetNamedString(NonLocalizable::AppZoneHistoryIds::AppPathID);
-                if (json.HasKey(NonLocalizable::AppZoneHistoryIds::HistoryID))
+                result.appPath = json.get_named_string(NonLocalizable::AppZoneHistoryIds::AppPathID);
+                if (json.has_key(NonLocalizable::AppZoneHistoryIds::HistoryID))
                 {
-                    auto appHistoryArray = json.GetNamedArray(NonLocalizable::AppZoneHistoryIds::HistoryID);
-                    for (uint32_t i = 0; i < appHistoryArray.Size(); ++i)
+                    for (const auto& json_hist : json.get_named_array(NonLocalizable::AppZoneHistoryIds::HistoryID))
                     {
-                        json::JsonObject json_hist = appHistoryArray.GetObjectAt(i);
                         if (auto data = ParseSingleAppZoneHistoryItem(json_hist); data.has_value())
                         {
                             result.data.push_back(std::move(data.value()));
@@ -152,67 +151,61 @@ namespace JsonUtils
 
                 return result;
             }
-            catch (const winrt::hresult_error&)
+            catch (const json::native::error&)
             {
                 return std::nullopt;
             }
         }
 
-        static json::JsonObject ToJson(const AppZoneHistoryJSON& appZoneHistory)
+        static void ToJson(json::native::Writer& writer, const std::wstring& appPath, const std::vector<FancyZonesDataTypes::AppZoneHistoryData>& appZoneHistoryData)
         {
-            json::JsonObject result{};
+            writer.begin_object();
+            writer.member(NonLocalizable::AppZoneHistoryIds::AppPathID, appPath);
 
-            result.SetNamedValue(NonLocalizable::AppZoneHistoryIds::AppPathID, json::value(appZoneHistory.appPath));
-
-            json::JsonArray appHistoryArray;
-            for (const auto& data : appZoneHistory.data)
+            writer.key(NonLocalizable::AppZoneHistoryIds::HistoryID).begin_array();
+            for (const auto& data : appZoneHistoryData)
             {
-                json::JsonObject desktopData;
-                json::JsonArray jsonIndexSet;
+                writer.begin_object();
+                writer.key(NonLocalizable::AppZoneHistoryIds::LayoutIndexesID).begin_array();
                 for (ZoneIndex index : data.zoneIndexSet)
                 {
-                    jsonIndexSet.Append(json::value(static_cast<int>(index)));
+                    writer.value(static_cast<int>(index));
                 }
+                writer.end_array();
 
-                json::JsonObject device{};
-                device.SetNamedValue(NonLocalizable::AppZoneHistoryIds::MonitorID, json::value(data.workAreaId.monitorId.deviceId.id));
-                device.SetNamedValue(NonLocalizable::AppZoneHistoryIds::MonitorInstanceID, json::value(data.workAreaId.monitorId.deviceId.instanceId));
-                device.SetNamedValue(NonLocalizable::AppZoneHistoryIds::MonitorSerialNumberID, json::value(data.workAreaId.monitorId.serialNumber));
-                device.SetNamedValue(NonLocalizable::AppZoneHistoryIds::MonitorNumberID, json::value(data.workAreaId.monitorId.deviceId.number));
+                writer.key(NonLocalizable::AppZoneHistoryIds::DeviceID).begin_object();
+                writer.member(NonLocalizable::AppZoneHistoryIds::MonitorID, data.workAreaId.monitorId.deviceId.id);
+                writer.member(NonLocalizable::AppZoneHistoryIds::MonitorInstanceID, data.workAreaId.monitorId.deviceId.instanceId);
+                writer.member(NonLocalizable::AppZoneHistoryIds::MonitorSerialNumberID, data.workAreaId.monitorId.serialNumber);
+                writer.member(NonLocalizable::AppZoneHistoryIds::MonitorNumberID, data.workAreaId.monitorId.deviceId.number);
 
                 auto virtualDesktopStr = FancyZonesUtils::GuidToString(data.workAreaId.virtualDesktopId);
                 if (virtualDesktopStr)
                 {
-                    device.SetNamedValue(NonLocalizable::AppZoneHistoryIds::VirtualDesktopID, json::value(virtualDesktopStr.value()));
+                    writer.member(NonLocalizable::AppZoneHistoryIds::VirtualDesktopID, virtualDesktopStr.value());
                 }
+                writer.end_object();
 
-                desktopData.SetNamedValue(NonLocalizable::AppZoneHistoryIds::LayoutIndexesID, jsonIndexSet);
-                desktopData.SetNamedValue(NonLocalizable::AppZoneHistoryIds::DeviceID, device);
                 auto layoutIdStr = FancyZonesUtils::GuidToString(data.layoutId);
                 if (layoutIdStr)
                 {
-                    desktopData.SetNamedValue(NonLocalizable::AppZoneHistoryIds::LayoutIdID, json::value(layoutIdStr.value()));
+                    writer.member(NonLocalizable::AppZoneHistoryIds::LayoutIdID, layoutIdStr.value());
                 }
-
-                appHistoryArray.Append(desktopData);
+                writer.end_object();
             }
+            writer.end_array();
 
-            result.SetNamedValue(NonLocalizable::AppZoneHistoryIds::HistoryID, appHistoryArray);
-
-            return result;
+            writer.end_object();
         }
     };
 
-    AppZoneHistory::TAppZoneHistoryMap ParseAppZoneHistory(const json::JsonObject& fancyZonesDataJSON)
+    AppZoneHistory::TAppZoneHistoryMap ParseAppZoneHistory(const json::native::Value& fancyZonesDataJSON)
     {
         try
         {
             AppZoneHistory::TAppZoneHistoryMap appZoneHistoryMap{};
-            auto appLastZones = fancyZonesDataJSON.GetNamedArray(NonLocalizable::AppZoneHistoryIds::AppZoneHistoryID);
-
-            for (uint32_t i = 0; i < appLastZones.Size(); ++i)
+            for (const auto& appLastZone : fancyZonesDataJSON.get_named_array(NonLocalizable::AppZoneHistoryIds::AppZoneHistoryID))
             {
-                json::JsonObject appLastZone = appLastZones.GetObjectAt(i);
                 if (auto appZoneHistory = AppZoneHistoryJSON::FromJson(appLastZone); appZoneHistory.has_value())
                 {
                     appZoneHistoryMap[appZoneHistory->appPath] = std::move(appZoneHistory->data);
@@ -221,24 +214,24 @@ namespace JsonUtils
 
             return std::move(appZoneHistoryMap);
         }
-        catch (const winrt::hresult_error&)
+        catch (const json::native::error&)
         {
             return {};
         }
     }
 
-    json::JsonObject SerializeJson(const AppZoneHistory::TAppZoneHistoryMap& map)
+    std::string SerializeJson(const AppZoneHistory::TAppZoneHistoryMap& map)
     {
-        json::JsonObject root{};
-        json::JsonArray appHistoryArray{};
-
+        json::native::Writer writer;
+        writer.begin_object();
+        writer.key(NonLocalizable::AppZoneHistoryIds::AppZoneHistoryID).begin_array();
         for (const auto& [appPath, appZoneHistoryData] : map)
         {
-            appHistoryArray.Append(AppZoneHistoryJSON::ToJson(AppZoneHistoryJSON{ appPath, appZoneHistoryData }));
+            AppZoneHistoryJSON::ToJson(writer, appPath, appZoneHistoryData);
         }
-
-        root.SetNamedValue(NonLocalizable::AppZoneHistoryIds::AppZoneHistoryID, appHistoryArray);
-        return root;
+        writer.end_array();
+        writer.end_object();
+        return writer.release();
     }
 }
 
@@ -256,13 +249,13 @@ AppZoneHistory& AppZoneHistory::instance()
 void AppZoneHistory::LoadData()
 {
     auto file = AppZoneHistoryFileName();
-    auto data = json::from_file(file);
+    auto data = json::native::from_file(file);
 
     try
     {
         if (data)
         {
-            m_history = JsonUtils::ParseAppZoneHistory(data.value());
+            m_history = JsonUtils::ParseAppZoneHistory(data->root());
         }
         else
         {
@@ -270,15 +263,15 @@ void AppZoneHistory::LoadData()
             Logger::error(L"app-zone-history.json file is missing or malformed");
         }
     }
-    catch (const winrt::hresult_error& e)
+    catch (const json::native::error& e)
     {
-        Logger::error(L"Parsing app-zone-history error: {}", e.message());
+        Logger::error("Parsing app-zone-history error: {}", std::string{ e.what() });
     }
 }
 
 void AppZoneHistory::SaveData()
 {
-    json::to_file(AppZoneHistoryFileName(), JsonUtils::SerializeJson(m_history));
+    json::native::to_file(AppZoneHistoryFileName(), JsonUtils::SerializeJson(m_history));
 }
 
 void AppZoneHistory::AdjustWorkAreaIds(const std::vector<FancyZonesDataTypes::MonitorId>& ids)
@@ -461,7 +454,7 @@ std::optional<FancyZonesDataTypes::AppZoneHistoryData> AppZoneHistory::GetZoneHi
     auto srcVirtualDesktopIDStr = FancyZonesUtils::GuidToString(workAreaId.virtualDesktopId);
     if (srcVirtualDesktopIDStr)
     {
-        Logger::debug(L"Get {} zone history on monitor: {}, virtual desktop: {}", app, workAreaId.toString(), srcVirtualDesktopIDStr.value());
+        LOG_DEBUG(L"Get {} zone history on monitor: {}, virtual desktop: {}", app, workAreaId.toString(), srcVirtualDesktopIDStr.value());
     }
 
     auto iter = m_history.find(appPath);
@@ -479,7 +472,7 @@ std::optional<FancyZonesDataTypes::AppZoneHistoryData> AppZoneHistory::GetZoneHi
             auto vdStr = FancyZonesUtils::GuidToString(history.workAreaId.virtualDesktopId);
             if (vdStr)
             {
-                Logger::debug(L"App zone history found on the device {} with virtual desktop {}", history.workAreaId.toString(), vdStr.value());
+                LOG_DEBUG(L"App zone history found on the device {} with virtual desktop {}", history.workAreaId.toString(), vdStr.value());
             }
 
             if (history.workAreaId.virtualDesktopId == workAreaId.virtualDesktopId || history.workAreaId.virtualDesktopId == GUID_NULL)
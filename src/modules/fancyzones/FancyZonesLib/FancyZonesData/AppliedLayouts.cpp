@@ -3,6 +3,7 @@
 
 #include <common/logger/call_tracer.h>
 #include <common/logger/logger.h>
+#include <common/utils/native_json.h>
 
 #include <FancyZonesLib/GuidUtils.h>
 #include <FancyZonesLib/FancyZonesData/CustomLayouts.h>
@@ -31,61 +32,61 @@ namespace JsonUtils
 {
     struct LayoutJSON
     {
-        static std::optional<LayoutData> FromJson(const json::JsonObject& json)
+        static std::optional<LayoutData> FromJson(const json::native::Value& json)
         {
             try
             {
                 LayoutData data{};
-                auto idStr = json.GetNamedString(NonLocalizable::AppliedLayoutsIds::UuidID);
-                auto id = FancyZonesUtils::GuidFromString(idStr.c_str());
+                auto idStr = json.get_named_string(NonLocalizable::AppliedLayoutsIds::UuidID);
+                auto id = FancyZonesUtils::GuidFromString(idStr);
                 if (!id.has_value())
                 {
                     return std::nullopt;
                 }
 
                 data.uuid = id.value();
-                data.type = FancyZonesDataTypes::TypeFromString(std::wstring{ json.GetNamedString(NonLocalizable::AppliedLayoutsIds::TypeID) });
-                data.showSpacing = json.GetNamedBoolean(NonLocalizable::AppliedLayoutsIds::ShowSpacingID);
-                data.spacing = static_cast<int>(json.GetNamedNumber(NonLocalizable::AppliedLayoutsIds::SpacingID));
-                data.zoneCount = static_cast<int>(json.GetNamedNumber(NonLocalizable::AppliedLayoutsIds::ZoneCountID));
-                data.sensitivityRadius = static_cast<int>(json.GetNamedNumber(NonLocalizable::AppliedLayoutsIds::SensitivityRadiusID, DefaultValues::SensitivityRadius));
+                data.type = FancyZonesDataTypes::TypeFromString(json.get_named_string(NonLocalizable::AppliedLayoutsIds::TypeID));
+                data.showSpacing = json.get_named_boolean(NonLocalizable::AppliedLayoutsIds::ShowSpacingID);
+                data.spacing = static_cast<int>(json.get_named_number(NonLocalizable::AppliedLayoutsIds::SpacingID));
+                data.zoneCount = static_cast<int>(json.get_named_number(NonLocalizable::AppliedLayoutsIds::ZoneCountID));
+                data.sensitivityRadius = static_cast<int>(json.get_named_number(NonLocalizable::AppliedLayoutsIds::SensitivityRadiusID, DefaultValues::SensitivityRadius));
 
                 return data;
             }
-            catch (const winrt::hresult_error&)
+            catch (const json::native::error&)
             {
                 return std::nullopt;
             }
         }
 
-        static json::JsonObject ToJson(const LayoutData& data)
+        static void ToJson(json::native::Writer& writer, const LayoutData& data)
         {
-            json::JsonObject result{};
-            result.SetNamedValue(NonLocalizable::AppliedLayoutsIds::UuidID, json::value(FancyZonesUtils::GuidToString(data.uuid).value()));
-            result.SetNamedValue(NonLocalizable::AppliedLayoutsIds::TypeID, json::value(FancyZonesDataTypes::TypeToString(data.type)));
-            result.SetNamedValue(NonLocalizable::AppliedLayoutsIds::ShowSpacingID, json::value(data.showSpacing));
-            result.SetNamedValue(NonLocalizable::AppliedLayoutsIds::SpacingID, json::value(data.spacing));
-            result.SetNamedValue(NonLocalizable::AppliedLayoutsIds::ZoneCountID, json::value(data.zoneCount));
-            result.SetNamedValue(NonLocalizable::AppliedLayoutsIds::SensitivityRadiusID, json::value(data.sensitivityRadius));
-            return result;
+            writer.begin_object();
+            writer.member(NonLocalizable::AppliedLayoutsIds::UuidID, FancyZonesUtils::GuidToString(data.uuid).value());
+            writer.member(NonLocalizable::AppliedLayoutsIds::TypeID, FancyZonesDataTypes::TypeToString(data.type));
+            writer.member(NonLocalizable::AppliedLayoutsIds::ShowSpacingID, data.showSpacing);
+            writer.member(NonLocalizable::AppliedLayoutsIds::SpacingID, data.spacing);
+            writer.member(NonLocalizable::AppliedLayoutsIds::ZoneCountID, data.zoneCount);
+            writer.member(NonLocalizable::AppliedLayoutsIds::SensitivityRadiusID, data.sensitivityRadius);
+            writer.end_object();
         }
     };
 
     struct AppliedLayoutsJSON
     {
     private:
-        static std::pair<std::optional<FancyZonesDataTypes::WorkAreaId>, bool> WorkAreaIdFromJson(const json::JsonObject& json)
+        static std::pair<std::optional<FancyZonesDataTypes::WorkAreaId>, bool> WorkAreaIdFromJson(const json::native::Value& json)
         {
             try
             {
-                if (json.HasKey(NonLocalizable::AppliedLayoutsIds::DeviceID))
+                if (json.has_key(NonLocalizable::AppliedLayoutsIds::DeviceID))
                 {
-                    json::JsonObject device = json.GetNamedObject(NonLocalizable::AppliedLayoutsIds::DeviceID);
-                    std::wstring monitor = device.GetNamedString(NonLocalizable::AppliedLayoutsIds::MonitorID).c_str();
-                    std::wstring monitorInstance = device.GetNamedString(NonLocalizable::AppliedLayoutsIds::MonitorInstanceID, L"").c_str();
-                    std::wstring monitorSerialNumber = device.GetNamedString(NonLocalizable::AppliedLayoutsIds::MonitorSerialNumberID, L"").c_str();
-                    int monitorNumber = static_cast<int>(device.GetNamedNumber(NonLocalizable::AppliedLayoutsIds::MonitorNumberID, 0));
-                    std::wstring virtualDesktop = device.GetNamedString(NonLocalizable::AppliedLayoutsIds::VirtualDesktopID).c_str();
+                    const auto& device = json.get_named_object(NonLocalizable::AppliedLayoutsIds::DeviceID);
+                    std::wstring monitor = device.get_named_string(NonLocalizable::AppliedLayoutsIds::MonitorID);
+                    std::wstring monitorInstance = device.get_named_string(NonLocalizable::AppliedLayoutsIds::MonitorInstanceID, L"");
+                    std::wstring monitorSerialNumber = device.get_named_string(NonLocalizable::AppliedLayoutsIds::MonitorSerialNumberID, L"");
+                    int monitorNumber = static_cast<int>(device.get_named_number(NonLocalizable::AppliedLayoutsIds::MonitorNumberID, 0));
+                    std::wstring virtualDesktop = device.get_named_string(NonLocalizable::AppliedLayoutsIds::VirtualDesktopID);
 
                     auto virtualDesktopGuid = FancyZonesUtils::GuidFromString(virtualDesktop);
                     if (!virtualDesktopGuid)
@@ -119,7 +120,7 @@ namespace JsonUtils
                 }
                 else
                 {
-                    std::wstring deviceIdStr = json.GetNamedString(NonLocalizable::AppliedLayoutsIds::DeviceIdID).c_str();
+                    std::wstring deviceIdStr = json.get_named_string(NonLocalizable::AppliedLayoutsIds::DeviceIdID);
                     auto bcDeviceId = BackwardsCompatibility::DeviceIdData::ParseDeviceId(deviceIdStr);
                     if (!bcDeviceId)
                     {
@@ -133,7 +134,7 @@ namespace JsonUtils
                              true };
                 }
             }
-            catch (const winrt::hresult_error&)
+            catch (const json::native::error&)
             {
                 return { std::nullopt, false };
             }
@@ -144,7 +145,7 @@ namespace JsonUtils
         LayoutData data{};
         bool hasResolutionInId = false;
 
-        static std::optional<AppliedLayoutsJSON> FromJson(const json::JsonObject& json)
+        static std::optional<AppliedLayoutsJSON> FromJson(const json::native::Value& json)
         {
             try
             {
@@ -156,7 +157,7 @@ namespace JsonUtils
                     return std::nullopt;
                 }
 
-                auto layout = JsonUtils::LayoutJSON::FromJson(json.GetNamedObject(NonLocalizable::AppliedLayoutsIds::AppliedLayoutID));
+                auto layout = JsonUtils::LayoutJSON::FromJson(json.get_named_object(NonLocalizable::AppliedLayoutsIds::AppliedLayoutID));
                 if (!layout.has_value())
                 {
                     return std::nullopt;
@@ -168,42 +169,40 @@ namespace JsonUtils
 
                 return result;
             }
-            catch (const winrt::hresult_error&)
+            catch (const json::native::error&)
             {
                 return std::nullopt;
             }
         }
 
-        static json::JsonObject ToJson(const AppliedLayoutsJSON& value)
+        static void ToJson(json::native::Writer& writer, const FancyZonesDataTypes::WorkAreaId& workAreaId, const LayoutData& data)
         {
-            json::JsonObject device{};
-            device.SetNamedValue(NonLocalizable::AppliedLayoutsIds::MonitorID, json::value(value.workAreaId.monitorId.deviceId.id));
-            device.SetNamedValue(NonLocalizable::AppliedLayoutsIds::MonitorInstanceID, json::value(value.workAreaId.monitorId.deviceId.instanceId));
-            device.SetNamedValue(NonLocalizable::AppliedLayoutsIds::MonitorSerialNumberID, json::value(value.workAreaId.monitorId.serialNumber));
-            device.SetNamedValue(NonLocalizable::AppliedLayoutsIds::MonitorNumberID, json::value(value.workAreaId.monitorId.deviceId.number));
-
-            auto virtualDesktopStr = FancyZonesUtils::GuidToString(value.workAreaId.virtualDesktopId);
+            writer.begin_object();
+            writer.key(NonLocalizable::AppliedLayoutsIds::DeviceID).begin_object();
+            writer.member(NonLocalizable::AppliedLayoutsIds::MonitorID, workAreaId.monitorId.deviceId.id);
+            writer.member(NonLocalizable::AppliedLayoutsIds::MonitorInstanceID, workAreaId.monitorId.deviceId.instanceId);
+            writer.member(NonLocalizable::AppliedLayoutsIds::MonitorSerialNumberID, workAreaId.monitorId.serialNumber);
+            writer.member(NonLocalizable::AppliedLayoutsIds::MonitorNumberID, workAreaId.monitorId.deviceId.number);
+
+            auto virtualDesktopStr = FancyZonesUtils::GuidToString(workAreaId.virtualDesktopId);
             if (virtualDesktopStr)
             {
-                device.SetNamedValue(NonLocalizable::AppliedLayoutsIds::VirtualDesktopID, json::value(virtualDesktopStr.value()));
+                writer.member(NonLocalizable::AppliedLayoutsIds::VirtualDesktopID, virtualDesktopStr.value());
             }
+            writer.end_object();
 
-            json::JsonObject result{};
-            result.SetNamedValue(NonLocalizable::AppliedLayoutsIds::DeviceID, device);
-            result.SetNamedValue(NonLocalizable::AppliedLayoutsIds::AppliedLayoutID, JsonUtils::LayoutJSON::ToJson(value.data));
-            
-            return result;
+            writer.key(NonLocalizable::AppliedLayoutsIds::AppliedLayoutID);
+            JsonUtils::LayoutJSON::ToJson(writer, data);
+            writer.end_object();
         }
     };
 
-    AppliedLayouts::TAppliedLayoutsMap ParseJson(const json::JsonObject& json)
+    AppliedLayouts::TAppliedLayoutsMap ParseJson(const json::native::Value& json)
     {
         AppliedLayouts::TAppliedLayoutsMap map{};
-        auto layouts = json.GetNamedArray(NonLocalizable::AppliedLayoutsIds::AppliedLayoutsArrayID);
-
-        for (uint32_t i = 0; i < layouts.Size(); ++i)
+        for (const auto& layout : json.get_named_array(NonLocalizable::AppliedLayoutsIds::AppliedLayoutsArrayID))
         {
-            if (auto obj = AppliedLayoutsJSON::FromJson(layouts.GetObjectAt(i)); obj.has_value())
+            if (auto obj = AppliedLayoutsJSON::FromJson(layout); obj.has_value())
             {
                 // skip default layouts in case if they were applied to different resolutions on the same monitor.
                 // NOTE: keep the default layout check for users who update PT version from the v0.57
@@ -222,21 +221,18 @@ namespace JsonUtils
         return map;
     }
 
-    json::JsonObject SerializeJson(const AppliedLayouts::TAppliedLayoutsMap& map)
+    std::string SerializeJson(const AppliedLayouts::TAppliedLayoutsMap& map)
     {
-        json::JsonObject json{};
-        json::JsonArray layoutArray{};
-
+        json::native::Writer writer;
+        writer.begin_object();
+        writer.key(NonLocalizable::AppliedLayoutsIds::AppliedLayoutsArrayID).begin_array();
         for (const auto& [id, data] : map)
         {
-            AppliedLayoutsJSON obj{};
-            obj.workAreaId = id;
-            obj.data = data;
-            layoutArray.Append(AppliedLayoutsJSON::ToJson(obj));
+            AppliedLayoutsJSON::ToJson(writer, id, data);
         }
-
-        json.SetNamedValue(NonLocalizable::AppliedLayoutsIds::AppliedLayoutsArrayID, layoutArray);
-        return json;
+        writer.end_array();
+        writer.end_object();
+        return writer.release();
     }
 }
 
@@ -257,13 +253,13 @@ AppliedLayouts& AppliedLayouts::instance()
 
 void AppliedLayouts::LoadData()
 {
-    auto data = json::from_file(AppliedLayoutsFileName());
+    auto data = json::native::from_file(AppliedLayoutsFileName());
 
     try
     {
         if (data)
         {
-            m_layouts = JsonUtils::ParseJson(data.value());
+            m_layouts = JsonUtils::ParseJson(data->root());
         }
         else
         {
@@ -271,15 +267,15 @@ void AppliedLayouts::LoadData()
             Logger::info(L"applied-layouts.json file is missing or malformed");
         }
     }
-    catch (const winrt::hresult_error& e)
+    catch (const json::native::error& e)
     {
-        Logger::error(L"Parsing applied-layouts error: {}", e.message());
+        Logger::error("Parsing applied-layouts error: {}", std::string{ e.what() });
     }
 }
 
 void AppliedLayouts::SaveData()
 {
-    json::to_file(AppliedLayoutsFileName(), JsonUtils::SerializeJson(m_layouts));
+    json::native::to_file(AppliedLayoutsFileName(), JsonUtils::SerializeJson(m_layouts));
 }
 
 void AppliedLayouts::AdjustWorkAreaIds(const std::vector<FancyZonesDataTypes::MonitorId>& ids)
@@ -228,6 +228,7 @@ void FancyZonesSettings::LoadSettings()
             {
                 m_settings.excludedApps = apps;
                 m_settings.excludedAppsArray = excludedApps;
+                m_settings.excludedAppsMatcher = ExcludedAppsMatcher(excludedApps);
                 NotifyObservers(SettingId::ExcludedApps);
             }
         }
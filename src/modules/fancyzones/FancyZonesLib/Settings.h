@@ -4,6 +4,7 @@
 
 #include <common/SettingsAPI/settings_helpers.h>
 #include <common/SettingsAPI/settings_objects.h>
+#include <common/utils/excluded_apps.h>
 
 #include <FancyZonesLib/ModuleConstants.h>
 #include <FancyZonesLib/SettingsConstants.h>
@@ -58,6 +59,7 @@ struct Settings
     PowerToysSettings::HotkeyObject prevTabHotkey = PowerToysSettings::HotkeyObject::from_settings(true, false, false, false, VK_PRIOR);
     std::wstring excludedApps = L"";
     std::vector<std::wstring> excludedAppsArray;
+    ExcludedAppsMatcher excludedAppsMatcher;
 };
 
 class FancyZonesSettings
@@ -83,6 +85,7 @@ public:
     inline void SetSettings(const Settings& settings)
     {
         m_settings = settings;
+        m_settings.excludedAppsMatcher = ExcludedAppsMatcher(settings.excludedAppsArray);
     }
 #endif
 
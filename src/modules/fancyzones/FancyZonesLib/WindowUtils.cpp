@@ -161,7 +161,7 @@ bool FancyZonesWindowUtils::IsExcluded(HWND window)
 
 bool FancyZonesWindowUtils::IsExcludedByUser(const HWND& hwnd, const std::wstring& processPath) noexcept
 {
-    return (check_excluded_app(hwnd, processPath, FancyZonesSettings::settings().excludedAppsArray));
+    return (check_excluded_app(hwnd, processPath, FancyZonesSettings::settings().excludedAppsMatcher));
 }
 
 bool FancyZonesWindowUtils::IsExcludedByDefault(const HWND& hwnd, const std::wstring& processPath) noexcept
@@ -184,7 +184,7 @@ bool FancyZonesWindowUtils::IsExcludedByDefault(const HWND& hwnd, const std::wst
         return true;
     }
 
-    static std::vector<std::wstring> defaultExcludedApps = { NonLocalizable::PowerToysAppFZEditor, NonLocalizable::CoreWindow, NonLocalizable::SearchUI };
+    static const ExcludedAppsMatcher defaultExcludedApps{ { NonLocalizable::PowerToysAppFZEditor, NonLocalizable::CoreWindow, NonLocalizable::SearchUI } };
     return (check_excluded_app(hwnd, processPath, defaultExcludedApps));
 }
 
@@ -20,11 +20,12 @@ int WINAPI wWinMain(_In_ HINSTANCE /*hInstance*/,
                     _In_ int /*nCmdShow*/)
 {
     winrt::init_apartment();
-    LoggerHelpers::init_logger(KeyboardManagerConstants::ModuleName, L"Engine", LogSettings::keyboardManagerLoggerName);
+    LoggerHelpers::init_logger(KeyboardManagerConstants::ModuleName, L"Engine", LogSettings::keyboardManagerLoggerName, true);
 
     Shared::Trace::ETWTrace trace;
     trace.UpdateState(true);
 
+    powertoys_gpo::watchPolicyChanges();
     if (powertoys_gpo::getConfiguredKeyboardManagerEnabledValue() == powertoys_gpo::gpo_rule_configured_disabled)
     {
         Logger::warn(L"Tried to start with a GPO policy setting the utility to always be disabled. Please contact your systems administrator.");
@@ -335,7 +335,7 @@ namespace KeyboardEventHandlers
                         {
                             if (data->lParam->vkCode == itShortcut.GetSecondKey())
                             {
-                                Logger::trace(L"ChordKeyboardHandler:found chord match {}, {}", itShortcut.GetActionKey(), itShortcut.GetSecondKey());
+                                LOG_TRACE(L"ChordKeyboardHandler:found chord match {}, {}", itShortcut.GetActionKey(), itShortcut.GetSecondKey());
                                 isMatchOnChordEnd = true;
                             }
                             // Resets chord status for the shortcut. A key was pressed and we registered if it was the end of the chord. We can reset it.
@@ -390,7 +390,7 @@ namespace KeyboardEventHandlers
                             myThread.detach();
                         }
 
-                        Logger::trace(L"ChordKeyboardHandler:returning..");
+                        LOG_TRACE(L"ChordKeyboardHandler:returning..");
                         return 1;
                     }
                     else if (isOpenUri)
@@ -408,7 +408,7 @@ namespace KeyboardEventHandlers
                             if (UrlCreateFromPathW(uri.c_str(), url, &bufferSize, 0) == S_OK)
                             {
                                 newUri = url;
-                                Logger::trace(L"ChordKeyboardHandler:ConvertPathToURI from {} to {}", uri, url);
+                                LOG_TRACE(L"ChordKeyboardHandler:ConvertPathToURI from {} to {}", uri, url);
                             }
                             else
                             {
@@ -436,7 +436,7 @@ namespace KeyboardEventHandlers
                             myThread.detach();
                         }
 
-                        Logger::trace(L"ChordKeyboardHandler:returning..");
+                        LOG_TRACE(L"ChordKeyboardHandler:returning..");
                         return 1;
                     }
                     else if (remapToShortcut)
@@ -524,7 +524,7 @@ namespace KeyboardEventHandlers
                         state.SetActivatedApp(*activatedApp);
                     }
 
-                    Logger::trace(L"ChordKeyboardHandler:keyEventList.size:{}", keyEventList.size());
+                    LOG_TRACE(L"ChordKeyboardHandler:keyEventList.size:{}", keyEventList.size());
 
                     ii.SendVirtualInput(keyEventList);
                     if (activatedApp.has_value())
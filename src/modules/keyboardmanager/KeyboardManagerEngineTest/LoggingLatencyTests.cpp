@@ -0,0 +1,108 @@
+#include "pch.h"
+
+// Suppressing 26466 - Don't use static_cast downcasts - in CppUnitTest.h
+#pragma warning(push)
+#pragma warning(disable : 26466)
+#include "CppUnitTest.h"
+#pragma warning(pop)
+
+#include "MockedInput.h"
+#include <keyboardmanager/KeyboardManagerEngineLibrary/State.h>
+#include <keyboardmanager/KeyboardManagerEngineLibrary/KeyboardEventHandlers.h>
+#include "TestHelpers.h"
+#include <common/logger/logger.h>
+#include <spdlog/sinks/basic_file_sink.h>
+#include <spdlog/sinks/null_sink.h>
+
+#include <chrono>
+#include <filesystem>
+#include <format>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace RemappingLogicTests
+{
+    // Time spent on the hook thread per key event, with trace logging written synchronously or by the async logger.
+    // Not a pass/fail benchmark, the numbers are written to the test log.
+    TEST_CLASS (LoggingLatencyTests)
+    {
+    private:
+        KeyboardManagerInput::MockedInput mockedInputHandler;
+        State testState;
+        std::filesystem::path logFolder;
+
+        double MeasureMicrosecondsPerEvent()
+        {
+            constexpr int keyPresses = 20000;
+            std::vector<INPUT> inputs{
+                { .type = INPUT_KEYBOARD, .ki = { .wVk = 'A' } },
+                { .type = INPUT_KEYBOARD, .ki = { .wVk = 'A', .dwFlags = KEYEVENTF_KEYUP } },
+            };
+
+            auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < keyPresses; i++)
+            {
+                mockedInputHandler.SendVirtualInput(inputs);
+            }
+            auto elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+            // every press is a key down and a key up
+            return elapsed / (keyPresses * 2);
+        }
+
+        spdlog::sink_ptr FileSink(const std::wstring& name)
+        {
+            auto sink = std::make_shared<spdlog::sinks::basic_file_sink_mt>((logFolder / name).wstring(), true);
+            sink->set_level(spdlog::level::trace);
+            return sink;
+        }
+
+    public:
+        TEST_METHOD_INITIALIZE(InitializeTestEnv)
+        {
+            // Reset test environment
+            TestHelpers::ResetTestEnv(mockedInputHandler, testState);
+            testState.AddSingleKeyRemap(0x41, (DWORD)0x42);
+
+            // Log every event like the chord handler does, then remap it
+            std::function<intptr_t(LowlevelKeyboardEvent*)> currentHookProc = [this](LowlevelKeyboardEvent* data) {
+                ::Logger::trace(L"ChordKeyboardHandler:key event {} for {}", data->wParam, data->lParam->vkCode);
+                return KeyboardEventHandlers::HandleSingleKeyRemapEvent(mockedInputHandler, data, testState);
+            };
+            mockedInputHandler.SetHookProc(currentHookProc);
+
+            logFolder = std::filesystem::temp_directory_path() / L"KeyboardManagerLoggingLatencyTests";
+            std::filesystem::create_directories(logFolder);
+        }
+
+        TEST_METHOD_CLEANUP(CleanupTestEnv)
+        {
+            // Releases the file sinks, which also stops the writer of the async logger
+            ::Logger::init(std::vector<spdlog::sink_ptr>{ std::make_shared<spdlog::sinks::null_sink_mt>() });
+
+            std::error_code error;
+            std::filesystem::remove_all(logFolder, error);
+        }
+
+        TEST_METHOD (HookLatencyWithTraceLogging)
+        {
+            auto traceOff = FileSink(L"off.log");
+            traceOff->set_level(spdlog::level::off);
+            ::Logger::init({ traceOff });
+            const double off = MeasureMicrosecondsPerEvent();
+
+            ::Logger::init({ FileSink(L"sync.log") });
+            const double sync = MeasureMicrosecondsPerEvent();
+
+            ::Logger::init({ FileSink(L"async.log") }, true);
+            const double async = MeasureMicrosecondsPerEvent();
+            ::Logger::flush();
+
+            // the key events are still remapped with logging on
+            Assert::AreEqual(mockedInputHandler.GetVirtualKeyState(0x42), false);
+            Assert::IsTrue(std::filesystem::file_size(logFolder / L"async.log") > 0);
+
+            Microsoft::VisualStudio::CppUnitTestFramework::Logger::WriteMessage(std::format("us per key event: trace off {:.2f}, synchronous {:.2f}, async {:.2f}", off, sync, async).c_str());
+        }
+    };
+}
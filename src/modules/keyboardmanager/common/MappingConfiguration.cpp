@@ -120,43 +120,40 @@ bool MappingConfiguration::AddAppSpecificShortcut(const std::wstring& app, const
     return true;
 }
 
-bool MappingConfiguration::LoadSingleKeyRemaps(const json::JsonObject& jsonData)
+bool MappingConfiguration::LoadSingleKeyRemaps(const json::native::Value& jsonData)
 {
     bool result = true;
 
     try
     {
-        auto remapKeysData = jsonData.GetNamedObject(KeyboardManagerConstants::RemapKeysSettingName);
+        const auto& remapKeysData = jsonData.get_named_object(KeyboardManagerConstants::RemapKeysSettingName);
         ClearSingleKeyRemaps();
 
-        if (remapKeysData)
+        const auto& inProcessRemapKeys = remapKeysData.get_named_array(KeyboardManagerConstants::InProcessRemapKeysSettingName);
+        for (const auto& it : inProcessRemapKeys)
         {
-            auto inProcessRemapKeys = remapKeysData.GetNamedArray(KeyboardManagerConstants::InProcessRemapKeysSettingName);
-            for (const auto& it : inProcessRemapKeys)
+            try
             {
-                try
-                {
-                    auto originalKey = it.GetObjectW().GetNamedString(KeyboardManagerConstants::OriginalKeysSettingName);
-                    auto newRemapKey = it.GetObjectW().GetNamedString(KeyboardManagerConstants::NewRemapKeysSettingName);
+                auto originalKey = it.get_named_string(KeyboardManagerConstants::OriginalKeysSettingName);
+                auto newRemapKey = it.get_named_string(KeyboardManagerConstants::NewRemapKeysSettingName);
 
-                    // If remapped to a shortcut
-                    if (std::wstring(newRemapKey).find(L";") != std::string::npos)
-                    {
-                        AddSingleKeyRemap(std::stoul(originalKey.c_str()), Shortcut(newRemapKey.c_str()));
-                    }
-
-                    // If remapped to a key
-                    else
-                    {
-                        AddSingleKeyRemap(std::stoul(originalKey.c_str()), std::stoul(newRemapKey.c_str()));
-                    }
+                // If remapped to a shortcut
+                if (std::wstring(newRemapKey).find(L";") != std::string::npos)
+                {
+                    AddSingleKeyRemap(std::stoul(originalKey.c_str()), Shortcut(newRemapKey.c_str()));
                 }
-                catch (...)
+
+                // If remapped to a key
+                else
                 {
-                    Logger::error(L"Improper Key Data JSON. Try the next remap.");
-                    result = false;
+                    AddSingleKeyRemap(std::stoul(originalKey.c_str()), std::stoul(newRemapKey.c_str()));
                 }
             }
+            catch (...)
+            {
+                Logger::error(L"Improper Key Data JSON. Try the next remap.");
+                result = false;
+            }
         }
     }
     catch (...)
@@ -168,27 +165,22 @@ bool MappingConfiguration::LoadSingleKeyRemaps(const json::JsonObject& jsonData)
     return result;
 }
 
-bool MappingConfiguration::LoadSingleKeyToTextRemaps(const json::JsonObject& jsonData)
+bool MappingConfiguration::LoadSingleKeyToTextRemaps(const json::native::Value& jsonData)
 {
     bool result = true;
 
     try
     {
-        auto remapKeysData = jsonData.GetNamedObject(KeyboardManagerConstants::RemapKeysToTextSettingName);
+        const auto& remapKeysData = jsonData.get_named_object(KeyboardManagerConstants::RemapKeysToTextSettingName);
         ClearSingleKeyToTextRemaps();
 
-        if (!remapKeysData)
-        {
-            return result;
-        }
-
-        auto inProcessRemapKeys = remapKeysData.GetNamedArray(KeyboardManagerConstants::InProcessRemapKeysSettingName);
+        const auto& inProcessRemapKeys = remapKeysData.get_named_array(KeyboardManagerConstants::InProcessRemapKeysSettingName);
         for (const auto& it : inProcessRemapKeys)
         {
             try
             {
-                auto originalKey = it.GetObjectW().GetNamedString(KeyboardManagerConstants::OriginalKeysSettingName);
-                auto newText = it.GetObjectW().GetNamedString(KeyboardManagerConstants::NewTextSettingName);
+                auto originalKey = it.get_named_string(KeyboardManagerConstants::OriginalKeysSettingName);
+                auto newText = it.get_named_string(KeyboardManagerConstants::NewTextSettingName);
 
                 // undo dummy data for backwards compatibility
                 if (newText == L"*Unsupported*")
@@ -214,23 +206,23 @@ bool MappingConfiguration::LoadSingleKeyToTextRemaps(const json::JsonObject& jso
     return result;
 }
 
-bool MappingConfiguration::LoadAppSpecificShortcutRemaps(const json::JsonObject& remapShortcutsData)
+bool MappingConfiguration::LoadAppSpecificShortcutRemaps(const json::native::Value& remapShortcutsData)
 {
     bool result = true;
 
     try
     {
-        auto appSpecificRemapShortcuts = remapShortcutsData.GetNamedArray(KeyboardManagerConstants::AppSpecificRemapShortcutsSettingName);
+        const auto& appSpecificRemapShortcuts = remapShortcutsData.get_named_array(KeyboardManagerConstants::AppSpecificRemapShortcutsSettingName);
         for (const auto& it : appSpecificRemapShortcuts)
         {
             try
             {
-                auto originalKeys = it.GetObjectW().GetNamedString(KeyboardManagerConstants::OriginalKeysSettingName);
-                auto newRemapKeys = it.GetObjectW().GetNamedString(KeyboardManagerConstants::NewRemapKeysSettingName, {});
-                auto newRemapText = it.GetObjectW().GetNamedString(KeyboardManagerConstants::NewTextSettingName, {});
-                auto targetApp = it.GetObjectW().GetNamedString(KeyboardManagerConstants::TargetAppSettingName);
-                auto operationType = it.GetObjectW().GetNamedNumber(KeyboardManagerConstants::ShortcutOperationType, 0);
-                auto exactMatch = it.GetObjectW().GetNamedBoolean(KeyboardManagerConstants::ShortcutExactMatch, false);
+                auto originalKeys = it.get_named_string(KeyboardManagerConstants::OriginalKeysSettingName);
+                auto newRemapKeys = it.get_named_string(KeyboardManagerConstants::NewRemapKeysSettingName, {});
+                auto newRemapText = it.get_named_string(KeyboardManagerConstants::NewTextSettingName, {});
+                auto targetApp = it.get_named_string(KeyboardManagerConstants::TargetAppSettingName);
+                auto operationType = it.get_named_number(KeyboardManagerConstants::ShortcutOperationType, 0);
+                auto exactMatch = it.get_named_boolean(KeyboardManagerConstants::ShortcutExactMatch, false);
                 auto originalShortcut = Shortcut(originalKeys.c_str());
                 originalShortcut.exactMatch = exactMatch;
                 // undo dummy data for backwards compatibility
@@ -242,12 +234,12 @@ bool MappingConfiguration::LoadAppSpecificShortcutRemaps(const json::JsonObject&
                 // check Shortcut::OperationType
                 if (operationType == 1)
                 {
-                    auto runProgramFilePath = it.GetObjectW().GetNamedString(KeyboardManagerConstants::RunProgramFilePathSettingName, L"");
-                    auto runProgramArgs = it.GetObjectW().GetNamedString(KeyboardManagerConstants::RunProgramArgsSettingName, L"");
-                    auto runProgramStartInDir = it.GetObjectW().GetNamedString(KeyboardManagerConstants::RunProgramStartInDirSettingName, L"");
-                    auto runProgramElevationLevel = it.GetObjectW().GetNamedNumber(KeyboardManagerConstants::RunProgramElevationLevelSettingName, 0);
-                    auto runProgramAlreadyRunningAction = it.GetObjectW().GetNamedNumber(KeyboardManagerConstants::RunProgramAlreadyRunningAction, 0);
-                    auto runProgramStartWindowType = it.GetObjectW().GetNamedNumber(KeyboardManagerConstants::RunProgramStartWindowType, 0);
+                    auto runProgramFilePath = it.get_named_string(KeyboardManagerConstants::RunProgramFilePathSettingName, L"");
+                    auto runProgramArgs = it.get_named_string(KeyboardManagerConstants::RunProgramArgsSettingName, L"");
+                    auto runProgramStartInDir = it.get_named_string(KeyboardManagerConstants::RunProgramStartInDirSettingName, L"");
+                    auto runProgramElevationLevel = it.get_named_number(KeyboardManagerConstants::RunProgramElevationLevelSettingName, 0);
+                    auto runProgramAlreadyRunningAction = it.get_named_number(KeyboardManagerConstants::RunProgramAlreadyRunningAction, 0);
+                    auto runProgramStartWindowType = it.get_named_number(KeyboardManagerConstants::RunProgramStartWindowType, 0);
 
                     auto tempShortcut = Shortcut(newRemapKeys.c_str());
                     tempShortcut.operationType = Shortcut::OperationType::RunProgram;
@@ -264,7 +256,7 @@ bool MappingConfiguration::LoadAppSpecificShortcutRemaps(const json::JsonObject&
                 {
                     auto tempShortcut = Shortcut(newRemapKeys.c_str());
                     tempShortcut.operationType = Shortcut::OperationType::OpenURI;
-                    tempShortcut.uriToOpen = it.GetObjectW().GetNamedString(KeyboardManagerConstants::ShortcutOpenURI, L"");
+                    tempShortcut.uriToOpen = it.get_named_string(KeyboardManagerConstants::ShortcutOpenURI, L"");
 
                     AddAppSpecificShortcut(targetApp.c_str(), originalShortcut, tempShortcut);
                 }
@@ -304,99 +296,96 @@ bool MappingConfiguration::LoadAppSpecificShortcutRemaps(const json::JsonObject&
     return result;
 }
 
-bool MappingConfiguration::LoadShortcutRemaps(const json::JsonObject& jsonData, const std::wstring& objectName)
+bool MappingConfiguration::LoadShortcutRemaps(const json::native::Value& jsonData, const std::wstring& objectName)
 {
     bool result = true;
 
     try
     {
-        auto remapShortcutsData = jsonData.GetNamedObject(objectName);
-        if (remapShortcutsData)
+        const auto& remapShortcutsData = jsonData.get_named_object(objectName);
+        // Load os level shortcut remaps
+        try
         {
-            // Load os level shortcut remaps
-            try
+            const auto& globalRemapShortcuts = remapShortcutsData.get_named_array(KeyboardManagerConstants::GlobalRemapShortcutsSettingName);
+            for (const auto& it : globalRemapShortcuts)
             {
-                auto globalRemapShortcuts = remapShortcutsData.GetNamedArray(KeyboardManagerConstants::GlobalRemapShortcutsSettingName);
-                for (const auto& it : globalRemapShortcuts)
+                try
                 {
-                    try
+                    auto originalKeys = it.get_named_string(KeyboardManagerConstants::OriginalKeysSettingName);
+                    auto newRemapKeys = it.get_named_string(KeyboardManagerConstants::NewRemapKeysSettingName, {});
+                    auto newRemapText = it.get_named_string(KeyboardManagerConstants::NewTextSettingName, {});
+                    auto operationType = it.get_named_number(KeyboardManagerConstants::ShortcutOperationType, 0);
+
+                    auto originalShortcut = Shortcut(originalKeys.c_str());
+                    originalShortcut.exactMatch = it.get_named_boolean(KeyboardManagerConstants::ShortcutExactMatch, false);
+                    // undo dummy data for backwards compatibility
+                    if (newRemapText == L"*Unsupported*")
                     {
-                        auto originalKeys = it.GetObjectW().GetNamedString(KeyboardManagerConstants::OriginalKeysSettingName);
-                        auto newRemapKeys = it.GetObjectW().GetNamedString(KeyboardManagerConstants::NewRemapKeysSettingName, {});
-                        auto newRemapText = it.GetObjectW().GetNamedString(KeyboardManagerConstants::NewTextSettingName, {});
-                        auto operationType = it.GetObjectW().GetNamedNumber(KeyboardManagerConstants::ShortcutOperationType, 0);
-
-                        auto originalShortcut = Shortcut(originalKeys.c_str());
-                        originalShortcut.exactMatch = it.GetObjectW().GetNamedBoolean(KeyboardManagerConstants::ShortcutExactMatch, false);
-                        // undo dummy data for backwards compatibility
-                        if (newRemapText == L"*Unsupported*")
-                        {
-                            newRemapText == L"";
-                        }
+                        newRemapText == L"";
+                    }
 
-                        // check Shortcut::OperationType
-                        if (operationType == 1)
-                        {
-                            auto runProgramFilePath = it.GetObjectW().GetNamedString(KeyboardManagerConstants::RunProgramFilePathSettingName, L"");
-                            auto runProgramArgs = it.GetObjectW().GetNamedString(KeyboardManagerConstants::RunProgramArgsSettingName, L"");
-                            auto runProgramStartInDir = it.GetObjectW().GetNamedString(KeyboardManagerConstants::RunProgramStartInDirSettingName, L"");
-                            auto runProgramElevationLevel = it.GetObjectW().GetNamedNumber(KeyboardManagerConstants::RunProgramElevationLevelSettingName, 0);
-                            auto runProgramStartWindowType = it.GetObjectW().GetNamedNumber(KeyboardManagerConstants::RunProgramStartWindowType, 0);
-                            auto runProgramAlreadyRunningAction = it.GetObjectW().GetNamedNumber(KeyboardManagerConstants::RunProgramAlreadyRunningAction, 0);
-
-                            auto tempShortcut = Shortcut(newRemapKeys.c_str());
-                            tempShortcut.operationType = Shortcut::OperationType::RunProgram;
-                            tempShortcut.runProgramFilePath = runProgramFilePath;
-                            tempShortcut.runProgramArgs = runProgramArgs;
-                            tempShortcut.runProgramStartInDir = runProgramStartInDir;
-                            tempShortcut.elevationLevel = static_cast<Shortcut::ElevationLevel>(runProgramElevationLevel);
-                            tempShortcut.alreadyRunningAction = static_cast<Shortcut::ProgramAlreadyRunningAction>(runProgramAlreadyRunningAction);
-                            tempShortcut.startWindowType = static_cast<Shortcut::StartWindowType>(runProgramStartWindowType);
-
-                            AddOSLevelShortcut(originalShortcut, tempShortcut);
-                        }
-                        else if (operationType == 2)
-                        {
-                            auto tempShortcut = Shortcut(newRemapKeys.c_str());
-                            tempShortcut.operationType = Shortcut::OperationType::OpenURI;
-                            tempShortcut.uriToOpen = it.GetObjectW().GetNamedString(KeyboardManagerConstants::ShortcutOpenURI, L"");
+                    // check Shortcut::OperationType
+                    if (operationType == 1)
+                    {
+                        auto runProgramFilePath = it.get_named_string(KeyboardManagerConstants::RunProgramFilePathSettingName, L"");
+                        auto runProgramArgs = it.get_named_string(KeyboardManagerConstants::RunProgramArgsSettingName, L"");
+                        auto runProgramStartInDir = it.get_named_string(KeyboardManagerConstants::RunProgramStartInDirSettingName, L"");
+                        auto runProgramElevationLevel = it.get_named_number(KeyboardManagerConstants::RunProgramElevationLevelSettingName, 0);
+                        auto runProgramStartWindowType = it.get_named_number(KeyboardManagerConstants::RunProgramStartWindowType, 0);
+                        auto runProgramAlreadyRunningAction = it.get_named_number(KeyboardManagerConstants::RunProgramAlreadyRunningAction, 0);
+
+                        auto tempShortcut = Shortcut(newRemapKeys.c_str());
+                        tempShortcut.operationType = Shortcut::OperationType::RunProgram;
+                        tempShortcut.runProgramFilePath = runProgramFilePath;
+                        tempShortcut.runProgramArgs = runProgramArgs;
+                        tempShortcut.runProgramStartInDir = runProgramStartInDir;
+                        tempShortcut.elevationLevel = static_cast<Shortcut::ElevationLevel>(runProgramElevationLevel);
+                        tempShortcut.alreadyRunningAction = static_cast<Shortcut::ProgramAlreadyRunningAction>(runProgramAlreadyRunningAction);
+                        tempShortcut.startWindowType = static_cast<Shortcut::StartWindowType>(runProgramStartWindowType);
+
+                        AddOSLevelShortcut(originalShortcut, tempShortcut);
+                    }
+                    else if (operationType == 2)
+                    {
+                        auto tempShortcut = Shortcut(newRemapKeys.c_str());
+                        tempShortcut.operationType = Shortcut::OperationType::OpenURI;
+                        tempShortcut.uriToOpen = it.get_named_string(KeyboardManagerConstants::ShortcutOpenURI, L"");
 
-                            AddOSLevelShortcut(originalShortcut, tempShortcut);
-                        }
-                        else if (!newRemapKeys.empty())
+                        AddOSLevelShortcut(originalShortcut, tempShortcut);
+                    }
+                    else if (!newRemapKeys.empty())
+                    {
+                        // If remapped to a shortcut
+                        if (std::wstring(newRemapKeys).find(L";") != std::string::npos)
                         {
-                            // If remapped to a shortcut
-                            if (std::wstring(newRemapKeys).find(L";") != std::string::npos)
-                            {
-                                AddOSLevelShortcut(originalShortcut, Shortcut(newRemapKeys.c_str()));
-                            }
-                            // If remapped to a key
-                            else
-                            {
-                                AddOSLevelShortcut(originalShortcut, std::stoul(newRemapKeys.c_str()));
-                            }
+                            AddOSLevelShortcut(originalShortcut, Shortcut(newRemapKeys.c_str()));
                         }
+                        // If remapped to a key
                         else
                         {
-                            AddOSLevelShortcut(originalShortcut, newRemapText.c_str());
+                            AddOSLevelShortcut(originalShortcut, std::stoul(newRemapKeys.c_str()));
                         }
                     }
-                    catch (...)
+                    else
                     {
-                        Logger::error(L"Improper Key Data JSON. Try the next shortcut.");
-                        result = false;
+                        AddOSLevelShortcut(originalShortcut, newRemapText.c_str());
                     }
                 }
+                catch (...)
+                {
+                    Logger::error(L"Improper Key Data JSON. Try the next shortcut.");
+                    result = false;
+                }
             }
-            catch (...)
-            {
-                Logger::error(L"Improper JSON format for os level shortcut remaps. Skip to next remap type");
-                result = false;
-            }
-
-            // Load app specific shortcut remaps
-            result = result && LoadAppSpecificShortcutRemaps(remapShortcutsData);
         }
+        catch (...)
+        {
+            Logger::error(L"Improper JSON format for os level shortcut remaps. Skip to next remap type");
+            result = false;
+        }
+
+        // Load app specific shortcut remaps
+        result = result && LoadAppSpecificShortcutRemaps(remapShortcutsData);
     }
     catch (...)
     {
@@ -423,18 +412,18 @@ bool MappingConfiguration::LoadSettings()
         currentConfig = *current_config;
 
         // Read the config file and load the remaps.
-        auto configFile = json::from_file(PTSettingsHelper::get_module_save_folder_location(KeyboardManagerConstants::ModuleName) + L"\\" + *current_config + L".json");
+        auto configFile = json::native::from_file(PTSettingsHelper::get_module_save_folder_location(KeyboardManagerConstants::ModuleName) + L"\\" + *current_config + L".json");
         if (!configFile)
         {
             return false;
         }
 
-        bool result = LoadSingleKeyRemaps(*configFile);
+        bool result = LoadSingleKeyRemaps(configFile->root());
         ClearOSLevelShortcuts();
         ClearAppSpecificShortcuts();
-        result = LoadShortcutRemaps(*configFile, KeyboardManagerConstants::RemapShortcutsSettingName) && result;
-        result = LoadShortcutRemaps(*configFile, KeyboardManagerConstants::RemapShortcutsToTextSettingName) && result;
-        result = LoadSingleKeyToTextRemaps(*configFile) && result;
+        result = LoadShortcutRemaps(configFile->root(), KeyboardManagerConstants::RemapShortcutsSettingName) && result;
+        result = LoadShortcutRemaps(configFile->root(), KeyboardManagerConstants::RemapShortcutsToTextSettingName) && result;
+        result = LoadSingleKeyToTextRemaps(configFile->root()) && result;
 
         return result;
     }
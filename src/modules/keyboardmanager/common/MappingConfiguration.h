@@ -1,6 +1,7 @@
 #pragma once
 
 #include <common/utils/json.h>
+#include <common/utils/native_json.h>
 
 #include <keyboardmanager/common/KeyboardManagerConstants.h>
 #include <keyboardmanager/common/Shortcut.h>
@@ -70,8 +71,8 @@ public:
     std::wstring currentConfig = KeyboardManagerConstants::DefaultConfiguration;
 
 private:
-    bool LoadSingleKeyRemaps(const json::JsonObject& jsonData);
-    bool LoadSingleKeyToTextRemaps(const json::JsonObject& jsonData);
-    bool LoadShortcutRemaps(const json::JsonObject& jsonData, const std::wstring& objectName);
-    bool LoadAppSpecificShortcutRemaps(const json::JsonObject& remapShortcutsData);
+    bool LoadSingleKeyRemaps(const json::native::Value& jsonData);
+    bool LoadSingleKeyToTextRemaps(const json::native::Value& jsonData);
+    bool LoadShortcutRemaps(const json::native::Value& jsonData, const std::wstring& objectName);
+    bool LoadAppSpecificShortcutRemaps(const json::native::Value& remapShortcutsData);
 };
\ No newline at end of file
@@ -113,7 +113,7 @@ namespace winrt::PowerToys::PowerAccentKeyboardService::implementation
         }
         {
             std::lock_guard<std::mutex> lock(m_mutex_excluded_apps);
-            m_settings.excludedApps = std::move(excludedApps);
+            m_settings.excludedApps = ExcludedAppsMatcher(excludedApps);
             m_prevForegroundAppExcl = { NULL, false };
         }
     }
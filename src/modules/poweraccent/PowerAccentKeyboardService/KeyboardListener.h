@@ -3,6 +3,7 @@
 #include "KeyboardListener.g.h"
 #include <mutex>
 #include <spdlog/stopwatch.h>
+#include <common/utils/excluded_apps.h>
 
 namespace winrt::PowerToys::PowerAccentKeyboardService::implementation
 {
@@ -18,7 +19,7 @@ namespace winrt::PowerToys::PowerAccentKeyboardService::implementation
         PowerAccentActivationKey activationKey{ PowerAccentActivationKey::Both };
         bool doNotActivateOnGameMode{ true };
         std::chrono::milliseconds inputTime{ 300 }; // Should match with UI.Library.PowerAccentSettings.DefaultInputTimeMs
-        std::vector<std::wstring> excludedApps;
+        ExcludedAppsMatcher excludedApps;
     };
 
     struct KeyboardListener : KeyboardListenerT<KeyboardListener>
@@ -1,25 +1,159 @@
 #include "pch.h"
 #include "GcodeThumbnailProvider.h"
 
+#include <cstring>
 #include <filesystem>
-#include <fstream>
-#include <shellapi.h>
 #include <Shlwapi.h>
 #include <string>
+#include <wincodec.h>
 
 #include <wil/com.h>
 
-#include <common/utils/process_path.h>
 #include <common/interop/shared_constants.h>
 #include <common/logger/logger.h>
 #include <common/SettingsAPI/settings_helpers.h>
-#include <common/utils/process_path.h>
+#include <common/utils/gcode_thumbnail.h>
+#include <common/utils/gpo.h>
+#include <common/utils/qoi_decoder.h>
+#include <common/utils/thumbnail_cache.h>
+#include <common/utils/winapi_error.h>
 
 extern HINSTANCE g_hInst;
 extern long g_cDllRef;
 
+namespace
+{
+    // The maximum dimension (width or height) thumbnail we will generate.
+    constexpr UINT MaxThumbnailSize = 10000;
+
+    // Thumbnails rendered before, by any provider and host process
+    thumbnail_cache::Cache& GetCache()
+    {
+        static thumbnail_cache::Cache cache{ PTSettingsHelper::get_local_low_folder_location() + L"\\ThumbnailCache" };
+        return cache;
+    }
+
+    HBITMAP CreateThumbnailBitmap(UINT width, UINT height, void** bits)
+    {
+        BITMAPINFO bmi{};
+        bmi.bmiHeader.biSize = sizeof(bmi.bmiHeader);
+        bmi.bmiHeader.biWidth = static_cast<LONG>(width);
+        bmi.bmiHeader.biHeight = -static_cast<LONG>(height);
+        bmi.bmiHeader.biPlanes = 1;
+        bmi.bmiHeader.biBitCount = 32;
+        bmi.bmiHeader.biCompression = BI_RGB;
+        return CreateDIBSection(NULL, &bmi, DIB_RGB_COLORS, bits, NULL, 0);
+    }
+
+    HRESULT DecodeQoi(const std::vector<uint8_t>& data, UINT cx, HBITMAP* phbmp)
+    {
+        size_t position = 0;
+        auto reader = [&](uint8_t* buffer, size_t size) -> size_t {
+            const size_t count = (std::min)(size, data.size() - position);
+            std::memcpy(buffer, data.data() + position, count);
+            position += count;
+            return count;
+        };
+
+        auto image = qoi::decode(reader, cx);
+        if (!image)
+        {
+            return E_FAIL;
+        }
+
+        void* bits = nullptr;
+        HBITMAP bitmap = CreateThumbnailBitmap(image->width, image->height, &bits);
+        if (!bitmap)
+        {
+            return E_OUTOFMEMORY;
+        }
+
+        std::memcpy(bits, image->bgra.data(), image->bgra.size());
+        *phbmp = bitmap;
+        return S_OK;
+    }
+
+    // PNG and JPG, scaled down to fit cx by WIC
+    HRESULT DecodeWithWic(const std::vector<uint8_t>& data, UINT cx, HBITMAP* phbmp)
+    {
+        wil::com_ptr<IWICImagingFactory> factory;
+        HRESULT hr = CoCreateInstance(CLSID_WICImagingFactory, NULL, CLSCTX_INPROC_SERVER, IID_PPV_ARGS(&factory));
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+
+        wil::com_ptr<IStream> stream;
+        stream.attach(SHCreateMemStream(data.data(), static_cast<UINT>(data.size())));
+        if (!stream)
+        {
+            return E_OUTOFMEMORY;
+        }
+
+        wil::com_ptr<IWICBitmapDecoder> decoder;
+        wil::com_ptr<IWICBitmapFrameDecode> frame;
+        UINT width = 0;
+        UINT height = 0;
+        hr = factory->CreateDecoderFromStream(stream.get(), NULL, WICDecodeMetadataCacheOnDemand, &decoder);
+        if (SUCCEEDED(hr))
+        {
+            hr = decoder->GetFrame(0, &frame);
+        }
+        if (SUCCEEDED(hr))
+        {
+            hr = frame->GetSize(&width, &height);
+        }
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+
+        const auto [scaledWidth, scaledHeight] = qoi::fit_size(width, height, cx);
+        wil::com_ptr<IWICBitmapSource> source = frame;
+        if (scaledWidth != width || scaledHeight != height)
+        {
+            wil::com_ptr<IWICBitmapScaler> scaler;
+            hr = factory->CreateBitmapScaler(&scaler);
+            if (SUCCEEDED(hr))
+            {
+                hr = scaler->Initialize(frame.get(), scaledWidth, scaledHeight, WICBitmapInterpolationModeFant);
+            }
+            if (FAILED(hr))
+            {
+                return hr;
+            }
+            source = scaler;
+        }
+
+        wil::com_ptr<IWICBitmapSource> converted;
+        hr = WICConvertBitmapSource(GUID_WICPixelFormat32bppBGRA, source.get(), &converted);
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+
+        void* bits = nullptr;
+        HBITMAP bitmap = CreateThumbnailBitmap(scaledWidth, scaledHeight, &bits);
+        if (!bitmap)
+        {
+            return E_OUTOFMEMORY;
+        }
+
+        const UINT stride = scaledWidth * 4;
+        hr = converted->CopyPixels(NULL, stride, stride * scaledHeight, static_cast<BYTE*>(bits));
+        if (FAILED(hr))
+        {
+            DeleteObject(bitmap);
+            return hr;
+        }
+
+        *phbmp = bitmap;
+        return S_OK;
+    }
+}
+
 GcodeThumbnailProvider::GcodeThumbnailProvider() :
-    m_cRef(1), m_pStream(NULL), m_process(NULL)
+    m_cRef(1), m_pStream(NULL)
 {
     std::filesystem::path logFilePath(PTSettingsHelper::get_local_low_folder_location());
     logFilePath.append(LogSettings::gcodeThumbLogPath);
@@ -92,108 +226,73 @@ IFACEMETHODIMP GcodeThumbnailProvider::Initialize(IStream* pStream, DWORD grfMod
 
 IFACEMETHODIMP GcodeThumbnailProvider::GetThumbnail(UINT cx, HBITMAP* phbmp, WTS_ALPHATYPE* pdwAlpha)
 {
-    // Read stream into the buffer
-    char buffer[4096];
-    ULONG cbRead;
-
     Logger::trace(L"Begin");
 
-    GUID guid;
-    if (CoCreateGuid(&guid) == S_OK)
+    if (!m_pStream)
     {
-        wil::unique_cotaskmem_string guidString;
-        if (SUCCEEDED(StringFromCLSID(guid, &guidString)))
-        {
-            Logger::info(L"Read stream and save to tmp file.");
-
-            // {CLSID} -> CLSID
-            std::wstring guid = std::wstring(guidString.get()).substr(1, std::wstring(guidString.get()).size() - 2);
-            std::wstring filePath = PTSettingsHelper::get_local_low_folder_location() + L"\\GCodeThumbnail-Temp\\";
-            if (!std::filesystem::exists(filePath))
-            {
-                std::filesystem::create_directories(filePath);
-            }
+        return E_UNEXPECTED;
+    }
 
-            std::wstring fileName = filePath + guid + L".gcode";
-            
-            // Write data to tmp file
-            std::fstream file;
-            file.open(fileName, std::ios_base::out | std::ios_base::binary);
+    // Release the stream in every branch
+    wil::com_ptr<IStream> stream;
+    stream.attach(m_pStream);
+    m_pStream = NULL;
 
-            if (!file.is_open())
-            {
-                return 0;
-            }
+    if (cx == 0 || cx > MaxThumbnailSize)
+    {
+        return E_INVALIDARG;
+    }
 
-            while (true)
-            {
-                auto result = m_pStream->Read(buffer, 4096, &cbRead);
+    if (powertoys_gpo::getConfiguredGcodeThumbnailsEnabledValue() == powertoys_gpo::gpo_rule_configured_disabled)
+    {
+        // GPO is disabling this utility.
+        return E_FAIL;
+    }
 
-                file.write(buffer, cbRead);
-                if (result == S_FALSE)
-                {               
-                    break;
-                }
-            }
-            file.close();
+    auto& cache = GetCache();
+    const auto key = cache.make_key(stream.get(), cx, thumbnail_cache::Source::Gcode);
+    if (key && cache.find(*key, cx, phbmp))
+    {
+        *pdwAlpha = WTS_ALPHATYPE::WTSAT_ARGB;
+        return S_OK;
+    }
 
-            m_pStream->Release();
-            m_pStream = NULL;
+    // Rendered at the size of the bucket, so the other sizes in it are served from the cache too
+    const UINT renderSize = key ? key->bucket : cx;
 
-            try
-            {
-                Logger::info(L"Start GcodeThumbnailProvider.exe");
-
-                STARTUPINFO info = { sizeof(info) };
-                std::wstring cmdLine{ L"\"" + fileName + L"\"" };
-                cmdLine += L" ";
-                cmdLine += std::to_wstring(cx);
-
-                std::wstring appPath = get_module_folderpath(g_hInst) + L"\\PowerToys.GcodeThumbnailProvider.exe";
-
-                SHELLEXECUTEINFO sei{ sizeof(sei) };
-                sei.fMask = { SEE_MASK_NOCLOSEPROCESS | SEE_MASK_FLAG_NO_UI };
-                sei.lpFile = appPath.c_str();
-                sei.lpParameters = cmdLine.c_str();
-                sei.nShow = SW_SHOWDEFAULT;
-                ShellExecuteEx(&sei);
-                m_process = sei.hProcess;
-                WaitForSingleObject(m_process, INFINITE);
-                std::filesystem::remove(fileName);
-
-
-                std::wstring fileNameBmp = filePath + guid + L".bmp";
-                if (std::filesystem::exists(fileNameBmp))
-                {
-                    *phbmp = static_cast<HBITMAP>(LoadImage(NULL, fileNameBmp.c_str(), IMAGE_BITMAP, 0, 0, LR_LOADFROMFILE));
-                    *pdwAlpha = WTS_ALPHATYPE::WTSAT_ARGB;
-                    std::filesystem::remove(fileNameBmp);
-                }
-                else
-                {
-                    Logger::info(L"Bmp file not generated.");
-                    return E_FAIL;
-                }
-            }
-            catch (std::exception& e)
-            {
-                std::wstring errorMessage = std::wstring{ winrt::to_hstring(e.what()) };
-                Logger::error(L"Failed to start GcodeThumbnailProvider.exe. Error: {}", errorMessage);
-            }
+    auto reader = [&stream](uint8_t* buffer, size_t size) -> size_t {
+        ULONG read = 0;
+        if (FAILED(stream->Read(buffer, static_cast<ULONG>(size), &read)))
+        {
+            return 0;
         }
+        return read;
+    };
+
+    // Only the top of the file is read, the thumbnails come before the first command
+    auto thumbnail = gcode::find_thumbnail(reader, renderSize);
+    if (!thumbnail)
+    {
+        Logger::info(L"No thumbnail found in the G-code file.");
+        return E_FAIL;
     }
 
-    // ensure releasing the stream (not all if branches contain it)
-    if (m_pStream)
+    HRESULT hr = thumbnail->format == gcode::ThumbnailFormat::QOI ? DecodeQoi(thumbnail->data, renderSize, phbmp) : DecodeWithWic(thumbnail->data, renderSize, phbmp);
+    if (FAILED(hr))
     {
-        m_pStream->Release();
-        m_pStream = NULL;
+        Logger::error(L"Failed to decode the G-code thumbnail. {}", get_last_error_or_default(hr));
+        return hr;
     }
 
+    if (key)
+    {
+        cache.store(*key, *phbmp);
+        thumbnail_cache::fit(*phbmp, cx);
+    }
+    *pdwAlpha = WTS_ALPHATYPE::WTSAT_ARGB;
     return S_OK;
 }
 
-
 #pragma endregion
 
 #pragma region Helper Functions
@@ -17,11 +17,21 @@ namespace Microsoft.PowerToys.ThumbnailHandler.Pdf
             FilePath = filePath;
         }
 
+        public PdfThumbnailProvider(Stream stream)
+        {
+            Stream = stream;
+        }
+
         /// <summary>
         /// Gets the file path to the file creating thumbnail for.
         /// </summary>
         public string FilePath { get; private set; }
 
+        /// <summary>
+        /// Gets the stream with the file content, used instead of the file path when set.
+        /// </summary>
+        public Stream Stream { get; private set; }
+
         /// <summary>
         ///  The maximum dimension (width or height) thumbnail we will generate.
         /// </summary>
@@ -58,8 +68,16 @@ namespace Microsoft.PowerToys.ThumbnailHandler.Pdf
             Bitmap thumbnail = null;
             try
             {
-                var file = await StorageFile.GetFileFromPathAsync(FilePath);
-                var pdf = await PdfDocument.LoadFromFileAsync(file);
+                PdfDocument pdf;
+                if (Stream != null)
+                {
+                    pdf = await PdfDocument.LoadFromStreamAsync(Stream.AsRandomAccessStream());
+                }
+                else
+                {
+                    var file = await StorageFile.GetFileFromPathAsync(FilePath);
+                    pdf = await PdfDocument.LoadFromFileAsync(file);
+                }
 
                 if (pdf.PageCount > 0)
                 {
@@ -4,6 +4,9 @@
 
 using System.Globalization;
 
+using Common.Utilities;
+using ManagedCommon;
+
 namespace Microsoft.PowerToys.ThumbnailHandler.Pdf
 {
     internal static class Program
@@ -17,7 +20,14 @@ namespace Microsoft.PowerToys.ThumbnailHandler.Pdf
         public static void Main(string[] args)
         {
             ApplicationConfiguration.Initialize();
-            if (args != null)
+            if (ThumbnailWorker.IsWorkerCommandLine(args))
+            {
+                ThumbnailWorker.Run(
+                    args[1],
+                    (stream, cx) => new PdfThumbnailProvider(stream).GetThumbnail(cx),
+                    (message, ex) => Logger.LogError(message, ex));
+            }
+            else if (args != null)
             {
                 if (args.Length == 2)
                 {
@@ -1,25 +1,38 @@
 #include "pch.h"
 #include "QoiThumbnailProvider.h"
 
+#include <cstring>
 #include <filesystem>
-#include <fstream>
-#include <shellapi.h>
 #include <Shlwapi.h>
 #include <string>
 
 #include <wil/com.h>
 
-#include <common/utils/process_path.h>
 #include <common/interop/shared_constants.h>
 #include <common/logger/logger.h>
 #include <common/SettingsAPI/settings_helpers.h>
-#include <common/utils/process_path.h>
+#include <common/utils/gpo.h>
+#include <common/utils/qoi_decoder.h>
+#include <common/utils/thumbnail_cache.h>
 
 extern HINSTANCE g_hInst;
 extern long g_cDllRef;
 
+namespace
+{
+    // The maximum dimension (width or height) thumbnail we will generate.
+    constexpr UINT MaxThumbnailSize = 10000;
+
+    // Thumbnails rendered before, by any provider and host process
+    thumbnail_cache::Cache& GetCache()
+    {
+        static thumbnail_cache::Cache cache{ PTSettingsHelper::get_local_low_folder_location() + L"\\ThumbnailCache" };
+        return cache;
+    }
+}
+
 QoiThumbnailProvider::QoiThumbnailProvider() :
-    m_cRef(1), m_pStream(NULL), m_process(NULL)
+    m_cRef(1), m_pStream(NULL)
 {
     std::filesystem::path logFilePath(PTSettingsHelper::get_local_low_folder_location());
     logFilePath.append(LogSettings::qoiThumbLogPath);
@@ -92,108 +105,84 @@ IFACEMETHODIMP QoiThumbnailProvider::Initialize(IStream* pStream, DWORD grfMode)
 
 IFACEMETHODIMP QoiThumbnailProvider::GetThumbnail(UINT cx, HBITMAP* phbmp, WTS_ALPHATYPE* pdwAlpha)
 {
-    // Read stream into the buffer
-    char buffer[4096];
-    ULONG cbRead;
-
     Logger::trace(L"Begin");
 
-    GUID guid;
-    if (CoCreateGuid(&guid) == S_OK)
+    if (!m_pStream)
     {
-        wil::unique_cotaskmem_string guidString;
-        if (SUCCEEDED(StringFromCLSID(guid, &guidString)))
-        {
-            Logger::info(L"Read stream and save to tmp file.");
-
-            // {CLSID} -> CLSID
-            std::wstring guid = std::wstring(guidString.get()).substr(1, std::wstring(guidString.get()).size() - 2);
-            std::wstring filePath = PTSettingsHelper::get_local_low_folder_location() + L"\\QoiThumbnail-Temp\\";
-            if (!std::filesystem::exists(filePath))
-            {
-                std::filesystem::create_directories(filePath);
-            }
-
-            std::wstring fileName = filePath + guid + L".qoi";
-            
-            // Write data to tmp file
-            std::fstream file;
-            file.open(fileName, std::ios_base::out | std::ios_base::binary);
-
-            if (!file.is_open())
-            {
-                return 0;
-            }
-
-            while (true)
-            {
-                auto result = m_pStream->Read(buffer, 4096, &cbRead);
-
-                file.write(buffer, cbRead);
-                if (result == S_FALSE)
-                {               
-                    break;
-                }
-            }
-            file.close();
+        return E_UNEXPECTED;
+    }
 
-            m_pStream->Release();
-            m_pStream = NULL;
+    // Release the stream in every branch
+    wil::com_ptr<IStream> stream;
+    stream.attach(m_pStream);
+    m_pStream = NULL;
+
+    if (cx == 0 || cx > MaxThumbnailSize)
+    {
+        return E_INVALIDARG;
+    }
 
-            try
-            {
-                Logger::info(L"Start QoiThumbnailProvider.exe");
-
-                STARTUPINFO info = { sizeof(info) };
-                std::wstring cmdLine{ L"\"" + fileName + L"\"" };
-                cmdLine += L" ";
-                cmdLine += std::to_wstring(cx);
-
-                std::wstring appPath = get_module_folderpath(g_hInst) + L"\\PowerToys.QoiThumbnailProvider.exe";
-
-                SHELLEXECUTEINFO sei{ sizeof(sei) };
-                sei.fMask = { SEE_MASK_NOCLOSEPROCESS | SEE_MASK_FLAG_NO_UI };
-                sei.lpFile = appPath.c_str();
-                sei.lpParameters = cmdLine.c_str();
-                sei.nShow = SW_SHOWDEFAULT;
-                ShellExecuteEx(&sei);
-                m_process = sei.hProcess;
-                WaitForSingleObject(m_process, INFINITE);
-                std::filesystem::remove(fileName);
-
-
-                std::wstring fileNameBmp = filePath + guid + L".bmp";
-                if (std::filesystem::exists(fileNameBmp))
-                {
-                    *phbmp = static_cast<HBITMAP>(LoadImage(NULL, fileNameBmp.c_str(), IMAGE_BITMAP, 0, 0, LR_LOADFROMFILE));
-                    *pdwAlpha = WTS_ALPHATYPE::WTSAT_ARGB;
-                    std::filesystem::remove(fileNameBmp);
-                }
-                else
-                {
-                    Logger::info(L"Bmp file not generated.");
-                    return E_FAIL;
-                }
-            }
-            catch (std::exception& e)
-            {
-                std::wstring errorMessage = std::wstring{ winrt::to_hstring(e.what()) };
-                Logger::error(L"Failed to start QoiThumbnailProvider.exe. Error: {}", errorMessage);
-            }
+    if (powertoys_gpo::getConfiguredQoiThumbnailsEnabledValue() == powertoys_gpo::gpo_rule_configured_disabled)
+    {
+        // GPO is disabling this utility.
+        return E_FAIL;
+    }
+
+    auto& cache = GetCache();
+    const auto key = cache.make_key(stream.get(), cx, thumbnail_cache::Source::Qoi);
+    if (key && cache.find(*key, cx, phbmp))
+    {
+        *pdwAlpha = WTS_ALPHATYPE::WTSAT_ARGB;
+        return S_OK;
+    }
+
+    // Rendered at the size of the bucket, so the other sizes in it are served from the cache too
+    const UINT renderSize = key ? key->bucket : cx;
+
+    auto reader = [&stream](uint8_t* buffer, size_t size) -> size_t {
+        ULONG read = 0;
+        if (FAILED(stream->Read(buffer, static_cast<ULONG>(size), &read)))
+        {
+            return 0;
         }
+        return read;
+    };
+
+    // Decoded straight from the stream, scaled down while decoding
+    auto image = qoi::decode(reader, renderSize);
+    if (!image)
+    {
+        Logger::error(L"Failed to decode the QOI image.");
+        return E_FAIL;
     }
 
-    // ensure releasing the stream (not all if branches contain it)
-    if (m_pStream)
+    BITMAPINFO bmi{};
+    bmi.bmiHeader.biSize = sizeof(bmi.bmiHeader);
+    bmi.bmiHeader.biWidth = static_cast<LONG>(image->width);
+    bmi.bmiHeader.biHeight = -static_cast<LONG>(image->height);
+    bmi.bmiHeader.biPlanes = 1;
+    bmi.bmiHeader.biBitCount = 32;
+    bmi.bmiHeader.biCompression = BI_RGB;
+
+    void* bits = nullptr;
+    HBITMAP bitmap = CreateDIBSection(NULL, &bmi, DIB_RGB_COLORS, &bits, NULL, 0);
+    if (!bitmap)
     {
-        m_pStream->Release();
-        m_pStream = NULL;
+        Logger::error(L"Failed to create the thumbnail bitmap.");
+        return E_OUTOFMEMORY;
     }
 
+    std::memcpy(bits, image->bgra.data(), image->bgra.size());
+    if (key)
+    {
+        cache.store(*key, bitmap);
+        thumbnail_cache::fit(bitmap, cx);
+    }
+    *phbmp = bitmap;
+    *pdwAlpha = WTS_ALPHATYPE::WTSAT_ARGB;
     return S_OK;
 }
 
-
 #pragma endregion
 
 #pragma region Helper Functions
@@ -2,8 +2,6 @@
 #include "StlThumbnailProvider.h"
 
 #include <filesystem>
-#include <fstream>
-#include <shellapi.h>
 #include <Shlwapi.h>
 #include <string>
 
@@ -12,13 +10,28 @@
 #include <common/interop/shared_constants.h>
 #include <common/logger/logger.h>
 #include <common/SettingsAPI/settings_helpers.h>
-#include <common/utils/process_path.h>
+#include <common/utils/gpo.h>
+#include <common/utils/native_json.h>
+#include <common/utils/thumbnail_cache.h>
 
 extern HINSTANCE g_hInst;
 extern long g_cDllRef;
 
+namespace
+{
+    // The maximum dimension (width or height) thumbnail we will generate.
+    constexpr UINT MaxThumbnailSize = 10000;
+
+    // Thumbnails rendered before, by any provider and host process
+    thumbnail_cache::Cache& GetCache()
+    {
+        static thumbnail_cache::Cache cache{ PTSettingsHelper::get_local_low_folder_location() + L"\\ThumbnailCache" };
+        return cache;
+    }
+}
+
 StlThumbnailProvider::StlThumbnailProvider() :
-    m_cRef(1), m_pStream(NULL), m_process(NULL)
+    m_cRef(1), m_pStream(NULL)
 {
     std::filesystem::path logFilePath(PTSettingsHelper::get_local_low_folder_location());
     logFilePath.append(LogSettings::stlThumbLogPath);
@@ -91,103 +104,92 @@ IFACEMETHODIMP StlThumbnailProvider::Initialize(IStream* pStream, DWORD grfMode)
 
 IFACEMETHODIMP StlThumbnailProvider::GetThumbnail(UINT cx, HBITMAP* phbmp, WTS_ALPHATYPE* pdwAlpha)
 {
-    // Read stream into the buffer
-    char buffer[4096];
-    ULONG cbRead;
-
     Logger::trace(L"Begin");
 
-    GUID guid;
-    if (CoCreateGuid(&guid) == S_OK)
+    if (!m_pStream)
     {
-        wil::unique_cotaskmem_string guidString;
-        if (SUCCEEDED(StringFromCLSID(guid, &guidString)))
-        {
-            Logger::info(L"Read stream and save to tmp file.");
-            
-            // {CLSID} -> CLSID
-            std::wstring guid = std::wstring(guidString.get()).substr(1, std::wstring(guidString.get()).size() - 2);
-            std::wstring filePath = PTSettingsHelper::get_local_low_folder_location() + L"\\StlThumbnail-Temp\\";
-            if (!std::filesystem::exists(filePath))
-            {
-                std::filesystem::create_directories(filePath);
-            }
-
-            std::wstring fileName = filePath + guid + L".stl";
-
-            // Write data to tmp file
-            std::fstream file;
-            file.open(fileName, std::ios_base::out | std::ios_base::binary);
-
-            if (!file.is_open())
-            {
-                return 0;
-            }
-
-            while (true)
-            {
-                auto result = m_pStream->Read(buffer, 4096, &cbRead);
-
-                file.write(buffer, cbRead);
-                if (result == S_FALSE)
-                {
-                    break;
-                }
-            }
-            file.close();
+        return E_UNEXPECTED;
+    }
 
-            m_pStream->Release();
-            m_pStream = NULL;
+    // Release the stream in every branch
+    wil::com_ptr<IStream> stream;
+    stream.attach(m_pStream);
+    m_pStream = NULL;
+
+    if (cx == 0 || cx > MaxThumbnailSize)
+    {
+        return E_INVALIDARG;
+    }
 
-            try
-            {
-                Logger::info(L"Start StlThumbnailProvider.exe");
-                
-                STARTUPINFO info = { sizeof(info) };
-                std::wstring cmdLine{ L"\"" + fileName + L"\"" };
-                cmdLine += L" ";
-                cmdLine += std::to_wstring(cx);
-
-                std::wstring appPath = get_module_folderpath(g_hInst) + L"\\PowerToys.StlThumbnailProvider.exe";
-
-                SHELLEXECUTEINFO sei{ sizeof(sei) };
-                sei.fMask = { SEE_MASK_NOCLOSEPROCESS | SEE_MASK_FLAG_NO_UI };
-                sei.lpFile = appPath.c_str();
-                sei.lpParameters = cmdLine.c_str();
-                sei.nShow = SW_SHOWDEFAULT;
-                ShellExecuteEx(&sei);
-                m_process = sei.hProcess;
-                WaitForSingleObject(m_process, INFINITE);
-                std::filesystem::remove(fileName);
-
-                std::wstring fileNameBmp = filePath + guid + L".bmp";
-                if (std::filesystem::exists(fileNameBmp))
-                {
-                    *phbmp = static_cast<HBITMAP>(LoadImage(NULL, fileNameBmp.c_str(), IMAGE_BITMAP, 0, 0, LR_LOADFROMFILE));
-                    *pdwAlpha = WTS_ALPHATYPE::WTSAT_ARGB;
-                    std::filesystem::remove(fileNameBmp);
-                }
-                else
-                {
-                    Logger::info(L"Bmp file not generated.");
-                    return E_FAIL;
-                }
-            }
-            catch (std::exception& e)
-            {
-                std::wstring errorMessage = std::wstring{ winrt::to_hstring(e.what()) };
-                Logger::error(L"Failed to start StlThumbnailProvider.exe. Error: {}", errorMessage);
-            }
+    if (powertoys_gpo::getConfiguredStlThumbnailsEnabledValue() == powertoys_gpo::gpo_rule_configured_disabled)
+    {
+        // GPO is disabling this utility.
+        return E_FAIL;
+    }
+
+    // The color is part of the key, a new color in the Settings doesn't show the old thumbnails
+    const auto color = GetMaterialColor();
+    auto& cache = GetCache();
+    auto key = cache.make_key(stream.get(), cx, thumbnail_cache::Source::Stl, uint32_t{ color.r } << 16 | uint32_t{ color.g } << 8 | color.b);
+
+    // Rasterized at the size Explorer asked for, rendering at the size of the bucket would cost up to four
+    // times the pixels
+    if (key)
+    {
+        key->bucket = cx;
+    }
+
+    if (key && cache.find(*key, cx, phbmp))
+    {
+        *pdwAlpha = WTS_ALPHATYPE::WTSAT_ARGB;
+        return S_OK;
+    }
+
+    auto reader = [&stream](uint8_t* buffer, size_t size) -> size_t {
+        ULONG read = 0;
+        if (FAILED(stream->Read(buffer, static_cast<ULONG>(size), &read)))
+        {
+            return 0;
         }
+        return read;
+    };
+
+    // Parsed straight from the stream, huge meshes are decimated while they're read
+    auto mesh = stl::parse(reader);
+    if (!mesh)
+    {
+        Logger::error(L"Failed to parse the STL model.");
+        return E_FAIL;
+    }
+
+    if (mesh->stride > 1)
+    {
+        Logger::info(L"Drawing {} of {} triangles.", mesh->triangles.size(), mesh->source_triangles);
     }
 
-    // ensure releasing the stream (not all if branches contain it)
-    if (m_pStream)
+    BITMAPINFO bmi{};
+    bmi.bmiHeader.biSize = sizeof(bmi.bmiHeader);
+    bmi.bmiHeader.biWidth = static_cast<LONG>(cx);
+    bmi.bmiHeader.biHeight = -static_cast<LONG>(cx);
+    bmi.bmiHeader.biPlanes = 1;
+    bmi.bmiHeader.biBitCount = 32;
+    bmi.bmiHeader.biCompression = BI_RGB;
+
+    void* bits = nullptr;
+    HBITMAP bitmap = CreateDIBSection(NULL, &bmi, DIB_RGB_COLORS, &bits, NULL, 0);
+    if (!bitmap)
     {
-        m_pStream->Release();
-        m_pStream = NULL;
+        Logger::error(L"Failed to create the thumbnail bitmap.");
+        return E_OUTOFMEMORY;
     }
 
+    stl::render(*mesh, cx, color, static_cast<uint8_t*>(bits));
+    if (key)
+    {
+        cache.store(*key, bitmap);
+    }
+    *phbmp = bitmap;
+    *pdwAlpha = WTS_ALPHATYPE::WTSAT_ARGB;
     return S_OK;
 }
 
@@ -195,4 +197,45 @@ IFACEMETHODIMP StlThumbnailProvider::GetThumbnail(UINT cx, HBITMAP* phbmp, WTS_A
 
 #pragma region Helper Functions
 
+stl::Color StlThumbnailProvider::GetMaterialColor()
+{
+    // Same default as the Settings
+    stl::Color color{ 0xFF, 0xC9, 0x24 };
+
+    try
+    {
+        auto settings = json::native::from_file(PTSettingsHelper::get_module_save_file_location(L"File Explorer"));
+        if (!settings || !settings->root().is_object())
+        {
+            return color;
+        }
+
+        const auto& properties = settings->root().get_named_object(L"properties");
+        if (!properties.has_key(L"stl-thumbnail-color-setting"))
+        {
+            return color;
+        }
+
+        // #RRGGBB or #AARRGGBB, the alpha is ignored
+        const auto value = properties.get_named_object(L"stl-thumbnail-color-setting").get_named_string(L"value");
+        if ((value.size() != 7 && value.size() != 9) || value[0] != L'#')
+        {
+            return color;
+        }
+
+        const auto rgb = std::stoul(value.substr(value.size() - 6), nullptr, 16);
+        color = { static_cast<uint8_t>(rgb >> 16), static_cast<uint8_t>(rgb >> 8), static_cast<uint8_t>(rgb) };
+    }
+    catch (const json::native::error&)
+    {
+        Logger::warn(L"Failed to read the STL thumbnail color from the settings.");
+    }
+    catch (const std::logic_error&)
+    {
+        Logger::warn(L"The STL thumbnail color in the settings is invalid.");
+    }
+
+    return color;
+}
+
 #pragma endregion
@@ -6,6 +6,8 @@
 #include <string>
 #include <thumbcache.h>
 
+#include <common/utils/stl_rasterizer.h>
+
 class StlThumbnailProvider :
     public IInitializeWithStream,
     public IThumbnailProvider
@@ -33,5 +35,6 @@ private:
     // Provided during initialization.
     IStream* m_pStream;
 
-    HANDLE m_process;
+    // Color of the model from the File Explorer settings
+    static stl::Color GetMaterialColor();
 };
\ No newline at end of file
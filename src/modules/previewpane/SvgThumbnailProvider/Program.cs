@@ -4,6 +4,7 @@
 
 using System.Globalization;
 
+using Common.Utilities;
 using ManagedCommon;
 
 namespace Microsoft.PowerToys.ThumbnailHandler.Svg
@@ -20,7 +21,18 @@ namespace Microsoft.PowerToys.ThumbnailHandler.Svg
         {
             ApplicationConfiguration.Initialize();
             Logger.InitializeLogger("\\FileExplorer_localLow\\SvgThumbnails\\logs", true);
-            if (args != null)
+            if (ThumbnailWorker.IsWorkerCommandLine(args))
+            {
+                ThumbnailWorker.Run(
+                    args[1],
+                    (stream, cx) =>
+                    {
+                        using var provider = new SvgThumbnailProvider(stream);
+                        return provider.GetThumbnail(cx);
+                    },
+                    (message, ex) => Logger.LogError(message, ex));
+            }
+            else if (args != null)
             {
                 if (args.Length == 2)
                 {
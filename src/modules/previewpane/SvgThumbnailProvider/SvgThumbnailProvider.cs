@@ -28,6 +28,11 @@ namespace Microsoft.PowerToys.ThumbnailHandler.Svg
             }
         }
 
+        public SvgThumbnailProvider(Stream stream)
+        {
+            Stream = stream;
+        }
+
         /// <summary>
         /// Gets the file path to the file creating thumbnail for.
         /// </summary>
@@ -2,8 +2,6 @@
 #include "SvgThumbnailProvider.h"
 
 #include <filesystem>
-#include <fstream>
-#include <shellapi.h>
 #include <Shlwapi.h>
 #include <string>
 
@@ -12,13 +10,37 @@
 #include <common/interop/shared_constants.h>
 #include <common/logger/logger.h>
 #include <common/SettingsAPI/settings_helpers.h>
+#include <common/utils/gpo.h>
 #include <common/utils/process_path.h>
+#include <common/utils/thumbnail_cache.h>
+#include <common/utils/thumbnail_worker.h>
+#include <common/utils/winapi_error.h>
 
 extern HINSTANCE g_hInst;
 extern long g_cDllRef;
 
+namespace
+{
+    // The maximum dimension (width or height) thumbnail we will generate.
+    constexpr UINT MaxThumbnailSize = 10000;
+
+    // Warm workers shared by every thumbnail request of this host process
+    thumbnail_worker::Broker& GetBroker()
+    {
+        static thumbnail_worker::Broker broker{ get_module_folderpath(g_hInst) + L"\\PowerToys.SvgThumbnailProvider.exe", worker_pool::Options{} };
+        return broker;
+    }
+
+    // Thumbnails rendered before, by any provider and host process
+    thumbnail_cache::Cache& GetCache()
+    {
+        static thumbnail_cache::Cache cache{ PTSettingsHelper::get_local_low_folder_location() + L"\\ThumbnailCache" };
+        return cache;
+    }
+}
+
 SvgThumbnailProvider::SvgThumbnailProvider() :
-    m_cRef(1), m_pStream(NULL), m_process(NULL)
+    m_cRef(1), m_pStream(NULL)
 {
     std::filesystem::path logFilePath(PTSettingsHelper::get_local_low_folder_location());
     logFilePath.append(LogSettings::svgThumbLogPath);
@@ -91,104 +113,51 @@ IFACEMETHODIMP SvgThumbnailProvider::Initialize(IStream* pStream, DWORD grfMode)
 
 IFACEMETHODIMP SvgThumbnailProvider::GetThumbnail(UINT cx, HBITMAP* phbmp, WTS_ALPHATYPE* pdwAlpha)
 {
-    // Read stream into the buffer
-    char buffer[4096];
-    ULONG cbRead;
-
     Logger::trace(L"Begin");
 
-    GUID guid;
-    if (CoCreateGuid(&guid) == S_OK)
+    if (!m_pStream)
     {
-        wil::unique_cotaskmem_string guidString;
-        if (SUCCEEDED(StringFromCLSID(guid, &guidString)))
-        {
-            Logger::info(L"Read stream and save to tmp file.");
-
-            // {CLSID} -> CLSID
-            std::wstring guid = std::wstring(guidString.get()).substr(1, std::wstring(guidString.get()).size() - 2);
-            std::wstring filePath = PTSettingsHelper::get_local_low_folder_location() + L"\\SvgThumbnailPreview-Temp\\";
-            if (!std::filesystem::exists(filePath))
-            {
-                std::filesystem::create_directories(filePath);
-            }
-
-            std::wstring fileName = filePath + guid + L".svg";
-
-            // Write data to tmp file
-            std::fstream file;
-            file.open(fileName, std::ios_base::out | std::ios_base::binary);
-
-            if (!file.is_open())
-            {
-                return 0;
-            }
-
-            while (true)
-            {
-                auto result = m_pStream->Read(buffer, 4096, &cbRead);
-
-                file.write(buffer, cbRead);
-                if (result == S_FALSE)
-                {
-                    break;
-                }
-            }
-            file.close();
+        return E_UNEXPECTED;
+    }
 
-            m_pStream->Release();
-            m_pStream = NULL;
+    // Release the stream in every branch
+    wil::com_ptr<IStream> stream;
+    stream.attach(m_pStream);
+    m_pStream = NULL;
 
-            try
-            {
-                Logger::info(L"Start SvgThumbnailProvider.exe");
-
-                STARTUPINFO info = { sizeof(info) };
-                std::wstring cmdLine{ L"\"" + fileName + L"\"" };
-                cmdLine += L" ";
-                cmdLine += std::to_wstring(cx);
-
-                std::wstring appPath = get_module_folderpath(g_hInst) + L"\\PowerToys.SvgThumbnailProvider.exe";
-
-                SHELLEXECUTEINFO sei{ sizeof(sei) };
-                sei.fMask = { SEE_MASK_NOCLOSEPROCESS | SEE_MASK_FLAG_NO_UI };
-                sei.lpFile = appPath.c_str();
-                sei.lpParameters = cmdLine.c_str();
-                sei.nShow = SW_SHOWDEFAULT;
-                ShellExecuteEx(&sei);
-                m_process = sei.hProcess;
-                WaitForSingleObject(m_process, INFINITE);
-                std::filesystem::remove(fileName);
-
-                std::wstring fileNameBmp = filePath + guid + L".bmp";
-
-                if (std::filesystem::exists(fileNameBmp))
-                {
-                    *phbmp = static_cast<HBITMAP>(LoadImage(NULL, fileNameBmp.c_str(), IMAGE_BITMAP, 0, 0, LR_LOADFROMFILE));
-                    *pdwAlpha = WTS_ALPHATYPE::WTSAT_ARGB;
-                    std::filesystem::remove(fileNameBmp);
-                }
-                else
-                {
-                    Logger::info(L"Bmp file not generated.");
-                    return E_FAIL;
-                }
-            }
-            catch (std::exception& e)
-            {
-                std::wstring errorMessage = std::wstring{ winrt::to_hstring(e.what()) };
-                Logger::error(L"Failed to start SvgThumbnailProvider.exe. Error: {}", errorMessage);
-            }
-        }
+    if (cx == 0 || cx > MaxThumbnailSize)
+    {
+        return E_INVALIDARG;
+    }
+
+    if (powertoys_gpo::getConfiguredSvgThumbnailsEnabledValue() == powertoys_gpo::gpo_rule_configured_disabled)
+    {
+        // GPO is disabling this utility.
+        return E_FAIL;
+    }
+
+    auto& cache = GetCache();
+    const auto key = cache.make_key(stream.get(), cx, thumbnail_cache::Source::Svg);
+    if (key && cache.find(*key, cx, phbmp))
+    {
+        *pdwAlpha = WTS_ALPHATYPE::WTSAT_ARGB;
+        return S_OK;
     }
 
-    // ensure releasing the stream (not all if branches contain it)
-    if (m_pStream)
+    // Rendered at the size of the bucket, so the other sizes in it are served from the cache too
+    HRESULT hr = GetBroker().render(stream.get(), key ? key->bucket : cx, phbmp);
+    if (FAILED(hr))
     {
-        m_pStream->Release();
-        m_pStream = NULL;
+        Logger::error(L"SvgThumbnailProvider.exe failed to render the thumbnail. {}", get_last_error_or_default(hr));
+        return hr;
     }
 
+    if (key)
+    {
+        cache.store(*key, *phbmp);
+        thumbnail_cache::fit(*phbmp, cx);
+    }
+    *pdwAlpha = WTS_ALPHATYPE::WTSAT_ARGB;
     return S_OK;
 }
 
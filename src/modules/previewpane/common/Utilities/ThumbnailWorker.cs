@@ -0,0 +1,170 @@
+﻿// Copyright (c) Microsoft Corporation
+// The Microsoft Corporation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+using System;
+using System.Buffers.Binary;
+using System.Drawing;
+using System.Drawing.Imaging;
+using System.IO;
+using System.IO.MemoryMappedFiles;
+using System.IO.Pipes;
+using System.Runtime.InteropServices;
+using System.Text;
+
+namespace Common.Utilities
+{
+    /// <summary>
+    /// Request loop of a warm thumbnail worker, started by the native thumbnail provider as "--worker &lt;pipe name&gt;".
+    /// </summary>
+    /// <remarks>
+    /// Implements the protocol of common/utils/thumbnail_worker.h: every request is a framed message naming a file
+    /// mapping with the file content, the bitmap is written back into the same mapping.
+    /// </remarks>
+    public static class ThumbnailWorker
+    {
+        private const ushort FrameMagic = 0x5450;
+        private const byte FrameVersion = 1;
+        private const byte BinaryPayload = 2;
+        private const int FrameHeaderSize = 8;
+        private const int RequestHeaderSize = 28;
+        private const int ResultHeaderSize = 8;
+        private const int MaxRequestSize = 64 * 1024;
+        private const uint StatusOk = 0;
+        private const uint StatusFailed = 1;
+
+        /// <summary>
+        /// Gets a value indicating whether the command line asks for worker mode.
+        /// </summary>
+        /// <param name="args">Command line arguments.</param>
+        /// <returns>True for "--worker &lt;pipe name&gt;".</returns>
+        public static bool IsWorkerCommandLine(string[] args)
+        {
+            return args != null && args.Length == 2 && args[0] == "--worker";
+        }
+
+        /// <summary>
+        /// Handles requests until the native side closes the pipe.
+        /// </summary>
+        /// <param name="pipeName">Name of the pipe created by the native side.</param>
+        /// <param name="render">Renders the content to a bitmap fitting cx x cx, or returns null.</param>
+        /// <param name="logError">Logs requests which failed with an exception.</param>
+        public static void Run(string pipeName, Func<Stream, uint, Bitmap?> render, Action<string, Exception> logError)
+        {
+            using var pipe = new NamedPipeClientStream(".", pipeName, PipeDirection.InOut);
+            pipe.Connect(10000);
+
+            var header = new byte[FrameHeaderSize];
+            while (ReadExactly(pipe, header))
+            {
+                var size = BinaryPrimitives.ReadUInt32LittleEndian(header.AsSpan(4));
+                if (BinaryPrimitives.ReadUInt16LittleEndian(header) != FrameMagic || header[2] != FrameVersion || header[3] != BinaryPayload || size < RequestHeaderSize || size > MaxRequestSize)
+                {
+                    return;
+                }
+
+                var request = new byte[size];
+                if (!ReadExactly(pipe, request))
+                {
+                    return;
+                }
+
+                uint status;
+                try
+                {
+                    status = Handle(request, render) ? StatusOk : StatusFailed;
+                }
+                catch (Exception ex)
+                {
+                    logError("Failed to render the thumbnail", ex);
+                    status = StatusFailed;
+                }
+
+                var response = new byte[FrameHeaderSize + 4];
+                BinaryPrimitives.WriteUInt16LittleEndian(response, FrameMagic);
+                response[2] = FrameVersion;
+                response[3] = BinaryPayload;
+                BinaryPrimitives.WriteUInt32LittleEndian(response.AsSpan(4), 4);
+                BinaryPrimitives.WriteUInt32LittleEndian(response.AsSpan(FrameHeaderSize), status);
+                pipe.Write(response);
+                pipe.Flush();
+            }
+        }
+
+        private static bool Handle(byte[] request, Func<Stream, uint, Bitmap?> render)
+        {
+            var cx = BinaryPrimitives.ReadUInt32LittleEndian(request);
+            var contentSize = checked((long)BinaryPrimitives.ReadUInt64LittleEndian(request.AsSpan(8)));
+            var resultOffset = checked((long)BinaryPrimitives.ReadUInt64LittleEndian(request.AsSpan(16)));
+            var nameLength = checked((int)BinaryPrimitives.ReadUInt32LittleEndian(request.AsSpan(24)));
+            // A view of size 0 would cover the whole mapping
+            if (RequestHeaderSize + (nameLength * 2L) > request.Length || resultOffset < contentSize || contentSize == 0)
+            {
+                return false;
+            }
+
+            var name = Encoding.Unicode.GetString(request, RequestHeaderSize, nameLength * 2);
+            using var mapping = MemoryMappedFile.OpenExisting(name, MemoryMappedFileRights.ReadWrite);
+
+            Bitmap? thumbnail;
+            using (var content = mapping.CreateViewStream(0, contentSize, MemoryMappedFileAccess.Read))
+            {
+                thumbnail = render(content, cx);
+            }
+
+            if (thumbnail == null)
+            {
+                return false;
+            }
+
+            using (thumbnail)
+            {
+                if (thumbnail.Width <= 0 || thumbnail.Height <= 0 || thumbnail.Width > cx || thumbnail.Height > cx)
+                {
+                    return false;
+                }
+
+                var width = thumbnail.Width;
+                var height = thumbnail.Height;
+                using var result = mapping.CreateViewAccessor(resultOffset, ResultHeaderSize + ((long)width * height * 4), MemoryMappedFileAccess.ReadWrite);
+                result.Write(0, (uint)width);
+                result.Write(4, (uint)height);
+
+                // Format32bppArgb is BGRA in memory with straight alpha, like the DIB section on the native side
+                var data = thumbnail.LockBits(new Rectangle(0, 0, width, height), ImageLockMode.ReadOnly, PixelFormat.Format32bppArgb);
+                try
+                {
+                    var row = new byte[width * 4];
+                    for (int y = 0; y < height; y++)
+                    {
+                        Marshal.Copy(data.Scan0 + (y * data.Stride), row, 0, row.Length);
+                        result.WriteArray(ResultHeaderSize + ((long)y * row.Length), row, 0, row.Length);
+                    }
+                }
+                finally
+                {
+                    thumbnail.UnlockBits(data);
+                }
+            }
+
+            return true;
+        }
+
+        private static bool ReadExactly(Stream stream, byte[] buffer)
+        {
+            var read = 0;
+            while (read < buffer.Length)
+            {
+                var count = stream.Read(buffer, read, buffer.Length - read);
+                if (count == 0)
+                {
+                    return false;
+                }
+
+                read += count;
+            }
+
+            return true;
+        }
+    }
+}
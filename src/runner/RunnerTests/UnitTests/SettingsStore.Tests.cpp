@@ -0,0 +1,319 @@
+#include "pch.h"
+#include <runner/settings_store.h>
+#include <common/utils/native_json.h>
+
+#include <format>
+#include <random>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace RunnerUnitTests
+{
+    namespace
+    {
+        // Module configs the store reads, counting the reads
+        struct FakeModules
+        {
+            std::optional<std::string> general = R"({"startup":true})";
+            std::map<std::wstring, std::optional<std::string>> configs;
+            std::map<std::wstring, int> reads;
+
+            void add_to(SettingsStore& store)
+            {
+                for (const auto& [name, config] : configs)
+                {
+                    store.add_module(name, [this, name] {
+                        reads[name]++;
+                        return configs[name];
+                    });
+                }
+            }
+        };
+
+        SettingsStore::Source GeneralSource(FakeModules& modules)
+        {
+            return [&modules] { return modules.general; };
+        }
+
+        std::wstring EscapePointer(std::wstring_view name)
+        {
+            std::wstring escaped;
+            for (const wchar_t c : name)
+            {
+                escaped += c == L'~' ? L"~0" : c == L'/' ? L"~1" : std::wstring(1, c);
+            }
+            return escaped;
+        }
+
+        // Serializes a parsed value again, so that documents can be compared whatever their formatting
+        void Write(json::native::Writer& writer, const json::native::Value& value)
+        {
+            switch (value.type())
+            {
+            case json::native::Type::Object:
+                writer.begin_object();
+                for (const auto& member : value.members())
+                {
+                    writer.key(json::native::details::to_wide(member.name));
+                    Write(writer, member.value);
+                }
+                writer.end_object();
+                break;
+            case json::native::Type::Array:
+                writer.begin_array();
+                for (const auto& item : value)
+                {
+                    Write(writer, item);
+                }
+                writer.end_array();
+                break;
+            case json::native::Type::String:
+                writer.value(value.get_string());
+                break;
+            case json::native::Type::Number:
+                writer.value(value.get_number());
+                break;
+            case json::native::Type::Bool:
+                writer.value(value.get_boolean());
+                break;
+            default:
+                writer.value(nullptr);
+                break;
+            }
+        }
+
+        std::string Canonical(const json::native::Value& value)
+        {
+            json::native::Writer writer;
+            Write(writer, value);
+            return writer.release();
+        }
+
+        json::native::Document Parse(const std::string& text)
+        {
+            auto document = json::native::Document::parse(text);
+            Assert::IsTrue(document.has_value());
+            return std::move(*document);
+        }
+
+        // What Settings knows: the JSON of every entry by its JSON pointer, and the version
+        struct Client
+        {
+            std::map<std::wstring, std::string> entries;
+            uint64_t version = 0;
+
+            void resync(const std::string& message)
+            {
+                const auto document = Parse(message);
+                const auto& root = document.root();
+
+                entries.clear();
+                if (const auto general = root.find(L"general"))
+                {
+                    entries[L"/general"] = Canonical(*general);
+                }
+                for (const auto& member : root.get_named_object(L"powertoys").members())
+                {
+                    entries[L"/powertoys/" + EscapePointer(json::native::details::to_wide(member.name))] = Canonical(member.value);
+                }
+                version = static_cast<uint64_t>(root.get_named_number(L"settings_version"));
+            }
+
+            // Applies the operations the way a JSON patch would, failing on any mismatch
+            void apply(const std::string& message)
+            {
+                const auto document = Parse(message);
+                const auto& patch = document.root().get_named_object(L"settings_patch");
+                Assert::AreEqual(version, static_cast<uint64_t>(patch.get_named_number(L"from_version")));
+
+                for (const auto& operation : patch.get_named_array(L"operations"))
+                {
+                    const auto op = operation.get_named_string(L"op");
+                    const auto path = operation.get_named_string(L"path");
+                    const bool exists = entries.contains(path);
+                    if (op == L"remove")
+                    {
+                        Assert::IsTrue(exists);
+                        entries.erase(path);
+                    }
+                    else
+                    {
+                        Assert::IsTrue(op == L"add" ? !exists : op == L"replace" && exists);
+                        entries[path] = Canonical(operation.get_named_object(L"value"));
+                    }
+                }
+
+                const auto patched = static_cast<uint64_t>(patch.get_named_number(L"version"));
+                Assert::IsTrue(patched > version);
+                version = patched;
+            }
+        };
+    }
+
+    TEST_CLASS (SettingsStoreUnitTests)
+    {
+    public:
+        TEST_METHOD (FullMessageHasEveryModule)
+        {
+            FakeModules modules;
+            modules.configs = { { L"FancyZones", R"({"name":"FancyZones"})" }, { L"ColorPicker", R"({"enabled":false})" } };
+            SettingsStore store(GeneralSource(modules));
+            modules.add_to(store);
+
+            const auto document = Parse(store.full_message());
+            const auto& root = document.root();
+            Assert::IsTrue(root.get_named_object(L"general").get_named_boolean(L"startup"));
+            Assert::AreEqual(std::wstring(L"FancyZones"), root.get_named_object(L"powertoys").get_named_object(L"FancyZones").get_named_string(L"name"));
+            Assert::IsFalse(root.get_named_object(L"powertoys").get_named_object(L"ColorPicker").get_named_boolean(L"enabled"));
+            Assert::AreEqual(1.0, root.get_named_number(L"settings_version"));
+
+            // Every module is read again for a resync, the version only changes with the settings
+            store.full_message();
+            Assert::AreEqual(2, modules.reads[L"FancyZones"]);
+            Assert::AreEqual(uint64_t{ 1 }, store.version());
+        }
+
+        TEST_METHOD (PatchReadsOnlyDirtyModules)
+        {
+            FakeModules modules;
+            modules.configs = { { L"A", R"({"value":1})" }, { L"B", R"({"value":1})" } };
+            SettingsStore store(GeneralSource(modules));
+            modules.add_to(store);
+            store.full_message();
+
+            modules.configs[L"B"] = R"({"value":2})";
+            store.mark_dirty(L"B");
+            const auto patch = store.patch_message();
+            Assert::IsTrue(patch.has_value());
+            Assert::AreEqual(std::string(R"({"settings_patch":{"operations":[{"op":"replace","path":"/powertoys/B","value":{"value":2}}],"from_version":1,"version":2}})"), *patch);
+            Assert::AreEqual(1, modules.reads[L"A"]);
+            Assert::AreEqual(2, modules.reads[L"B"]);
+        }
+
+        TEST_METHOD (NoPatchWithoutChanges)
+        {
+            FakeModules modules;
+            modules.configs = { { L"A", R"({"value":1})" } };
+            SettingsStore store(GeneralSource(modules));
+            modules.add_to(store);
+            store.full_message();
+
+            Assert::IsFalse(store.patch_message().has_value());
+
+            // Read again, but the same JSON
+            store.mark_dirty(L"A");
+            Assert::IsFalse(store.patch_message().has_value());
+            Assert::AreEqual(uint64_t{ 1 }, store.version());
+
+            // Unknown modules are ignored
+            store.mark_dirty(L"Unknown");
+            Assert::IsFalse(store.patch_message().has_value());
+        }
+
+        TEST_METHOD (UnreadableConfigsAreRemoved)
+        {
+            FakeModules modules;
+            modules.configs = { { L"A", R"({"value":1})" } };
+            SettingsStore store(GeneralSource(modules));
+            modules.add_to(store);
+            store.full_message();
+
+            for (const auto& config : { std::optional<std::string>{}, std::optional<std::string>{ R"({"value":)" }, std::optional<std::string>{ "[1]" } })
+            {
+                modules.configs[L"A"] = config;
+                store.mark_dirty(L"A");
+                const auto removed = Parse(*store.patch_message());
+                const auto& operation = removed.root().get_named_object(L"settings_patch").get_named_array(L"operations")[0];
+                Assert::AreEqual(std::wstring(L"remove"), operation.get_named_string(L"op"));
+                Assert::IsFalse(operation.has_key(L"value"));
+
+                // And added back once they can be read
+                modules.configs[L"A"] = R"({"value":1})";
+                store.mark_dirty(L"A");
+                const auto added = Parse(*store.patch_message());
+                Assert::AreEqual(std::wstring(L"add"), added.root().get_named_object(L"settings_patch").get_named_array(L"operations")[0].get_named_string(L"op"));
+            }
+
+            modules.configs[L"A"] = std::nullopt;
+            store.mark_dirty(L"A");
+            Assert::IsFalse(Parse(store.full_message()).root().get_named_object(L"powertoys").has_key(L"A"));
+        }
+
+        TEST_METHOD (GeneralSettingsAreAlwaysRead)
+        {
+            FakeModules modules;
+            SettingsStore store(GeneralSource(modules));
+            store.full_message();
+
+            modules.general = R"({"startup":false})";
+            const auto patch = Parse(*store.patch_message());
+            const auto& operation = patch.root().get_named_object(L"settings_patch").get_named_array(L"operations")[0];
+            Assert::AreEqual(std::wstring(L"/general"), operation.get_named_string(L"path"));
+            Assert::IsFalse(operation.get_named_object(L"value").get_named_boolean(L"startup"));
+        }
+
+        TEST_METHOD (ModuleNamesAreEscapedInPaths)
+        {
+            FakeModules modules;
+            modules.configs = { { L"a/b~c", R"({})" } };
+            SettingsStore store(GeneralSource(modules));
+            modules.add_to(store);
+
+            const auto patch = Parse(*store.patch_message());
+            const auto& operations = patch.root().get_named_object(L"settings_patch").get_named_array(L"operations");
+            Assert::AreEqual(std::wstring(L"/powertoys/a~1b~0c"), operations[1].get_named_string(L"path"));
+        }
+
+        TEST_METHOD (PatchesRoundTripToTheFullDocument)
+        {
+            std::mt19937 random{ 41 };
+            FakeModules modules;
+            for (const auto name : { L"Awake", L"ColorPicker", L"FancyZones", L"a/b", L"x~y", L"PowerRename" })
+            {
+                modules.configs[name] = std::format(R"({{"name":"{}","value":0}})", random() % 100);
+            }
+            SettingsStore store(GeneralSource(modules));
+            modules.add_to(store);
+
+            Client client;
+            client.resync(store.full_message());
+            for (int round = 0; round < 500; round++)
+            {
+                // Some modules change, and are marked dirty like set_config does. Others are marked without a change.
+                for (auto& [name, config] : modules.configs)
+                {
+                    switch (random() % 8)
+                    {
+                    case 0:
+                        config = std::format(R"({{"properties":{{"value":{},"list":[1,"two",null]}},"enabled":{}}})", random() % 4, random() % 2 == 0 ? "true" : "false");
+                        store.mark_dirty(name);
+                        break;
+                    case 1:
+                        config = random() % 2 == 0 ? std::nullopt : std::optional<std::string>{ "{" };
+                        store.mark_dirty(name);
+                        break;
+                    case 2:
+                        store.mark_dirty(name);
+                        break;
+                    }
+                }
+                if (random() % 4 == 0)
+                {
+                    modules.general = std::format(R"({{"startup":{},"theme":"system"}})", random() % 2 == 0 ? "true" : "false");
+                }
+
+                if (const auto patch = store.patch_message())
+                {
+                    client.apply(*patch);
+                }
+                Assert::AreEqual(store.version(), client.version);
+
+                // A resync reads everything again and has to agree with the patched document
+                Client resynced;
+                resynced.resync(store.full_message());
+                Assert::IsTrue(resynced.entries == client.entries);
+                Assert::AreEqual(client.version, resynced.version);
+            }
+        }
+    };
+}
@@ -0,0 +1,13 @@
+//{{NO_DEPENDENCIES}}
+// Microsoft Visual C++ generated include file.
+// Used by UnitTests-Runner.rc
+
+//////////////////////////////
+// Non-localizable
+
+#define FILE_DESCRIPTION "PowerToys UnitTests-Runner"
+#define INTERNAL_NAME "UnitTests-Runner"
+#define ORIGINAL_FILENAME "UnitTests-Runner.dll"
+
+// Non-localizable
+//////////////////////////////
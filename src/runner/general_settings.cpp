@@ -92,7 +92,7 @@ GeneralSettings get_general_settings()
 
     for (auto& [name, powertoy] : modules())
     {
-        settings.isModulesEnabledMap[name] = powertoy->is_enabled();
+        settings.isModulesEnabledMap[name] = powertoy.is_enabled();
     }
 
     return settings;
@@ -166,10 +166,10 @@ void apply_general_settings(const json::JsonObject& general_configs, bool save)
                 continue;
             }
             PowertoyModule& powertoy = modules().at(name);
-            const bool module_inst_enabled = powertoy->is_enabled();
+            const bool module_inst_enabled = powertoy.is_enabled();
             bool target_enabled = value.GetBoolean();
 
-            auto gpo_rule = powertoy->gpo_policy_enabled_configuration();
+            auto gpo_rule = powertoy.gpo_policy_enabled_configuration();
             if (gpo_rule == powertoys_gpo::gpo_rule_configured_enabled || gpo_rule == powertoys_gpo::gpo_rule_configured_disabled)
             {
                 // Apply the GPO Rule.
@@ -182,6 +182,10 @@ void apply_general_settings(const json::JsonObject& general_configs, bool save)
             }
             if (target_enabled)
             {
+                if (!powertoy.ensure_loaded())
+                {
+                    continue;
+                }
                 Logger::info(L"apply_general_settings: Enabling powertoy {}", name);
                 powertoy->enable();
             }
@@ -215,7 +219,7 @@ void start_enabled_powertoys()
     // Take into account default values supplied by modules themselves and gpo configurations
     for (auto& [name, powertoy] : modules())
     {
-        auto gpo_rule = powertoy->gpo_policy_enabled_configuration();
+        auto gpo_rule = powertoy.gpo_policy_enabled_configuration();
         powertoys_gpo_configuration[name] = gpo_rule;
         if (gpo_rule == powertoys_gpo::gpo_rule_configured_unavailable)
         {
@@ -226,7 +230,7 @@ void start_enabled_powertoys()
             Logger::warn(L"start_enabled_powertoys: gpo rule for Powertoy {} is set to an unknown value", name);
         }
 
-        if (!powertoy->is_enabled_by_default())
+        if (!powertoy.is_enabled_by_default())
             powertoys_to_disable.emplace(name);
     }
 
@@ -284,7 +288,7 @@ void start_enabled_powertoys()
             should_powertoy_be_enabled = false;
         }
 
-        if (should_powertoy_be_enabled)
+        if (should_powertoy_be_enabled && powertoy.ensure_loaded())
         {
             Logger::info(L"start_enabled_powertoys: Enabling powertoy {}", name);
             powertoy->enable();
@@ -5,6 +5,7 @@
 #include <sstream>
 #include "tray_icon.h"
 #include "powertoy_module.h"
+#include "module_loader.h"
 #include "trace.h"
 #include "general_settings.h"
 #include "restart_elevated.h"
@@ -61,7 +62,6 @@
 namespace
 {
     const wchar_t PT_URI_PROTOCOL_SCHEME[] = L"powertoys://";
-    const wchar_t POWER_TOYS_MODULE_LOAD_FAIL[] = L"Failed to load "; // Module name will be appended on this message and it is not localized.
 }
 
 void chdir_current_executable()
@@ -144,57 +144,41 @@ int runner(bool isProcessElevated, bool openSettings, std::string settingsWindow
 
         // Load PowerToys DLLs
 
-        std::vector<std::wstring_view> knownModules = {
-            L"PowerToys.FancyZonesModuleInterface.dll",
-            L"PowerToys.powerpreview.dll",
-            L"PowerToys.ImageResizerExt.dll",
-            L"PowerToys.KeyboardManager.dll",
-            L"PowerToys.Launcher.dll",
-            L"WinUI3Apps/PowerToys.PowerRenameExt.dll",
-            L"PowerToys.ShortcutGuideModuleInterface.dll",
-            L"PowerToys.ColorPicker.dll",
-            L"PowerToys.AwakeModuleInterface.dll",
-            L"PowerToys.FindMyMouse.dll",
-            L"PowerToys.MouseHighlighter.dll",
-            L"PowerToys.MouseJump.dll",
-            L"PowerToys.AlwaysOnTopModuleInterface.dll",
-            L"PowerToys.MousePointerCrosshairs.dll",
-            L"PowerToys.PowerAccentModuleInterface.dll",
-            L"PowerToys.PowerOCRModuleInterface.dll",
-            L"PowerToys.AdvancedPasteModuleInterface.dll",
-            L"WinUI3Apps/PowerToys.FileLocksmithExt.dll",
-            L"WinUI3Apps/PowerToys.RegistryPreviewExt.dll",
-            L"WinUI3Apps/PowerToys.MeasureToolModuleInterface.dll",
-            L"WinUI3Apps/PowerToys.NewPlus.ShellExtension.dll",
-            L"WinUI3Apps/PowerToys.HostsModuleInterface.dll",
-            L"WinUI3Apps/PowerToys.Peek.dll",
-            L"WinUI3Apps/PowerToys.EnvironmentVariablesModuleInterface.dll",
-            L"PowerToys.MouseWithoutBordersModuleInterface.dll",
-            L"PowerToys.CropAndLockModuleInterface.dll",
-            L"PowerToys.CmdNotFoundModuleInterface.dll",
-            L"PowerToys.WorkspacesModuleInterface.dll",
-            L"PowerToys.ZoomItModuleInterface.dll",
+        // The GPO rule of each module lets disabled modules be skipped without loading their DLL
+        const KnownModule knownModules[] = {
+            { L"PowerToys.FancyZonesModuleInterface.dll", powertoys_gpo::getConfiguredFancyZonesEnabledValue },
+            { L"PowerToys.powerpreview.dll", nullptr },
+            { L"PowerToys.ImageResizerExt.dll", powertoys_gpo::getConfiguredImageResizerEnabledValue },
+            { L"PowerToys.KeyboardManager.dll", powertoys_gpo::getConfiguredKeyboardManagerEnabledValue },
+            { L"PowerToys.Launcher.dll", powertoys_gpo::getConfiguredPowerLauncherEnabledValue },
+            { L"WinUI3Apps/PowerToys.PowerRenameExt.dll", powertoys_gpo::getConfiguredPowerRenameEnabledValue },
+            { L"PowerToys.ShortcutGuideModuleInterface.dll", powertoys_gpo::getConfiguredShortcutGuideEnabledValue },
+            { L"PowerToys.ColorPicker.dll", powertoys_gpo::getConfiguredColorPickerEnabledValue },
+            { L"PowerToys.AwakeModuleInterface.dll", powertoys_gpo::getConfiguredAwakeEnabledValue },
+            { L"PowerToys.FindMyMouse.dll", powertoys_gpo::getConfiguredFindMyMouseEnabledValue },
+            { L"PowerToys.MouseHighlighter.dll", powertoys_gpo::getConfiguredMouseHighlighterEnabledValue },
+            { L"PowerToys.MouseJump.dll", powertoys_gpo::getConfiguredMouseJumpEnabledValue },
+            { L"PowerToys.AlwaysOnTopModuleInterface.dll", powertoys_gpo::getConfiguredAlwaysOnTopEnabledValue },
+            { L"PowerToys.MousePointerCrosshairs.dll", powertoys_gpo::getConfiguredMousePointerCrosshairsEnabledValue },
+            { L"PowerToys.PowerAccentModuleInterface.dll", powertoys_gpo::getConfiguredQuickAccentEnabledValue },
+            { L"PowerToys.PowerOCRModuleInterface.dll", powertoys_gpo::getConfiguredTextExtractorEnabledValue },
+            { L"PowerToys.AdvancedPasteModuleInterface.dll", powertoys_gpo::getConfiguredAdvancedPasteEnabledValue },
+            { L"WinUI3Apps/PowerToys.FileLocksmithExt.dll", powertoys_gpo::getConfiguredFileLocksmithEnabledValue },
+            { L"WinUI3Apps/PowerToys.RegistryPreviewExt.dll", powertoys_gpo::getConfiguredRegistryPreviewEnabledValue },
+            { L"WinUI3Apps/PowerToys.MeasureToolModuleInterface.dll", powertoys_gpo::getConfiguredScreenRulerEnabledValue },
+            { L"WinUI3Apps/PowerToys.NewPlus.ShellExtension.dll", powertoys_gpo::getConfiguredNewPlusEnabledValue },
+            { L"WinUI3Apps/PowerToys.HostsModuleInterface.dll", powertoys_gpo::getConfiguredHostsFileEditorEnabledValue },
+            { L"WinUI3Apps/PowerToys.Peek.dll", powertoys_gpo::getConfiguredPeekEnabledValue },
+            { L"WinUI3Apps/PowerToys.EnvironmentVariablesModuleInterface.dll", powertoys_gpo::getConfiguredEnvironmentVariablesEnabledValue },
+            { L"PowerToys.MouseWithoutBordersModuleInterface.dll", powertoys_gpo::getConfiguredMouseWithoutBordersEnabledValue },
+            { L"PowerToys.CropAndLockModuleInterface.dll", powertoys_gpo::getConfiguredCropAndLockEnabledValue },
+            { L"PowerToys.CmdNotFoundModuleInterface.dll", powertoys_gpo::getConfiguredCmdNotFoundEnabledValue },
+            { L"PowerToys.WorkspacesModuleInterface.dll", powertoys_gpo::getConfiguredWorkspacesEnabledValue },
+            { L"PowerToys.ZoomItModuleInterface.dll", powertoys_gpo::getConfiguredZoomItEnabledValue },
         };
 
-        for (auto moduleSubdir : knownModules)
-        {
-            try
-            {
-                auto pt_module = load_powertoy(moduleSubdir);
-                modules().emplace(pt_module->get_key(), std::move(pt_module));
-            }
-            catch (...)
-            {
-                std::wstring errorMessage = POWER_TOYS_MODULE_LOAD_FAIL;
-                errorMessage += moduleSubdir;
-                MessageBoxW(NULL,
-                            errorMessage.c_str(),
-                            L"PowerToys",
-                            MB_OK | MB_ICONERROR);
-            }
-        }
-        // Start initial powertoys
-        start_enabled_powertoys();
+        // Also starts the enabled modules
+        load_powertoys(knownModules);
         std::wstring product_version = get_product_version();
         Trace::EventLaunch(product_version, isProcessElevated);
         PTSettingsHelper::save_last_version_run(product_version);
@@ -221,6 +205,7 @@ int runner(bool isProcessElevated, bool openSettings, std::string settingsWindow
 
         settings_telemetry::init();
         result = run_message_loop();
+        save_powertoys_cache();
     }
     catch (std::runtime_error& err)
     {
@@ -393,6 +378,9 @@ int WINAPI WinMain(HINSTANCE /*hInstance*/, HINSTANCE /*hPrevInstance*/, LPSTR l
         return 0;
     }
 
+    // The runner asks for the policies whenever modules are enabled or the settings are sent
+    powertoys_gpo::watchPolicyChanges();
+
     bool openOobe = false;
     try
     {
@@ -0,0 +1,314 @@
+#include "pch.h"
+#include "module_loader.h"
+#include "powertoy_module.h"
+#include "general_settings.h"
+
+#include <atomic>
+#include <format>
+#include <sstream>
+#include <thread>
+
+#include <common/logger/logger.h>
+#include <common/SettingsAPI/settings_helpers.h>
+#include <common/utils/native_json.h>
+#include <common/version/version.h>
+
+namespace
+{
+    const wchar_t POWER_TOYS_MODULE_LOAD_FAIL[] = L"Failed to load "; // Module name will be appended on this message and it is not localized.
+    const wchar_t MODULE_CACHE_FILENAME[] = L"\\module_cache.json";
+
+    // Past this, the threads mostly wait for the loader lock
+    constexpr unsigned MAX_LOADER_THREADS = 8;
+
+    using Clock = std::chrono::steady_clock;
+
+    struct CachedModule
+    {
+        std::wstring key;
+        bool enabled_by_default = true;
+        std::wstring config;
+    };
+
+    struct LoadedLibrary
+    {
+        HMODULE handle = nullptr;
+        DWORD error = ERROR_SUCCESS;
+        Clock::time_point start;
+        Clock::time_point end;
+        std::thread::id thread;
+    };
+
+    // Cached modules by DLL, kept for the stubs until the cache is written again
+    std::map<std::wstring, CachedModule>& module_cache()
+    {
+        static std::map<std::wstring, CachedModule> cache;
+        return cache;
+    }
+
+    // DLL of every module by key
+    std::map<std::wstring, std::wstring>& module_dlls()
+    {
+        static std::map<std::wstring, std::wstring> dlls;
+        return dlls;
+    }
+
+    std::wstring cache_path()
+    {
+        return PTSettingsHelper::get_root_save_folder_location() + MODULE_CACHE_FILENAME;
+    }
+
+    // Entries of another version are dropped, its modules might have different keys or defaults
+    std::map<std::wstring, CachedModule> read_cache()
+    {
+        std::map<std::wstring, CachedModule> cache;
+        try
+        {
+            auto document = json::native::from_file(cache_path());
+            if (!document || !document->root().is_object())
+            {
+                return cache;
+            }
+
+            const auto& root = document->root();
+            if (root.get_named_string(L"version", L"") != get_product_version())
+            {
+                Logger::info(L"Module cache is from another version, loading every module");
+                return cache;
+            }
+
+            for (const auto& entry : root.get_named_array(L"modules"))
+            {
+                cache.emplace(entry.get_named_string(L"dll"),
+                              CachedModule{
+                                  .key = entry.get_named_string(L"key"),
+                                  .enabled_by_default = entry.get_named_boolean(L"enabled_by_default"),
+                                  .config = entry.get_named_string(L"config") });
+            }
+        }
+        catch (const json::native::error& e)
+        {
+            Logger::error("Failed to read the module cache: {}", std::string{ e.what() });
+            cache.clear();
+        }
+        return cache;
+    }
+
+    void write_cache()
+    {
+        json::native::Writer writer;
+        writer.begin_object().member(L"version", get_product_version());
+        writer.key(L"modules").begin_array();
+        for (const auto& [dll, entry] : module_cache())
+        {
+            writer.begin_object();
+            writer.member(L"dll", dll).member(L"key", entry.key);
+            writer.member(L"enabled_by_default", entry.enabled_by_default).member(L"config", entry.config);
+            writer.end_object();
+        }
+        writer.end_array().end_object();
+
+        if (!json::native::to_file(cache_path(), writer.str()))
+        {
+            Logger::error(L"Failed to write the module cache");
+        }
+    }
+
+    void update_cache_entry(const std::wstring& dll, PowertoyModule& powertoy)
+    {
+        if (!powertoy.is_loaded())
+        {
+            return;
+        }
+
+        try
+        {
+            module_cache()[dll] = CachedModule{
+                .key = powertoy->get_key(),
+                .enabled_by_default = powertoy.is_enabled_by_default(),
+                .config = powertoy.json_config()
+            };
+        }
+        catch (...)
+        {
+            Logger::error(L"Failed to read the settings of {} for the module cache", dll);
+        }
+    }
+
+    // Same rules as start_enabled_powertoys: GPO first, then the settings, then the default of the module
+    bool will_be_enabled(const KnownModule& known, const CachedModule& cached, const json::JsonObject& enabled)
+    {
+        const auto gpo_rule = known.gpo_rule ? known.gpo_rule() : powertoys_gpo::gpo_rule_configured_not_configured;
+        if (gpo_rule == powertoys_gpo::gpo_rule_configured_enabled || gpo_rule == powertoys_gpo::gpo_rule_configured_disabled)
+        {
+            return gpo_rule == powertoys_gpo::gpo_rule_configured_enabled;
+        }
+
+        if (enabled && enabled.HasKey(cached.key))
+        {
+            const auto value = enabled.GetNamedValue(cached.key);
+            if (value.ValueType() == json::JsonValueType::Boolean)
+            {
+                return value.GetBoolean();
+            }
+        }
+        return cached.enabled_by_default;
+    }
+
+    double milliseconds(Clock::duration duration)
+    {
+        return std::chrono::duration<double, std::milli>(duration).count();
+    }
+}
+
+void load_powertoys(std::span<const KnownModule> knownModules)
+{
+    const auto start = Clock::now();
+    auto log_event = [start](std::wstring_view event) {
+        Logger::info(L"Startup +{:.1f} ms: {}", milliseconds(Clock::now() - start), event);
+    };
+
+    module_cache() = read_cache();
+    log_event(std::format(L"read the module cache, {} entries", module_cache().size()));
+
+    json::JsonObject enabled{ nullptr };
+    try
+    {
+        auto general_settings = load_general_settings();
+        if (general_settings.HasKey(L"enabled"))
+        {
+            enabled = general_settings.GetNamedObject(L"enabled");
+        }
+    }
+    catch (...)
+    {
+    }
+
+    // Only modules seen before can be stubs, the others have to be loaded to know their key and defaults
+    std::vector<const KnownModule*> toLoad;
+    std::vector<PowertoyModuleStub> stubs;
+    for (const auto& known : knownModules)
+    {
+        const std::wstring dll{ known.dll };
+        auto cached = module_cache().find(dll);
+        if (cached == module_cache().end() || will_be_enabled(known, cached->second, enabled))
+        {
+            toLoad.push_back(&known);
+            continue;
+        }
+
+        stubs.push_back(PowertoyModuleStub{
+            .dll = dll,
+            .key = cached->second.key,
+            .enabled_by_default = cached->second.enabled_by_default,
+            .config = cached->second.config,
+            .gpo_rule = known.gpo_rule });
+    }
+    log_event(std::format(L"{} modules to load, {} stubs", toLoad.size(), stubs.size()));
+
+    // LoadLibrary is the expensive part and safe to call from any thread. Creating the modules and registering
+    // their hotkeys stays on this thread, the hooks and windows they set up belong to it.
+    std::vector<LoadedLibrary> libraries(toLoad.size());
+    {
+        std::atomic<size_t> next = 0;
+        auto worker = [&] {
+            for (size_t i = next++; i < toLoad.size(); i = next++)
+            {
+                auto& library = libraries[i];
+                library.thread = std::this_thread::get_id();
+                library.start = Clock::now();
+                library.handle = LoadLibraryW(toLoad[i]->dll.data());
+                library.error = library.handle ? ERROR_SUCCESS : GetLastError();
+                library.end = Clock::now();
+            }
+        };
+
+        const size_t threadCount = (std::min)({ static_cast<size_t>((std::max)(std::thread::hardware_concurrency(), 1u)), size_t{ MAX_LOADER_THREADS }, toLoad.size() });
+        std::vector<std::thread> threads;
+        for (size_t i = 1; i < threadCount; i++)
+        {
+            threads.emplace_back(worker);
+        }
+        worker();
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+    }
+
+    for (size_t i = 0; i < toLoad.size(); i++)
+    {
+        const auto& library = libraries[i];
+        std::wstringstream thread;
+        thread << library.thread;
+        Logger::info(L"Startup +{:.1f} ms: LoadLibrary {} took {:.1f} ms on thread {}", milliseconds(library.start - start), toLoad[i]->dll, milliseconds(library.end - library.start), thread.str());
+    }
+    log_event(L"loaded the module libraries");
+
+    for (size_t i = 0; i < toLoad.size(); i++)
+    {
+        const std::wstring dll{ toLoad[i]->dll };
+        try
+        {
+            if (!libraries[i].handle)
+            {
+                winrt::throw_hresult(HRESULT_FROM_WIN32(libraries[i].error));
+            }
+
+            const auto created = Clock::now();
+            auto pt_module = create_powertoy(libraries[i].handle);
+            std::wstring key = pt_module->get_key();
+            Logger::info(L"Startup +{:.1f} ms: created {} in {:.1f} ms", milliseconds(created - start), key, milliseconds(Clock::now() - created));
+
+            module_dlls()[key] = dll;
+            modules().emplace(std::move(key), std::move(pt_module));
+        }
+        catch (...)
+        {
+            std::wstring errorMessage = POWER_TOYS_MODULE_LOAD_FAIL;
+            errorMessage += dll;
+            MessageBoxW(NULL,
+                        errorMessage.c_str(),
+                        L"PowerToys",
+                        MB_OK | MB_ICONERROR);
+        }
+    }
+
+    for (auto& stub : stubs)
+    {
+        module_dlls()[stub.key] = stub.dll;
+        std::wstring key = stub.key;
+        modules().emplace(std::move(key), PowertoyModule(std::move(stub)));
+    }
+    log_event(L"created the modules");
+
+    start_enabled_powertoys();
+    log_event(L"enabled the modules");
+
+    // Written now rather than on exit, a crash or logoff would leave the stubs with old settings
+    save_powertoys_cache();
+    log_event(L"wrote the module cache");
+}
+
+void save_powertoys_cache()
+{
+    for (auto& [key, powertoy] : modules())
+    {
+        if (auto dll = module_dlls().find(key); dll != module_dlls().end())
+        {
+            update_cache_entry(dll->second, powertoy);
+        }
+    }
+    write_cache();
+}
+
+void save_powertoy_cache(const std::wstring& key)
+{
+    auto powertoy = modules().find(key);
+    auto dll = module_dlls().find(key);
+    if (powertoy != modules().end() && dll != module_dlls().end())
+    {
+        update_cache_entry(dll->second, powertoy->second);
+        write_cache();
+    }
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include <span>
+#include <string>
+#include <string_view>
+
+#include <common/utils/gpo.h>
+
+struct KnownModule
+{
+    std::wstring_view dll;
+    // Lets the runner know whether GPO forces the module on without loading it, nullptr if there's no policy
+    powertoys_gpo::gpo_rule_configured_t (*gpo_rule)();
+};
+
+// Fills modules(). Modules which will be enabled are loaded concurrently, the ones which stay disabled are
+// stubs until they're used, built from what was cached about them on the previous run.
+// Logs a timeline of the startup.
+void load_powertoys(std::span<const KnownModule> knownModules);
+
+// Updates the cache with the current settings of the loaded modules
+void save_powertoys_cache();
+
+// Updates the cache after the settings of one module changed
+void save_powertoy_cache(const std::wstring& key);
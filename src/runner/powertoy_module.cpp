@@ -11,9 +11,8 @@ std::map<std::wstring, PowertoyModule>& modules()
     return modules;
 }
 
-PowertoyModule load_powertoy(const std::wstring_view filename)
+PowertoyModule create_powertoy(HMODULE handle)
 {
-    auto handle = winrt::check_pointer(LoadLibraryW(filename.data()));
     auto create = reinterpret_cast<powertoy_create_func>(GetProcAddress(handle, "powertoy_create"));
     if (!create)
     {
@@ -29,14 +28,24 @@ PowertoyModule load_powertoy(const std::wstring_view filename)
     return PowertoyModule(pt_module, handle);
 }
 
-json::JsonObject PowertoyModule::json_config() const
+PowertoyModule load_powertoy(const std::wstring_view filename)
+{
+    return create_powertoy(winrt::check_pointer(LoadLibraryW(filename.data())));
+}
+
+std::wstring PowertoyModule::json_config() const
 {
+    if (stub)
+    {
+        return stub->config;
+    }
+
     int size = 0;
     pt_module->get_config(nullptr, &size);
     std::wstring result;
     result.resize(static_cast<size_t>(size) - 1);
     pt_module->get_config(result.data(), &size);
-    return json::JsonObject::Parse(result);
+    return result;
 }
 
 PowertoyModule::PowertoyModule(PowertoyModuleIface* pt_module, HMODULE handle) :
@@ -51,8 +60,67 @@ PowertoyModule::PowertoyModule(PowertoyModuleIface* pt_module, HMODULE handle) :
     UpdateHotkeyEx();
 }
 
+PowertoyModule::PowertoyModule(PowertoyModuleStub stub) :
+    stub(std::move(stub))
+{
+}
+
+bool PowertoyModule::ensure_loaded()
+{
+    if (pt_module)
+    {
+        return true;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    try
+    {
+        auto loaded = load_powertoy(stub->dll);
+        if (loaded.pt_module->get_key() != stub->key)
+        {
+            Logger::warn(L"Module {} has the key {} instead of the cached {}", stub->dll, loaded.pt_module->get_key(), stub->key);
+        }
+
+        handle = std::move(loaded.handle);
+        pt_module = std::move(loaded.pt_module);
+    }
+    catch (...)
+    {
+        Logger::error(L"Failed to load {} on first use", stub->dll);
+        return false;
+    }
+
+    Logger::info(L"Loaded {} on first use in {} ms", stub->dll, std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count());
+    stub.reset();
+    return true;
+}
+
+bool PowertoyModule::is_enabled() const
+{
+    return pt_module && pt_module->is_enabled();
+}
+
+bool PowertoyModule::is_enabled_by_default() const
+{
+    return stub ? stub->enabled_by_default : pt_module->is_enabled_by_default();
+}
+
+powertoys_gpo::gpo_rule_configured_t PowertoyModule::gpo_policy_enabled_configuration() const
+{
+    if (stub)
+    {
+        return stub->gpo_rule ? stub->gpo_rule() : powertoys_gpo::gpo_rule_configured_not_configured;
+    }
+    return pt_module->gpo_policy_enabled_configuration();
+}
+
 void PowertoyModule::update_hotkeys()
 {
+    if (!pt_module)
+    {
+        return;
+    }
+
     CentralizedKeyboardHook::ClearModuleHotkeys(pt_module->get_key());
 
     size_t hotkeyCount = pt_module->get_hotkeys(nullptr, 0);
@@ -72,6 +140,11 @@ void PowertoyModule::update_hotkeys()
 
 void PowertoyModule::UpdateHotkeyEx()
 {
+    if (!pt_module)
+    {
+        return;
+    }
+
     CentralizedHotkeys::UnregisterHotkeysForModule(pt_module->get_key());
     auto container = pt_module->GetHotkeyEx();
     if (container.has_value() && pt_module->is_enabled())
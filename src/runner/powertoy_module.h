@@ -5,6 +5,7 @@
 #include <mutex>
 #include <vector>
 #include <functional>
+#include <optional>
 
 #include <common/utils/json.h>
 
@@ -28,17 +29,50 @@ struct PowertoyModuleDLLDeleter
     }
 };
 
+// What the runner needs to know about a disabled module without loading its DLL
+struct PowertoyModuleStub
+{
+    std::wstring dll;
+    std::wstring key;
+    bool enabled_by_default = true;
+    // Settings of the module from the last time it was loaded
+    std::wstring config;
+    powertoys_gpo::gpo_rule_configured_t (*gpo_rule)() = nullptr;
+};
+
 class PowertoyModule
 {
 public:
     PowertoyModule(PowertoyModuleIface* pt_module, HMODULE handle);
 
+    // The DLL is loaded when the module is used for the first time
+    explicit PowertoyModule(PowertoyModuleStub stub);
+
+    // Loads a stubbed module, throws if it can't be loaded
     inline PowertoyModuleIface* operator->()
     {
+        if (!ensure_loaded())
+        {
+            throw std::runtime_error("Module couldn't be loaded");
+        }
         return pt_module.get();
     }
 
-    json::JsonObject json_config() const;
+    // Returns false if the DLL of a stubbed module couldn't be loaded
+    bool ensure_loaded();
+
+    bool is_loaded() const
+    {
+        return pt_module != nullptr;
+    }
+
+    // These don't load a stubbed module
+    bool is_enabled() const;
+    bool is_enabled_by_default() const;
+    powertoys_gpo::gpo_rule_configured_t gpo_policy_enabled_configuration() const;
+
+    // Serialized settings of the module, the cached ones for a stub
+    std::wstring json_config() const;
 
     void update_hotkeys();
 
@@ -47,7 +81,10 @@ public:
 private:
     std::unique_ptr<HMODULE, PowertoyModuleDLLDeleter> handle;
     std::unique_ptr<PowertoyModuleIface, PowertoyModuleDeleter> pt_module;
+    std::optional<PowertoyModuleStub> stub;
 };
 
+// Creates the module from a DLL which is already loaded, frees the DLL on failure
+PowertoyModule create_powertoy(HMODULE handle);
 PowertoyModule load_powertoy(const std::wstring_view filename);
 std::map<std::wstring, PowertoyModule>& modules();
@@ -0,0 +1,174 @@
+#include "pch.h"
+#include "settings_store.h"
+
+#include <common/logger/logger.h>
+#include <common/utils/native_json.h>
+
+namespace
+{
+    // JSON pointer to the settings of a module, '~' and '/' in the name are escaped
+    std::wstring module_path(const std::wstring& name)
+    {
+        std::wstring path = L"/powertoys/";
+        for (const wchar_t c : name)
+        {
+            if (c == L'~')
+            {
+                path += L"~0";
+            }
+            else if (c == L'/')
+            {
+                path += L"~1";
+            }
+            else
+            {
+                path += c;
+            }
+        }
+        return path;
+    }
+}
+
+SettingsStore::SettingsStore(Source generalSettings)
+{
+    m_general.source = std::move(generalSettings);
+}
+
+void SettingsStore::add_module(const std::wstring& name, Source config)
+{
+    m_modules[name] = Entry{ .source = std::move(config) };
+}
+
+void SettingsStore::mark_dirty(const std::wstring& name)
+{
+    if (auto it = m_modules.find(name); it != m_modules.end())
+    {
+        it->second.dirty = true;
+    }
+}
+
+void SettingsStore::mark_all_dirty()
+{
+    for (auto& [name, entry] : m_modules)
+    {
+        entry.dirty = true;
+    }
+}
+
+bool SettingsStore::refresh(Entry& entry, std::wstring_view name)
+{
+    if (!entry.dirty)
+    {
+        return false;
+    }
+    entry.dirty = false;
+
+    auto json = entry.source().value_or(std::string{});
+
+    // the configs are written into the messages as they are, so they have to be valid objects
+    if (!json.empty())
+    {
+        auto document = json::native::Document::parse(json);
+        if (!document || !document->root().is_object())
+        {
+            Logger::error(L"SettingsStore: got malformed json for {}", name);
+            json.clear();
+        }
+    }
+
+    if (json == entry.json)
+    {
+        return false;
+    }
+
+    entry.json = std::move(json);
+    return true;
+}
+
+std::optional<std::string> SettingsStore::patch_message()
+{
+    json::native::Writer writer;
+    writer.begin_object().key(L"settings_patch").begin_object();
+    writer.key(L"operations").begin_array();
+
+    size_t operations = 0;
+    auto write_operation = [&](const Entry& entry, const std::wstring& path, bool wasEmpty) {
+        writer.begin_object();
+        if (entry.json.empty())
+        {
+            writer.member(L"op", L"remove").member(L"path", path);
+        }
+        else
+        {
+            writer.member(L"op", wasEmpty ? L"add" : L"replace").member(L"path", path);
+            writer.key(L"value").raw_value(entry.json);
+        }
+        writer.end_object();
+        operations++;
+    };
+
+    m_general.dirty = true;
+    const bool generalWasEmpty = m_general.json.empty();
+    if (refresh(m_general, L"general"))
+    {
+        write_operation(m_general, L"/general", generalWasEmpty);
+    }
+
+    for (auto& [name, entry] : m_modules)
+    {
+        const bool wasEmpty = entry.json.empty();
+        if (refresh(entry, name))
+        {
+            write_operation(entry, module_path(name), wasEmpty);
+        }
+    }
+
+    if (operations == 0)
+    {
+        return std::nullopt;
+    }
+
+    writer.end_array();
+    writer.member(L"from_version", m_version);
+    writer.member(L"version", ++m_version);
+    writer.end_object().end_object();
+    return writer.release();
+}
+
+std::string SettingsStore::full_message()
+{
+    mark_all_dirty();
+    m_general.dirty = true;
+
+    bool changed = refresh(m_general, L"general");
+    for (auto& [name, entry] : m_modules)
+    {
+        changed = refresh(entry, name) || changed;
+    }
+
+    if (changed)
+    {
+        m_version++;
+    }
+
+    json::native::Writer writer;
+    writer.begin_object();
+    if (!m_general.json.empty())
+    {
+        writer.key(L"general").raw_value(m_general.json);
+    }
+
+    writer.key(L"powertoys").begin_object();
+    for (const auto& [name, entry] : m_modules)
+    {
+        if (!entry.json.empty())
+        {
+            writer.key(name).raw_value(entry.json);
+        }
+    }
+    writer.end_object();
+
+    writer.member(L"settings_version", m_version);
+    writer.end_object();
+    return writer.release();
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <optional>
+#include <string>
+
+// Settings the runner sends to the Settings window: the general settings and the config of every module.
+// Module configs are kept serialized and read again only after the module was marked dirty, so changing
+// one toggle doesn't query every module. Settings gets the entries that changed as a patch and can ask
+// for the whole document to resync.
+// Used from the main thread only.
+class SettingsStore
+{
+public:
+    // Returns the serialized settings, nullopt if they can't be read
+    using Source = std::function<std::optional<std::string>()>;
+
+    // The general settings are read on every update, they're cheap and change without notice
+    explicit SettingsStore(Source generalSettings);
+
+    void add_module(const std::wstring& name, Source config);
+
+    void mark_dirty(const std::wstring& name);
+    void mark_all_dirty();
+
+    // {"settings_patch":{"operations":[...],"from_version":N,"version":M}} with JSON patch operations for
+    // the entries changed since the last message, nullopt if nothing changed
+    std::optional<std::string> patch_message();
+
+    // {"general":{...},"powertoys":{...},"settings_version":N} read again from every module
+    std::string full_message();
+
+    uint64_t version() const noexcept
+    {
+        return m_version;
+    }
+
+private:
+    struct Entry
+    {
+        Source source;
+        // empty while the settings can't be read
+        std::string json;
+        bool dirty = true;
+    };
+
+    // Reads a dirty entry again, returns whether its JSON changed
+    static bool refresh(Entry& entry, std::wstring_view name);
+
+    Entry m_general;
+    std::map<std::wstring, Entry> m_modules;
+    uint64_t m_version = 0;
+};
@@ -42,7 +42,7 @@ void send()
 {
     for (auto& [name, powertoy] : modules())
     {
-        if (powertoy->is_enabled())
+        if (powertoy.is_enabled())
         {
             try
             {
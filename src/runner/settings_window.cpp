@@ -4,7 +4,10 @@
 #include <sstream>
 #include <aclapi.h>
 
+#include "module_loader.h"
 #include "powertoy_module.h"
+#include "settings_store.h"
+#include <common/interop/async_message_queue.h>
 #include <common/interop/two_way_pipe_message_ipc.h>
 #include <common/interop/shared_constants.h>
 #include "tray_icon.h"
@@ -37,30 +40,47 @@ std::atomic_bool g_isLaunchInProgress = false;
 std::atomic_bool isUpdateCheckThreadRunning = false;
 HANDLE g_terminateSettingsEvent = CreateEventW(nullptr, false, false, CommonSharedConstants::TERMINATE_SETTINGS_SHARED_EVENT);
 
-json::JsonObject get_power_toys_settings()
+// Created on first use, the modules are loaded by then
+SettingsStore& settings_store()
 {
-    json::JsonObject result;
-    for (const auto& [name, powertoy] : modules())
-    {
-        try
-        {
-            result.SetNamedValue(name, powertoy.json_config());
-        }
-        catch (...)
+    static SettingsStore store = [] {
+        SettingsStore result([]() -> std::optional<std::string> {
+            return winrt::to_string(get_general_settings().to_json().Stringify());
+        });
+
+        for (const auto& [name, powertoy] : modules())
         {
-            Logger::error(L"get_power_toys_settings(): got malformed json for {} module", name);
+            result.add_module(name, [&powertoy = powertoy]() -> std::optional<std::string> {
+                try
+                {
+                    return winrt::to_string(powertoy.json_config());
+                }
+                catch (...)
+                {
+                    return std::nullopt;
+                }
+            });
         }
-    }
-    return result;
+        return result;
+    }();
+    return store;
 }
 
-json::JsonObject get_all_settings()
+void send_settings_message(const std::string& message)
 {
-    json::JsonObject result;
+    const std::wstring settings_string{ winrt::to_hstring(message).c_str() };
+    std::unique_lock lock{ ipc_mutex };
+    if (current_settings_ipc)
+        current_settings_ipc->send(settings_string);
+}
 
-    result.SetNamedValue(L"general", get_general_settings().to_json());
-    result.SetNamedValue(L"powertoys", get_power_toys_settings());
-    return result;
+// Sends the settings changed since the last message
+void send_settings_patch()
+{
+    if (auto patch = settings_store().patch_message())
+    {
+        send_settings_message(*patch);
+    }
 }
 
 std::optional<std::wstring> dispatch_json_action_to_module(const json::JsonObject& powertoys_configs)
@@ -137,10 +157,12 @@ std::optional<std::wstring> dispatch_json_action_to_module(const json::JsonObjec
             {
             }
         }
-        else if (modules().find(name) != modules().end())
+        else if (modules().find(name) != modules().end() && modules().at(name).ensure_loaded())
         {
             const auto element = powertoy_element.Value().Stringify();
             modules().at(name)->call_custom_action(element.c_str());
+            settings_store().mark_dirty(name);
+            save_powertoy_cache(name);
         }
     }
 
@@ -150,11 +172,13 @@ std::optional<std::wstring> dispatch_json_action_to_module(const json::JsonObjec
 void send_json_config_to_module(const std::wstring& module_key, const std::wstring& settings)
 {
     auto moduleIt = modules().find(module_key);
-    if (moduleIt != modules().end())
+    if (moduleIt != modules().end() && moduleIt->second.ensure_loaded())
     {
         moduleIt->second->set_config(settings.c_str());
         moduleIt->second.update_hotkeys();
         moduleIt->second.UpdateHotkeyEx();
+        settings_store().mark_dirty(module_key);
+        save_powertoy_cache(module_key);
     }
 }
 
@@ -185,31 +209,17 @@ void dispatch_received_json(const std::wstring& json_to_parse)
         if (name == L"general")
         {
             apply_general_settings(value.GetObjectW());
-            const std::wstring settings_string{ get_all_settings().Stringify().c_str() };
-            {
-                std::unique_lock lock{ ipc_mutex };
-                if (current_settings_ipc)
-                    current_settings_ipc->send(settings_string);
-            }
+            send_settings_patch();
         }
         else if (name == L"powertoys")
         {
             dispatch_json_config_to_modules(value.GetObjectW());
-            const std::wstring settings_string{ get_all_settings().Stringify().c_str() };
-            {
-                std::unique_lock lock{ ipc_mutex };
-                if (current_settings_ipc)
-                    current_settings_ipc->send(settings_string);
-            }
+            send_settings_patch();
         }
         else if (name == L"refresh")
         {
-            const std::wstring settings_string{ get_all_settings().Stringify().c_str() };
-            {
-                std::unique_lock lock{ ipc_mutex };
-                if (current_settings_ipc)
-                    current_settings_ipc->send(settings_string);
-            }
+            // full resync, also picks up changes the modules made on their own
+            send_settings_message(settings_store().full_message());
         }
         else if (name == L"action")
         {
@@ -245,17 +255,39 @@ void dispatch_received_json(const std::wstring& json_to_parse)
     return;
 }
 
-void dispatch_received_json_callback(PVOID data)
+namespace
+{
+    // Messages from Settings waiting for the main thread. Every message is delivered in order, the IPC
+    // thread only waits if the main thread falls behind by more than the capacity.
+    AsyncMessageQueue<std::wstring> received_settings_messages(256, OverflowPolicy::Block);
+    std::atomic_bool received_settings_dispatch_scheduled = false;
+}
+
+void dispatch_received_json_callback(PVOID /*data*/)
 {
-    std::wstring* msg = static_cast<std::wstring*>(data);
-    dispatch_received_json(*msg);
-    delete msg;
+    // Allow the next message to schedule a dispatch before taking the queued ones, so none is left behind
+    received_settings_dispatch_scheduled = false;
+
+    std::vector<std::wstring> messages;
+    received_settings_messages.try_drain(messages, SIZE_MAX);
+    for (const auto& msg : messages)
+    {
+        dispatch_received_json(msg);
+    }
 }
 
 void receive_json_send_to_main_thread(const std::wstring& msg)
 {
-    std::wstring* copy = new std::wstring(msg);
-    dispatch_run_on_main_ui_thread(dispatch_received_json_callback, copy);
+    received_settings_messages.queue_message(msg);
+
+    // One window message handles all the messages queued until the main thread gets to it
+    if (!received_settings_dispatch_scheduled.exchange(true))
+    {
+        if (!dispatch_run_on_main_ui_thread(dispatch_received_json_callback, nullptr))
+        {
+            received_settings_dispatch_scheduled = false;
+        }
+    }
 }
 
 // Try to run the Settings process with non-elevated privileges.
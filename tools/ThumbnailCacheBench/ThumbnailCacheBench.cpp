@@ -0,0 +1,206 @@
+// Shows the counters of the thumbnail cache shared by the thumbnail providers (see
+// src/common/utils/thumbnail_cache.h) and measures it with generated files in a temporary folder.
+// Usage: PowerToys.ThumbnailCacheBench.exe stats|clear|bench [files] [cx]
+#include "pch.h"
+
+#include <chrono>
+#include <filesystem>
+#include <format>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <ShlObj.h>
+#include <Shlwapi.h>
+
+#include <wil/com.h>
+
+#include <common/utils/thumbnail_cache.h>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    // Same folder as the thumbnail providers use
+    std::wstring SharedFolder()
+    {
+        PWSTR localLow = nullptr;
+        if (FAILED(SHGetKnownFolderPath(FOLDERID_LocalAppDataLow, 0, NULL, &localLow)))
+        {
+            return {};
+        }
+        std::wstring result{ localLow };
+        CoTaskMemFree(localLow);
+        return result + L"\\Microsoft\\PowerToys\\ThumbnailCache";
+    }
+
+    void PrintStats(const thumbnail_cache::Stats& stats)
+    {
+        const uint64_t lookups = stats.hits + stats.misses;
+        std::wcout << std::format(L"entries:   {}\nsize:      {:.1f} MB\nhits:      {}\nmisses:    {}\nhit rate:  {:.1f}%\nstores:    {}\nevictions: {}\n",
+                                  stats.entries,
+                                  stats.bytes / (1024.0 * 1024.0),
+                                  stats.hits,
+                                  stats.misses,
+                                  lookups ? 100.0 * stats.hits / lookups : 0.0,
+                                  stats.stores,
+                                  stats.evictions);
+    }
+
+    // Something like a rendered thumbnail, a flat background with a shape and a gradient on it
+    HBITMAP MakeThumbnail(UINT size, uint32_t seed)
+    {
+        BITMAPINFO bmi{};
+        bmi.bmiHeader.biSize = sizeof(bmi.bmiHeader);
+        bmi.bmiHeader.biWidth = static_cast<LONG>(size);
+        bmi.bmiHeader.biHeight = -static_cast<LONG>(size);
+        bmi.bmiHeader.biPlanes = 1;
+        bmi.bmiHeader.biBitCount = 32;
+        bmi.bmiHeader.biCompression = BI_RGB;
+
+        void* bits = nullptr;
+        HBITMAP bitmap = CreateDIBSection(NULL, &bmi, DIB_RGB_COLORS, &bits, NULL, 0);
+        if (!bitmap)
+        {
+            return nullptr;
+        }
+
+        auto* px = static_cast<uint8_t*>(bits);
+        for (UINT y = 0; y < size; y++)
+        {
+            for (UINT x = 0; x < size; x++, px += 4)
+            {
+                const bool inside = x > size / 8 && x < size * 7 / 8 && y > size / 4 && y < size * 3 / 4;
+                px[0] = inside ? static_cast<uint8_t>(x * 255 / size) : 0;
+                px[1] = inside ? static_cast<uint8_t>(y * 255 / size) : 0;
+                px[2] = inside ? static_cast<uint8_t>(seed) : 0;
+                px[3] = inside ? 255 : 0;
+            }
+        }
+        return bitmap;
+    }
+
+    double Microseconds(Clock::duration duration, size_t count)
+    {
+        return std::chrono::duration<double, std::micro>(duration).count() / (count ? count : 1);
+    }
+
+    int Bench(size_t files, UINT cx)
+    {
+        const auto folder = std::filesystem::temp_directory_path() / std::format(L"PowerToys.ThumbnailCacheBench_{}", GetCurrentProcessId());
+        {
+            thumbnail_cache::Cache cache{ folder.wstring() };
+            if (!cache.valid())
+            {
+                std::wcerr << L"Can't create the cache in " << folder.wstring() << std::endl;
+                return 1;
+            }
+
+            // The content of the files only matters for the hash of the prefix
+            std::mt19937 random{ 1 };
+            std::vector<std::vector<uint8_t>> contents(files, std::vector<uint8_t>(256 * 1024));
+            for (auto& content : contents)
+            {
+                for (auto& byte : content)
+                {
+                    byte = static_cast<uint8_t>(random());
+                }
+            }
+
+            auto makeKey = [&](size_t i) {
+                wil::com_ptr_nothrow<IStream> stream;
+                stream.attach(SHCreateMemStream(contents[i].data(), static_cast<UINT>(contents[i].size())));
+                return stream ? cache.make_key(stream.get(), cx, thumbnail_cache::Source::Stl) : std::nullopt;
+            };
+
+            Clock::duration keyTime{};
+            Clock::duration missTime{};
+            Clock::duration storeTime{};
+            for (size_t i = 0; i < files; i++)
+            {
+                auto start = Clock::now();
+                const auto key = makeKey(i);
+                keyTime += Clock::now() - start;
+                if (!key)
+                {
+                    std::wcerr << L"Can't make a key" << std::endl;
+                    return 1;
+                }
+
+                HBITMAP found = nullptr;
+                start = Clock::now();
+                cache.find(*key, cx, &found);
+                missTime += Clock::now() - start;
+
+                HBITMAP bitmap = MakeThumbnail(key->bucket, static_cast<uint32_t>(i));
+                start = Clock::now();
+                cache.store(*key, bitmap);
+                storeTime += Clock::now() - start;
+                DeleteObject(bitmap);
+            }
+
+            Clock::duration hitTime{};
+            size_t hits = 0;
+            for (size_t i = 0; i < files; i++)
+            {
+                const auto start = Clock::now();
+                const auto key = makeKey(i);
+                HBITMAP found = nullptr;
+                if (key && cache.find(*key, cx, &found))
+                {
+                    hits++;
+                    DeleteObject(found);
+                }
+                hitTime += Clock::now() - start;
+            }
+
+            std::wcout << std::format(L"{} files, thumbnails of {}x{}\n", files, thumbnail_cache::size_bucket(cx), thumbnail_cache::size_bucket(cx));
+            std::wcout << std::format(L"key (64 KB prefix): {:.1f} us\n", Microseconds(keyTime, files));
+            std::wcout << std::format(L"miss:               {:.1f} us\n", Microseconds(missTime, files));
+            std::wcout << std::format(L"store:              {:.1f} us\n", Microseconds(storeTime, files));
+            std::wcout << std::format(L"key and hit:        {:.1f} us, {} of {} found\n\n", Microseconds(hitTime, files), hits, files);
+            PrintStats(cache.stats());
+        }
+
+        std::error_code error;
+        std::filesystem::remove_all(folder, error);
+        return 0;
+    }
+}
+
+int wmain(int argc, wchar_t* argv[])
+{
+    const std::wstring command = argc > 1 ? argv[1] : L"";
+    if (command == L"bench")
+    {
+        const size_t files = argc > 2 ? std::wcstoul(argv[2], nullptr, 10) : 1000;
+        const UINT cx = argc > 3 ? std::wcstoul(argv[3], nullptr, 10) : 256;
+        if (files == 0 || cx == 0 || cx > 10000)
+        {
+            std::wcerr << L"Expected 1 or more files and a cx up to 10000" << std::endl;
+            return 1;
+        }
+        return Bench(files, cx);
+    }
+
+    if (command == L"stats" || command == L"clear")
+    {
+        thumbnail_cache::Cache cache{ SharedFolder() };
+        if (!cache.valid())
+        {
+            std::wcerr << L"Can't open the thumbnail cache" << std::endl;
+            return 1;
+        }
+
+        if (command == L"clear")
+        {
+            cache.clear();
+        }
+        PrintStats(cache.stats());
+        return 0;
+    }
+
+    std::wcerr << L"Usage: PowerToys.ThumbnailCacheBench.exe stats|clear|bench [files] [cx]" << std::endl;
+    return 1;
+}
@@ -0,0 +1,3 @@
+#pragma once
+
+#include <Windows.h>
\ No newline at end of file
@@ -0,0 +1,93 @@
+// Converts a binary trace file written by the PowerToys logger (see src/common/logger/binary_trace.h)
+// to the text format of the log files.
+// Usage: PowerToys.TraceDecoder.exe <file.trace> [output.txt]
+#include "pch.h"
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+#include <common/logger/binary_trace.h>
+
+namespace
+{
+    // Same names as the log files use
+    const wchar_t* LevelName(uint8_t level)
+    {
+        constexpr const wchar_t* names[] = { L"trace", L"debug", L"info", L"warning", L"error", L"critical", L"off" };
+        return level < std::size(names) ? names[level] : L"unknown";
+    }
+
+    std::string ToUtf8(const std::wstring& text)
+    {
+        const int size = WideCharToMultiByte(CP_UTF8, 0, text.data(), static_cast<int>(text.size()), nullptr, 0, nullptr, nullptr);
+        std::string result(size, '\0');
+        WideCharToMultiByte(CP_UTF8, 0, text.data(), static_cast<int>(text.size()), result.data(), size, nullptr, nullptr);
+        return result;
+    }
+
+    std::wstring FormatRecord(const BinaryTrace::DecodedRecord& record, uint32_t processId)
+    {
+        using namespace std::chrono;
+        const auto local = current_zone()->to_local(record.time);
+        const auto seconds = floor<std::chrono::seconds>(local);
+        return std::format(L"[{:%Y-%m-%d %H:%M:%S}.{:06}] [p-{}] [t-{}] [{}] {}\n",
+                           seconds,
+                           (local - seconds).count(),
+                           processId,
+                           record.threadId,
+                           LevelName(record.level),
+                           record.message);
+    }
+}
+
+int wmain(int argc, wchar_t* argv[])
+{
+    if (argc < 2)
+    {
+        std::wcerr << L"Usage: PowerToys.TraceDecoder.exe <file.trace> [output.txt]" << std::endl;
+        return 1;
+    }
+
+    std::ifstream input(argv[1], std::ios::binary);
+    if (!input)
+    {
+        std::wcerr << L"Can't open " << argv[1] << std::endl;
+        return 1;
+    }
+
+    BinaryTrace::Decoder decoder(std::string{ std::istreambuf_iterator<char>{ input }, std::istreambuf_iterator<char>{} });
+    if (decoder.failed())
+    {
+        std::wcerr << argv[1] << L" is not a trace file" << std::endl;
+        return 1;
+    }
+
+    std::ofstream outputFile;
+    if (argc > 2)
+    {
+        outputFile.open(argv[2], std::ios::binary);
+        if (!outputFile)
+        {
+            std::wcerr << L"Can't create " << argv[2] << std::endl;
+            return 1;
+        }
+    }
+    std::ostream& output = outputFile.is_open() ? outputFile : std::cout;
+
+    size_t count = 0;
+    while (auto record = decoder.next())
+    {
+        output << ToUtf8(FormatRecord(record.value(), decoder.process_id()));
+        count++;
+    }
+
+    // a trace cut short by a crash still has its complete records decoded
+    if (decoder.failed())
+    {
+        std::wcerr << L"The trace is truncated or damaged after " << count << L" records" << std::endl;
+        return 2;
+    }
+    return 0;
+}